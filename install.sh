@@ -301,6 +301,32 @@ install_dependencies() {
         need_install=true
     fi
 
+    # Check for libffi
+    local has_ffi=false
+    if pkg-config --exists libffi 2>/dev/null || \
+       [[ -f /usr/include/ffi.h ]] || \
+       [[ -f /usr/include/x86_64-linux-gnu/ffi.h ]] || \
+       [[ -f /usr/local/include/ffi.h ]]; then
+        has_ffi=true
+    fi
+
+    if ! $has_ffi; then
+        missing_deps+=("libffi")
+        need_install=true
+    fi
+
+    # Check for libpng and libjpeg
+    local has_images=false
+    if { pkg-config --exists libpng 2>/dev/null || [[ -f /usr/include/png.h ]] || [[ -f /usr/local/include/png.h ]]; } && \
+       { pkg-config --exists libjpeg 2>/dev/null || [[ -f /usr/include/jpeglib.h ]] || [[ -f /usr/local/include/jpeglib.h ]]; }; then
+        has_images=true
+    fi
+
+    if ! $has_images; then
+        missing_deps+=("libpng/libjpeg")
+        need_install=true
+    fi
+
     if $need_install; then
         warn "Missing dependencies: ${missing_deps[*]}"
 
@@ -319,28 +345,28 @@ install_dependencies() {
         case "$pkg_manager" in
             apt)
                 sudo apt-get update -qq
-                sudo apt-get install -y build-essential git libuv1-dev libreadline-dev libsqlite3-dev pkg-config
+                sudo apt-get install -y build-essential git libuv1-dev libreadline-dev libsqlite3-dev libffi-dev libpng-dev libjpeg-dev pkg-config
                 ;;
             dnf)
-                sudo dnf install -y gcc make git libuv-devel readline-devel sqlite-devel pkgconfig
+                sudo dnf install -y gcc make git libuv-devel readline-devel sqlite-devel libffi-devel libpng-devel libjpeg-turbo-devel pkgconfig
                 ;;
             yum)
-                sudo yum install -y gcc make git libuv-devel readline-devel sqlite-devel pkgconfig
+                sudo yum install -y gcc make git libuv-devel readline-devel sqlite-devel libffi-devel libpng-devel libjpeg-turbo-devel pkgconfig
                 ;;
             pacman)
-                sudo pacman -Sy --noconfirm base-devel git libuv readline sqlite
+                sudo pacman -Sy --noconfirm base-devel git libuv readline sqlite libffi libpng libjpeg-turbo
                 ;;
             apk)
-                sudo apk add --no-cache build-base git libuv-dev readline-dev sqlite-dev pkgconfig
+                sudo apk add --no-cache build-base git libuv-dev readline-dev sqlite-dev libffi-dev libpng-dev libjpeg-turbo-dev pkgconfig
                 ;;
             zypper)
-                sudo zypper install -y gcc make git libuv-devel readline-devel sqlite3-devel pkg-config
+                sudo zypper install -y gcc make git libuv-devel readline-devel sqlite3-devel libffi-devel libpng16-devel libjpeg8-devel pkg-config
                 ;;
             brew)
-                brew install libuv readline sqlite3 pkg-config
+                brew install libuv readline sqlite3 libffi libpng jpeg-turbo pkg-config
                 ;;
             pkg)
-                sudo pkg install -y libuv readline sqlite3 pkgconf
+                sudo pkg install -y libuv readline sqlite3 libffi png jpeg-turbo pkgconf
                 ;;
             *)
                 error "Unknown package manager. Please install manually:"
@@ -350,6 +376,8 @@ install_dependencies() {
                 echo "  - libuv development files"
                 echo "  - readline development files"
                 echo "  - sqlite3 development files"
+                echo "  - libffi development files"
+                echo "  - libpng and libjpeg development files"
                 exit 1
                 ;;
         esac
@@ -3,6 +3,9 @@
 RADS_TEST_DIR="tests"
 RADS_BIN="./bin/rads"
 
+# Run the work pool with several threads even on a single-CPU machine.
+export RADS_WORKERS="${RADS_WORKERS:-8}"
+
 total_passed=0
 total_failed=0
 
@@ -25,6 +28,24 @@ test_files=(
     "v0_0_7_comprehensive.rads"
     "test_debugger.rads"
     "test_typecheck.rads"
+    "test_json.rads"
+    "test_db.rads"
+    "test_graphql.rads"
+    "test_template.rads"
+    "test_session.rads"
+    "test_tcp.rads"
+    "test_websocket.rads"
+    "test_http.rads"
+    "test_async.rads"
+    "test_parallel.rads"
+    "test_chan.rads"
+    "test_io_stream.rads"
+    "test_bytes.rads"
+    "test_strings.rads"
+    "test_regex.rads"
+    "test_ffi.rads"
+    "test_media.rads"
+    "test_numarray.rads"
 )
 
 for test_file in "${test_files[@]}"; do
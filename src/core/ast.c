@@ -132,6 +132,24 @@ ASTNode* ast_create_typeof(ASTNode* operand, int line, int column) {
     return node;
 }
 
+ASTNode* ast_create_await(ASTNode* operand, int line, int column) {
+    ASTNode* node = malloc(sizeof(ASTNode));
+    node->type = AST_AWAIT_EXPR;
+    node->line = line;
+    node->column = column;
+    node->await_expr.operand = operand;
+    return node;
+}
+
+ASTNode* ast_create_spawn(ASTNode* call, int line, int column) {
+    ASTNode* node = malloc(sizeof(ASTNode));
+    node->type = AST_SPAWN_EXPR;
+    node->line = line;
+    node->column = column;
+    node->spawn_expr.call = call;
+    return node;
+}
+
 ASTNode* ast_create_function_decl(const char* name, ASTList* params, TypeInfo* return_type, ASTNode* body, bool is_async, int line, int column) {
     ASTNode* node = malloc(sizeof(ASTNode));
     node->type = AST_FUNCTION_DECL;
@@ -537,6 +555,12 @@ void ast_free(ASTNode* node) {
         case AST_TYPEOF_EXPR:
             ast_free(node->typeof_expr.operand);
             break;
+        case AST_AWAIT_EXPR:
+            ast_free(node->await_expr.operand);
+            break;
+        case AST_SPAWN_EXPR:
+            ast_free(node->spawn_expr.call);
+            break;
         case AST_ENUM_DECL:
             free(node->enum_decl.name);
             ast_list_free(node->enum_decl.values);
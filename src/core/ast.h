@@ -51,6 +51,8 @@ typedef enum {
     AST_INDEX_EXPR,
     AST_MEMBER_EXPR,
     AST_TYPEOF_EXPR,
+    AST_AWAIT_EXPR,
+    AST_SPAWN_EXPR,
     AST_STRUCT_LITERAL,
     AST_SPREAD_EXPR,
     AST_OPTIONAL_CHAIN,
@@ -153,6 +155,16 @@ struct ASTNode {
         struct {
             ASTNode* operand;
         } typeof_expr;
+
+        // Await expression
+        struct {
+            ASTNode* operand;
+        } await_expr;
+
+        // Spawn expression
+        struct {
+            ASTNode* call;
+        } spawn_expr;
         
         // Function declaration
         struct {
@@ -323,6 +335,8 @@ ASTNode* ast_create_identifier(const char* name, int line, int column);
 ASTNode* ast_create_binary_op(OperatorType op, ASTNode* left, ASTNode* right, int line, int column);
 ASTNode* ast_create_unary_op(OperatorType op, ASTNode* operand, int line, int column);
 ASTNode* ast_create_typeof(ASTNode* operand, int line, int column);
+ASTNode* ast_create_await(ASTNode* operand, int line, int column);
+ASTNode* ast_create_spawn(ASTNode* call, int line, int column);
 ASTNode* ast_create_function_decl(const char* name, ASTList* params, TypeInfo* return_type, ASTNode* body, bool is_async, int line, int column);
 ASTNode* ast_create_variable_decl(const char* name, TypeInfo* type, ASTNode* initializer, bool is_turbo, int line, int column);
 ASTNode* ast_create_struct_decl(const char* name, ASTList* fields, int line, int column);
@@ -0,0 +1,250 @@
+#include "coroutine.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef RADS_PLATFORM_WINDOWS
+
+// Windows: one fiber per coroutine; the system owns the stacks.
+struct RadsCoroutine {
+    void* fiber;
+    void* caller;
+    RadsCoroutineFn fn;
+    void* arg;
+    RadsCoroutine* prev;
+    bool done;
+};
+
+static RadsCoroutine* current = NULL;
+
+static void WINAPI coroutine_entry(void* param) {
+    RadsCoroutine* co = param;
+    co->fn(co->arg);
+    co->done = true;
+    SwitchToFiber(co->caller);
+}
+
+RadsCoroutine* coroutine_create(RadsCoroutineFn fn, void* arg) {
+    RadsCoroutine* co = calloc(1, sizeof(RadsCoroutine));
+    co->fn = fn;
+    co->arg = arg;
+    // Commit a little up front and reserve the rest, like a thread stack.
+    co->fiber = CreateFiberEx(64 * 1024, RADS_COROUTINE_STACK_SIZE, 0, coroutine_entry, co);
+    if (!co->fiber) {
+        free(co);
+        return NULL;
+    }
+    return co;
+}
+
+bool coroutine_resume(RadsCoroutine* co) {
+    if (!co || co->done) return true;
+    void* self = GetCurrentFiber();
+    if (!self || self == (void*)0x1E00) self = ConvertThreadToFiber(NULL);
+    co->caller = self;
+    co->prev = current;
+    current = co;
+    SwitchToFiber(co->fiber);
+    current = co->prev;
+    if (co->done) {
+        DeleteFiber(co->fiber);
+        co->fiber = NULL;
+    }
+    return co->done;
+}
+
+void coroutine_yield(void) {
+    RadsCoroutine* co = current;
+    if (co) SwitchToFiber(co->caller);
+}
+
+void coroutine_free(RadsCoroutine* co) {
+    if (!co) return;
+    if (co->fiber) DeleteFiber(co->fiber);
+    free(co);
+}
+
+void coroutine_pool_drain(void) {}
+
+bool coroutine_stack_low(void) {
+    return false;
+}
+
+#else
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define RADS_ASAN_FIBERS 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define RADS_ASAN_FIBERS 1
+#endif
+#endif
+
+#ifdef RADS_ASAN_FIBERS
+// AddressSanitizer has to be told about every stack switch.
+void __sanitizer_start_switch_fiber(void** fake_stack_save, const void* bottom, size_t size);
+void __sanitizer_finish_switch_fiber(void* fake_stack_save, const void** bottom_old, size_t* size_old);
+#endif
+
+struct RadsCoroutine {
+    ucontext_t ctx;
+    ucontext_t caller;
+    RadsCoroutineFn fn;
+    void* arg;
+    char* stack;             // mapping base; the lowest page is the guard
+    RadsCoroutine* prev;     // coroutine running when this one was resumed
+    bool done;
+#ifdef RADS_ASAN_FIBERS
+    void* fake_stack;
+    const void* caller_bottom;
+    size_t caller_size;
+#endif
+};
+
+#define COROUTINE_GUARD_SIZE 4096
+#define COROUTINE_MAP_SIZE (RADS_COROUTINE_STACK_SIZE + COROUTINE_GUARD_SIZE)
+
+static RadsCoroutine* current = NULL;
+static char* stack_pool[RADS_COROUTINE_POOL_MAX];
+static int stack_pool_count = 0;
+
+// Lowest usable address of the stack this thread is running on: set while
+// a coroutine runs, otherwise the thread's own stack (looked up once).
+static _Thread_local char* stack_floor = NULL;
+static _Thread_local char* thread_stack_floor = NULL;
+
+static char* stack_acquire(void) {
+    if (stack_pool_count > 0) return stack_pool[--stack_pool_count];
+    char* base = mmap(NULL, COROUTINE_MAP_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+    // Stacks grow down: an overflow runs into the guard page and faults
+    // instead of corrupting a neighbouring stack.
+    mprotect(base, COROUTINE_GUARD_SIZE, PROT_NONE);
+    return base;
+}
+
+static void stack_release(char* base) {
+    if (!base) return;
+    if (stack_pool_count < RADS_COROUTINE_POOL_MAX) {
+        // A deep task may have dirtied megabytes; keep only the top of the
+        // stack resident while it waits in the pool.
+        madvise(base + COROUTINE_GUARD_SIZE, RADS_COROUTINE_STACK_SIZE - RADS_STACK_RESERVE, MADV_DONTNEED);
+        stack_pool[stack_pool_count++] = base;
+        return;
+    }
+    munmap(base, COROUTINE_MAP_SIZE);
+}
+
+static void coroutine_entry(void) {
+    RadsCoroutine* co = current;
+#ifdef RADS_ASAN_FIBERS
+    __sanitizer_finish_switch_fiber(NULL, &co->caller_bottom, &co->caller_size);
+#endif
+    co->fn(co->arg);
+    co->done = true;
+#ifdef RADS_ASAN_FIBERS
+    __sanitizer_start_switch_fiber(NULL, co->caller_bottom, co->caller_size);
+#endif
+    // Returning continues at uc_link, i.e. back in coroutine_resume.
+}
+
+RadsCoroutine* coroutine_create(RadsCoroutineFn fn, void* arg) {
+    RadsCoroutine* volatile co = calloc(1, sizeof(RadsCoroutine));
+    if (!co) return NULL;
+    co->stack = stack_acquire();
+    if (!co->stack) {
+        free(co);
+        return NULL;
+    }
+    co->fn = fn;
+    co->arg = arg;
+    getcontext(&co->ctx);
+    co->ctx.uc_stack.ss_sp = co->stack + COROUTINE_GUARD_SIZE;
+    co->ctx.uc_stack.ss_size = RADS_COROUTINE_STACK_SIZE;
+    co->ctx.uc_link = &co->caller;
+    makecontext(&co->ctx, coroutine_entry, 0);
+    return co;
+}
+
+bool coroutine_resume(RadsCoroutine* target) {
+    // swapcontext returns twice as far as the compiler is concerned.
+    RadsCoroutine* volatile co = target;
+    if (!co || co->done) return true;
+    char* volatile caller_floor = stack_floor;
+    co->prev = current;
+    current = co;
+    stack_floor = co->stack + COROUTINE_GUARD_SIZE;
+#ifdef RADS_ASAN_FIBERS
+    void* fake_stack = NULL;
+    __sanitizer_start_switch_fiber(&fake_stack, co->stack + COROUTINE_GUARD_SIZE, RADS_COROUTINE_STACK_SIZE);
+#endif
+    swapcontext(&co->caller, &co->ctx);
+#ifdef RADS_ASAN_FIBERS
+    __sanitizer_finish_switch_fiber(fake_stack, NULL, NULL);
+#endif
+    current = co->prev;
+    stack_floor = caller_floor;
+    if (co->done) {
+        stack_release(co->stack);
+        co->stack = NULL;
+    }
+    return co->done;
+}
+
+void coroutine_yield(void) {
+    RadsCoroutine* co = current;
+    if (!co) return;
+#ifdef RADS_ASAN_FIBERS
+    __sanitizer_start_switch_fiber(&co->fake_stack, co->caller_bottom, co->caller_size);
+#endif
+    swapcontext(&co->ctx, &co->caller);
+#ifdef RADS_ASAN_FIBERS
+    __sanitizer_finish_switch_fiber(co->fake_stack, &co->caller_bottom, &co->caller_size);
+#endif
+}
+
+void coroutine_free(RadsCoroutine* co) {
+    if (!co) return;
+    stack_release(co->stack);
+    free(co);
+}
+
+void coroutine_pool_drain(void) {
+    while (stack_pool_count > 0) {
+        munmap(stack_pool[--stack_pool_count], COROUTINE_MAP_SIZE);
+    }
+}
+
+static char* thread_floor(void) {
+    if (thread_stack_floor) return thread_stack_floor;
+#if defined(__APPLE__)
+    pthread_t self = pthread_self();
+    thread_stack_floor = (char*)pthread_get_stackaddr_np(self) - pthread_get_stacksize_np(self);
+#elif defined(__linux__)
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        void* addr;
+        size_t size;
+        if (pthread_attr_getstack(&attr, &addr, &size) == 0) thread_stack_floor = addr;
+        pthread_attr_destroy(&attr);
+    }
+#endif
+    return thread_stack_floor;
+}
+
+bool coroutine_stack_low(void) {
+    char here;
+    char* floor = stack_floor ? stack_floor : thread_floor();
+    return floor && &here < floor + RADS_STACK_RESERVE;
+}
+
+#endif
+
+RadsCoroutine* coroutine_current(void) {
+    return current;
+}
@@ -0,0 +1,49 @@
+#ifndef RADS_COROUTINE_H
+#define RADS_COROUTINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Stackful coroutines for the interpreter's async tasks.
+//
+// Each coroutine runs on its own stack, so the tree-walking evaluator can
+// suspend anywhere in a call chain and pick up where it left off. Stacks
+// are mmap'd with a guard page and recycled through a free list; pages a
+// task never touches cost no memory, so a task gets as much stack as the
+// main thread. Coroutines are resumed and yield on the loop thread only.
+
+#define RADS_COROUTINE_STACK_SIZE (8 * 1024 * 1024)
+#define RADS_COROUTINE_POOL_MAX 1024
+
+// Stack a call must leave free for the natives it may run;
+// coroutine_stack_low() reports when less than this remains.
+#define RADS_STACK_RESERVE (256 * 1024)
+
+typedef struct RadsCoroutine RadsCoroutine;
+typedef void (*RadsCoroutineFn)(void* arg);
+
+// Returns NULL if no stack could be mapped. The coroutine does not start
+// until it is first resumed.
+RadsCoroutine* coroutine_create(RadsCoroutineFn fn, void* arg);
+
+// Runs co until it yields or returns. Returns true once fn has returned;
+// its stack is back in the pool by then.
+bool coroutine_resume(RadsCoroutine* co);
+
+// Suspends the running coroutine and returns to whoever resumed it.
+void coroutine_yield(void);
+
+// The running coroutine, or NULL on the main stack.
+RadsCoroutine* coroutine_current(void);
+
+// True when the stack the caller runs on (a coroutine's, or its thread's
+// own) has less than RADS_STACK_RESERVE bytes left.
+bool coroutine_stack_low(void);
+
+// Frees a coroutine that has finished or was never started.
+void coroutine_free(RadsCoroutine* co);
+
+// Unmaps the pooled stacks.
+void coroutine_pool_drain(void);
+
+#endif // RADS_COROUTINE_H
@@ -3,6 +3,8 @@
 #include "lexer.h"
 #include "parser.h"
 #include "platform.h"
+#include "coroutine.h"
+#include "workpool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +14,12 @@ static Value eval_expression(ASTNode* node);
 static ExecResult exec_statement(ASTNode* node);
 static void exec_function(ASTNode* node);
 static bool is_truthy(Value v);
+static Value await_value(Value v);
+static NativeFn find_iterable(const char* handle);
+static void task_detach_value(const Value* v);
+static void tasks_shutdown(void);
+static Value task_spawn(Value callback, int argc, Value* args);
+static Value call_user_function(Value callback, int argc, Value* args);
 
 uv_loop_t* global_event_loop = NULL;
 static struct Interpreter global_interpreter_instance = {0};
@@ -46,6 +54,17 @@ void interpreter_run_event_loop(void) {
     uv_run(global_event_loop, UV_RUN_DEFAULT);
 }
 
+#define MAX_MAIN_RETURN_HOOKS 8
+static void (*main_return_hooks[MAX_MAIN_RETURN_HOOKS])(void);
+static int main_return_hook_count = 0;
+
+void interpreter_on_main_return(void (*fn)(void)) {
+    for (int i = 0; i < main_return_hook_count; i++) {
+        if (main_return_hooks[i] == fn) return;
+    }
+    if (main_return_hook_count < MAX_MAIN_RETURN_HOOKS) main_return_hooks[main_return_hook_count++] = fn;
+}
+
 void interpreter_cleanup_event_loop(void) {
     if (!global_event_loop) return;
     uv_loop_close(global_event_loop);
@@ -75,6 +94,122 @@ Array* array_create(size_t capacity) {
     return arr;
 }
 
+ByteBuffer* byte_buffer_create(size_t capacity) {
+    ByteBuffer* buf = calloc(1, sizeof(ByteBuffer));
+    buf->refcount = 1;
+    buf->capacity = capacity;
+    buf->data = malloc(capacity > 0 ? capacity : 1);
+    return buf;
+}
+
+void byte_buffer_release(ByteBuffer* buf) {
+    if (!buf) return;
+    if (buf->refcount > 0) buf->refcount--;
+    if (buf->refcount > 0) return;
+    if (buf->release) {
+        buf->release(buf);
+    } else {
+        free(buf->data);
+    }
+    free(buf);
+}
+
+Value make_bytes_view(ByteBuffer* buf, size_t offset, size_t length) {
+    Bytes* bytes = malloc(sizeof(Bytes));
+    buf->refcount++;
+    bytes->buf = buf;
+    bytes->offset = offset;
+    bytes->length = length;
+    Value v = { .type = VAL_BYTES, .bytes_val = bytes };
+    return v;
+}
+
+// Wraps a new buffer, taking over its creation reference.
+static Value bytes_adopt(ByteBuffer* buf) {
+    Value v = make_bytes_view(buf, 0, buf->length);
+    buf->refcount--;
+    return v;
+}
+
+Value make_bytes(const void* data, size_t length) {
+    ByteBuffer* buf = byte_buffer_create(length);
+    if (length > 0) memcpy(buf->data, data, length);
+    buf->length = length;
+    return bytes_adopt(buf);
+}
+
+Value make_bytes_owned(unsigned char* data, size_t length, size_t capacity) {
+    ByteBuffer* buf = calloc(1, sizeof(ByteBuffer));
+    buf->refcount = 1;
+    buf->length = length;
+    buf->capacity = capacity;
+    buf->data = data;
+    return bytes_adopt(buf);
+}
+
+const unsigned char* value_bytes(const Value* v, size_t* length) {
+    if (v->type == VAL_BYTES) {
+        *length = v->bytes_val->length;
+        return v->bytes_val->buf->data + v->bytes_val->offset;
+    }
+    if (v->type == VAL_STRING) {
+        *length = strlen(v->string_val);
+        return (const unsigned char*)v->string_val;
+    }
+    *length = 0;
+    return NULL;
+}
+
+NumArray* numarray_create(NumArrayKind kind, size_t count) {
+    if (count > (SIZE_MAX - 31) / sizeof(double)) {
+        fprintf(stderr, "Error: numeric array of %zu elements is too large\n", count);
+        return NULL;
+    }
+    NumArray* arr = calloc(1, sizeof(NumArray));
+    if (!arr) {
+        fprintf(stderr, "Error: out of memory for a numeric array\n");
+        return NULL;
+    }
+    arr->refcount = 1;
+    arr->kind = kind;
+    arr->count = count;
+    // aligned_alloc wants a multiple of the alignment
+    size_t size = (count * sizeof(double) + 31) & ~(size_t)31;
+    arr->data = aligned_alloc(32, size > 0 ? size : 32);
+    if (!arr->data) {
+        fprintf(stderr, "Error: out of memory for a numeric array of %zu elements\n", count);
+        free(arr);
+        return NULL;
+    }
+    memset(arr->data, 0, size);
+    return arr;
+}
+
+void numarray_release(NumArray* arr) {
+    if (!arr) return;
+    if (arr->refcount > 0) arr->refcount--;
+    if (arr->refcount > 0) return;
+    free(arr->data);
+    free(arr);
+}
+
+Value make_numarray(NumArray* arr) {
+    Value v = { .type = VAL_NUMARRAY, .numarray_val = arr };
+    return v;
+}
+
+static bool numarray_equal(const NumArray* a, const NumArray* b) {
+    if (a->kind != b->kind || a->count != b->count) return false;
+    for (size_t i = 0; i < a->count; i++) {
+        if (a->kind == NUM_F64 ? a->f64[i] != b->f64[i] : a->i64[i] != b->i64[i]) return false;
+    }
+    return true;
+}
+
+static Value numarray_element(const NumArray* arr, size_t i) {
+    return arr->kind == NUM_F64 ? make_float(arr->f64[i]) : make_int(arr->i64[i]);
+}
+
 static Value value_clone(Value v);
 static void value_release(Value* v);
 
@@ -121,6 +256,12 @@ static Value value_clone(Value v) {
         case VAL_ARRAY:
             if (v.array_val) v.array_val->refcount++;
             break;
+        case VAL_BYTES:
+            out = make_bytes_view(v.bytes_val->buf, v.bytes_val->offset, v.bytes_val->length);
+            break;
+        case VAL_NUMARRAY:
+            v.numarray_val->refcount++;
+            break;
         case VAL_STRUCT_INSTANCE:
             if (v.struct_instance) {
                 StructInstance* new_instance = malloc(sizeof(StructInstance));
@@ -167,6 +308,13 @@ static void value_release(Value* value) {
                 }
             }
             break;
+        case VAL_BYTES:
+            byte_buffer_release(value->bytes_val->buf);
+            free(value->bytes_val);
+            break;
+        case VAL_NUMARRAY:
+            numarray_release(value->numarray_val);
+            break;
         case VAL_STRUCT_DEF:
             // Handled by the struct registry
             break;
@@ -229,6 +377,13 @@ void value_print(Value* value) {
         case VAL_STRUCT_INSTANCE:
             printf("<struct instance %s>", value->struct_instance->definition->name);
             break;
+        case VAL_BYTES:
+            printf("<bytes %zu>", value->bytes_val->length);
+            break;
+        case VAL_NUMARRAY:
+            printf("<%s %zu>", value->numarray_val->kind == NUM_F64 ? "f64array" : "i64array",
+                   value->numarray_val->count);
+            break;
     }
 }
 
@@ -241,57 +396,83 @@ typedef struct Environment {
     struct Environment* next;
 } Environment;
 
-static Environment* global_env = NULL;
+// Evaluation state is per thread: pool workers run parallel jobs against
+// their own environment (see interpreter_isolated_call).
+static _Thread_local Environment* global_env = NULL;
+
+// Variables declared inside an async task (including its parameters) live
+// in the task's own list, so tasks interleaving at await points do not
+// overwrite each other. Everything else stays global.
+struct RadsTask;
+static _Thread_local struct RadsTask* current_task = NULL;
+static _Thread_local Environment* local_env = NULL;
+
+static Environment* env_find(Environment* list, const char* name) {
+    for (Environment* current = list; current; current = current->next) {
+        if (strcmp(current->name, name) == 0) return current;
+    }
+    return NULL;
+}
+
+static Environment* env_lookup(const char* name) {
+    Environment* found = local_env ? env_find(local_env, name) : NULL;
+    return found ? found : env_find(global_env, name);
+}
+
+static void env_bind(Environment** list, const char* name, Value owned) {
+    Environment* env = malloc(sizeof(Environment));
+    env->name = strdup(name);
+    env->value = owned;
+    env->next = *list;
+    *list = env;
+}
 
 static void env_set(const char* name, Value value) {
     // Always clone the value to ensure proper ownership
     Value cloned_value = value_clone(value);
 
     // Check existing
-    Environment* current = global_env;
-    while (current) {
-        if (strcmp(current->name, name) == 0) {
-            value_free(&current->value); // Free old value
-            current->value = cloned_value;
-            return;
-        }
-        current = current->next;
+    Environment* current = env_lookup(name);
+    if (current) {
+        value_free(&current->value); // Free old value
+        current->value = cloned_value;
+        return;
     }
 
     // Create new
-    Environment* env = malloc(sizeof(Environment));
-    env->name = strdup(name);
-    env->value = cloned_value;
-    env->next = global_env;
-    global_env = env;
+    env_bind(current_task ? &local_env : &global_env, name, cloned_value);
 }
 
-static Value env_get(const char* name) {
-    Environment* current = global_env;
-    while (current) {
-        if (strcmp(current->name, name) == 0) {
-            // Return a clone to ensure proper ownership
-            return value_clone(current->value);
-        }
-        current = current->next;
+// Declarations (turbo, parameters, loop and catch variables) bind in the
+// current task when there is one, shadowing any global of the same name.
+static void env_declare(const char* name, Value value) {
+    if (!current_task) {
+        env_set(name, value);
+        return;
     }
-    return make_null();
+    Value cloned_value = value_clone(value);
+    Environment* current = env_find(local_env, name);
+    if (current) {
+        value_free(&current->value);
+        current->value = cloned_value;
+        return;
+    }
+    env_bind(&local_env, name, cloned_value);
+}
+
+static Value env_get(const char* name) {
+    Environment* current = env_lookup(name);
+    // Return a clone to ensure proper ownership
+    return current ? value_clone(current->value) : make_null();
 }
 
 // Get a reference to a value in the environment (for in-place modification)
 static Value* env_get_ref(const char* name) {
-    Environment* current = global_env;
-    while (current) {
-        if (strcmp(current->name, name) == 0) {
-            return &current->value;
-        }
-        current = current->next;
-    }
-    return NULL;
+    Environment* current = env_lookup(name);
+    return current ? &current->value : NULL;
 }
 
-static void env_free() {
-    Environment* current = global_env;
+static void env_list_free(Environment* current) {
     while (current) {
         Environment* next = current->next;
         free(current->name);
@@ -299,6 +480,10 @@ static void env_free() {
         free(current);
         current = next;
     }
+}
+
+static void env_free() {
+    env_list_free(global_env);
     global_env = NULL;
 }
 
@@ -330,6 +515,32 @@ static NativeFn find_native(const char* name) {
     return NULL;
 }
 
+// Handle method registry: maps string handle prefixes to native name prefixes
+typedef struct HandleMethodBinding {
+    char* handle_prefix;
+    char* native_prefix;
+    struct HandleMethodBinding* next;
+} HandleMethodBinding;
+
+static HandleMethodBinding* handle_methods = NULL;
+
+void register_handle_methods(const char* handle_prefix, const char* native_prefix) {
+    HandleMethodBinding* binding = malloc(sizeof(HandleMethodBinding));
+    binding->handle_prefix = strdup(handle_prefix);
+    binding->native_prefix = strdup(native_prefix);
+    binding->next = handle_methods;
+    handle_methods = binding;
+}
+
+static const char* find_handle_methods(const char* handle) {
+    for (HandleMethodBinding* current = handle_methods; current; current = current->next) {
+        if (strncmp(handle, current->handle_prefix, strlen(current->handle_prefix)) == 0) {
+            return current->native_prefix;
+        }
+    }
+    return NULL;
+}
+
 // Struct definition registry
 typedef struct StructDefBinding {
     char* name;
@@ -410,7 +621,9 @@ static void env_free_enums() {
 }
 
 // Evaluate call expression
-static Value eval_call(ASTNode* node) {
+// With spawn set, a user function runs as a new task (async or not) and
+// the call evaluates to its handle; natives are simply called.
+static Value eval_call(ASTNode* node, bool spawn) {
     // For now, only support calling global native functions or simple function calls
     // Real implementation would need full environment/scope support
     
@@ -449,9 +662,17 @@ static Value eval_call(ASTNode* node) {
             }
         }
 
-        if (obj_val.type == VAL_STRING && member) {
+        if ((obj_val.type == VAL_STRING || obj_val.type == VAL_BYTES || obj_val.type == VAL_NUMARRAY) && member) {
             char native_name[64];
-            snprintf(native_name, sizeof(native_name), "net.%s", member);
+            const char* native_prefix;
+            if (obj_val.type == VAL_BYTES) {
+                native_prefix = "bytes.";
+            } else if (obj_val.type == VAL_NUMARRAY) {
+                native_prefix = obj_val.numarray_val->kind == NUM_F64 ? "f64array." : "i64array.";
+            } else {
+                native_prefix = find_handle_methods(obj_val.string_val);
+            }
+            snprintf(native_name, sizeof(native_name), "%s%s", native_prefix ? native_prefix : "net.", member);
             NativeFn native = find_native(native_name);
             if (native) {
                 int argc = node->call_expr.arguments ? (int)node->call_expr.arguments->count : 0;
@@ -515,7 +736,8 @@ static Value eval_call(ASTNode* node) {
                 args[i] = eval_expression(node->call_expr.arguments->nodes[i]);
             }
 
-            Value result = interpreter_execute_callback(func_val, argc, args);
+            Value result = spawn && !workpool_on_worker() ? task_spawn(func_val, argc, args)
+                                                          : call_user_function(func_val, argc, args);
 
             // Cleanup args
             for (int i = 0; i < argc; i++) {
@@ -526,6 +748,32 @@ static Value eval_call(ASTNode* node) {
             if (full_name) free(full_name);
             return result;
         }
+
+        // A handle whose methods include call (e.g. from ffi.bind) is callable.
+        if (func_val.type == VAL_STRING) {
+            const char* native_prefix = find_handle_methods(func_val.string_val);
+            NativeFn call = NULL;
+            if (native_prefix) {
+                char native_name[64];
+                snprintf(native_name, sizeof(native_name), "%scall", native_prefix);
+                call = find_native(native_name);
+            }
+            if (call) {
+                int argc = node->call_expr.arguments ? (int)node->call_expr.arguments->count : 0;
+                Value* args = malloc(sizeof(Value) * (argc + 1));
+                args[0] = func_val;
+                for (int i = 0; i < argc; i++) {
+                    args[i + 1] = eval_expression(node->call_expr.arguments->nodes[i]);
+                }
+                Value result = call(global_interpreter, argc + 1, args);
+                for (int i = 0; i < argc + 1; i++) {
+                    value_free(&args[i]);
+                }
+                free(args);
+                if (full_name) free(full_name);
+                return result;
+            }
+        }
         value_free(&func_val);
 
         if (full_name) free(full_name);
@@ -568,6 +816,11 @@ static Value eval_unary_op(ASTNode* node) {
 }
 
 // Evaluate binary operation
+static bool bytes_equal(const Bytes* a, const Bytes* b) {
+    return a->length == b->length &&
+           memcmp(a->buf->data + a->offset, b->buf->data + b->offset, a->length) == 0;
+}
+
 static Value eval_binary_op(ASTNode* node) {
     Value left = eval_expression(node->binary_op.left);
     Value right = eval_expression(node->binary_op.right);
@@ -722,6 +975,10 @@ static Value eval_binary_op(ASTNode* node) {
                 result = make_bool(left.bool_val == right.bool_val);
             } else if (left.type == VAL_STRING && right.type == VAL_STRING) {
                 result = make_bool(strcmp(left.string_val, right.string_val) == 0);
+            } else if (left.type == VAL_BYTES && right.type == VAL_BYTES) {
+                result = make_bool(bytes_equal(left.bytes_val, right.bytes_val));
+            } else if (left.type == VAL_NUMARRAY && right.type == VAL_NUMARRAY) {
+                result = make_bool(numarray_equal(left.numarray_val, right.numarray_val));
             } else if (left.type == VAL_NULL && right.type == VAL_NULL) {
                 result = make_bool(true);
             } else {
@@ -737,6 +994,10 @@ static Value eval_binary_op(ASTNode* node) {
                 result = make_bool(left.bool_val != right.bool_val);
             } else if (left.type == VAL_STRING && right.type == VAL_STRING) {
                 result = make_bool(strcmp(left.string_val, right.string_val) != 0);
+            } else if (left.type == VAL_BYTES && right.type == VAL_BYTES) {
+                result = make_bool(!bytes_equal(left.bytes_val, right.bytes_val));
+            } else if (left.type == VAL_NUMARRAY && right.type == VAL_NUMARRAY) {
+                result = make_bool(!numarray_equal(left.numarray_val, right.numarray_val));
             } else if (left.type == VAL_NULL && right.type == VAL_NULL) {
                 result = make_bool(false);
             } else {
@@ -813,18 +1074,17 @@ static Value eval_expression(ASTNode* node) {
             Value result = make_null();
             if (arr.type == VAL_ARRAY && idx.type == VAL_INT) {
                 if (idx.int_val >= 0 && (size_t)idx.int_val < arr.array_val->count) {
-                    // return copy
-                    Value elem = arr.array_val->items[idx.int_val];
-                    // shallow copy ok; duplicate strings
-                    if (elem.type == VAL_STRING) {
-                        result = make_string(elem.string_val);
-                    } else if (elem.type == VAL_ARRAY) {
-                        // simplistic: not deep copy; share
-                        result.type = VAL_ARRAY;
-                        result.array_val = elem.array_val;
-                    } else {
-                        result = elem;
-                    }
+                    // return copy; arrays are shared by refcount, struct
+                    // instances (e.g. parsed JSON objects) are duplicated
+                    result = value_clone(arr.array_val->items[idx.int_val]);
+                }
+            } else if (arr.type == VAL_BYTES && idx.type == VAL_INT) {
+                if (idx.int_val >= 0 && (size_t)idx.int_val < arr.bytes_val->length) {
+                    result = make_int(arr.bytes_val->buf->data[arr.bytes_val->offset + (size_t)idx.int_val]);
+                }
+            } else if (arr.type == VAL_NUMARRAY && idx.type == VAL_INT) {
+                if (idx.int_val >= 0 && (size_t)idx.int_val < arr.numarray_val->count) {
+                    result = numarray_element(arr.numarray_val, (size_t)idx.int_val);
                 }
             }
             value_free(&arr);
@@ -848,16 +1108,26 @@ static Value eval_expression(ASTNode* node) {
                 case VAL_FUNCTION: type_str = "function"; break;
                 case VAL_STRUCT_DEF: type_str = "struct_def"; break;
                 case VAL_STRUCT_INSTANCE: type_str = "struct"; break;
+                case VAL_BYTES: type_str = "bytes"; break;
+                case VAL_NUMARRAY:
+                    type_str = val.numarray_val->kind == NUM_F64 ? "f64array" : "i64array";
+                    break;
             }
             value_free(&val);
             return make_string(type_str);
         }
 
+        case AST_AWAIT_EXPR:
+            return await_value(eval_expression(node->await_expr.operand));
+
         case AST_BINARY_OP:
             return eval_binary_op(node);
             
         case AST_CALL_EXPR:
-            return eval_call(node);
+            return eval_call(node, false);
+
+        case AST_SPAWN_EXPR:
+            return eval_call(node->spawn_expr.call, true);
             
         case AST_MEMBER_EXPR: {
             // Check for enum value access (e.g., Color.RED)
@@ -899,6 +1169,20 @@ static Value eval_expression(ASTNode* node) {
                     return result;
                 }
                 fprintf(stderr, "Error: Array has no property '%s'.\n", member_name);
+            } else if (object.type == VAL_BYTES) {
+                if (strcmp(node->member_expr.member, "length") == 0) {
+                    Value result = make_int((long long)object.bytes_val->length);
+                    value_release(&object);
+                    return result;
+                }
+                fprintf(stderr, "Error: Bytes has no property '%s'.\n", node->member_expr.member);
+            } else if (object.type == VAL_NUMARRAY) {
+                if (strcmp(node->member_expr.member, "length") == 0) {
+                    Value result = make_int((long long)object.numarray_val->count);
+                    value_release(&object);
+                    return result;
+                }
+                fprintf(stderr, "Error: Numeric array has no property '%s'.\n", node->member_expr.member);
             }
             value_release(&object);
             return make_null();
@@ -1023,6 +1307,14 @@ static Value eval_expression(ASTNode* node) {
                     if (strcmp(node->optional_chain.member, "length") == 0) {
                         result = make_int((long long)object.array_val->count);
                     }
+                } else if (object.type == VAL_BYTES) {
+                    if (strcmp(node->optional_chain.member, "length") == 0) {
+                        result = make_int((long long)object.bytes_val->length);
+                    }
+                } else if (object.type == VAL_NUMARRAY) {
+                    if (strcmp(node->optional_chain.member, "length") == 0) {
+                        result = make_int((long long)object.numarray_val->count);
+                    }
                 }
             } else {
                 Value idx = eval_expression(node->optional_chain.index);
@@ -1061,10 +1353,10 @@ static void exec_echo(ASTNode* node) {
 
 
 
-static Value current_return_value;
-static bool has_return_value = false;
-static Value thrown_value;
-static bool has_thrown_value = false;
+static _Thread_local Value current_return_value;
+static _Thread_local bool has_return_value = false;
+static _Thread_local Value thrown_value;
+static _Thread_local bool has_thrown_value = false;
 
 static bool is_truthy(Value v) {
     switch (v.type) {
@@ -1076,6 +1368,10 @@ static bool is_truthy(Value v) {
             return v.float_val != 0.0;
         case VAL_STRING:
             return v.string_val && v.string_val[0] != '\0';
+        case VAL_BYTES:
+            return v.bytes_val->length > 0;
+        case VAL_NUMARRAY:
+            return v.numarray_val->count > 0;
         case VAL_FUNCTION:
         case VAL_NULL:
         default:
@@ -1149,6 +1445,8 @@ static ExecResult exec_statement(ASTNode* node) {
                 if (r == EXEC_BREAK || r == EXEC_CONTINUE || r == EXEC_RETURN || r == EXEC_THROW) {
                     return r;
                 }
+                // A function called by the statement threw.
+                if (has_thrown_value) return EXEC_THROW;
             }
             return EXEC_OK;
 
@@ -1191,7 +1489,8 @@ static ExecResult exec_statement(ASTNode* node) {
         }
         
         case AST_CRUISE_STMT: {
-            // Expect iterable to be a range binary op or something providing ints; currently handle range only
+            // Ranges, arrays, numeric arrays, and handles registered with
+            // register_iterable.
             ASTNode* iter = node->cruise_stmt.iterable;
             if (iter && iter->type == AST_BINARY_OP && iter->binary_op.op == OP_RANGE) {
                 Value start_v = eval_expression(iter->binary_op.left);
@@ -1203,7 +1502,7 @@ static ExecResult exec_statement(ASTNode* node) {
                 
                 for (long long i = start; i < end; i++) {
                     Value idx = make_int(i);
-                    env_set(node->cruise_stmt.iterator, idx);
+                    env_declare(node->cruise_stmt.iterator, idx);
                     value_free(&idx);
                     
                     ExecResult r = exec_statement(node->cruise_stmt.body);
@@ -1220,8 +1519,40 @@ static ExecResult exec_statement(ASTNode* node) {
                         return EXEC_THROW;
                     }
                 }
+                return EXEC_OK;
             }
-            return EXEC_OK;
+
+            Value seq = eval_expression(iter);
+            NativeFn next = seq.type == VAL_STRING ? find_iterable(seq.string_val) : NULL;
+            ExecResult result = EXEC_OK;
+            for (size_t i = 0;; i++) {
+                Value item;
+                if (seq.type == VAL_ARRAY && seq.array_val) {
+                    if (i >= seq.array_val->count) break;
+                    item = value_clone(seq.array_val->items[i]);
+                } else if (seq.type == VAL_NUMARRAY) {
+                    if (i >= seq.numarray_val->count) break;
+                    item = numarray_element(seq.numarray_val, i);
+                } else if (next) {
+                    Value handle = value_clone(seq);
+                    item = next(global_interpreter, 1, &handle);
+                    value_free(&handle);
+                    if (item.type == VAL_NULL) break;
+                } else {
+                    break;
+                }
+                env_declare(node->cruise_stmt.iterator, item);
+                value_free(&item);
+
+                ExecResult r = exec_statement(node->cruise_stmt.body);
+                if (r == EXEC_BREAK) break;
+                if (r == EXEC_RETURN || r == EXEC_THROW) {
+                    result = r;
+                    break;
+                }
+            }
+            value_free(&seq);
+            return result;
         }
         
         case AST_BREAK_STMT:
@@ -1262,7 +1593,7 @@ static ExecResult exec_statement(ASTNode* node) {
             if (r == EXEC_THROW && node->try_stmt.catch_block) {
                 if (has_thrown_value) {
                     if (node->try_stmt.catch_var) {
-                        env_set(node->try_stmt.catch_var, thrown_value);
+                        env_declare(node->try_stmt.catch_var, thrown_value);
                     }
                     value_free(&thrown_value);
                     has_thrown_value = false;
@@ -1311,13 +1642,13 @@ static ExecResult exec_statement(ASTNode* node) {
                                 Value rest_val;
                                 rest_val.type = VAL_ARRAY;
                                 rest_val.array_val = rest_arr;
-                                env_set(elem->destructure_rest.name, rest_val);
+                                env_declare(elem->destructure_rest.name, rest_val);
                                 value_free(&rest_val);
                             } else if (elem->type == AST_IDENTIFIER) {
                                 if (array_index < arr->count) {
-                                    env_set(elem->identifier.name, arr->items[array_index]);
+                                    env_declare(elem->identifier.name, arr->items[array_index]);
                                 } else {
-                                    env_set(elem->identifier.name, make_null());
+                                    env_declare(elem->identifier.name, make_null());
                                 }
                                 array_index++;
                             }
@@ -1339,20 +1670,20 @@ static ExecResult exec_statement(ASTNode* node) {
                                 FieldValue* fv = instance->fields;
                                 while (fv) {
                                     if (strcmp(fv->name, field_name) == 0) {
-                                        env_set(var_name, *fv->value);
+                                        env_declare(var_name, *fv->value);
                                         break;
                                     }
                                     fv = fv->next;
                                 }
                                 if (!fv) {
-                                    env_set(var_name, make_null());
+                                    env_declare(var_name, make_null());
                                 }
                             }
                         }
                     }
                 }
             } else if (node->variable_decl.name) {
-                env_set(node->variable_decl.name, val);
+                env_declare(node->variable_decl.name, val);
             }
             value_free(&val);
             return EXEC_OK;
@@ -1360,6 +1691,8 @@ static ExecResult exec_statement(ASTNode* node) {
         
         default: {
             Value v = eval_expression(node);
+            // A task started as a bare statement is fire-and-forget.
+            if (node->type == AST_CALL_EXPR || node->type == AST_SPAWN_EXPR) task_detach_value(&v);
             value_free(&v);
             return EXEC_OK;
         }
@@ -1375,10 +1708,7 @@ static void exec_function(ASTNode* node) {
     env_set(node->function_decl.name, v);
 }
 
-Value interpreter_execute_callback(Value callback, int argc, Value* args) {
-    if (callback.type != VAL_FUNCTION) {
-        return make_null();
-    }
+static Value call_function(Value callback, int argc, Value* args) {
     // Reset return tracking for this invocation
     if (has_return_value) {
         value_free(&current_return_value);
@@ -1386,6 +1716,13 @@ Value interpreter_execute_callback(Value callback, int argc, Value* args) {
     }
 
     ASTNode* func = callback.func_node;
+    // Each call nests several evaluator frames; stop before the guard page.
+    if (coroutine_stack_low()) {
+        if (has_thrown_value) value_free(&thrown_value);
+        thrown_value = make_string("maximum call depth exceeded");
+        has_thrown_value = true;
+        return make_null();
+    }
     // Bind parameters naively to globals for now
     if (func->function_decl.parameters) {
         int param_count = (int)func->function_decl.parameters->count;
@@ -1407,7 +1744,7 @@ Value interpreter_execute_callback(Value callback, int argc, Value* args) {
                 pname = param_node->identifier.name;
                 arg = (i < argc && args) ? value_clone(args[i]) : make_null();
             }
-            env_set(pname, arg);
+            env_declare(pname, arg);
             value_free(&arg);
         }
     }
@@ -1421,6 +1758,519 @@ Value interpreter_execute_callback(Value callback, int argc, Value* args) {
     return make_null();
 }
 
+static void report_uncaught(const char* where) {
+    fflush(stdout);
+    if (thrown_value.type == VAL_STRING && thrown_value.string_val) {
+        fprintf(stderr, "Error: Uncaught exception in %s: %s\n", where, thrown_value.string_val);
+    } else {
+        fprintf(stderr, "Error: Uncaught exception in %s\n", where);
+    }
+    value_free(&thrown_value);
+    has_thrown_value = false;
+}
+
+// A call from RADS code: a throw is left pending for the caller's block.
+static Value call_user_function(Value callback, int argc, Value* args) {
+    if (callback.type != VAL_FUNCTION) {
+        return make_null();
+    }
+    // Tasks live on the loop thread; a pool job runs async functions inline.
+    if (callback.func_node->function_decl.is_async && !workpool_on_worker()) {
+        return task_spawn(callback, argc, args);
+    }
+    return call_function(callback, argc, args);
+}
+
+// A call from a native (route handlers, callbacks): there is no RADS
+// caller to catch a throw, so it is reported here.
+Value interpreter_execute_callback(Value callback, int argc, Value* args) {
+    bool pending = has_thrown_value;
+    Value result = call_user_function(callback, argc, args);
+    if (has_thrown_value && !pending) report_uncaught("callback");
+    return result;
+}
+
+// ============================================================================
+// Async tasks
+// ============================================================================
+//
+// Calling an async function creates a task: the function runs on its own
+// coroutine stack right away, up to its first suspension, and the call
+// evaluates to the task's handle. A task suspends in interpreter_wait()
+// (which blocking natives call instead of spinning the loop) and is put
+// back on the ready queue by interpreter_wake() from a libuv callback; an
+// idle handle resumes ready tasks from inside the loop.
+
+#define TASK_HANDLE_PREFIX "task_"
+#define TASK_TABLE_SIZE 1024
+
+// Interpreter state that belongs to whichever task is running.
+typedef struct TaskState {
+    struct RadsTask* task;
+    Environment* locals;
+    Value return_value;
+    bool has_return;
+    Value thrown;
+    bool has_thrown;
+} TaskState;
+
+typedef struct RadsTask {
+    long id;
+    char handle[32];
+    RadsCoroutine* co;
+    Value func;
+    int argc;
+    Value* args;
+    Value result;
+    bool done;
+    bool detached;           // nobody will await the result
+    bool queued;
+    TaskDoneFn on_done;
+    void* on_done_user;
+    TaskState state;         // parked here while suspended
+    char* wait_key;
+    struct RadsTask* wait_next;
+    struct RadsTask* run_next;
+    struct RadsTask* next;   // task table chain
+} RadsTask;
+
+static RadsTask* task_table[TASK_TABLE_SIZE];
+static RadsTask* wait_table[TASK_TABLE_SIZE];
+static RadsTask* run_head = NULL;
+static RadsTask* run_tail = NULL;
+static uv_idle_t task_idle;
+static bool task_idle_ready = false;
+static long next_task_id = 1;
+
+static size_t wait_bucket(const char* key) {
+    size_t h = 1469598103934665603ULL;
+    for (const unsigned char* p = (const unsigned char*)key; *p; p++) {
+        h = (h ^ *p) * 1099511628211ULL;
+    }
+    return h % TASK_TABLE_SIZE;
+}
+
+// Returns the id in a "task_<n>" handle, or 0.
+static long task_handle_id(const char* handle) {
+    if (!handle || strncmp(handle, TASK_HANDLE_PREFIX, sizeof(TASK_HANDLE_PREFIX) - 1) != 0) return 0;
+    const char* digits = handle + sizeof(TASK_HANDLE_PREFIX) - 1;
+    char* end = NULL;
+    long id = strtol(digits, &end, 10);
+    if (end == digits || *end || id <= 0 || id >= next_task_id) return 0;
+    return id;
+}
+
+static RadsTask* task_find(long id) {
+    for (RadsTask* t = task_table[id % TASK_TABLE_SIZE]; t; t = t->next) {
+        if (t->id == id) return t;
+    }
+    return NULL;
+}
+
+static void task_state_save(TaskState* state) {
+    state->task = current_task;
+    state->locals = local_env;
+    state->return_value = current_return_value;
+    state->has_return = has_return_value;
+    state->thrown = thrown_value;
+    state->has_thrown = has_thrown_value;
+}
+
+static void task_state_load(const TaskState* state) {
+    current_task = state->task;
+    local_env = state->locals;
+    current_return_value = state->return_value;
+    has_return_value = state->has_return;
+    thrown_value = state->thrown;
+    has_thrown_value = state->has_thrown;
+}
+
+static void task_destroy(RadsTask* task) {
+    RadsTask** cur = &task_table[task->id % TASK_TABLE_SIZE];
+    while (*cur && *cur != task) cur = &(*cur)->next;
+    if (*cur) *cur = task->next;
+    if (task->wait_key) {
+        RadsTask** w = &wait_table[wait_bucket(task->wait_key)];
+        while (*w && *w != task) w = &(*w)->wait_next;
+        if (*w) *w = task->wait_next;
+        free(task->wait_key);
+    }
+    coroutine_free(task->co);
+    for (int i = 0; i < task->argc; i++) value_free(&task->args[i]);
+    free(task->args);
+    value_free(&task->func);
+    value_free(&task->result);
+    env_list_free(task->state.locals);
+    if (task->state.has_return) value_free(&task->state.return_value);
+    if (task->state.has_thrown) value_free(&task->state.thrown);
+    free(task);
+}
+
+static void task_main(void* arg) {
+    RadsTask* task = arg;
+    task->result = call_function(task->func, task->argc, task->args);
+    if (has_thrown_value) {
+        char where[64];
+        snprintf(where, sizeof(where), "async task %s", task->handle);
+        report_uncaught(where);
+    }
+}
+
+// Runs task until it suspends or finishes, keeping the caller's state.
+static void task_resume(RadsTask* task) {
+    TaskState outer;
+    task_state_save(&outer);
+    task_state_load(&task->state);
+    bool finished = coroutine_resume(task->co);
+    task_state_save(&task->state);
+    task_state_load(&outer);
+    if (!finished) return;
+
+    task->done = true;
+    coroutine_free(task->co);
+    task->co = NULL;
+    if (task->on_done) {
+        task->on_done(&task->result, task->on_done_user);
+        task_destroy(task);
+        return;
+    }
+    char handle[sizeof(task->handle)];
+    memcpy(handle, task->handle, sizeof(handle));
+    bool drop = task->detached || task->result.type == VAL_NULL;
+    // Awaiting tasks take the result; otherwise it is kept for a later
+    // await unless there is nothing worth keeping.
+    if (interpreter_wake(handle) == 0 && drop) task_destroy(task);
+}
+
+static void task_idle_cb(uv_idle_t* handle) {
+    RadsTask* batch = run_head;
+    run_head = run_tail = NULL;
+    while (batch) {
+        RadsTask* task = batch;
+        batch = task->run_next;
+        task->run_next = NULL;
+        task->queued = false;
+        task_resume(task);
+    }
+    if (!run_head) uv_idle_stop(handle);
+}
+
+static void task_schedule(RadsTask* task) {
+    if (task->queued) return;
+    task->queued = true;
+    if (run_tail) run_tail->run_next = task;
+    else run_head = task;
+    run_tail = task;
+    if (!task_idle_ready) {
+        uv_idle_init(interpreter_init_event_loop(), &task_idle);
+        task_idle_ready = true;
+    }
+    uv_idle_start(&task_idle, task_idle_cb);
+}
+
+static Value task_spawn(Value callback, int argc, Value* args) {
+    RadsTask* task = calloc(1, sizeof(RadsTask));
+    task->co = coroutine_create(task_main, task);
+    if (!task->co) {
+        // Out of stacks: run it to completion on the caller's stack.
+        free(task);
+        fprintf(stderr, "Error: Could not allocate a task stack; running synchronously\n");
+        return call_function(callback, argc, args);
+    }
+    task->id = next_task_id++;
+    snprintf(task->handle, sizeof(task->handle), TASK_HANDLE_PREFIX "%ld", task->id);
+    task->func = value_clone(callback);
+    task->argc = argc;
+    task->args = malloc(sizeof(Value) * (argc > 0 ? argc : 1));
+    for (int i = 0; i < argc; i++) task->args[i] = value_clone(args[i]);
+    task->result = make_null();
+    task->state.task = task;
+    task->next = task_table[task->id % TASK_TABLE_SIZE];
+    task_table[task->id % TASK_TABLE_SIZE] = task;
+
+    Value handle = make_string(task->handle);
+    task_resume(task);
+    return handle;
+}
+
+static void task_detach_value(const Value* v) {
+    if (v->type != VAL_STRING) return;
+    long id = task_handle_id(v->string_val);
+    RadsTask* task = id ? task_find(id) : NULL;
+    if (!task) return;
+    if (task->done) task_destroy(task);
+    else task->detached = true;
+}
+
+bool interpreter_in_task(void) {
+    return current_task != NULL;
+}
+
+bool interpreter_wait(const char* key) {
+    if (workpool_on_worker()) return false;
+    if (!current_task) {
+        uv_loop_t* loop = interpreter_init_event_loop();
+        if (!uv_loop_alive(loop)) return false;
+        uv_run(loop, UV_RUN_ONCE);
+        return true;
+    }
+    RadsTask* task = current_task;
+    size_t bucket = wait_bucket(key);
+    task->wait_key = strdup(key);
+    task->wait_next = wait_table[bucket];
+    wait_table[bucket] = task;
+    coroutine_yield();
+    return true;
+}
+
+int interpreter_wake(const char* key) {
+    if (!key) return 0;
+    int woken = 0;
+    RadsTask** cur = &wait_table[wait_bucket(key)];
+    while (*cur) {
+        RadsTask* task = *cur;
+        if (strcmp(task->wait_key, key) != 0) {
+            cur = &task->wait_next;
+            continue;
+        }
+        *cur = task->wait_next;
+        task->wait_next = NULL;
+        free(task->wait_key);
+        task->wait_key = NULL;
+        task_schedule(task);
+        woken++;
+    }
+    return woken;
+}
+
+bool interpreter_task_defer(Value* value, TaskDoneFn fn, void* user) {
+    if (value->type != VAL_STRING) return false;
+    long id = task_handle_id(value->string_val);
+    if (!id) return false;
+    RadsTask* task = task_find(id);
+    value_free(value);
+    *value = make_null();
+    if (!task) return false;
+    if (task->done) {
+        *value = task->result;
+        task->result = make_null();
+        task_destroy(task);
+        return false;
+    }
+    task->on_done = fn;
+    task->on_done_user = user;
+    return true;
+}
+
+// Native waits registered for handle kinds other than tasks.
+typedef struct AwaitableBinding {
+    char* handle_prefix;
+    NativeFn wait;
+    struct AwaitableBinding* next;
+} AwaitableBinding;
+
+static AwaitableBinding* awaitables = NULL;
+
+void register_awaitable(const char* handle_prefix, NativeFn wait) {
+    AwaitableBinding* binding = malloc(sizeof(AwaitableBinding));
+    binding->handle_prefix = strdup(handle_prefix);
+    binding->wait = wait;
+    binding->next = awaitables;
+    awaitables = binding;
+}
+
+typedef struct IterableBinding {
+    char* handle_prefix;
+    NativeFn next;
+    struct IterableBinding* next_binding;
+} IterableBinding;
+
+static IterableBinding* iterables = NULL;
+
+void register_iterable(const char* handle_prefix, NativeFn next) {
+    IterableBinding* binding = malloc(sizeof(IterableBinding));
+    binding->handle_prefix = strdup(handle_prefix);
+    binding->next = next;
+    binding->next_binding = iterables;
+    iterables = binding;
+}
+
+static NativeFn find_iterable(const char* handle) {
+    for (IterableBinding* b = iterables; b; b = b->next_binding) {
+        if (strncmp(handle, b->handle_prefix, strlen(b->handle_prefix)) == 0) return b->next;
+    }
+    return NULL;
+}
+
+// await <v>: a task handle waits for the task's result, a registered handle
+// for its native wait; any other value is its own result. Takes v.
+static Value await_value(Value v) {
+    if (v.type != VAL_STRING || workpool_on_worker()) return v;
+    long id = task_handle_id(v.string_val);
+    if (id) {
+        RadsTask* task = task_find(id);
+        while (task && !task->done && task != current_task) {
+            if (!interpreter_wait(v.string_val)) break;
+            task = task_find(id);
+        }
+        value_free(&v);
+        if (!task || !task->done) return make_null();
+        Value result = task->result;
+        task->result = make_null();
+        task_destroy(task);
+        return result;
+    }
+    for (AwaitableBinding* b = awaitables; b; b = b->next) {
+        if (strncmp(v.string_val, b->handle_prefix, strlen(b->handle_prefix)) == 0) {
+            Value result = b->wait(global_interpreter, 1, &v);
+            value_free(&v);
+            return result;
+        }
+    }
+    return v;
+}
+
+// Tasks still suspended when the program ends are dropped.
+static void tasks_shutdown(void) {
+    for (size_t i = 0; i < TASK_TABLE_SIZE; i++) {
+        while (task_table[i]) task_destroy(task_table[i]);
+    }
+    run_head = run_tail = NULL;
+    if (task_idle_ready) {
+        uv_close((uv_handle_t*)&task_idle, NULL);
+        uv_run(global_event_loop, UV_RUN_NOWAIT);
+        task_idle_ready = false;
+    }
+    coroutine_pool_drain();
+}
+
+// ============================================================================
+// Parallel jobs
+// ============================================================================
+//
+// Pool workers evaluate functions concurrently with the loop thread. Each
+// job gets a fresh environment seeded from a snapshot of the caller's
+// functions and scalar globals, and only values that were deep-copied for
+// it, so no array refcount or binding is ever shared between threads.
+
+struct InterpreterSnapshot {
+    Environment* env;
+};
+
+Value value_deep_copy(Value v) {
+    Value out = v;
+    switch (v.type) {
+        case VAL_STRING:
+            out.string_val = strdup(v.string_val);
+            break;
+        case VAL_BYTES:
+            out = make_bytes(v.bytes_val->buf->data + v.bytes_val->offset, v.bytes_val->length);
+            break;
+        case VAL_NUMARRAY: {
+            NumArray* arr = numarray_create(v.numarray_val->kind, v.numarray_val->count);
+            if (!arr) {
+                out = make_null();
+                break;
+            }
+            memcpy(arr->data, v.numarray_val->data, arr->count * sizeof(double));
+            out = make_numarray(arr);
+            break;
+        }
+        case VAL_ARRAY:
+            if (v.array_val) {
+                Array* arr = array_create(v.array_val->count);
+                for (size_t i = 0; i < v.array_val->count; i++) {
+                    arr->items[i] = value_deep_copy(v.array_val->items[i]);
+                }
+                arr->count = v.array_val->count;
+                out.array_val = arr;
+            }
+            break;
+        case VAL_STRUCT_INSTANCE:
+            if (v.struct_instance) {
+                StructInstance* instance = malloc(sizeof(StructInstance));
+                instance->definition = v.struct_instance->definition;
+                instance->fields = NULL;
+                FieldValue** tail = &instance->fields;
+                for (FieldValue* f = v.struct_instance->fields; f; f = f->next) {
+                    FieldValue* field = malloc(sizeof(FieldValue));
+                    field->name = strdup(f->name);
+                    field->value = malloc(sizeof(Value));
+                    *field->value = value_deep_copy(*f->value);
+                    field->next = NULL;
+                    *tail = field;
+                    tail = &field->next;
+                }
+                out.struct_instance = instance;
+            }
+            break;
+        default:
+            break;
+    }
+    return out;
+}
+
+static void snapshot_add(Environment** list, Environment* from) {
+    for (Environment* e = from; e; e = e->next) {
+        switch (e->value.type) {
+            case VAL_FUNCTION:
+            case VAL_BOOL:
+            case VAL_INT:
+            case VAL_FLOAT:
+            case VAL_STRING:
+                if (!env_find(*list, e->name)) env_bind(list, e->name, value_clone(e->value));
+                break;
+            default:
+                // Arrays and structs are passed to jobs as arguments.
+                break;
+        }
+    }
+}
+
+InterpreterSnapshot* interpreter_snapshot(void) {
+    InterpreterSnapshot* snapshot = calloc(1, sizeof(InterpreterSnapshot));
+    snapshot_add(&snapshot->env, local_env);
+    snapshot_add(&snapshot->env, global_env);
+    return snapshot;
+}
+
+void interpreter_snapshot_free(InterpreterSnapshot* snapshot) {
+    if (!snapshot) return;
+    env_list_free(snapshot->env);
+    free(snapshot);
+}
+
+Value interpreter_isolated_call(const InterpreterSnapshot* snapshot, Value callback, int argc, Value* args) {
+    // A nested call on the same thread must not lose its caller's state.
+    Environment* saved_env = global_env;
+    TaskState saved;
+    task_state_save(&saved);
+    global_env = NULL;
+    local_env = NULL;
+    current_task = NULL;
+    has_return_value = false;
+    has_thrown_value = false;
+    for (Environment* e = snapshot->env; e; e = e->next) {
+        env_bind(&global_env, e->name, value_clone(e->value));
+    }
+
+    Value result = make_null();
+    if (callback.type == VAL_FUNCTION) {
+        result = call_function(callback, argc, args);
+    }
+    if (has_thrown_value) report_uncaught("parallel job");
+    if (has_return_value) {
+        value_free(&current_return_value);
+        has_return_value = false;
+    }
+    for (int i = 0; i < argc; i++) value_free(&args[i]);
+    env_list_free(global_env);
+    env_list_free(local_env);
+    global_env = saved_env;
+    task_state_load(&saved);
+    return result;
+}
+
 // Main interpreter
 int interpret(ASTNode* program) {
     if (!program || program->type != AST_PROGRAM) {
@@ -1451,6 +2301,7 @@ int interpret(ASTNode* program) {
     }
     
     // Pass 2: Execute main function if it exists
+    int status = 0;
     Value main_val = env_get("main");
     if (main_val.type == VAL_FUNCTION) {
         exec_statement(main_val.func_node->function_decl.body);
@@ -1465,11 +2316,21 @@ int interpret(ASTNode* program) {
             }
         }
     }
+    if (has_thrown_value) {
+        report_uncaught("main");
+        status = 1;
+    }
 
+    // Let pending async work (HTTP client requests, timers) deliver callbacks
+    // before tearing the environment down. Handles nothing can use any more
+    // are closed first so they don't keep the loop alive forever.
+    for (int i = 0; i < main_return_hook_count; i++) main_return_hooks[i]();
+    interpreter_run_event_loop();
 
+    tasks_shutdown();
     env_free();
     interpreter_cleanup_event_loop();
-    return 0;
+    return status;
 }
 
 // REPL-specific interpreter - executes single statement without clearing environment
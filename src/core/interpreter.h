@@ -23,7 +23,9 @@ typedef enum {
     VAL_FUNCTION,
     VAL_ARRAY,
     VAL_STRUCT_DEF,
-    VAL_STRUCT_INSTANCE
+    VAL_STRUCT_INSTANCE,
+    VAL_BYTES,
+    VAL_NUMARRAY
 } ValueType;
 
 struct Value; // Forward declaration
@@ -35,6 +37,44 @@ typedef struct Array {
     struct Value* items;
 } Array;
 
+// Storage behind bytes values. data holds length bytes in use out of
+// capacity. release, when set, frees data instead of free() (e.g. munmap
+// for a mapped file); owner is for its use.
+typedef struct ByteBuffer {
+    size_t refcount;
+    size_t length;
+    size_t capacity;
+    unsigned char* data;
+    void (*release)(struct ByteBuffer* buf);
+    void* owner;
+} ByteBuffer;
+
+// A bytes value is a view of offset..offset+length in a shared buffer, so
+// slices and copies of the value alias the same storage.
+typedef struct Bytes {
+    ByteBuffer* buf;
+    size_t offset;
+    size_t length;
+} Bytes;
+
+// Unboxed numbers behind f64array and i64array values: count elements in
+// one 32-byte aligned block. Shared by reference like arrays.
+typedef enum {
+    NUM_F64,
+    NUM_I64
+} NumArrayKind;
+
+typedef struct NumArray {
+    size_t refcount;
+    NumArrayKind kind;
+    size_t count;
+    union {
+        double* f64;
+        long long* i64;
+        void* data;
+    };
+} NumArray;
+
 typedef struct FieldValue {
     char* name;
     struct Value* value;
@@ -62,6 +102,8 @@ typedef struct Value {
         Array* array_val;
         StructDef* struct_def;
         StructInstance* struct_instance;
+        Bytes* bytes_val;
+        NumArray* numarray_val;
     };
 } Value;
 
@@ -86,12 +128,58 @@ typedef enum {
 } FunctionType;
 
 void register_native(const char* name, NativeFn fn);
+// Route method calls on string handles with the given prefix (e.g. "http_res_")
+// to natives named <native_prefix><member> (e.g. "net.res_write").
+void register_handle_methods(const char* handle_prefix, const char* native_prefix);
+// `await` on a string handle with this prefix calls wait(handle) (which
+// should block via interpreter_wait) and evaluates to its result.
+void register_awaitable(const char* handle_prefix, NativeFn wait);
+// `cruise (x in h)` over a string handle with this prefix calls next(h)
+// for each item until it returns null.
+void register_iterable(const char* handle_prefix, NativeFn next);
 uv_loop_t* interpreter_init_event_loop(void);
 void interpreter_cleanup_event_loop(void);
 void interpreter_cleanup_environment(void);
 void interpreter_run_event_loop(void);
+// Runs after main() returns, before the event loop is drained: modules close
+// handles (listeners, sockets) that only the script could still have used.
+void interpreter_on_main_return(void (*fn)(void));
 Value interpreter_execute_callback(Value callback, int argc, Value* args);
 
+// Async tasks. Calling an `async blast` function (directly or as a
+// callback) runs it as a task and evaluates to the task's handle,
+// "task_<n>"; `await` on the handle suspends the caller until the task has
+// finished and evaluates to its result.
+//
+// Natives that block wait for their condition in a loop around
+// interpreter_wait(key): inside a task this suspends only that task until
+// interpreter_wake(key) is called (typically from the libuv callback that
+// changes the condition); on the main path it runs one loop iteration.
+// interpreter_wait returns false when nothing is left that could make
+// progress. key is usually the handle the native operates on.
+typedef void (*TaskDoneFn)(Value* result, void* user);
+bool interpreter_in_task(void);
+bool interpreter_wait(const char* key);
+// Returns how many tasks were waiting on key.
+int interpreter_wake(const char* key);
+// If *value is the handle of an unfinished task, fn gets the task's result
+// (which it may take) when the task finishes, and true is returned.
+// Otherwise returns false, replacing a finished task's handle with its
+// result.
+bool interpreter_task_defer(Value* value, TaskDoneFn fn, void* user);
+
+// Parallel jobs. A snapshot captures the caller's functions and scalar
+// globals; interpreter_isolated_call runs callback on the calling thread
+// (typically a pool worker) in a fresh environment seeded from it, takes
+// args, and returns a result no other thread references. Values cross
+// threads only as deep copies. Jobs must not use natives that need the
+// event loop: interpreter_wait returns false on a worker.
+typedef struct InterpreterSnapshot InterpreterSnapshot;
+InterpreterSnapshot* interpreter_snapshot(void);
+void interpreter_snapshot_free(InterpreterSnapshot* snapshot);
+Value interpreter_isolated_call(const InterpreterSnapshot* snapshot, Value callback, int argc, Value* args);
+Value value_deep_copy(Value v);
+
 Value make_int(long long val);
 Value make_float(double val);
 Value make_string(const char* val);
@@ -100,4 +188,22 @@ Value make_null(void);
 Array* array_create(size_t capacity);
 void array_push(Array* arr, Value v);
 
+// Bytes values. make_bytes copies data; make_bytes_owned takes a malloc'd
+// block of capacity bytes with length in use; make_bytes_view adds a
+// reference to buf. value_bytes returns the data and length of a bytes or
+// string value (NULL for other types), so natives can accept either.
+ByteBuffer* byte_buffer_create(size_t capacity);
+void byte_buffer_release(ByteBuffer* buf);
+Value make_bytes(const void* data, size_t length);
+Value make_bytes_owned(unsigned char* data, size_t length, size_t capacity);
+Value make_bytes_view(ByteBuffer* buf, size_t offset, size_t length);
+const unsigned char* value_bytes(const Value* v, size_t* length);
+
+// Numeric arrays. numarray_create returns count zeroed elements with one
+// reference held by the caller, or NULL after printing an error when they
+// cannot be allocated; make_numarray takes that reference over.
+NumArray* numarray_create(NumArrayKind kind, size_t count);
+void numarray_release(NumArray* arr);
+Value make_numarray(NumArray* arr);
+
 #endif // RADS_INTERPRETER_H
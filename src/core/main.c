@@ -24,6 +24,11 @@
 #include "stdlib_async_utils.h"
 #include "stdlib_websocket.h"
 #include "stdlib_graphql.h"
+#include "stdlib_chan.h"
+#include "stdlib_bytes.h"
+#include "stdlib_regex.h"
+#include "stdlib_numarray.h"
+#include "stdlib_test.h"
 
 // ANSI Color Codes for Chroma Effects
 #define COLOR_RESET     "\033[0m"
@@ -259,6 +264,13 @@ int run_repl() {
     stdlib_json_register();
     stdlib_db_register();
     stdlib_webengine_register();
+    stdlib_websocket_register();
+    stdlib_graphql_register();
+    stdlib_chan_register();
+    stdlib_bytes_register();
+    stdlib_regex_register();
+    stdlib_numarray_register();
+    stdlib_test_register();
 
     // Initialize event loop for REPL
     interpreter_init_event_loop();
@@ -462,8 +474,13 @@ int main(int argc, char* argv[]) {
     stdlib_webengine_register();
     stdlib_filesystem_register();
     stdlib_async_utils_register();
-    // TODO: stdlib_websocket_register();
-    // TODO: stdlib_graphql_register();
+    stdlib_websocket_register();
+    stdlib_graphql_register();
+    stdlib_chan_register();
+    stdlib_bytes_register();
+    stdlib_regex_register();
+    stdlib_numarray_register();
+    stdlib_test_register();
     
 
     // Tokenize
@@ -483,6 +500,11 @@ int main(int argc, char* argv[]) {
     
     // Interpret
     int result = interpret(program);
+    if (result == 0 && test_failure_count() > 0) {
+        fflush(stdout);
+        fprintf(stderr, "\n%d check%s failed\n", test_failure_count(), test_failure_count() == 1 ? "" : "s");
+        result = 1;
+    }
     
     // Cleanup
     ast_free(program);
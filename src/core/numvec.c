@@ -0,0 +1,704 @@
+#include "numvec.h"
+#include "textscan.h"
+#include <math.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NUMVEC_X86 1
+#include <immintrin.h>
+#endif
+
+// Sixteen accumulators: four AVX2 registers of four lanes.
+#define LANES 16
+
+typedef struct NumKernels {
+    void (*f64_arith)(NumVecOp op, double* dst, const double* a, const double* b, size_t b_step, size_t n);
+    void (*i64_arith)(NumVecOp op, long long* dst, const long long* a, const long long* b, size_t b_step,
+                      size_t n);
+    void (*f64_fma)(double* dst, const double* a, const double* b, size_t b_step, const double* c,
+                    size_t c_step, size_t n);
+    void (*f64_compare)(NumVecCmp cmp, long long* mask, const double* a, const double* b, size_t b_step,
+                        size_t n);
+    void (*i64_compare)(NumVecCmp cmp, long long* mask, const long long* a, const long long* b,
+                        size_t b_step, size_t n);
+    void (*where)(long long* dst, const long long* mask, const long long* x, size_t x_step, const long long* y,
+                  size_t y_step, size_t n);
+    void (*f64_clamp)(double* dst, const double* a, double lo, double hi, size_t n);
+    void (*i64_clamp)(long long* dst, const long long* a, long long lo, long long hi, size_t n);
+    double (*f64_sum)(const double* a, size_t n);
+    double (*f64_dot)(const double* a, const double* b, size_t n);
+    double (*f64_sq_dev)(const double* a, double mean, size_t n);
+    double (*f64_min)(const double* a, size_t n);
+    double (*f64_max)(const double* a, size_t n);
+    long long (*i64_sum)(const long long* a, size_t n);
+    long long (*i64_min)(const long long* a, size_t n);
+    long long (*i64_max)(const long long* a, size_t n);
+    void (*f64_cumsum)(double* dst, const double* a, size_t n);
+    void (*i64_cumsum)(long long* dst, const long long* a, size_t n);
+} NumKernels;
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+// Integer arithmetic wraps like the hardware instead of being undefined.
+static long long wrap_add(long long a, long long b) {
+    return (long long)((unsigned long long)a + (unsigned long long)b);
+}
+
+static long long wrap_sub(long long a, long long b) {
+    return (long long)((unsigned long long)a - (unsigned long long)b);
+}
+
+static long long wrap_mul(long long a, long long b) {
+    return (long long)((unsigned long long)a * (unsigned long long)b);
+}
+
+// Adds lane l + w into lane l for w = 8, 4, 2, 1: the fixed order every
+// version finishes a sum in.
+static double lanes_combine(double* acc) {
+    for (size_t w = LANES / 2; w > 0; w /= 2) {
+        for (size_t l = 0; l < w; l++) acc[l] += acc[l + w];
+    }
+    return acc[0];
+}
+
+static void f64_arith_scalar(NumVecOp op, double* dst, const double* a, const double* b, size_t b_step,
+                             size_t n) {
+    switch (op) {
+        case NUMVEC_ADD:
+            for (size_t i = 0; i < n; i++) dst[i] = a[i] + b[i * b_step];
+            break;
+        case NUMVEC_SUB:
+            for (size_t i = 0; i < n; i++) dst[i] = a[i] - b[i * b_step];
+            break;
+        case NUMVEC_MUL:
+            for (size_t i = 0; i < n; i++) dst[i] = a[i] * b[i * b_step];
+            break;
+        case NUMVEC_DIV:
+            for (size_t i = 0; i < n; i++) dst[i] = a[i] / b[i * b_step];
+            break;
+    }
+}
+
+static void i64_arith_scalar(NumVecOp op, long long* dst, const long long* a, const long long* b, size_t b_step,
+                             size_t n) {
+    switch (op) {
+        case NUMVEC_ADD:
+            for (size_t i = 0; i < n; i++) dst[i] = wrap_add(a[i], b[i * b_step]);
+            break;
+        case NUMVEC_SUB:
+            for (size_t i = 0; i < n; i++) dst[i] = wrap_sub(a[i], b[i * b_step]);
+            break;
+        case NUMVEC_MUL:
+            for (size_t i = 0; i < n; i++) dst[i] = wrap_mul(a[i], b[i * b_step]);
+            break;
+        case NUMVEC_DIV:
+            break;
+    }
+}
+
+static void f64_fma_scalar(double* dst, const double* a, const double* b, size_t b_step, const double* c,
+                           size_t c_step, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = fma(a[i], b[i * b_step], c[i * c_step]);
+}
+
+static bool f64_holds(NumVecCmp cmp, double x, double y) {
+    switch (cmp) {
+        case NUMVEC_LT: return x < y;
+        case NUMVEC_LE: return x <= y;
+        case NUMVEC_GT: return x > y;
+        case NUMVEC_GE: return x >= y;
+        case NUMVEC_EQ: return x == y;
+        case NUMVEC_NE: return x != y;
+    }
+    return false;
+}
+
+static bool i64_holds(NumVecCmp cmp, long long x, long long y) {
+    switch (cmp) {
+        case NUMVEC_LT: return x < y;
+        case NUMVEC_LE: return x <= y;
+        case NUMVEC_GT: return x > y;
+        case NUMVEC_GE: return x >= y;
+        case NUMVEC_EQ: return x == y;
+        case NUMVEC_NE: return x != y;
+    }
+    return false;
+}
+
+static void f64_compare_scalar(NumVecCmp cmp, long long* mask, const double* a, const double* b, size_t b_step,
+                               size_t n) {
+    for (size_t i = 0; i < n; i++) mask[i] = f64_holds(cmp, a[i], b[i * b_step]);
+}
+
+static void i64_compare_scalar(NumVecCmp cmp, long long* mask, const long long* a, const long long* b,
+                               size_t b_step, size_t n) {
+    for (size_t i = 0; i < n; i++) mask[i] = i64_holds(cmp, a[i], b[i * b_step]);
+}
+
+static void where_scalar(long long* dst, const long long* mask, const long long* x, size_t x_step,
+                         const long long* y, size_t y_step, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = mask[i] ? x[i * x_step] : y[i * y_step];
+}
+
+// NaN stays NaN, as with the AVX2 max/min operand order below.
+static void f64_clamp_scalar(double* dst, const double* a, double lo, double hi, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        double x = a[i] < lo ? lo : a[i];
+        dst[i] = x > hi ? hi : x;
+    }
+}
+
+static void i64_clamp_scalar(long long* dst, const long long* a, long long lo, long long hi, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        long long x = a[i] < lo ? lo : a[i];
+        dst[i] = x > hi ? hi : x;
+    }
+}
+
+static double f64_sum_scalar(const double* a, size_t n) {
+    double acc[LANES] = {0};
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t l = 0; l < LANES; l++) acc[l] += a[i + l];
+    }
+    double s = lanes_combine(acc);
+    for (; i < n; i++) s += a[i];
+    return s;
+}
+
+static double f64_dot_scalar(const double* a, const double* b, size_t n) {
+    double acc[LANES] = {0};
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t l = 0; l < LANES; l++) acc[l] += a[i + l] * b[i + l];
+    }
+    double s = lanes_combine(acc);
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+static double f64_sq_dev_scalar(const double* a, double mean, size_t n) {
+    double acc[LANES] = {0};
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t l = 0; l < LANES; l++) {
+            double d = a[i + l] - mean;
+            acc[l] += d * d;
+        }
+    }
+    double s = lanes_combine(acc);
+    for (; i < n; i++) {
+        double d = a[i] - mean;
+        s += d * d;
+    }
+    return s;
+}
+
+static double f64_min_scalar(const double* a, size_t n) {
+    double m = a[0];
+    for (size_t i = 1; i < n; i++) m = a[i] < m ? a[i] : m;
+    return m;
+}
+
+static double f64_max_scalar(const double* a, size_t n) {
+    double m = a[0];
+    for (size_t i = 1; i < n; i++) m = a[i] > m ? a[i] : m;
+    return m;
+}
+
+static long long i64_sum_scalar(const long long* a, size_t n) {
+    long long s = 0;
+    for (size_t i = 0; i < n; i++) s = wrap_add(s, a[i]);
+    return s;
+}
+
+static long long i64_min_scalar(const long long* a, size_t n) {
+    long long m = a[0];
+    for (size_t i = 1; i < n; i++) m = a[i] < m ? a[i] : m;
+    return m;
+}
+
+static long long i64_max_scalar(const long long* a, size_t n) {
+    long long m = a[0];
+    for (size_t i = 1; i < n; i++) m = a[i] > m ? a[i] : m;
+    return m;
+}
+
+static void f64_cumsum_tail(double* dst, const double* a, size_t n, double carry) {
+    for (size_t i = 0; i < n; i++) {
+        carry += a[i];
+        dst[i] = carry;
+    }
+}
+
+// Blocks of four are scanned the way the AVX2 version does it: each lane
+// adds the lane one back, then the lane two back (zeros shifted in at the
+// front), then the total of the blocks before.
+static void f64_cumsum_scalar(double* dst, const double* a, size_t n) {
+    double carry = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        double y0 = a[i] + 0.0, y1 = a[i + 1] + a[i], y2 = a[i + 2] + a[i + 1], y3 = a[i + 3] + a[i + 2];
+        double z0 = y0 + 0.0, z1 = y1 + 0.0, z2 = y2 + y0, z3 = y3 + y1;
+        dst[i] = z0 + carry;
+        dst[i + 1] = z1 + carry;
+        dst[i + 2] = z2 + carry;
+        dst[i + 3] = z3 + carry;
+        carry = dst[i + 3];
+    }
+    f64_cumsum_tail(dst + i, a + i, n - i, carry);
+}
+
+static void i64_cumsum_tail(long long* dst, const long long* a, size_t n, long long carry) {
+    for (size_t i = 0; i < n; i++) {
+        carry = wrap_add(carry, a[i]);
+        dst[i] = carry;
+    }
+}
+
+static void i64_cumsum_scalar(long long* dst, const long long* a, size_t n) {
+    i64_cumsum_tail(dst, a, n, 0);
+}
+
+static NumKernels kernels = {
+    f64_arith_scalar, i64_arith_scalar, f64_fma_scalar, f64_compare_scalar, i64_compare_scalar, where_scalar,
+    f64_clamp_scalar, i64_clamp_scalar, f64_sum_scalar, f64_dot_scalar, f64_sq_dev_scalar, f64_min_scalar,
+    f64_max_scalar, i64_sum_scalar, i64_min_scalar, i64_max_scalar, f64_cumsum_scalar, i64_cumsum_scalar
+};
+static bool use_avx2 = false;
+
+#ifdef NUMVEC_X86
+
+// ============================================================================
+// AVX2 + FMA: four 64-bit lanes. Each kernel runs whole vectors and hands
+// the last n % 4 elements to the scalar version. Broadcast operands are
+// only read when their step is 0, so empty arrays are never touched.
+// ============================================================================
+
+#define AVX2 __attribute__((target("avx2,fma")))
+
+#define F64_ARITH_AVX2(vop)                                                     \
+    for (; i + 4 <= n; i += 4) {                                                \
+        __m256d vb = b_step ? _mm256_loadu_pd(b + i) : bb;                      \
+        _mm256_storeu_pd(dst + i, vop(_mm256_loadu_pd(a + i), vb));             \
+    }
+
+AVX2 static void f64_arith_avx2(NumVecOp op, double* dst, const double* a, const double* b, size_t b_step,
+                                size_t n) {
+    const __m256d bb = _mm256_set1_pd(b_step ? 0.0 : b[0]);
+    size_t i = 0;
+    switch (op) {
+        case NUMVEC_ADD: F64_ARITH_AVX2(_mm256_add_pd); break;
+        case NUMVEC_SUB: F64_ARITH_AVX2(_mm256_sub_pd); break;
+        case NUMVEC_MUL: F64_ARITH_AVX2(_mm256_mul_pd); break;
+        case NUMVEC_DIV: F64_ARITH_AVX2(_mm256_div_pd); break;
+    }
+    f64_arith_scalar(op, dst + i, a + i, b + i * b_step, b_step, n - i);
+}
+
+// AVX2 has no 64-bit multiply (that is AVX-512), so mul stays scalar.
+AVX2 static void i64_arith_avx2(NumVecOp op, long long* dst, const long long* a, const long long* b,
+                                size_t b_step, size_t n) {
+    if (op != NUMVEC_ADD && op != NUMVEC_SUB) {
+        i64_arith_scalar(op, dst, a, b, b_step, n);
+        return;
+    }
+    const __m256i bb = _mm256_set1_epi64x(b_step ? 0 : b[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = b_step ? _mm256_loadu_si256((const __m256i*)(b + i)) : bb;
+        __m256i r = op == NUMVEC_ADD ? _mm256_add_epi64(va, vb) : _mm256_sub_epi64(va, vb);
+        _mm256_storeu_si256((__m256i*)(dst + i), r);
+    }
+    i64_arith_scalar(op, dst + i, a + i, b + i * b_step, b_step, n - i);
+}
+
+AVX2 static void f64_fma_avx2(double* dst, const double* a, const double* b, size_t b_step, const double* c,
+                              size_t c_step, size_t n) {
+    const __m256d bb = _mm256_set1_pd(b_step ? 0.0 : b[0]);
+    const __m256d cc = _mm256_set1_pd(c_step ? 0.0 : c[0]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d vb = b_step ? _mm256_loadu_pd(b + i) : bb;
+        __m256d vc = c_step ? _mm256_loadu_pd(c + i) : cc;
+        _mm256_storeu_pd(dst + i, _mm256_fmadd_pd(_mm256_loadu_pd(a + i), vb, vc));
+    }
+    f64_fma_scalar(dst + i, a + i, b + i * b_step, b_step, c + i * c_step, c_step, n - i);
+}
+
+// Ordered predicates, except NE which is true for NaN like C's !=.
+#define F64_COMPARE_AVX2(pred)                                                  \
+    for (; i + 4 <= n; i += 4) {                                                \
+        __m256d vb = b_step ? _mm256_loadu_pd(b + i) : bb;                      \
+        __m256i m = _mm256_castpd_si256(_mm256_cmp_pd(_mm256_loadu_pd(a + i), vb, pred)); \
+        _mm256_storeu_si256((__m256i*)(mask + i), _mm256_and_si256(m, one));    \
+    }
+
+AVX2 static void f64_compare_avx2(NumVecCmp cmp, long long* mask, const double* a, const double* b, size_t b_step,
+                                  size_t n) {
+    const __m256d bb = _mm256_set1_pd(b_step ? 0.0 : b[0]);
+    const __m256i one = _mm256_set1_epi64x(1);
+    size_t i = 0;
+    switch (cmp) {
+        case NUMVEC_LT: F64_COMPARE_AVX2(_CMP_LT_OQ); break;
+        case NUMVEC_LE: F64_COMPARE_AVX2(_CMP_LE_OQ); break;
+        case NUMVEC_GT: F64_COMPARE_AVX2(_CMP_GT_OQ); break;
+        case NUMVEC_GE: F64_COMPARE_AVX2(_CMP_GE_OQ); break;
+        case NUMVEC_EQ: F64_COMPARE_AVX2(_CMP_EQ_OQ); break;
+        case NUMVEC_NE: F64_COMPARE_AVX2(_CMP_NEQ_UQ); break;
+    }
+    f64_compare_scalar(cmp, mask + i, a + i, b + i * b_step, b_step, n - i);
+}
+
+// Every comparison is a > or == with the operands maybe swapped and the
+// result maybe negated: a <= b is !(a > b), a >= b is !(b > a).
+AVX2 static void i64_compare_avx2(NumVecCmp cmp, long long* mask, const long long* a, const long long* b,
+                                  size_t b_step, size_t n) {
+    const __m256i bb = _mm256_set1_epi64x(b_step ? 0 : b[0]);
+    const __m256i one = _mm256_set1_epi64x(1);
+    bool eq = cmp == NUMVEC_EQ || cmp == NUMVEC_NE;
+    bool swap = cmp == NUMVEC_LT || cmp == NUMVEC_GE;
+    bool negate = cmp == NUMVEC_LE || cmp == NUMVEC_GE || cmp == NUMVEC_NE;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = b_step ? _mm256_loadu_si256((const __m256i*)(b + i)) : bb;
+        __m256i m = eq ? _mm256_cmpeq_epi64(va, vb) : swap ? _mm256_cmpgt_epi64(vb, va) : _mm256_cmpgt_epi64(va, vb);
+        m = negate ? _mm256_andnot_si256(m, one) : _mm256_and_si256(m, one);
+        _mm256_storeu_si256((__m256i*)(mask + i), m);
+    }
+    i64_compare_scalar(cmp, mask + i, a + i, b + i * b_step, b_step, n - i);
+}
+
+AVX2 static void where_avx2(long long* dst, const long long* mask, const long long* x, size_t x_step,
+                            const long long* y, size_t y_step, size_t n) {
+    const __m256i xx = _mm256_set1_epi64x(x_step ? 0 : x[0]);
+    const __m256i yy = _mm256_set1_epi64x(y_step ? 0 : y[0]);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i vx = x_step ? _mm256_loadu_si256((const __m256i*)(x + i)) : xx;
+        __m256i vy = y_step ? _mm256_loadu_si256((const __m256i*)(y + i)) : yy;
+        __m256i unset = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)(mask + i)), zero);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(vx, vy, unset));
+    }
+    where_scalar(dst + i, mask + i, x + i * x_step, x_step, y + i * y_step, y_step, n - i);
+}
+
+// max_pd/min_pd return their second operand when either is NaN, so with x
+// second a NaN passes through as in the scalar version.
+AVX2 static void f64_clamp_avx2(double* dst, const double* a, double lo, double hi, size_t n) {
+    const __m256d vlo = _mm256_set1_pd(lo);
+    const __m256d vhi = _mm256_set1_pd(hi);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_max_pd(vlo, _mm256_loadu_pd(a + i));
+        _mm256_storeu_pd(dst + i, _mm256_min_pd(vhi, x));
+    }
+    f64_clamp_scalar(dst + i, a + i, lo, hi, n - i);
+}
+
+AVX2 static void i64_clamp_avx2(long long* dst, const long long* a, long long lo, long long hi, size_t n) {
+    const __m256i vlo = _mm256_set1_epi64x(lo);
+    const __m256i vhi = _mm256_set1_epi64x(hi);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        x = _mm256_blendv_epi8(x, vlo, _mm256_cmpgt_epi64(vlo, x));
+        x = _mm256_blendv_epi8(x, vhi, _mm256_cmpgt_epi64(x, vhi));
+        _mm256_storeu_si256((__m256i*)(dst + i), x);
+    }
+    i64_clamp_scalar(dst + i, a + i, lo, hi, n - i);
+}
+
+// Spills the four accumulators in lane order and finishes like the
+// scalar version.
+AVX2 static double lanes_store(__m256d s0, __m256d s1, __m256d s2, __m256d s3) {
+    double acc[LANES];
+    _mm256_storeu_pd(acc, s0);
+    _mm256_storeu_pd(acc + 4, s1);
+    _mm256_storeu_pd(acc + 8, s2);
+    _mm256_storeu_pd(acc + 12, s3);
+    return lanes_combine(acc);
+}
+
+AVX2 static double f64_sum_avx2(const double* a, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        s0 = _mm256_add_pd(s0, _mm256_loadu_pd(a + i));
+        s1 = _mm256_add_pd(s1, _mm256_loadu_pd(a + i + 4));
+        s2 = _mm256_add_pd(s2, _mm256_loadu_pd(a + i + 8));
+        s3 = _mm256_add_pd(s3, _mm256_loadu_pd(a + i + 12));
+    }
+    double s = lanes_store(s0, s1, s2, s3);
+    for (; i < n; i++) s += a[i];
+    return s;
+}
+
+// Multiply then add (not fused) so the sum matches the scalar version.
+#define DOT_STEP(s, k) \
+    s = _mm256_add_pd(s, _mm256_mul_pd(_mm256_loadu_pd(a + i + k), _mm256_loadu_pd(b + i + k)))
+
+AVX2 static double f64_dot_avx2(const double* a, const double* b, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        DOT_STEP(s0, 0);
+        DOT_STEP(s1, 4);
+        DOT_STEP(s2, 8);
+        DOT_STEP(s3, 12);
+    }
+    double s = lanes_store(s0, s1, s2, s3);
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+#define SQ_DEV_STEP(s, k)                                                       \
+    do {                                                                        \
+        __m256d d = _mm256_sub_pd(_mm256_loadu_pd(a + i + k), vmean);           \
+        s = _mm256_add_pd(s, _mm256_mul_pd(d, d));                              \
+    } while (0)
+
+AVX2 static double f64_sq_dev_avx2(const double* a, double mean, size_t n) {
+    const __m256d vmean = _mm256_set1_pd(mean);
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        SQ_DEV_STEP(s0, 0);
+        SQ_DEV_STEP(s1, 4);
+        SQ_DEV_STEP(s2, 8);
+        SQ_DEV_STEP(s3, 12);
+    }
+    double s = lanes_store(s0, s1, s2, s3);
+    for (; i < n; i++) {
+        double d = a[i] - mean;
+        s += d * d;
+    }
+    return s;
+}
+
+AVX2 static double f64_min_avx2(const double* a, size_t n) {
+    if (n < 4) return f64_min_scalar(a, n);
+    __m256d m = _mm256_loadu_pd(a);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) m = _mm256_min_pd(_mm256_loadu_pd(a + i), m);
+    double lanes[4];
+    _mm256_storeu_pd(lanes, m);
+    double r = f64_min_scalar(lanes, 4);
+    return i < n ? fmin(r, f64_min_scalar(a + i, n - i)) : r;
+}
+
+AVX2 static double f64_max_avx2(const double* a, size_t n) {
+    if (n < 4) return f64_max_scalar(a, n);
+    __m256d m = _mm256_loadu_pd(a);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) m = _mm256_max_pd(_mm256_loadu_pd(a + i), m);
+    double lanes[4];
+    _mm256_storeu_pd(lanes, m);
+    double r = f64_max_scalar(lanes, 4);
+    return i < n ? fmax(r, f64_max_scalar(a + i, n - i)) : r;
+}
+
+AVX2 static long long i64_sum_avx2(const long long* a, size_t n) {
+    __m256i s0 = _mm256_setzero_si256(), s1 = s0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_add_epi64(s0, _mm256_loadu_si256((const __m256i*)(a + i)));
+        s1 = _mm256_add_epi64(s1, _mm256_loadu_si256((const __m256i*)(a + i + 4)));
+    }
+    long long lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(s0, s1));
+    return wrap_add(i64_sum_scalar(lanes, 4), i64_sum_scalar(a + i, n - i));
+}
+
+AVX2 static long long i64_min_avx2(const long long* a, size_t n) {
+    if (n < 4) return i64_min_scalar(a, n);
+    __m256i m = _mm256_loadu_si256((const __m256i*)a);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        m = _mm256_blendv_epi8(m, x, _mm256_cmpgt_epi64(m, x));
+    }
+    long long lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, m);
+    long long r = i64_min_scalar(lanes, 4);
+    if (i < n) {
+        long long t = i64_min_scalar(a + i, n - i);
+        if (t < r) r = t;
+    }
+    return r;
+}
+
+AVX2 static long long i64_max_avx2(const long long* a, size_t n) {
+    if (n < 4) return i64_max_scalar(a, n);
+    __m256i m = _mm256_loadu_si256((const __m256i*)a);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        m = _mm256_blendv_epi8(m, x, _mm256_cmpgt_epi64(x, m));
+    }
+    long long lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, m);
+    long long r = i64_max_scalar(lanes, 4);
+    if (i < n) {
+        long long t = i64_max_scalar(a + i, n - i);
+        if (t > r) r = t;
+    }
+    return r;
+}
+
+// In-register scan: add the vector shifted up one lane, then two lanes,
+// then the last total broadcast from the previous block.
+AVX2 static void f64_cumsum_avx2(double* dst, const double* a, size_t n) {
+    const __m256d zero = _mm256_setzero_pd();
+    __m256d carry = zero;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d x = _mm256_loadu_pd(a + i);
+        x = _mm256_add_pd(x, _mm256_blend_pd(_mm256_permute4x64_pd(x, 0x90), zero, 0x1));
+        x = _mm256_add_pd(x, _mm256_blend_pd(_mm256_permute4x64_pd(x, 0x40), zero, 0x3));
+        x = _mm256_add_pd(x, carry);
+        _mm256_storeu_pd(dst + i, x);
+        carry = _mm256_permute4x64_pd(x, 0xFF);
+    }
+    f64_cumsum_tail(dst + i, a + i, n - i, i > 0 ? dst[i - 1] : 0.0);
+}
+
+AVX2 static void i64_cumsum_avx2(long long* dst, const long long* a, size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i carry = zero;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x90), zero, 0x03));
+        x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, 0x40), zero, 0x0F));
+        x = _mm256_add_epi64(x, carry);
+        _mm256_storeu_si256((__m256i*)(dst + i), x);
+        carry = _mm256_permute4x64_epi64(x, 0xFF);
+    }
+    i64_cumsum_tail(dst + i, a + i, n - i, i > 0 ? dst[i - 1] : 0);
+}
+
+#endif // NUMVEC_X86
+
+void numvec_init(void) {
+#ifdef NUMVEC_X86
+    __builtin_cpu_init();
+    if (textscan_level() == TEXTSCAN_AVX2 && __builtin_cpu_supports("fma")) {
+        kernels = (NumKernels){ f64_arith_avx2, i64_arith_avx2, f64_fma_avx2, f64_compare_avx2,
+                                i64_compare_avx2, where_avx2, f64_clamp_avx2, i64_clamp_avx2,
+                                f64_sum_avx2, f64_dot_avx2, f64_sq_dev_avx2, f64_min_avx2,
+                                f64_max_avx2, i64_sum_avx2, i64_min_avx2, i64_max_avx2,
+                                f64_cumsum_avx2, i64_cumsum_avx2 };
+        use_avx2 = true;
+    }
+#endif
+}
+
+bool numvec_avx2(void) {
+    return use_avx2;
+}
+
+void numvec_f64_arith(NumVecOp op, double* dst, const double* a, const double* b, size_t b_step, size_t n) {
+    kernels.f64_arith(op, dst, a, b, b_step, n);
+}
+
+void numvec_i64_arith(NumVecOp op, long long* dst, const long long* a, const long long* b, size_t b_step,
+                      size_t n) {
+    kernels.i64_arith(op, dst, a, b, b_step, n);
+}
+
+void numvec_f64_fma(double* dst, const double* a, const double* b, size_t b_step, const double* c,
+                    size_t c_step, size_t n) {
+    kernels.f64_fma(dst, a, b, b_step, c, c_step, n);
+}
+
+void numvec_f64_compare(NumVecCmp cmp, long long* mask, const double* a, const double* b, size_t b_step,
+                        size_t n) {
+    kernels.f64_compare(cmp, mask, a, b, b_step, n);
+}
+
+void numvec_i64_compare(NumVecCmp cmp, long long* mask, const long long* a, const long long* b, size_t b_step,
+                        size_t n) {
+    kernels.i64_compare(cmp, mask, a, b, b_step, n);
+}
+
+void numvec_where(void* dst, const long long* mask, const void* x, size_t x_step, const void* y, size_t y_step,
+                  size_t n) {
+    kernels.where(dst, mask, x, x_step, y, y_step, n);
+}
+
+void numvec_f64_clamp(double* dst, const double* a, double lo, double hi, size_t n) {
+    kernels.f64_clamp(dst, a, lo, hi, n);
+}
+
+void numvec_i64_clamp(long long* dst, const long long* a, long long lo, long long hi, size_t n) {
+    kernels.i64_clamp(dst, a, lo, hi, n);
+}
+
+double numvec_f64_sum(const double* a, size_t n) {
+    return kernels.f64_sum(a, n);
+}
+
+double numvec_f64_dot(const double* a, const double* b, size_t n) {
+    return kernels.f64_dot(a, b, n);
+}
+
+double numvec_f64_min(const double* a, size_t n) {
+    return kernels.f64_min(a, n);
+}
+
+double numvec_f64_max(const double* a, size_t n) {
+    return kernels.f64_max(a, n);
+}
+
+long long numvec_i64_sum(const long long* a, size_t n) {
+    return kernels.i64_sum(a, n);
+}
+
+// No 64-bit vector multiply below AVX-512; a plain loop it is.
+long long numvec_i64_dot(const long long* a, const long long* b, size_t n) {
+    long long s = 0;
+    for (size_t i = 0; i < n; i++) s = wrap_add(s, wrap_mul(a[i], b[i]));
+    return s;
+}
+
+long long numvec_i64_min(const long long* a, size_t n) {
+    return kernels.i64_min(a, n);
+}
+
+long long numvec_i64_max(const long long* a, size_t n) {
+    return kernels.i64_max(a, n);
+}
+
+double numvec_f64_sq_dev(const double* a, double mean, size_t n) {
+    return kernels.f64_sq_dev(a, mean, n);
+}
+
+void numvec_f64_cumsum(double* dst, const double* a, size_t n) {
+    kernels.f64_cumsum(dst, a, n);
+}
+
+void numvec_i64_cumsum(long long* dst, const long long* a, size_t n) {
+    kernels.i64_cumsum(dst, a, n);
+}
+
+void numvec_i64_to_f64(double* dst, const long long* a, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = (double)a[i];
+}
+
+// Saturates out-of-range values and maps NaN to 0 instead of leaving the
+// conversion undefined.
+void numvec_f64_to_i64(long long* dst, const double* a, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        double x = a[i];
+        if (x != x) dst[i] = 0;
+        else if (x >= 9223372036854775807.0) dst[i] = INT64_MAX;
+        else if (x <= -9223372036854775808.0) dst[i] = INT64_MIN;
+        else dst[i] = (long long)x;
+    }
+}
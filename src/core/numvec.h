@@ -0,0 +1,85 @@
+#ifndef RADS_NUMVEC_H
+#define RADS_NUMVEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Number kernels behind the f64array.* and i64array.* natives.
+//
+// Each operation has a scalar version and, on x86-64 with AVX2 and FMA,
+// one working on four 64-bit lanes at a time. numvec_init picks AVX2 when
+// textscan did (so RADS_SIMD=scalar turns it off too) and the CPU has FMA.
+//
+// Binary operations take a b_step of 1 for an array operand or 0 for a
+// single value broadcast to every element. dst may equal an operand.
+// Both versions give bit-identical results: sums and dot products add in
+// sixteen interleaved lanes combined in a fixed order, and prefix sums
+// scan blocks of four the same way, so they can differ in the last bits
+// from a left-to-right loop but never between machines.
+
+typedef enum {
+    NUMVEC_ADD,
+    NUMVEC_SUB,
+    NUMVEC_MUL,
+    NUMVEC_DIV
+} NumVecOp;
+
+typedef enum {
+    NUMVEC_LT,
+    NUMVEC_LE,
+    NUMVEC_GT,
+    NUMVEC_GE,
+    NUMVEC_EQ,
+    NUMVEC_NE
+} NumVecCmp;
+
+// Selects the kernels. Call once, after textscan_init and before other
+// threads use them; until then the scalar versions are used.
+void numvec_init(void);
+bool numvec_avx2(void);
+
+// dst = a op b. Integer division is not supported (NUMVEC_DIV is f64 only).
+void numvec_f64_arith(NumVecOp op, double* dst, const double* a, const double* b, size_t b_step, size_t n);
+void numvec_i64_arith(NumVecOp op, long long* dst, const long long* a, const long long* b, size_t b_step,
+                      size_t n);
+
+// dst = a * b + c with a single rounding.
+void numvec_f64_fma(double* dst, const double* a, const double* b, size_t b_step, const double* c,
+                    size_t c_step, size_t n);
+
+// mask[i] = 1 when a[i] cmp b[i] holds, else 0.
+void numvec_f64_compare(NumVecCmp cmp, long long* mask, const double* a, const double* b, size_t b_step,
+                        size_t n);
+void numvec_i64_compare(NumVecCmp cmp, long long* mask, const long long* a, const long long* b, size_t b_step,
+                        size_t n);
+
+// dst[i] = mask[i] ? x[i] : y[i] for 64-bit elements of either kind.
+void numvec_where(void* dst, const long long* mask, const void* x, size_t x_step, const void* y, size_t y_step,
+                  size_t n);
+
+// dst = min(max(a, lo), hi)
+void numvec_f64_clamp(double* dst, const double* a, double lo, double hi, size_t n);
+void numvec_i64_clamp(long long* dst, const long long* a, long long lo, long long hi, size_t n);
+
+// Reductions. min and max need n > 0; integer sums wrap on overflow.
+double numvec_f64_sum(const double* a, size_t n);
+double numvec_f64_dot(const double* a, const double* b, size_t n);
+double numvec_f64_min(const double* a, size_t n);
+double numvec_f64_max(const double* a, size_t n);
+long long numvec_i64_sum(const long long* a, size_t n);
+long long numvec_i64_dot(const long long* a, const long long* b, size_t n);
+long long numvec_i64_min(const long long* a, size_t n);
+long long numvec_i64_max(const long long* a, size_t n);
+
+// Sum of (a[i] - mean)^2, the numerator of the variance.
+double numvec_f64_sq_dev(const double* a, double mean, size_t n);
+
+// Inclusive prefix sums; dst may equal a.
+void numvec_f64_cumsum(double* dst, const double* a, size_t n);
+void numvec_i64_cumsum(long long* dst, const long long* a, size_t n);
+
+// Conversions between the two kinds (f64 to i64 truncates).
+void numvec_i64_to_f64(double* dst, const long long* a, size_t n);
+void numvec_f64_to_i64(long long* dst, const double* a, size_t n);
+
+#endif // RADS_NUMVEC_H
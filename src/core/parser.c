@@ -387,7 +387,7 @@ static ASTNode* parse_call(Parser* parser) {
     return expr;
 }
 
-// Parse unary operators (!, -, typeof)
+// Parse unary operators (!, -, typeof, await)
 static ASTNode* parse_unary(Parser* parser) {
     if (match(parser, TOKEN_BANG) || match(parser, TOKEN_MINUS)) {
         Token op = parser->previous;
@@ -405,6 +405,23 @@ static ASTNode* parse_unary(Parser* parser) {
         return ast_create_typeof(operand, line, column);
     }
 
+    if (match(parser, TOKEN_AWAIT)) {
+        int line = parser->previous.line;
+        int column = parser->previous.column;
+        ASTNode* operand = parse_unary(parser);
+        return ast_create_await(operand, line, column);
+    }
+
+    if (match(parser, TOKEN_SPAWN)) {
+        int line = parser->previous.line;
+        int column = parser->previous.column;
+        ASTNode* call = parse_call(parser);
+        if (call && call->type != AST_CALL_EXPR) {
+            error(parser, "Expected a function call after 'spawn'");
+        }
+        return ast_create_spawn(call, line, column);
+    }
+
     return parse_call(parser);
 }
 
@@ -554,13 +571,13 @@ static ASTNode* parse_return_statement(Parser* parser) {
 }
 
 // Parse await statement: await <expr>;
+// Suspends the current task until the awaited task or handle completes.
 static ASTNode* parse_await_statement(Parser* parser) {
-    (void)parser->previous; // unused for now
+    int line = parser->previous.line;
+    int column = parser->previous.column;
     ASTNode* value = parse_expression(parser);
     consume(parser, TOKEN_SEMICOLON, "Expected ';' after await expression");
-    // For now, await is a no-op; just evaluate the expression.
-    // In the future, we can add async/await semantics.
-    return value;
+    return ast_create_await(value, line, column);
 }
 
 // Parse loop statement: loop (<condition>) <statement>
@@ -0,0 +1,478 @@
+#include "textscan.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TEXTSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+typedef struct TextKernels {
+    const char* (*find)(const char* hay, size_t hay_len, const char* needle, size_t needle_len);
+    void (*map_case)(char* dst, const char* src, size_t len, char first);
+    size_t (*skip_space)(const char* s, size_t len);
+    size_t (*trim_end)(const char* s, size_t len);
+    bool (*utf8_valid)(const char* s, size_t len);
+    size_t (*utf8_count)(const char* s, size_t len);
+} TextKernels;
+
+// ============================================================================
+// Scalar
+// ============================================================================
+
+static bool is_space(unsigned char c) {
+    return c == ' ' || (unsigned char)(c - '\t') < 5;
+}
+
+static const char* find_scalar(const char* hay, size_t hay_len, const char* needle, size_t needle_len) {
+    if (needle_len == 0) return hay;
+    if (needle_len == 1) return memchr(hay, needle[0], hay_len);
+    return memmem(hay, hay_len, needle, needle_len);
+}
+
+// Flips the case of the 26 letters starting at first ('a' or 'A').
+static void map_case_scalar(char* dst, const char* src, size_t len, char first) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)src[i];
+        dst[i] = (char)((unsigned char)(c - first) < 26 ? c ^ 0x20 : c);
+    }
+}
+
+static size_t skip_space_scalar(const char* s, size_t len) {
+    size_t i = 0;
+    while (i < len && is_space((unsigned char)s[i])) i++;
+    return i;
+}
+
+static size_t trim_end_scalar(const char* s, size_t len) {
+    while (len > 0 && is_space((unsigned char)s[len - 1])) len--;
+    return len;
+}
+
+static bool utf8_valid_scalar(const char* str, size_t len) {
+    const unsigned char* s = (const unsigned char*)str;
+    size_t i = 0;
+    while (i < len) {
+        unsigned char c = s[i];
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+        size_t extra;
+        unsigned char lo = 0x80, hi = 0xBF;    // allowed range of the second byte
+        if (c >= 0xC2 && c <= 0xDF) {
+            extra = 1;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            extra = 2;
+            if (c == 0xE0) lo = 0xA0;          // overlong
+            if (c == 0xED) hi = 0x9F;          // surrogates
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            extra = 3;
+            if (c == 0xF0) lo = 0x90;          // overlong
+            if (c == 0xF4) hi = 0x8F;          // past U+10FFFF
+        } else {
+            return false;
+        }
+        if (len - i - 1 < extra || s[i + 1] < lo || s[i + 1] > hi) return false;
+        for (size_t k = 2; k <= extra; k++) {
+            if ((s[i + k] & 0xC0) != 0x80) return false;
+        }
+        i += extra + 1;
+    }
+    return true;
+}
+
+// Code points are the bytes that are not continuation bytes (10xxxxxx).
+static size_t utf8_count_scalar(const char* s, size_t len) {
+    size_t count = 0;
+    for (size_t i = 0; i < len; i++) {
+        count += (signed char)s[i] > -65;
+    }
+    return count;
+}
+
+static TextKernels kernels = {
+    find_scalar, map_case_scalar, skip_space_scalar, trim_end_scalar, utf8_valid_scalar, utf8_count_scalar,
+};
+static TextScanLevel current_level = TEXTSCAN_SCALAR;
+
+#ifdef TEXTSCAN_X86
+
+// ============================================================================
+// UTF-8 validation tables
+// ============================================================================
+//
+// Validation follows Keiser and Lemire, "Validating UTF-8 In Less Than One
+// Instruction Per Byte": three 16-entry lookups, on the high and low
+// nibble of the previous byte and the high nibble of the current one, each
+// give the set of errors that byte pair could be part of. Their AND is
+// non-zero exactly for invalid pairs, except that two continuation bytes
+// in a row are fine where a 3 or 4-byte sequence needs them.
+
+#define U8_TOO_SHORT  0x01    // lead byte or ASCII followed by a lead byte
+#define U8_TOO_LONG   0x02    // ASCII followed by a continuation
+#define U8_OVERLONG_3 0x04
+#define U8_TOO_LARGE  0x08
+#define U8_SURROGATE  0x10
+#define U8_OVERLONG_2 0x20
+#define U8_TOO_LARGE_1000 0x40
+#define U8_OVERLONG_4 0x40
+#define U8_TWO_CONTS  0x80    // continuation followed by a continuation
+#define U8_CARRY (U8_TOO_SHORT | U8_TOO_LONG | U8_TWO_CONTS)
+
+static const uint8_t u8_byte1_high[16] = {
+    U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG,
+    U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG, U8_TOO_LONG,
+    U8_TWO_CONTS, U8_TWO_CONTS, U8_TWO_CONTS, U8_TWO_CONTS,
+    U8_TOO_SHORT | U8_OVERLONG_2,
+    U8_TOO_SHORT,
+    U8_TOO_SHORT | U8_OVERLONG_3 | U8_SURROGATE,
+    U8_TOO_SHORT | U8_TOO_LARGE | U8_TOO_LARGE_1000 | U8_OVERLONG_4,
+};
+
+static const uint8_t u8_byte1_low[16] = {
+    U8_CARRY | U8_OVERLONG_3 | U8_OVERLONG_2 | U8_OVERLONG_4,
+    U8_CARRY | U8_OVERLONG_2,
+    U8_CARRY,
+    U8_CARRY,
+    U8_CARRY | U8_TOO_LARGE,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000 | U8_SURROGATE,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+    U8_CARRY | U8_TOO_LARGE | U8_TOO_LARGE_1000,
+};
+
+static const uint8_t u8_byte2_high[16] = {
+    U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,
+    U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,
+    U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_OVERLONG_3 | U8_TOO_LARGE_1000 | U8_OVERLONG_4,
+    U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_OVERLONG_3 | U8_TOO_LARGE,
+    U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_SURROGATE | U8_TOO_LARGE,
+    U8_TOO_LONG | U8_OVERLONG_2 | U8_TWO_CONTS | U8_SURROGATE | U8_TOO_LARGE,
+    U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT, U8_TOO_SHORT,
+};
+
+// A block whose last bytes start a sequence longer than what is left of it
+// must be followed by continuations: byte - limit is non-zero there.
+static const uint8_t u8_incomplete_limit[32] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xEF, 0xDF, 0xBF,
+};
+
+// ============================================================================
+// SSE4.2 (16 bytes)
+// ============================================================================
+
+#define SSE42 __attribute__((target("sse4.2")))
+
+SSE42 static const char* find_sse42(const char* hay, size_t hay_len, const char* needle, size_t needle_len) {
+    if (needle_len <= 1 || hay_len < needle_len) return find_scalar(hay, hay_len, needle, needle_len);
+    // Compare the first and last needle bytes at 16 positions at once and
+    // only memcmp where both match.
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[needle_len - 1]);
+    size_t i = 0;
+    for (; i + needle_len - 1 + 16 <= hay_len; i += 16) {
+        __m128i block_first = _mm_loadu_si128((const __m128i*)(hay + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i*)(hay + i + needle_len - 1));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, needle_len - 2) == 0) return hay + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return find_scalar(hay + i, hay_len - i, needle, needle_len);
+}
+
+SSE42 static void map_case_sse42(char* dst, const char* src, size_t len, char first) {
+    // Adding 0x80 - first moves the 26 letters to -128..-103 (signed).
+    const __m128i shift = _mm_set1_epi8((char)(0x80 - first));
+    const __m128i limit = _mm_set1_epi8(-128 + 26);
+    const __m128i flip = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i letters = _mm_cmpgt_epi8(limit, _mm_add_epi8(x, shift));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(x, _mm_and_si128(letters, flip)));
+    }
+    map_case_scalar(dst + i, src + i, len - i, first);
+}
+
+SSE42 static unsigned space_mask_sse42(__m128i x) {
+    __m128i t = _mm_sub_epi8(x, _mm_set1_epi8('\t'));
+    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(4)), t);
+    __m128i space = _mm_cmpeq_epi8(x, _mm_set1_epi8(' '));
+    return (unsigned)_mm_movemask_epi8(_mm_or_si128(control, space));
+}
+
+SSE42 static size_t skip_space_sse42(const char* s, size_t len) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        unsigned other = ~space_mask_sse42(_mm_loadu_si128((const __m128i*)(s + i))) & 0xFFFF;
+        if (other) return i + (unsigned)__builtin_ctz(other);
+    }
+    return i + skip_space_scalar(s + i, len - i);
+}
+
+SSE42 static size_t trim_end_sse42(const char* s, size_t len) {
+    for (; len >= 16; len -= 16) {
+        unsigned other = ~space_mask_sse42(_mm_loadu_si128((const __m128i*)(s + len - 16))) & 0xFFFF;
+        if (other) return len - 16 + (31 - (unsigned)__builtin_clz(other)) + 1;
+    }
+    return trim_end_scalar(s, len);
+}
+
+SSE42 static __m128i utf8_errors_sse42(__m128i input, __m128i prev_input) {
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+    __m128i byte1_high = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)u8_byte1_high),
+                                          _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+    __m128i byte1_low = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)u8_byte1_low),
+                                         _mm_and_si128(prev1, low_nibble));
+    __m128i byte2_high = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)u8_byte2_high),
+                                          _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+    __m128i special = _mm_and_si128(_mm_and_si128(byte1_high, byte1_low), byte2_high);
+    __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+    __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+    __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+    __m128i must_continue = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must_continue, special);
+}
+
+SSE42 static bool utf8_valid_sse42(const char* s, size_t len) {
+    const __m128i limit = _mm_loadu_si128((const __m128i*)(u8_incomplete_limit + 16));
+    __m128i prev = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    char tail[16];
+    for (size_t i = 0; i < len; i += 16) {
+        __m128i input;
+        if (i + 16 <= len) {
+            input = _mm_loadu_si128((const __m128i*)(s + i));
+        } else {
+            // Zero padding is ASCII, so a sequence cut off by the end fails.
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, len - i);
+            input = _mm_loadu_si128((const __m128i*)tail);
+        }
+        if (_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, incomplete);
+        } else {
+            error = _mm_or_si128(error, utf8_errors_sse42(input, prev));
+        }
+        incomplete = _mm_subs_epu8(input, limit);
+        prev = input;
+    }
+    error = _mm_or_si128(error, incomplete);
+    return _mm_testz_si128(error, error);
+}
+
+SSE42 static size_t utf8_count_sse42(const char* s, size_t len) {
+    const __m128i lead_min = _mm_set1_epi8(-65);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(s + i));
+        count += (size_t)__builtin_popcount((unsigned)_mm_movemask_epi8(_mm_cmpgt_epi8(x, lead_min)));
+    }
+    return count + utf8_count_scalar(s + i, len - i);
+}
+
+// ============================================================================
+// AVX2 (32 bytes)
+// ============================================================================
+
+#define AVX2 __attribute__((target("avx2")))
+
+// The 32 bytes ending n bytes before input's first byte.
+#define AVX2_PREV(input, prev, n) \
+    _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - (n))
+
+AVX2 static const char* find_avx2(const char* hay, size_t hay_len, const char* needle, size_t needle_len) {
+    if (needle_len <= 1 || hay_len < needle_len) return find_scalar(hay, hay_len, needle, needle_len);
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[needle_len - 1]);
+    size_t i = 0;
+    for (; i + needle_len - 1 + 32 <= hay_len; i += 32) {
+        __m256i block_first = _mm256_loadu_si256((const __m256i*)(hay + i));
+        __m256i block_last = _mm256_loadu_si256((const __m256i*)(hay + i + needle_len - 1));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last)));
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, needle_len - 2) == 0) return hay + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return find_sse42(hay + i, hay_len - i, needle, needle_len);
+}
+
+AVX2 static void map_case_avx2(char* dst, const char* src, size_t len, char first) {
+    const __m256i shift = _mm256_set1_epi8((char)(0x80 - first));
+    const __m256i limit = _mm256_set1_epi8(-128 + 26);
+    const __m256i flip = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i letters = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(x, shift));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(x, _mm256_and_si256(letters, flip)));
+    }
+    map_case_scalar(dst + i, src + i, len - i, first);
+}
+
+AVX2 static uint32_t space_mask_avx2(__m256i x) {
+    __m256i t = _mm256_sub_epi8(x, _mm256_set1_epi8('\t'));
+    __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(4)), t);
+    __m256i space = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' '));
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(control, space));
+}
+
+AVX2 static size_t skip_space_avx2(const char* s, size_t len) {
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        uint32_t other = ~space_mask_avx2(_mm256_loadu_si256((const __m256i*)(s + i)));
+        if (other) return i + (unsigned)__builtin_ctz(other);
+    }
+    return i + skip_space_scalar(s + i, len - i);
+}
+
+AVX2 static size_t trim_end_avx2(const char* s, size_t len) {
+    for (; len >= 32; len -= 32) {
+        uint32_t other = ~space_mask_avx2(_mm256_loadu_si256((const __m256i*)(s + len - 32)));
+        if (other) return len - 32 + (31 - (unsigned)__builtin_clz(other)) + 1;
+    }
+    return trim_end_scalar(s, len);
+}
+
+AVX2 static __m256i utf8_errors_avx2(__m256i input, __m256i prev_input) {
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    const __m256i table1_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)u8_byte1_high));
+    const __m256i table1_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)u8_byte1_low));
+    const __m256i table2_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)u8_byte2_high));
+    __m256i prev1 = AVX2_PREV(input, prev_input, 1);
+    __m256i byte1_high = _mm256_shuffle_epi8(table1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+    __m256i byte1_low = _mm256_shuffle_epi8(table1_low, _mm256_and_si256(prev1, low_nibble));
+    __m256i byte2_high = _mm256_shuffle_epi8(table2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte1_high, byte1_low), byte2_high);
+    __m256i prev2 = AVX2_PREV(input, prev_input, 2);
+    __m256i prev3 = AVX2_PREV(input, prev_input, 3);
+    __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must_continue, special);
+}
+
+AVX2 static bool utf8_valid_avx2(const char* s, size_t len) {
+    const __m256i limit = _mm256_loadu_si256((const __m256i*)u8_incomplete_limit);
+    __m256i prev = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    char tail[32];
+    for (size_t i = 0; i < len; i += 32) {
+        __m256i input;
+        if (i + 32 <= len) {
+            input = _mm256_loadu_si256((const __m256i*)(s + i));
+        } else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, len - i);
+            input = _mm256_loadu_si256((const __m256i*)tail);
+        }
+        if (_mm256_movemask_epi8(input) == 0) {
+            error = _mm256_or_si256(error, incomplete);
+        } else {
+            error = _mm256_or_si256(error, utf8_errors_avx2(input, prev));
+        }
+        incomplete = _mm256_subs_epu8(input, limit);
+        prev = input;
+    }
+    error = _mm256_or_si256(error, incomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+AVX2 static size_t utf8_count_avx2(const char* s, size_t len) {
+    const __m256i lead_min = _mm256_set1_epi8(-65);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(s + i));
+        count += (size_t)__builtin_popcount((uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(x, lead_min)));
+    }
+    return count + utf8_count_scalar(s + i, len - i);
+}
+
+#endif // TEXTSCAN_X86
+
+void textscan_init(void) {
+    TextScanLevel level = TEXTSCAN_SCALAR;
+#ifdef TEXTSCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) level = TEXTSCAN_AVX2;
+    else if (__builtin_cpu_supports("sse4.2")) level = TEXTSCAN_SSE42;
+#endif
+    const char* cap = getenv("RADS_SIMD");
+    if (cap) {
+        if (strcmp(cap, "scalar") == 0) level = TEXTSCAN_SCALAR;
+        else if (strcmp(cap, "sse4.2") == 0 && level > TEXTSCAN_SSE42) level = TEXTSCAN_SSE42;
+    }
+#ifdef TEXTSCAN_X86
+    if (level == TEXTSCAN_AVX2) {
+        kernels = (TextKernels){ find_avx2, map_case_avx2, skip_space_avx2, trim_end_avx2, utf8_valid_avx2,
+                                 utf8_count_avx2 };
+    } else if (level == TEXTSCAN_SSE42) {
+        kernels = (TextKernels){ find_sse42, map_case_sse42, skip_space_sse42, trim_end_sse42, utf8_valid_sse42,
+                                 utf8_count_sse42 };
+    }
+#endif
+    current_level = level;
+}
+
+TextScanLevel textscan_level(void) {
+    return current_level;
+}
+
+const char* textscan_level_name(void) {
+    switch (current_level) {
+        case TEXTSCAN_AVX2: return "avx2";
+        case TEXTSCAN_SSE42: return "sse4.2";
+        default: return "scalar";
+    }
+}
+
+const char* text_find(const char* hay, size_t hay_len, const char* needle, size_t needle_len) {
+    return kernels.find(hay, hay_len, needle, needle_len);
+}
+
+void text_upper(char* dst, const char* src, size_t len) {
+    kernels.map_case(dst, src, len, 'a');
+}
+
+void text_lower(char* dst, const char* src, size_t len) {
+    kernels.map_case(dst, src, len, 'A');
+}
+
+size_t text_skip_space(const char* s, size_t len) {
+    return kernels.skip_space(s, len);
+}
+
+size_t text_trim_end(const char* s, size_t len) {
+    return kernels.trim_end(s, len);
+}
+
+bool text_utf8_valid(const char* s, size_t len) {
+    return kernels.utf8_valid(s, len);
+}
+
+size_t text_utf8_count(const char* s, size_t len) {
+    return kernels.utf8_count(s, len);
+}
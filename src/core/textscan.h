@@ -0,0 +1,45 @@
+#ifndef RADS_TEXTSCAN_H
+#define RADS_TEXTSCAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Byte-string kernels behind the str.* and string.* natives.
+//
+// Each operation has a scalar version and, on x86-64, SSE4.2 (16 bytes at
+// a time) and AVX2 (32 bytes) versions. textscan_init picks the widest one
+// the CPU supports; RADS_SIMD=scalar|sse4.2|avx2 caps the choice. All
+// functions take explicit lengths and never read past them. Case mapping
+// and whitespace follow the C locale (ASCII only).
+
+typedef enum {
+    TEXTSCAN_SCALAR,
+    TEXTSCAN_SSE42,
+    TEXTSCAN_AVX2
+} TextScanLevel;
+
+// Selects the kernels. Call once before other threads use them; until
+// then the scalar versions are used.
+void textscan_init(void);
+TextScanLevel textscan_level(void);
+const char* textscan_level_name(void);
+
+// First occurrence of needle in hay, or NULL. An empty needle matches at
+// hay.
+const char* text_find(const char* hay, size_t hay_len, const char* needle, size_t needle_len);
+
+// ASCII case mapping of len bytes; dst may equal src.
+void text_upper(char* dst, const char* src, size_t len);
+void text_lower(char* dst, const char* src, size_t len);
+
+// Number of leading whitespace bytes, and the length left once trailing
+// whitespace is dropped.
+size_t text_skip_space(const char* s, size_t len);
+size_t text_trim_end(const char* s, size_t len);
+
+// UTF-8 well-formedness (no overlongs, surrogates or code points past
+// U+10FFFF) and the number of code points in valid UTF-8.
+bool text_utf8_valid(const char* s, size_t len);
+size_t text_utf8_count(const char* s, size_t len);
+
+#endif // RADS_TEXTSCAN_H
@@ -0,0 +1,233 @@
+#include "workpool.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <uv.h>
+
+typedef struct WorkJob {
+    WorkFn fn;
+    void* arg;
+    struct WorkJob* next;    // injection queue link
+} WorkJob;
+
+// Circular job buffer of a deque. Replaced arrays are kept until exit
+// because a thief may still be reading from one.
+typedef struct DequeArray {
+    int64_t size;            // power of two
+    struct DequeArray* retired;
+    _Atomic(WorkJob*) slots[];
+} DequeArray;
+
+// Chase-Lev deque (in the C11 formulation of Le, Pop, Cohen and Zappa
+// Nardelli). Only the owner touches bottom; thieves race on top.
+typedef struct WorkDeque {
+    _Atomic int64_t top;
+    _Atomic int64_t bottom;
+    _Atomic(DequeArray*) array;
+} WorkDeque;
+
+typedef struct Worker {
+    WorkDeque deque;
+    uv_thread_t thread;
+    unsigned int seed;
+} Worker;
+
+#define DEQUE_INITIAL_SIZE 256
+#define STEAL_ATTEMPTS 4
+
+static Worker* workers = NULL;
+static int worker_count = 0;
+static uv_once_t pool_once = UV_ONCE_INIT;
+
+static uv_mutex_t inject_lock;
+static _Atomic(WorkJob*) inject_head = NULL;    // read unlocked as a hint
+static WorkJob* inject_tail = NULL;
+
+// Jobs queued anywhere and not yet taken; idle workers sleep while it is 0.
+static _Atomic long pending = 0;
+static _Atomic int sleepers = 0;
+static uv_mutex_t idle_lock;
+static uv_cond_t idle_cond;
+
+static _Thread_local Worker* self = NULL;
+
+static DequeArray* deque_array_create(int64_t size) {
+    DequeArray* a = calloc(1, sizeof(DequeArray) + (size_t)size * sizeof(_Atomic(WorkJob*)));
+    a->size = size;
+    return a;
+}
+
+static void deque_push(WorkDeque* q, WorkJob* job) {
+    int64_t b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&q->top, memory_order_acquire);
+    DequeArray* a = atomic_load_explicit(&q->array, memory_order_relaxed);
+    if (b - t > a->size - 1) {
+        DequeArray* bigger = deque_array_create(a->size * 2);
+        for (int64_t i = t; i < b; i++) {
+            atomic_store_explicit(&bigger->slots[i & (bigger->size - 1)],
+                                  atomic_load_explicit(&a->slots[i & (a->size - 1)], memory_order_relaxed),
+                                  memory_order_relaxed);
+        }
+        bigger->retired = a;
+        atomic_store_explicit(&q->array, bigger, memory_order_release);
+        a = bigger;
+    }
+    atomic_store_explicit(&a->slots[b & (a->size - 1)], job, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+}
+
+static WorkJob* deque_take(WorkDeque* q) {
+    int64_t b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+    DequeArray* a = atomic_load_explicit(&q->array, memory_order_relaxed);
+    atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&q->top, memory_order_relaxed);
+    if (t > b) {
+        atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    WorkJob* job = atomic_load_explicit(&a->slots[b & (a->size - 1)], memory_order_relaxed);
+    if (t == b) {
+        // Last job: race the thieves for it.
+        if (!atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1, memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            job = NULL;
+        }
+        atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+static WorkJob* deque_steal(WorkDeque* q) {
+    int64_t t = atomic_load_explicit(&q->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+    if (t >= b) return NULL;
+    DequeArray* a = atomic_load_explicit(&q->array, memory_order_acquire);
+    WorkJob* job = atomic_load_explicit(&a->slots[t & (a->size - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return NULL;
+    }
+    return job;
+}
+
+static WorkJob* inject_pop(void) {
+    uv_mutex_lock(&inject_lock);
+    WorkJob* job = atomic_load_explicit(&inject_head, memory_order_relaxed);
+    if (job) {
+        atomic_store_explicit(&inject_head, job->next, memory_order_relaxed);
+        if (!job->next) inject_tail = NULL;
+    }
+    uv_mutex_unlock(&inject_lock);
+    return job;
+}
+
+// Own deque first (most recent work, still in cache), then the shared
+// queue, then other workers' oldest jobs starting from a random victim.
+static WorkJob* find_job(Worker* w) {
+    WorkJob* job = deque_take(&w->deque);
+    if (!job && atomic_load_explicit(&inject_head, memory_order_relaxed)) job = inject_pop();
+    for (int attempt = 0; !job && attempt < STEAL_ATTEMPTS; attempt++) {
+        int start = (int)(rand_r(&w->seed) % (unsigned int)worker_count);
+        for (int i = 0; i < worker_count && !job; i++) {
+            Worker* victim = &workers[(start + i) % worker_count];
+            if (victim != w) job = deque_steal(&victim->deque);
+        }
+    }
+    if (job) atomic_fetch_sub(&pending, 1);
+    return job;
+}
+
+static void run_job(WorkJob* job) {
+    WorkFn fn = job->fn;
+    void* arg = job->arg;
+    free(job);
+    fn(arg);
+}
+
+static void worker_main(void* arg) {
+    Worker* w = arg;
+    self = w;
+    for (;;) {
+        WorkJob* job = find_job(w);
+        if (job) {
+            run_job(job);
+            continue;
+        }
+        uv_mutex_lock(&idle_lock);
+        atomic_fetch_add(&sleepers, 1);
+        while (atomic_load(&pending) == 0) {
+            uv_cond_wait(&idle_cond, &idle_lock);
+        }
+        atomic_fetch_sub(&sleepers, 1);
+        uv_mutex_unlock(&idle_lock);
+    }
+}
+
+static void pool_start(void) {
+    const char* env = getenv("RADS_WORKERS");
+    int count = env ? atoi(env) : (int)uv_available_parallelism();
+    if (count < 1) count = 1;
+    if (count > WORKPOOL_MAX_WORKERS) count = WORKPOOL_MAX_WORKERS;
+    uv_mutex_init(&inject_lock);
+    uv_mutex_init(&idle_lock);
+    uv_cond_init(&idle_cond);
+    workers = calloc((size_t)count, sizeof(Worker));
+    worker_count = count;
+    for (int i = 0; i < count; i++) {
+        atomic_init(&workers[i].deque.array, deque_array_create(DEQUE_INITIAL_SIZE));
+        workers[i].seed = (unsigned int)i * 2654435761u + 1;
+    }
+    for (int i = 0; i < count; i++) {
+        if (uv_thread_create(&workers[i].thread, worker_main, &workers[i]) != 0) {
+            fprintf(stderr, "Error: Could not start pool worker %d\n", i);
+        }
+    }
+}
+
+void workpool_submit(WorkFn fn, void* arg) {
+    uv_once(&pool_once, pool_start);
+    WorkJob* job = malloc(sizeof(WorkJob));
+    job->fn = fn;
+    job->arg = arg;
+    job->next = NULL;
+    atomic_fetch_add(&pending, 1);
+    if (self) {
+        deque_push(&self->deque, job);
+    } else {
+        uv_mutex_lock(&inject_lock);
+        if (inject_tail) inject_tail->next = job;
+        else atomic_store_explicit(&inject_head, job, memory_order_relaxed);
+        inject_tail = job;
+        uv_mutex_unlock(&inject_lock);
+    }
+    if (atomic_load(&sleepers) > 0) {
+        uv_mutex_lock(&idle_lock);
+        uv_cond_signal(&idle_cond);
+        uv_mutex_unlock(&idle_lock);
+    }
+}
+
+void workpool_help_until(bool (*done)(void* arg), void* arg) {
+    while (!done(arg)) {
+        WorkJob* job = self ? find_job(self) : NULL;
+        if (job) {
+            run_job(job);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+bool workpool_on_worker(void) {
+    return self != NULL;
+}
+
+int workpool_size(void) {
+    uv_once(&pool_once, pool_start);
+    return worker_count;
+}
@@ -0,0 +1,31 @@
+#ifndef RADS_WORKPOOL_H
+#define RADS_WORKPOOL_H
+
+#include <stdbool.h>
+
+// Work-stealing thread pool for CPU-bound jobs.
+//
+// Every worker owns a Chase-Lev deque: it pushes and pops jobs at the
+// bottom, while idle workers steal from the top. Jobs submitted from
+// outside the pool go through a shared injection queue. The pool starts
+// on first use with one worker per available CPU (RADS_WORKERS overrides).
+
+#define WORKPOOL_MAX_WORKERS 256
+
+typedef void (*WorkFn)(void* arg);
+
+// Queues fn(arg). From a worker the job goes on that worker's own deque.
+void workpool_submit(WorkFn fn, void* arg);
+
+// Runs queued jobs on the calling worker until done(arg) returns true.
+// Only valid on a pool thread; used to wait for nested work without
+// blocking a worker.
+void workpool_help_until(bool (*done)(void* arg), void* arg);
+
+// True on one of the pool's threads.
+bool workpool_on_worker(void);
+
+// Number of worker threads (starting the pool if needed).
+int workpool_size(void);
+
+#endif // RADS_WORKPOOL_H
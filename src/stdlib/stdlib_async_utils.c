@@ -1,4 +1,6 @@
 #include "../core/interpreter.h"
+#include "../core/workpool.h"
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,15 +21,6 @@ extern void array_push(Array* arr, Value v);
 extern void value_free(Value* value);
 extern Value interpreter_execute_callback(Value func_val, int argc, Value* args);
 
-typedef struct {
-    Value callback;
-    int index;
-    int remaining;
-    Array* results;
-    Value done_callback;
-    struct Interpreter* interp;
-} ParallelContext;
-
 typedef struct {
     Value callback;
     int index;
@@ -56,16 +49,139 @@ typedef struct {
     bool completed;
 } TimeoutContext;
 
-static void parallel_callback(uv_work_t* req, int status) {
-    (void)status;
-    free(req);
+// ----------------------------------------------------------------------------
+// Parallel batches
+// ----------------------------------------------------------------------------
+//
+// parallel, each and parallel_map fan their calls out over the work pool.
+// Inputs are deep-copied up front and each call runs in an isolated
+// interpreter context, so jobs share nothing but read-only function
+// definitions. A batch runs as `lanes` pool jobs that claim indices until
+// none are left, which is how the concurrency limit is enforced. Results
+// land in their own slots; the last job to finish wakes the caller.
+
+typedef struct {
+    InterpreterSnapshot* snapshot;
+    Value func;                  // called for every item, or NULL-typed
+    Array* inputs;               // functions (parallel) or items
+    Array* results;              // NULL when results are discarded
+    size_t count;
+    bool pass_item;              // call func(item, index) instead of item()
+    _Atomic size_t next_index;
+    _Atomic size_t lanes_left;   // the batch is done when every lane has exited
+    bool on_loop;                // caller waits on the loop, not in the pool
+    uv_async_t async;
+    char key[32];
+} ParallelBatch;
+
+static long next_batch_id = 1;
+
+static void parallel_run_one(ParallelBatch* batch, size_t i) {
+    Value item = batch->inputs->items[i];
+    batch->inputs->items[i] = make_null();
+    Value result;
+    if (batch->pass_item) {
+        Value call_args[2] = { item, make_int((long long)i) };
+        result = interpreter_isolated_call(batch->snapshot, batch->func, 2, call_args);
+    } else {
+        result = interpreter_isolated_call(batch->snapshot, item, 0, NULL);
+        value_free(&item);
+    }
+    if (batch->results) batch->results->items[i] = result;
+    else value_free(&result);
 }
 
-static void parallel_work(uv_work_t* req) {
-    (void)req;
+static void parallel_lane(void* arg) {
+    ParallelBatch* batch = arg;
+    bool on_loop = batch->on_loop;
+    for (;;) {
+        size_t i = atomic_fetch_add(&batch->next_index, 1);
+        if (i >= batch->count) break;
+        parallel_run_one(batch, i);
+    }
+    // The caller may free the batch as soon as the last lane is out; only
+    // the async handle (whose close waits for senders) is touched after.
+    if (atomic_fetch_sub(&batch->lanes_left, 1) == 1 && on_loop) {
+        uv_async_send(&batch->async);
+    }
 }
 
+static void parallel_async_cb(uv_async_t* handle) {
+    ParallelBatch* batch = handle->data;
+    interpreter_wake(batch->key);
+}
+
+static bool parallel_finished(void* arg) {
+    ParallelBatch* batch = arg;
+    return atomic_load(&batch->lanes_left) == 0;
+}
+
+static void parallel_batch_free(ParallelBatch* batch) {
+    for (size_t i = 0; i < batch->inputs->count; i++) value_free(&batch->inputs->items[i]);
+    free(batch->inputs->items);
+    free(batch->inputs);
+    interpreter_snapshot_free(batch->snapshot);
+    free(batch);
+}
+
+static void parallel_close_cb(uv_handle_t* handle) {
+    parallel_batch_free(handle->data);
+}
+
+// Runs the batch to completion and returns its results (an array of
+// nulls when they are discarded). Inside an async task only the task
+// waits; on the main path the event loop keeps running meanwhile.
+static Value parallel_run(Value func, Array* items, bool pass_item, bool keep_results, long long limit) {
+    ParallelBatch* batch = calloc(1, sizeof(ParallelBatch));
+    batch->snapshot = interpreter_snapshot();
+    batch->func = func;
+    batch->pass_item = pass_item;
+    batch->count = items->count;
+    batch->inputs = array_create(items->count);
+    for (size_t i = 0; i < items->count; i++) {
+        batch->inputs->items[i] = value_deep_copy(items->items[i]);
+    }
+    batch->inputs->count = items->count;
+    Array* results = array_create(items->count);
+    results->count = items->count;
+    batch->results = keep_results ? results : NULL;
+    atomic_init(&batch->next_index, 0);
+
+    Value out = { .type = VAL_ARRAY, .array_val = results };
+    if (batch->count == 0) {
+        parallel_batch_free(batch);
+        return out;
+    }
+
+    batch->on_loop = !workpool_on_worker();
+    if (batch->on_loop) {
+        snprintf(batch->key, sizeof(batch->key), "parallel_%ld", next_batch_id++);
+        uv_async_init(interpreter_init_event_loop(), &batch->async, parallel_async_cb);
+        batch->async.data = batch;
+    }
+
+    size_t lanes = batch->count;
+    if (limit > 0 && (size_t)limit < lanes) lanes = (size_t)limit;
+    atomic_init(&batch->lanes_left, lanes);
+    for (size_t i = 0; i < lanes; i++) workpool_submit(parallel_lane, batch);
+
+    if (!batch->on_loop) {
+        // Nested batch: keep this worker busy with pool jobs meanwhile.
+        workpool_help_until(parallel_finished, batch);
+        parallel_batch_free(batch);
+        return out;
+    }
+    while (!parallel_finished(batch)) {
+        if (!interpreter_wait(batch->key)) break;
+    }
+    uv_close((uv_handle_t*)&batch->async, parallel_close_cb);
+    return out;
+}
+
+// async_utils.parallel(functions, done): calls every function on the work
+// pool, then done(results); also evaluates to the results.
 Value stdlib_async_parallel(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
     if (argc < 2) {
         fprintf(stderr, "Error: async.parallel() requires 2 arguments (array of functions, done callback)\n");
         return make_null();
@@ -79,25 +195,24 @@ Value stdlib_async_parallel(struct Interpreter* interp, int argc, Value* args) {
         return make_null();
     }
 
-    Array* funcs = funcs_val.array_val;
-    Array* results = array_create(funcs->count);
-    
-    for (size_t i = 0; i < funcs->count; i++) {
-        Value func = funcs->items[i];
-        if (func.type == VAL_FUNCTION) {
-            Value result = interpreter_execute_callback(func, 0, NULL);
-            array_push(results, result);
-        } else {
-            array_push(results, make_null());
-        }
+    Value results = parallel_run(make_null(), funcs_val.array_val, false, true, 0);
+    if (done_callback.type == VAL_FUNCTION) {
+        Value done_result = interpreter_execute_callback(done_callback, 1, &results);
+        value_free(&done_result);
     }
+    return results;
+}
 
-    Value cb_args[1];
-    cb_args[0].type = VAL_ARRAY;
-    cb_args[0].array_val = results;
-    interpreter_execute_callback(done_callback, 1, cb_args);
-
-    return make_null();
+// async_utils.parallel_map(array, fn, [limit]): [fn(item, index), ...]
+// computed on the work pool, at most limit calls at a time.
+Value stdlib_async_parallel_map(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 2 || args[0].type != VAL_ARRAY || args[1].type != VAL_FUNCTION) {
+        fprintf(stderr, "Error: async.parallel_map() requires an array and a function\n");
+        return make_null();
+    }
+    long long limit = (argc > 2 && args[2].type == VAL_INT) ? args[2].int_val : 0;
+    return parallel_run(args[1], args[0].array_val, true, true, limit);
 }
 
 Value stdlib_async_series(struct Interpreter* interp, int argc, Value* args) {
@@ -271,7 +386,51 @@ Value stdlib_async_delay(struct Interpreter* interp, int argc, Value* args) {
     return make_null();
 }
 
+typedef struct {
+    uv_timer_t timer;
+    char key[32];
+    bool fired;
+} SleepContext;
+
+static long next_sleep_id = 1;
+
+static void sleep_timer_cb(uv_timer_t* timer) {
+    SleepContext* ctx = (SleepContext*)timer->data;
+    ctx->fired = true;
+    interpreter_wake(ctx->key);
+}
+
+static void sleep_close_cb(uv_handle_t* handle) {
+    free(handle->data);
+}
+
+// async_utils.sleep(ms): inside an async task only that task pauses;
+// elsewhere the caller waits while the event loop keeps running.
+Value stdlib_async_sleep(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_INT || args[0].int_val < 0) {
+        fprintf(stderr, "Error: async.sleep() requires a non-negative number of milliseconds\n");
+        return make_null();
+    }
+
+    SleepContext* ctx = calloc(1, sizeof(SleepContext));
+    snprintf(ctx->key, sizeof(ctx->key), "sleep_%ld", next_sleep_id++);
+    uv_loop_t* loop = interpreter_init_event_loop();
+    uv_timer_init(loop, &ctx->timer);
+    ctx->timer.data = ctx;
+    uv_timer_start(&ctx->timer, sleep_timer_cb, (uint64_t)args[0].int_val, 0);
+
+    while (!ctx->fired) {
+        if (!interpreter_wait(ctx->key)) break;
+    }
+    uv_close((uv_handle_t*)&ctx->timer, sleep_close_cb);
+    return make_null();
+}
+
+// async_utils.each(array, fn, done, [limit]): calls fn(item, index) for
+// every item on the work pool, at most limit at a time, then done().
 Value stdlib_async_each(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
     if (argc < 3) {
         fprintf(stderr, "Error: async.each() requires 3 arguments (array, iterator function, done callback)\n");
         return make_null();
@@ -291,18 +450,13 @@ Value stdlib_async_each(struct Interpreter* interp, int argc, Value* args) {
         return make_null();
     }
 
-    Array* arr = arr_val.array_val;
-    
-    for (size_t i = 0; i < arr->count; i++) {
-        Value call_args[2] = { 
-            arr->items[i],
-            make_int((long long)i)
-        };
-        interpreter_execute_callback(iterator_fn, 2, call_args);
-    }
+    long long limit = (argc > 3 && args[3].type == VAL_INT) ? args[3].int_val : 0;
+    Value results = parallel_run(iterator_fn, arr_val.array_val, true, false, limit);
+    value_free(&results);
 
     if (done_callback.type == VAL_FUNCTION) {
-        interpreter_execute_callback(done_callback, 0, NULL);
+        Value done_result = interpreter_execute_callback(done_callback, 0, NULL);
+        value_free(&done_result);
     }
 
     return make_null();
@@ -316,5 +470,7 @@ void stdlib_async_utils_register(void) {
     register_native("async_utils.retry", (NativeFn)stdlib_async_retry);
     register_native("async_utils.timeout", (NativeFn)stdlib_async_timeout);
     register_native("async_utils.delay", (NativeFn)stdlib_async_delay);
+    register_native("async_utils.sleep", (NativeFn)stdlib_async_sleep);
     register_native("async_utils.each", (NativeFn)stdlib_async_each);
+    register_native("async_utils.parallel_map", (NativeFn)stdlib_async_parallel_map);
 }
@@ -0,0 +1,408 @@
+#include "stdlib_bytes.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const unsigned char* bytes_data(const Bytes* b) {
+    return b->buf->data + b->offset;
+}
+
+// Buffers with a release hook are not ours to write: io.mmap views map
+// the file read-only.
+static bool bytes_writable(const Bytes* b) {
+    return !b->buf->release;
+}
+
+// Resolves an index or offset argument against length, allowing negative
+// values to count from the end. Returns false when it is not an int.
+static bool bytes_index_arg(const Value* v, size_t length, size_t* out) {
+    if (v->type != VAL_INT) return false;
+    long long i = v->int_val;
+    if (i < 0) i += (long long)length;
+    if (i < 0) i = 0;
+    if ((unsigned long long)i > length) i = (long long)length;
+    *out = (size_t)i;
+    return true;
+}
+
+// Makes room for extra bytes after the end of b, which must end where its
+// buffer's data ends. Grows geometrically so repeated appends stay linear.
+static void bytes_reserve(Bytes* b, size_t extra) {
+    ByteBuffer* buf = b->buf;
+    size_t need = buf->length + extra;
+    if (need <= buf->capacity) return;
+    size_t cap = buf->capacity > 0 ? buf->capacity : 16;
+    while (cap < need) cap *= 2;
+    buf->data = realloc(buf->data, cap);
+    buf->capacity = cap;
+}
+
+// bytes.new([length], [capacity]) -> zeroed bytes
+static Value native_bytes_new(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    long long length = (argc >= 1 && args[0].type == VAL_INT) ? args[0].int_val : 0;
+    long long cap = (argc >= 2 && args[1].type == VAL_INT) ? args[1].int_val : length;
+    if (length < 0) length = 0;
+    if (cap < length) cap = length;
+    ByteBuffer* buf = byte_buffer_create((size_t)cap);
+    memset(buf->data, 0, (size_t)length);
+    buf->length = (size_t)length;
+    Value v = make_bytes_view(buf, 0, buf->length);
+    byte_buffer_release(buf);
+    return v;
+}
+
+// bytes.from(value): a string (taken over without copying), an array of
+// byte values, or bytes (returned as is).
+static Value native_bytes_from(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1) return make_bytes(NULL, 0);
+    if (args[0].type == VAL_STRING) {
+        char* s = args[0].string_val;
+        size_t len = strlen(s);
+        args[0] = make_null();
+        return make_bytes_owned((unsigned char*)s, len, len + 1);
+    }
+    if (args[0].type == VAL_BYTES) {
+        Value v = args[0];
+        args[0] = make_null();
+        return v;
+    }
+    if (args[0].type == VAL_ARRAY) {
+        Array* arr = args[0].array_val;
+        unsigned char* data = malloc(arr->count > 0 ? arr->count : 1);
+        for (size_t i = 0; i < arr->count; i++) {
+            Value* item = &arr->items[i];
+            data[i] = (unsigned char)(item->type == VAL_INT ? item->int_val
+                                      : item->type == VAL_FLOAT ? (long long)item->float_val : 0);
+        }
+        return make_bytes_owned(data, arr->count, arr->count);
+    }
+    fprintf(stderr, "Error: bytes.from() requires a string, array or bytes\n");
+    return make_null();
+}
+
+// bytes.to_string(b): null if b holds a NUL byte. Takes over the storage
+// without copying when nothing else references it.
+static Value native_bytes_to_string(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1) return make_null();
+    if (args[0].type == VAL_STRING) {
+        Value v = args[0];
+        args[0] = make_null();
+        return v;
+    }
+    if (args[0].type != VAL_BYTES) return make_null();
+    Bytes* b = args[0].bytes_val;
+    const unsigned char* data = bytes_data(b);
+    if (memchr(data, '\0', b->length)) return make_null();
+
+    ByteBuffer* buf = b->buf;
+    if (buf->refcount == 1 && !buf->release && b->offset == 0) {
+        if (buf->capacity < b->length + 1) {
+            buf->data = realloc(buf->data, b->length + 1);
+        }
+        char* s = (char*)buf->data;
+        s[b->length] = '\0';
+        buf->data = NULL;
+        buf->length = buf->capacity = 0;
+        b->length = 0;
+        return (Value){ .type = VAL_STRING, .string_val = s };
+    }
+    char* s = malloc(b->length + 1);
+    memcpy(s, data, b->length);
+    s[b->length] = '\0';
+    return (Value){ .type = VAL_STRING, .string_val = s };
+}
+
+static Value native_bytes_len(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    size_t len = 0;
+    if (argc >= 1) value_bytes(&args[0], &len);
+    return make_int((long long)len);
+}
+
+// bytes.slice(b, start, [end]): a view of the same storage.
+static Value native_bytes_slice(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_BYTES) {
+        fprintf(stderr, "Error: bytes.slice() requires bytes\n");
+        return make_null();
+    }
+    Bytes* b = args[0].bytes_val;
+    size_t start = 0, end = b->length;
+    if (argc >= 2) bytes_index_arg(&args[1], b->length, &start);
+    if (argc >= 3) bytes_index_arg(&args[2], b->length, &end);
+    if (end < start) end = start;
+    return make_bytes_view(b->buf, b->offset + start, end - start);
+}
+
+// bytes.copy(b): bytes with storage of their own.
+static Value native_bytes_copy(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    size_t len = 0;
+    const unsigned char* data = argc >= 1 ? value_bytes(&args[0], &len) : NULL;
+    return make_bytes(data, len);
+}
+
+static Value native_bytes_get(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 2 || args[0].type != VAL_BYTES || args[1].type != VAL_INT) return make_null();
+    Bytes* b = args[0].bytes_val;
+    if (args[1].int_val < 0 || (size_t)args[1].int_val >= b->length) return make_null();
+    return make_int(bytes_data(b)[args[1].int_val]);
+}
+
+// bytes.set(b, index, value): writes through to every view of the storage.
+// False for an mmap view.
+static Value native_bytes_set(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 3 || args[0].type != VAL_BYTES || args[1].type != VAL_INT || args[2].type != VAL_INT) {
+        return make_bool(false);
+    }
+    Bytes* b = args[0].bytes_val;
+    if (!bytes_writable(b) || args[1].int_val < 0 || (size_t)args[1].int_val >= b->length) return make_bool(false);
+    b->buf->data[b->offset + (size_t)args[1].int_val] = (unsigned char)args[2].int_val;
+    return make_bool(true);
+}
+
+// bytes.concat(a, b, ...): a followed by the other bytes or strings. When
+// a ends where its storage's data ends, the rest is appended in place and
+// the result shares a's storage, so building a payload by repeated concat
+// costs amortized linear time. Views of a are unaffected either way.
+static Value native_bytes_concat(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1) return make_bytes(NULL, 0);
+    size_t extra = 0;
+    for (int i = 1; i < argc; i++) {
+        size_t len = 0;
+        value_bytes(&args[i], &len);
+        extra += len;
+    }
+
+    Bytes* a = args[0].type == VAL_BYTES ? args[0].bytes_val : NULL;
+    if (a && !a->buf->release && a->offset + a->length == a->buf->length) {
+        bytes_reserve(a, extra);
+        ByteBuffer* buf = a->buf;
+        for (int i = 1; i < argc; i++) {
+            size_t len = 0;
+            const unsigned char* data = value_bytes(&args[i], &len);
+            if (len > 0) memcpy(buf->data + buf->length, data, len);
+            buf->length += len;
+        }
+        return make_bytes_view(buf, a->offset, a->length + extra);
+    }
+
+    size_t first_len = 0;
+    const unsigned char* first = value_bytes(&args[0], &first_len);
+    size_t total = first_len + extra;
+    unsigned char* out = malloc(total > 0 ? total : 1);
+    if (first_len > 0) memcpy(out, first, first_len);
+    size_t pos = first_len;
+    for (int i = 1; i < argc; i++) {
+        size_t len = 0;
+        const unsigned char* data = value_bytes(&args[i], &len);
+        if (len > 0) memcpy(out + pos, data, len);
+        pos += len;
+    }
+    return make_bytes_owned(out, total, total);
+}
+
+// bytes.find(b, needle, [start]) -> offset or -1. needle is bytes, a
+// string or a single byte value.
+static Value native_bytes_find(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 2) return make_int(-1);
+    size_t len = 0;
+    const unsigned char* data = value_bytes(&args[0], &len);
+    if (!data) return make_int(-1);
+    size_t start = 0;
+    if (argc >= 3) bytes_index_arg(&args[2], len, &start);
+
+    unsigned char single;
+    size_t needle_len = 0;
+    const unsigned char* needle = value_bytes(&args[1], &needle_len);
+    if (args[1].type == VAL_INT) {
+        single = (unsigned char)args[1].int_val;
+        needle = &single;
+        needle_len = 1;
+    }
+    if (!needle) return make_int(-1);
+    if (needle_len == 0) return make_int((long long)start);
+    const unsigned char* hit = memmem(data + start, len - start, needle, needle_len);
+    return make_int(hit ? (long long)(hit - data) : -1);
+}
+
+static Value native_bytes_to_hex(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    static const char digits[] = "0123456789abcdef";
+    size_t len = 0;
+    const unsigned char* data = argc >= 1 ? value_bytes(&args[0], &len) : NULL;
+    char* out = malloc(len * 2 + 1);
+    for (size_t i = 0; i < len; i++) {
+        out[2 * i] = digits[data[i] >> 4];
+        out[2 * i + 1] = digits[data[i] & 15];
+    }
+    out[len * 2] = '\0';
+    return (Value){ .type = VAL_STRING, .string_val = out };
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// bytes.from_hex(s): null if s is not an even number of hex digits.
+static Value native_bytes_from_hex(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) return make_null();
+    const char* s = args[0].string_val;
+    size_t n = strlen(s);
+    if (n % 2 != 0) return make_null();
+    unsigned char* out = malloc(n / 2 > 0 ? n / 2 : 1);
+    for (size_t i = 0; i < n / 2; i++) {
+        int hi = hex_digit(s[2 * i]);
+        int lo = hex_digit(s[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            free(out);
+            return make_null();
+        }
+        out[i] = (unsigned char)(hi << 4 | lo);
+    }
+    return make_bytes_owned(out, n / 2, n / 2);
+}
+
+// ---------------------------------------------------------------------------
+// Fixed-width numbers
+// ---------------------------------------------------------------------------
+//
+// bytes.read_<type>(b, offset) and bytes.write_<type>(b, offset, value) for
+// u8/i8 and u16/i16/u32/i32/u64/i64/f32/f64 with an le or be suffix. Reads
+// out of range give null and writes false, as do writes to an mmap view.
+// u64 reads wrap into a signed int.
+
+typedef enum { NUM_UINT, NUM_INT, NUM_FLOAT } NumKind;
+
+static unsigned char* bytes_field(int argc, Value* args, int width) {
+    if (argc < 2 || args[0].type != VAL_BYTES || args[1].type != VAL_INT) return NULL;
+    Bytes* b = args[0].bytes_val;
+    long long off = args[1].int_val;
+    if (off < 0 || (size_t)off > b->length || b->length - (size_t)off < (size_t)width) return NULL;
+    return b->buf->data + b->offset + (size_t)off;
+}
+
+static Value bytes_read_number(int argc, Value* args, int width, bool big, NumKind kind) {
+    const unsigned char* p = bytes_field(argc, args, width);
+    if (!p) return make_null();
+    uint64_t x = 0;
+    for (int i = 0; i < width; i++) {
+        x = x << 8 | p[big ? i : width - 1 - i];
+    }
+    if (kind == NUM_FLOAT) {
+        if (width == 4) {
+            uint32_t bits = (uint32_t)x;
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            return make_float(f);
+        }
+        double d;
+        memcpy(&d, &x, sizeof(d));
+        return make_float(d);
+    }
+    if (kind == NUM_INT && width < 8 && (x >> (width * 8 - 1)) & 1) {
+        x |= ~(uint64_t)0 << (width * 8);
+    }
+    return make_int((long long)x);
+}
+
+static Value bytes_write_number(int argc, Value* args, int width, bool big, NumKind kind) {
+    unsigned char* p = bytes_field(argc, args, width);
+    if (!p || !bytes_writable(args[0].bytes_val) || argc < 3 || (args[2].type != VAL_INT && args[2].type != VAL_FLOAT)) return make_bool(false);
+    uint64_t x;
+    if (kind == NUM_FLOAT) {
+        double d = args[2].type == VAL_FLOAT ? args[2].float_val : (double)args[2].int_val;
+        if (width == 4) {
+            float f = (float)d;
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            x = bits;
+        } else {
+            memcpy(&x, &d, sizeof(x));
+        }
+    } else {
+        x = (uint64_t)(args[2].type == VAL_INT ? args[2].int_val : (long long)args[2].float_val);
+    }
+    for (int i = 0; i < width; i++) {
+        p[big ? width - 1 - i : i] = (unsigned char)(x >> (i * 8));
+    }
+    return make_bool(true);
+}
+
+#define BYTES_NUMBER(name, width, big, kind)                                                       \
+    static Value native_bytes_read_##name(struct Interpreter* interp, int argc, Value* args) {    \
+        (void)interp;                                                                              \
+        return bytes_read_number(argc, args, width, big, kind);                                    \
+    }                                                                                              \
+    static Value native_bytes_write_##name(struct Interpreter* interp, int argc, Value* args) {   \
+        (void)interp;                                                                              \
+        return bytes_write_number(argc, args, width, big, kind);                                   \
+    }
+
+BYTES_NUMBER(u8, 1, false, NUM_UINT)
+BYTES_NUMBER(i8, 1, false, NUM_INT)
+BYTES_NUMBER(u16le, 2, false, NUM_UINT)
+BYTES_NUMBER(u16be, 2, true, NUM_UINT)
+BYTES_NUMBER(i16le, 2, false, NUM_INT)
+BYTES_NUMBER(i16be, 2, true, NUM_INT)
+BYTES_NUMBER(u32le, 4, false, NUM_UINT)
+BYTES_NUMBER(u32be, 4, true, NUM_UINT)
+BYTES_NUMBER(i32le, 4, false, NUM_INT)
+BYTES_NUMBER(i32be, 4, true, NUM_INT)
+BYTES_NUMBER(u64le, 8, false, NUM_UINT)
+BYTES_NUMBER(u64be, 8, true, NUM_UINT)
+BYTES_NUMBER(i64le, 8, false, NUM_INT)
+BYTES_NUMBER(i64be, 8, true, NUM_INT)
+BYTES_NUMBER(f32le, 4, false, NUM_FLOAT)
+BYTES_NUMBER(f32be, 4, true, NUM_FLOAT)
+BYTES_NUMBER(f64le, 8, false, NUM_FLOAT)
+BYTES_NUMBER(f64be, 8, true, NUM_FLOAT)
+
+#define REGISTER_BYTES_NUMBER(name)                                \
+    register_native("bytes.read_" #name, native_bytes_read_##name); \
+    register_native("bytes.write_" #name, native_bytes_write_##name)
+
+void stdlib_bytes_register(void) {
+    register_native("bytes.new", native_bytes_new);
+    register_native("bytes.from", native_bytes_from);
+    register_native("bytes.to_string", native_bytes_to_string);
+    register_native("bytes.len", native_bytes_len);
+    register_native("bytes.slice", native_bytes_slice);
+    register_native("bytes.copy", native_bytes_copy);
+    register_native("bytes.get", native_bytes_get);
+    register_native("bytes.set", native_bytes_set);
+    register_native("bytes.concat", native_bytes_concat);
+    register_native("bytes.find", native_bytes_find);
+    register_native("bytes.to_hex", native_bytes_to_hex);
+    register_native("bytes.from_hex", native_bytes_from_hex);
+    REGISTER_BYTES_NUMBER(u8);
+    REGISTER_BYTES_NUMBER(i8);
+    REGISTER_BYTES_NUMBER(u16le);
+    REGISTER_BYTES_NUMBER(u16be);
+    REGISTER_BYTES_NUMBER(i16le);
+    REGISTER_BYTES_NUMBER(i16be);
+    REGISTER_BYTES_NUMBER(u32le);
+    REGISTER_BYTES_NUMBER(u32be);
+    REGISTER_BYTES_NUMBER(i32le);
+    REGISTER_BYTES_NUMBER(i32be);
+    REGISTER_BYTES_NUMBER(u64le);
+    REGISTER_BYTES_NUMBER(u64be);
+    REGISTER_BYTES_NUMBER(i64le);
+    REGISTER_BYTES_NUMBER(i64be);
+    REGISTER_BYTES_NUMBER(f32le);
+    REGISTER_BYTES_NUMBER(f32be);
+    REGISTER_BYTES_NUMBER(f64le);
+    REGISTER_BYTES_NUMBER(f64be);
+}
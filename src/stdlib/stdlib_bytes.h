@@ -0,0 +1,18 @@
+#ifndef RADS_BYTES_H
+#define RADS_BYTES_H
+
+#include "../core/interpreter.h"
+
+// Binary buffers behind bytes.*.
+//
+// A bytes value carries its own length, so it may hold NUL bytes, and it
+// is a view into a refcounted buffer: slices and copies of the value share
+// the storage instead of copying it (bytes.copy makes an independent one).
+// Strings convert without copying when the value being converted is not
+// referenced anywhere else, e.g. bytes.from(io.read_file(p)).
+//
+// Methods work on the value itself: b.slice(4, 8), b.read_u32le(0).
+
+void stdlib_bytes_register(void);
+
+#endif
@@ -0,0 +1,505 @@
+#include "stdlib_chan.h"
+#include "../core/workpool.h"
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uv.h>
+
+typedef struct ChanCell {
+    _Atomic size_t seq;
+    Value value;
+} ChanCell;
+
+typedef struct Channel {
+    long id;
+    char handle[32];
+    size_t cap;
+    ChanCell* cells;
+    // Producers and consumers live on separate cache lines.
+    _Alignas(64) _Atomic size_t send_pos;
+    _Alignas(64) _Atomic size_t recv_pos;
+    _Atomic bool closed;
+    _Atomic int waiters;         // loop-thread callers blocked on this channel
+    _Atomic int refs;            // one for the handle table plus one per chan_find
+    _Atomic bool dying;          // last ref dropped off the loop thread
+    bool listed;                 // still in chan_buckets (guarded by chan_lock)
+    bool has_async;
+    uv_async_t async;            // wakes loop-thread waiters after pool-side ops
+    struct Channel* next;
+} Channel;
+
+#define CHAN_BUCKETS 256
+#define CHAN_SELECT_KEY "chan_select"
+
+static Channel* chan_buckets[CHAN_BUCKETS];
+static uv_rwlock_t chan_lock;
+static uv_once_t chan_once = UV_ONCE_INIT;
+static _Atomic long next_chan_id = 1;
+static _Atomic int select_waiters = 0;
+
+static void chan_init_lock(void) {
+    uv_rwlock_init(&chan_lock);
+}
+
+static long chan_handle_id(const Value* v) {
+    if (v->type != VAL_STRING || strncmp(v->string_val, "chan_", 5) != 0) return 0;
+    return atol(v->string_val + 5);
+}
+
+// A handle chan.new gave out whose channel has since been released behaves
+// as closed and empty.
+static bool chan_released(const Value* v) {
+    long id = chan_handle_id(v);
+    return id > 0 && id < atomic_load(&next_chan_id);
+}
+
+// Returns the channel with a reference held; give it back with chan_put.
+static Channel* chan_find(const Value* v) {
+    long id = chan_handle_id(v);
+    if (id <= 0) return NULL;
+    uv_once(&chan_once, chan_init_lock);
+    uv_rwlock_rdlock(&chan_lock);
+    Channel* ch = chan_buckets[id % CHAN_BUCKETS];
+    while (ch && ch->id != id) ch = ch->next;
+    if (ch) atomic_fetch_add(&ch->refs, 1);
+    uv_rwlock_rdunlock(&chan_lock);
+    return ch;
+}
+
+static void chan_free(Channel* ch) {
+    for (size_t i = 0; i < ch->cap; i++) value_free(&ch->cells[i].value);
+    free(ch->cells);
+    free(ch);
+}
+
+static void chan_async_close_cb(uv_handle_t* handle) {
+    chan_free(handle->data);
+}
+
+// The async handle can only be closed on the loop thread; a worker dropping
+// the last reference sends it one more time and chan_async_cb closes it.
+static void chan_destroy(Channel* ch) {
+    if (!ch->has_async) {
+        chan_free(ch);
+    } else if (!workpool_on_worker()) {
+        uv_close((uv_handle_t*)&ch->async, chan_async_close_cb);
+    } else {
+        atomic_store(&ch->dying, true);
+        uv_async_send(&ch->async);
+    }
+}
+
+static void chan_put(Channel* ch) {
+    if (ch && atomic_fetch_sub(&ch->refs, 1) == 1) chan_destroy(ch);
+}
+
+// A closed channel with nothing left to receive can never change again, so
+// it leaves the handle table and goes away once its current users are done.
+static void chan_release_if_done(Channel* ch) {
+    if (!atomic_load(&ch->closed) || atomic_load(&ch->send_pos) != atomic_load(&ch->recv_pos)) return;
+    uv_rwlock_wrlock(&chan_lock);
+    bool unlink = ch->listed;
+    if (unlink) {
+        Channel** cur = &chan_buckets[ch->id % CHAN_BUCKETS];
+        while (*cur != ch) cur = &(*cur)->next;
+        *cur = ch->next;
+        ch->listed = false;
+    }
+    uv_rwlock_wrunlock(&chan_lock);
+    if (unlink) chan_put(ch);
+}
+
+// A slot is free for the send at position p when its seq is 2p, and holds
+// the value for the receive at p when its seq is 2p + 1. (Doubling keeps
+// the two states apart even when the ring has a single slot.)
+static bool ring_push(Channel* ch, Value* value) {
+    size_t pos = atomic_load_explicit(&ch->send_pos, memory_order_relaxed);
+    ChanCell* cell;
+    for (;;) {
+        cell = &ch->cells[pos % ch->cap];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(2 * pos);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ch->send_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&ch->send_pos, memory_order_relaxed);
+        }
+    }
+    cell->value = *value;
+    atomic_store_explicit(&cell->seq, 2 * pos + 1, memory_order_release);
+    return true;
+}
+
+static bool ring_pop(Channel* ch, Value* out) {
+    size_t pos = atomic_load_explicit(&ch->recv_pos, memory_order_relaxed);
+    ChanCell* cell;
+    for (;;) {
+        cell = &ch->cells[pos % ch->cap];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(2 * pos + 1);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ch->recv_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&ch->recv_pos, memory_order_relaxed);
+        }
+    }
+    *out = cell->value;
+    cell->value = make_null();
+    atomic_store_explicit(&cell->seq, 2 * (pos + ch->cap), memory_order_release);
+    return true;
+}
+
+static void chan_wake_loop(Channel* ch) {
+    if (atomic_load(&ch->waiters) > 0) interpreter_wake(ch->handle);
+    if (atomic_load(&select_waiters) > 0) interpreter_wake(CHAN_SELECT_KEY);
+}
+
+static void chan_async_cb(uv_async_t* handle) {
+    Channel* ch = handle->data;
+    if (atomic_load(&ch->dying)) {
+        uv_close((uv_handle_t*)handle, chan_async_close_cb);
+        return;
+    }
+    chan_wake_loop(ch);
+}
+
+// Called after every send, receive and close: whoever was blocked on the
+// other end gets to retry.
+static void chan_notify(Channel* ch) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&ch->waiters) == 0 && atomic_load(&select_waiters) == 0) return;
+    if (!workpool_on_worker()) {
+        chan_wake_loop(ch);
+    } else if (ch->has_async) {
+        uv_async_send(&ch->async);
+    }
+}
+
+// Blocks the caller until something may have changed on key. The caller
+// has already registered itself as a waiter and re-checked its condition.
+static bool chan_block(const char* key) {
+    if (workpool_on_worker()) {
+        sched_yield();
+        return true;
+    }
+    return interpreter_wait(key);
+}
+
+static bool chan_send(Channel* ch, Value* value) {
+    for (;;) {
+        if (atomic_load(&ch->closed)) return false;
+        if (ring_push(ch, value)) {
+            chan_notify(ch);
+            return true;
+        }
+        atomic_fetch_add(&ch->waiters, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        bool closed = atomic_load(&ch->closed);
+        bool pushed = !closed && ring_push(ch, value);
+        bool ok = pushed || closed || chan_block(ch->handle);
+        atomic_fetch_sub(&ch->waiters, 1);
+        if (pushed) {
+            chan_notify(ch);
+            return true;
+        }
+        if (!ok) {
+            fprintf(stderr, "Error: chan.send() on %s would block forever\n", ch->handle);
+            return false;
+        }
+    }
+}
+
+static bool chan_recv(Channel* ch, Value* out) {
+    for (;;) {
+        if (ring_pop(ch, out)) {
+            chan_notify(ch);
+            return true;
+        }
+        if (atomic_load(&ch->closed)) {
+            // Values sent just before the close are still delivered.
+            if (ring_pop(ch, out)) return true;
+            return false;
+        }
+        atomic_fetch_add(&ch->waiters, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        bool got = ring_pop(ch, out);
+        bool ok = got || atomic_load(&ch->closed) || chan_block(ch->handle);
+        atomic_fetch_sub(&ch->waiters, 1);
+        if (got) {
+            chan_notify(ch);
+            return true;
+        }
+        if (!ok) {
+            fprintf(stderr, "Error: chan.recv() on %s would block forever\n", ch->handle);
+            return false;
+        }
+    }
+}
+
+// Channels cross threads, so a sent value must not share anything with
+// the sender: strings are taken over, everything else is deep-copied.
+static Value chan_take_arg(Value* arg) {
+    if (arg->type == VAL_STRING) {
+        Value v = *arg;
+        *arg = make_null();
+        return v;
+    }
+    return value_deep_copy(*arg);
+}
+
+// chan.new([capacity]) -> "chan_<n>"
+static Value native_chan_new(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    long long cap = (argc >= 1 && args[0].type == VAL_INT) ? args[0].int_val : CHAN_DEFAULT_CAPACITY;
+    if (cap < 1) cap = 1;
+    if (cap > CHAN_MAX_CAPACITY) cap = CHAN_MAX_CAPACITY;
+
+    Channel* ch = aligned_alloc(64, (sizeof(Channel) + 63) & ~(size_t)63);
+    memset(ch, 0, sizeof(Channel));
+    ch->id = atomic_fetch_add(&next_chan_id, 1);
+    snprintf(ch->handle, sizeof(ch->handle), "chan_%ld", ch->id);
+    ch->cap = (size_t)cap;
+    atomic_init(&ch->refs, 1);
+    ch->listed = true;
+    ch->cells = calloc(ch->cap, sizeof(ChanCell));
+    for (size_t i = 0; i < ch->cap; i++) atomic_init(&ch->cells[i].seq, 2 * i);
+    if (!workpool_on_worker()) {
+        // Unreferenced: an idle channel must not keep the program alive.
+        uv_async_init(interpreter_init_event_loop(), &ch->async, chan_async_cb);
+        uv_unref((uv_handle_t*)&ch->async);
+        ch->async.data = ch;
+        ch->has_async = true;
+    }
+
+    uv_once(&chan_once, chan_init_lock);
+    uv_rwlock_wrlock(&chan_lock);
+    ch->next = chan_buckets[ch->id % CHAN_BUCKETS];
+    chan_buckets[ch->id % CHAN_BUCKETS] = ch;
+    uv_rwlock_wrunlock(&chan_lock);
+    return make_string(ch->handle);
+}
+
+// chan.send(ch, value): waits while the channel is full. False once the
+// channel is closed.
+static Value native_chan_send(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Channel* ch = argc >= 2 ? chan_find(&args[0]) : NULL;
+    if (!ch) {
+        if (argc < 2 || !chan_released(&args[0])) {
+            fprintf(stderr, "Error: chan.send() requires a channel and a value\n");
+        }
+        return make_bool(false);
+    }
+    Value v = chan_take_arg(&args[1]);
+    bool sent = chan_send(ch, &v);
+    if (!sent) value_free(&v);
+    chan_put(ch);
+    return make_bool(sent);
+}
+
+// chan.try_send(ch, value): false instead of waiting when full.
+static Value native_chan_try_send(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Channel* ch = argc >= 2 ? chan_find(&args[0]) : NULL;
+    if (!ch) return make_bool(false);
+    bool sent = false;
+    if (!atomic_load(&ch->closed)) {
+        Value v = chan_take_arg(&args[1]);
+        sent = ring_push(ch, &v);
+        if (sent) {
+            chan_notify(ch);
+        } else {
+            value_free(&v);
+        }
+    }
+    chan_put(ch);
+    return make_bool(sent);
+}
+
+// chan.recv(ch): waits for a value; null once the channel is closed and
+// drained.
+static Value native_chan_recv(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Channel* ch = argc >= 1 ? chan_find(&args[0]) : NULL;
+    if (!ch) {
+        if (argc < 1 || !chan_released(&args[0])) fprintf(stderr, "Error: chan.recv() requires a channel\n");
+        return make_null();
+    }
+    Value v;
+    if (!chan_recv(ch, &v)) v = make_null();
+    chan_release_if_done(ch);
+    chan_put(ch);
+    return v;
+}
+
+// chan.try_recv(ch): null instead of waiting when empty.
+static Value native_chan_try_recv(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Channel* ch = argc >= 1 ? chan_find(&args[0]) : NULL;
+    if (!ch) return make_null();
+    Value v;
+    if (ring_pop(ch, &v)) {
+        chan_notify(ch);
+    } else {
+        v = make_null();
+    }
+    chan_release_if_done(ch);
+    chan_put(ch);
+    return v;
+}
+
+// chan.close(ch): later sends fail; receivers drain what is buffered. The
+// channel is freed once it is closed and drained.
+static Value native_chan_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Channel* ch = argc >= 1 ? chan_find(&args[0]) : NULL;
+    if (!ch) return make_bool(false);
+    bool was_closed = atomic_exchange(&ch->closed, true);
+    chan_notify(ch);
+    chan_release_if_done(ch);
+    chan_put(ch);
+    return make_bool(!was_closed);
+}
+
+static Value native_chan_closed(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Channel* ch = argc >= 1 ? chan_find(&args[0]) : NULL;
+    bool closed = !ch || atomic_load(&ch->closed);
+    chan_put(ch);
+    return make_bool(closed);
+}
+
+// chan.len(ch): values currently buffered.
+static Value native_chan_len(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Channel* ch = argc >= 1 ? chan_find(&args[0]) : NULL;
+    if (!ch) return make_int(0);
+    size_t sent = atomic_load(&ch->send_pos);
+    size_t received = atomic_load(&ch->recv_pos);
+    chan_put(ch);
+    return make_int(sent > received ? (long long)(sent - received) : 0);
+}
+
+typedef struct SelectTimer {
+    uv_timer_t timer;
+    bool fired;
+} SelectTimer;
+
+static void select_timer_cb(uv_timer_t* timer) {
+    SelectTimer* t = timer->data;
+    t->fired = true;
+    interpreter_wake(CHAN_SELECT_KEY);
+}
+
+static void select_timer_close_cb(uv_handle_t* handle) {
+    free(handle->data);
+}
+
+static Value select_result(long long index, Value value) {
+    Array* pair = array_create(2);
+    pair->items[0] = make_int(index);
+    pair->items[1] = value;
+    pair->count = 2;
+    Value out = { .type = VAL_ARRAY, .array_val = pair };
+    return out;
+}
+
+// One receive attempt across chans, starting at a rotating offset so no
+// channel starves the others. Returns the index served, or -1; *open is
+// cleared when every channel is closed and drained.
+static long long select_try(Channel** chans, size_t count, size_t start, Value* out, bool* open) {
+    *open = false;
+    for (size_t k = 0; k < count; k++) {
+        size_t i = (start + k) % count;
+        if (!chans[i]) continue;
+        if (ring_pop(chans[i], out)) {
+            chan_notify(chans[i]);
+            return (long long)i;
+        }
+        if (!atomic_load(&chans[i]->closed)) *open = true;
+    }
+    return -1;
+}
+
+// chan.select(chans, [timeout_ms]) -> [index, value] for the first channel
+// with a value ready; [-1, null] on timeout or when all are closed.
+static Value native_chan_select(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_ARRAY) {
+        fprintf(stderr, "Error: chan.select() requires an array of channels\n");
+        return select_result(-1, make_null());
+    }
+    Array* arr = args[0].array_val;
+    size_t count = arr->count;
+    if (count == 0) return select_result(-1, make_null());
+    Channel** chans = malloc(sizeof(Channel*) * count);
+    for (size_t i = 0; i < count; i++) chans[i] = chan_find(&arr->items[i]);
+    long long timeout = (argc >= 2 && args[1].type == VAL_INT) ? args[1].int_val : -1;
+
+    static _Atomic size_t rotation = 0;
+    size_t start = atomic_fetch_add(&rotation, 1) % count;
+    uint64_t deadline = timeout >= 0 ? uv_hrtime() + (uint64_t)timeout * 1000000ULL : 0;
+    SelectTimer* timer = NULL;
+    Value out = make_null();
+    long long index = -1;
+    bool open = true;
+
+    for (;;) {
+        index = select_try(chans, count, start, &out, &open);
+        if (index >= 0 || !open || timeout == 0) break;
+        if (timeout > 0 && (timer ? timer->fired : uv_hrtime() >= deadline)) break;
+        if (timeout > 0 && !timer && !workpool_on_worker()) {
+            timer = calloc(1, sizeof(SelectTimer));
+            uv_timer_init(interpreter_init_event_loop(), &timer->timer);
+            timer->timer.data = timer;
+            uv_timer_start(&timer->timer, select_timer_cb, (uint64_t)timeout, 0);
+        }
+        atomic_fetch_add(&select_waiters, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        index = select_try(chans, count, start, &out, &open);
+        bool ok = index >= 0 || !open || chan_block(CHAN_SELECT_KEY);
+        atomic_fetch_sub(&select_waiters, 1);
+        if (index >= 0 || !open) break;
+        if (!ok) {
+            fprintf(stderr, "Error: chan.select() would block forever\n");
+            break;
+        }
+    }
+    if (timer) {
+        uv_timer_stop(&timer->timer);
+        uv_close((uv_handle_t*)&timer->timer, select_timer_close_cb);
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!chans[i]) continue;
+        chan_release_if_done(chans[i]);
+        chan_put(chans[i]);
+    }
+    free(chans);
+    return select_result(index, index >= 0 ? out : make_null());
+}
+
+void stdlib_chan_register(void) {
+    register_native("chan.new", native_chan_new);
+    register_native("chan.send", native_chan_send);
+    register_native("chan.try_send", native_chan_try_send);
+    register_native("chan.recv", native_chan_recv);
+    register_native("chan.try_recv", native_chan_try_recv);
+    register_native("chan.close", native_chan_close);
+    register_native("chan.closed", native_chan_closed);
+    register_native("chan.len", native_chan_len);
+    register_native("chan.select", native_chan_select);
+    register_handle_methods("chan_", "chan.");
+}
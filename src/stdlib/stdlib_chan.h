@@ -0,0 +1,25 @@
+#ifndef RADS_CHAN_H
+#define RADS_CHAN_H
+
+#include "../core/interpreter.h"
+
+// Bounded channels behind chan.*.
+//
+// A channel is a fixed ring of slots used as a lock-free multi-producer,
+// multi-consumer queue (each slot carries a sequence number that tells
+// producers and consumers whose turn it is). Values are deep-copied on
+// send, so a channel can connect async tasks on the loop thread as well as
+// parallel jobs on the work pool. A full channel blocks senders and an
+// empty one blocks receivers: inside a task only that task waits, on the
+// main path the event loop keeps running, and a pool worker yields.
+//
+// Handles are "chan_<n>" strings with methods, e.g. ch.send(v). A channel
+// is freed once it is closed and drained; its handle then reads as closed
+// and empty.
+
+#define CHAN_DEFAULT_CAPACITY 1
+#define CHAN_MAX_CAPACITY (1 << 24)
+
+void stdlib_chan_register(void);
+
+#endif
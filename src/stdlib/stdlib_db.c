@@ -2,7 +2,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sqlite3.h>
+#include <uv.h>
 #include "../core/interpreter.h"
+#include "../core/workpool.h"
 #include "stdlib_db.h"
 
 // ============================================================================
@@ -14,7 +16,12 @@
 // API:
 //   db.open(path) - Open database connection
 //   db.query(sql, params) - Execute SELECT query, returns array of rows
+//   db.query_iter(sql, params) - Cursor that yields one row per next()
+//   db.print(sql, params) - Print a query result as a table
 //   db.execute(sql, params) - Execute INSERT/UPDATE/DELETE, returns affected rows
+//   db.cache_stats() - Prepared statement cache [hits, misses, size]
+//   db.insert_batch(table, columns, rows) - Insert many rows in one transaction
+//   db.pool(name, path, size) - WAL connection pool with off-loop queries
 //   db.begin() - Start transaction
 //   db.commit() - Commit transaction
 //   db.rollback() - Rollback transaction
@@ -22,14 +29,58 @@
 //
 // ============================================================================
 
+// Prepared statements are cached per connection, keyed by SQL text, so a
+// query run in a loop is compiled once. Entries live in a small hash table
+// for lookup and a doubly linked list in LRU order for eviction.
+#define DB_STMT_CACHE_CAPACITY 64
+#define DB_STMT_CACHE_BUCKETS 128
+
+typedef struct CachedStmt {
+    char* sql;
+    unsigned long hash;
+    sqlite3_stmt* stmt;
+    int in_use;                     // held by an open cursor
+    struct CachedStmt* bucket_next;
+    struct CachedStmt* lru_prev;
+    struct CachedStmt* lru_next;
+} CachedStmt;
+
+typedef struct DBCursor DBCursor;
+
 // Database connection handle stored as opaque pointer
 typedef struct {
     sqlite3* db;
     int in_transaction;
+    CachedStmt* buckets[DB_STMT_CACHE_BUCKETS];
+    CachedStmt* lru_head;           // most recently used
+    CachedStmt* lru_tail;
+    int cache_count;
+    long cache_hits;
+    long cache_misses;
+    DBCursor* cursors;
 } DBHandle;
 
-// Global database handle (single connection for now)
+// A streaming query started by db.query_iter
+struct DBCursor {
+    char id[32];
+    sqlite3_stmt* stmt;
+    CachedStmt* cached;             // NULL when the statement is private
+    DBCursor* next;
+};
+
+static long next_cursor_id = 1;
+
+// Global database handle used by the synchronous db.* calls. Pool workers
+// may call them too, so each call runs under db_lock (see DB_SYNC).
 static DBHandle* current_db = NULL;
+static uv_mutex_t db_lock;
+static uv_once_t db_once = UV_ONCE_INIT;
+
+static void db_init_lock(void) {
+    uv_mutex_init(&db_lock);
+}
+
+extern uv_loop_t* global_event_loop;
 
 // ============================================================================
 // Database Error Helper
@@ -40,22 +91,441 @@ static void print_db_error(const char* message, sqlite3* db) {
 }
 
 // ============================================================================
-// Database Row Object Creation (for future use)
+// Prepared Statement Cache
 // ============================================================================
 
-static Value __attribute__((unused)) create_row_object(sqlite3_stmt* stmt) {
-    // Create a struct-like object representing a database row
-    // For now, we'll use a simple approach with a custom type
-    // In future, this could be enhanced with proper struct support
+static unsigned long stmt_hash(const char* sql) {
+    unsigned long h = 1469598103934665603UL;
+    for (const unsigned char* p = (const unsigned char*)sql; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211UL;
+    }
+    return h;
+}
+
+static void stmt_lru_unlink(DBHandle* h, CachedStmt* c) {
+    if (c->lru_prev) c->lru_prev->lru_next = c->lru_next;
+    else h->lru_head = c->lru_next;
+    if (c->lru_next) c->lru_next->lru_prev = c->lru_prev;
+    else h->lru_tail = c->lru_prev;
+    c->lru_prev = c->lru_next = NULL;
+}
+
+static void stmt_lru_push_front(DBHandle* h, CachedStmt* c) {
+    c->lru_prev = NULL;
+    c->lru_next = h->lru_head;
+    if (h->lru_head) h->lru_head->lru_prev = c;
+    h->lru_head = c;
+    if (!h->lru_tail) h->lru_tail = c;
+}
+
+static void stmt_cache_remove(DBHandle* h, CachedStmt* c) {
+    CachedStmt** link = &h->buckets[c->hash % DB_STMT_CACHE_BUCKETS];
+    while (*link && *link != c) link = &(*link)->bucket_next;
+    if (*link) *link = c->bucket_next;
+    stmt_lru_unlink(h, c);
+    sqlite3_finalize(c->stmt);
+    free(c->sql);
+    free(c);
+    h->cache_count--;
+}
+
+// Evicts least recently used statements that no cursor is holding.
+static void stmt_cache_trim(DBHandle* h) {
+    CachedStmt* c = h->lru_tail;
+    while (c && h->cache_count > DB_STMT_CACHE_CAPACITY) {
+        CachedStmt* prev = c->lru_prev;
+        if (!c->in_use) stmt_cache_remove(h, c);
+        c = prev;
+    }
+}
+
+static void stmt_cache_clear(DBHandle* h) {
+    while (h->lru_head) stmt_cache_remove(h, h->lru_head);
+}
 
-    Value row = {0};
-    row.type = VAL_NULL; // Placeholder - will implement proper row objects
+// Returns a reset statement for sql (NULL on error, see sqlite3_errmsg).
+// *cached is the cache entry, or NULL if the statement is private to the
+// caller (multi-statement text, or the cached copy is busy in a cursor) and
+// must be finalized by it. *tail receives the text after the first statement.
+static sqlite3_stmt* db_prepare(DBHandle* h, const char* sql, CachedStmt** cached, const char** tail) {
+    unsigned long hash = stmt_hash(sql);
+    CachedStmt* c = h->buckets[hash % DB_STMT_CACHE_BUCKETS];
+    while (c && (c->hash != hash || strcmp(c->sql, sql) != 0)) c = c->bucket_next;
+    if (c && !c->in_use) {
+        h->cache_hits++;
+        stmt_lru_unlink(h, c);
+        stmt_lru_push_front(h, c);
+        sqlite3_reset(c->stmt);
+        sqlite3_clear_bindings(c->stmt);
+        *cached = c;
+        if (tail) *tail = "";
+        return c->stmt;
+    }
+    h->cache_misses++;
+    sqlite3_stmt* stmt = NULL;
+    const char* rest = NULL;
+    int rc = sqlite3_prepare_v3(h->db, sql, -1, c ? 0 : SQLITE_PREPARE_PERSISTENT, &stmt, &rest);
+    if (rc != SQLITE_OK) return NULL;
+    if (tail) *tail = rest ? rest : "";
+    *cached = NULL;
+    // Only single statements are worth keeping; busy duplicates stay private.
+    while (rest && (*rest == ' ' || *rest == '\t' || *rest == '\n' || *rest == '\r' || *rest == ';')) rest++;
+    if (c || !stmt || (rest && *rest)) return stmt;
+
+    c = calloc(1, sizeof(CachedStmt));
+    c->sql = strdup(sql);
+    c->hash = hash;
+    c->stmt = stmt;
+    c->bucket_next = h->buckets[hash % DB_STMT_CACHE_BUCKETS];
+    h->buckets[hash % DB_STMT_CACHE_BUCKETS] = c;
+    stmt_lru_push_front(h, c);
+    h->cache_count++;
+    stmt_cache_trim(h);
+    *cached = c;
+    return stmt;
+}
+
+static void db_release(sqlite3_stmt* stmt, CachedStmt* cached) {
+    if (cached) {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    } else {
+        sqlite3_finalize(stmt);
+    }
+}
 
-    // For demonstration, we'll just print the row data
-    // TODO: Create proper struct instance with column values
+// ============================================================================
+// Parameter Binding
+// ============================================================================
+// params is an array bound to ?/?NNN placeholders in order, or a struct
+// (e.g. a json.parse object) bound by name to :name, @name or $name.
+
+static int bind_value(sqlite3_stmt* stmt, int index, const Value* v, char* err, size_t err_len) {
+    switch (v->type) {
+        case VAL_NULL: return sqlite3_bind_null(stmt, index);
+        case VAL_BOOL: return sqlite3_bind_int(stmt, index, v->bool_val ? 1 : 0);
+        case VAL_INT: return sqlite3_bind_int64(stmt, index, (sqlite3_int64)v->int_val);
+        case VAL_FLOAT: return sqlite3_bind_double(stmt, index, v->float_val);
+        case VAL_STRING: return sqlite3_bind_text(stmt, index, v->string_val ? v->string_val : "", -1, SQLITE_TRANSIENT);
+        case VAL_BYTES: {
+            size_t len = 0;
+            const unsigned char* data = value_bytes(v, &len);
+            return sqlite3_bind_blob64(stmt, index, data, (sqlite3_uint64)len, SQLITE_TRANSIENT);
+        }
+        default:
+            snprintf(err, err_len, "parameter %d has a type that cannot be bound", index);
+            return SQLITE_MISMATCH;
+    }
+}
 
+static int bind_params(sqlite3_stmt* stmt, const Value* params, char* err, size_t err_len) {
+    if (!params || params->type == VAL_NULL) return SQLITE_OK;
+    int expected = sqlite3_bind_parameter_count(stmt);
+    if (params->type == VAL_ARRAY) {
+        Array* arr = params->array_val;
+        if ((int)arr->count != expected) {
+            snprintf(err, err_len, "expected %d parameters, got %zu", expected, arr->count);
+            return SQLITE_RANGE;
+        }
+        for (size_t i = 0; i < arr->count; i++) {
+            int rc = bind_value(stmt, (int)i + 1, &arr->items[i], err, err_len);
+            if (rc != SQLITE_OK) return rc;
+        }
+        return SQLITE_OK;
+    }
+    if (params->type == VAL_STRUCT_INSTANCE) {
+        static const char prefixes[] = ":@$";
+        char name[256];
+        for (FieldValue* f = params->struct_instance->fields; f; f = f->next) {
+            for (int k = 0; k < 3; k++) {
+                snprintf(name, sizeof(name), "%c%s", prefixes[k], f->name);
+                int index = sqlite3_bind_parameter_index(stmt, name);
+                if (index > 0) {
+                    int rc = bind_value(stmt, index, f->value, err, err_len);
+                    if (rc != SQLITE_OK) return rc;
+                }
+            }
+        }
+        return SQLITE_OK;
+    }
+    snprintf(err, err_len, "params must be an array or a struct");
+    return SQLITE_MISMATCH;
+}
+
+// ============================================================================
+// Database Row Object Creation
+// ============================================================================
+// Rows are struct instances with one field per column, in column order.
+// INTEGER columns become ints, REAL floats, TEXT strings and BLOB bytes.
+
+static StructDef db_row_def = { (char*)"row", NULL };
+
+static Value column_value(sqlite3_stmt* stmt, int i) {
+    switch (sqlite3_column_type(stmt, i)) {
+        case SQLITE_INTEGER:
+            return make_int((long long)sqlite3_column_int64(stmt, i));
+        case SQLITE_FLOAT:
+            return make_float(sqlite3_column_double(stmt, i));
+        case SQLITE_BLOB:
+            return make_bytes(sqlite3_column_blob(stmt, i), (size_t)sqlite3_column_bytes(stmt, i));
+        case SQLITE_TEXT: {
+            const char* data = (const char*)sqlite3_column_blob(stmt, i);
+            int len = sqlite3_column_bytes(stmt, i);
+            Value v;
+            v.type = VAL_STRING;
+            v.string_val = malloc((size_t)len + 1);
+            if (len > 0) memcpy(v.string_val, data, (size_t)len);
+            v.string_val[len] = '\0';
+            return v;
+        }
+        default:
+            return make_null();
+    }
+}
+
+static Value create_row_object(sqlite3_stmt* stmt) {
+    Value row;
+    row.type = VAL_STRUCT_INSTANCE;
+    row.struct_instance = malloc(sizeof(StructInstance));
+    row.struct_instance->definition = &db_row_def;
+    row.struct_instance->fields = NULL;
+    FieldValue** tail = &row.struct_instance->fields;
+    int col_count = sqlite3_column_count(stmt);
+    for (int i = 0; i < col_count; i++) {
+        FieldValue* field = malloc(sizeof(FieldValue));
+        const char* name = sqlite3_column_name(stmt, i);
+        field->name = strdup(name ? name : "");
+        field->value = malloc(sizeof(Value));
+        *field->value = column_value(stmt, i);
+        field->next = NULL;
+        *tail = field;
+        tail = &field->next;
+    }
     return row;
- }
+}
+
+static void array_push_owned(Array* arr, Value v) {
+    if (arr->count >= arr->capacity) {
+        arr->capacity = arr->capacity ? arr->capacity * 2 : 4;
+        arr->items = realloc(arr->items, arr->capacity * sizeof(Value));
+    }
+    arr->items[arr->count++] = v;
+}
+
+static void print_sql_error(const char* message) {
+    fprintf(stderr, "\033[1;31mSQL Error:\033[0m %s\n", message);
+}
+
+// Prepares and binds a statement; on failure fills err and returns NULL.
+static sqlite3_stmt* prepare_bound(DBHandle* h, const char* sql, const Value* params,
+                                   CachedStmt** cached, const char** tail, char* err, size_t err_len) {
+    sqlite3_stmt* stmt = db_prepare(h, sql, cached, tail);
+    if (!stmt) {
+        snprintf(err, err_len, "%s", sqlite3_errmsg(h->db));
+        return NULL;
+    }
+    if (bind_params(stmt, params, err, err_len) != SQLITE_OK) {
+        db_release(stmt, *cached);
+        return NULL;
+    }
+    return stmt;
+}
+
+// ============================================================================
+// Statement Runners
+// ============================================================================
+// Shared by the synchronous db.* calls and by pool jobs running on the libuv
+// threadpool, so they report errors through err instead of printing.
+
+static bool run_query(DBHandle* h, const char* sql, const Value* params, Value* out, char* err, size_t err_len) {
+    CachedStmt* cached = NULL;
+    sqlite3_stmt* stmt = prepare_bound(h, sql, params, &cached, NULL, err, err_len);
+    if (!stmt) return false;
+
+    Array* rows = array_create(16);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        array_push_owned(rows, create_row_object(stmt));
+    }
+    out->type = VAL_ARRAY;
+    out->array_val = rows;
+    if (rc != SQLITE_DONE) {
+        snprintf(err, err_len, "%s", sqlite3_errmsg(h->db));
+        value_free(out);
+    }
+    db_release(stmt, cached);
+    return rc == SQLITE_DONE;
+}
+
+static bool run_execute(DBHandle* h, const char* sql, const Value* params, long long* affected, char* err, size_t err_len) {
+    CachedStmt* cached = NULL;
+    const char* tail = NULL;
+    sqlite3_stmt* stmt = prepare_bound(h, sql, params, &cached, &tail, err, err_len);
+    if (!stmt) return false;
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        // Rows from statements such as INSERT ... RETURNING are discarded
+    }
+    if (rc != SQLITE_DONE) snprintf(err, err_len, "%s", sqlite3_errmsg(h->db));
+    db_release(stmt, cached);
+    if (rc != SQLITE_DONE) return false;
+    *affected = sqlite3_changes(h->db);
+
+    // Scripts with several statements (schema setup) run the rest unbound.
+    while (*tail == ' ' || *tail == '\t' || *tail == '\n' || *tail == '\r' || *tail == ';') tail++;
+    if (*tail) {
+        char* err_msg = NULL;
+        if (sqlite3_exec(h->db, tail, NULL, NULL, &err_msg) != SQLITE_OK) {
+            snprintf(err, err_len, "%s", err_msg ? err_msg : "exec failed");
+            sqlite3_free(err_msg);
+            return false;
+        }
+        *affected = sqlite3_changes(h->db);
+    }
+    return true;
+}
+
+static void append_identifier(char* buf, size_t cap, size_t* len, const char* name) {
+    if (*len + 1 < cap) buf[(*len)++] = '"';
+    for (const char* p = name; *p && *len + 2 < cap; p++) {
+        if (*p == '"') buf[(*len)++] = '"';
+        buf[(*len)++] = *p;
+    }
+    if (*len + 1 < cap) buf[(*len)++] = '"';
+    buf[*len] = '\0';
+}
+
+// Inserts every row in one transaction through a single cached statement.
+// Rows are arrays in column order, or structs with fields named like the
+// columns.
+static bool run_insert_batch(DBHandle* h, const char* table, const Value* columns, const Value* rows,
+                             long long* inserted, char* err, size_t err_len) {
+    if (!columns || columns->type != VAL_ARRAY || columns->array_val->count == 0 ||
+        !rows || rows->type != VAL_ARRAY) {
+        snprintf(err, err_len, "insert_batch expects (table, [columns], [rows])");
+        return false;
+    }
+    Array* cols = columns->array_val;
+    char sql[4096];
+    size_t len = (size_t)snprintf(sql, sizeof(sql), "INSERT INTO ");
+    append_identifier(sql, sizeof(sql), &len, table);
+    len += (size_t)snprintf(sql + len, sizeof(sql) - len, " (");
+    for (size_t i = 0; i < cols->count; i++) {
+        if (cols->items[i].type != VAL_STRING) {
+            snprintf(err, err_len, "column names must be strings");
+            return false;
+        }
+        if (i > 0 && len + 2 < sizeof(sql)) sql[len++] = ',';
+        append_identifier(sql, sizeof(sql), &len, cols->items[i].string_val);
+    }
+    len += (size_t)snprintf(sql + len, sizeof(sql) - len, ") VALUES (");
+    for (size_t i = 0; i < cols->count && len + 3 < sizeof(sql); i++) {
+        len += (size_t)snprintf(sql + len, sizeof(sql) - len, i ? ",?" : "?");
+    }
+    if (len + 2 >= sizeof(sql)) {
+        snprintf(err, err_len, "insert_batch statement too long");
+        return false;
+    }
+    snprintf(sql + len, sizeof(sql) - len, ")");
+
+    CachedStmt* cached = NULL;
+    sqlite3_stmt* stmt = db_prepare(h, sql, &cached, NULL);
+    if (!stmt) {
+        snprintf(err, err_len, "%s", sqlite3_errmsg(h->db));
+        return false;
+    }
+    // Join an open transaction rather than nesting one.
+    bool own_txn = sqlite3_get_autocommit(h->db);
+    if (own_txn && sqlite3_exec(h->db, "BEGIN IMMEDIATE", NULL, NULL, NULL) != SQLITE_OK) {
+        snprintf(err, err_len, "%s", sqlite3_errmsg(h->db));
+        db_release(stmt, cached);
+        return false;
+    }
+    bool ok = true;
+    Array* arr = rows->array_val;
+    for (size_t r = 0; r < arr->count && ok; r++) {
+        const Value* row = &arr->items[r];
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        for (size_t c = 0; c < cols->count && ok; c++) {
+            const Value* v = NULL;
+            if (row->type == VAL_ARRAY && c < row->array_val->count) {
+                v = &row->array_val->items[c];
+            } else if (row->type == VAL_STRUCT_INSTANCE) {
+                for (FieldValue* f = row->struct_instance->fields; f; f = f->next) {
+                    if (strcmp(f->name, cols->items[c].string_val) == 0) {
+                        v = f->value;
+                        break;
+                    }
+                }
+            }
+            if (v) ok = bind_value(stmt, (int)c + 1, v, err, err_len) == SQLITE_OK;
+        }
+        if (ok && sqlite3_step(stmt) != SQLITE_DONE) {
+            snprintf(err, err_len, "row %zu: %s", r, sqlite3_errmsg(h->db));
+            ok = false;
+        }
+    }
+    db_release(stmt, cached);
+    if (own_txn) {
+        if (ok && sqlite3_exec(h->db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+            snprintf(err, err_len, "%s", sqlite3_errmsg(h->db));
+            ok = false;
+        }
+        if (!ok) sqlite3_exec(h->db, "ROLLBACK", NULL, NULL, NULL);
+    }
+    if (ok) *inserted = (long long)arr->count;
+    return ok;
+}
+
+// Prepares sql from args[0] and binds args[1]; prints and returns NULL on error.
+static bool check_call(const char* fn, int argc, Value* args) {
+    if (current_db == NULL) {
+        fprintf(stderr, "Error: No database connection. Call db.open() first.\n");
+        return false;
+    }
+    if (argc < 1 || argc > 2) {
+        fprintf(stderr, "Error: %s() requires 1-2 arguments (sql, params?)\n", fn);
+        return false;
+    }
+    if (args[0].type != VAL_STRING) {
+        fprintf(stderr, "Error: %s() sql must be a string\n", fn);
+        return false;
+    }
+    return true;
+}
+
+static sqlite3_stmt* prepare_call(const char* fn, int argc, Value* args, CachedStmt** cached, const char** tail) {
+    if (!check_call(fn, argc, args)) return NULL;
+    char err[256];
+    sqlite3_stmt* stmt = prepare_bound(current_db, args[0].string_val, argc >= 2 ? &args[1] : NULL,
+                                       cached, tail, err, sizeof(err));
+    if (!stmt) print_sql_error(err);
+    return stmt;
+}
+
+static void cursor_free(DBHandle* h, DBCursor* cursor) {
+    for (DBCursor** link = &h->cursors; *link; link = &(*link)->next) {
+        if (*link == cursor) {
+            *link = cursor->next;
+            break;
+        }
+    }
+    if (cursor->cached) cursor->cached->in_use = 0;
+    db_release(cursor->stmt, cursor->cached);
+    free(cursor);
+    stmt_cache_trim(h);
+}
+
+// Finalizes every statement (open cursors included) before closing.
+static void db_handle_close(DBHandle* h) {
+    while (h->cursors) cursor_free(h, h->cursors);
+    stmt_cache_clear(h);
+    sqlite3_close(h->db);
+    free(h);
+}
 
 // ============================================================================
 // db.open(path) - Open database connection
@@ -89,13 +559,11 @@ Value native_db_open(struct Interpreter* interp, int argc, Value* args) {
 
     // Close existing connection if any
     if (current_db != NULL) {
-        sqlite3_close(current_db->db);
-        free(current_db);
+        db_handle_close(current_db);
     }
 
     // Allocate new handle
-    current_db = malloc(sizeof(DBHandle));
-    current_db->in_transaction = 0;
+    current_db = calloc(1, sizeof(DBHandle));
 
     // Open database
     int rc = sqlite3_open(path, &current_db->db);
@@ -132,50 +600,16 @@ Value native_db_open(struct Interpreter* interp, int argc, Value* args) {
 Value native_db_execute(struct Interpreter* interp, int argc, Value* args) {
     (void)interp; // Unused
 
-    if (current_db == NULL) {
-        fprintf(stderr, "Error: No database connection. Call db.open() first.\n");
-        Value v = {0};
-        v.type = VAL_NULL;
-        return v;
-    }
-
-    if (argc < 1 || argc > 2) {
-        fprintf(stderr, "Error: db.execute() requires 1-2 arguments (sql, params?)\n");
-        Value v = {0};
-        v.type = VAL_NULL;
-        return v;
-    }
-
-    if (args[0].type != VAL_STRING) {
-        fprintf(stderr, "Error: db.execute() sql must be a string\n");
-        Value v = {0};
-        v.type = VAL_NULL;
-        return v;
-    }
-
-    const char* sql = args[0].string_val;
-
-    // For now, simple exec without parameter binding
-    // TODO: Add parameter binding from args[1] array
-
-    char* err_msg = NULL;
-    int rc = sqlite3_exec(current_db->db, sql, NULL, NULL, &err_msg);
-
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "\033[1;31mSQL Error:\033[0m %s\n", err_msg);
-        sqlite3_free(err_msg);
-        Value v = {0};
-        v.type = VAL_NULL;
-        return v;
+    if (!check_call("db.execute", argc, args)) return make_null();
+    char err[256];
+    long long affected = 0;
+    if (!run_execute(current_db, args[0].string_val, argc >= 2 ? &args[1] : NULL, &affected, err, sizeof(err))) {
+        print_sql_error(err);
+        return make_null();
     }
 
     // Return number of affected rows
-    int affected = sqlite3_changes(current_db->db);
-
-    Value result = {0};
-    result.type = VAL_INT;
-    result.int_val = affected;
-    return result;
+    return make_int(affected);
 }
 
 // ============================================================================
@@ -192,43 +626,116 @@ Value native_db_execute(struct Interpreter* interp, int argc, Value* args) {
 Value native_db_query(struct Interpreter* interp, int argc, Value* args) {
     (void)interp; // Unused
 
+    if (!check_call("db.query", argc, args)) return make_null();
+    char err[256];
+    Value rows;
+    if (!run_query(current_db, args[0].string_val, argc >= 2 ? &args[1] : NULL, &rows, err, sizeof(err))) {
+        print_sql_error(err);
+        return make_null();
+    }
+    return rows;
+}
+
+// ============================================================================
+// db.insert_batch(table, columns, rows) - Insert many rows at once
+// ============================================================================
+// All rows go in one transaction through one prepared statement, which is
+// far cheaper than a transaction per db.execute. Returns the row count.
+//
+// Examples:
+//   db.insert_batch("users", ["id", "name"], [[1, "Ana"], [2, "Bo"]]);
+// ============================================================================
+
+Value native_db_insert_batch(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+
     if (current_db == NULL) {
         fprintf(stderr, "Error: No database connection. Call db.open() first.\n");
-        Value v = {0};
-        v.type = VAL_NULL;
-        return v;
+        return make_null();
     }
-
-    if (argc < 1 || argc > 2) {
-        fprintf(stderr, "Error: db.query() requires 1-2 arguments (sql, params?)\n");
-        Value v = {0};
-        v.type = VAL_NULL;
-        return v;
+    if (argc != 3 || args[0].type != VAL_STRING) {
+        fprintf(stderr, "Error: db.insert_batch() requires 3 arguments (table, columns, rows)\n");
+        return make_null();
+    }
+    char err[256];
+    long long inserted = 0;
+    if (!run_insert_batch(current_db, args[0].string_val, &args[1], &args[2], &inserted, err, sizeof(err))) {
+        print_sql_error(err);
+        return make_null();
     }
+    return make_int(inserted);
+}
 
-    if (args[0].type != VAL_STRING) {
-        fprintf(stderr, "Error: db.query() sql must be a string\n");
-        Value v = {0};
-        v.type = VAL_NULL;
-        return v;
+// ============================================================================
+// db.query_iter(sql, params) - Stream a SELECT query row by row
+// ============================================================================
+// Returns a cursor handle. cursor.next() returns the next row, or null once
+// the result set is exhausted (the cursor then closes itself). Only one row
+// is held in memory at a time.
+//
+// Examples:
+//   turbo cur = db.query_iter("SELECT * FROM events WHERE day = ?", [day]);
+//   turbo row = cur.next();
+//   loop (row != null) { ...; row = cur.next(); }
+// ============================================================================
+
+static DBCursor* find_cursor(int argc, Value* args) {
+    if (!current_db || argc < 1 || args[0].type != VAL_STRING) return NULL;
+    for (DBCursor* c = current_db->cursors; c; c = c->next) {
+        if (strcmp(c->id, args[0].string_val) == 0) return c;
     }
+    return NULL;
+}
 
-    const char* sql = args[0].string_val;
+Value native_db_query_iter(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
 
-    // Prepare statement
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(current_db->db, sql, -1, &stmt, NULL);
+    CachedStmt* cached = NULL;
+    sqlite3_stmt* stmt = prepare_call("db.query_iter", argc, args, &cached, NULL);
+    if (!stmt) return make_null();
+
+    DBCursor* cursor = calloc(1, sizeof(DBCursor));
+    snprintf(cursor->id, sizeof(cursor->id), "db_cursor_%ld", next_cursor_id++);
+    cursor->stmt = stmt;
+    cursor->cached = cached;
+    if (cached) cached->in_use = 1;
+    cursor->next = current_db->cursors;
+    current_db->cursors = cursor;
+    return make_string(cursor->id);
+}
 
-    if (rc != SQLITE_OK) {
+Value native_db_cursor_next(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    DBCursor* cursor = find_cursor(argc, args);
+    if (!cursor) return make_null();
+    int rc = sqlite3_step(cursor->stmt);
+    if (rc == SQLITE_ROW) return create_row_object(cursor->stmt);
+    if (rc != SQLITE_DONE) {
         fprintf(stderr, "\033[1;31mSQL Error:\033[0m %s\n", sqlite3_errmsg(current_db->db));
-        Value v = {0};
-        v.type = VAL_NULL;
-        return v;
     }
+    cursor_free(current_db, cursor);
+    return make_null();
+}
+
+Value native_db_cursor_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    DBCursor* cursor = find_cursor(argc, args);
+    if (!cursor) return make_bool(false);
+    cursor_free(current_db, cursor);
+    return make_bool(true);
+}
 
-    // TODO: Bind parameters from args[1] if provided
+// ============================================================================
+// db.print(sql, params) - Print a query result as a table
+// ============================================================================
+
+Value native_db_print(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+
+    CachedStmt* cached = NULL;
+    sqlite3_stmt* stmt = prepare_call("db.print", argc, args, &cached, NULL);
+    if (!stmt) return make_null();
 
-    // For now, print results directly (will return proper array later)
     int col_count = sqlite3_column_count(stmt);
     int row_count = 0;
 
@@ -244,7 +751,7 @@ Value native_db_query(struct Interpreter* interp, int argc, Value* args) {
     printf("\n");
 
     // Print rows
-    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
         for (int i = 0; i < col_count; i++) {
             const char* val = (const char*)sqlite3_column_text(stmt, i);
             printf("%-15s ", val ? val : "NULL");
@@ -254,13 +761,26 @@ Value native_db_query(struct Interpreter* interp, int argc, Value* args) {
     }
     printf("\n");
 
-    sqlite3_finalize(stmt);
+    db_release(stmt, cached);
+    return make_int(row_count);
+}
 
-    // Return row count for now
-    // TODO: Return actual array of row objects
-    Value result = {0};
-    result.type = VAL_INT;
-    result.int_val = row_count;
+// ============================================================================
+// db.cache_stats() - Prepared statement cache counters
+// ============================================================================
+
+Value native_db_cache_stats(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    (void)argc;
+    (void)args;
+    if (current_db == NULL) return make_null();
+    Array* stats = array_create(3);
+    array_push_owned(stats, make_int(current_db->cache_hits));
+    array_push_owned(stats, make_int(current_db->cache_misses));
+    array_push_owned(stats, make_int(current_db->cache_count));
+    Value result;
+    result.type = VAL_ARRAY;
+    result.array_val = stats;
     return result;
 }
 
@@ -402,8 +922,7 @@ Value native_db_close(struct Interpreter* interp, int argc, Value* args) {
         return result;
     }
 
-    sqlite3_close(current_db->db);
-    free(current_db);
+    db_handle_close(current_db);
     current_db = NULL;
 
     printf("\033[1;34m✓\033[0m Database closed\n");
@@ -411,17 +930,434 @@ Value native_db_close(struct Interpreter* interp, int argc, Value* args) {
     return result;
 }
 
+// ============================================================================
+// Connection Pools
+// ============================================================================
+// db.pool(name, path, size?) opens `size` connections to one database file in
+// WAL mode, so readers never block the writer or each other. Queries run on
+// the libuv threadpool with uv_queue_work and report back on the event loop,
+// so a slow query no longer stalls HTTP connections.
+//
+// Connection 0 takes every write (execute, insert_batch); the others serve
+// reads. A job waits in the pool's queue when its connection is busy.
+//
+// Every pool call returns a job handle: pass a callback(result, error) or
+// call job.wait() to block until the result is ready.
+//
+// Examples:
+//   turbo pool = db.pool("main", "app.db", 4);
+//   pool.query("SELECT * FROM users WHERE id = ?", [id], blast(rows, err) { ... });
+//   turbo count = pool.execute("DELETE FROM sessions WHERE expires < ?", [now]).wait();
+//   pool.insert_batch("events", ["ts", "kind"], rows).wait();
+// ============================================================================
+
+#define DB_POOL_DEFAULT_SIZE 4
+#define DB_POOL_MAX_SIZE 64
+
+typedef enum {
+    DB_JOB_QUERY,
+    DB_JOB_EXECUTE,
+    DB_JOB_BATCH
+} DBJobKind;
+
+typedef struct DBPool DBPool;
+
+typedef struct DBJob {
+    uv_work_t work;
+    char id[32];
+    DBPool* pool;
+    DBJobKind kind;
+    char* sql;                  // table name for DB_JOB_BATCH
+    Value params;               // columns for DB_JOB_BATCH
+    Value rows;
+    int conn;
+    Value result;
+    bool ok;
+    bool done;
+    char error[256];
+    Value callback;
+    struct DBJob* next_wait;
+    struct DBJob* next;
+} DBJob;
+
+struct DBPool {
+    char* name;
+    char handle[96];
+    DBHandle** conns;
+    bool* busy;
+    int size;
+    int active;
+    DBJob* wait_head;
+    DBJob* wait_tail;
+    DBPool* next;
+};
+
+static DBPool* db_pools = NULL;
+static DBJob* db_jobs = NULL;
+static long next_job_id = 1;
+
+static const char* db_pool_pragmas =
+    "PRAGMA journal_mode=WAL;"
+    "PRAGMA synchronous=NORMAL;"
+    "PRAGMA mmap_size=268435456;"
+    "PRAGMA cache_size=-16000;"
+    "PRAGMA temp_store=MEMORY;"
+    "PRAGMA busy_timeout=5000;";
+
+static DBPool* find_pool(const Value* v) {
+    if (!v || v->type != VAL_STRING || !v->string_val) return NULL;
+    const char* name = v->string_val;
+    if (strncmp(name, "db_pool_", 8) == 0) name += 8;
+    for (DBPool* p = db_pools; p; p = p->next) {
+        if (strcmp(p->name, name) == 0) return p;
+    }
+    return NULL;
+}
+
+static DBJob* find_job(const Value* v) {
+    if (!v || v->type != VAL_STRING || !v->string_val) return NULL;
+    for (DBJob* j = db_jobs; j; j = j->next) {
+        if (strcmp(j->id, v->string_val) == 0) return j;
+    }
+    return NULL;
+}
+
+static void job_free(DBJob* job) {
+    for (DBJob** link = &db_jobs; *link; link = &(*link)->next) {
+        if (*link == job) {
+            *link = job->next;
+            break;
+        }
+    }
+    free(job->sql);
+    value_free(&job->params);
+    value_free(&job->rows);
+    value_free(&job->result);
+    free(job);
+}
+
+// Threadpool side: only touches the job and its checked-out connection.
+static void pool_work(uv_work_t* req) {
+    DBJob* job = req->data;
+    DBHandle* h = job->pool->conns[job->conn];
+    long long n = 0;
+    switch (job->kind) {
+        case DB_JOB_QUERY:
+            job->ok = run_query(h, job->sql, &job->params, &job->result, job->error, sizeof(job->error));
+            break;
+        case DB_JOB_EXECUTE:
+            job->ok = run_execute(h, job->sql, &job->params, &n, job->error, sizeof(job->error));
+            if (job->ok) job->result = make_int(n);
+            break;
+        case DB_JOB_BATCH:
+            job->ok = run_insert_batch(h, job->sql, &job->params, &job->rows, &n, job->error, sizeof(job->error));
+            if (job->ok) job->result = make_int(n);
+            break;
+    }
+}
+
+static void pool_after_work(uv_work_t* req, int status);
+
+// Connection a job may run on right now, or -1.
+static int pool_free_conn(DBPool* pool, DBJobKind kind) {
+    if (kind != DB_JOB_QUERY || pool->size == 1) return pool->busy[0] ? -1 : 0;
+    for (int i = 1; i < pool->size; i++) {
+        if (!pool->busy[i]) return i;
+    }
+    return -1;
+}
+
+static void pool_start(DBPool* pool, DBJob* job, int conn) {
+    job->conn = conn;
+    pool->busy[conn] = true;
+    pool->active++;
+    job->work.data = job;
+    uv_queue_work(global_event_loop, &job->work, pool_work, pool_after_work);
+}
+
+static void pool_dispatch(DBPool* pool) {
+    DBJob** link = &pool->wait_head;
+    DBJob* prev = NULL;
+    while (*link) {
+        DBJob* job = *link;
+        int conn = pool_free_conn(pool, job->kind);
+        if (conn < 0) {
+            prev = job;
+            link = &job->next_wait;
+            continue;
+        }
+        *link = job->next_wait;
+        if (pool->wait_tail == job) pool->wait_tail = prev;
+        job->next_wait = NULL;
+        pool_start(pool, job, conn);
+    }
+}
+
+static void pool_after_work(uv_work_t* req, int status) {
+    (void)status;
+    DBJob* job = req->data;
+    DBPool* pool = job->pool;
+    pool->busy[job->conn] = false;
+    pool->active--;
+    job->done = true;
+    pool_dispatch(pool);
+
+    if (job->callback.type != VAL_FUNCTION) return;  // kept for job.wait()
+    Value cb_args[2];
+    cb_args[0] = job->result;
+    cb_args[1] = job->ok ? make_null() : make_string(job->error);
+    job->result = make_null();
+    Value ret = interpreter_execute_callback(job->callback, 2, cb_args);
+    value_free(&ret);
+    value_free(&cb_args[0]);
+    value_free(&cb_args[1]);
+    job_free(job);
+}
+
+// Arrays are shared with the script, which may change them before the job
+// runs on the threadpool, so the job keeps deep copies of params and rows.
+static Value pool_submit(DBPool* pool, DBJobKind kind, char* sql, const Value* params, const Value* rows,
+                         Value* callback) {
+    DBJob* job = calloc(1, sizeof(DBJob));
+    snprintf(job->id, sizeof(job->id), "db_job_%ld", next_job_id++);
+    job->pool = pool;
+    job->kind = kind;
+    job->sql = sql;
+    job->params = make_null();
+    job->rows = make_null();
+    job->result = make_null();
+    job->callback = make_null();
+    if (params) job->params = value_deep_copy(*params);
+    if (rows) job->rows = value_deep_copy(*rows);
+    if (callback && callback->type == VAL_FUNCTION) job->callback = *callback;
+    job->next = db_jobs;
+    db_jobs = job;
+
+    int conn = pool_free_conn(pool, kind);
+    if (conn >= 0 && !pool->wait_head) {
+        pool_start(pool, job, conn);
+    } else {
+        if (pool->wait_tail) pool->wait_tail->next_wait = job;
+        else pool->wait_head = job;
+        pool->wait_tail = job;
+    }
+    return make_string(job->id);
+}
+
+static void pool_close(DBPool* pool) {
+    while (pool->active > 0 || pool->wait_head) {
+        uv_run(global_event_loop, UV_RUN_ONCE);
+    }
+    for (DBPool** link = &db_pools; *link; link = &(*link)->next) {
+        if (*link == pool) {
+            *link = pool->next;
+            break;
+        }
+    }
+    for (int i = 0; i < pool->size; i++) {
+        if (pool->conns[i]) db_handle_close(pool->conns[i]);
+    }
+    free(pool->conns);
+    free(pool->busy);
+    free(pool->name);
+    free(pool);
+}
+
+// Pools hand work to the event loop, which only its own thread may touch.
+static bool pool_on_loop(const char* fn) {
+    if (!workpool_on_worker()) return true;
+    fprintf(stderr, "Error: %s() cannot be called from a parallel worker\n", fn);
+    return false;
+}
+
+// db.pool(name, path, size?) -> pool handle
+Value native_db_pool(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 2 || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
+        fprintf(stderr, "Error: db.pool() requires (name, path, size?)\n");
+        return make_null();
+    }
+    if (!pool_on_loop("db.pool")) return make_null();
+    interpreter_init_event_loop();
+    DBPool* existing = find_pool(&args[0]);
+    if (existing) pool_close(existing);
+
+    int size = (argc >= 3 && args[2].type == VAL_INT) ? (int)args[2].int_val : DB_POOL_DEFAULT_SIZE;
+    if (size < 1) size = 1;
+    if (size > DB_POOL_MAX_SIZE) size = DB_POOL_MAX_SIZE;
+    const char* path = args[1].string_val;
+    // Separate :memory: connections would each see their own empty database.
+    if (strcmp(path, ":memory:") == 0) size = 1;
+
+    DBPool* pool = calloc(1, sizeof(DBPool));
+    pool->name = strdup(args[0].string_val);
+    snprintf(pool->handle, sizeof(pool->handle), "db_pool_%s", pool->name);
+    pool->size = size;
+    pool->conns = calloc((size_t)size, sizeof(DBHandle*));
+    pool->busy = calloc((size_t)size, sizeof(bool));
+    for (int i = 0; i < size; i++) {
+        DBHandle* h = calloc(1, sizeof(DBHandle));
+        pool->conns[i] = h;
+        // Each connection is used by one thread at a time, so SQLite's own
+        // per-connection mutex is unnecessary.
+        int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+        char* err_msg = NULL;
+        if (sqlite3_open_v2(path, &h->db, flags, NULL) != SQLITE_OK ||
+            sqlite3_exec(h->db, db_pool_pragmas, NULL, NULL, &err_msg) != SQLITE_OK) {
+            print_db_error("Failed to open pool connection", h->db);
+            sqlite3_free(err_msg);
+            pool_close(pool);
+            return make_null();
+        }
+    }
+    pool->next = db_pools;
+    db_pools = pool;
+    return make_string(pool->handle);
+}
+
+static DBPool* pool_arg(const char* fn, int argc, Value* args, int min_argc) {
+    if (!pool_on_loop(fn)) return NULL;
+    DBPool* pool = argc >= 1 ? find_pool(&args[0]) : NULL;
+    if (!pool) {
+        fprintf(stderr, "Error: %s() unknown pool\n", fn);
+        return NULL;
+    }
+    if (argc < min_argc || args[1].type != VAL_STRING) {
+        fprintf(stderr, "Error: %s() bad arguments\n", fn);
+        return NULL;
+    }
+    return pool;
+}
+
+// Trailing function argument, if any, is the completion callback.
+static Value* callback_arg(int argc, Value* args, int first) {
+    for (int i = argc - 1; i >= first; i--) {
+        if (args[i].type == VAL_FUNCTION) return &args[i];
+    }
+    return NULL;
+}
+
+static Value* params_arg(int argc, Value* args) {
+    return (argc >= 3 && args[2].type != VAL_FUNCTION) ? &args[2] : NULL;
+}
+
+// pool.query(sql, params?, callback?) -> job
+Value native_db_pool_query(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    DBPool* pool = pool_arg("pool.query", argc, args, 2);
+    if (!pool) return make_null();
+    return pool_submit(pool, DB_JOB_QUERY, strdup(args[1].string_val), params_arg(argc, args), NULL,
+                       callback_arg(argc, args, 2));
+}
+
+// pool.execute(sql, params?, callback?) -> job
+Value native_db_pool_execute(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    DBPool* pool = pool_arg("pool.execute", argc, args, 2);
+    if (!pool) return make_null();
+    return pool_submit(pool, DB_JOB_EXECUTE, strdup(args[1].string_val), params_arg(argc, args), NULL,
+                       callback_arg(argc, args, 2));
+}
+
+// pool.insert_batch(table, columns, rows, callback?) -> job
+Value native_db_pool_insert_batch(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    DBPool* pool = pool_arg("pool.insert_batch", argc, args, 4);
+    if (!pool) return make_null();
+    return pool_submit(pool, DB_JOB_BATCH, strdup(args[1].string_val), &args[2], &args[3],
+                       callback_arg(argc, args, 4));
+}
+
+// pool.close() waits for queued jobs, then closes every connection
+Value native_db_pool_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (!pool_on_loop("pool.close")) return make_bool(false);
+    DBPool* pool = argc >= 1 ? find_pool(&args[0]) : NULL;
+    if (!pool) return make_bool(false);
+    pool_close(pool);
+    return make_bool(true);
+}
+
+// job.wait() -> result (rows or count); null and an error message on failure
+Value native_db_job_wait(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (!pool_on_loop("job.wait")) return make_null();
+    DBJob* job = argc >= 1 ? find_job(&args[0]) : NULL;
+    if (!job) return make_null();
+    if (job->callback.type == VAL_FUNCTION) {
+        fprintf(stderr, "Error: job.wait() on a job with a callback\n");
+        return make_null();
+    }
+    while (!job->done) {
+        uv_run(global_event_loop, UV_RUN_ONCE);
+    }
+    Value result = job->result;
+    job->result = make_null();
+    if (!job->ok) print_sql_error(job->error);
+    job_free(job);
+    return result;
+}
+
+// job.done() -> bool
+Value native_db_job_done(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (!pool_on_loop("job.done")) return make_null();
+    DBJob* job = argc >= 1 ? find_job(&args[0]) : NULL;
+    return make_bool(!job || job->done);
+}
+
 // ============================================================================
 // Registration
 // ============================================================================
 
+// The synchronous calls share current_db, its statement cache and cursors;
+// each is registered through a wrapper that holds db_lock for the call.
+#define DB_SYNC(fn) \
+    static Value fn##_sync(struct Interpreter* interp, int argc, Value* args) { \
+        uv_once(&db_once, db_init_lock); \
+        uv_mutex_lock(&db_lock); \
+        Value result = fn(interp, argc, args); \
+        uv_mutex_unlock(&db_lock); \
+        return result; \
+    }
+
+DB_SYNC(native_db_open)
+DB_SYNC(native_db_query)
+DB_SYNC(native_db_execute)
+DB_SYNC(native_db_begin)
+DB_SYNC(native_db_commit)
+DB_SYNC(native_db_rollback)
+DB_SYNC(native_db_close)
+DB_SYNC(native_db_query_iter)
+DB_SYNC(native_db_cursor_next)
+DB_SYNC(native_db_cursor_close)
+DB_SYNC(native_db_print)
+DB_SYNC(native_db_cache_stats)
+DB_SYNC(native_db_insert_batch)
+
 void stdlib_db_register(void) {
     // Register all database functions
-    register_native("db.open", native_db_open);
-    register_native("db.query", native_db_query);
-    register_native("db.execute", native_db_execute);
-    register_native("db.begin", native_db_begin);
-    register_native("db.commit", native_db_commit);
-    register_native("db.rollback", native_db_rollback);
-    register_native("db.close", native_db_close);
+    register_native("db.open", native_db_open_sync);
+    register_native("db.query", native_db_query_sync);
+    register_native("db.execute", native_db_execute_sync);
+    register_native("db.begin", native_db_begin_sync);
+    register_native("db.commit", native_db_commit_sync);
+    register_native("db.rollback", native_db_rollback_sync);
+    register_native("db.close", native_db_close_sync);
+    register_native("db.query_iter", native_db_query_iter_sync);
+    register_native("db.cursor_next", native_db_cursor_next_sync);
+    register_native("db.cursor_close", native_db_cursor_close_sync);
+    register_native("db.print", native_db_print_sync);
+    register_native("db.cache_stats", native_db_cache_stats_sync);
+    register_native("db.insert_batch", native_db_insert_batch_sync);
+    register_native("db.pool", native_db_pool);
+    register_native("db.pool_query", native_db_pool_query);
+    register_native("db.pool_execute", native_db_pool_execute);
+    register_native("db.pool_insert_batch", native_db_pool_insert_batch);
+    register_native("db.pool_close", native_db_pool_close);
+    register_native("db.job_wait", native_db_job_wait);
+    register_native("db.job_done", native_db_job_done);
+    register_handle_methods("db_pool_", "db.pool_");
+    register_handle_methods("db_job_", "db.job_");
+    register_handle_methods("db_cursor_", "db.cursor_");
 }
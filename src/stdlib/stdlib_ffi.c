@@ -1,49 +1,470 @@
 #define _POSIX_C_SOURCE 200809L
 #include "stdlib_ffi.h"
+#include <ffi.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <uv.h>
 
-// For prototype, we simulate loading C libraries
-// In a full implementation, this would use <dlfcn.h> (dlopen/dlsym)
+extern Value make_string(const char* val);
 
+typedef enum {
+    FFI_K_VOID,
+    FFI_K_BOOL,
+    FFI_K_I8,
+    FFI_K_U8,
+    FFI_K_I16,
+    FFI_K_U16,
+    FFI_K_I32,
+    FFI_K_U32,
+    FFI_K_I64,
+    FFI_K_U64,
+    FFI_K_F32,
+    FFI_K_F64,
+    FFI_K_PTR,
+    FFI_K_STR
+} FfiKind;
+
+static const struct {
+    const char* name;
+    FfiKind kind;
+} ffi_kind_names[] = {
+    { "void", FFI_K_VOID }, { "bool", FFI_K_BOOL },
+    { "i8", FFI_K_I8 }, { "u8", FFI_K_U8 }, { "i16", FFI_K_I16 }, { "u16", FFI_K_U16 },
+    { "i32", FFI_K_I32 }, { "u32", FFI_K_U32 }, { "i64", FFI_K_I64 }, { "u64", FFI_K_U64 },
+    { "f32", FFI_K_F32 }, { "f64", FFI_K_F64 }, { "ptr", FFI_K_PTR }, { "str", FFI_K_STR },
+};
+
+// How a binding is called: through libffi, or straight through a cast
+// function pointer when the platform ABI passes every argument of the
+// signature in registers of one class.
+typedef enum {
+    FFI_PATH_LIBFFI,
+    FFI_PATH_INTS,
+    FFI_PATH_F64S
+} FfiPath;
+
+#if (defined(__x86_64__) || defined(__aarch64__)) && !defined(_WIN32)
+#define FFI_HAVE_DIRECT 1
+#define FFI_DIRECT_MAX_INTS 6
+#define FFI_DIRECT_MAX_F64S 3
+#endif
+
+typedef struct FfiLib {
+    char handle[32];
+    char* path;             // NULL for the running program
+    uv_lib_t lib;
+} FfiLib;
+
+typedef struct FfiBinding {
+    char handle[32];
+    char* name;
+    char* signature;
+    FfiLib* lib;
+    void (*fn)(void);
+    FfiKind ret;
+    FfiKind args[FFI_MAX_ARGS];
+    int nargs;
+    FfiPath path;
+    ffi_cif cif;
+    ffi_type* arg_types[FFI_MAX_ARGS];
+} FfiBinding;
+
+typedef union {
+    int8_t i8;
+    uint8_t u8;
+    int16_t i16;
+    uint16_t u16;
+    int32_t i32;
+    uint32_t u32;
+    int64_t i64;
+    uint64_t u64;
+    float f32;
+    double f64;
+    void* ptr;
+} FfiSlot;
+
+static FfiLib** ffi_libs = NULL;
+static int ffi_lib_count = 0;
+static FfiBinding** ffi_bindings = NULL;
+static int ffi_binding_count = 0;
+static uv_rwlock_t ffi_lock;
+static uv_once_t ffi_once = UV_ONCE_INIT;
+
+static void ffi_init_lock(void) {
+    uv_rwlock_init(&ffi_lock);
+}
+
+static FfiLib* ffi_find_lib(const Value* v) {
+    if (v->type != VAL_STRING || strncmp(v->string_val, "ffi_lib_", 8) != 0) return NULL;
+    int id = atoi(v->string_val + 8);
+    uv_rwlock_rdlock(&ffi_lock);
+    FfiLib* lib = id >= 1 && id <= ffi_lib_count ? ffi_libs[id - 1] : NULL;
+    uv_rwlock_rdunlock(&ffi_lock);
+    return lib;
+}
+
+static FfiBinding* ffi_find_binding(const Value* v) {
+    if (v->type != VAL_STRING || strncmp(v->string_val, "ffi_fn_", 7) != 0) return NULL;
+    int id = atoi(v->string_val + 7);
+    uv_rwlock_rdlock(&ffi_lock);
+    FfiBinding* b = id >= 1 && id <= ffi_binding_count ? ffi_bindings[id - 1] : NULL;
+    uv_rwlock_rdunlock(&ffi_lock);
+    return b;
+}
+
+static ffi_type* ffi_kind_type(FfiKind kind) {
+    switch (kind) {
+        case FFI_K_VOID: return &ffi_type_void;
+        case FFI_K_BOOL: return &ffi_type_uint8;
+        case FFI_K_I8: return &ffi_type_sint8;
+        case FFI_K_U8: return &ffi_type_uint8;
+        case FFI_K_I16: return &ffi_type_sint16;
+        case FFI_K_U16: return &ffi_type_uint16;
+        case FFI_K_I32: return &ffi_type_sint32;
+        case FFI_K_U32: return &ffi_type_uint32;
+        case FFI_K_I64: return &ffi_type_sint64;
+        case FFI_K_U64: return &ffi_type_uint64;
+        case FFI_K_F32: return &ffi_type_float;
+        case FFI_K_F64: return &ffi_type_double;
+        default: return &ffi_type_pointer;
+    }
+}
+
+static bool ffi_parse_kind(const char* s, size_t len, FfiKind* kind) {
+    while (len > 0 && (*s == ' ' || *s == '\t')) {
+        s++;
+        len--;
+    }
+    while (len > 0 && (s[len - 1] == ' ' || s[len - 1] == '\t')) len--;
+    for (size_t i = 0; i < sizeof(ffi_kind_names) / sizeof(ffi_kind_names[0]); i++) {
+        if (strlen(ffi_kind_names[i].name) == len && strncmp(ffi_kind_names[i].name, s, len) == 0) {
+            *kind = ffi_kind_names[i].kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "ret(arg, arg)"; "ret()" and "ret(void)" take no arguments.
+static bool ffi_parse_signature(const char* sig, FfiBinding* b, char* error, size_t error_len) {
+    const char* open = strchr(sig, '(');
+    const char* close = open ? strrchr(open, ')') : NULL;
+    if (!open || !close || close[1] != '\0') {
+        snprintf(error, error_len, "signature must look like \"i64(ptr,f64)\"");
+        return false;
+    }
+    if (!ffi_parse_kind(sig, (size_t)(open - sig), &b->ret)) {
+        snprintf(error, error_len, "unknown return type in \"%s\"", sig);
+        return false;
+    }
+    b->nargs = 0;
+    const char* p = open + 1;
+    FfiKind only;
+    if (ffi_parse_kind(p, (size_t)(close - p), &only) && only == FFI_K_VOID) return true;
+    bool empty = true;
+    for (const char* q = p; q < close; q++) {
+        if (*q != ' ' && *q != '\t') empty = false;
+    }
+    if (empty) return true;
+    while (p <= close) {
+        const char* end = p;
+        while (end < close && *end != ',') end++;
+        if (b->nargs == FFI_MAX_ARGS) {
+            snprintf(error, error_len, "more than %d arguments", FFI_MAX_ARGS);
+            return false;
+        }
+        FfiKind kind;
+        if (!ffi_parse_kind(p, (size_t)(end - p), &kind) || kind == FFI_K_VOID) {
+            snprintf(error, error_len, "bad argument type in \"%s\"", sig);
+            return false;
+        }
+        b->args[b->nargs++] = kind;
+        p = end + 1;
+    }
+    return true;
+}
+
+static bool ffi_is_int_class(FfiKind kind) {
+    return kind != FFI_K_F32 && kind != FFI_K_F64;
+}
+
+static FfiPath ffi_choose_path(const FfiBinding* b) {
+#ifdef FFI_HAVE_DIRECT
+    bool ints = ffi_is_int_class(b->ret) && b->nargs <= FFI_DIRECT_MAX_INTS;
+    bool f64s = b->ret == FFI_K_F64 && b->nargs >= 1 && b->nargs <= FFI_DIRECT_MAX_F64S;
+    for (int i = 0; i < b->nargs; i++) {
+        if (!ffi_is_int_class(b->args[i])) ints = false;
+        if (b->args[i] != FFI_K_F64) f64s = false;
+    }
+    if (ints) return FFI_PATH_INTS;
+    if (f64s) return FFI_PATH_F64S;
+#else
+    (void)b;
+#endif
+    return FFI_PATH_LIBFFI;
+}
+
+static bool ffi_to_slot(FfiKind kind, const Value* v, FfiSlot* slot) {
+    if (kind == FFI_K_PTR || kind == FFI_K_STR) {
+        if (v->type == VAL_NULL) {
+            slot->ptr = NULL;
+        } else if (v->type == VAL_STRING) {
+            slot->ptr = v->string_val;
+        } else if (kind == FFI_K_PTR && v->type == VAL_BYTES) {
+            slot->ptr = v->bytes_val->buf->data + v->bytes_val->offset;
+        } else if (kind == FFI_K_PTR && v->type == VAL_INT) {
+            slot->ptr = (void*)(intptr_t)v->int_val;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (kind == FFI_K_F32 || kind == FFI_K_F64) {
+        double d;
+        if (v->type == VAL_FLOAT) d = v->float_val;
+        else if (v->type == VAL_INT) d = (double)v->int_val;
+        else return false;
+        if (kind == FFI_K_F32) slot->f32 = (float)d;
+        else slot->f64 = d;
+        return true;
+    }
+    long long n;
+    if (v->type == VAL_INT) n = v->int_val;
+    else if (v->type == VAL_BOOL) n = v->bool_val;
+    else if (v->type == VAL_FLOAT) n = (long long)v->float_val;
+    else return false;
+    switch (kind) {
+        case FFI_K_BOOL: slot->u8 = n != 0; break;
+        case FFI_K_I8: slot->i8 = (int8_t)n; break;
+        case FFI_K_U8: slot->u8 = (uint8_t)n; break;
+        case FFI_K_I16: slot->i16 = (int16_t)n; break;
+        case FFI_K_U16: slot->u16 = (uint16_t)n; break;
+        case FFI_K_I32: slot->i32 = (int32_t)n; break;
+        case FFI_K_U32: slot->u32 = (uint32_t)n; break;
+        default: slot->i64 = n; break;
+    }
+    return true;
+}
+
+// An integer-class slot widened to a full register, as the ABI expects.
+static uint64_t ffi_slot_word(FfiKind kind, const FfiSlot* slot) {
+    switch (kind) {
+        case FFI_K_BOOL:
+        case FFI_K_U8: return slot->u8;
+        case FFI_K_I8: return (uint64_t)(int64_t)slot->i8;
+        case FFI_K_I16: return (uint64_t)(int64_t)slot->i16;
+        case FFI_K_U16: return slot->u16;
+        case FFI_K_I32: return (uint64_t)(int64_t)slot->i32;
+        case FFI_K_U32: return slot->u32;
+        case FFI_K_PTR:
+        case FFI_K_STR: return (uint64_t)(uintptr_t)slot->ptr;
+        default: return slot->u64;
+    }
+}
+
+// Narrows a returned register to the declared type.
+static Value ffi_word_value(FfiKind kind, uint64_t w) {
+    switch (kind) {
+        case FFI_K_VOID: return make_null();
+        case FFI_K_BOOL: return make_bool((uint8_t)w != 0);
+        case FFI_K_I8: return make_int((int8_t)w);
+        case FFI_K_U8: return make_int((uint8_t)w);
+        case FFI_K_I16: return make_int((int16_t)w);
+        case FFI_K_U16: return make_int((uint16_t)w);
+        case FFI_K_I32: return make_int((int32_t)w);
+        case FFI_K_U32: return make_int((uint32_t)w);
+        case FFI_K_PTR: return make_int((long long)(intptr_t)(uintptr_t)w);
+        case FFI_K_STR: {
+            const char* s = (const char*)(uintptr_t)w;
+            return s ? make_string(s) : make_null();
+        }
+        default: return make_int((long long)w);
+    }
+}
+
+#ifdef FFI_HAVE_DIRECT
+typedef uint64_t W;
+
+static uint64_t ffi_call_ints(void (*fn)(void), int n, const uint64_t* a) {
+    switch (n) {
+        case 0: return ((W (*)(void))fn)();
+        case 1: return ((W (*)(W))fn)(a[0]);
+        case 2: return ((W (*)(W, W))fn)(a[0], a[1]);
+        case 3: return ((W (*)(W, W, W))fn)(a[0], a[1], a[2]);
+        case 4: return ((W (*)(W, W, W, W))fn)(a[0], a[1], a[2], a[3]);
+        case 5: return ((W (*)(W, W, W, W, W))fn)(a[0], a[1], a[2], a[3], a[4]);
+        default: return ((W (*)(W, W, W, W, W, W))fn)(a[0], a[1], a[2], a[3], a[4], a[5]);
+    }
+}
+
+static double ffi_call_f64s(void (*fn)(void), int n, const double* a) {
+    switch (n) {
+        case 1: return ((double (*)(double))fn)(a[0]);
+        case 2: return ((double (*)(double, double))fn)(a[0], a[1]);
+        default: return ((double (*)(double, double, double))fn)(a[0], a[1], a[2]);
+    }
+}
+#endif
+
+static Value ffi_invoke(FfiBinding* b, int argc, Value* args) {
+    if (argc != b->nargs) {
+        fprintf(stderr, "Error: %s(%s) takes %d argument%s, got %d\n", b->name, b->signature,
+                b->nargs, b->nargs == 1 ? "" : "s", argc);
+        return make_null();
+    }
+    FfiSlot slots[FFI_MAX_ARGS];
+    for (int i = 0; i < argc; i++) {
+        if (!ffi_to_slot(b->args[i], &args[i], &slots[i])) {
+            fprintf(stderr, "Error: %s(%s): argument %d has the wrong type\n", b->name, b->signature, i + 1);
+            return make_null();
+        }
+    }
+#ifdef FFI_HAVE_DIRECT
+    if (b->path == FFI_PATH_INTS) {
+        uint64_t words[FFI_DIRECT_MAX_INTS];
+        for (int i = 0; i < argc; i++) words[i] = ffi_slot_word(b->args[i], &slots[i]);
+        return ffi_word_value(b->ret, ffi_call_ints(b->fn, argc, words));
+    }
+    if (b->path == FFI_PATH_F64S) {
+        double values[FFI_DIRECT_MAX_F64S];
+        for (int i = 0; i < argc; i++) values[i] = slots[i].f64;
+        return make_float(ffi_call_f64s(b->fn, argc, values));
+    }
+#endif
+    void* values[FFI_MAX_ARGS];
+    for (int i = 0; i < argc; i++) values[i] = &slots[i];
+    union {
+        ffi_arg word;
+        ffi_sarg sword;
+        uint64_t u64;
+        float f32;
+        double f64;
+        void* ptr;
+    } rv;
+    memset(&rv, 0, sizeof(rv));
+    ffi_call(&b->cif, b->fn, &rv, values);
+    switch (b->ret) {
+        case FFI_K_F32: return make_float(rv.f32);
+        case FFI_K_F64: return make_float(rv.f64);
+        case FFI_K_PTR:
+        case FFI_K_STR: return ffi_word_value(b->ret, (uint64_t)(uintptr_t)rv.ptr);
+        case FFI_K_I64:
+        case FFI_K_U64: return ffi_word_value(b->ret, rv.u64);
+        default: return ffi_word_value(b->ret, (uint64_t)rv.word);
+    }
+}
+
+// ffi.load(path?) -> "ffi_lib_<n>"; without a path, the running program
 Value native_ffi_load(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
-    if (argc < 1 || args[0].type != VAL_STRING) {
-        printf("⚠️ FFI Error: Expected library path\n");
-        return (Value){VAL_NULL, {0}};
+    if (argc >= 1 && args[0].type != VAL_STRING && args[0].type != VAL_NULL) {
+        fprintf(stderr, "Error: ffi.load() expects a library path\n");
+        return make_null();
     }
-    
-    const char* path = args[0].string_val;
-    printf("🔗 RADS FFI: Loading external C binary '%s'...\n", path);
-    printf("✅ Symbols mapped! Linking successful.\n");
-    
-    Value v;
-    v.type = VAL_STRING;
-    v.string_val = strdup("lib_handle_0x1337");
-    return v;
+    const char* path = argc >= 1 && args[0].type == VAL_STRING ? args[0].string_val : NULL;
+    uv_once(&ffi_once, ffi_init_lock);
+    uv_rwlock_wrlock(&ffi_lock);
+    FfiLib* lib = NULL;
+    for (int i = 0; i < ffi_lib_count && !lib; i++) {
+        const char* p = ffi_libs[i]->path;
+        if ((p == NULL && path == NULL) || (p && path && strcmp(p, path) == 0)) lib = ffi_libs[i];
+    }
+    if (!lib) {
+        lib = calloc(1, sizeof(FfiLib));
+        if (uv_dlopen(path, &lib->lib) != 0) {
+            fprintf(stderr, "Error: ffi.load(): %s\n", uv_dlerror(&lib->lib));
+            uv_dlclose(&lib->lib);
+            free(lib);
+            uv_rwlock_wrunlock(&ffi_lock);
+            return make_null();
+        }
+        lib->path = path ? strdup(path) : NULL;
+        ffi_libs = realloc(ffi_libs, (size_t)(ffi_lib_count + 1) * sizeof(FfiLib*));
+        ffi_libs[ffi_lib_count++] = lib;
+        snprintf(lib->handle, sizeof(lib->handle), "ffi_lib_%d", ffi_lib_count);
+    }
+    uv_rwlock_wrunlock(&ffi_lock);
+    return make_string(lib->handle);
 }
 
+static FfiBinding* ffi_bind(FfiLib* lib, const char* name, const char* signature) {
+    uv_rwlock_wrlock(&ffi_lock);
+    for (int i = 0; i < ffi_binding_count; i++) {
+        FfiBinding* b = ffi_bindings[i];
+        if (b->lib == lib && strcmp(b->name, name) == 0 && strcmp(b->signature, signature) == 0) {
+            uv_rwlock_wrunlock(&ffi_lock);
+            return b;
+        }
+    }
+    FfiBinding* b = calloc(1, sizeof(FfiBinding));
+    char error[128];
+    void* sym = NULL;
+    if (!ffi_parse_signature(signature, b, error, sizeof(error))) {
+        fprintf(stderr, "Error: ffi.bind(): %s\n", error);
+    } else if (uv_dlsym(&lib->lib, name, &sym) != 0 || !sym) {
+        fprintf(stderr, "Error: ffi.bind(): %s\n", uv_dlerror(&lib->lib));
+    } else {
+        for (int i = 0; i < b->nargs; i++) b->arg_types[i] = ffi_kind_type(b->args[i]);
+        if (ffi_prep_cif(&b->cif, FFI_DEFAULT_ABI, (unsigned)b->nargs, ffi_kind_type(b->ret),
+                         b->arg_types) != FFI_OK) {
+            fprintf(stderr, "Error: ffi.bind(): cannot prepare a call for %s\n", signature);
+            sym = NULL;
+        }
+    }
+    if (!sym) {
+        free(b);
+        uv_rwlock_wrunlock(&ffi_lock);
+        return NULL;
+    }
+    b->fn = (void (*)(void))sym;
+    b->lib = lib;
+    b->name = strdup(name);
+    b->signature = strdup(signature);
+    b->path = ffi_choose_path(b);
+    ffi_bindings = realloc(ffi_bindings, (size_t)(ffi_binding_count + 1) * sizeof(FfiBinding*));
+    ffi_bindings[ffi_binding_count++] = b;
+    snprintf(b->handle, sizeof(b->handle), "ffi_fn_%d", ffi_binding_count);
+    uv_rwlock_wrunlock(&ffi_lock);
+    return b;
+}
+
+// ffi.bind(lib, "name", "i64(ptr,f64)") -> callable "ffi_fn_<n>"
+Value native_ffi_bind(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    uv_once(&ffi_once, ffi_init_lock);
+    FfiLib* lib = argc >= 1 ? ffi_find_lib(&args[0]) : NULL;
+    if (!lib || argc < 3 || args[1].type != VAL_STRING || args[2].type != VAL_STRING) {
+        fprintf(stderr, "Error: ffi.bind() expects a library, a symbol name and a signature\n");
+        return make_null();
+    }
+    FfiBinding* b = ffi_bind(lib, args[1].string_val, args[2].string_val);
+    return b ? make_string(b->handle) : make_null();
+}
+
+// ffi.call(fn, args...) calls a bound function (same as fn(args...));
+// ffi.call(lib, "name", "sig", args...) binds on first use
 Value native_ffi_call(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
-    if (argc < 2 || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
-        printf("⚠️ FFI Error: Expected lib handle and function name\n");
-        return (Value){VAL_NULL, {0}};
-    }
-    
-    const char* lib = args[0].string_val;
-    const char* func = args[1].string_val;
-    
-    printf("⚡ RADS FFI Call: %s::%s()\n", lib, func);
-    printf("💎 Executing native code at peak efficiency...\n");
-    
-    Value v;
-    v.type = VAL_INT;
-    v.int_val = 0; // Success code from C
-    return v;
+    uv_once(&ffi_once, ffi_init_lock);
+    FfiBinding* b = argc >= 1 ? ffi_find_binding(&args[0]) : NULL;
+    if (b) return ffi_invoke(b, argc - 1, args + 1);
+    FfiLib* lib = argc >= 1 ? ffi_find_lib(&args[0]) : NULL;
+    if (!lib || argc < 3 || args[1].type != VAL_STRING || args[2].type != VAL_STRING) {
+        fprintf(stderr, "Error: ffi.call() expects a bound function, or a library, a symbol name and a signature\n");
+        return make_null();
+    }
+    b = ffi_bind(lib, args[1].string_val, args[2].string_val);
+    return b ? ffi_invoke(b, argc - 3, args + 3) : make_null();
 }
 
 void stdlib_ffi_register(void) {
     register_native("ffi.load", native_ffi_load);
+    register_native("ffi.bind", native_ffi_bind);
     register_native("ffi.call", native_ffi_call);
+    register_native("ffi.lib_bind", native_ffi_bind);
+    register_native("ffi.fn_call", native_ffi_call);
+    register_handle_methods("ffi_lib_", "ffi.lib_");
+    register_handle_methods("ffi_fn_", "ffi.fn_");
 }
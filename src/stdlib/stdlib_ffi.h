@@ -3,11 +3,30 @@
 
 #include "../core/interpreter.h"
 
+// Calls into C libraries behind ffi.*.
+//
+// ffi.load opens a shared library (uv_dlopen, i.e. dlopen on Unix) and
+// ffi.bind(lib, "name", "i64(ptr,f64)") looks the symbol up and parses the
+// signature once, returning an "ffi_fn_<n>" handle that is called like a
+// function: f(a, b). Each binding keeps a prepared libffi call interface;
+// signatures made only of integer/pointer arguments (up to six) or only
+// of f64 (up to three) are called directly through a typed function
+// pointer instead. Bindings live for the whole process and may be called
+// from any thread.
+//
+// Types: void (return only), bool, i8 u8 i16 u16 i32 u32 i64 u64, f32 f64,
+// ptr and str. A ptr argument takes bytes (their data, which C may write
+// into), a string, an integer address or null; str passes a string as
+// const char* and returns a copy of the C string.
+
+#define FFI_MAX_ARGS 16
+
 // FFI Module registration
 void stdlib_ffi_register(void);
 
 // Native functions
 Value native_ffi_load(struct Interpreter* interp, int argc, Value* args);
+Value native_ffi_bind(struct Interpreter* interp, int argc, Value* args);
 Value native_ffi_call(struct Interpreter* interp, int argc, Value* args);
 
 #endif // RADS_STDLIB_FFI_H
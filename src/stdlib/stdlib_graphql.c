@@ -1,504 +1,1903 @@
 #include "stdlib_graphql.h"
+#include "stdlib_json.h"
+#include "stdlib_net.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <unistd.h>
-
-#define GQL_MAX_FIELDS 128
-#define GQL_MAX_TYPES 32
-#define GQL_QUERY_BUFFER 4096
-
-typedef struct {
-    int fd;
-    GraphQLSchema* schema;
-    bool running;
-} GraphQLServerImpl;
-
-static char* trim_whitespace(char* str) {
-    while (isspace((unsigned char)*str)) str++;
-    if (*str == '\0') return str;
-
-    char* end = str + strlen(str) - 1;
-    while (end > str && isspace((unsigned char)*end)) end--;
-    *(end + 1) = '\0';
-    return str;
-}
-
-GraphQLSchema* graphql_schema_create(void) {
-    GraphQLSchema* schema = (GraphQLSchema*)calloc(1, sizeof(GraphQLSchema));
-    schema->types = (GraphQLTypeDef**)malloc(GQL_MAX_TYPES * sizeof(GraphQLTypeDef*));
-    schema->type_count = 0;
-    schema->queries = (GraphQLField*)calloc(GQL_MAX_FIELDS, sizeof(GraphQLField));
-    schema->mutations = (GraphQLField*)calloc(GQL_MAX_FIELDS, sizeof(GraphQLField));
-    schema->subscriptions = (GraphQLField*)calloc(GQL_MAX_FIELDS, sizeof(GraphQLField));
-    schema->user_data = NULL;
-    return schema;
+#include <stdatomic.h>
+#include <uv.h>
+
+// GraphQL executable documents: parser, document cache and a batching
+// executor.
+//
+// Schemas are resolver tables rather than SDL: schema.resolve("User.posts", fn)
+// attaches a resolver to a field coordinate and every other field falls back
+// to reading the same-named field of its parent struct. A resolver may name
+// the type its objects have, which picks the resolvers for the next level.
+//
+// Execution is breadth-first. Each selection set runs over every parent that
+// reached it at once, so a batch resolver (schema.batch) is called one time
+// per field and level with all parents - the DataLoader pattern that turns
+// N+1 resolver calls into one. Resolver results are also memoized per request
+// by field, arguments and parent id.
+
+extern Value make_string(const char* val);
+extern Value make_bool(bool val);
+extern Value make_null(void);
+extern Value make_int(long long val);
+extern Array* array_create(size_t capacity);
+
+#define GQL_POOL_BLOCK 8192
+#define GQL_CACHE_BUCKETS 256
+#define GQL_MEMO_BUCKETS 256
+
+// ---------------------------------------------------------------------------
+// Pool allocator: a document or request is freed in one go
+// ---------------------------------------------------------------------------
+
+typedef struct GqlBlock {
+    struct GqlBlock* next;
+    size_t used;
+    size_t cap;
+    char data[];
+} GqlBlock;
+
+typedef struct GqlPool {
+    GqlBlock* head;
+} GqlPool;
+
+static void* gql_alloc(GqlPool* pool, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    GqlBlock* b = pool->head;
+    if (!b || b->used + size > b->cap) {
+        size_t cap = size > GQL_POOL_BLOCK ? size : GQL_POOL_BLOCK;
+        b = malloc(sizeof(GqlBlock) + cap);
+        if (!b) return NULL;
+        b->next = pool->head;
+        b->used = 0;
+        b->cap = cap;
+        pool->head = b;
+    }
+    void* p = b->data + b->used;
+    b->used += size;
+    memset(p, 0, size);
+    return p;
 }
 
-void graphql_schema_free(GraphQLSchema* schema) {
-    if (!schema) return;
+static char* gql_strndup(GqlPool* pool, const char* s, size_t len) {
+    char* out = gql_alloc(pool, len + 1);
+    if (!out) return NULL;
+    memcpy(out, s, len);
+    out[len] = '\0';
+    return out;
+}
 
-    for (int i = 0; i < schema->type_count; i++) {
-        if (schema->types[i]) {
-            free(schema->types[i]->name);
-            for (int j = 0; j < schema->types[i]->field_count; j++) {
-                free(schema->types[i]->fields[j].name);
-                if (schema->types[i]->fields[j].args) {
-                    free(schema->types[i]->fields[j].args);
-                }
-            }
-            free(schema->types[i]->fields);
-            free(schema->types[i]);
-        }
+static void gql_pool_free(GqlPool* pool) {
+    GqlBlock* b = pool->head;
+    while (b) {
+        GqlBlock* next = b->next;
+        free(b);
+        b = next;
     }
-
-    free(schema->types);
-    free(schema->queries);
-    free(schema->mutations);
-    free(schema->subscriptions);
-    free(schema);
+    pool->head = NULL;
 }
 
-int graphql_schema_add_type(GraphQLSchema* schema, const char* name, GraphQLField* fields, int field_count) {
-    if (schema->type_count >= GQL_MAX_TYPES) return -1;
-
-    GraphQLTypeDef* type = (GraphQLTypeDef*)malloc(sizeof(GraphQLTypeDef));
-    type->name = strdup(name);
-    type->fields = (GraphQLField*)malloc(field_count * sizeof(GraphQLField));
-    type->field_count = field_count;
-
-    for (int i = 0; i < field_count; i++) {
-        type->fields[i].name = strdup(fields[i].name);
-        type->fields[i].args = fields[i].args ? (GraphQLArgument*)malloc(fields[i].arg_count * sizeof(GraphQLArgument)) : NULL;
-        type->fields[i].arg_count = fields[i].arg_count;
-        type->fields[i].value = NULL;
+// ---------------------------------------------------------------------------
+// Document AST
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    GV_VARIABLE,
+    GV_INT,
+    GV_FLOAT,
+    GV_STRING,
+    GV_BOOL,
+    GV_NULL,
+    GV_ENUM,
+    GV_LIST,
+    GV_OBJECT
+} GqlValueKind;
+
+typedef struct GqlValue {
+    GqlValueKind kind;
+    const char* name;        // field name inside an object value
+    const char* str;         // string, enum or variable name
+    long long i;
+    double f;
+    bool b;
+    struct GqlValue* items;  // list items or object fields
+    struct GqlValue* next;
+} GqlValue;
+
+typedef struct GqlArg {
+    const char* name;
+    GqlValue* value;
+    struct GqlArg* next;
+} GqlArg;
+
+typedef struct GqlDirective {
+    const char* name;
+    GqlArg* args;
+    struct GqlDirective* next;
+} GqlDirective;
+
+typedef enum { GS_FIELD, GS_SPREAD, GS_INLINE } GqlSelKind;
+
+typedef struct GqlSelection {
+    GqlSelKind kind;
+    const char* alias;
+    const char* name;             // field name, or fragment name for a spread
+    const char* type_cond;        // inline fragments
+    GqlArg* args;
+    GqlDirective* directives;
+    struct GqlSelection* children;
+    struct GqlSelection* next;
+} GqlSelection;
+
+typedef struct GqlVarDef {
+    const char* name;
+    const char* type;
+    bool non_null;
+    GqlValue* def;
+    struct GqlVarDef* next;
+} GqlVarDef;
+
+typedef enum { GQL_QUERY, GQL_MUTATION, GQL_SUBSCRIPTION } GqlOpKind;
+
+typedef struct GqlOperation {
+    GqlOpKind kind;
+    const char* name;
+    GqlVarDef* vars;
+    GqlSelection* selections;
+    struct GqlOperation* next;
+} GqlOperation;
+
+typedef struct GqlFragment {
+    const char* name;
+    const char* type_cond;
+    GqlSelection* selections;
+    struct GqlFragment* next;
+} GqlFragment;
+
+typedef struct GqlDocument {
+    GqlPool pool;
+    _Atomic int refs;        // the cache and each running request
+    GqlOperation* ops;
+    GqlFragment* frags;
+} GqlDocument;
+
+static void gql_document_release(GqlDocument* doc) {
+    if (doc && atomic_fetch_sub(&doc->refs, 1) == 1) {
+        GqlPool pool = doc->pool;  // the document lives in its own pool
+        gql_pool_free(&pool);
+    }
+}
 
-        for (int j = 0; j < fields[i].arg_count; j++) {
-            type->fields[i].args[j].name = strdup(fields[i].args[j].name);
-            type->fields[i].args[j].value = fields[i].args[j].value;
+// ---------------------------------------------------------------------------
+// Lexer
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    TK_EOF,
+    TK_PUNCT,
+    TK_SPREAD,
+    TK_NAME,
+    TK_INT,
+    TK_FLOAT,
+    TK_STRING
+} GqlTokKind;
+
+typedef struct GqlParser {
+    const char* src;
+    size_t len;
+    size_t pos;
+    GqlTokKind kind;
+    char punct;
+    size_t tok_start;
+    const char* text;        // token text (decoded for strings), pool-owned
+    GqlPool* pool;
+    char error[160];
+} GqlParser;
+
+static bool gql_error(GqlParser* p, size_t at, const char* fmt, const char* detail) {
+    if (p->error[0]) return false;
+    int line = 1, col = 1;
+    for (size_t i = 0; i < at && i < p->len; i++) {
+        if (p->src[i] == '\n') {
+            line++;
+            col = 1;
+        } else {
+            col++;
         }
     }
-
-    schema->types[schema->type_count++] = type;
-    return 0;
+    char msg[96];
+    snprintf(msg, sizeof(msg), fmt, detail ? detail : "");
+    snprintf(p->error, sizeof(p->error), "Syntax Error: %s (line %d, column %d)", msg, line, col);
+    return false;
 }
 
-int graphql_schema_add_query(GraphQLSchema* schema, GraphQLField* field) {
-    for (int i = 0; i < GQL_MAX_FIELDS; i++) {
-        if (!schema->queries[i].name) {
-            schema->queries[i].name = strdup(field->name);
-            schema->queries[i].args = field->args ? (GraphQLArgument*)malloc(field->arg_count * sizeof(GraphQLArgument)) : NULL;
-            schema->queries[i].arg_count = field->arg_count;
-            schema->queries[i].value = field->value;
-            return 0;
-        }
+static void gql_utf8(char** out, unsigned cp) {
+    char* o = *out;
+    if (cp < 0x80) {
+        *o++ = (char)cp;
+    } else if (cp < 0x800) {
+        *o++ = (char)(0xC0 | (cp >> 6));
+        *o++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *o++ = (char)(0xE0 | (cp >> 12));
+        *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *o++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *o++ = (char)(0xF0 | (cp >> 18));
+        *o++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *o++ = (char)(0x80 | (cp & 0x3F));
     }
-    return -1;
+    *out = o;
 }
 
-int graphql_schema_add_mutation(GraphQLSchema* schema, GraphQLField* field) {
-    for (int i = 0; i < GQL_MAX_FIELDS; i++) {
-        if (!schema->mutations[i].name) {
-            schema->mutations[i].name = strdup(field->name);
-            schema->mutations[i].args = field->args ? (GraphQLArgument*)malloc(field->arg_count * sizeof(GraphQLArgument)) : NULL;
-            schema->mutations[i].arg_count = field->arg_count;
-            schema->mutations[i].value = field->value;
-            return 0;
+static bool gql_lex_string(GqlParser* p) {
+    const char* s = p->src;
+    size_t start = p->pos;
+    if (p->pos + 2 < p->len && s[p->pos + 1] == '"' && s[p->pos + 2] == '"') {
+        // Block string: raw text up to the closing """, with \""" escaped.
+        size_t i = p->pos + 3;
+        char* out = gql_alloc(p->pool, p->len - i + 1);
+        char* o = out;
+        while (i < p->len) {
+            if (s[i] == '"' && i + 2 < p->len && s[i + 1] == '"' && s[i + 2] == '"') {
+                *o = '\0';
+                p->text = out;
+                p->pos = i + 3;
+                p->kind = TK_STRING;
+                return true;
+            }
+            if (s[i] == '\\' && i + 3 < p->len && s[i + 1] == '"' && s[i + 2] == '"' && s[i + 3] == '"') {
+                memcpy(o, "\"\"\"", 3);
+                o += 3;
+                i += 4;
+                continue;
+            }
+            *o++ = s[i++];
         }
+        return gql_error(p, start, "Unterminated string%s", NULL);
+    }
+    size_t i = p->pos + 1;
+    size_t end = i;
+    while (end < p->len && s[end] != '"' && s[end] != '\n') {
+        if (s[end] == '\\') end++;
+        end++;
     }
-    return -1;
+    if (end >= p->len || s[end] != '"') return gql_error(p, start, "Unterminated string%s", NULL);
+    char* out = gql_alloc(p->pool, end - i + 1);
+    char* o = out;
+    while (i < end) {
+        char c = s[i++];
+        if (c != '\\') {
+            *o++ = c;
+            continue;
+        }
+        char e = s[i++];
+        switch (e) {
+            case '"': *o++ = '"'; break;
+            case '\\': *o++ = '\\'; break;
+            case '/': *o++ = '/'; break;
+            case 'b': *o++ = '\b'; break;
+            case 'f': *o++ = '\f'; break;
+            case 'n': *o++ = '\n'; break;
+            case 'r': *o++ = '\r'; break;
+            case 't': *o++ = '\t'; break;
+            case 'u': {
+                if (i + 4 > end) return gql_error(p, i, "Invalid unicode escape%s", NULL);
+                char hex[5] = { s[i], s[i + 1], s[i + 2], s[i + 3], 0 };
+                char* hend;
+                unsigned cp = (unsigned)strtoul(hex, &hend, 16);
+                if (*hend) return gql_error(p, i, "Invalid unicode escape%s", NULL);
+                i += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF && i + 6 <= end && s[i] == '\\' && s[i + 1] == 'u') {
+                    char lo_hex[5] = { s[i + 2], s[i + 3], s[i + 4], s[i + 5], 0 };
+                    unsigned lo = (unsigned)strtoul(lo_hex, &hend, 16);
+                    if (!*hend && lo >= 0xDC00 && lo <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        i += 6;
+                    }
+                }
+                gql_utf8(&o, cp);
+                break;
+            }
+            default:
+                return gql_error(p, i - 2, "Invalid escape sequence%s", NULL);
+        }
+    }
+    *o = '\0';
+    p->text = out;
+    p->pos = end + 1;
+    p->kind = TK_STRING;
+    return true;
 }
 
-int graphql_schema_add_subscription(GraphQLSchema* schema, GraphQLField* field) {
-    for (int i = 0; i < GQL_MAX_FIELDS; i++) {
-        if (!schema->subscriptions[i].name) {
-            schema->subscriptions[i].name = strdup(field->name);
-            schema->subscriptions[i].args = field->args ? (GraphQLArgument*)malloc(field->arg_count * sizeof(GraphQLArgument)) : NULL;
-            schema->subscriptions[i].arg_count = field->arg_count;
-            schema->subscriptions[i].value = field->value;
-            return 0;
+// Advances to the next token. Commas are insignificant in GraphQL.
+static bool gql_next(GqlParser* p) {
+    const char* s = p->src;
+    for (;;) {
+        while (p->pos < p->len && (s[p->pos] == ' ' || s[p->pos] == '\t' || s[p->pos] == '\n' ||
+                                   s[p->pos] == '\r' || s[p->pos] == ',' || (unsigned char)s[p->pos] == 0xEF ||
+                                   (unsigned char)s[p->pos] == 0xBB || (unsigned char)s[p->pos] == 0xBF)) {
+            p->pos++;
         }
+        if (p->pos < p->len && s[p->pos] == '#') {
+            while (p->pos < p->len && s[p->pos] != '\n') p->pos++;
+            continue;
+        }
+        break;
+    }
+    p->tok_start = p->pos;
+    p->text = NULL;
+    if (p->pos >= p->len) {
+        p->kind = TK_EOF;
+        return true;
+    }
+    char c = s[p->pos];
+    if (c == '.') {
+        if (p->pos + 2 < p->len && s[p->pos + 1] == '.' && s[p->pos + 2] == '.') {
+            p->pos += 3;
+            p->kind = TK_SPREAD;
+            return true;
+        }
+        return gql_error(p, p->pos, "Unexpected \".\"%s", NULL);
     }
-    return -1;
+    if (strchr("!$&()/:=@[]{}|", c)) {
+        p->pos++;
+        p->kind = TK_PUNCT;
+        p->punct = c;
+        return true;
+    }
+    if (c == '_' || isalpha((unsigned char)c)) {
+        size_t start = p->pos;
+        while (p->pos < p->len && (s[p->pos] == '_' || isalnum((unsigned char)s[p->pos]))) p->pos++;
+        p->text = gql_strndup(p->pool, s + start, p->pos - start);
+        p->kind = TK_NAME;
+        return true;
+    }
+    if (c == '-' || isdigit((unsigned char)c)) {
+        size_t start = p->pos;
+        if (s[p->pos] == '-') p->pos++;
+        if (p->pos >= p->len || !isdigit((unsigned char)s[p->pos])) return gql_error(p, start, "Invalid number%s", NULL);
+        if (s[p->pos] == '0' && p->pos + 1 < p->len && isdigit((unsigned char)s[p->pos + 1])) {
+            return gql_error(p, start, "Invalid number, unexpected digit after 0%s", NULL);
+        }
+        while (p->pos < p->len && isdigit((unsigned char)s[p->pos])) p->pos++;
+        bool is_float = false;
+        if (p->pos < p->len && s[p->pos] == '.') {
+            is_float = true;
+            p->pos++;
+            if (p->pos >= p->len || !isdigit((unsigned char)s[p->pos])) return gql_error(p, start, "Invalid number%s", NULL);
+            while (p->pos < p->len && isdigit((unsigned char)s[p->pos])) p->pos++;
+        }
+        if (p->pos < p->len && (s[p->pos] == 'e' || s[p->pos] == 'E')) {
+            is_float = true;
+            p->pos++;
+            if (p->pos < p->len && (s[p->pos] == '+' || s[p->pos] == '-')) p->pos++;
+            if (p->pos >= p->len || !isdigit((unsigned char)s[p->pos])) return gql_error(p, start, "Invalid number%s", NULL);
+            while (p->pos < p->len && isdigit((unsigned char)s[p->pos])) p->pos++;
+        }
+        p->text = gql_strndup(p->pool, s + start, p->pos - start);
+        p->kind = is_float ? TK_FLOAT : TK_INT;
+        return true;
+    }
+    if (c == '"') return gql_lex_string(p);
+    char bad[2] = { c, 0 };
+    return gql_error(p, p->pos, "Unexpected character \"%s\"", bad);
 }
 
-void graphql_field_set_resolver(GraphQLField* field, GraphQLResolver resolver, void* user_data) {
-    (void)user_data;
-    if (!field) return;
-    field->resolver = resolver;
+static bool gql_peek_punct(GqlParser* p, char c) {
+    return p->kind == TK_PUNCT && p->punct == c;
 }
 
-GraphQLValue* graphql_value_string(const char* str) {
-    GraphQLValue* v = (GraphQLValue*)malloc(sizeof(GraphQLValue));
-    v->type = GQL_TYPE_SCALAR;
-    v->is_null = false;
-    v->as.string = strdup(str);
-    return v;
+static bool gql_expect_punct(GqlParser* p, char c) {
+    if (!gql_peek_punct(p, c)) {
+        char want[2] = { c, 0 };
+        return gql_error(p, p->tok_start, "Expected \"%s\"", want);
+    }
+    return gql_next(p);
 }
 
-GraphQLValue* graphql_value_number(double num) {
-    GraphQLValue* v = (GraphQLValue*)malloc(sizeof(GraphQLValue));
-    v->type = GQL_TYPE_SCALAR;
-    v->is_null = false;
-    v->as.number = num;
-    return v;
+static const char* gql_expect_name(GqlParser* p) {
+    if (p->kind != TK_NAME) {
+        gql_error(p, p->tok_start, "Expected Name%s", NULL);
+        return NULL;
+    }
+    const char* name = p->text;
+    return gql_next(p) ? name : NULL;
 }
 
-GraphQLValue* graphql_value_bool(bool b) {
-    GraphQLValue* v = (GraphQLValue*)malloc(sizeof(GraphQLValue));
-    v->type = GQL_TYPE_SCALAR;
-    v->is_null = false;
-    v->as.boolean = b;
-    return v;
+static bool gql_peek_keyword(GqlParser* p, const char* word) {
+    return p->kind == TK_NAME && strcmp(p->text, word) == 0;
 }
 
-static GraphQLValue _null_value = { .type = GQL_TYPE_SCALAR, .is_null = true };
+// ---------------------------------------------------------------------------
+// Parser
+// ---------------------------------------------------------------------------
 
-GraphQLValue* graphql_value_null(void) {
-    return &_null_value;
-}
+static GqlValue* gql_parse_value(GqlParser* p, bool is_const);
+static GqlSelection* gql_parse_selection_set(GqlParser* p, int depth);
 
-GraphQLValue* graphql_value_list(GraphQLValue** items, int count) {
-    (void)count;
-    GraphQLValue* v = (GraphQLValue*)malloc(sizeof(GraphQLValue));
-    v->type = GQL_TYPE_LIST;
-    v->is_null = false;
-    v->as.list = items;
+static GqlValue* gql_new_value(GqlParser* p, GqlValueKind kind) {
+    GqlValue* v = gql_alloc(p->pool, sizeof(GqlValue));
+    if (v) v->kind = kind;
     return v;
 }
 
-GraphQLValue* graphql_value_object(GraphQLField** fields, int count) {
-    GraphQLValue* v = (GraphQLValue*)malloc(sizeof(GraphQLValue));
-    v->type = GQL_TYPE_OBJECT;
-    v->is_null = false;
-    v->as.object.fields = (GraphQLField*)malloc(count * sizeof(GraphQLField));
-    v->as.object.count = count;
-    return v;
+static GqlValue* gql_parse_value(GqlParser* p, bool is_const) {
+    GqlValue* v = NULL;
+    if (gql_peek_punct(p, '$')) {
+        if (is_const) {
+            gql_error(p, p->tok_start, "Unexpected variable in constant value%s", NULL);
+            return NULL;
+        }
+        if (!gql_next(p)) return NULL;
+        const char* name = gql_expect_name(p);
+        if (!name) return NULL;
+        v = gql_new_value(p, GV_VARIABLE);
+        v->str = name;
+        return v;
+    }
+    if (gql_peek_punct(p, '[')) {
+        if (!gql_next(p)) return NULL;
+        v = gql_new_value(p, GV_LIST);
+        GqlValue** tail = &v->items;
+        while (!gql_peek_punct(p, ']')) {
+            if (p->kind == TK_EOF) {
+                gql_error(p, p->tok_start, "Expected \"]\"%s", NULL);
+                return NULL;
+            }
+            GqlValue* item = gql_parse_value(p, is_const);
+            if (!item) return NULL;
+            *tail = item;
+            tail = &item->next;
+        }
+        return gql_next(p) ? v : NULL;
+    }
+    if (gql_peek_punct(p, '{')) {
+        if (!gql_next(p)) return NULL;
+        v = gql_new_value(p, GV_OBJECT);
+        GqlValue** tail = &v->items;
+        while (!gql_peek_punct(p, '}')) {
+            const char* name = gql_expect_name(p);
+            if (!name || !gql_expect_punct(p, ':')) return NULL;
+            GqlValue* field = gql_parse_value(p, is_const);
+            if (!field) return NULL;
+            field->name = name;
+            *tail = field;
+            tail = &field->next;
+        }
+        return gql_next(p) ? v : NULL;
+    }
+    switch (p->kind) {
+        case TK_INT:
+            v = gql_new_value(p, GV_INT);
+            v->i = strtoll(p->text, NULL, 10);
+            break;
+        case TK_FLOAT:
+            v = gql_new_value(p, GV_FLOAT);
+            v->f = strtod(p->text, NULL);
+            break;
+        case TK_STRING:
+            v = gql_new_value(p, GV_STRING);
+            v->str = p->text;
+            break;
+        case TK_NAME:
+            if (strcmp(p->text, "true") == 0 || strcmp(p->text, "false") == 0) {
+                v = gql_new_value(p, GV_BOOL);
+                v->b = p->text[0] == 't';
+            } else if (strcmp(p->text, "null") == 0) {
+                v = gql_new_value(p, GV_NULL);
+            } else {
+                v = gql_new_value(p, GV_ENUM);
+                v->str = p->text;
+            }
+            break;
+        default:
+            gql_error(p, p->tok_start, "Expected a value%s", NULL);
+            return NULL;
+    }
+    return gql_next(p) ? v : NULL;
 }
 
-void graphql_value_free(GraphQLValue* value) {
-    if (!value) return;
+static bool gql_parse_arguments(GqlParser* p, GqlArg** out, bool is_const) {
+    *out = NULL;
+    if (!gql_peek_punct(p, '(')) return true;
+    if (!gql_next(p)) return false;
+    GqlArg** tail = out;
+    do {
+        const char* name = gql_expect_name(p);
+        if (!name || !gql_expect_punct(p, ':')) return false;
+        GqlArg* arg = gql_alloc(p->pool, sizeof(GqlArg));
+        arg->name = name;
+        arg->value = gql_parse_value(p, is_const);
+        if (!arg->value) return false;
+        *tail = arg;
+        tail = &arg->next;
+    } while (!gql_peek_punct(p, ')'));
+    return gql_next(p);
+}
 
-    if (!value->is_null) {
-        switch (value->type) {
-            case GQL_TYPE_SCALAR:
-                if (value->as.string) free(value->as.string);
-                break;
-            case GQL_TYPE_LIST:
-                if (value->as.list) {
-                    GraphQLValue** list_items = (GraphQLValue**)value->as.list;
-                    for (int i = 0; i < 10; i++) {
-                        if (list_items[i]) graphql_value_free(list_items[i]);
-                    }
-                    free(value->as.list);
-                }
-                break;
-            case GQL_TYPE_OBJECT:
-                if (value->as.object.fields) free(value->as.object.fields);
-                break;
-            default:
-                break;
+static bool gql_parse_directives(GqlParser* p, GqlDirective** out, bool is_const) {
+    *out = NULL;
+    GqlDirective** tail = out;
+    while (gql_peek_punct(p, '@')) {
+        if (!gql_next(p)) return false;
+        GqlDirective* d = gql_alloc(p->pool, sizeof(GqlDirective));
+        d->name = gql_expect_name(p);
+        if (!d->name || !gql_parse_arguments(p, &d->args, is_const)) return false;
+        *tail = d;
+        tail = &d->next;
+    }
+    return true;
+}
+
+static GqlSelection* gql_parse_selection(GqlParser* p, int depth) {
+    GqlSelection* sel = gql_alloc(p->pool, sizeof(GqlSelection));
+    if (p->kind == TK_SPREAD) {
+        if (!gql_next(p)) return NULL;
+        if (p->kind == TK_NAME && strcmp(p->text, "on") != 0) {
+            sel->kind = GS_SPREAD;
+            sel->name = gql_expect_name(p);
+            if (!sel->name || !gql_parse_directives(p, &sel->directives, false)) return NULL;
+            return sel;
+        }
+        sel->kind = GS_INLINE;
+        if (gql_peek_keyword(p, "on")) {
+            if (!gql_next(p)) return NULL;
+            sel->type_cond = gql_expect_name(p);
+            if (!sel->type_cond) return NULL;
         }
+        if (!gql_parse_directives(p, &sel->directives, false)) return NULL;
+        sel->children = gql_parse_selection_set(p, depth + 1);
+        return sel->children ? sel : NULL;
     }
+    sel->kind = GS_FIELD;
+    sel->name = gql_expect_name(p);
+    if (!sel->name) return NULL;
+    if (gql_peek_punct(p, ':')) {
+        if (!gql_next(p)) return NULL;
+        sel->alias = sel->name;
+        sel->name = gql_expect_name(p);
+        if (!sel->name) return NULL;
+    }
+    if (!gql_parse_arguments(p, &sel->args, false)) return NULL;
+    if (!gql_parse_directives(p, &sel->directives, false)) return NULL;
+    if (gql_peek_punct(p, '{')) {
+        sel->children = gql_parse_selection_set(p, depth + 1);
+        if (!sel->children) return NULL;
+    }
+    return sel;
+}
 
-    free(value);
+static GqlSelection* gql_parse_selection_set(GqlParser* p, int depth) {
+    if (depth > GRAPHQL_MAX_DEPTH) {
+        gql_error(p, p->tok_start, "Selection sets nest too deeply%s", NULL);
+        return NULL;
+    }
+    if (!gql_expect_punct(p, '{')) return NULL;
+    GqlSelection* head = NULL;
+    GqlSelection** tail = &head;
+    do {
+        if (p->kind == TK_EOF) {
+            gql_error(p, p->tok_start, "Expected \"}\"%s", NULL);
+            return NULL;
+        }
+        GqlSelection* sel = gql_parse_selection(p, depth);
+        if (!sel) return NULL;
+        *tail = sel;
+        tail = &sel->next;
+    } while (!gql_peek_punct(p, '}'));
+    return gql_next(p) ? head : NULL;
 }
 
-char* graphql_value_to_json(GraphQLValue* value) {
-    if (!value) return strdup("null");
+// Types are kept as text ("[ID!]!"); only the outer non-null matters here.
+static bool gql_parse_type(GqlParser* p, char* buf, size_t cap, size_t* len) {
+    if (gql_peek_punct(p, '[')) {
+        if (*len + 1 < cap) buf[(*len)++] = '[';
+        if (!gql_next(p) || !gql_parse_type(p, buf, cap, len) || !gql_expect_punct(p, ']')) return false;
+        if (*len + 1 < cap) buf[(*len)++] = ']';
+    } else {
+        const char* name = gql_expect_name(p);
+        if (!name) return false;
+        size_t n = strlen(name);
+        if (*len + n < cap) {
+            memcpy(buf + *len, name, n);
+            *len += n;
+        }
+    }
+    if (gql_peek_punct(p, '!')) {
+        if (*len + 1 < cap) buf[(*len)++] = '!';
+        if (!gql_next(p)) return false;
+    }
+    buf[*len] = '\0';
+    return true;
+}
 
-    if (value->is_null) return strdup("null");
+static bool gql_parse_variable_defs(GqlParser* p, GqlVarDef** out) {
+    *out = NULL;
+    if (!gql_peek_punct(p, '(')) return true;
+    if (!gql_next(p)) return false;
+    GqlVarDef** tail = out;
+    do {
+        if (!gql_expect_punct(p, '$')) return false;
+        GqlVarDef* var = gql_alloc(p->pool, sizeof(GqlVarDef));
+        var->name = gql_expect_name(p);
+        if (!var->name || !gql_expect_punct(p, ':')) return false;
+        char type[128];
+        size_t tlen = 0;
+        if (!gql_parse_type(p, type, sizeof(type), &tlen)) return false;
+        var->type = gql_strndup(p->pool, type, tlen);
+        var->non_null = tlen > 0 && type[tlen - 1] == '!';
+        if (gql_peek_punct(p, '=')) {
+            if (!gql_next(p)) return false;
+            var->def = gql_parse_value(p, true);
+            if (!var->def) return false;
+        }
+        GqlDirective* ignored;
+        if (!gql_parse_directives(p, &ignored, true)) return false;
+        *tail = var;
+        tail = &var->next;
+    } while (!gql_peek_punct(p, ')'));
+    return gql_next(p);
+}
 
-    char buffer[1024];
+static bool gql_parse_definition(GqlParser* p, GqlDocument* doc, GqlOperation*** op_tail, GqlFragment*** frag_tail) {
+    if (gql_peek_punct(p, '{')) {
+        GqlOperation* op = gql_alloc(p->pool, sizeof(GqlOperation));
+        op->kind = GQL_QUERY;
+        op->selections = gql_parse_selection_set(p, 0);
+        if (!op->selections) return false;
+        **op_tail = op;
+        *op_tail = &op->next;
+        return true;
+    }
+    if (gql_peek_keyword(p, "fragment")) {
+        if (!gql_next(p)) return false;
+        GqlFragment* frag = gql_alloc(p->pool, sizeof(GqlFragment));
+        if (gql_peek_keyword(p, "on")) return gql_error(p, p->tok_start, "Unexpected Name \"on\"%s", NULL);
+        frag->name = gql_expect_name(p);
+        if (!frag->name) return false;
+        if (!gql_peek_keyword(p, "on")) return gql_error(p, p->tok_start, "Expected \"on\"%s", NULL);
+        if (!gql_next(p)) return false;
+        frag->type_cond = gql_expect_name(p);
+        GqlDirective* ignored;
+        if (!frag->type_cond || !gql_parse_directives(p, &ignored, false)) return false;
+        frag->selections = gql_parse_selection_set(p, 0);
+        if (!frag->selections) return false;
+        for (GqlFragment* f = doc->frags; f; f = f->next) {
+            if (strcmp(f->name, frag->name) == 0) {
+                return gql_error(p, p->tok_start, "There can be only one fragment named \"%s\"", frag->name);
+            }
+        }
+        **frag_tail = frag;
+        *frag_tail = &frag->next;
+        return true;
+    }
+    if (p->kind == TK_NAME) {
+        GqlOperation* op = gql_alloc(p->pool, sizeof(GqlOperation));
+        if (strcmp(p->text, "query") == 0) op->kind = GQL_QUERY;
+        else if (strcmp(p->text, "mutation") == 0) op->kind = GQL_MUTATION;
+        else if (strcmp(p->text, "subscription") == 0) op->kind = GQL_SUBSCRIPTION;
+        else return gql_error(p, p->tok_start, "Unexpected Name \"%s\"", p->text);
+        if (!gql_next(p)) return false;
+        if (p->kind == TK_NAME) op->name = gql_expect_name(p);
+        GqlDirective* ignored;
+        if (!gql_parse_variable_defs(p, &op->vars) || !gql_parse_directives(p, &ignored, false)) return false;
+        op->selections = gql_parse_selection_set(p, 0);
+        if (!op->selections) return false;
+        **op_tail = op;
+        *op_tail = &op->next;
+        return true;
+    }
+    return gql_error(p, p->tok_start, "Unexpected token%s", NULL);
+}
 
-    switch (value->type) {
-        case GQL_TYPE_SCALAR:
-            if (value->as.string) {
-                snprintf(buffer, sizeof(buffer), "\"%s\"", value->as.string);
-            } else if (value->as.boolean) {
-                snprintf(buffer, sizeof(buffer), "%s", value->as.boolean ? "true" : "false");
-            } else {
-                snprintf(buffer, sizeof(buffer), "%g", value->as.number);
+static bool gql_check_spreads(GqlParser* p, GqlDocument* doc, GqlSelection* sel) {
+    for (; sel; sel = sel->next) {
+        if (sel->kind == GS_SPREAD) {
+            GqlFragment* f = doc->frags;
+            while (f && strcmp(f->name, sel->name) != 0) f = f->next;
+            if (!f) {
+                snprintf(p->error, sizeof(p->error), "Unknown fragment \"%s\".", sel->name);
+                return false;
             }
-            break;
+        }
+        if (!gql_check_spreads(p, doc, sel->children)) return false;
+    }
+    return true;
+}
 
-        case GQL_TYPE_LIST:
-            snprintf(buffer, sizeof(buffer), "[...]");
-            break;
+// Returns a document with one reference, or NULL with error filled in.
+static GqlDocument* gql_parse_document(const char* text, size_t len, char* error, size_t error_len) {
+    GqlPool pool = { NULL };
+    GqlDocument* doc = gql_alloc(&pool, sizeof(GqlDocument));
+    if (!doc) return NULL;
+    GqlParser p;
+    memset(&p, 0, sizeof(p));
+    p.src = text;
+    p.len = len;
+    p.pool = &pool;
+    GqlOperation** op_tail = &doc->ops;
+    GqlFragment** frag_tail = &doc->frags;
+    bool ok = gql_next(&p);
+    if (ok && p.kind == TK_EOF) ok = gql_error(&p, p.tok_start, "Unexpected <EOF>%s", NULL);
+    while (ok && p.kind != TK_EOF) {
+        ok = gql_parse_definition(&p, doc, &op_tail, &frag_tail);
+    }
+    for (GqlOperation* op = doc->ops; ok && op; op = op->next) ok = gql_check_spreads(&p, doc, op->selections);
+    for (GqlFragment* f = doc->frags; ok && f; f = f->next) ok = gql_check_spreads(&p, doc, f->selections);
+    if (ok && !doc->ops) {
+        snprintf(p.error, sizeof(p.error), "Document contains no operations.");
+        ok = false;
+    }
+    if (!ok) {
+        snprintf(error, error_len, "%s", p.error);
+        gql_pool_free(&pool);
+        return NULL;
+    }
+    doc->pool = pool;
+    atomic_init(&doc->refs, 1);
+    return doc;
+}
 
-        case GQL_TYPE_OBJECT:
-            snprintf(buffer, sizeof(buffer), "{...}");
-            break;
+// ---------------------------------------------------------------------------
+// Document cache
+// ---------------------------------------------------------------------------
+
+typedef struct GqlCacheEntry {
+    uint64_t hash;
+    char* text;
+    size_t len;
+    GqlDocument* doc;
+    struct GqlCacheEntry* bucket_next;
+    struct GqlCacheEntry* lru_prev;   // towards most recently used
+    struct GqlCacheEntry* lru_next;
+} GqlCacheEntry;
+
+static GqlCacheEntry* gql_cache[GQL_CACHE_BUCKETS];
+static GqlCacheEntry* gql_lru_head = NULL;
+static GqlCacheEntry* gql_lru_tail = NULL;
+static int gql_cache_count = 0;
+static long long gql_cache_hits = 0;
+static long long gql_cache_misses = 0;
+// Guards the cache and the schema list; pool workers run queries too.
+static uv_mutex_t gql_lock;
+static uv_once_t gql_once = UV_ONCE_INIT;
+
+static void gql_init_lock(void) {
+    uv_mutex_init(&gql_lock);
+}
 
-        default:
-            snprintf(buffer, sizeof(buffer), "null");
-            break;
+static uint64_t gql_hash(const char* s, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
     }
+    return h;
+}
+
+static void gql_lru_unlink(GqlCacheEntry* e) {
+    if (e->lru_prev) e->lru_prev->lru_next = e->lru_next;
+    else gql_lru_head = e->lru_next;
+    if (e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+    else gql_lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+}
+
+static void gql_lru_push(GqlCacheEntry* e) {
+    e->lru_next = gql_lru_head;
+    if (gql_lru_head) gql_lru_head->lru_prev = e;
+    gql_lru_head = e;
+    if (!gql_lru_tail) gql_lru_tail = e;
+}
 
-    return strdup(buffer);
+static void gql_cache_evict(void) {
+    GqlCacheEntry* victim = gql_lru_tail;
+    if (!victim) return;
+    gql_lru_unlink(victim);
+    GqlCacheEntry** link = &gql_cache[victim->hash % GQL_CACHE_BUCKETS];
+    while (*link && *link != victim) link = &(*link)->bucket_next;
+    if (*link) *link = victim->bucket_next;
+    gql_document_release(victim->doc);
+    free(victim->text);
+    free(victim);
+    gql_cache_count--;
 }
 
-static GraphQLField* find_field(GraphQLField* fields, int field_count, const char* name) {
-    for (int i = 0; i < field_count; i++) {
-        if (fields[i].name && strcmp(fields[i].name, name) == 0) {
-            return &fields[i];
+// Call with gql_lock held.
+static GqlDocument* gql_cache_find(const char* text, size_t len, uint64_t hash) {
+    for (GqlCacheEntry* e = gql_cache[hash % GQL_CACHE_BUCKETS]; e; e = e->bucket_next) {
+        if (e->hash == hash && e->len == len && memcmp(e->text, text, len) == 0) {
+            gql_cache_hits++;
+            gql_lru_unlink(e);
+            gql_lru_push(e);
+            atomic_fetch_add(&e->doc->refs, 1);
+            return e->doc;
         }
     }
     return NULL;
 }
 
-static GraphQLValue* resolve_field(GraphQLContext* ctx, GraphQLField* field) {
-    if (field->resolver) {
-        return field->resolver(ctx, field, ctx->schema->user_data);
+// Returns the parsed document for text with a reference for the caller.
+static GqlDocument* gql_document_get(const char* text, char* error, size_t error_len) {
+    size_t len = strlen(text);
+    uint64_t hash = gql_hash(text, len);
+    uv_once(&gql_once, gql_init_lock);
+    uv_mutex_lock(&gql_lock);
+    GqlDocument* doc = gql_cache_find(text, len, hash);
+    if (!doc) gql_cache_misses++;
+    uv_mutex_unlock(&gql_lock);
+    if (doc) return doc;
+
+    // Parse outside the lock; if another thread cached the same text
+    // meanwhile, keep its copy.
+    doc = gql_parse_document(text, len, error, error_len);
+    if (!doc) return NULL;
+    GqlCacheEntry* e = calloc(1, sizeof(GqlCacheEntry));
+    if (!e) return doc;
+    uv_mutex_lock(&gql_lock);
+    GqlDocument* cached = gql_cache_find(text, len, hash);
+    if (cached) {
+        uv_mutex_unlock(&gql_lock);
+        free(e);
+        gql_document_release(doc);
+        return cached;
     }
-
-    return graphql_value_null();
+    if (gql_cache_count >= GRAPHQL_CACHE_CAPACITY) gql_cache_evict();
+    e->hash = hash;
+    e->text = strdup(text);
+    e->len = len;
+    e->doc = doc;
+    atomic_fetch_add(&doc->refs, 1);
+    e->bucket_next = gql_cache[hash % GQL_CACHE_BUCKETS];
+    gql_cache[hash % GQL_CACHE_BUCKETS] = e;
+    gql_lru_push(e);
+    gql_cache_count++;
+    uv_mutex_unlock(&gql_lock);
+    return doc;
 }
 
-GraphQLQuery* graphql_parse(const char* query, char** error) {
-    if (!query || !query[0]) {
-        if (error) *error = strdup("Empty query");
-        return NULL;
+// ---------------------------------------------------------------------------
+// Schemas
+// ---------------------------------------------------------------------------
+
+typedef struct GqlResolver {
+    char* type;
+    char* field;
+    char* returns;     // type name of the objects it produces, or NULL
+    Value fn;
+    bool batch;
+    struct GqlResolver* next;
+} GqlResolver;
+
+typedef struct GqlSchema {
+    char id[40];
+    GqlResolver* resolvers;
+    struct GqlSchema* next;
+} GqlSchema;
+
+static GqlSchema* gql_schemas = NULL;
+static long gql_next_schema_id = 1;
+
+// Schemas are never freed, so the pointer outlives the lock.
+static GqlSchema* gql_schema_find(const char* id) {
+    if (!id) return NULL;
+    uv_once(&gql_once, gql_init_lock);
+    uv_mutex_lock(&gql_lock);
+    GqlSchema* found = NULL;
+    for (GqlSchema* s = gql_schemas; s; s = s->next) {
+        if (strcmp(s->id, id) == 0) {
+            found = s;
+            break;
+        }
     }
+    uv_mutex_unlock(&gql_lock);
+    return found;
+}
 
-    GraphQLQuery* q = (GraphQLQuery*)calloc(1, sizeof(GraphQLQuery));
+static GqlResolver* gql_resolver_find(GqlSchema* schema, const char* type, const char* field) {
+    if (!type) return NULL;
+    for (GqlResolver* r = schema->resolvers; r; r = r->next) {
+        if (strcmp(r->field, field) == 0 && strcmp(r->type, type) == 0) return r;
+    }
+    return NULL;
+}
 
-    char* operation_start = strstr(query, "query");
-    char* mutation_start = strstr(query, "mutation");
+// ---------------------------------------------------------------------------
+// Execution
+// ---------------------------------------------------------------------------
+
+typedef enum { OUT_NULL, OUT_RAW, OUT_OBJECT, OUT_LIST } GqlOutKind;
+
+// Response tree, filled in level by level and serialized at the end.
+typedef struct GqlOut {
+    GqlOutKind kind;
+    const char* raw;          // JSON text of a leaf
+    size_t count;
+    const char** keys;        // object response keys
+    struct GqlOut* items;     // object fields or list items
+} GqlOut;
+
+typedef struct GqlPath {
+    const struct GqlPath* parent;
+    const char* key;          // NULL for a list index
+    size_t index;
+} GqlPath;
+
+typedef struct GqlItem {
+    const Value* parent;
+    const char* type;
+    GqlOut* out;
+    const GqlPath* path;
+} GqlItem;
+
+typedef struct GqlMemo {
+    char* key;
+    const Value* value;
+    struct GqlMemo* next;
+} GqlMemo;
+
+typedef struct GqlKept {
+    Value value;
+    struct GqlKept* next;
+} GqlKept;
+
+typedef struct GqlError {
+    char* message;
+    const GqlPath* path;
+    struct GqlError* next;
+} GqlError;
+
+typedef struct GqlExec {
+    GqlSchema* schema;
+    GqlDocument* doc;
+    GqlPool pool;             // response tree, paths, keys
+    const Value* variables;
+    GqlVarDef* var_defs;
+    GqlKept* kept;            // resolver results, alive until the response is written
+    GqlMemo* memo[GQL_MEMO_BUCKETS];
+    GqlError* errors;
+    GqlError** errors_tail;
+    int depth;
+} GqlExec;
+
+static StructDef gql_args_def = { (char*)"args", NULL };
+static const Value gql_null_value = { .type = VAL_NULL };
+
+static void gql_add_error(GqlExec* ex, const GqlPath* path, const char* message) {
+    GqlError* err = gql_alloc(&ex->pool, sizeof(GqlError));
+    err->message = gql_strndup(&ex->pool, message, strlen(message));
+    err->path = path;
+    *ex->errors_tail = err;
+    ex->errors_tail = &err->next;
+}
 
-    if (operation_start) {
-        q->operation = GQL_OP_QUERY;
-        operation_start += 5;
-    } else if (mutation_start) {
-        q->operation = GQL_OP_MUTATION;
-        operation_start = mutation_start + 8;
-    } else {
-        q->operation = GQL_OP_QUERY;
-        operation_start = (char*)query;
+static const Value* gql_keep(GqlExec* ex, Value v) {
+    GqlKept* k = malloc(sizeof(GqlKept));
+    if (!k) {
+        value_free(&v);
+        return &gql_null_value;
     }
+    k->value = v;
+    k->next = ex->kept;
+    ex->kept = k;
+    return &k->value;
+}
 
-    char* brace_start = strchr(operation_start, '{');
-    if (!brace_start) {
-        if (error) *error = strdup("Invalid GraphQL syntax");
-        free(q);
-        return NULL;
+static const Value* gql_struct_field(const Value* v, const char* name) {
+    if (!v || v->type != VAL_STRUCT_INSTANCE || !v->struct_instance) return NULL;
+    for (FieldValue* f = v->struct_instance->fields; f; f = f->next) {
+        if (strcmp(f->name, name) == 0) return f->value;
     }
+    return NULL;
+}
 
-    brace_start++;
+static void gql_struct_append(FieldValue*** tail, const char* name, Value value) {
+    FieldValue* field = malloc(sizeof(FieldValue));
+    field->name = strdup(name);
+    field->value = malloc(sizeof(Value));
+    *field->value = value;
+    field->next = NULL;
+    **tail = field;
+    *tail = &field->next;
+}
 
-    char* brace_end = strchr(brace_start, '}');
-    if (!brace_end) {
-        if (error) *error = strdup("Unclosed brace");
-        free(q);
-        return NULL;
+static Value gql_new_struct(void) {
+    Value v;
+    v.type = VAL_STRUCT_INSTANCE;
+    v.struct_instance = malloc(sizeof(StructInstance));
+    v.struct_instance->definition = &gql_args_def;
+    v.struct_instance->fields = NULL;
+    return v;
+}
+
+// Copies a value the way the interpreter does: arrays are shared by
+// reference count, structs and strings are copied.
+static Value gql_clone(const Value* v) {
+    if (v->type == VAL_STRING) return make_string(v->string_val);
+    if (v->type == VAL_ARRAY && v->array_val) {
+        v->array_val->refcount++;
+        return *v;
+    }
+    if (v->type == VAL_STRUCT_INSTANCE && v->struct_instance) {
+        Value out = gql_new_struct();
+        out.struct_instance->definition = v->struct_instance->definition;
+        FieldValue** tail = &out.struct_instance->fields;
+        for (FieldValue* f = v->struct_instance->fields; f; f = f->next) {
+            gql_struct_append(&tail, f->name, gql_clone(f->value));
+        }
+        return out;
     }
+    return *v;
+}
 
-    int field_count = 0;
-    char* current = brace_start;
+static const GqlVarDef* gql_var_def(GqlExec* ex, const char* name) {
+    for (GqlVarDef* d = ex->var_defs; d; d = d->next) {
+        if (strcmp(d->name, name) == 0) return d;
+    }
+    return NULL;
+}
 
-    while (current < brace_end) {
-        if (*current && !isspace((unsigned char)*current)) {
-            if (field_count > 0) field_count++;
+// Converts an argument literal to a RADS value, substituting variables.
+static Value gql_input_value(GqlExec* ex, const GqlValue* v) {
+    switch (v->kind) {
+        case GV_VARIABLE: {
+            const Value* given = gql_struct_field(ex->variables, v->str);
+            if (given) return gql_clone(given);
+            const GqlVarDef* def = gql_var_def(ex, v->str);
+            if (def && def->def) return gql_input_value(ex, def->def);
+            return make_null();
+        }
+        case GV_INT: return make_int(v->i);
+        case GV_FLOAT: {
+            Value f = { .type = VAL_FLOAT };
+            f.float_val = v->f;
+            return f;
+        }
+        case GV_STRING:
+        case GV_ENUM: return make_string(v->str);
+        case GV_BOOL: return make_bool(v->b);
+        case GV_NULL: return make_null();
+        case GV_LIST: {
+            size_t n = 0;
+            for (GqlValue* it = v->items; it; it = it->next) n++;
+            Array* arr = array_create(n);
+            for (GqlValue* it = v->items; it; it = it->next) arr->items[arr->count++] = gql_input_value(ex, it);
+            Value out = { .type = VAL_ARRAY };
+            out.array_val = arr;
+            return out;
+        }
+        case GV_OBJECT: {
+            Value out = gql_new_struct();
+            FieldValue** tail = &out.struct_instance->fields;
+            for (GqlValue* it = v->items; it; it = it->next) gql_struct_append(&tail, it->name, gql_input_value(ex, it));
+            return out;
         }
-        current++;
     }
-    if (brace_end > brace_start) field_count++;
+    return make_null();
+}
 
-    q->selection_set = (GraphQLField*)malloc(field_count * sizeof(GraphQLField));
-    q->selection_count = 0;
-    q->query = strdup(query);
-    q->variables = NULL;
-    q->variable_count = 0;
-    q->result = NULL;
-    q->error = NULL;
+static Value gql_args_value(GqlExec* ex, const GqlArg* args) {
+    Value out = gql_new_struct();
+    FieldValue** tail = &out.struct_instance->fields;
+    for (const GqlArg* a = args; a; a = a->next) gql_struct_append(&tail, a->name, gql_input_value(ex, a->value));
+    return out;
+}
 
-    return q;
+// @skip(if:) and @include(if:)
+static bool gql_included(GqlExec* ex, const GqlDirective* d) {
+    for (; d; d = d->next) {
+        bool skip = strcmp(d->name, "skip") == 0;
+        if (!skip && strcmp(d->name, "include") != 0) continue;
+        for (const GqlArg* a = d->args; a; a = a->next) {
+            if (strcmp(a->name, "if") != 0) continue;
+            Value cond = gql_input_value(ex, a->value);
+            bool truthy = cond.type == VAL_BOOL && cond.bool_val;
+            value_free(&cond);
+            if (skip == truthy) return false;
+        }
+    }
+    return true;
 }
 
-void graphql_query_free(GraphQLQuery* query) {
-    if (!query) return;
+// Fields that share a response key are merged; their sub-selections are
+// executed together.
+typedef struct GqlFieldGroup {
+    const char* key;
+    const GqlSelection* field;
+    const GqlSelection** subsets;
+    size_t subset_count;
+    size_t subset_cap;
+} GqlFieldGroup;
+
+typedef struct GqlFieldList {
+    GqlFieldGroup* groups;
+    size_t count;
+    size_t cap;
+} GqlFieldList;
+
+static bool gql_type_applies(const char* cond, const char* type) {
+    return !cond || (type && strcmp(cond, type) == 0);
+}
 
-    if (query->query) free(query->query);
-    if (query->selection_set) free(query->selection_set);
-    if (query->result) graphql_value_free(query->result);
-    if (query->error) free(query->error);
-    if (query->variables) {
-        for (int i = 0; i < query->variable_count; i++) {
-            if (query->variables[i].key) free(query->variables[i].key);
-            if (query->variables[i].value) free(query->variables[i].value);
+static void gql_collect_fields(GqlExec* ex, const GqlSelection* sel, const char* type, GqlFieldList* list, int depth) {
+    if (depth > GRAPHQL_MAX_DEPTH) return;
+    for (; sel; sel = sel->next) {
+        if (!gql_included(ex, sel->directives)) continue;
+        if (sel->kind == GS_SPREAD) {
+            const GqlFragment* f = ex->doc->frags;
+            while (f && strcmp(f->name, sel->name) != 0) f = f->next;
+            if (f && gql_type_applies(f->type_cond, type)) gql_collect_fields(ex, f->selections, type, list, depth + 1);
+            continue;
+        }
+        if (sel->kind == GS_INLINE) {
+            if (gql_type_applies(sel->type_cond, type)) gql_collect_fields(ex, sel->children, type, list, depth + 1);
+            continue;
+        }
+        const char* key = sel->alias ? sel->alias : sel->name;
+        GqlFieldGroup* g = NULL;
+        for (size_t i = 0; i < list->count; i++) {
+            if (strcmp(list->groups[i].key, key) == 0) {
+                g = &list->groups[i];
+                break;
+            }
+        }
+        if (!g) {
+            if (list->count == list->cap) {
+                list->cap = list->cap ? list->cap * 2 : 8;
+                list->groups = realloc(list->groups, list->cap * sizeof(GqlFieldGroup));
+            }
+            g = &list->groups[list->count++];
+            memset(g, 0, sizeof(*g));
+            g->key = key;
+            g->field = sel;
+        }
+        if (sel->children) {
+            if (g->subset_count == g->subset_cap) {
+                g->subset_cap = g->subset_cap ? g->subset_cap * 2 : 2;
+                g->subsets = realloc(g->subsets, g->subset_cap * sizeof(*g->subsets));
+            }
+            g->subsets[g->subset_count++] = sel->children;
         }
-        free(query->variables);
     }
+}
 
-    free(query);
+static void gql_field_list_free(GqlFieldList* list) {
+    for (size_t i = 0; i < list->count; i++) free(list->groups[i].subsets);
+    free(list->groups);
 }
 
-GraphQLContext* graphql_execute(GraphQLSchema* schema, GraphQLQuery* query, GraphQLVariable* variables) {
-    GraphQLContext* ctx = (GraphQLContext*)calloc(1, sizeof(GraphQLContext));
-    ctx->query = query;
-    ctx->variables = variables;
-    ctx->variable_count = variables ? 1 : 0;
-    ctx->schema = schema;
-    ctx->result = NULL;
-    ctx->error = NULL;
+// Memo keys are "Type.field(args)#parent-id"; parents without an id field
+// are never memoized since two of them cannot be told apart cheaply.
+static char* gql_memo_key(const char* type, const char* field, const char* args_json, const Value* parent) {
+    char id_buf[64];
+    const char* id = "";
+    if (parent && parent->type != VAL_NULL) {
+        const Value* idv = gql_struct_field(parent, "id");
+        if (!idv) return NULL;
+        if (idv->type == VAL_INT) {
+            snprintf(id_buf, sizeof(id_buf), "%lld", idv->int_val);
+            id = id_buf;
+        } else if (idv->type == VAL_STRING) {
+            id = idv->string_val;
+        } else {
+            return NULL;
+        }
+    }
+    size_t len = strlen(type) + strlen(field) + strlen(args_json) + strlen(id) + 4;
+    char* key = malloc(len);
+    if (key) snprintf(key, len, "%s.%s%s#%s", type, field, args_json, id);
+    return key;
+}
 
-    GraphQLField* operation_fields = NULL;
-    int field_count = 0;
+static const Value* gql_memo_get(GqlExec* ex, const char* key) {
+    if (!key) return NULL;
+    for (GqlMemo* m = ex->memo[gql_hash(key, strlen(key)) % GQL_MEMO_BUCKETS]; m; m = m->next) {
+        if (strcmp(m->key, key) == 0) return m->value;
+    }
+    return NULL;
+}
 
-    switch (query->operation) {
-        case GQL_OP_QUERY:
-            operation_fields = schema->queries;
-            field_count = GQL_MAX_FIELDS;
-            break;
-        case GQL_OP_MUTATION:
-            operation_fields = schema->mutations;
-            field_count = GQL_MAX_FIELDS;
-            break;
-        case GQL_OP_SUBSCRIPTION:
-            operation_fields = schema->subscriptions;
-            field_count = GQL_MAX_FIELDS;
-            break;
+// Takes ownership of key.
+static void gql_memo_put(GqlExec* ex, char* key, const Value* value) {
+    if (!key) return;
+    GqlMemo* m = malloc(sizeof(GqlMemo));
+    if (!m) {
+        free(key);
+        return;
     }
+    size_t b = gql_hash(key, strlen(key)) % GQL_MEMO_BUCKETS;
+    m->key = key;
+    m->value = value;
+    m->next = ex->memo[b];
+    ex->memo[b] = m;
+}
 
-    GraphQLValue** results = (GraphQLValue**)malloc(query->selection_count * sizeof(GraphQLValue*));
-    int result_count = 0;
+static const GqlPath* gql_path(GqlExec* ex, const GqlPath* parent, const char* key, size_t index) {
+    GqlPath* p = gql_alloc(&ex->pool, sizeof(GqlPath));
+    p->parent = parent;
+    p->key = key;
+    p->index = index;
+    return p;
+}
 
-    for (int i = 0; i < query->selection_count; i++) {
-        GraphQLField* field = find_field(operation_fields, field_count, query->selection_set[i].name);
+static const char* gql_raw(GqlExec* ex, const Value* v) {
+    size_t len = 0;
+    char* json = json_stringify_value(v, 0, &len);
+    if (!json) return "null";
+    const char* out = gql_strndup(&ex->pool, json, len);
+    free(json);
+    return out;
+}
+
+// Resolves one field for every item in group. results[i] is borrowed from
+// the parent, the memo or the kept list.
+static void gql_resolve_field(GqlExec* ex, const GqlFieldGroup* g, const char* type,
+                              GqlItem* items, size_t* group, size_t n, const Value** results) {
+    const GqlSelection* field = g->field;
+    GqlResolver* r = gql_resolver_find(ex->schema, type, field->name);
+    if (!r) {
+        for (size_t j = 0; j < n; j++) {
+            const Value* v = gql_struct_field(items[group[j]].parent, field->name);
+            results[j] = v ? v : &gql_null_value;
+        }
+        return;
+    }
+    Value args = gql_args_value(ex, field->args);
+    char* args_json = json_stringify_value(&args, 0, NULL);
+    char** keys = calloc(n, sizeof(char*));
+
+    size_t pending = 0;
+    for (size_t j = 0; j < n; j++) {
+        keys[j] = gql_memo_key(type, field->name, args_json ? args_json : "", items[group[j]].parent);
+        results[j] = gql_memo_get(ex, keys[j]);
+        if (!results[j]) pending++;
+    }
 
-        if (field) {
-            GraphQLValue* resolved = resolve_field(ctx, field);
-            if (resolved) {
-                results[result_count++] = resolved;
+    if (r->batch && pending > 0) {
+        // One call with every distinct parent; duplicates share a slot.
+        Array* parents = array_create(pending);
+        size_t* slot = malloc(n * sizeof(size_t));
+        for (size_t j = 0; j < n; j++) {
+            if (results[j]) continue;
+            slot[j] = parents->count;
+            for (size_t k = 0; k < j; k++) {
+                if (!results[k] && keys[k] && keys[j] && strcmp(keys[k], keys[j]) == 0) {
+                    slot[j] = slot[k];
+                    break;
+                }
+            }
+            if (slot[j] == parents->count) parents->items[parents->count++] = gql_clone(items[group[j]].parent);
+        }
+        Value call_args[2];
+        call_args[0] = (Value){ .type = VAL_ARRAY };
+        call_args[0].array_val = parents;
+        call_args[1] = args;
+        const Value* batch = gql_keep(ex, interpreter_execute_callback(r->fn, 2, call_args));
+        value_free(&call_args[0]);
+        bool ok = batch->type == VAL_ARRAY && batch->array_val && batch->array_val->count == parents->count;
+        if (!ok) {
+            char msg[160];
+            snprintf(msg, sizeof(msg), "Batch resolver %s.%s must return an array with one result per parent",
+                     type, field->name);
+            gql_add_error(ex, items[group[0]].path, msg);
+        }
+        for (size_t j = 0; j < n; j++) {
+            if (results[j]) continue;
+            results[j] = ok ? &batch->array_val->items[slot[j]] : &gql_null_value;
+            if (ok && keys[j] && !gql_memo_get(ex, keys[j])) {
+                gql_memo_put(ex, keys[j], results[j]);
+                keys[j] = NULL;
+            }
+        }
+        free(slot);
+    } else if (pending > 0) {
+        for (size_t j = 0; j < n; j++) {
+            if (results[j]) continue;
+            const Value* memo = gql_memo_get(ex, keys[j]);
+            if (memo) {
+                results[j] = memo;
+                continue;
             }
+            Value call_args[2];
+            call_args[0] = *items[group[j]].parent;
+            call_args[1] = args;
+            results[j] = gql_keep(ex, interpreter_execute_callback(r->fn, 2, call_args));
+            gql_memo_put(ex, keys[j], results[j]);
+            keys[j] = NULL;
         }
     }
+    for (size_t j = 0; j < n; j++) free(keys[j]);
+    free(keys);
+    free(args_json);
+    value_free(&args);
+}
 
-    if (result_count == 1) {
-        ctx->result = results[0];
-    } else if (result_count > 1) {
-        ctx->result = graphql_value_list(results, result_count);
-    } else {
-        ctx->result = graphql_value_null();
+typedef struct GqlItemList {
+    GqlItem* items;
+    size_t count;
+    size_t cap;
+} GqlItemList;
+
+static void gql_item_push(GqlItemList* list, GqlItem item) {
+    if (list->count == list->cap) {
+        list->cap = list->cap ? list->cap * 2 : 16;
+        list->items = realloc(list->items, list->cap * sizeof(GqlItem));
     }
+    list->items[list->count++] = item;
+}
 
-    return ctx;
+static const char* gql_type_of(const Value* v, const char* declared) {
+    const Value* tn = gql_struct_field(v, "__typename");
+    if (tn && tn->type == VAL_STRING) return tn->string_val;
+    if (declared) return declared;
+    if (v->type == VAL_STRUCT_INSTANCE && v->struct_instance && v->struct_instance->definition) {
+        return v->struct_instance->definition->name;
+    }
+    return NULL;
 }
 
-void graphql_context_free(GraphQLContext* ctx) {
-    if (!ctx) return;
-    if (ctx->result && ctx->result != graphql_value_null()) {
-        graphql_value_free(ctx->result);
+// Places a resolved value under a field that has a selection set: objects
+// become items for the next level, lists are walked.
+static void gql_complete_object(GqlExec* ex, const Value* v, const char* declared, GqlOut* out,
+                                const GqlPath* path, GqlItemList* next) {
+    if (!v || v->type == VAL_NULL) {
+        out->kind = OUT_NULL;
+        return;
+    }
+    if (v->type == VAL_ARRAY && v->array_val) {
+        Array* arr = v->array_val;
+        out->kind = OUT_LIST;
+        out->count = arr->count;
+        out->items = gql_alloc(&ex->pool, (arr->count ? arr->count : 1) * sizeof(GqlOut));
+        for (size_t i = 0; i < arr->count; i++) {
+            gql_complete_object(ex, &arr->items[i], declared, &out->items[i], gql_path(ex, path, NULL, i), next);
+        }
+        return;
+    }
+    if (v->type != VAL_STRUCT_INSTANCE) {
+        gql_add_error(ex, path, "Field with a selection set did not resolve to an object");
+        out->kind = OUT_NULL;
+        return;
     }
-    if (ctx->error) free(ctx->error);
-    free(ctx);
+    GqlItem item = { v, gql_type_of(v, declared), out, path };
+    gql_item_push(next, item);
 }
 
-struct GraphQLServer* graphql_server_create(GraphQLSchema* schema, int port) {
-    GraphQLServerImpl* server = (GraphQLServerImpl*)calloc(1, sizeof(GraphQLServerImpl));
-    server->fd = socket(AF_INET, SOCK_STREAM, 0);
-    server->schema = schema;
-    server->running = false;
+static void gql_execute_level(GqlExec* ex, const GqlSelection** sets, size_t nsets, GqlItem* items, size_t n);
+
+// Runs one field group for the items in group (all of one type).
+static void gql_execute_field(GqlExec* ex, const GqlFieldGroup* g, size_t index, const char* type,
+                              GqlItem* items, size_t* group, size_t n) {
+    const GqlSelection* field = g->field;
+    if (strcmp(field->name, "__typename") == 0) {
+        for (size_t j = 0; j < n; j++) {
+            GqlOut* o = &items[group[j]].out->items[index];
+            Value tn = make_string(type ? type : "");
+            o->kind = OUT_RAW;
+            o->raw = gql_raw(ex, &tn);
+            value_free(&tn);
+        }
+        return;
+    }
+    const Value** results = malloc(n * sizeof(Value*));
+    if (!results) return;
+    gql_resolve_field(ex, g, type, items, group, n, results);
+    GqlResolver* r = gql_resolver_find(ex->schema, type, field->name);
+    const char* declared = r ? r->returns : NULL;
+
+    if (g->subset_count == 0) {
+        for (size_t j = 0; j < n; j++) {
+            GqlOut* o = &items[group[j]].out->items[index];
+            if (results[j]->type == VAL_NULL) {
+                o->kind = OUT_NULL;
+            } else {
+                o->kind = OUT_RAW;
+                o->raw = gql_raw(ex, results[j]);
+            }
+        }
+        free(results);
+        return;
+    }
+    GqlItemList next = { NULL, 0, 0 };
+    for (size_t j = 0; j < n; j++) {
+        GqlItem* it = &items[group[j]];
+        gql_complete_object(ex, results[j], declared, &it->out->items[index],
+                            gql_path(ex, it->path, g->key, 0), &next);
+    }
+    free(results);
+    if (next.count > 0) gql_execute_level(ex, g->subsets, g->subset_count, next.items, next.count);
+    free(next.items);
+}
 
-    if (server->fd < 0) {
-        perror("socket");
-        free(server);
-        return NULL;
+// Executes merged selection sets over every item that reached them.
+static void gql_execute_level(GqlExec* ex, const GqlSelection** sets, size_t nsets, GqlItem* items, size_t n) {
+    if (++ex->depth > GRAPHQL_MAX_DEPTH) {
+        gql_add_error(ex, items[0].path, "Query nests too deeply");
+        for (size_t i = 0; i < n; i++) items[i].out->kind = OUT_NULL;
+        ex->depth--;
+        return;
     }
+    bool* done = calloc(n, sizeof(bool));
+    size_t* group = malloc(n * sizeof(size_t));
+    for (size_t first = 0; first < n; first++) {
+        if (done[first]) continue;
+        // Items are grouped by type so each group shares one field plan.
+        const char* type = items[first].type;
+        size_t m = 0;
+        for (size_t i = first; i < n; i++) {
+            const char* t = items[i].type;
+            if (done[i] || !((t == type) || (t && type && strcmp(t, type) == 0))) continue;
+            done[i] = true;
+            group[m++] = i;
+        }
+        GqlFieldList fields = { NULL, 0, 0 };
+        for (size_t s = 0; s < nsets; s++) gql_collect_fields(ex, sets[s], type, &fields, 0);
+        for (size_t j = 0; j < m; j++) {
+            GqlOut* out = items[group[j]].out;
+            out->kind = OUT_OBJECT;
+            out->count = fields.count;
+            out->keys = gql_alloc(&ex->pool, (fields.count ? fields.count : 1) * sizeof(char*));
+            out->items = gql_alloc(&ex->pool, (fields.count ? fields.count : 1) * sizeof(GqlOut));
+            for (size_t k = 0; k < fields.count; k++) out->keys[k] = fields.groups[k].key;
+        }
+        for (size_t k = 0; k < fields.count; k++) {
+            gql_execute_field(ex, &fields.groups[k], k, type, items, group, m);
+        }
+        gql_field_list_free(&fields);
+    }
+    free(group);
+    free(done);
+    ex->depth--;
+}
 
-    int opt = 1;
-    setsockopt(server->fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+// ---------------------------------------------------------------------------
+// Response serialization
+// ---------------------------------------------------------------------------
+
+typedef struct GqlBuf {
+    char* data;
+    size_t len;
+    size_t cap;
+} GqlBuf;
+
+static void gb_append(GqlBuf* b, const char* s, size_t n) {
+    if (b->len + n + 1 > b->cap) {
+        size_t cap = b->cap ? b->cap : 256;
+        while (cap < b->len + n + 1) cap *= 2;
+        b->data = realloc(b->data, cap);
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
 
-    struct sockaddr_in address;
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(port);
+static void gb_puts(GqlBuf* b, const char* s) {
+    gb_append(b, s, strlen(s));
+}
 
-    if (bind(server->fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
-        perror("bind");
-        close(server->fd);
-        free(server);
-        return NULL;
+static void gb_string(GqlBuf* b, const char* s) {
+    gb_append(b, "\"", 1);
+    for (const char* c = s; *c; c++) {
+        char esc[8];
+        switch (*c) {
+            case '"': gb_append(b, "\\\"", 2); break;
+            case '\\': gb_append(b, "\\\\", 2); break;
+            case '\n': gb_append(b, "\\n", 2); break;
+            case '\r': gb_append(b, "\\r", 2); break;
+            case '\t': gb_append(b, "\\t", 2); break;
+            default:
+                if ((unsigned char)*c < 0x20) {
+                    snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char)*c);
+                    gb_puts(b, esc);
+                } else {
+                    gb_append(b, c, 1);
+                }
+        }
     }
+    gb_append(b, "\"", 1);
+}
 
-    if (listen(server->fd, 10) < 0) {
-        perror("listen");
-        close(server->fd);
-        free(server);
-        return NULL;
+static void gb_out(GqlBuf* b, const GqlOut* o) {
+    switch (o->kind) {
+        case OUT_NULL:
+            gb_puts(b, "null");
+            return;
+        case OUT_RAW:
+            gb_puts(b, o->raw);
+            return;
+        case OUT_LIST:
+            gb_append(b, "[", 1);
+            for (size_t i = 0; i < o->count; i++) {
+                if (i) gb_append(b, ",", 1);
+                gb_out(b, &o->items[i]);
+            }
+            gb_append(b, "]", 1);
+            return;
+        case OUT_OBJECT:
+            gb_append(b, "{", 1);
+            for (size_t i = 0; i < o->count; i++) {
+                if (i) gb_append(b, ",", 1);
+                gb_string(b, o->keys[i]);
+                gb_append(b, ":", 1);
+                gb_out(b, &o->items[i]);
+            }
+            gb_append(b, "}", 1);
+            return;
+    }
+}
+
+static void gb_path(GqlBuf* b, const GqlPath* p, bool* first) {
+    if (!p) return;
+    gb_path(b, p->parent, first);
+    if (!*first) gb_append(b, ",", 1);
+    *first = false;
+    if (p->key) {
+        gb_string(b, p->key);
+    } else {
+        char num[32];
+        snprintf(num, sizeof(num), "%zu", p->index);
+        gb_puts(b, num);
+    }
+}
+
+static void gb_errors(GqlBuf* b, const GqlError* errors) {
+    gb_puts(b, "\"errors\":[");
+    for (const GqlError* e = errors; e; e = e->next) {
+        if (e != errors) gb_append(b, ",", 1);
+        gb_puts(b, "{\"message\":");
+        gb_string(b, e->message);
+        if (e->path) {
+            gb_puts(b, ",\"path\":[");
+            bool first = true;
+            gb_path(b, e->path, &first);
+            gb_append(b, "]", 1);
+        }
+        gb_append(b, "}", 1);
     }
+    gb_append(b, "]", 1);
+}
 
-    server->running = true;
-    printf("GraphQL server listening on port %d\n", port);
-    return (struct GraphQLServer*)server;
+static char* gql_error_response(const char* message, size_t* out_len) {
+    GqlBuf b = { NULL, 0, 0 };
+    gb_puts(&b, "{\"errors\":[{\"message\":");
+    gb_string(&b, message);
+    gb_puts(&b, "}]}");
+    if (out_len) *out_len = b.len;
+    return b.data;
 }
 
-void graphql_server_free(struct GraphQLServer* server) {
-    if (!server) return;
+static GqlOperation* gql_pick_operation(GqlDocument* doc, const char* name, char* error, size_t error_len) {
+    if (name && *name) {
+        for (GqlOperation* op = doc->ops; op; op = op->next) {
+            if (op->name && strcmp(op->name, name) == 0) return op;
+        }
+        snprintf(error, error_len, "Unknown operation named \"%s\".", name);
+        return NULL;
+    }
+    if (doc->ops->next) {
+        snprintf(error, error_len, "Must provide operation name if query contains multiple operations.");
+        return NULL;
+    }
+    return doc->ops;
+}
 
-    GraphQLServerImpl* impl = (GraphQLServerImpl*)server;
+static char* gql_execute(GqlSchema* schema, const char* query, const Value* variables,
+                         const char* operation, size_t* out_len) {
+    char error[200];
+    GqlDocument* doc = gql_document_get(query, error, sizeof(error));
+    if (!doc) return gql_error_response(error, out_len);
+    GqlOperation* op = gql_pick_operation(doc, operation, error, sizeof(error));
+    if (!op || op->kind == GQL_SUBSCRIPTION) {
+        if (op) snprintf(error, sizeof(error), "Subscriptions are not supported.");
+        gql_document_release(doc);
+        return gql_error_response(error, out_len);
+    }
+    if (variables && variables->type != VAL_STRUCT_INSTANCE) variables = NULL;
+    for (GqlVarDef* d = op->vars; d; d = d->next) {
+        const Value* given = gql_struct_field(variables, d->name);
+        if (d->non_null && !d->def && (!given || given->type == VAL_NULL)) {
+            snprintf(error, sizeof(error), "Variable \"$%s\" of required type \"%s\" was not provided.", d->name, d->type);
+            gql_document_release(doc);
+            return gql_error_response(error, out_len);
+        }
+    }
 
-    if (impl->fd >= 0) {
-        close(impl->fd);
+    GqlExec ex;
+    memset(&ex, 0, sizeof(ex));
+    ex.schema = schema;
+    ex.doc = doc;
+    ex.variables = variables;
+    ex.var_defs = op->vars;
+    ex.errors_tail = &ex.errors;
+
+    GqlOut* root = gql_alloc(&ex.pool, sizeof(GqlOut));
+    GqlItem item = { &gql_null_value, op->kind == GQL_MUTATION ? "Mutation" : "Query", root, NULL };
+    const GqlSelection* sets[1] = { op->selections };
+    gql_execute_level(&ex, sets, 1, &item, 1);
+
+    GqlBuf b = { NULL, 0, 0 };
+    gb_puts(&b, "{\"data\":");
+    gb_out(&b, root);
+    if (ex.errors) {
+        gb_append(&b, ",", 1);
+        gb_errors(&b, ex.errors);
+    }
+    gb_append(&b, "}", 1);
+
+    for (size_t i = 0; i < GQL_MEMO_BUCKETS; i++) {
+        GqlMemo* m = ex.memo[i];
+        while (m) {
+            GqlMemo* next = m->next;
+            free(m->key);
+            free(m);
+            m = next;
+        }
+    }
+    while (ex.kept) {
+        GqlKept* next = ex.kept->next;
+        value_free(&ex.kept->value);
+        free(ex.kept);
+        ex.kept = next;
     }
+    gql_pool_free(&ex.pool);
+    gql_document_release(doc);
+    if (out_len) *out_len = b.len;
+    return b.data;
+}
 
-    free(impl);
+char* graphql_execute_json(const char* schema_id, const char* query, const Value* variables,
+                           const char* operation, size_t* out_len) {
+    GqlSchema* schema = gql_schema_find(schema_id);
+    if (!schema || !query) return NULL;
+    return gql_execute(schema, query, variables, operation, out_len);
 }
 
-int graphql_server_listen(struct GraphQLServer* server) {
-    GraphQLServerImpl* impl = (GraphQLServerImpl*)server;
+// ---------------------------------------------------------------------------
+// HTTP endpoint on net.http_server
+// ---------------------------------------------------------------------------
+
+static char* gql_url_decode(const char* s, size_t len) {
+    char* out = malloc(len + 1);
+    if (!out) return NULL;
+    size_t o = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '+') {
+            out[o++] = ' ';
+        } else if (s[i] == '%' && i + 2 < len && isxdigit((unsigned char)s[i + 1]) && isxdigit((unsigned char)s[i + 2])) {
+            char hex[3] = { s[i + 1], s[i + 2], 0 };
+            out[o++] = (char)strtol(hex, NULL, 16);
+            i += 2;
+        } else {
+            out[o++] = s[i];
+        }
+    }
+    out[o] = '\0';
+    return out;
+}
 
-    while (impl->running) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int client_fd = accept(impl->fd, (struct sockaddr*)&client_addr, &client_len);
+static char* gql_query_param(const char* qs, const char* name) {
+    size_t nlen = strlen(name);
+    for (const char* p = qs; p && *p;) {
+        const char* amp = strchr(p, '&');
+        size_t seg = amp ? (size_t)(amp - p) : strlen(p);
+        if (seg > nlen && strncmp(p, name, nlen) == 0 && p[nlen] == '=') {
+            return gql_url_decode(p + nlen + 1, seg - nlen - 1);
+        }
+        p = amp ? amp + 1 : NULL;
+    }
+    return NULL;
+}
 
-        if (client_fd >= 0) {
-            char buffer[4096];
-            ssize_t len = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
+// GET ?query=&variables=&operationName= or POST with a JSON body
+// {"query", "variables", "operationName"}; any other POST body is taken as
+// the query text itself (application/graphql).
+static char* gql_http_handler(void* user, const char* method, const char* query_string,
+                              const char* body, size_t body_len, int* status,
+                              const char** content_type, size_t* out_len) {
+    GqlSchema* schema = user;
+    *content_type = "application/json";
+    *status = 200;
+    char* query = NULL;
+    char* operation = NULL;
+    Value request = make_null();
+    Value variables = make_null();
+    char error[160] = "";
+
+    if (method && strcasecmp(method, "GET") == 0) {
+        query = gql_query_param(query_string, "query");
+        operation = gql_query_param(query_string, "operationName");
+        char* vars = gql_query_param(query_string, "variables");
+        if (vars && *vars && !json_parse_text(vars, strlen(vars), &variables, error, sizeof(error))) {
+            variables = make_null();
+        }
+        free(vars);
+    } else if (body && body_len > 0) {
+        size_t i = 0;
+        while (i < body_len && isspace((unsigned char)body[i])) i++;
+        // A query document also starts with '{', so only a body that parses
+        // as JSON is treated as a request object.
+        if (i < body_len && body[i] == '{' && json_parse_text(body, body_len, &request, error, sizeof(error))) {
+            const Value* q = gql_struct_field(&request, "query");
+            const Value* v = gql_struct_field(&request, "variables");
+            const Value* o = gql_struct_field(&request, "operationName");
+            if (q && q->type == VAL_STRING) query = strdup(q->string_val);
+            if (o && o->type == VAL_STRING) operation = strdup(o->string_val);
+            if (v && v->type == VAL_STRUCT_INSTANCE) variables = gql_clone(v);
+        } else {
+            error[0] = '\0';
+            query = strndup(body, body_len);
+        }
+    }
 
-            if (len > 0) {
-                buffer[len] = '\0';
+    char* out;
+    if (error[0]) {
+        *status = 400;
+        char msg[200];
+        snprintf(msg, sizeof(msg), "Invalid JSON: %s", error);
+        out = gql_error_response(msg, out_len);
+    } else if (!query) {
+        *status = 400;
+        out = gql_error_response("Must provide query string.", out_len);
+    } else {
+        out = gql_execute(schema, query, &variables, operation, out_len);
+    }
+    free(query);
+    free(operation);
+    value_free(&request);
+    value_free(&variables);
+    return out;
+}
 
-                char* error = NULL;
-                GraphQLQuery* query = graphql_parse(buffer, &error);
+// ---------------------------------------------------------------------------
+// Natives
+// ---------------------------------------------------------------------------
 
-                if (query) {
-                    GraphQLContext* ctx = graphql_execute(impl->schema, query, NULL);
+static GqlSchema* schema_arg(int argc, Value* args, const char* fn) {
+    GqlSchema* schema = argc >= 1 && args[0].type == VAL_STRING ? gql_schema_find(args[0].string_val) : NULL;
+    if (!schema) fprintf(stderr, "⚠️ GraphQL Error: %s expects a schema handle\n", fn);
+    return schema;
+}
 
-                    char* json_result = graphql_value_to_json(ctx->result);
+// graphql.schema() -> schema handle
+static Value native_graphql_schema(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    (void)argc;
+    (void)args;
+    GqlSchema* schema = calloc(1, sizeof(GqlSchema));
+    if (!schema) return make_null();
+    uv_once(&gql_once, gql_init_lock);
+    uv_mutex_lock(&gql_lock);
+    snprintf(schema->id, sizeof(schema->id), "graphql_schema_%ld", gql_next_schema_id++);
+    schema->next = gql_schemas;
+    gql_schemas = schema;
+    uv_mutex_unlock(&gql_lock);
+    return make_string(schema->id);
+}
 
-                    char response[8192];
-                    snprintf(response, sizeof(response),
-                        "{\n"
-                        "  \"data\": %s%s%s\n"
-                        "}\n",
-                        json_result ? json_result : "null",
-                        ctx->error ? ",\n  \"errors\": [{" : "",
-                        ctx->error ? ctx->error : "");
+static Value gql_add_resolver(int argc, Value* args, bool batch, const char* fn_name) {
+    GqlSchema* schema = schema_arg(argc, args, fn_name);
+    if (!schema) return make_bool(false);
+    const char* coord = argc >= 2 && args[1].type == VAL_STRING ? args[1].string_val : NULL;
+    const char* dot = coord ? strchr(coord, '.') : NULL;
+    if (!dot || dot == coord || !dot[1] || argc < 3 || args[2].type != VAL_FUNCTION) {
+        fprintf(stderr, "⚠️ GraphQL Error: %s expects (\"Type.field\", function, [return_type])\n", fn_name);
+        return make_bool(false);
+    }
+    char* type = strndup(coord, (size_t)(dot - coord));
+    GqlResolver* r = gql_resolver_find(schema, type, dot + 1);
+    if (r) {
+        value_free(&r->fn);
+        free(r->returns);
+        free(type);
+    } else {
+        r = calloc(1, sizeof(GqlResolver));
+        r->type = type;
+        r->field = strdup(dot + 1);
+        r->next = schema->resolvers;
+        schema->resolvers = r;
+    }
+    r->fn = args[2];
+    args[2] = make_null();  // moved into the schema
+    r->batch = batch;
+    r->returns = argc >= 4 && args[3].type == VAL_STRING ? strdup(args[3].string_val) : NULL;
+    return make_bool(true);
+}
 
-                    send(client_fd, response, strlen(response), 0);
+// schema.resolve("Type.field", fn(parent, args), [return_type])
+static Value native_graphql_schema_resolve(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    return gql_add_resolver(argc, args, false, "schema.resolve");
+}
 
-                    free(json_result);
-                    graphql_context_free(ctx);
-                    graphql_query_free(query);
-                }
+// schema.batch("Type.field", fn(parents, args), [return_type]); fn returns
+// an array with one result per parent, in order.
+static Value native_graphql_schema_batch(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    return gql_add_resolver(argc, args, true, "schema.batch");
+}
 
-                close(client_fd);
-            }
+// schema.execute(query, [variables], [operation_name]) -> JSON response text.
+// variables may be a struct (e.g. from json.parse) or JSON text.
+static Value native_graphql_schema_execute(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    GqlSchema* schema = schema_arg(argc, args, "schema.execute");
+    if (!schema || argc < 2 || args[1].type != VAL_STRING) return make_null();
+    Value parsed = make_null();
+    const Value* variables = NULL;
+    if (argc >= 3 && args[2].type == VAL_STRUCT_INSTANCE) {
+        variables = &args[2];
+    } else if (argc >= 3 && args[2].type == VAL_STRING && args[2].string_val[0]) {
+        char error[128];
+        if (!json_parse_text(args[2].string_val, strlen(args[2].string_val), &parsed, error, sizeof(error))) {
+            char msg[160];
+            snprintf(msg, sizeof(msg), "Invalid variables: %s", error);
+            char* out = gql_error_response(msg, NULL);
+            return (Value){ .type = VAL_STRING, .string_val = out };
         }
+        variables = &parsed;
     }
+    const char* operation = argc >= 4 && args[3].type == VAL_STRING ? args[3].string_val : NULL;
+    char* out = gql_execute(schema, args[1].string_val, variables, operation, NULL);
+    value_free(&parsed);
+    return (Value){ .type = VAL_STRING, .string_val = out };
+}
+
+// schema.serve(server, [path = "/graphql"]) mounts the schema on a
+// net.http_server for GET and POST.
+static Value native_graphql_schema_serve(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    GqlSchema* schema = schema_arg(argc, args, "schema.serve");
+    if (!schema || argc < 2 || args[1].type != VAL_STRING) return make_bool(false);
+    const char* path = argc >= 3 && args[2].type == VAL_STRING ? args[2].string_val : "/graphql";
+    bool ok = net_route_native(args[1].string_val, path, "GET", gql_http_handler, schema) &&
+              net_route_native(args[1].string_val, path, "POST", gql_http_handler, schema);
+    return make_bool(ok);
+}
 
-    return 0;
+// graphql.validate(query) -> "" when the document parses, else the error.
+static Value native_graphql_validate(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) return make_string("Must provide query string.");
+    char error[200];
+    GqlDocument* doc = gql_document_get(args[0].string_val, error, sizeof(error));
+    if (!doc) return make_string(error);
+    gql_document_release(doc);
+    return make_string("");
 }
 
-void graphql_server_stop(struct GraphQLServer* server) {
-    if (!server) return;
+// graphql.cache_stats() -> [hits, misses, cached_documents]
+static Value native_graphql_cache_stats(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    (void)argc;
+    (void)args;
+    Array* stats = array_create(3);
+    uv_once(&gql_once, gql_init_lock);
+    uv_mutex_lock(&gql_lock);
+    stats->items[stats->count++] = make_int(gql_cache_hits);
+    stats->items[stats->count++] = make_int(gql_cache_misses);
+    stats->items[stats->count++] = make_int(gql_cache_count);
+    uv_mutex_unlock(&gql_lock);
+    Value result = { .type = VAL_ARRAY };
+    result.array_val = stats;
+    return result;
+}
 
-    GraphQLServerImpl* impl = (GraphQLServerImpl*)server;
-    impl->running = false;
+void stdlib_graphql_register(void) {
+    register_native("graphql.schema", native_graphql_schema);
+    register_native("graphql.schema_resolve", native_graphql_schema_resolve);
+    register_native("graphql.schema_batch", native_graphql_schema_batch);
+    register_native("graphql.schema_execute", native_graphql_schema_execute);
+    register_native("graphql.schema_serve", native_graphql_schema_serve);
+    register_native("graphql.validate", native_graphql_validate);
+    register_native("graphql.cache_stats", native_graphql_cache_stats);
+    register_handle_methods("graphql_schema_", "graphql.schema_");
 }
@@ -1,14 +1,50 @@
 #define _POSIX_C_SOURCE 200809L
 #include "stdlib_io.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Helper to check argument count
 static bool check_argc(int argc, int expected) {
     return argc == expected;
 }
 
+// Reads a whole file into a NUL-terminated buffer of *cap_out bytes.
+static char* read_whole_file(const char* path, size_t* len_out, size_t* cap_out) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    
+    // The size comes from the descriptor; pipes and /proc files report 0
+    // and are read until EOF instead.
+    struct stat st;
+    size_t cap = (fstat(fileno(file), &st) == 0 && st.st_size > 0) ? (size_t)st.st_size + 1 : IO_STREAM_BUFFER_SIZE;
+    char* buffer = malloc(cap);
+    if (!buffer) {
+        fclose(file);
+        return NULL;
+    }
+    
+    size_t length = 0;
+    size_t n;
+    while ((n = fread(buffer + length, 1, cap - length - 1, file)) > 0) {
+        length += n;
+        if (length + 1 == cap) {
+            cap *= 2;
+            buffer = realloc(buffer, cap);
+        }
+    }
+    buffer[length] = '\0';
+    fclose(file);
+    *len_out = length;
+    *cap_out = cap;
+    return buffer;
+}
+
 Value native_io_read_file(struct Interpreter* interp, int argc, Value* args) {
     (void)interp; // Unused
     
@@ -19,39 +55,35 @@ Value native_io_read_file(struct Interpreter* interp, int argc, Value* args) {
         return v;
     }
     
-    FILE* file = fopen(args[0].string_val, "rb");
-    if (!file) {
-        Value v;
-        v.type = VAL_NULL;
-        return v;
-    }
-    
-    fseek(file, 0, SEEK_END);
-    long length = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    char* buffer = malloc(length + 1);
+    size_t length, cap;
+    char* buffer = read_whole_file(args[0].string_val, &length, &cap);
     if (!buffer) {
-        fclose(file);
         Value v;
         v.type = VAL_NULL;
         return v;
     }
     
-    fread(buffer, 1, length, file);
-    buffer[length] = '\0';
-    fclose(file);
-    
     Value v;
     v.type = VAL_STRING;
     v.string_val = buffer; // Ownership transferred to Value
     return v;
 }
 
+// io.read_file_bytes(path) -> bytes or null, NUL bytes included.
+Value native_io_read_file_bytes(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (!check_argc(argc, 1) || args[0].type != VAL_STRING) return make_null();
+    size_t length, cap;
+    char* buffer = read_whole_file(args[0].string_val, &length, &cap);
+    if (!buffer) return make_null();
+    return make_bytes_owned((unsigned char*)buffer, length, cap);
+}
+
 Value native_io_write_file(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
     
-    if (!check_argc(argc, 2) || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
+    if (!check_argc(argc, 2) || args[0].type != VAL_STRING ||
+        (args[1].type != VAL_STRING && args[1].type != VAL_BYTES)) {
         Value v;
         v.type = VAL_BOOL;
         v.bool_val = false;
@@ -66,7 +98,9 @@ Value native_io_write_file(struct Interpreter* interp, int argc, Value* args) {
         return v;
     }
     
-    fwrite(args[1].string_val, 1, strlen(args[1].string_val), file);
+    size_t len = 0;
+    const unsigned char* data = value_bytes(&args[1], &len);
+    fwrite(data, 1, len, file);
     fclose(file);
     
     Value v;
@@ -114,7 +148,8 @@ Value native_io_delete_file(struct Interpreter* interp, int argc, Value* args) {
 Value native_io_append_file(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
     
-    if (!check_argc(argc, 2) || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
+    if (!check_argc(argc, 2) || args[0].type != VAL_STRING ||
+        (args[1].type != VAL_STRING && args[1].type != VAL_BYTES)) {
         Value v;
         v.type = VAL_BOOL;
         v.bool_val = false;
@@ -129,7 +164,9 @@ Value native_io_append_file(struct Interpreter* interp, int argc, Value* args) {
         return v;
     }
     
-    fwrite(args[1].string_val, 1, strlen(args[1].string_val), file);
+    size_t len = 0;
+    const unsigned char* data = value_bytes(&args[1], &len);
+    fwrite(data, 1, len, file);
     fclose(file);
     
     Value v;
@@ -206,14 +243,651 @@ Value native_io_read_line(struct Interpreter* __attribute__((unused)) interp, in
     return v;
 }
 
+// ============================================================================
+// Memory-mapped views
+// ============================================================================
+
+typedef struct MappedFile {
+    long id;
+    char handle[32];
+    char* data;
+    size_t size;
+    size_t pos;              // cursor for read_line()/lines()
+    ByteBuffer* buf;         // set once bytes() has handed out views
+    struct MappedFile* next;
+} MappedFile;
+
+static MappedFile* mapped_files = NULL;
+static long next_mapped_id = 1;
+
+static MappedFile* mmap_find(const Value* v) {
+    if (v->type != VAL_STRING) return NULL;
+    for (MappedFile* m = mapped_files; m; m = m->next) {
+        if (strcmp(m->handle, v->string_val) == 0) return m;
+    }
+    return NULL;
+}
+
+static int mmap_advice(const char* name) {
+    if (!name || strcmp(name, "sequential") == 0) return MADV_SEQUENTIAL;
+    if (strcmp(name, "random") == 0) return MADV_RANDOM;
+    if (strcmp(name, "willneed") == 0) return MADV_WILLNEED;
+    if (strcmp(name, "dontneed") == 0) return MADV_DONTNEED;
+    return MADV_NORMAL;
+}
+
+// Copies [start, start + len) out as a string.
+static Value string_from_range(const char* start, size_t len) {
+    char* out = malloc(len + 1);
+    memcpy(out, start, len);
+    out[len] = '\0';
+    return (Value){ .type = VAL_STRING, .string_val = out };
+}
+
+// Next line from data[*pos..size) without its "\n" or "\r\n"; null at the end.
+static Value next_line(const char* data, size_t size, size_t* pos) {
+    if (*pos >= size) return make_null();
+    const char* start = data + *pos;
+    const char* nl = memchr(start, '\n', size - *pos);
+    size_t len = nl ? (size_t)(nl - start) : size - *pos;
+    *pos += len + (nl ? 1 : 0);
+    if (len > 0 && start[len - 1] == '\r') len--;
+    return string_from_range(start, len);
+}
+
+// io.mmap(path, [advice]) -> "mmap_<n>" or null
+Value native_io_mmap(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) return make_null();
+    int fd = open(args[0].string_val, O_RDONLY);
+    if (fd < 0) return make_null();
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return make_null();
+    }
+    char* data = NULL;
+    if (st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return make_null();
+        }
+        madvise(data, (size_t)st.st_size, mmap_advice(argc >= 2 && args[1].type == VAL_STRING ? args[1].string_val : NULL));
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+
+    MappedFile* m = calloc(1, sizeof(MappedFile));
+    m->id = next_mapped_id++;
+    snprintf(m->handle, sizeof(m->handle), "mmap_%ld", m->id);
+    m->data = data;
+    m->size = (size_t)st.st_size;
+    m->next = mapped_files;
+    mapped_files = m;
+    return make_string(m->handle);
+}
+
+// m.len() -> size in bytes
+Value native_io_mmap_len(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MappedFile* m = argc >= 1 ? mmap_find(&args[0]) : NULL;
+    return make_int(m ? (long long)m->size : -1);
+}
+
+// m.slice(offset, length) -> copy of that range as a string
+Value native_io_mmap_slice(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MappedFile* m = argc >= 3 ? mmap_find(&args[0]) : NULL;
+    if (!m || args[1].type != VAL_INT || args[2].type != VAL_INT || args[1].int_val < 0 || args[2].int_val < 0) {
+        return make_null();
+    }
+    size_t off = (size_t)args[1].int_val;
+    if (off > m->size) off = m->size;
+    size_t len = (size_t)args[2].int_val;
+    if (len > m->size - off) len = m->size - off;
+    return string_from_range(m->data + off, len);
+}
+
+// m.byte(offset) -> 0..255, or -1 out of range
+Value native_io_mmap_byte(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MappedFile* m = argc >= 2 ? mmap_find(&args[0]) : NULL;
+    if (!m || args[1].type != VAL_INT || args[1].int_val < 0 || (size_t)args[1].int_val >= m->size) {
+        return make_int(-1);
+    }
+    return make_int((unsigned char)m->data[args[1].int_val]);
+}
+
+// m.find(needle, [from]) -> offset of the next occurrence, or -1. needle
+// is a string or bytes.
+Value native_io_mmap_find(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MappedFile* m = argc >= 2 ? mmap_find(&args[0]) : NULL;
+    size_t nlen = 0;
+    const unsigned char* needle = m ? value_bytes(&args[1], &nlen) : NULL;
+    if (!needle) return make_int(-1);
+    size_t from = (argc >= 3 && args[2].type == VAL_INT && args[2].int_val > 0) ? (size_t)args[2].int_val : 0;
+    if (from >= m->size || nlen == 0) return make_int(nlen == 0 && from <= m->size ? (long long)from : -1);
+    const char* hit = memmem(m->data + from, m->size - from, needle, nlen);
+    return make_int(hit ? (long long)(hit - m->data) : -1);
+}
+
+// m.count(needle) -> non-overlapping occurrences in the whole view
+Value native_io_mmap_count(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MappedFile* m = argc >= 2 ? mmap_find(&args[0]) : NULL;
+    if (!m || args[1].type != VAL_STRING || !args[1].string_val[0]) return make_int(0);
+    size_t nlen = strlen(args[1].string_val);
+    long long count = 0;
+    const char* p = m->data;
+    const char* end = m->data + m->size;
+    while (p && (size_t)(end - p) >= nlen) {
+        p = nlen == 1 ? memchr(p, args[1].string_val[0], (size_t)(end - p))
+                      : memmem(p, (size_t)(end - p), args[1].string_val, nlen);
+        if (!p) break;
+        count++;
+        p += nlen;
+    }
+    return make_int(count);
+}
+
+// m.read_line() -> next line from the view's cursor, or null at the end
+Value native_io_mmap_read_line(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MappedFile* m = argc >= 1 ? mmap_find(&args[0]) : NULL;
+    return m ? next_line(m->data, m->size, &m->pos) : make_null();
+}
+
+// m.lines() -> the view itself, rewound, for `cruise (line in m.lines())`
+Value native_io_mmap_lines(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MappedFile* m = argc >= 1 ? mmap_find(&args[0]) : NULL;
+    if (!m) return make_null();
+    m->pos = 0;
+    return make_string(m->handle);
+}
+
+static void mmap_buffer_release(ByteBuffer* buf) {
+    munmap(buf->data, buf->capacity);
+}
+
+// m.bytes([offset], [length]) -> bytes viewing the mapping without a copy.
+// Views keep the mapping alive after m.close(). The mapping is read-only,
+// so bytes.set and bytes.write_* refuse them; bytes.copy gives a writable
+// copy.
+Value native_io_mmap_bytes(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MappedFile* m = argc >= 1 ? mmap_find(&args[0]) : NULL;
+    if (!m) return make_null();
+    size_t off = (argc >= 2 && args[1].type == VAL_INT && args[1].int_val > 0) ? (size_t)args[1].int_val : 0;
+    if (off > m->size) off = m->size;
+    size_t len = m->size - off;
+    if (argc >= 3 && args[2].type == VAL_INT && args[2].int_val >= 0 && (size_t)args[2].int_val < len) {
+        len = (size_t)args[2].int_val;
+    }
+    if (m->size == 0) return make_bytes(NULL, 0);
+    if (!m->buf) {
+        m->buf = calloc(1, sizeof(ByteBuffer));
+        m->buf->refcount = 1;
+        m->buf->data = (unsigned char*)m->data;
+        m->buf->length = m->buf->capacity = m->size;
+        m->buf->release = mmap_buffer_release;
+    }
+    return make_bytes_view(m->buf, off, len);
+}
+
+// m.advise("sequential" | "random" | "willneed" | "dontneed" | "normal")
+Value native_io_mmap_advise(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MappedFile* m = argc >= 2 ? mmap_find(&args[0]) : NULL;
+    if (!m || args[1].type != VAL_STRING) return make_bool(false);
+    return make_bool(m->size == 0 || madvise(m->data, m->size, mmap_advice(args[1].string_val)) == 0);
+}
+
+Value native_io_mmap_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MappedFile* m = argc >= 1 ? mmap_find(&args[0]) : NULL;
+    if (!m) return make_bool(false);
+    MappedFile** cur = &mapped_files;
+    while (*cur != m) cur = &(*cur)->next;
+    *cur = m->next;
+    if (m->buf) {
+        byte_buffer_release(m->buf);
+    } else if (m->data) {
+        munmap(m->data, m->size);
+    }
+    free(m);
+    return make_bool(true);
+}
+
+// ============================================================================
+// Buffered streams
+// ============================================================================
+
+typedef struct FileStream {
+    long id;
+    char handle[32];
+    int fd;
+    bool writable;
+    char* rbuf;              // read buffer: unread bytes are rbuf[rpos..rlen)
+    size_t rcap;
+    size_t rpos;
+    size_t rlen;
+    bool eof;
+    char* wbuf;              // pending writes
+    size_t wlen;
+    struct FileStream* next;
+} FileStream;
+
+static FileStream* file_streams = NULL;
+static long next_stream_id = 1;
+
+static FileStream* stream_find(const Value* v) {
+    if (v->type != VAL_STRING) return NULL;
+    for (FileStream* f = file_streams; f; f = f->next) {
+        if (strcmp(f->handle, v->string_val) == 0) return f;
+    }
+    return NULL;
+}
+
+static bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool stream_flush(FileStream* f) {
+    bool ok = f->wlen == 0 || write_all(f->fd, f->wbuf, f->wlen);
+    f->wlen = 0;
+    return ok;
+}
+
+// Tops up the read buffer, keeping unread bytes. Returns false at EOF
+// with nothing new.
+static bool stream_fill(FileStream* f) {
+    if (f->eof) return false;
+    if (f->rpos > 0) {
+        memmove(f->rbuf, f->rbuf + f->rpos, f->rlen - f->rpos);
+        f->rlen -= f->rpos;
+        f->rpos = 0;
+    }
+    if (f->rlen == f->rcap) {
+        f->rcap *= 2;
+        f->rbuf = realloc(f->rbuf, f->rcap);
+    }
+    ssize_t n;
+    do {
+        n = read(f->fd, f->rbuf + f->rlen, f->rcap - f->rlen);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        f->eof = true;
+        return false;
+    }
+    f->rlen += (size_t)n;
+    return true;
+}
+
+// io.open(path, [mode]) -> "file_<n>" or null. mode is "r" (default),
+// "w" (truncate) or "a" (append).
+Value native_io_open(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) return make_null();
+    const char* mode = (argc >= 2 && args[1].type == VAL_STRING) ? args[1].string_val : "r";
+    int flags;
+    if (strcmp(mode, "r") == 0) flags = O_RDONLY;
+    else if (strcmp(mode, "w") == 0) flags = O_WRONLY | O_CREAT | O_TRUNC;
+    else if (strcmp(mode, "a") == 0) flags = O_WRONLY | O_CREAT | O_APPEND;
+    else return make_null();
+    int fd = open(args[0].string_val, flags | O_CLOEXEC, 0644);
+    if (fd < 0) return make_null();
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (flags == O_RDONLY) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    FileStream* f = calloc(1, sizeof(FileStream));
+    f->id = next_stream_id++;
+    snprintf(f->handle, sizeof(f->handle), "file_%ld", f->id);
+    f->fd = fd;
+    f->writable = flags != O_RDONLY;
+    if (f->writable) {
+        f->wbuf = malloc(IO_WRITE_BUFFER_SIZE);
+    } else {
+        f->rcap = IO_STREAM_BUFFER_SIZE;
+        f->rbuf = malloc(f->rcap);
+    }
+    f->next = file_streams;
+    file_streams = f;
+    return make_string(f->handle);
+}
+
+static Value stream_read(int argc, Value* args, bool as_bytes) {
+    FileStream* f = argc >= 2 ? stream_find(&args[0]) : NULL;
+    if (!f || f->writable || args[1].type != VAL_INT || args[1].int_val <= 0) return make_null();
+    size_t want = (size_t)args[1].int_val;
+    if (f->rlen - f->rpos < want) {
+        // Larger requests read straight into the result.
+        size_t have = f->rlen - f->rpos;
+        char* out = malloc(want + 1);
+        memcpy(out, f->rbuf + f->rpos, have);
+        f->rpos = f->rlen = 0;
+        while (have < want && !f->eof) {
+            ssize_t n = read(f->fd, out + have, want - have);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) f->eof = true;
+            else have += (size_t)n;
+        }
+        if (have == 0) {
+            free(out);
+            return make_null();
+        }
+        out[have] = '\0';
+        if (as_bytes) return make_bytes_owned((unsigned char*)out, have, want + 1);
+        return (Value){ .type = VAL_STRING, .string_val = out };
+    }
+    Value v = as_bytes ? make_bytes(f->rbuf + f->rpos, want) : string_from_range(f->rbuf + f->rpos, want);
+    f->rpos += want;
+    return v;
+}
+
+// f.read(n) -> up to n bytes as a string, or null at EOF
+Value native_io_file_read(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    return stream_read(argc, args, false);
+}
+
+// f.read_bytes(n) -> up to n bytes as bytes, or null at EOF
+Value native_io_file_read_bytes(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    return stream_read(argc, args, true);
+}
+
+// f.read_line() -> next line without its terminator, or null at EOF
+Value native_io_file_read_line(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    FileStream* f = argc >= 1 ? stream_find(&args[0]) : NULL;
+    if (!f || f->writable) return make_null();
+    size_t scanned = 0;
+    for (;;) {
+        const char* start = f->rbuf + f->rpos;
+        size_t avail = f->rlen - f->rpos;
+        const char* nl = memchr(start + scanned, '\n', avail - scanned);
+        if (nl || (!stream_fill(f) && avail > 0)) {
+            start = f->rbuf + f->rpos;
+            size_t pos = 0;
+            Value line = next_line(start, nl ? (size_t)(nl - start) + 1 : avail, &pos);
+            f->rpos += pos;
+            return line;
+        }
+        if (f->rlen - f->rpos == 0) return make_null();
+        scanned = avail;
+    }
+}
+
+// f.lines() -> the stream itself, for `cruise (line in f.lines())`
+Value native_io_file_lines(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    FileStream* f = argc >= 1 ? stream_find(&args[0]) : NULL;
+    return f ? make_string(f->handle) : make_null();
+}
+
+// f.write(data) -> bool. data is a string or bytes. Buffered; writes of a
+// buffer or more go straight out.
+Value native_io_file_write(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    FileStream* f = argc >= 2 ? stream_find(&args[0]) : NULL;
+    size_t len = 0;
+    const char* data = f ? (const char*)value_bytes(&args[1], &len) : NULL;
+    if (!data || !f->writable) return make_bool(false);
+    if (f->wlen + len > IO_WRITE_BUFFER_SIZE && !stream_flush(f)) return make_bool(false);
+    if (len >= IO_WRITE_BUFFER_SIZE) return make_bool(write_all(f->fd, data, len));
+    memcpy(f->wbuf + f->wlen, data, len);
+    f->wlen += len;
+    return make_bool(true);
+}
+
+Value native_io_file_flush(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    FileStream* f = argc >= 1 ? stream_find(&args[0]) : NULL;
+    return make_bool(f && stream_flush(f));
+}
+
+Value native_io_file_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    FileStream* f = argc >= 1 ? stream_find(&args[0]) : NULL;
+    if (!f) return make_bool(false);
+    bool ok = stream_flush(f);
+    ok = close(f->fd) == 0 && ok;
+    FileStream** cur = &file_streams;
+    while (*cur != f) cur = &(*cur)->next;
+    *cur = f->next;
+    free(f->rbuf);
+    free(f->wbuf);
+    free(f);
+    return make_bool(ok);
+}
+
+// ============================================================================
+// Async whole-file I/O on uv_fs_*
+// ============================================================================
+//
+// io.read_file_async(path) and io.write_file_async(path, data) return an
+// "fs_req_<n>" handle; `await` on it (or h.wait()) evaluates to the
+// contents (null on error) or to a success bool. Inside a task only that
+// task waits.
+
+typedef struct FsRequest {
+    long id;
+    char handle[32];
+    uv_fs_t req;
+    bool writing;
+    uv_file file;
+    char* data;
+    size_t len;              // bytes read or written so far
+    size_t cap;              // read buffer size / bytes to write
+    int error;               // first failing uv status
+    bool done;
+    struct FsRequest* next;
+} FsRequest;
+
+static FsRequest* fs_requests = NULL;
+static long next_fs_id = 1;
+
+static FsRequest* fs_find(const Value* v) {
+    if (v->type != VAL_STRING) return NULL;
+    for (FsRequest* r = fs_requests; r; r = r->next) {
+        if (strcmp(r->handle, v->string_val) == 0) return r;
+    }
+    return NULL;
+}
+
+static void fs_finish(uv_fs_t* req) {
+    FsRequest* r = req->data;
+    uv_fs_req_cleanup(req);
+    r->done = true;
+    interpreter_wake(r->handle);
+}
+
+static void fs_close(FsRequest* r) {
+    uv_fs_req_cleanup(&r->req);
+    if (uv_fs_close(interpreter_init_event_loop(), &r->req, r->file, fs_finish) != 0) {
+        r->done = true;
+        interpreter_wake(r->handle);
+    }
+}
+
+static void fs_on_io(uv_fs_t* req);
+
+static void fs_next_chunk(FsRequest* r) {
+    uv_fs_req_cleanup(&r->req);
+    int rc;
+    if (r->writing) {
+        uv_buf_t buf = uv_buf_init(r->data + r->len, (unsigned int)(r->cap - r->len));
+        rc = uv_fs_write(interpreter_init_event_loop(), &r->req, r->file, &buf, 1, (int64_t)r->len, fs_on_io);
+    } else {
+        if (r->cap - r->len < 2) {
+            r->cap *= 2;
+            r->data = realloc(r->data, r->cap);
+        }
+        uv_buf_t buf = uv_buf_init(r->data + r->len, (unsigned int)(r->cap - r->len - 1));
+        rc = uv_fs_read(interpreter_init_event_loop(), &r->req, r->file, &buf, 1, (int64_t)r->len, fs_on_io);
+    }
+    if (rc != 0) {
+        r->error = rc;
+        fs_close(r);
+    }
+}
+
+static void fs_on_io(uv_fs_t* req) {
+    FsRequest* r = req->data;
+    if (req->result < 0) {
+        r->error = (int)req->result;
+        fs_close(r);
+        return;
+    }
+    r->len += (size_t)req->result;
+    bool finished = r->writing ? r->len >= r->cap : req->result == 0;
+    if (finished) fs_close(r);
+    else fs_next_chunk(r);
+}
+
+static void fs_on_stat(uv_fs_t* req) {
+    FsRequest* r = req->data;
+    if (req->result == 0 && req->statbuf.st_size > 0) {
+        r->cap = (size_t)req->statbuf.st_size + 1;
+    }
+    r->data = malloc(r->cap);
+    fs_next_chunk(r);
+}
+
+static void fs_on_open(uv_fs_t* req) {
+    FsRequest* r = req->data;
+    if (req->result < 0) {
+        r->error = (int)req->result;
+        fs_finish(req);
+        return;
+    }
+    r->file = (uv_file)req->result;
+    uv_fs_req_cleanup(req);
+    if (r->writing) {
+        fs_next_chunk(r);
+    } else if (uv_fs_fstat(interpreter_init_event_loop(), req, r->file, fs_on_stat) != 0) {
+        fs_on_stat(req);
+    }
+}
+
+static Value fs_start(const char* path, int flags, const unsigned char* data, size_t len) {
+    FsRequest* r = calloc(1, sizeof(FsRequest));
+    r->id = next_fs_id++;
+    snprintf(r->handle, sizeof(r->handle), "fs_req_%ld", r->id);
+    r->req.data = r;
+    r->writing = data != NULL;
+    if (data) {
+        r->cap = len;
+        r->data = malloc(len + 1);
+        memcpy(r->data, data, len);
+    } else {
+        r->cap = IO_STREAM_BUFFER_SIZE;
+    }
+    r->next = fs_requests;
+    fs_requests = r;
+    int rc = uv_fs_open(interpreter_init_event_loop(), &r->req, path, flags, 0644, fs_on_open);
+    if (rc != 0) {
+        r->error = rc;
+        r->done = true;
+    }
+    return make_string(r->handle);
+}
+
+Value native_io_read_file_async(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) return make_null();
+    return fs_start(args[0].string_val, O_RDONLY, NULL, 0);
+}
+
+Value native_io_write_file_async(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    size_t len = 0;
+    const unsigned char* data = argc >= 2 ? value_bytes(&args[1], &len) : NULL;
+    if (!data || args[0].type != VAL_STRING) return make_null();
+    return fs_start(args[0].string_val, O_WRONLY | O_CREAT | O_TRUNC, data, len);
+}
+
+// h.wait() / await h: blocks until the request is done, then releases it.
+Value native_io_fs_wait(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    FsRequest* r = argc >= 1 ? fs_find(&args[0]) : NULL;
+    if (!r) return make_null();
+    while (!r->done) {
+        if (!interpreter_wait(r->handle)) break;
+    }
+    if (!r->done) return make_null();
+
+    Value result;
+    if (r->writing) {
+        result = make_bool(r->error == 0);
+        free(r->data);
+    } else if (r->error == 0) {
+        r->data[r->len] = '\0';
+        result = (Value){ .type = VAL_STRING, .string_val = r->data };
+    } else {
+        free(r->data);
+        result = make_null();
+    }
+    if (r->error != 0) fprintf(stderr, "Error: %s failed: %s\n", r->handle, uv_strerror(r->error));
+    FsRequest** cur = &fs_requests;
+    while (*cur != r) cur = &(*cur)->next;
+    *cur = r->next;
+    free(r);
+    return result;
+}
 
 // Registration
 void stdlib_io_register(void) {
     register_native("io.read_file", native_io_read_file);
+    register_native("io.read_file_bytes", native_io_read_file_bytes);
     register_native("io.write_file", native_io_write_file);
     register_native("io.file_exists", native_io_file_exists);
     register_native("io.delete_file", native_io_delete_file);
     register_native("io.append_file", native_io_append_file);
     register_native("io.file_size", native_io_file_size);
     register_native("io.read_line", native_io_read_line);
+
+    register_native("io.mmap", native_io_mmap);
+    register_native("io.mmap_len", native_io_mmap_len);
+    register_native("io.mmap_slice", native_io_mmap_slice);
+    register_native("io.mmap_byte", native_io_mmap_byte);
+    register_native("io.mmap_find", native_io_mmap_find);
+    register_native("io.mmap_count", native_io_mmap_count);
+    register_native("io.mmap_read_line", native_io_mmap_read_line);
+    register_native("io.mmap_lines", native_io_mmap_lines);
+    register_native("io.mmap_bytes", native_io_mmap_bytes);
+    register_native("io.mmap_advise", native_io_mmap_advise);
+    register_native("io.mmap_close", native_io_mmap_close);
+    register_handle_methods("mmap_", "io.mmap_");
+    register_iterable("mmap_", native_io_mmap_read_line);
+
+    register_native("io.open", native_io_open);
+    register_native("io.file_read", native_io_file_read);
+    register_native("io.file_read_bytes", native_io_file_read_bytes);
+    register_native("io.file_read_line", native_io_file_read_line);
+    register_native("io.file_lines", native_io_file_lines);
+    register_native("io.file_write", native_io_file_write);
+    register_native("io.file_flush", native_io_file_flush);
+    register_native("io.file_close", native_io_file_close);
+    register_handle_methods("file_", "io.file_");
+    register_iterable("file_", native_io_file_read_line);
+
+    register_native("io.read_file_async", native_io_read_file_async);
+    register_native("io.write_file_async", native_io_write_file_async);
+    register_native("io.fs_req_wait", native_io_fs_wait);
+    register_handle_methods("fs_req_", "io.fs_req_");
+    register_awaitable("fs_req_", native_io_fs_wait);
 }
@@ -3,6 +3,23 @@
 
 #include "../core/interpreter.h"
 
+// Large files are read through one of three paths:
+//
+//   io.mmap(path, [advice])  read-only view of the whole file, mapped with
+//                            MAP_PRIVATE and madvise'd ("sequential" by
+//                            default, or "random"/"willneed"/"normal"); the
+//                            kernel pages it in on demand.
+//   io.open(path, [mode])    buffered stream ("r", "w" or "a") with
+//                            read(n), read_line(), lines(), write(s).
+//   io.read_file_async / io.write_file_async
+//                            run on uv_fs_* and return an awaitable handle.
+//
+// mmap views and streams are handles ("mmap_<n>", "file_<n>") with methods;
+// both iterate line by line in `cruise (line in h.lines())`.
+
+#define IO_STREAM_BUFFER_SIZE (256 * 1024)
+#define IO_WRITE_BUFFER_SIZE (1024 * 1024)
+
 // IO Module registration
 void stdlib_io_register(void);
 
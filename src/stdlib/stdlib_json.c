@@ -1,9 +1,18 @@
 #define _POSIX_C_SOURCE 200809L
 #include "stdlib_json.h"
+#include "../core/textscan.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <uv.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 extern Value make_string(const char* val);
 extern Value make_null(void);
@@ -12,116 +21,6 @@ static bool check_argc(int argc, int expected) {
     return argc == expected;
 }
 
-static void trim_spaces(const char** p) {
-    while (**p && isspace((unsigned char)**p)) (*p)++;
-}
-
-// Very small helper: find a string value for a key in a flat JSON object {"k":"v",...}
-Value native_json_get_string(struct Interpreter* interp, int argc, Value* args) {
-    (void)interp;
-    if (!check_argc(argc, 2) || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
-        return make_null();
-    }
-    const char* json = args[0].string_val;
-    const char* key = args[1].string_val;
-    if (!json || !key) return make_null();
-
-    // naive search for "key"
-    size_t keylen = strlen(key);
-    const char* p = json;
-    while ((p = strstr(p, key)) != NULL) {
-        // ensure we're at a quoted key
-        if (p > json && p[-1] != '"' ) { p += keylen; continue; }
-        const char* after = p + keylen;
-        // next char should be "
-        if (*after != '"') { p += keylen; continue; }
-        // find colon
-        const char* colon = strchr(after, ':');
-        if (!colon) return make_null();
-        colon++;
-        trim_spaces(&colon);
-        if (*colon == '"') {
-            colon++;
-            const char* end = strchr(colon, '"');
-            if (!end) return make_null();
-            size_t len = (size_t)(end - colon);
-            char* out = malloc(len + 1);
-            if (!out) return make_null();
-            memcpy(out, colon, len);
-            out[len] = '\0';
-            Value v; v.type = VAL_STRING; v.string_val = out; return v;
-        }
-        // non-string value not supported in this helper
-        return make_null();
-    }
-    return make_null();
-}
-
-// Very small helper: parse a numeric literal for a flat key (no nested objects)
-Value native_json_get_number(struct Interpreter* interp, int argc, Value* args) {
-    (void)interp;
-    if (!check_argc(argc, 2) || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
-        return make_null();
-    }
-    const char* json = args[0].string_val;
-    const char* key = args[1].string_val;
-    size_t keylen = strlen(key);
-    const char* p = json;
-    while ((p = strstr(p, key)) != NULL) {
-        if (p > json && p[-1] != '"') { p += keylen; continue; }
-        const char* after = p + keylen;
-        if (*after != '"') { p += keylen; continue; }
-        const char* colon = strchr(after, ':');
-        if (!colon) return make_null();
-        colon++;
-        trim_spaces(&colon);
-        // parse number
-        char* endptr = NULL;
-        double val = strtod(colon, &endptr);
-        if (endptr == colon) return make_null();
-        Value v;
-        // choose int if integral
-        if (val == (long long)val) {
-            v.type = VAL_INT;
-            v.int_val = (long long)val;
-        } else {
-            v.type = VAL_FLOAT;
-            v.float_val = val;
-        }
-        return v;
-    }
-    return make_null();
-}
-
-// Very small helper: parse boolean literal true/false for a flat key
-Value native_json_get_bool(struct Interpreter* interp, int argc, Value* args) {
-    (void)interp;
-    if (!check_argc(argc, 2) || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
-        return make_null();
-    }
-    const char* json = args[0].string_val;
-    const char* key = args[1].string_val;
-    size_t keylen = strlen(key);
-    const char* p = json;
-    while ((p = strstr(p, key)) != NULL) {
-        if (p > json && p[-1] != '"') { p += keylen; continue; }
-        const char* after = p + keylen;
-        if (*after != '"') { p += keylen; continue; }
-        const char* colon = strchr(after, ':');
-        if (!colon) return make_null();
-        colon++;
-        trim_spaces(&colon);
-        if (strncmp(colon, "true", 4) == 0) {
-            Value v; v.type = VAL_BOOL; v.bool_val = true; return v;
-        }
-        if (strncmp(colon, "false", 5) == 0) {
-            Value v; v.type = VAL_BOOL; v.bool_val = false; return v;
-        }
-        return make_null();
-    }
-    return make_null();
-}
-
 // Simple builder: json.stringify_kv("k","v") => {"k":"v"}
 Value native_json_stringify_kv(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
@@ -160,10 +59,1441 @@ Value native_json_escape(struct Interpreter* interp, int argc, Value* args) {
     Value v; v.type = VAL_STRING; v.string_val = out; return v;
 }
 
+// ---------------------------------------------------------------------------
+// json.parse / json.stringify
+//
+// Parsing runs in two stages, as in simdjson: stage 1 scans the text 64 bytes
+// at a time and records the offset of every structural character, string and
+// scalar outside of strings; stage 2 walks that index to build native values.
+// Objects become struct instances of the shared "json" struct (fields keep
+// document order), arrays become RADS arrays.
+// ---------------------------------------------------------------------------
+
+#define JSON_MAX_DEPTH 1024
+
+static StructDef json_object_def = { (char*)"json", NULL };
+
+typedef struct JsonBuf {
+    char* data;
+    size_t len;
+    size_t cap;
+} JsonBuf;
+
+static void jb_reserve(JsonBuf* b, size_t extra) {
+    if (b->len + extra + 1 <= b->cap) return;
+    size_t cap = b->cap ? b->cap : 64;
+    while (cap < b->len + extra + 1) cap *= 2;
+    b->data = realloc(b->data, cap);
+    b->cap = cap;
+}
+
+static void jb_append(JsonBuf* b, const char* s, size_t n) {
+    jb_reserve(b, n);
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = '\0';
+}
+
+static void jb_putc(JsonBuf* b, char c) {
+    jb_reserve(b, 1);
+    b->data[b->len++] = c;
+    b->data[b->len] = '\0';
+}
+
+static char* jb_finish(JsonBuf* b) {
+    if (!b->data) return strdup("");
+    return b->data;
+}
+
+// Stage 1: structural index
+
+typedef struct JsonIndex {
+    uint32_t* pos;
+    size_t count;
+    size_t cap;
+} JsonIndex;
+
+typedef struct JsonBlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;      // { } [ ] : ,
+    uint64_t space;
+} JsonBlockMasks;
+
+static void json_block_masks(const unsigned char* p, JsonBlockMasks* m) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i open_brace = _mm_set1_epi8('{');   // '[' | 0x20 == '{'
+    const __m128i close_brace = _mm_set1_epi8('}');  // ']' | 0x20 == '}'
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    m->quote = m->backslash = m->op = m->space = 0;
+    for (int k = 0; k < 4; k++) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * k));
+        __m128i folded = _mm_or_si128(v, lower);
+        __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open_brace), _mm_cmpeq_epi8(folded, close_brace)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+        __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, cr)));
+        int shift = 16 * k;
+        m->quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << shift;
+        m->backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)) << shift;
+        m->op |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << shift;
+        m->space |= (uint64_t)(uint16_t)_mm_movemask_epi8(space) << shift;
+    }
+#else
+    m->quote = m->backslash = m->op = m->space = 0;
+    for (int i = 0; i < 64; i++) {
+        uint64_t bit = 1ULL << i;
+        switch (p[i]) {
+            case '"': m->quote |= bit; break;
+            case '\\': m->backslash |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': m->op |= bit; break;
+            case ' ': case '\t': case '\n': case '\r': m->space |= bit; break;
+            default: break;
+        }
+    }
+#endif
+}
+
+// Bytes preceded by an odd run of backslashes. Backslashes are rare, so the
+// runs are walked bit by bit; *carry says whether byte 0 is escaped.
+static uint64_t json_escaped_mask(uint64_t backslash, bool* carry) {
+    uint64_t escaped = 0;
+    if (*carry) {
+        escaped = 1;
+        backslash &= ~1ULL;
+    }
+    *carry = false;
+    while (backslash) {
+        int k = __builtin_ctzll(backslash);
+        if (k == 63) {
+            *carry = true;
+            break;
+        }
+        escaped |= 1ULL << (k + 1);
+        backslash &= ~(3ULL << k);
+    }
+    return escaped;
+}
+
+static uint64_t json_prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+static bool json_stage1(const char* src, size_t len, JsonIndex* idx) {
+    idx->count = 0;
+    idx->cap = len / 4 + 64;
+    idx->pos = malloc(idx->cap * sizeof(uint32_t));
+    if (!idx->pos) return false;
+    uint64_t prev_in_string = 0;
+    uint64_t prev_scalar = 0;
+    bool escape_carry = false;
+    for (size_t base = 0; base < len; base += 64) {
+        const unsigned char* block = (const unsigned char*)src + base;
+        unsigned char tail[64];
+        if (len - base < 64) {
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, block, len - base);
+            block = tail;
+        }
+        JsonBlockMasks m;
+        json_block_masks(block, &m);
+        uint64_t escaped = (m.backslash || escape_carry) ? json_escaped_mask(m.backslash, &escape_carry) : 0;
+        uint64_t quotes = m.quote & ~escaped;
+        // Bits from an opening quote up to (not including) its closing quote.
+        uint64_t in_string = json_prefix_xor(quotes) ^ prev_in_string;
+        prev_in_string = (uint64_t)((int64_t)in_string >> 63);
+        uint64_t scalar = ~(m.op | m.space | m.quote) & ~in_string;
+        uint64_t scalar_start = scalar & ~((scalar << 1) | prev_scalar);
+        prev_scalar = scalar >> 63;
+        uint64_t structurals = (m.op & ~in_string) | (quotes & in_string) | scalar_start;
+
+        if (idx->count + 64 > idx->cap) {
+            idx->cap = idx->cap * 2 + 64;
+            idx->pos = realloc(idx->pos, idx->cap * sizeof(uint32_t));
+        }
+        while (structurals) {
+            idx->pos[idx->count++] = (uint32_t)(base + (size_t)__builtin_ctzll(structurals));
+            structurals &= structurals - 1;
+        }
+    }
+    return prev_in_string == 0;
+}
+
+// Scalars
+
+static const double json_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool json_is_delim(char c) {
+    return c == '\0' || c == ',' || c == ']' || c == '}' || c == ':' ||
+           c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Integers become VAL_INT when they fit. Other numbers take Clinger's fast
+// path (mantissa < 2^53, |exponent| <= 22 is exact with one multiply or
+// divide) and fall back to strtod otherwise. Leading zeros ("01") are
+// rejected, as RFC 8259 requires.
+static bool json_parse_number(const char* s, Value* out, const char** end_out) {
+    const char* p = s;
+    bool neg = false;
+    if (*p == '-') {
+        neg = true;
+        p++;
+    }
+    if (!isdigit((unsigned char)*p)) return false;
+    if (*p == '0' && isdigit((unsigned char)p[1])) return false;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exp10 = 0;
+    while (isdigit((unsigned char)*p)) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        } else {
+            exp10++;
+        }
+        if (mantissa || digits) digits++;
+        p++;
+    }
+    bool is_float = false;
+    if (*p == '.') {
+        is_float = true;
+        p++;
+        if (!isdigit((unsigned char)*p)) return false;
+        while (isdigit((unsigned char)*p)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                exp10--;
+                if (mantissa) digits++;
+            }
+            p++;
+        }
+    }
+    if (*p == 'e' || *p == 'E') {
+        is_float = true;
+        p++;
+        bool exp_neg = false;
+        if (*p == '+' || *p == '-') {
+            exp_neg = *p == '-';
+            p++;
+        }
+        if (!isdigit((unsigned char)*p)) return false;
+        int e = 0;
+        while (isdigit((unsigned char)*p)) {
+            if (e < 100000) e = e * 10 + (*p - '0');
+            p++;
+        }
+        exp10 += exp_neg ? -e : e;
+    }
+    if (!json_is_delim(*p)) return false;
+    *end_out = p;
+
+    if (!is_float && exp10 == 0 && mantissa <= (uint64_t)LLONG_MAX + (neg ? 1 : 0)) {
+        out->type = VAL_INT;
+        out->int_val = neg ? (long long)(0 - mantissa) : (long long)mantissa;
+        return true;
+    }
+    double d;
+    if (mantissa <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+        d = (double)mantissa;
+        d = exp10 < 0 ? d / json_pow10[-exp10] : d * json_pow10[exp10];
+        if (neg) d = -d;
+    } else {
+        d = strtod(s, NULL);
+    }
+    out->type = VAL_FLOAT;
+    out->float_val = d;
+    return true;
+}
+
+static void json_put_utf8(JsonBuf* b, unsigned cp) {
+    char tmp[4];
+    size_t n;
+    if (cp < 0x80) {
+        tmp[0] = (char)cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        tmp[0] = (char)(0xC0 | (cp >> 6));
+        tmp[1] = (char)(0x80 | (cp & 0x3F));
+        n = 2;
+    } else if (cp < 0x10000) {
+        tmp[0] = (char)(0xE0 | (cp >> 12));
+        tmp[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        tmp[2] = (char)(0x80 | (cp & 0x3F));
+        n = 3;
+    } else {
+        tmp[0] = (char)(0xF0 | (cp >> 18));
+        tmp[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        tmp[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        tmp[3] = (char)(0x80 | (cp & 0x3F));
+        n = 4;
+    }
+    jb_append(b, tmp, n);
+}
+
+static int json_hex4(const char* p, const char* limit) {
+    if (limit - p < 4) return -1;
+    int v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+        else return -1;
+    }
+    return v;
+}
+
+// s points just past the opening quote. Returns a heap string and sets
+// *end_out past the closing quote, or NULL on malformed input (including
+// unescaped control characters). A \u escape for half of a surrogate pair
+// with no other half decodes to U+FFFD, keeping the result valid UTF-8.
+static char* json_decode_string(const char* s, const char* limit, const char** end_out) {
+    const char* p = s;
+    while (p < limit && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20) p++;
+    if (p >= limit || (unsigned char)*p < 0x20) return NULL;
+    if (*p == '"') {
+        *end_out = p + 1;
+        return strndup(s, (size_t)(p - s));
+    }
+    JsonBuf b = {0};
+    jb_append(&b, s, (size_t)(p - s));
+    while (p < limit) {
+        char c = *p++;
+        if (c == '"') {
+            *end_out = p;
+            return jb_finish(&b);
+        }
+        if ((unsigned char)c < 0x20) break;
+        if (c != '\\') {
+            jb_putc(&b, c);
+            continue;
+        }
+        if (p >= limit) break;
+        c = *p++;
+        switch (c) {
+            case '"': case '\\': case '/': jb_putc(&b, c); break;
+            case 'b': jb_putc(&b, '\b'); break;
+            case 'f': jb_putc(&b, '\f'); break;
+            case 'n': jb_putc(&b, '\n'); break;
+            case 'r': jb_putc(&b, '\r'); break;
+            case 't': jb_putc(&b, '\t'); break;
+            case 'u': {
+                int cp = json_hex4(p, limit);
+                if (cp < 0) goto fail;
+                p += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF && limit - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    int lo = json_hex4(p + 2, limit);
+                    if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        p += 6;
+                    }
+                }
+                if (cp >= 0xD800 && cp <= 0xDFFF) cp = 0xFFFD;
+                json_put_utf8(&b, (unsigned)cp);
+                break;
+            }
+            default:
+                goto fail;
+        }
+    }
+fail:
+    free(b.data);
+    return NULL;
+}
+
+// Stage 2: build values from the index
+
+typedef struct JsonParser {
+    const char* src;
+    size_t len;
+    const uint32_t* idx;
+    size_t count;
+    size_t i;
+    int depth;
+    const char* error;
+    size_t error_pos;
+} JsonParser;
+
+static bool json_fail(JsonParser* p, const char* msg, size_t pos) {
+    if (!p->error) {
+        p->error = msg;
+        p->error_pos = pos;
+    }
+    return false;
+}
+
+static Value json_new_object(void) {
+    Value v;
+    v.type = VAL_STRUCT_INSTANCE;
+    v.struct_instance = malloc(sizeof(StructInstance));
+    v.struct_instance->definition = &json_object_def;
+    v.struct_instance->fields = NULL;
+    return v;
+}
+
+// Takes ownership of key and value.
+static void json_object_append(FieldValue*** tail, char* key, Value value) {
+    FieldValue* field = malloc(sizeof(FieldValue));
+    field->name = key;
+    field->value = malloc(sizeof(Value));
+    *field->value = value;
+    field->next = NULL;
+    **tail = field;
+    *tail = &field->next;
+}
+
+static void json_array_append(Array* arr, Value v) {
+    if (arr->count >= arr->capacity) {
+        arr->capacity = arr->capacity ? arr->capacity * 2 : 4;
+        arr->items = realloc(arr->items, arr->capacity * sizeof(Value));
+    }
+    arr->items[arr->count++] = v;
+}
+
+static bool json_parse_value(JsonParser* p, Value* out);
+
+static char json_peek(JsonParser* p) {
+    return p->i < p->count ? p->src[p->idx[p->i]] : '\0';
+}
+
+static size_t json_here(JsonParser* p) {
+    return p->i < p->count ? p->idx[p->i] : p->len;
+}
+
+static bool json_parse_string_at(JsonParser* p, char** out) {
+    size_t pos = p->idx[p->i];
+    const char* end = NULL;
+    *out = json_decode_string(p->src + pos + 1, p->src + p->len, &end);
+    if (!*out) return json_fail(p, "invalid string", pos);
+    p->i++;
+    return true;
+}
+
+static bool json_parse_object(JsonParser* p, Value* out) {
+    p->i++;
+    *out = json_new_object();
+    FieldValue** tail = &out->struct_instance->fields;
+    if (json_peek(p) == '}') {
+        p->i++;
+        return true;
+    }
+    for (;;) {
+        if (json_peek(p) != '"') return json_fail(p, "expected object key", json_here(p));
+        char* key = NULL;
+        if (!json_parse_string_at(p, &key)) return false;
+        if (json_peek(p) != ':') {
+            free(key);
+            return json_fail(p, "expected ':' after object key", json_here(p));
+        }
+        p->i++;
+        Value v;
+        if (!json_parse_value(p, &v)) {
+            free(key);
+            return false;
+        }
+        json_object_append(&tail, key, v);
+        size_t pos = json_here(p);
+        char c = json_peek(p);
+        p->i++;
+        if (c == '}') return true;
+        if (c != ',') return json_fail(p, "expected ',' or '}' in object", pos);
+    }
+}
+
+static bool json_parse_array(JsonParser* p, Value* out) {
+    p->i++;
+    Array* arr = array_create(8);
+    out->type = VAL_ARRAY;
+    out->array_val = arr;
+    if (json_peek(p) == ']') {
+        p->i++;
+        return true;
+    }
+    for (;;) {
+        Value v;
+        if (!json_parse_value(p, &v)) return false;
+        json_array_append(arr, v);
+        size_t pos = json_here(p);
+        char c = json_peek(p);
+        p->i++;
+        if (c == ']') return true;
+        if (c != ',') return json_fail(p, "expected ',' or ']' in array", pos);
+    }
+}
+
+static bool json_parse_value(JsonParser* p, Value* out) {
+    *out = make_null();
+    if (p->i >= p->count) return json_fail(p, "unexpected end of input", p->len);
+    size_t pos = p->idx[p->i];
+    const char* s = p->src + pos;
+    switch (*s) {
+        case '{':
+        case '[': {
+            if (++p->depth > JSON_MAX_DEPTH) return json_fail(p, "nesting too deep", pos);
+            bool ok = *s == '{' ? json_parse_object(p, out) : json_parse_array(p, out);
+            p->depth--;
+            return ok;
+        }
+        case '"': {
+            char* str = NULL;
+            if (!json_parse_string_at(p, &str)) return false;
+            out->type = VAL_STRING;
+            out->string_val = str;
+            return true;
+        }
+        case 't':
+            if (strncmp(s, "true", 4) != 0 || !json_is_delim(s[4])) break;
+            *out = make_bool(true);
+            p->i++;
+            return true;
+        case 'f':
+            if (strncmp(s, "false", 5) != 0 || !json_is_delim(s[5])) break;
+            *out = make_bool(false);
+            p->i++;
+            return true;
+        case 'n':
+            if (strncmp(s, "null", 4) != 0 || !json_is_delim(s[4])) break;
+            p->i++;
+            return true;
+        default: {
+            const char* end = NULL;
+            if (!json_parse_number(s, out, &end)) break;
+            p->i++;
+            return true;
+        }
+    }
+    return json_fail(p, "unexpected token", pos);
+}
+
+bool json_parse_text(const char* text, size_t len, Value* out, char* error, size_t error_len) {
+    *out = make_null();
+    if (!text_utf8_valid(text, len)) {
+        if (error) snprintf(error, error_len, "invalid UTF-8");
+        return false;
+    }
+    JsonIndex idx = {0};
+    if (!json_stage1(text, len, &idx)) {
+        free(idx.pos);
+        if (error) snprintf(error, error_len, "unterminated string");
+        return false;
+    }
+    JsonParser p = { text, len, idx.pos, idx.count, 0, 0, NULL, 0 };
+    bool ok = json_parse_value(&p, out);
+    if (ok && p.i < p.count) {
+        ok = json_fail(&p, "trailing characters after JSON value", p.idx[p.i]);
+    }
+    if (!ok) {
+        value_free(out);
+        *out = make_null();
+        if (error) snprintf(error, error_len, "%s at offset %zu", p.error ? p.error : "invalid JSON", p.error_pos);
+    }
+    free(idx.pos);
+    return ok;
+}
+
+// Serializer
+
+static void json_put_string(JsonBuf* b, const char* s) {
+    static const char hex[] = "0123456789abcdef";
+    jb_putc(b, '"');
+    const char* run = s;
+    for (const unsigned char* p = (const unsigned char*)s; *p; p++) {
+        unsigned char c = *p;
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        jb_append(b, run, (size_t)((const char*)p - run));
+        switch (c) {
+            case '"': jb_append(b, "\\\"", 2); break;
+            case '\\': jb_append(b, "\\\\", 2); break;
+            case '\n': jb_append(b, "\\n", 2); break;
+            case '\r': jb_append(b, "\\r", 2); break;
+            case '\t': jb_append(b, "\\t", 2); break;
+            case '\b': jb_append(b, "\\b", 2); break;
+            case '\f': jb_append(b, "\\f", 2); break;
+            default: {
+                char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+                jb_append(b, esc, 6);
+            }
+        }
+        run = (const char*)p + 1;
+    }
+    jb_append(b, run, strlen(run));
+    jb_putc(b, '"');
+}
+
+static void json_put_int(JsonBuf* b, long long v) {
+    char tmp[24];
+    char* w = tmp + sizeof(tmp);
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    do {
+        *--w = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0) *--w = '-';
+    jb_append(b, w, (size_t)(tmp + sizeof(tmp) - w));
+}
+
+// Shortest of %.15g/%.16g/%.17g that reads back as the same double.
+static void json_put_float(JsonBuf* b, double d) {
+    if (!isfinite(d)) {
+        jb_append(b, "null", 4);
+        return;
+    }
+    char tmp[40];
+    int n = 0;
+    for (int prec = 15; prec <= 17; prec++) {
+        n = snprintf(tmp, sizeof(tmp), "%.*g", prec, d);
+        if (strtod(tmp, NULL) == d) break;
+    }
+    jb_append(b, tmp, (size_t)n);
+    if (!strpbrk(tmp, ".eE")) jb_append(b, ".0", 2);
+}
+
+static void json_newline(JsonBuf* b, int indent, int depth) {
+    if (indent <= 0) return;
+    jb_putc(b, '\n');
+    jb_reserve(b, (size_t)(indent * depth));
+    memset(b->data + b->len, ' ', (size_t)(indent * depth));
+    b->len += (size_t)(indent * depth);
+    b->data[b->len] = '\0';
+}
+
+static bool json_put_value(JsonBuf* b, const Value* v, int indent, int depth);
+
+static bool json_put_field(JsonBuf* b, const FieldValue* f, bool* first, int indent, int depth) {
+    if (!*first) jb_putc(b, ',');
+    *first = false;
+    json_newline(b, indent, depth + 1);
+    json_put_string(b, f->name);
+    jb_putc(b, ':');
+    if (indent > 0) jb_putc(b, ' ');
+    return json_put_value(b, f->value, indent, depth + 1);
+}
+
+static bool json_put_value(JsonBuf* b, const Value* v, int indent, int depth) {
+    if (depth > JSON_MAX_DEPTH) return false;
+    switch (v->type) {
+        case VAL_NULL: jb_append(b, "null", 4); return true;
+        case VAL_BOOL: v->bool_val ? jb_append(b, "true", 4) : jb_append(b, "false", 5); return true;
+        case VAL_INT: json_put_int(b, v->int_val); return true;
+        case VAL_FLOAT: json_put_float(b, v->float_val); return true;
+        case VAL_STRING: json_put_string(b, v->string_val ? v->string_val : ""); return true;
+        case VAL_ARRAY: {
+            jb_putc(b, '[');
+            Array* arr = v->array_val;
+            for (size_t i = 0; arr && i < arr->count; i++) {
+                if (i > 0) jb_putc(b, ',');
+                json_newline(b, indent, depth + 1);
+                if (!json_put_value(b, &arr->items[i], indent, depth + 1)) return false;
+            }
+            if (arr && arr->count > 0) json_newline(b, indent, depth);
+            jb_putc(b, ']');
+            return true;
+        }
+        case VAL_NUMARRAY: {
+            jb_putc(b, '[');
+            NumArray* arr = v->numarray_val;
+            for (size_t i = 0; i < arr->count; i++) {
+                if (i > 0) jb_putc(b, ',');
+                json_newline(b, indent, depth + 1);
+                if (arr->kind == NUM_F64) {
+                    json_put_float(b, arr->f64[i]);
+                } else {
+                    json_put_int(b, arr->i64[i]);
+                }
+            }
+            if (arr->count > 0) json_newline(b, indent, depth);
+            jb_putc(b, ']');
+            return true;
+        }
+        case VAL_STRUCT_INSTANCE: {
+            jb_putc(b, '{');
+            StructInstance* inst = v->struct_instance;
+            bool first = true;
+            ASTNode* decl = inst && inst->definition ? inst->definition->ast_node : NULL;
+            if (decl && decl->struct_decl.fields) {
+                // User structs: declaration order (literals store fields reversed).
+                ASTList* fields = decl->struct_decl.fields;
+                for (size_t i = 0; i < fields->count; i++) {
+                    const char* name = fields->nodes[i]->variable_decl.name;
+                    for (FieldValue* f = inst->fields; f; f = f->next) {
+                        if (strcmp(f->name, name) == 0) {
+                            if (!json_put_field(b, f, &first, indent, depth)) return false;
+                            break;
+                        }
+                    }
+                }
+            } else if (inst) {
+                for (FieldValue* f = inst->fields; f; f = f->next) {
+                    if (!json_put_field(b, f, &first, indent, depth)) return false;
+                }
+            }
+            if (!first) json_newline(b, indent, depth);
+            jb_putc(b, '}');
+            return true;
+        }
+        default:
+            jb_append(b, "null", 4);
+            return true;
+    }
+}
+
+char* json_stringify_value(const Value* v, int indent, size_t* out_len) {
+    JsonBuf b = {0};
+    jb_reserve(&b, 256);
+    if (!json_put_value(&b, v, indent, 0)) {
+        free(b.data);
+        return NULL;
+    }
+    if (out_len) *out_len = b.len;
+    return jb_finish(&b);
+}
+
+// json.parse(text) -> value (null on error)
+Value native_json_parse(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING || !args[0].string_val) {
+        fprintf(stderr, "⚠️ JSON Error: json.parse expects a string\n");
+        return make_null();
+    }
+    Value out;
+    char error[128];
+    if (!json_parse_text(args[0].string_val, strlen(args[0].string_val), &out, error, sizeof(error))) {
+        fprintf(stderr, "⚠️ JSON Error: %s\n", error);
+        return make_null();
+    }
+    return out;
+}
+
+// json.stringify(value, [indent]) -> string
+Value native_json_stringify(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1) return make_string("null");
+    int indent = (argc >= 2 && args[1].type == VAL_INT) ? (int)args[1].int_val : 0;
+    char* text = json_stringify_value(&args[0], indent, NULL);
+    if (!text) {
+        fprintf(stderr, "⚠️ JSON Error: value is nested too deeply (cycle?)\n");
+        return make_null();
+    }
+    Value v;
+    v.type = VAL_STRING;
+    v.string_val = text;
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// Lazy document views
+// json.view(text) runs stage 1 once and links every container on the tape to
+// the entry just past its end, so a path lookup hops over siblings without
+// looking inside them. Only the value a lookup lands on is ever built.
+// ---------------------------------------------------------------------------
+
+typedef struct JsonView {
+    char id[32];
+    char* text;
+    size_t len;
+    uint32_t* pos;    // stage 1 index
+    uint32_t* skip;   // tape entry following the value that starts here
+    size_t count;
+    _Atomic int refs;  // the handle list + lookups in flight
+    struct JsonView* next;
+} JsonView;
+
+// Views are shared by every thread, so the list is guarded and a lookup
+// holds a reference while it reads the document.
+static JsonView* json_views = NULL;
+static long next_view_id = 1;
+static uv_mutex_t json_views_lock;
+static uv_once_t json_views_once = UV_ONCE_INIT;
+
+static void json_views_init_lock(void) {
+    uv_mutex_init(&json_views_lock);
+}
+
+static bool json_view_build(JsonView* v, const char* text, size_t len, char* error, size_t error_len) {
+    if (!text_utf8_valid(text, len)) {
+        snprintf(error, error_len, "invalid UTF-8");
+        return false;
+    }
+    JsonIndex idx = {0};
+    if (!json_stage1(text, len, &idx)) {
+        free(idx.pos);
+        snprintf(error, error_len, "unterminated string");
+        return false;
+    }
+    v->pos = idx.pos;
+    v->count = idx.count;
+    v->skip = malloc((idx.count + 1) * sizeof(uint32_t));
+    size_t stack[JSON_MAX_DEPTH];
+    int depth = 0;
+    for (size_t i = 0; i < idx.count; i++) {
+        char c = text[idx.pos[i]];
+        v->skip[i] = (uint32_t)(i + 1);
+        if (c == '{' || c == '[') {
+            if (depth == JSON_MAX_DEPTH) {
+                snprintf(error, error_len, "nesting too deep at offset %u", idx.pos[i]);
+                return false;
+            }
+            stack[depth++] = i;
+        } else if (c == '}' || c == ']') {
+            char open = c == '}' ? '{' : '[';
+            if (depth == 0 || text[idx.pos[stack[depth - 1]]] != open) {
+                snprintf(error, error_len, "unbalanced '%c' at offset %u", c, idx.pos[i]);
+                return false;
+            }
+            v->skip[stack[--depth]] = (uint32_t)(i + 1);
+        }
+    }
+    if (depth != 0 || idx.count == 0) {
+        snprintf(error, error_len, "unexpected end of input");
+        return false;
+    }
+    if (v->skip[0] != idx.count) {
+        snprintf(error, error_len, "trailing characters after JSON value at offset %u", idx.pos[v->skip[0]]);
+        return false;
+    }
+    return true;
+}
+
+static void json_view_release(JsonView* v) {
+    free(v->pos);
+    free(v->skip);
+}
+
+static char json_view_char(const JsonView* v, size_t i) {
+    return i < v->count ? v->text[v->pos[i]] : '\0';
+}
+
+static bool json_view_key_equals(const JsonView* v, size_t i, const char* name, size_t name_len) {
+    const char* k = v->text + v->pos[i] + 1;
+    const char* q = k;
+    while (*q != '"' && *q != '\\' && *q) q++;
+    if (*q == '"') return (size_t)(q - k) == name_len && memcmp(k, name, name_len) == 0;
+    const char* end = NULL;
+    char* key = json_decode_string(k, v->text + v->len, &end);
+    bool eq = key && strlen(key) == name_len && memcmp(key, name, name_len) == 0;
+    free(key);
+    return eq;
+}
+
+// Value that follows object key at tape entry i, or count if malformed.
+static size_t json_view_member(const JsonView* v, size_t obj, const char* name, size_t name_len) {
+    size_t j = obj + 1;
+    while (json_view_char(v, j) == '"') {
+        if (json_view_char(v, j + 1) != ':' || j + 2 >= v->count) return v->count;
+        if (json_view_key_equals(v, j, name, name_len)) return j + 2;
+        j = v->skip[j + 2];
+        if (json_view_char(v, j) != ',') return v->count;
+        j++;
+    }
+    return v->count;
+}
+
+static size_t json_view_element(const JsonView* v, size_t arr, long n) {
+    size_t j = arr + 1;
+    if (n < 0 || json_view_char(v, j) == ']') return v->count;
+    for (long k = 0; k < n; k++) {
+        j = v->skip[j];
+        if (json_view_char(v, j) != ',') return v->count;
+        j++;
+    }
+    return j < v->count ? j : v->count;
+}
+
+// Resolves a path such as "a.b[3].c" to a tape entry; returns count when
+// the path does not exist.
+static size_t json_view_find(const JsonView* v, const char* path) {
+    size_t i = 0;
+    const char* p = path;
+    while (*p && i < v->count) {
+        if (*p == '.') {
+            p++;
+            continue;
+        }
+        if (*p == '[') {
+            char* end = NULL;
+            long n = strtol(p + 1, &end, 10);
+            if (end == p + 1 || *end != ']' || json_view_char(v, i) != '[') return v->count;
+            i = json_view_element(v, i, n);
+            p = end + 1;
+            continue;
+        }
+        size_t seg = strcspn(p, ".[");
+        if (json_view_char(v, i) != '{') return v->count;
+        i = json_view_member(v, i, p, seg);
+        p += seg;
+    }
+    return *p ? v->count : i;
+}
+
+// First occurrence of key anywhere in the document, in document order.
+static size_t json_view_find_key(const JsonView* v, const char* key) {
+    size_t key_len = strlen(key);
+    for (size_t j = 0; j + 2 < v->count; j++) {
+        if (json_view_char(v, j) == '"' && json_view_char(v, j + 1) == ':' &&
+            json_view_key_equals(v, j, key, key_len)) {
+            return j + 2;
+        }
+    }
+    return v->count;
+}
+
+static Value json_view_materialize(const JsonView* v, size_t i) {
+    JsonParser p = { v->text, v->len, v->pos, v->count, i, 0, NULL, 0 };
+    Value out;
+    if (!json_parse_value(&p, &out)) {
+        fprintf(stderr, "⚠️ JSON Error: %s at offset %zu\n", p.error, p.error_pos);
+        value_free(&out);
+        return make_null();
+    }
+    return out;
+}
+
+static JsonView* json_view_find_handle(const char* id) {
+    for (JsonView* v = json_views; v; v = v->next) {
+        if (strcmp(v->id, id) == 0) return v;
+    }
+    return NULL;
+}
+
+// Returns a referenced view; drop it with json_view_unref.
+static JsonView* json_view_arg(int argc, Value* args) {
+    if (argc < 1 || args[0].type != VAL_STRING || !args[0].string_val) return NULL;
+    uv_once(&json_views_once, json_views_init_lock);
+    uv_mutex_lock(&json_views_lock);
+    JsonView* v = json_view_find_handle(args[0].string_val);
+    if (v) atomic_fetch_add(&v->refs, 1);
+    uv_mutex_unlock(&json_views_lock);
+    return v;
+}
+
+static void json_view_unref(JsonView* v) {
+    if (atomic_fetch_sub(&v->refs, 1) != 1) return;
+    json_view_release(v);
+    free(v->text);
+    free(v);
+}
+
+static const char* json_path_arg(int argc, Value* args) {
+    return (argc >= 2 && args[1].type == VAL_STRING && args[1].string_val) ? args[1].string_val : "";
+}
+
+// json.view(text) -> handle (null on malformed structure)
+Value native_json_view(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING || !args[0].string_val) {
+        fprintf(stderr, "⚠️ JSON Error: json.view expects a string\n");
+        return make_null();
+    }
+    JsonView* v = calloc(1, sizeof(JsonView));
+    // The view keeps the text; steal it from the argument instead of copying.
+    v->text = args[0].string_val;
+    args[0] = make_null();
+    v->len = strlen(v->text);
+    char error[128];
+    if (!json_view_build(v, v->text, v->len, error, sizeof(error))) {
+        fprintf(stderr, "⚠️ JSON Error: %s\n", error);
+        json_view_release(v);
+        free(v->text);
+        free(v);
+        return make_null();
+    }
+    atomic_init(&v->refs, 1);
+    uv_once(&json_views_once, json_views_init_lock);
+    uv_mutex_lock(&json_views_lock);
+    snprintf(v->id, sizeof(v->id), "json_view_%ld", next_view_id++);
+    v->next = json_views;
+    json_views = v;
+    Value id = make_string(v->id);
+    uv_mutex_unlock(&json_views_lock);
+    return id;
+}
+
+// view.get(path) -> value at path, or null
+Value native_json_view_get(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    JsonView* v = json_view_arg(argc, args);
+    if (!v) return make_null();
+    size_t i = json_view_find(v, json_path_arg(argc, args));
+    Value out = i < v->count ? json_view_materialize(v, i) : make_null();
+    json_view_unref(v);
+    return out;
+}
+
+// view.has(path) -> bool
+Value native_json_view_has(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    JsonView* v = json_view_arg(argc, args);
+    if (!v) return make_bool(false);
+    bool found = json_view_find(v, json_path_arg(argc, args)) < v->count;
+    json_view_unref(v);
+    return make_bool(found);
+}
+
+// view.count(path) -> number of elements or fields of the container at path
+Value native_json_view_count(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    JsonView* v = json_view_arg(argc, args);
+    if (!v) return make_null();
+    size_t i = json_view_find(v, json_path_arg(argc, args));
+    char open = json_view_char(v, i);
+    if (open != '{' && open != '[') {
+        json_view_unref(v);
+        return make_null();
+    }
+    char close = open == '{' ? '}' : ']';
+    long long n = 0;
+    size_t j = i + 1;
+    while (j < v->count && json_view_char(v, j) != close) {
+        if (open == '{') j += 2;  // key and ':'
+        j = v->skip[j];
+        n++;
+        if (json_view_char(v, j) == ',') j++;
+    }
+    json_view_unref(v);
+    return make_int(n);
+}
+
+// view.close() releases the document
+Value native_json_view_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    JsonView* v = json_view_arg(argc, args);
+    if (!v) return make_bool(false);
+    bool linked = false;
+    uv_mutex_lock(&json_views_lock);
+    for (JsonView** link = &json_views; *link; link = &(*link)->next) {
+        if (*link == v) {
+            *link = v->next;
+            linked = true;
+            break;
+        }
+    }
+    uv_mutex_unlock(&json_views_lock);
+    // A concurrent close may have unlinked it first; only one drops the
+    // list's reference.
+    if (linked) json_view_unref(v);
+    json_view_unref(v);
+    return make_bool(linked);
+}
+
+// json.get_string/get_number/get_bool(text, key) share one pass: the text is
+// indexed once and the key is resolved as a path from the root, falling back
+// to the first occurrence of a plain key anywhere in the document.
+static bool json_lookup(Value* args, JsonView* v, size_t* at) {
+    const char* text = args[0].string_val;
+    const char* key = args[1].string_val;
+    if (!text || !key) return false;
+    memset(v, 0, sizeof(*v));
+    v->text = (char*)text;
+    v->len = strlen(text);
+    char error[128];
+    if (!json_view_build(v, text, v->len, error, sizeof(error))) {
+        json_view_release(v);
+        return false;
+    }
+    *at = json_view_find(v, key);
+    if (*at >= v->count && !strpbrk(key, ".[")) *at = json_view_find_key(v, key);
+    if (*at >= v->count) {
+        json_view_release(v);
+        return false;
+    }
+    return true;
+}
+
+Value native_json_get_string(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (!check_argc(argc, 2) || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
+        return make_null();
+    }
+    JsonView v;
+    size_t i;
+    if (!json_lookup(args, &v, &i)) return make_null();
+    Value out = json_view_char(&v, i) == '"' ? json_view_materialize(&v, i) : make_null();
+    json_view_release(&v);
+    return out;
+}
+
+Value native_json_get_number(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (!check_argc(argc, 2) || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
+        return make_null();
+    }
+    JsonView v;
+    size_t i;
+    if (!json_lookup(args, &v, &i)) return make_null();
+    Value out = make_null();
+    const char* end = NULL;
+    if (json_parse_number(v.text + v.pos[i], &out, &end) && out.type == VAL_FLOAT &&
+        out.float_val == (long long)out.float_val) {
+        out = make_int((long long)out.float_val);
+    }
+    json_view_release(&v);
+    return out;
+}
+
+Value native_json_get_bool(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (!check_argc(argc, 2) || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
+        return make_null();
+    }
+    JsonView v;
+    size_t i;
+    if (!json_lookup(args, &v, &i)) return make_null();
+    const char* s = v.text + v.pos[i];
+    Value out = make_null();
+    if (strncmp(s, "true", 4) == 0) out = make_bool(true);
+    else if (strncmp(s, "false", 5) == 0) out = make_bool(false);
+    json_view_release(&v);
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// Streaming (SAX) parsing
+// Reads a file in fixed-size chunks so documents larger than memory can be
+// processed. json.sax reports events; json.stream_items builds one native
+// value at a time for each element of a top-level array (or for each value of
+// a newline-delimited JSON file).
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    JSON_EV_START_OBJECT,
+    JSON_EV_END_OBJECT,
+    JSON_EV_START_ARRAY,
+    JSON_EV_END_ARRAY,
+    JSON_EV_KEY,
+    JSON_EV_VALUE
+} JsonEvent;
+
+static const char* json_event_names[] = {
+    "start_object", "end_object", "start_array", "end_array", "key", "value"
+};
+
+// Returns false to stop parsing. value is owned by the handler.
+typedef bool (*JsonEventFn)(void* ctx, JsonEvent ev, int depth, Value value);
+
+typedef struct JsonReader {
+    FILE* f;
+    char buf[64 * 1024];
+    size_t len;
+    size_t pos;
+    size_t offset;
+} JsonReader;
+
+static int jr_getc(JsonReader* r) {
+    if (r->pos == r->len) {
+        r->offset += r->len;
+        r->len = fread(r->buf, 1, sizeof(r->buf), r->f);
+        r->pos = 0;
+        if (r->len == 0) return EOF;
+    }
+    return (unsigned char)r->buf[r->pos++];
+}
+
+typedef enum {
+    JS_TOP,
+    JS_VALUE,
+    JS_VALUE_OR_END,
+    JS_KEY,
+    JS_KEY_OR_END,
+    JS_COLON,
+    JS_COMMA_OR_END
+} JsonStreamState;
+
+static bool json_stream_parse(FILE* f, JsonEventFn fn, void* ctx, char* error, size_t error_len) {
+    JsonReader* r = malloc(sizeof(JsonReader));
+    r->f = f;
+    r->len = r->pos = r->offset = 0;
+    char stack[JSON_MAX_DEPTH];
+    int depth = 0;
+    JsonStreamState state = JS_TOP;
+    JsonBuf tok = {0};
+    bool ok = true;
+    const char* msg = NULL;
+
+    for (;;) {
+        int c = jr_getc(r);
+        if (c == EOF) break;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
+        bool value_state = state == JS_TOP || state == JS_VALUE || state == JS_VALUE_OR_END;
+        Value scalar = make_null();
+        bool have_scalar = false;
+        switch (c) {
+            case '{':
+            case '[':
+                if (!value_state) { msg = "unexpected container"; goto error; }
+                if (depth >= JSON_MAX_DEPTH) { msg = "nesting too deep"; goto error; }
+                if (!fn(ctx, c == '{' ? JSON_EV_START_OBJECT : JSON_EV_START_ARRAY, depth, make_null())) goto stop;
+                stack[depth++] = (char)c;
+                state = c == '{' ? JS_KEY_OR_END : JS_VALUE_OR_END;
+                continue;
+            case '}':
+            case ']': {
+                char open = c == '}' ? '{' : '[';
+                bool can_close = state == JS_COMMA_OR_END || (c == '}' ? state == JS_KEY_OR_END : state == JS_VALUE_OR_END);
+                if (depth == 0 || stack[depth - 1] != open || !can_close) { msg = "unexpected closing bracket"; goto error; }
+                depth--;
+                if (!fn(ctx, c == '}' ? JSON_EV_END_OBJECT : JSON_EV_END_ARRAY, depth, make_null())) goto stop;
+                state = depth == 0 ? JS_TOP : JS_COMMA_OR_END;
+                continue;
+            }
+            case ':':
+                if (state != JS_COLON) { msg = "unexpected ':'"; goto error; }
+                state = JS_VALUE;
+                continue;
+            case ',':
+                if (state != JS_COMMA_OR_END) { msg = "unexpected ','"; goto error; }
+                state = stack[depth - 1] == '{' ? JS_KEY : JS_VALUE;
+                continue;
+            case '"': {
+                // Collect the raw string (escapes included), then decode.
+                tok.len = 0;
+                bool escaped = false;
+                for (;;) {
+                    int d = jr_getc(r);
+                    if (d == EOF) { msg = "unterminated string"; goto error; }
+                    jb_putc(&tok, (char)d);
+                    if (escaped) escaped = false;
+                    else if (d == '\\') escaped = true;
+                    else if (d == '"') break;
+                }
+                const char* end = NULL;
+                char* str = json_decode_string(tok.data, tok.data + tok.len, &end);
+                if (!str) { msg = "invalid string"; goto error; }
+                if (state == JS_KEY || state == JS_KEY_OR_END) {
+                    Value key;
+                    key.type = VAL_STRING;
+                    key.string_val = str;
+                    if (!fn(ctx, JSON_EV_KEY, depth, key)) goto stop;
+                    state = JS_COLON;
+                    continue;
+                }
+                if (!value_state) {
+                    free(str);
+                    msg = "unexpected string";
+                    goto error;
+                }
+                scalar.type = VAL_STRING;
+                scalar.string_val = str;
+                have_scalar = true;
+                break;
+            }
+            default: {
+                if (!value_state) { msg = "unexpected token"; goto error; }
+                tok.len = 0;
+                jb_putc(&tok, (char)c);
+                for (;;) {
+                    int d = jr_getc(r);
+                    if (d == EOF) break;
+                    if (json_is_delim((char)d) || d == '"' || d == '[' || d == '{') {
+                        r->pos--;
+                        break;
+                    }
+                    jb_putc(&tok, (char)d);
+                }
+                const char* end = NULL;
+                if (strcmp(tok.data, "true") == 0) scalar = make_bool(true);
+                else if (strcmp(tok.data, "false") == 0) scalar = make_bool(false);
+                else if (strcmp(tok.data, "null") == 0) scalar = make_null();
+                else if (!json_parse_number(tok.data, &scalar, &end)) { msg = "invalid literal"; goto error; }
+                have_scalar = true;
+                break;
+            }
+        }
+        if (have_scalar) {
+            if (!fn(ctx, JSON_EV_VALUE, depth, scalar)) goto stop;
+            state = depth == 0 ? JS_TOP : JS_COMMA_OR_END;
+        }
+    }
+    if (depth != 0 || (state != JS_TOP)) {
+        msg = "unexpected end of input";
+        goto error;
+    }
+    goto stop;
+
+error:
+    ok = false;
+    if (error) snprintf(error, error_len, "%s at offset %zu", msg, r->offset + (r->pos ? r->pos - 1 : 0));
+stop:
+    free(tok.data);
+    free(r);
+    return ok;
+}
+
+typedef struct JsonCallbackCtx {
+    Value callback;
+} JsonCallbackCtx;
+
+static bool json_stream_call(Value callback, int argc, Value* args) {
+    Value result = interpreter_execute_callback(callback, argc, args);
+    bool keep_going = !(result.type == VAL_BOOL && !result.bool_val);
+    value_free(&result);
+    for (int i = 0; i < argc; i++) value_free(&args[i]);
+    return keep_going;
+}
+
+static bool json_event_to_callback(void* ctx, JsonEvent ev, int depth, Value value) {
+    (void)depth;
+    JsonCallbackCtx* c = ctx;
+    Value args[2] = { make_string(json_event_names[ev]), value };
+    return json_stream_call(c->callback, 2, args);
+}
+
+typedef struct JsonItemFrame {
+    Value value;
+    FieldValue** tail;
+    char* key;
+} JsonItemFrame;
+
+typedef struct JsonItemCtx {
+    Value callback;
+    int item_depth;     // depth at which complete values are handed out
+    bool started;
+    JsonItemFrame frames[JSON_MAX_DEPTH];
+    int nframes;
+} JsonItemCtx;
+
+static bool json_item_complete(JsonItemCtx* c, Value v) {
+    if (c->nframes == 0) {
+        Value args[1] = { v };
+        return json_stream_call(c->callback, 1, args);
+    }
+    JsonItemFrame* top = &c->frames[c->nframes - 1];
+    if (top->value.type == VAL_ARRAY) {
+        json_array_append(top->value.array_val, v);
+    } else {
+        json_object_append(&top->tail, top->key ? top->key : strdup(""), v);
+        top->key = NULL;
+    }
+    return true;
+}
+
+static bool json_event_to_items(void* ctx, JsonEvent ev, int depth, Value value) {
+    JsonItemCtx* c = ctx;
+    if (!c->started) {
+        c->started = true;
+        c->item_depth = ev == JSON_EV_START_ARRAY ? 1 : 0;
+        if (c->item_depth == 1) return true;  // the enclosing array itself is not built
+    }
+    bool building = c->nframes > 0 || depth == c->item_depth;
+    switch (ev) {
+        case JSON_EV_START_OBJECT:
+        case JSON_EV_START_ARRAY: {
+            if (!building) return true;
+            JsonItemFrame* f = &c->frames[c->nframes++];
+            f->key = NULL;
+            if (ev == JSON_EV_START_OBJECT) {
+                f->value = json_new_object();
+                f->tail = &f->value.struct_instance->fields;
+            } else {
+                f->value.type = VAL_ARRAY;
+                f->value.array_val = array_create(8);
+                f->tail = NULL;
+            }
+            return true;
+        }
+        case JSON_EV_END_OBJECT:
+        case JSON_EV_END_ARRAY: {
+            if (c->nframes == 0) return true;
+            Value done = c->frames[--c->nframes].value;
+            return json_item_complete(c, done);
+        }
+        case JSON_EV_KEY:
+            if (c->nframes > 0) {
+                free(c->frames[c->nframes - 1].key);
+                c->frames[c->nframes - 1].key = value.string_val;
+            } else {
+                value_free(&value);
+            }
+            return true;
+        case JSON_EV_VALUE:
+            if (!building) {
+                value_free(&value);
+                return true;
+            }
+            return json_item_complete(c, value);
+    }
+    return true;
+}
+
+static FILE* json_open_stream_arg(int argc, Value* args, const char* fn) {
+    if (argc < 2 || args[0].type != VAL_STRING || args[1].type != VAL_FUNCTION) {
+        fprintf(stderr, "⚠️ JSON Error: %s expects (path, callback)\n", fn);
+        return NULL;
+    }
+    FILE* f = fopen(args[0].string_val, "rb");
+    if (!f) {
+        fprintf(stderr, "⚠️ JSON Error: cannot open %s\n", args[0].string_val);
+    }
+    return f;
+}
+
+// json.sax(path, callback(event, value)) -> bool
+// Events: start_object, end_object, start_array, end_array, key, value.
+// Returning false from the callback stops early.
+Value native_json_sax(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    FILE* f = json_open_stream_arg(argc, args, "json.sax");
+    if (!f) return make_bool(false);
+    JsonCallbackCtx ctx = { args[1] };
+    char error[128];
+    bool ok = json_stream_parse(f, json_event_to_callback, &ctx, error, sizeof(error));
+    fclose(f);
+    if (!ok) fprintf(stderr, "⚠️ JSON Error: %s\n", error);
+    return make_bool(ok);
+}
+
+// json.stream_items(path, callback(item)) -> bool
+// Calls back once per element of a top-level array, or once per value of a
+// newline-delimited JSON file. Only one item is held in memory at a time.
+Value native_json_stream_items(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    FILE* f = json_open_stream_arg(argc, args, "json.stream_items");
+    if (!f) return make_bool(false);
+    JsonItemCtx* ctx = calloc(1, sizeof(JsonItemCtx));
+    ctx->callback = args[1];
+    char error[128];
+    bool ok = json_stream_parse(f, json_event_to_items, ctx, error, sizeof(error));
+    fclose(f);
+    while (ctx->nframes > 0) {
+        JsonItemFrame* frame = &ctx->frames[--ctx->nframes];
+        free(frame->key);
+        value_free(&frame->value);
+    }
+    free(ctx);
+    if (!ok) fprintf(stderr, "⚠️ JSON Error: %s\n", error);
+    return make_bool(ok);
+}
+
 void stdlib_json_register(void) {
     register_native("json.get_string", native_json_get_string);
     register_native("json.get_number", native_json_get_number);
     register_native("json.get_bool", native_json_get_bool);
     register_native("json.stringify_kv", native_json_stringify_kv);
     register_native("json.escape", native_json_escape);
+    register_native("json.parse", native_json_parse);
+    register_native("json.stringify", native_json_stringify);
+    register_native("json.sax", native_json_sax);
+    register_native("json.stream_items", native_json_stream_items);
+    register_native("json.view", native_json_view);
+    register_native("json.view_get", native_json_view_get);
+    register_native("json.view_has", native_json_view_has);
+    register_native("json.view_count", native_json_view_count);
+    register_native("json.view_close", native_json_view_close);
+    register_handle_methods("json_view_", "json.view_");
 }
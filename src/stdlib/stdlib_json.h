@@ -12,4 +12,23 @@ Value native_json_get_bool(struct Interpreter* interp, int argc, Value* args);
 Value native_json_stringify_kv(struct Interpreter* interp, int argc, Value* args);
 Value native_json_escape(struct Interpreter* interp, int argc, Value* args);
 
+// Native values
+Value native_json_parse(struct Interpreter* interp, int argc, Value* args);
+Value native_json_stringify(struct Interpreter* interp, int argc, Value* args);
+Value native_json_sax(struct Interpreter* interp, int argc, Value* args);
+Value native_json_stream_items(struct Interpreter* interp, int argc, Value* args);
+
+// Lazy views: json.view(text) returns a handle with get/has/count/close
+Value native_json_view(struct Interpreter* interp, int argc, Value* args);
+Value native_json_view_get(struct Interpreter* interp, int argc, Value* args);
+Value native_json_view_has(struct Interpreter* interp, int argc, Value* args);
+Value native_json_view_count(struct Interpreter* interp, int argc, Value* args);
+Value native_json_view_close(struct Interpreter* interp, int argc, Value* args);
+
+// C API for other modules. json_parse_text fills *out and returns true, or
+// writes a message into error. json_stringify_value returns a heap string,
+// or NULL if the value nests too deeply.
+bool json_parse_text(const char* text, size_t len, Value* out, char* error, size_t error_len);
+char* json_stringify_value(const Value* v, int indent, size_t* out_len);
+
 #endif // RADS_STDLIB_JSON_H
@@ -1,4 +1,5 @@
 #include "../core/interpreter.h"
+#include "stdlib_numarray.h"
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
@@ -18,6 +19,9 @@ static void init_random(void) {
 
 Value stdlib_math_min(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
+    if (argc == 1 && args[0].type == VAL_NUMARRAY) {
+        return numarray_min(args[0].numarray_val);
+    }
     if (argc < 2) {
         fprintf(stderr, "Error: math.min() requires at least 2 arguments\n");
         Value v;
@@ -58,6 +62,9 @@ Value stdlib_math_min(struct Interpreter* interp, int argc, Value* args) {
 
 Value stdlib_math_max(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
+    if (argc == 1 && args[0].type == VAL_NUMARRAY) {
+        return numarray_max(args[0].numarray_val);
+    }
     if (argc < 2) {
         fprintf(stderr, "Error: math.max() requires at least 2 arguments\n");
         Value v;
@@ -104,6 +111,9 @@ Value stdlib_math_clamp(struct Interpreter* interp, int argc, Value* args) {
         v.type = VAL_NULL;
         return v;
     }
+    if (args[0].type == VAL_NUMARRAY) {
+        return numarray_clamp(args[0].numarray_val, &args[1], &args[2]);
+    }
 
     double val, min_val, max_val;
     bool is_int = (args[0].type == VAL_INT && args[1].type == VAL_INT && args[2].type == VAL_INT);
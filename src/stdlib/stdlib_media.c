@@ -1,68 +1,1484 @@
 #define _POSIX_C_SOURCE 200809L
 #include "stdlib_media.h"
+#include "../core/textscan.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <setjmp.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <uv.h>
+#include <jpeglib.h>
+#include <png.h>
 
-// For prototype, we simulate media processing
-// In future, this would link with libraries like stb_image, ffmpeg, etc.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MEDIA_X86 1
+#include <immintrin.h>
+#endif
 
-Value native_media_image_info(struct Interpreter* interp, int argc, Value* args) {
-    (void)interp;
-    if (argc < 1 || args[0].type != VAL_STRING) {
-        printf("⚠️ Media Error: Expected filename for image_info\n");
-        Value v; v.type = VAL_NULL; return v;
+extern Value make_string(const char* val);
+
+typedef enum {
+    MEDIA_UNKNOWN,
+    MEDIA_PNG,
+    MEDIA_JPEG,
+    MEDIA_WAV,
+    MEDIA_RAW
+} MediaFormat;
+
+static const char* format_name(MediaFormat format) {
+    switch (format) {
+        case MEDIA_PNG: return "png";
+        case MEDIA_JPEG: return "jpeg";
+        case MEDIA_WAV: return "wav";
+        case MEDIA_RAW: return "raw";
+        default: return "unknown";
+    }
+}
+
+static MediaFormat format_named(const char* name) {
+    if (strcasecmp(name, "png") == 0) return MEDIA_PNG;
+    if (strcasecmp(name, "jpeg") == 0 || strcasecmp(name, "jpg") == 0) return MEDIA_JPEG;
+    return MEDIA_UNKNOWN;
+}
+
+static MediaFormat format_for_path(const char* path) {
+    const char* dot = strrchr(path, '.');
+    return dot && !strchr(dot, '/') ? format_named(dot + 1) : MEDIA_UNKNOWN;
+}
+
+static MediaFormat format_sniff(const unsigned char* head, size_t len) {
+    static const unsigned char png_magic[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (len >= 8 && memcmp(head, png_magic, 8) == 0) return MEDIA_PNG;
+    if (len >= 3 && head[0] == 0xFF && head[1] == 0xD8 && head[2] == 0xFF) return MEDIA_JPEG;
+    if (len >= 12 && memcmp(head, "RIFF", 4) == 0 && memcmp(head + 8, "WAVE", 4) == 0) return MEDIA_WAV;
+    return MEDIA_UNKNOWN;
+}
+
+static uint32_t be16(const unsigned char* p) { return (uint32_t)p[0] << 8 | p[1]; }
+static uint32_t be32(const unsigned char* p) { return be16(p) << 16 | be16(p + 2); }
+static uint32_t le16(const unsigned char* p) { return (uint32_t)p[1] << 8 | p[0]; }
+static uint32_t le32(const unsigned char* p) { return le16(p + 2) << 16 | le16(p); }
+
+// ============================================================================
+// Sources
+// ============================================================================
+//
+// Header parsing reads a file with pread, so image_info on a large photo
+// touches only the few kilobytes in front of its frame header.
+
+typedef struct MediaSource {
+    const unsigned char* data;  // NULL for a file
+    size_t len;
+    int fd;
+} MediaSource;
+
+static bool source_open(MediaSource* src, const Value* v, char* err, size_t err_len) {
+    src->data = NULL;
+    src->len = 0;
+    src->fd = -1;
+    if (v->type == VAL_STRING) {
+        struct stat st;
+        src->fd = open(v->string_val, O_RDONLY);
+        if (src->fd < 0 || fstat(src->fd, &st) != 0) {
+            snprintf(err, err_len, "%s: %s", v->string_val, strerror(errno));
+            if (src->fd >= 0) close(src->fd);
+            return false;
+        }
+        src->len = (size_t)st.st_size;
+        return true;
+    }
+    if (v->type != VAL_BYTES) {
+        snprintf(err, err_len, "expected a path or bytes");
+        return false;
+    }
+    src->data = value_bytes(v, &src->len);
+    return true;
+}
+
+static size_t source_read(const MediaSource* src, size_t off, unsigned char* buf, size_t n) {
+    if (off >= src->len) return 0;
+    if (n > src->len - off) n = src->len - off;
+    if (src->data) {
+        memcpy(buf, src->data + off, n);
+        return n;
+    }
+    ssize_t got = pread(src->fd, buf, n, (off_t)off);
+    return got < 0 ? 0 : (size_t)got;
+}
+
+static void source_close(MediaSource* src) {
+    if (src->fd >= 0) close(src->fd);
+    src->fd = -1;
+}
+
+static unsigned char* read_whole_file(const char* path, size_t* len, char* err, size_t err_len) {
+    FILE* f = fopen(path, "rb");
+    struct stat st;
+    if (!f || fstat(fileno(f), &st) != 0) {
+        snprintf(err, err_len, "%s: %s", path, strerror(errno));
+        if (f) fclose(f);
+        return NULL;
+    }
+    unsigned char* data = malloc((size_t)st.st_size + 1);
+    *len = data ? fread(data, 1, (size_t)st.st_size, f) : 0;
+    fclose(f);
+    if (!data || *len != (size_t)st.st_size) {
+        snprintf(err, err_len, "%s: short read", path);
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+static bool write_whole_file(const char* path, const unsigned char* data, size_t len, char* err, size_t err_len) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        snprintf(err, err_len, "%s: %s", path, strerror(errno));
+        return false;
+    }
+    bool ok = fwrite(data, 1, len, f) == len;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) snprintf(err, err_len, "%s: write failed", path);
+    return ok;
+}
+
+// ============================================================================
+// Headers
+// ============================================================================
+
+typedef struct ImageHeader {
+    MediaFormat format;
+    int width;
+    int height;
+    int channels;
+    int bit_depth;
+} ImageHeader;
+
+typedef struct AudioHeader {
+    const char* codec;
+    int sample_rate;
+    int channels;
+    int bits_per_sample;
+    long long frames;
+} AudioHeader;
+
+// The IHDR chunk always comes first.
+static bool png_header(const MediaSource* src, ImageHeader* h, char* err, size_t err_len) {
+    unsigned char b[26];
+    if (source_read(src, 0, b, sizeof(b)) < sizeof(b) || memcmp(b + 12, "IHDR", 4) != 0) {
+        snprintf(err, err_len, "truncated PNG header");
+        return false;
+    }
+    h->width = (int)be32(b + 16);
+    h->height = (int)be32(b + 20);
+    h->bit_depth = b[24];
+    switch (b[25]) {
+        case 0: h->channels = 1; break;
+        case 2: h->channels = 3; break;
+        case 3: h->channels = 3; break;   // palette; a tRNS chunk adds alpha on decode
+        case 4: h->channels = 2; break;
+        case 6: h->channels = 4; break;
+        default:
+            snprintf(err, err_len, "bad PNG color type %d", b[25]);
+            return false;
+    }
+    return true;
+}
+
+// Walks the marker segments up to the first SOFn frame header.
+static bool jpeg_header(const MediaSource* src, ImageHeader* h, char* err, size_t err_len) {
+    size_t pos = 2;
+    unsigned char b[8];
+    for (;;) {
+        if (source_read(src, pos, b, 2) < 2 || b[0] != 0xFF) break;
+        unsigned char marker = b[1];
+        if (marker == 0xFF) {          // fill byte
+            pos++;
+            continue;
+        }
+        pos += 2;
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) continue;
+        if (marker == 0xD9 || marker == 0xDA) break;
+        if (source_read(src, pos, b, 8) < 2) break;
+        size_t seg_len = be16(b);
+        bool sof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (sof) {
+            if (seg_len < 8 || source_read(src, pos, b, 8) < 8) break;
+            h->bit_depth = b[2];
+            h->height = (int)be16(b + 3);
+            h->width = (int)be16(b + 5);
+            h->channels = b[7];
+            return true;
+        }
+        if (seg_len < 2) break;
+        pos += seg_len;
+    }
+    snprintf(err, err_len, "no JPEG frame header");
+    return false;
+}
+
+static bool image_header(const MediaSource* src, ImageHeader* h, char* err, size_t err_len) {
+    unsigned char head[12];
+    size_t n = source_read(src, 0, head, sizeof(head));
+    h->format = format_sniff(head, n);
+    if (h->format == MEDIA_PNG) return png_header(src, h, err, err_len);
+    if (h->format == MEDIA_JPEG) return jpeg_header(src, h, err, err_len);
+    snprintf(err, err_len, "not a PNG or JPEG image");
+    return false;
+}
+
+static const char* wav_codec(uint32_t tag) {
+    switch (tag) {
+        case 1: return "pcm";
+        case 3: return "float";
+        case 6: return "alaw";
+        case 7: return "mulaw";
+        default: return "unknown";
+    }
+}
+
+// RIFF chunks: "fmt " describes the samples, "data" holds them. A data
+// size past the end of the file (streamed WAVs write 0xFFFFFFFF) is
+// clamped to what is there.
+static bool wav_header(const MediaSource* src, AudioHeader* a, char* err, size_t err_len) {
+    unsigned char b[26];
+    size_t pos = 12;
+    uint32_t block_align = 0;
+    bool have_fmt = false;
+    while (source_read(src, pos, b, 8) == 8) {
+        uint32_t size = le32(b + 4);
+        pos += 8;
+        if (memcmp(b, "fmt ", 4) == 0) {
+            if (size < 16 || source_read(src, pos, b, size >= 26 ? 26 : 16) < 16) break;
+            uint32_t tag = le16(b);
+            if (tag == 0xFFFE && size >= 26) tag = le16(b + 24);   // WAVE_FORMAT_EXTENSIBLE
+            a->codec = wav_codec(tag);
+            a->channels = (int)le16(b + 2);
+            a->sample_rate = (int)le32(b + 4);
+            block_align = le16(b + 12);
+            a->bits_per_sample = (int)le16(b + 14);
+            have_fmt = true;
+        } else if (memcmp(b, "data", 4) == 0) {
+            if (!have_fmt || block_align == 0) break;
+            size_t avail = src->len - pos;
+            a->frames = (long long)((size < avail ? size : avail) / block_align);
+            return true;
+        }
+        pos += size + (size & 1);
+    }
+    snprintf(err, err_len, have_fmt ? "no WAV data chunk" : "no WAV fmt chunk");
+    return false;
+}
+
+// ============================================================================
+// Images
+// ============================================================================
+//
+// Pixels are 8-bit, rows packed without padding: gray, gray + alpha, RGB or
+// RGBA. Handles live in a process-wide table, so parallel jobs may load
+// and save images too.
+
+typedef struct Image {
+    int width;
+    int height;
+    int channels;
+    MediaFormat format;          // what it was decoded from
+    unsigned char* pixels;
+} Image;
+
+static Image** media_images = NULL;
+static int media_image_count = 0;
+static int media_image_capacity = 0;
+static uv_rwlock_t media_lock;
+static uv_once_t media_once = UV_ONCE_INIT;
+
+static void media_init_lock(void) {
+    uv_rwlock_init(&media_lock);
+}
+
+static bool image_size_ok(long long width, long long height, char* err, size_t err_len) {
+    if (width < 1 || height < 1 || width * height > MEDIA_MAX_PIXELS) {
+        snprintf(err, err_len, "unsupported image size %lldx%lld", width, height);
+        return false;
+    }
+    return true;
+}
+
+static Image* image_new(int width, int height, int channels, MediaFormat format) {
+    Image* img = malloc(sizeof(Image));
+    if (!img) return NULL;
+    img->width = width;
+    img->height = height;
+    img->channels = channels;
+    img->format = format;
+    img->pixels = malloc((size_t)width * height * channels);
+    if (!img->pixels) {
+        free(img);
+        return NULL;
+    }
+    return img;
+}
+
+static void image_free(Image* img) {
+    if (!img) return;
+    free(img->pixels);
+    free(img);
+}
+
+static Value image_handle(Image* img) {
+    uv_once(&media_once, media_init_lock);
+    uv_rwlock_wrlock(&media_lock);
+    if (media_image_count == media_image_capacity) {
+        media_image_capacity = media_image_capacity ? media_image_capacity * 2 : 16;
+        media_images = realloc(media_images, (size_t)media_image_capacity * sizeof(Image*));
+    }
+    media_images[media_image_count++] = img;
+    char handle[32];
+    snprintf(handle, sizeof(handle), "image_%d", media_image_count);
+    uv_rwlock_wrunlock(&media_lock);
+    return make_string(handle);
+}
+
+static int image_id(const Value* v) {
+    if (v->type != VAL_STRING || strncmp(v->string_val, "image_", 6) != 0) return 0;
+    return atoi(v->string_val + 6);
+}
+
+static Image* image_find(const Value* v) {
+    int id = image_id(v);
+    if (id < 1) return NULL;
+    uv_once(&media_once, media_init_lock);
+    uv_rwlock_rdlock(&media_lock);
+    Image* img = id <= media_image_count ? media_images[id - 1] : NULL;
+    uv_rwlock_rdunlock(&media_lock);
+    return img;
+}
+
+// ============================================================================
+// Decoding
+// ============================================================================
+
+static Image* decode_png(const unsigned char* data, size_t len, char* err, size_t err_len) {
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&png, data, len)) {
+        snprintf(err, err_len, "PNG: %s", png.message);
+        return NULL;
+    }
+    // 8-bit samples, keeping whether the file has color and alpha.
+    png.format &= PNG_FORMAT_FLAG_COLOR | PNG_FORMAT_FLAG_ALPHA;
+    Image* img = NULL;
+    if (image_size_ok(png.width, png.height, err, err_len)) {
+        img = image_new((int)png.width, (int)png.height, (int)PNG_IMAGE_SAMPLE_CHANNELS(png.format), MEDIA_PNG);
+    }
+    if (!img) {
+        png_image_free(&png);
+        return NULL;
     }
-    
-    const char* path = args[0].string_val;
-    printf("🖼️ RADS Media Engine: Analyzing image '%s'...\n", path);
-    printf("📊 Detected: 1920x1080 (PNG/RGBA)\n");
-    
+    if (!png_image_finish_read(&png, NULL, img->pixels, 0, NULL)) {
+        snprintf(err, err_len, "PNG: %s", png.message);
+        png_image_free(&png);
+        image_free(img);
+        return NULL;
+    }
+    return img;
+}
+
+typedef struct JpegError {
+    struct jpeg_error_mgr mgr;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+} JpegError;
+
+static void jpeg_on_error(j_common_ptr cinfo) {
+    JpegError* e = (JpegError*)cinfo->err;
+    cinfo->err->format_message(cinfo, e->message);
+    longjmp(e->jump, 1);
+}
+
+static void jpeg_quiet(j_common_ptr cinfo) {
+    (void)cinfo;
+}
+
+// Adobe writes CMYK inverted; multiplying by K gives a fair RGB.
+static void cmyk_to_rgb(const unsigned char* src, unsigned char* dst, int width) {
+    for (int x = 0; x < width; x++) {
+        unsigned k = src[4 * x + 3];
+        dst[3 * x] = (unsigned char)(src[4 * x] * k / 255);
+        dst[3 * x + 1] = (unsigned char)(src[4 * x + 1] * k / 255);
+        dst[3 * x + 2] = (unsigned char)(src[4 * x + 2] * k / 255);
+    }
+}
+
+typedef struct JpegDecode {
+    struct jpeg_decompress_struct cinfo;
+    JpegError err;
+    Image* img;
+    unsigned char* row;
+} JpegDecode;
+
+// fit_width x fit_height, when set, lets libjpeg decode at 1/2, 1/4 or 1/8
+// scale (straight from the DCT coefficients) as long as the result still
+// covers it.
+static bool jpeg_decode_into(JpegDecode* d, const unsigned char* data, size_t len, int fit_width, int fit_height,
+                             char* err, size_t err_len) {
+    struct jpeg_decompress_struct* cinfo = &d->cinfo;
+    if (setjmp(d->err.jump)) {
+        snprintf(err, err_len, "JPEG: %s", d->err.message);
+        return false;
+    }
+    jpeg_create_decompress(cinfo);
+    jpeg_mem_src(cinfo, data, (unsigned long)len);
+    jpeg_read_header(cinfo, TRUE);
+    if (!image_size_ok(cinfo->image_width, cinfo->image_height, err, err_len)) return false;
+    if (fit_width > 0 && fit_height > 0) {
+        for (unsigned denom = 8; denom > 1; denom /= 2) {
+            if ((cinfo->image_width + denom - 1) / denom >= (unsigned)fit_width &&
+                (cinfo->image_height + denom - 1) / denom >= (unsigned)fit_height) {
+                cinfo->scale_num = 1;
+                cinfo->scale_denom = denom;
+                break;
+            }
+        }
+    }
+    bool cmyk = cinfo->num_components == 4;
+    cinfo->out_color_space = cinfo->num_components == 1 ? JCS_GRAYSCALE : cmyk ? JCS_CMYK : JCS_RGB;
+    jpeg_start_decompress(cinfo);
+    d->img = image_new((int)cinfo->output_width, (int)cinfo->output_height, cmyk ? 3 : cinfo->output_components,
+                       MEDIA_JPEG);
+    if (cmyk) d->row = malloc((size_t)cinfo->output_width * 4);
+    if (!d->img || (cmyk && !d->row)) {
+        snprintf(err, err_len, "out of memory");
+        return false;
+    }
+    size_t stride = (size_t)d->img->width * d->img->channels;
+    while (cinfo->output_scanline < cinfo->output_height) {
+        unsigned char* dst = d->img->pixels + (size_t)cinfo->output_scanline * stride;
+        JSAMPROW rows[1] = { cmyk ? d->row : dst };
+        jpeg_read_scanlines(cinfo, rows, 1);
+        if (cmyk) cmyk_to_rgb(d->row, dst, d->img->width);
+    }
+    jpeg_finish_decompress(cinfo);
+    return true;
+}
+
+static Image* decode_jpeg(const unsigned char* data, size_t len, int fit_width, int fit_height,
+                          char* err, size_t err_len) {
+    JpegDecode d;
+    memset(&d, 0, sizeof(d));
+    d.cinfo.err = jpeg_std_error(&d.err.mgr);
+    d.err.mgr.error_exit = jpeg_on_error;
+    d.err.mgr.output_message = jpeg_quiet;
+    bool ok = jpeg_decode_into(&d, data, len, fit_width, fit_height, err, err_len);
+    jpeg_destroy_decompress(&d.cinfo);
+    free(d.row);
+    if (!ok) {
+        image_free(d.img);
+        return NULL;
+    }
+    return d.img;
+}
+
+static Image* decode_image(const unsigned char* data, size_t len, int fit_width, int fit_height,
+                           char* err, size_t err_len) {
+    switch (format_sniff(data, len)) {
+        case MEDIA_PNG: return decode_png(data, len, err, err_len);
+        case MEDIA_JPEG: return decode_jpeg(data, len, fit_width, fit_height, err, err_len);
+        default:
+            snprintf(err, err_len, "not a PNG or JPEG image");
+            return NULL;
+    }
+}
+
+// ============================================================================
+// Encoding
+// ============================================================================
+
+static unsigned char* encode_png(const Image* img, size_t* len, char* err, size_t err_len) {
+    static const png_uint_32 formats[5] = { 0, PNG_FORMAT_GRAY, PNG_FORMAT_GA, PNG_FORMAT_RGB, PNG_FORMAT_RGBA };
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = (png_uint_32)img->width;
+    png.height = (png_uint_32)img->height;
+    png.format = formats[img->channels];
+    png_alloc_size_t size = 0;
+    if (!png_image_write_to_memory(&png, NULL, &size, 0, img->pixels, 0, NULL)) {
+        snprintf(err, err_len, "PNG: %s", png.message);
+        return NULL;
+    }
+    unsigned char* out = malloc(size);
+    if (!out || !png_image_write_to_memory(&png, out, &size, 0, img->pixels, 0, NULL)) {
+        snprintf(err, err_len, "PNG: %s", out ? png.message : "out of memory");
+        free(out);
+        return NULL;
+    }
+    *len = size;
+    return out;
+}
+
+typedef struct JpegEncode {
+    struct jpeg_compress_struct cinfo;
+    JpegError err;
+    unsigned char* out;
+    unsigned long out_len;
+    unsigned char* row;
+} JpegEncode;
+
+// JPEG has no alpha channel; it is dropped.
+static bool jpeg_encode_into(JpegEncode* e, const Image* img, int quality, char* err, size_t err_len) {
+    struct jpeg_compress_struct* cinfo = &e->cinfo;
+    if (setjmp(e->err.jump)) {
+        snprintf(err, err_len, "JPEG: %s", e->err.message);
+        return false;
+    }
+    jpeg_create_compress(cinfo);
+    jpeg_mem_dest(cinfo, &e->out, &e->out_len);
+    bool color = img->channels >= 3;
+    bool alpha = img->channels == 2 || img->channels == 4;
+    cinfo->image_width = (JDIMENSION)img->width;
+    cinfo->image_height = (JDIMENSION)img->height;
+    cinfo->input_components = color ? 3 : 1;
+    cinfo->in_color_space = color ? JCS_RGB : JCS_GRAYSCALE;
+    jpeg_set_defaults(cinfo);
+    jpeg_set_quality(cinfo, quality, TRUE);
+    if (alpha) e->row = malloc((size_t)img->width * 3);
+    jpeg_start_compress(cinfo, TRUE);
+    size_t stride = (size_t)img->width * img->channels;
+    int keep = cinfo->input_components;
+    while (cinfo->next_scanline < cinfo->image_height) {
+        unsigned char* src = img->pixels + (size_t)cinfo->next_scanline * stride;
+        if (alpha) {
+            for (int x = 0; x < img->width; x++) {
+                memcpy(e->row + (size_t)x * keep, src + (size_t)x * img->channels, (size_t)keep);
+            }
+            src = e->row;
+        }
+        JSAMPROW rows[1] = { src };
+        jpeg_write_scanlines(cinfo, rows, 1);
+    }
+    jpeg_finish_compress(cinfo);
+    return true;
+}
+
+static unsigned char* encode_jpeg(const Image* img, int quality, size_t* len, char* err, size_t err_len) {
+    JpegEncode e;
+    memset(&e, 0, sizeof(e));
+    e.cinfo.err = jpeg_std_error(&e.err.mgr);
+    e.err.mgr.error_exit = jpeg_on_error;
+    e.err.mgr.output_message = jpeg_quiet;
+    bool ok = jpeg_encode_into(&e, img, quality, err, err_len);
+    jpeg_destroy_compress(&e.cinfo);
+    free(e.row);
+    if (!ok) {
+        free(e.out);
+        return NULL;
+    }
+    *len = e.out_len;
+    return e.out;
+}
+
+static unsigned char* encode_image(const Image* img, MediaFormat format, int quality, size_t* len,
+                                   char* err, size_t err_len) {
+    if (format == MEDIA_PNG) return encode_png(img, len, err, err_len);
+    if (format == MEDIA_JPEG) return encode_jpeg(img, quality, len, err, err_len);
+    snprintf(err, err_len, "can only encode png or jpeg");
+    return NULL;
+}
+
+// ============================================================================
+// Resampling
+// ============================================================================
+//
+// Each output coordinate reads a fixed-size window of `taps` source
+// coordinates with precomputed weights (zero where the filter is), so the
+// kernels have no edge cases. Shrinking stretches the filter over the
+// source pixels each output pixel covers. Pixels are four floats wide
+// whatever the channel count, color premultiplied by alpha, so
+// transparent pixels do not bleed their color into their neighbours.
+
+typedef enum {
+    FILTER_BOX,
+    FILTER_BILINEAR,
+    FILTER_LANCZOS
+} ResampleFilter;
+
+typedef struct ResampleAxis {
+    int taps;
+    int* start;              // first source index of each output's window
+    float* weights;          // taps per output
+} ResampleAxis;
+
+static bool filter_named(const char* name, ResampleFilter* filter) {
+    if (strcmp(name, "box") == 0) *filter = FILTER_BOX;
+    else if (strcmp(name, "bilinear") == 0) *filter = FILTER_BILINEAR;
+    else if (strcmp(name, "lanczos") == 0) *filter = FILTER_LANCZOS;
+    else return false;
+    return true;
+}
+
+static double filter_support(ResampleFilter filter) {
+    switch (filter) {
+        case FILTER_BOX: return 0.5;
+        case FILTER_BILINEAR: return 1.0;
+        default: return 3.0;
+    }
+}
+
+static double sinc(double x) {
+    if (x == 0.0) return 1.0;
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+static double filter_weight(ResampleFilter filter, double x) {
+    switch (filter) {
+        case FILTER_BOX: return x >= -0.5 && x < 0.5 ? 1.0 : 0.0;
+        case FILTER_BILINEAR: return x < 0 ? (x > -1.0 ? 1.0 + x : 0.0) : (x < 1.0 ? 1.0 - x : 0.0);
+        default: return x > -3.0 && x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+    }
+}
+
+static void axis_free(ResampleAxis* ax) {
+    free(ax->start);
+    free(ax->weights);
+}
+
+static bool axis_init(ResampleAxis* ax, int in_n, int out_n, ResampleFilter filter) {
+    double scale = (double)out_n / in_n;
+    double stretch = scale < 1.0 ? 1.0 / scale : 1.0;
+    double support = filter_support(filter) * stretch;
+    int taps = in_n == out_n ? 1 : (int)ceil(support * 2.0) + 1;
+    if (taps > in_n) taps = in_n;
+    ax->taps = taps;
+    ax->start = malloc((size_t)out_n * sizeof(int));
+    ax->weights = calloc((size_t)out_n * taps, sizeof(float));
+    if (!ax->start || !ax->weights) {
+        axis_free(ax);
+        return false;
+    }
+    for (int i = 0; i < out_n; i++) {
+        float* w = ax->weights + (size_t)i * taps;
+        if (in_n == out_n) {
+            ax->start[i] = i;
+            w[0] = 1.0f;
+            continue;
+        }
+        double center = (i + 0.5) / scale - 0.5;
+        int lo = (int)ceil(center - support);
+        int hi = (int)floor(center + support);
+        if (lo < 0) lo = 0;
+        if (hi > in_n - 1) hi = in_n - 1;
+        if (hi < lo) hi = lo;
+        int first = lo < in_n - taps ? lo : in_n - taps;
+        double total = 0.0;
+        for (int j = lo; j <= hi; j++) {
+            double v = filter_weight(filter, (j - center) / stretch);
+            w[j - first] = (float)v;
+            total += v;
+        }
+        if (total == 0.0) {
+            long nearest = lround(center);
+            if (nearest < lo) nearest = lo;
+            if (nearest > hi) nearest = hi;
+            w[nearest - first] = 1.0f;
+        } else {
+            for (int j = lo; j <= hi; j++) w[j - first] = (float)(w[j - first] / total);
+        }
+        ax->start[i] = first;
+    }
+    return true;
+}
+
+// One row of the horizontal pass: out_n four-float pixels.
+typedef void (*HorizontalFn)(const float* in, float* out, const ResampleAxis* ax, int out_n);
+// One row of the vertical pass: n floats from taps rows, stride floats
+// apart, starting at row start.
+typedef void (*VerticalFn)(const float* in, size_t stride, int start, const float* w, int taps, float* out, size_t n);
+
+static void horizontal_scalar(const float* in, float* out, const ResampleAxis* ax, int out_n) {
+    for (int i = 0; i < out_n; i++) {
+        const float* p = in + (size_t)ax->start[i] * 4;
+        const float* w = ax->weights + (size_t)i * ax->taps;
+        float a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+        for (int k = 0; k < ax->taps; k++) {
+            a0 += w[k] * p[4 * k];
+            a1 += w[k] * p[4 * k + 1];
+            a2 += w[k] * p[4 * k + 2];
+            a3 += w[k] * p[4 * k + 3];
+        }
+        float* o = out + (size_t)i * 4;
+        o[0] = a0;
+        o[1] = a1;
+        o[2] = a2;
+        o[3] = a3;
+    }
+}
+
+static void vertical_scalar(const float* in, size_t stride, int start, const float* w, int taps, float* out, size_t n) {
+    const float* row = in + (size_t)start * stride;
+    for (size_t j = 0; j < n; j++) out[j] = w[0] * row[j];
+    for (int k = 1; k < taps; k++) {
+        row += stride;
+        for (size_t j = 0; j < n; j++) out[j] += w[k] * row[j];
+    }
+}
+
+#ifdef MEDIA_X86
+
+// SSE2 is part of x86-64: one pixel per register. Two accumulators halve
+// the chain of dependent adds on wide (shrinking) windows.
+static void horizontal_sse(const float* in, float* out, const ResampleAxis* ax, int out_n) {
+    int taps = ax->taps;
+    for (int i = 0; i < out_n; i++) {
+        const float* p = in + (size_t)ax->start[i] * 4;
+        const float* w = ax->weights + (size_t)i * taps;
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        int k = 0;
+        for (; k + 2 <= taps; k += 2) {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(p + 4 * k)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_set1_ps(w[k + 1]), _mm_loadu_ps(p + 4 * k + 4)));
+        }
+        if (k < taps) acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(p + 4 * k)));
+        _mm_storeu_ps(out + (size_t)i * 4, _mm_add_ps(acc0, acc1));
+    }
+}
+
+// n is a multiple of 4 (whole pixels).
+static void vertical_sse(const float* in, size_t stride, int start, const float* w, int taps, float* out, size_t n) {
+    const float* base = in + (size_t)start * stride;
+    for (size_t j = 0; j < n; j += 4) {
+        __m128 acc = _mm_setzero_ps();
+        const float* p = base + j;
+        for (int k = 0; k < taps; k++, p += stride) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(p)));
+        }
+        _mm_storeu_ps(out + j, acc);
+    }
+}
+
+#define AVX2 __attribute__((target("avx2")))
+
+// Two taps (two source pixels) per register, two registers per step.
+AVX2 static void horizontal_avx2(const float* in, float* out, const ResampleAxis* ax, int out_n) {
+    int taps = ax->taps;
+    for (int i = 0; i < out_n; i++) {
+        const float* p = in + (size_t)ax->start[i] * 4;
+        const float* w = ax->weights + (size_t)i * taps;
+        __m256 acc = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        int k = 0;
+        for (; k + 4 <= taps; k += 4) {
+            __m256 w01 = _mm256_set_m128(_mm_set1_ps(w[k + 1]), _mm_set1_ps(w[k]));
+            __m256 w23 = _mm256_set_m128(_mm_set1_ps(w[k + 3]), _mm_set1_ps(w[k + 2]));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(w01, _mm256_loadu_ps(p + 4 * k)));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(w23, _mm256_loadu_ps(p + 4 * k + 8)));
+        }
+        acc = _mm256_add_ps(acc, acc1);
+        for (; k + 2 <= taps; k += 2) {
+            __m256 wk = _mm256_set_m128(_mm_set1_ps(w[k + 1]), _mm_set1_ps(w[k]));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(wk, _mm256_loadu_ps(p + 4 * k)));
+        }
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        if (k < taps) sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(p + 4 * k)));
+        _mm_storeu_ps(out + (size_t)i * 4, sum);
+    }
+}
+
+AVX2 static void vertical_avx2(const float* in, size_t stride, int start, const float* w, int taps, float* out,
+                               size_t n) {
+    const float* base = in + (size_t)start * stride;
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256 acc = _mm256_setzero_ps();
+        const float* p = base + j;
+        for (int k = 0; k < taps; k++, p += stride) {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(w[k]), _mm256_loadu_ps(p)));
+        }
+        _mm256_storeu_ps(out + j, acc);
+    }
+    if (j < n) vertical_sse(in + j, stride, start, w, taps, out + j, n - j);
+}
+
+#endif // MEDIA_X86
+
+// Follows the string kernels' choice, so RADS_SIMD caps this too.
+static void resample_kernels(HorizontalFn* horizontal, VerticalFn* vertical) {
+    *horizontal = horizontal_scalar;
+    *vertical = vertical_scalar;
+#ifdef MEDIA_X86
+    if (textscan_level() == TEXTSCAN_AVX2) {
+        *horizontal = horizontal_avx2;
+        *vertical = vertical_avx2;
+    } else if (textscan_level() != TEXTSCAN_SCALAR) {
+        *horizontal = horizontal_sse;
+        *vertical = vertical_sse;
+    }
+#endif
+}
+
+static void row_to_float(const unsigned char* src, float* dst, int width, int channels) {
+    switch (channels) {
+        case 1:
+            for (int x = 0; x < width; x++, dst += 4) {
+                dst[0] = src[x];
+                dst[1] = dst[2] = dst[3] = 0.0f;
+            }
+            break;
+        case 2:
+            for (int x = 0; x < width; x++, src += 2, dst += 4) {
+                float a = src[1] * (1.0f / 255.0f);
+                dst[0] = src[0] * a;
+                dst[1] = dst[2] = 0.0f;
+                dst[3] = src[1];
+            }
+            break;
+        case 3:
+            for (int x = 0; x < width; x++, src += 3, dst += 4) {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+                dst[3] = 0.0f;
+            }
+            break;
+        default:
+            for (int x = 0; x < width; x++, src += 4, dst += 4) {
+                float a = src[3] * (1.0f / 255.0f);
+                dst[0] = src[0] * a;
+                dst[1] = src[1] * a;
+                dst[2] = src[2] * a;
+                dst[3] = src[3];
+            }
+            break;
+    }
+}
+
+static unsigned char to_u8(float v) {
+    v += 0.5f;
+    return v <= 0.0f ? 0 : v >= 255.0f ? 255 : (unsigned char)v;
+}
+
+static void float_to_row(const float* src, unsigned char* dst, int width, int channels) {
+    for (int x = 0; x < width; x++, src += 4) {
+        unsigned char* d = dst + (size_t)x * channels;
+        bool alpha = channels == 2 || channels == 4;
+        float unpremultiply = alpha ? (src[3] > 0.0f ? 255.0f / src[3] : 0.0f) : 1.0f;
+        for (int c = 0; c < (alpha ? channels - 1 : channels); c++) d[c] = to_u8(src[c] * unpremultiply);
+        if (alpha) d[channels - 1] = to_u8(src[3]);
+    }
+}
+
+static Image* image_resample(const Image* src, int width, int height, ResampleFilter filter,
+                             char* err, size_t err_len) {
+    if (!image_size_ok(width, height, err, err_len)) return NULL;
+    ResampleAxis ax_x, ax_y;
+    if (!axis_init(&ax_x, src->width, width, filter)) {
+        snprintf(err, err_len, "out of memory");
+        return NULL;
+    }
+    if (!axis_init(&ax_y, src->height, height, filter)) {
+        axis_free(&ax_x);
+        snprintf(err, err_len, "out of memory");
+        return NULL;
+    }
+    HorizontalFn horizontal;
+    VerticalFn vertical;
+    resample_kernels(&horizontal, &vertical);
+
+    size_t mid_stride = (size_t)width * 4;
+    size_t src_stride = (size_t)src->width * src->channels;
+    size_t dst_stride = (size_t)width * src->channels;
+    float* row = malloc((size_t)src->width * 4 * sizeof(float));
+    float* mid = malloc((size_t)src->height * mid_stride * sizeof(float));
+    float* out = malloc(mid_stride * sizeof(float));
+    Image* dst = image_new(width, height, src->channels, src->format);
+    if (!row || !mid || !out || !dst) {
+        snprintf(err, err_len, "out of memory");
+        image_free(dst);
+        dst = NULL;
+    } else {
+        for (int y = 0; y < src->height; y++) {
+            row_to_float(src->pixels + (size_t)y * src_stride, row, src->width, src->channels);
+            horizontal(row, mid + (size_t)y * mid_stride, &ax_x, width);
+        }
+        for (int y = 0; y < height; y++) {
+            vertical(mid, mid_stride, ax_y.start[y], ax_y.weights + (size_t)y * ax_y.taps, ax_y.taps, out, mid_stride);
+            float_to_row(out, dst->pixels + (size_t)y * dst_stride, width, src->channels);
+        }
+    }
+    free(row);
+    free(mid);
+    free(out);
+    axis_free(&ax_x);
+    axis_free(&ax_y);
+    return dst;
+}
+
+// ============================================================================
+// Pipeline
+// ============================================================================
+//
+// media.thumbnail and media.convert: read, decode, resize, encode, then
+// write a file or hand back the bytes. A task touches no interpreter
+// state, so its _async form runs it on the libuv threadpool.
+
+typedef struct MediaTask {
+    char* src_path;
+    const unsigned char* src_data;
+    size_t src_len;
+    unsigned char* src_copy;    // owned copy of src_data for a threadpool job
+    char* dst_path;             // NULL: the result is the encoded bytes
+    MediaFormat dst_format;
+    int box_width;              // thumbnail bounds; 0 leaves a side free
+    int box_height;
+    ResampleFilter filter;
+    int quality;
+    bool ok;
+    unsigned char* out;
+    size_t out_len;
+    char error[256];
+} MediaTask;
+
+// Shrinks width x height to fit the box, keeping the aspect ratio.
+static void fit_box(int* width, int* height, int box_width, int box_height) {
+    double scale = 1.0;
+    if (box_width > 0 && box_width < *width) scale = (double)box_width / *width;
+    if (box_height > 0 && (double)box_height / *height < scale) scale = (double)box_height / *height;
+    if (scale >= 1.0) return;
+    *width = (int)lround(*width * scale);
+    *height = (int)lround(*height * scale);
+    if (*width < 1) *width = 1;
+    if (*height < 1) *height = 1;
+}
+
+static void task_run(MediaTask* t) {
+    char* err = t->error;
+    size_t err_len = sizeof(t->error);
+    const unsigned char* data = t->src_data;
+    size_t len = t->src_len;
+    unsigned char* file = NULL;
+    Image* img = NULL;
+    if (t->src_path) {
+        file = read_whole_file(t->src_path, &len, err, err_len);
+        if (!file) return;
+        data = file;
+    }
+    MediaSource src = { data, len, -1 };
+    ImageHeader h;
+    if (!image_header(&src, &h, err, err_len)) goto done;
+    int width = h.width, height = h.height;
+    fit_box(&width, &height, t->box_width, t->box_height);
+    img = decode_image(data, len, width, height, err, err_len);
+    if (!img) goto done;
+    if (img->width != width || img->height != height) {
+        Image* scaled = image_resample(img, width, height, t->filter, err, err_len);
+        image_free(img);
+        img = scaled;
+        if (!img) goto done;
+    }
+    t->out = encode_image(img, t->dst_format, t->quality, &t->out_len, err, err_len);
+    if (!t->out) goto done;
+    if (t->dst_path) {
+        bool written = write_whole_file(t->dst_path, t->out, t->out_len, err, err_len);
+        free(t->out);
+        t->out = NULL;
+        if (!written) goto done;
+    }
+    t->ok = true;
+done:
+    free(file);
+    image_free(img);
+}
+
+static void task_free(MediaTask* t) {
+    free(t->src_path);
+    free(t->src_copy);
+    free(t->dst_path);
+    free(t->out);
+}
+
+// Takes the task's result: true for a file, the encoded bytes otherwise.
+static Value task_result(MediaTask* t, const char* fn) {
+    if (!t->ok) {
+        fprintf(stderr, "Error: %s: %s\n", fn, t->error);
+        return t->dst_path ? make_bool(false) : make_null();
+    }
+    if (t->dst_path) return make_bool(true);
+    Value v = make_bytes_owned(t->out, t->out_len, t->out_len);
+    t->out = NULL;
+    return v;
+}
+
+static int int_arg(int argc, Value* args, int i, int fallback) {
+    if (i >= argc) return fallback;
+    if (args[i].type == VAL_INT) return (int)args[i].int_val;
+    if (args[i].type == VAL_FLOAT) return (int)args[i].float_val;
+    return fallback;
+}
+
+// (src, dst, [width, height, filter,] quality): src is a path or bytes;
+// dst is an output path, or "png"/"jpeg" for bytes.
+static bool task_parse(MediaTask* t, const char* fn, int argc, Value* args, bool thumbnail, bool copy_src) {
+    memset(t, 0, sizeof(*t));
+    t->filter = FILTER_LANCZOS;
+    t->quality = MEDIA_DEFAULT_QUALITY;
+    int next = 2;
+    if (argc < (thumbnail ? 3 : 2) || (args[0].type != VAL_STRING && args[0].type != VAL_BYTES) ||
+        args[1].type != VAL_STRING) {
+        fprintf(stderr, "Error: %s expects (source, destination%s)\n", fn, thumbnail ? ", width, [height]" : "");
+        return false;
+    }
+    if (thumbnail) {
+        t->box_width = int_arg(argc, args, 2, 0);
+        t->box_height = int_arg(argc, args, 3, 0);
+        if (t->box_width < 0 || t->box_height < 0 || (t->box_width == 0 && t->box_height == 0)) {
+            fprintf(stderr, "Error: %s needs a positive width or height\n", fn);
+            return false;
+        }
+        if (argc > 4 && args[4].type == VAL_STRING && !filter_named(args[4].string_val, &t->filter)) {
+            fprintf(stderr, "Error: %s: unknown filter '%s' (box, bilinear, lanczos)\n", fn, args[4].string_val);
+            return false;
+        }
+        next = 5;
+    }
+    t->quality = int_arg(argc, args, next, MEDIA_DEFAULT_QUALITY);
+    if (t->quality < 1 || t->quality > 100) t->quality = MEDIA_DEFAULT_QUALITY;
+
+    const char* dst = args[1].string_val;
+    t->dst_format = format_named(dst);
+    if (t->dst_format == MEDIA_UNKNOWN) {
+        t->dst_format = format_for_path(dst);
+        if (t->dst_format == MEDIA_UNKNOWN) {
+            fprintf(stderr, "Error: %s: cannot tell the output format of '%s' (.png, .jpg)\n", fn, dst);
+            return false;
+        }
+        t->dst_path = strdup(dst);
+    }
+    if (args[0].type == VAL_STRING) {
+        t->src_path = strdup(args[0].string_val);
+    } else {
+        t->src_data = value_bytes(&args[0], &t->src_len);
+        if (copy_src) {
+            t->src_copy = malloc(t->src_len ? t->src_len : 1);
+            if (t->src_len) memcpy(t->src_copy, t->src_data, t->src_len);
+            t->src_data = t->src_copy;
+        }
+    }
+    return true;
+}
+
+typedef struct MediaJob {
+    uv_work_t work;
+    char handle[32];
+    const char* fn;
+    MediaTask task;
+    bool done;
+    struct MediaJob* next;
+} MediaJob;
+
+// Jobs are started and collected on the event loop thread.
+static MediaJob* media_jobs = NULL;
+static long next_job_id = 1;
+
+static MediaJob* job_find(const Value* v) {
+    if (v->type != VAL_STRING) return NULL;
+    for (MediaJob* j = media_jobs; j; j = j->next) {
+        if (strcmp(j->handle, v->string_val) == 0) return j;
+    }
+    return NULL;
+}
+
+static void job_work(uv_work_t* req) {
+    MediaJob* job = req->data;
+    task_run(&job->task);
+}
+
+static void job_after_work(uv_work_t* req, int status) {
+    MediaJob* job = req->data;
+    if (status != 0) snprintf(job->task.error, sizeof(job->task.error), "%s", uv_strerror(status));
+    job->done = true;
+    interpreter_wake(job->handle);
+}
+
+static Value job_start(const char* fn, int argc, Value* args, bool thumbnail) {
+    MediaJob* job = calloc(1, sizeof(MediaJob));
+    if (!task_parse(&job->task, fn, argc, args, thumbnail, true)) {
+        task_free(&job->task);
+        free(job);
+        return make_null();
+    }
+    job->fn = fn;
+    snprintf(job->handle, sizeof(job->handle), "media_job_%ld", next_job_id++);
+    job->work.data = job;
+    job->next = media_jobs;
+    media_jobs = job;
+    int rc = uv_queue_work(interpreter_init_event_loop(), &job->work, job_work, job_after_work);
+    if (rc != 0) {
+        snprintf(job->task.error, sizeof(job->task.error), "%s", uv_strerror(rc));
+        job->done = true;
+    }
+    return make_string(job->handle);
+}
+
+// ============================================================================
+// Natives
+// ============================================================================
+
+static StructDef image_info_def = { (char*)"image_info", NULL };
+static StructDef audio_info_def = { (char*)"audio_info", NULL };
+
+static Value info_struct(StructDef* def) {
     Value v;
-    v.type = VAL_STRING;
-    v.string_val = strdup("1920x1080 PNG");
+    v.type = VAL_STRUCT_INSTANCE;
+    v.struct_instance = malloc(sizeof(StructInstance));
+    v.struct_instance->definition = def;
+    v.struct_instance->fields = NULL;
+    return v;
+}
+
+static void info_field(FieldValue*** tail, const char* name, Value value) {
+    FieldValue* field = malloc(sizeof(FieldValue));
+    field->name = strdup(name);
+    field->value = malloc(sizeof(Value));
+    *field->value = value;
+    field->next = NULL;
+    **tail = field;
+    *tail = &field->next;
+}
+
+static Value image_info_value(const ImageHeader* h) {
+    Value v = info_struct(&image_info_def);
+    FieldValue** tail = &v.struct_instance->fields;
+    info_field(&tail, "format", make_string(format_name(h->format)));
+    info_field(&tail, "width", make_int(h->width));
+    info_field(&tail, "height", make_int(h->height));
+    info_field(&tail, "channels", make_int(h->channels));
+    info_field(&tail, "bit_depth", make_int(h->bit_depth));
     return v;
 }
 
+// media.image_info(path | bytes | image) -> {format, width, height, channels, bit_depth}
+Value native_media_image_info(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1) return make_null();
+    Image* img = image_find(&args[0]);
+    if (img) {
+        ImageHeader h = { img->format, img->width, img->height, img->channels, 8 };
+        return image_info_value(&h);
+    }
+    char err[256];
+    MediaSource src;
+    ImageHeader h;
+    bool ok = source_open(&src, &args[0], err, sizeof(err)) && image_header(&src, &h, err, sizeof(err));
+    source_close(&src);
+    if (!ok) {
+        fprintf(stderr, "Error: media.image_info(): %s\n", err);
+        return make_null();
+    }
+    return image_info_value(&h);
+}
+
+// media.audio_info(path | bytes) -> {format, codec, sample_rate, channels,
+// bits_per_sample, frames, duration}
 Value native_media_audio_info(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
-    if (argc < 1 || args[0].type != VAL_STRING) {
-        printf("⚠️ Media Error: Expected filename for audio_info\n");
-        Value v; v.type = VAL_NULL; return v;
+    if (argc < 1) return make_null();
+    char err[256];
+    MediaSource src;
+    AudioHeader a;
+    memset(&a, 0, sizeof(a));
+    bool ok = source_open(&src, &args[0], err, sizeof(err));
+    if (ok) {
+        unsigned char head[12];
+        size_t n = source_read(&src, 0, head, sizeof(head));
+        if (format_sniff(head, n) == MEDIA_WAV) {
+            ok = wav_header(&src, &a, err, sizeof(err));
+        } else {
+            ok = false;
+            snprintf(err, sizeof(err), "not a WAV file");
+        }
     }
-    
-    const char* path = args[0].string_val;
-    printf("🎵 RADS Media Engine: Analyzing audio '%s'...\n", path);
-    printf("📊 Detected: 44.1kHz 16-bit Stereo (MP3)\n");
-    
-    Value v;
-    v.type = VAL_STRING;
-    v.string_val = strdup("44100Hz MP3");
+    source_close(&src);
+    if (!ok) {
+        fprintf(stderr, "Error: media.audio_info(): %s\n", err);
+        return make_null();
+    }
+    Value v = info_struct(&audio_info_def);
+    FieldValue** tail = &v.struct_instance->fields;
+    info_field(&tail, "format", make_string("wav"));
+    info_field(&tail, "codec", make_string(a.codec));
+    info_field(&tail, "sample_rate", make_int(a.sample_rate));
+    info_field(&tail, "channels", make_int(a.channels));
+    info_field(&tail, "bits_per_sample", make_int(a.bits_per_sample));
+    info_field(&tail, "frames", make_int(a.frames));
+    info_field(&tail, "duration", make_float(a.sample_rate > 0 ? (double)a.frames / a.sample_rate : 0.0));
     return v;
 }
 
+// media.load_image(path | bytes) -> "image_<n>"
+Value native_media_load_image(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || (args[0].type != VAL_STRING && args[0].type != VAL_BYTES)) {
+        fprintf(stderr, "Error: media.load_image() expects a path or bytes\n");
+        return make_null();
+    }
+    char err[256];
+    size_t len = 0;
+    unsigned char* file = NULL;
+    const unsigned char* data;
+    if (args[0].type == VAL_STRING) {
+        data = file = read_whole_file(args[0].string_val, &len, err, sizeof(err));
+    } else {
+        data = value_bytes(&args[0], &len);
+    }
+    Image* img = data ? decode_image(data, len, 0, 0, err, sizeof(err)) : NULL;
+    free(file);
+    if (!img) {
+        fprintf(stderr, "Error: media.load_image(): %s\n", err);
+        return make_null();
+    }
+    return image_handle(img);
+}
+
+// media.from_pixels(width, height, channels, bytes) -> "image_<n>"
+static Value native_media_from_pixels(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    char err[256];
+    size_t len = 0;
+    const unsigned char* data = argc >= 4 && args[3].type == VAL_BYTES ? value_bytes(&args[3], &len) : NULL;
+    int width = int_arg(argc, args, 0, 0), height = int_arg(argc, args, 1, 0), channels = int_arg(argc, args, 2, 0);
+    if (!data || channels < 1 || channels > 4 || !image_size_ok(width, height, err, sizeof(err)) ||
+        len != (size_t)width * height * channels) {
+        fprintf(stderr, "Error: media.from_pixels() expects (width, height, channels 1-4, bytes of width*height*channels)\n");
+        return make_null();
+    }
+    Image* img = image_new(width, height, channels, MEDIA_RAW);
+    if (!img) return make_null();
+    memcpy(img->pixels, data, len);
+    return image_handle(img);
+}
+
+// media.thumbnail(src, dst, width, [height, filter, quality]): fits the
+// image inside width x height (0 for either leaves it free), never
+// enlarging it. dst is a path (true when written) or "png"/"jpeg" for the
+// encoded bytes.
+Value native_media_thumbnail(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MediaTask t;
+    if (!task_parse(&t, "media.thumbnail()", argc, args, true, false)) {
+        task_free(&t);
+        return make_null();
+    }
+    task_run(&t);
+    Value result = task_result(&t, "media.thumbnail()");
+    task_free(&t);
+    return result;
+}
+
+// media.convert(src, dst, [quality]): decodes and re-encodes, e.g. PNG to
+// JPEG.
 Value native_media_convert(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
-    if (argc < 2 || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
-        printf("⚠️ Media Error: Expected filename and target format for convert\n");
-        Value v; v.type = VAL_BOOL; v.bool_val = false; return v;
-    }
-    
-    const char* source = args[0].string_val;
-    const char* target = args[1].string_val;
-    
-    printf("🔥 RADS BLAST: Converting '%s' to '%s'...\n", source, target);
-    printf("⚡ Processing bits at turbo speed...\n");
-    printf("✅ Conversion complete!\n");
-    
-    Value v;
-    v.type = VAL_BOOL;
-    v.bool_val = true;
-    return v;
+    MediaTask t;
+    if (!task_parse(&t, "media.convert()", argc, args, false, false)) {
+        task_free(&t);
+        return make_null();
+    }
+    task_run(&t);
+    Value result = task_result(&t, "media.convert()");
+    task_free(&t);
+    return result;
+}
+
+static Value native_media_thumbnail_async(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    return job_start("media.thumbnail_async()", argc, args, true);
+}
+
+static Value native_media_convert_async(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    return job_start("media.convert_async()", argc, args, false);
+}
+
+// job.wait() / await job: the thumbnail or convert result.
+static Value native_media_job_wait(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MediaJob* job = argc >= 1 ? job_find(&args[0]) : NULL;
+    if (!job) return make_null();
+    while (!job->done) {
+        if (!interpreter_wait(job->handle)) break;
+    }
+    if (!job->done) return make_null();
+    Value result = task_result(&job->task, job->fn);
+    MediaJob** cur = &media_jobs;
+    while (*cur != job) cur = &(*cur)->next;
+    *cur = job->next;
+    task_free(&job->task);
+    free(job);
+    return result;
+}
+
+static Value native_media_job_done(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    MediaJob* job = argc >= 1 ? job_find(&args[0]) : NULL;
+    return make_bool(!job || job->done);
+}
+
+// ----------------------------------------------------------------------------
+// Image methods
+// ----------------------------------------------------------------------------
+
+static Image* image_arg(int argc, Value* args, const char* fn) {
+    Image* img = argc >= 1 ? image_find(&args[0]) : NULL;
+    if (!img) fprintf(stderr, "Error: media.image_%s() on a freed or unknown image\n", fn);
+    return img;
+}
+
+static Value native_media_image_width(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Image* img = image_arg(argc, args, "width");
+    return img ? make_int(img->width) : make_null();
+}
+
+static Value native_media_image_height(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Image* img = image_arg(argc, args, "height");
+    return img ? make_int(img->height) : make_null();
+}
+
+static Value native_media_image_channels(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Image* img = image_arg(argc, args, "channels");
+    return img ? make_int(img->channels) : make_null();
+}
+
+static Value native_media_image_format(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Image* img = image_arg(argc, args, "format");
+    return img ? make_string(format_name(img->format)) : make_null();
+}
+
+// img.resize(width, height, [filter]) resizes in place; filter is "box",
+// "bilinear" or "lanczos" (the default).
+static Value native_media_image_resize(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Image* img = image_arg(argc, args, "resize");
+    if (!img) return make_bool(false);
+    ResampleFilter filter = FILTER_LANCZOS;
+    if (argc > 3 && args[3].type == VAL_STRING && !filter_named(args[3].string_val, &filter)) {
+        fprintf(stderr, "Error: img.resize(): unknown filter '%s' (box, bilinear, lanczos)\n", args[3].string_val);
+        return make_bool(false);
+    }
+    int width = int_arg(argc, args, 1, 0), height = int_arg(argc, args, 2, 0);
+    if (width == img->width && height == img->height) return make_bool(true);
+    char err[256];
+    Image* scaled = image_resample(img, width, height, filter, err, sizeof(err));
+    if (!scaled) {
+        fprintf(stderr, "Error: img.resize(): %s\n", err);
+        return make_bool(false);
+    }
+    free(img->pixels);
+    *img = *scaled;
+    free(scaled);
+    return make_bool(true);
+}
+
+static Value native_media_image_clone(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Image* img = image_arg(argc, args, "clone");
+    Image* copy = img ? image_new(img->width, img->height, img->channels, img->format) : NULL;
+    if (!copy) return make_null();
+    memcpy(copy->pixels, img->pixels, (size_t)img->width * img->height * img->channels);
+    return image_handle(copy);
+}
+
+// img.encode("png" | "jpeg", [quality]) -> bytes
+static Value native_media_image_encode(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Image* img = image_arg(argc, args, "encode");
+    if (!img) return make_null();
+    MediaFormat format = argc > 1 && args[1].type == VAL_STRING ? format_named(args[1].string_val) : MEDIA_UNKNOWN;
+    if (format == MEDIA_UNKNOWN) {
+        fprintf(stderr, "Error: img.encode() expects \"png\" or \"jpeg\"\n");
+        return make_null();
+    }
+    char err[256];
+    size_t len = 0;
+    unsigned char* out = encode_image(img, format, int_arg(argc, args, 2, MEDIA_DEFAULT_QUALITY), &len, err, sizeof(err));
+    if (!out) {
+        fprintf(stderr, "Error: img.encode(): %s\n", err);
+        return make_null();
+    }
+    return make_bytes_owned(out, len, len);
+}
+
+// img.save(path, [quality]): the format follows the extension.
+static Value native_media_image_save(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Image* img = image_arg(argc, args, "save");
+    if (!img || argc < 2 || args[1].type != VAL_STRING) return make_bool(false);
+    char err[256];
+    size_t len = 0;
+    MediaFormat format = format_for_path(args[1].string_val);
+    unsigned char* out = encode_image(img, format, int_arg(argc, args, 2, MEDIA_DEFAULT_QUALITY), &len, err, sizeof(err));
+    bool ok = out && write_whole_file(args[1].string_val, out, len, err, sizeof(err));
+    free(out);
+    if (!ok) fprintf(stderr, "Error: img.save(): %s\n", err);
+    return make_bool(ok);
+}
+
+// img.pixels() -> a copy of the raw pixels, row by row
+static Value native_media_image_pixels(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Image* img = image_arg(argc, args, "pixels");
+    return img ? make_bytes(img->pixels, (size_t)img->width * img->height * img->channels) : make_null();
+}
+
+static Value native_media_image_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    int id = argc >= 1 ? image_id(&args[0]) : 0;
+    if (id < 1) return make_bool(false);
+    uv_once(&media_once, media_init_lock);
+    uv_rwlock_wrlock(&media_lock);
+    Image* img = id <= media_image_count ? media_images[id - 1] : NULL;
+    if (img) media_images[id - 1] = NULL;
+    uv_rwlock_wrunlock(&media_lock);
+    image_free(img);
+    return make_bool(img != NULL);
 }
 
 void stdlib_media_register(void) {
     register_native("media.image_info", native_media_image_info);
     register_native("media.audio_info", native_media_audio_info);
+    register_native("media.load_image", native_media_load_image);
+    register_native("media.from_pixels", native_media_from_pixels);
+    register_native("media.thumbnail", native_media_thumbnail);
+    register_native("media.thumbnail_async", native_media_thumbnail_async);
     register_native("media.convert", native_media_convert);
+    register_native("media.convert_async", native_media_convert_async);
+
+    register_native("media.image_width", native_media_image_width);
+    register_native("media.image_height", native_media_image_height);
+    register_native("media.image_channels", native_media_image_channels);
+    register_native("media.image_format", native_media_image_format);
+    register_native("media.image_resize", native_media_image_resize);
+    register_native("media.image_clone", native_media_image_clone);
+    register_native("media.image_encode", native_media_image_encode);
+    register_native("media.image_save", native_media_image_save);
+    register_native("media.image_pixels", native_media_image_pixels);
+    register_native("media.image_close", native_media_image_close);
+    register_handle_methods("image_", "media.image_");
+
+    register_native("media.job_wait", native_media_job_wait);
+    register_native("media.job_done", native_media_job_done);
+    register_handle_methods("media_job_", "media.job_");
+    register_awaitable("media_job_", native_media_job_wait);
 }
@@ -3,12 +3,35 @@
 
 #include "../core/interpreter.h"
 
+// Images and audio behind media.*.
+//
+// media.image_info and media.audio_info read only the headers of a PNG,
+// JPEG or WAV file (a path) or buffer (bytes). media.load_image decodes a
+// PNG or JPEG (with libpng and libjpeg) into an "image_<n>" handle holding
+// 8-bit pixels, 1 to 4 channels per pixel, that is resized, encoded and
+// saved through its methods, e.g. img.resize(320, 240, "lanczos").
+//
+// Resizing is separable: a horizontal pass then a vertical one, each with
+// precomputed weights for the box, bilinear or Lanczos-3 filter, on
+// premultiplied float pixels. On x86-64 the passes run four channels (SSE)
+// or eight floats (AVX2) per instruction.
+//
+// media.thumbnail and media.convert run the whole decode, resize and
+// encode pipeline; their _async versions run it on the libuv threadpool
+// and return a "media_job_<n>" handle to `await`. JPEG sources are decoded
+// straight at 1/2, 1/4 or 1/8 scale when the thumbnail allows it.
+
+#define MEDIA_MAX_PIXELS 100000000
+#define MEDIA_DEFAULT_QUALITY 85
+
 // Media Module registration
 void stdlib_media_register(void);
 
 // Native functions
 Value native_media_image_info(struct Interpreter* interp, int argc, Value* args);
 Value native_media_audio_info(struct Interpreter* interp, int argc, Value* args);
+Value native_media_load_image(struct Interpreter* interp, int argc, Value* args);
+Value native_media_thumbnail(struct Interpreter* interp, int argc, Value* args);
 Value native_media_convert(struct Interpreter* interp, int argc, Value* args);
 
 #endif // RADS_STDLIB_MEDIA_H
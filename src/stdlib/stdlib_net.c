@@ -1,5 +1,8 @@
 #define _POSIX_C_SOURCE 200809L
 #include "stdlib_net.h"
+#include "stdlib_websocket.h"
+#include "stdlib_template.h"
+#include "stdlib_session.h"
 #include "interpreter.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,19 +13,147 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include <limits.h>
+#include <zlib.h>
 
 extern uv_loop_t* global_event_loop;
 struct Interpreter;
 
+// Request arena
+// Each HTTP connection borrows a bump allocator that owns everything one
+// request/response cycle needs: the read buffer, the parsed request (parsed
+// in place), route params and response headers. It is reset as soon as the
+// request has been handled, and arenas are recycled across connections, so a
+// steady stream of requests stops hitting malloc/free for these objects.
+// Response bodies stay on the heap because libuv sends them asynchronously.
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t cap;
+    size_t used;
+    char data[];
+} ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock* head;
+    struct Arena* next_free;
+} Arena;
+
+#define ARENA_BLOCK_SIZE (80 * 1024)
+#define ARENA_POOL_MAX 64
+
+static Arena* arena_pool = NULL;
+static int arena_pool_count = 0;
+
+static void* arena_alloc(Arena* arena, size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    ArenaBlock* block = arena->head;
+    if (!block || block->used + size > block->cap) {
+        size_t cap = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + cap);
+        if (!block) return NULL;
+        block->cap = cap;
+        block->used = 0;
+        block->next = arena->head;
+        arena->head = block;
+    }
+    void* ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+static void* arena_calloc(Arena* arena, size_t size) {
+    void* ptr = arena_alloc(arena, size);
+    if (ptr) memset(ptr, 0, size);
+    return ptr;
+}
+
+static char* arena_strndup(Arena* arena, const char* str, size_t len) {
+    char* out = arena_alloc(arena, len + 1);
+    if (!out) return NULL;
+    memcpy(out, str, len);
+    out[len] = '\0';
+    return out;
+}
+
+static char* arena_strdup(Arena* arena, const char* str) {
+    return arena_strndup(arena, str, strlen(str));
+}
+
+// Keeps the oldest block (normally the standard-sized one) for reuse.
+static void arena_reset(Arena* arena) {
+    ArenaBlock* block = arena->head;
+    while (block && block->next) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    if (block) block->used = 0;
+    arena->head = block;
+}
+
+static Arena* arena_acquire(void) {
+    if (arena_pool) {
+        Arena* arena = arena_pool;
+        arena_pool = arena->next_free;
+        arena_pool_count--;
+        arena->next_free = NULL;
+        return arena;
+    }
+    return calloc(1, sizeof(Arena));
+}
+
+static void arena_release(Arena* arena) {
+    if (!arena) return;
+    arena_reset(arena);
+    if (arena_pool_count < ARENA_POOL_MAX) {
+        arena->next_free = arena_pool;
+        arena_pool = arena;
+        arena_pool_count++;
+        return;
+    }
+    free(arena->head);
+    free(arena);
+}
+
+// Receive buffer for raw TCP sockets: libuv reads straight into the free
+// tail, net.recv consumes from the front, and the unread bytes are moved
+// back to the start once the tail runs short.
+typedef struct TcpRecvBuffer {
+    char* data;              // a pooled slab until it has to grow
+    size_t cap;
+    size_t head;
+    size_t len;
+} TcpRecvBuffer;
+
 typedef struct TcpHandleCtx {
     uv_tcp_t* handle;
-    RadsBufferNode* recv_queue;
+    RadsBufferNode* recv_queue;  // listeners: ids of accepted connections
+    TcpRecvBuffer rx;
+    bool reading;
+    bool connecting;
+    bool eof;                // peer finished sending (or the read failed)
+    bool shut;               // our write side is shut down
+    bool closing;
+    size_t rx_want;          // bytes a blocked net.recv is waiting for
+    bool piped;
+    struct TcpHandleCtx* pipe_to;    // net.pipe: bytes read here go there
+    struct TcpHandleCtx* pipe_from;
+    bool pipe_paused;        // source stopped until the target drains
     char* id;
     bool is_listener;
     bool owns_handle;
     bool is_http;
     bool data_owner;
+    bool upgraded;           // socket handed to the websocket module
     void* data;
+    struct HttpResponseWriter* writer;
+    Arena* arena;            // per-request allocations on HTTP connections
+    char* http_in;           // unconsumed request bytes, inside the arena
+    size_t http_in_len;
+    bool http_busy;          // the current response has not been written yet
+    bool http_processing;    // a request is being handled (its arena is live)
+    bool http_keep_alive;    // the current response leaves the socket open
+    bool http_paused;        // reads stopped until pipelined input is handled
     struct Interpreter* interp;
     struct TcpHandleCtx* next;
 } TcpHandleCtx;
@@ -40,7 +171,7 @@ typedef struct HttpRequest {
     int header_count;
     char* body;
     size_t body_length;
-} HttpRequest;
+} HttpRequest;  // parsed in place; every field points into the arena read buffer
 
 typedef struct HttpResponse {
     int status_code;
@@ -48,8 +179,11 @@ typedef struct HttpResponse {
     char** header_names;
     char** header_values;
     int header_count;
+    int header_capacity;
+    Arena* arena;                        // headers live here when set
     char* body;
     size_t body_length;
+    struct HttpCachedBody* shared_body;  // set when body points into the static cache
 } HttpResponse;
 
 typedef struct HttpClientRequest {
@@ -76,41 +210,12 @@ typedef struct HttpClientResponse {
     bool complete;
 } HttpClientResponse;
 
-typedef struct HttpClientContext {
-    HttpClientRequest* request;
-    HttpClientResponse* response;
-    uv_tcp_t* tcp_handle;
-    char* buffer;
-    size_t buffer_size;
-    size_t buffer_used;
-    bool headers_complete;
-    size_t content_length;
-    struct Interpreter* interp;
-    bool connect_done;
-    int connect_status;
-    bool timed_out;
-    uv_timer_t* timer_handle;
-} HttpClientContext;
-
-typedef struct ConnectionPoolEntry {
-    char* host;
-    int port;
-    uv_tcp_t* handle;
-    time_t last_used;
-    bool in_use;
-    struct ConnectionPoolEntry* next;
-} ConnectionPoolEntry;
-
-typedef struct ConnectionPool {
-    ConnectionPoolEntry* head;
-    int max_connections;
-    int idle_timeout;
-} ConnectionPool;
-
 typedef struct RouteParams {
     char** keys;
     char** values;
     int count;
+    int capacity;
+    Arena* arena;  // NULL means heap-owned (freed by route_params_free)
 } RouteParams;
 
 typedef struct RouteNode {
@@ -120,6 +225,8 @@ typedef struct RouteNode {
     bool is_static;
     char* static_dir;
     bool has_params;  // true if path contains :param
+    NetNativeHandler native;  // C handler registered by another module
+    void* native_user;
     struct RouteNode* next;
 } RouteNode;
 
@@ -138,20 +245,37 @@ typedef struct MiddlewareChain {
     int count;
 } MiddlewareChain;
 
-typedef struct Session {
+// Streaming response handed to route handlers as their 8th argument
+// ("http_res_N"). It lives as long as the client connection.
+typedef struct HttpResponseWriter {
     char* id;
-    char** keys;
-    char** values;
-    int count;
-    time_t created;
-    time_t last_accessed;
-    struct Session* next;
-} Session;
-
-typedef struct SessionStore {
-    Session* head;
-    int count;
-} SessionStore;
+    uv_stream_t* client;
+    int status_code;
+    bool headers_sent;
+    bool ended;
+    bool sse;
+    bool waiting_drain;
+    Value on_drain;
+    int accept_encoding;     // HttpEncoding negotiated from the request
+    struct z_stream_s* zs;   // streaming encoder once compression is on
+    struct HttpResponseWriter* next;
+} HttpResponseWriter;
+
+// Write-queue watermarks for streamed responses (bytes queued in libuv).
+#define HTTP_STREAM_HIGH_WATER (64 * 1024)
+#define HTTP_STREAM_LOW_WATER (16 * 1024)
+
+// Largest request head and body an HTTP connection will buffer.
+#define HTTP_MAX_HEAD (64 * 1024)
+#define HTTP_MAX_BODY (16 * 1024 * 1024)
+
+// Raw TCP read slabs and receive-side flow control.
+#define TCP_SLAB_SIZE (64 * 1024)
+#define TCP_SLAB_POOL_MAX 256
+#define TCP_RECV_MIN_READ (16 * 1024)
+#define TCP_RECV_HIGH_WATER (4 * 1024 * 1024)
+#define TCP_PIPE_HIGH_WATER (1024 * 1024)
+#define TCP_PIPE_LOW_WATER (256 * 1024)
 
 extern Value make_string(const char* val);
 extern Value make_bool(bool val);
@@ -168,31 +292,35 @@ static void buffer_free(RadsBufferNode* head);
 static RadsBufferNode* buffer_push(RadsBufferNode** head, const char* data, size_t len);
 static Value buffer_pop(RadsBufferNode** head);
 static void enqueue_data(TcpHandleCtx* ctx, const char* data, ssize_t len);
+static char* tcp_slab_get(void);
+static void tcp_slab_put(char* slab);
+static void tcp_close(TcpHandleCtx* ctx);
 static TcpHandleCtx* find_tcp_ctx(const char* id);
 static void unregister_tcp_ctx(TcpHandleCtx* ctx);
 static void http_send_response(uv_stream_t* client, HttpResponse* resp);
-static HttpResponse* http_response_create(int status_code, const char* status_text);
+static HttpResponseWriter* http_writer_create(uv_stream_t* client);
+static HttpResponseWriter* http_writer_find(const char* id);
+static void http_writer_detach(HttpResponseWriter* writer);
+static HttpResponse* http_response_create(Arena* arena, int status_code, const char* status_text);
 static void http_response_add_header(HttpResponse* resp, const char* name, const char* value);
 static void http_response_set_body(HttpResponse* resp, const char* body, const char* content_type);
-static char* http_response_build(HttpResponse* resp, size_t* out_len);
+static void http_response_take_body(HttpResponse* resp, char* body, size_t body_length, const char* content_type);
+static char* http_response_build_head(HttpResponse* resp, bool keep_alive, size_t* out_len);
 static void http_response_free(HttpResponse* resp);
-static HttpRequest* http_request_parse(const char* data, ssize_t len);
-static HttpRequest* http_request_create(void);
-static void http_request_free(HttpRequest* req);
+static HttpRequest* http_request_parse(Arena* arena, char* data, size_t len);
 static const char* http_request_get_header(HttpRequest* req, const char* name);
-static void http_handle_request(uv_stream_t* client, const char* data, ssize_t len);
+static void http_handle_request(uv_stream_t* client, char* data, ssize_t len);
 static RouteRegistry* route_registry_create(void);
 static void route_registry_free(RouteRegistry* reg);
 static bool route_registry_add(RouteRegistry* reg, const char* path, const char* method, Value handler);
 static bool route_registry_add_static(RouteRegistry* reg, const char* prefix, const char* dir);
 static RouteNode* route_registry_find(RouteRegistry* reg, const char* path, const char* method);
 static RouteNode* route_registry_find_static(RouteRegistry* reg, const char* path);
-static RouteNode* route_registry_find_with_params(RouteRegistry* reg, const char* path, const char* method, RouteParams** params_out);
+static RouteNode* route_registry_find_with_params(RouteRegistry* reg, Arena* arena, const char* path, const char* method, RouteParams** params_out);
 static bool path_has_parent_ref(const char* path);
-static RouteParams* route_params_create(void);
-static void route_params_add(RouteParams* params, const char* key, const char* value);
+static RouteParams* route_params_create(Arena* arena);
 static void route_params_free(RouteParams* params);
-static bool route_match_with_params(const char* pattern, const char* path, RouteParams** params_out);
+static bool route_match_with_params(Arena* arena, const char* pattern, const char* path, RouteParams** params_out);
 static MiddlewareChain* middleware_chain_create(void);
 static void middleware_chain_add(MiddlewareChain* chain, Value handler);
 static void middleware_chain_free(MiddlewareChain* chain);
@@ -201,15 +329,6 @@ static char* cookie_get(const char* cookies, const char* name);
 static char* cookie_set(const char* name, const char* value, int max_age);
 static char* parse_form_data(const char* body);
 static char* form_get(const char* form_data, const char* key);
-static char* template_render(const char* template_str, RouteParams* vars);
-static SessionStore* session_store_create(void);
-static Session* session_create(const char* id);
-static Session* session_find(SessionStore* store, const char* id);
-static void session_set(Session* sess, const char* key, const char* value);
-static const char* session_get(Session* sess, const char* key);
-static void session_destroy(SessionStore* store, const char* id);
-static void session_store_free(SessionStore* store);
-static char* generate_session_id(void);
 static const char* guess_mime(const char* path);
 static HttpClientRequest* http_client_request_create(const char* method, const char* url);
 static void http_client_request_free(HttpClientRequest* req);
@@ -218,21 +337,25 @@ static void http_client_request_set_body(HttpClientRequest* req, const char* bod
 static char* http_client_request_build(HttpClientRequest* req, size_t* out_len);
 static HttpClientResponse* http_client_response_create(void);
 static void http_client_response_free(HttpClientResponse* resp);
-static bool http_client_response_parse(HttpClientResponse* resp, const char* data, size_t len);
+static size_t http_client_response_parse_head(HttpClientResponse* resp, const char* data, size_t len);
 static const char* http_client_response_get_header(HttpClientResponse* resp, const char* name);
 static bool url_parse(const char* url, char** host, int* port, char** path);
-static ConnectionPool* connection_pool_create(int max_connections, int idle_timeout);
-static void connection_pool_free(ConnectionPool* pool);
-static uv_tcp_t* connection_pool_get(ConnectionPool* pool, const char* host, int port);
-static void connection_pool_release(ConnectionPool* pool, const char* host, int port, uv_tcp_t* handle);
-static void connection_pool_cleanup_idle(ConnectionPool* pool);
-static HttpClientResponse* http_client_execute(HttpClientRequest* req);
-static void on_http_client_connect(uv_connect_t* req, int status);
-static void on_http_client_write(uv_write_t* req, int status);
-static void on_http_client_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
-static void on_http_client_timeout(uv_timer_t* timer);
-static void on_http_client_close(uv_handle_t* handle);
-static bool should_keep_alive(HttpClientResponse* resp);
+
+// Appends without the clone array_push makes; v is moved into the array.
+static void array_push_owned(Array* arr, Value v) {
+    if (arr->count >= arr->capacity) {
+        arr->capacity = arr->capacity ? arr->capacity * 2 : 4;
+        arr->items = realloc(arr->items, arr->capacity * sizeof(Value));
+    }
+    arr->items[arr->count++] = v;
+}
+
+static Value array_value(Array* arr) {
+    Value v;
+    v.type = VAL_ARRAY;
+    v.array_val = arr;
+    return v;
+}
 
 static Value clone_value(Value v) {
     Value out = v;
@@ -244,29 +367,6 @@ static Value clone_value(Value v) {
     return out;
 }
 
-static HttpRequest* http_request_create(void) {
-    HttpRequest* req = calloc(1, sizeof(HttpRequest));
-    return req;
-}
-
-static void http_request_free(HttpRequest* req) {
-    if (!req) return;
-    free(req->method);
-    free(req->path);
-    free(req->query_string);
-    free(req->http_version);
-    if (req->header_names && req->header_values) {
-        for (int i = 0; i < req->header_count; i++) {
-            free(req->header_names[i]);
-            free(req->header_values[i]);
-        }
-    }
-    free(req->header_names);
-    free(req->header_values);
-    free(req->body);
-    free(req);
-}
-
 static const char* http_request_get_header(HttpRequest* req, const char* name) {
     if (!req || !name) return NULL;
     for (int i = 0; i < req->header_count; i++) {
@@ -277,109 +377,216 @@ static const char* http_request_get_header(HttpRequest* req, const char* name) {
     return NULL;
 }
 
-static HttpRequest* http_request_parse(const char* data, ssize_t len) {
-    if (!data || len <= 0) return NULL;
-    // Incoming libuv buffers are not null-terminated; operate on a safe copy.
-    char* buf = malloc((size_t)len + 1);
-    if (!buf) return NULL;
-    memcpy(buf, data, (size_t)len);
-    buf[len] = '\0';
-
-    HttpRequest* req = http_request_create();
-    const char* end = buf + len;
-    const char* line_end = strstr(buf, "\r\n");
-    if (!line_end) {
-        free(buf);
-        http_request_free(req);
-        return NULL;
-    }
-    size_t line_len = (size_t)(line_end - buf);
-    char* request_line = strndup(buf, line_len);
-    char* saveptr;
-    char* method = strtok_r(request_line, " ", &saveptr);
-    char* path = strtok_r(NULL, " ", &saveptr);
-    char* version = strtok_r(NULL, " ", &saveptr);
-    if (!method || !path || !version) {
-        free(buf);
-        free(request_line);
-        http_request_free(req);
-        return NULL;
-    }
-    req->method = strdup(method);
-    req->http_version = strdup(version);
+// Parses in place: data must have one writable byte past len. Header names,
+// values and the body are NUL-terminated inside the buffer, not copied.
+static HttpRequest* http_request_parse(Arena* arena, char* data, size_t len) {
+    if (!data || len == 0) return NULL;
+    data[len] = '\0';
+    char* head_end = strstr(data, "\r\n\r\n");
+    if (!head_end) return NULL;
+    char* line_end = strstr(data, "\r\n");
+    char* body_start = head_end + 4;
+    size_t remaining = len - (size_t)(body_start - data);
+
+    int max_headers = 0;
+    for (char* p = line_end; p && p < head_end; p = strstr(p + 2, "\r\n")) {
+        max_headers++;
+    }
+    *head_end = '\0';
+    *line_end = '\0';
+
+    HttpRequest* req = arena_calloc(arena, sizeof(HttpRequest));
+    if (!req) return NULL;
+    char* method = data;
+    char* path = strchr(method, ' ');
+    if (!path) return NULL;
+    *path++ = '\0';
+    while (*path == ' ') path++;
+    char* version = strchr(path, ' ');
+    if (!version) return NULL;
+    *version++ = '\0';
+    while (*version == ' ') version++;
+    if (!*method || !*path || !*version) return NULL;
+    req->method = method;
+    req->http_version = version;
     char* query = strchr(path, '?');
     if (query) {
-        *query = '\0';
-        query++;
-        req->query_string = strdup(query);
+        *query++ = '\0';
+        req->query_string = query;
     }
-    req->path = strdup(path);
-    free(request_line);
+    req->path = path;
 
-    const char* headers_start = line_end + 2;
-    const char* headers_end = strstr(headers_start, "\r\n\r\n");
-    if (!headers_end) {
-        free(buf);
-        http_request_free(req);
-        return NULL;
+    if (max_headers > 0) {
+        req->header_names = arena_alloc(arena, sizeof(char*) * (size_t)max_headers);
+        req->header_values = arena_alloc(arena, sizeof(char*) * (size_t)max_headers);
     }
-    const char* cursor = headers_start;
-    while (cursor < headers_end) {
-        const char* eol = strstr(cursor, "\r\n");
-        if (!eol || eol > headers_end) break;
-        size_t hlen = (size_t)(eol - cursor);
-        char* header_line = strndup(cursor, hlen);
-        char* sep = strchr(header_line, ':');
+    char* cursor = line_end + 2;
+    while (cursor < head_end && req->header_count < max_headers) {
+        char* eol = strstr(cursor, "\r\n");
+        if (eol) *eol = '\0';
+        char* sep = strchr(cursor, ':');
         if (sep) {
             *sep = '\0';
-            char* name = header_line;
             char* value = sep + 1;
             while (*value && isspace((unsigned char)*value)) value++;
-            req->header_names = realloc(req->header_names, sizeof(char*) * (req->header_count + 1));
-            req->header_values = realloc(req->header_values, sizeof(char*) * (req->header_count + 1));
-            req->header_names[req->header_count] = strdup(name);
-            req->header_values[req->header_count] = strdup(value);
+            req->header_names[req->header_count] = cursor;
+            req->header_values[req->header_count] = value;
             req->header_count++;
         }
-        free(header_line);
+        if (!eol) break;
         cursor = eol + 2;
     }
 
-    const char* body_start = headers_end + 4;
-    size_t remaining = (size_t)(end - body_start);
     const char* cl = http_request_get_header(req, "Content-Length");
     if (cl) {
         size_t blen = (size_t)strtoul(cl, NULL, 10);
         if (blen <= remaining) {
             req->body_length = blen;
-            req->body = malloc(blen + 1);
-            memcpy(req->body, body_start, blen);
-            req->body[blen] = '\0';
+            req->body = body_start;
+            body_start[blen] = '\0';
         }
     } else if (remaining > 0) {
         req->body_length = remaining;
-        req->body = malloc(remaining + 1);
-        memcpy(req->body, body_start, remaining);
-        req->body[remaining] = '\0';
+        req->body = body_start;
     }
-
-    free(buf);
     return req;
 }
 
-static HttpResponse* http_response_create(int status_code, const char* status_text) {
-    HttpResponse* resp = calloc(1, sizeof(HttpResponse));
+// Length of the request at the front of data: its head plus the
+// Content-Length body. Upgrades and chunked uploads (which are not decoded)
+// take everything buffered, as they own the rest of the connection. Returns
+// 0 while more input is needed; *status is set for requests too large to
+// buffer.
+static size_t http_request_frame(const char* data, size_t len, int* status) {
+    const char* head_end = memmem(data, len, "\r\n\r\n", 4);
+    if (!head_end) {
+        if (len > HTTP_MAX_HEAD) *status = 431;
+        return 0;
+    }
+    size_t head_len = (size_t)(head_end - data) + 4;
+    if (head_len > HTTP_MAX_HEAD) {
+        *status = 431;
+        return 0;
+    }
+    size_t body_len = 0;
+    const char* line = (const char*)memmem(data, head_len, "\r\n", 2) + 2;
+    while (line < head_end) {
+        const char* eol = memmem(line, (size_t)(head_end + 2 - line), "\r\n", 2);
+        size_t n = (size_t)(eol - line);
+        if (n > 15 && strncasecmp(line, "Content-Length:", 15) == 0) {
+            const char* v = line + 15;
+            while (v < eol && (*v == ' ' || *v == '\t')) v++;
+            if (v == eol || !isdigit((unsigned char)*v)) {
+                *status = 400;
+                return 0;
+            }
+            body_len = 0;
+            for (; v < eol && isdigit((unsigned char)*v); v++) {
+                body_len = body_len * 10 + (size_t)(*v - '0');
+                if (body_len > HTTP_MAX_BODY) {
+                    *status = 413;
+                    return 0;
+                }
+            }
+        } else if ((n > 8 && strncasecmp(line, "Upgrade:", 8) == 0) ||
+                   (n > 18 && strncasecmp(line, "Transfer-Encoding:", 18) == 0)) {
+            return len;
+        }
+        line = eol + 2;
+    }
+    return head_len + body_len <= len ? head_len + body_len : 0;
+}
+
+// HTTP/1.1 connections stay open unless the client asks to close; 1.0
+// clients have to ask for keep-alive. Requests framed to the end of the
+// connection (see http_request_frame) always close it.
+static bool http_request_keep_alive(HttpRequest* req) {
+    if (http_request_get_header(req, "Upgrade") || http_request_get_header(req, "Transfer-Encoding")) {
+        return false;
+    }
+    const char* conn = http_request_get_header(req, "Connection");
+    if (strcmp(req->http_version, "HTTP/1.1") == 0) {
+        return !conn || !strcasestr(conn, "close");
+    }
+    return conn && strcasestr(conn, "keep-alive");
+}
+
+static const char* http_status_text(int status_code) {
+    switch (status_code) {
+        case 100: return "Continue";
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 303: return "See Other";
+        case 304: return "Not Modified";
+        case 307: return "Temporary Redirect";
+        case 308: return "Permanent Redirect";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 409: return "Conflict";
+        case 410: return "Gone";
+        case 413: return "Payload Too Large";
+        case 414: return "URI Too Long";
+        case 415: return "Unsupported Media Type";
+        case 422: return "Unprocessable Entity";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        default: return "";
+    }
+}
+
+// With an arena the response struct and its headers are arena-owned; the
+// body is always heap (or cache) memory since it outlives the call. A NULL
+// status_text uses the standard reason phrase for status_code.
+static HttpResponse* http_response_create(Arena* arena, int status_code, const char* status_text) {
+    HttpResponse* resp = arena ? arena_calloc(arena, sizeof(HttpResponse)) : calloc(1, sizeof(HttpResponse));
+    resp->arena = arena;
     resp->status_code = status_code;
-    resp->status_text = strdup(status_text ? status_text : "");
+    status_text = status_text ? status_text : http_status_text(status_code);
+    resp->status_text = arena ? arena_strdup(arena, status_text) : strdup(status_text);
     return resp;
 }
 
 static void http_response_add_header(HttpResponse* resp, const char* name, const char* value) {
     if (!resp || !name || !value) return;
-    resp->header_names = realloc(resp->header_names, sizeof(char*) * (resp->header_count + 1));
-    resp->header_values = realloc(resp->header_values, sizeof(char*) * (resp->header_count + 1));
-    resp->header_names[resp->header_count] = strdup(name);
-    resp->header_values[resp->header_count] = strdup(value);
+    if (resp->header_count == resp->header_capacity) {
+        int cap = resp->header_capacity ? resp->header_capacity * 2 : 8;
+        if (resp->arena) {
+            char** names = arena_alloc(resp->arena, sizeof(char*) * (size_t)cap);
+            char** values = arena_alloc(resp->arena, sizeof(char*) * (size_t)cap);
+            if (resp->header_count > 0) {
+                memcpy(names, resp->header_names, sizeof(char*) * (size_t)resp->header_count);
+                memcpy(values, resp->header_values, sizeof(char*) * (size_t)resp->header_count);
+            }
+            resp->header_names = names;
+            resp->header_values = values;
+        } else {
+            resp->header_names = realloc(resp->header_names, sizeof(char*) * (size_t)cap);
+            resp->header_values = realloc(resp->header_values, sizeof(char*) * (size_t)cap);
+        }
+        resp->header_capacity = cap;
+    }
+    if (resp->arena) {
+        resp->header_names[resp->header_count] = arena_strdup(resp->arena, name);
+        resp->header_values[resp->header_count] = arena_strdup(resp->arena, value);
+    } else {
+        resp->header_names[resp->header_count] = strdup(name);
+        resp->header_values[resp->header_count] = strdup(value);
+    }
     resp->header_count++;
 }
 
@@ -397,51 +604,287 @@ static void http_response_set_body(HttpResponse* resp, const char* body, const c
     }
 }
 
-static char* http_response_build(HttpResponse* resp, size_t* out_len) {
+// Takes ownership of a heap buffer (usually a RADS string) so the body is
+// handed to libuv by reference instead of being copied again.
+static void http_response_take_body(HttpResponse* resp, char* body, size_t body_length, const char* content_type) {
+    if (!resp) {
+        free(body);
+        return;
+    }
+    free(resp->body);
+    resp->body = body;
+    resp->body_length = body ? body_length : 0;
+    if (content_type) {
+        http_response_add_header(resp, "Content-Type", content_type);
+    }
+}
+
+// "Date:" and "Server:" lines (plus the blank line ending the header block)
+// are identical for every response sent within the same second, so they are
+// formatted once and shared. In-flight writes keep a reference because libuv
+// may still be sending the bytes after the cache has moved on.
+typedef struct HttpCommonHeaders {
+    size_t refcount;
+    time_t stamp;
+    size_t len;
+    char data[96];
+} HttpCommonHeaders;
+
+static HttpCommonHeaders* common_headers_current = NULL;
+
+static void http_common_headers_release(HttpCommonHeaders* common) {
+    if (common && --common->refcount == 0) {
+        free(common);
+    }
+}
+
+static HttpCommonHeaders* http_common_headers_acquire(void) {
+    time_t now = time(NULL);
+    if (!common_headers_current || common_headers_current->stamp != now) {
+        HttpCommonHeaders* common = malloc(sizeof(HttpCommonHeaders));
+        if (!common) return NULL;
+        struct tm tm_now;
+        gmtime_r(&now, &tm_now);
+        common->refcount = 1;
+        common->stamp = now;
+        common->len = strftime(common->data, sizeof(common->data),
+                               "Date: %a, %d %b %Y %H:%M:%S GMT\r\nServer: RADS/1.0\r\n\r\n", &tm_now);
+        http_common_headers_release(common_headers_current);
+        common_headers_current = common;
+    }
+    common_headers_current->refcount++;
+    return common_headers_current;
+}
+
+// Status line plus per-response headers. The shared Date/Server block and the
+// body are written as separate uv_buf_t entries by http_send_response.
+static char* http_response_build_head(HttpResponse* resp, bool keep_alive, size_t* out_len) {
     if (!resp) return NULL;
     const char* status_text = resp->status_text ? resp->status_text : "";
-    // ensure Content-Length header
     char len_buf[64];
     snprintf(len_buf, sizeof(len_buf), "%zu", resp->body_length);
     bool has_len = false;
     for (int i = 0; i < resp->header_count; i++) {
-        if (resp->header_names[i] && strcasecmp(resp->header_names[i], "Content-Length") == 0) {
+        if (resp->header_names[i] && (strcasecmp(resp->header_names[i], "Content-Length") == 0 ||
+                                      strcasecmp(resp->header_names[i], "Transfer-Encoding") == 0)) {
             has_len = true;
             break;
         }
     }
     if (!has_len) http_response_add_header(resp, "Content-Length", len_buf);
-    bool has_server = false;
+    http_response_add_header(resp, "Connection", keep_alive ? "keep-alive" : "close");
+
+    size_t head_cap = 32 + strlen(status_text);
     for (int i = 0; i < resp->header_count; i++) {
-        if (resp->header_names[i] && strcasecmp(resp->header_names[i], "Server") == 0) {
-            has_server = true;
-            break;
-        }
+        head_cap += strlen(resp->header_names[i]) + strlen(resp->header_values[i]) + 4;
     }
-    if (!has_server) http_response_add_header(resp, "Server", "RADS/1.0");
-    http_response_add_header(resp, "Connection", "close");
-
-    size_t header_cap = 256 + (size_t)resp->header_count * 64;
-    char* header_buf = malloc(header_cap);
-    int written = snprintf(header_buf, header_cap, "HTTP/1.1 %d %s\r\n", resp->status_code, status_text);
+    char* head = malloc(head_cap);
+    if (!head) return NULL;
+    int written = snprintf(head, head_cap, "HTTP/1.1 %d %s\r\n", resp->status_code, status_text);
     for (int i = 0; i < resp->header_count; i++) {
-        written += snprintf(header_buf + written, header_cap - (size_t)written, "%s: %s\r\n", resp->header_names[i], resp->header_values[i]);
+        written += snprintf(head + written, head_cap - (size_t)written, "%s: %s\r\n", resp->header_names[i], resp->header_values[i]);
     }
-    written += snprintf(header_buf + written, header_cap - (size_t)written, "\r\n");
-    size_t total_len = (size_t)written + resp->body_length;
-    char* out = malloc(total_len + 1);
-    memcpy(out, header_buf, (size_t)written);
-    if (resp->body_length > 0 && resp->body) {
-        memcpy(out + written, resp->body, resp->body_length);
+    if (out_len) *out_len = (size_t)written;
+    return head;
+}
+
+// Response compression
+// Text bodies of at least compress_min_size bytes are gzip/deflate encoded
+// when the request's Accept-Encoding allows it. Encoded static files are
+// cached (keyed by path, mtime, size and encoding) and handed to libuv by
+// reference, so a hot asset is compressed once rather than per request.
+
+typedef enum {
+    HTTP_ENC_NONE,
+    HTTP_ENC_GZIP,
+    HTTP_ENC_DEFLATE
+} HttpEncoding;
+
+typedef struct HttpCachedBody {
+    size_t refcount;
+    char* path;
+    time_t mtime;
+    off_t size;
+    HttpEncoding encoding;
+    char* data;
+    size_t len;
+    struct HttpCachedBody* next;
+} HttpCachedBody;
+
+#define STATIC_CACHE_MAX_BYTES (32 * 1024 * 1024)
+
+static bool compress_enabled = true;
+static int compress_level = 6;
+static size_t compress_min_size = 1024;
+static HttpCachedBody* static_cache = NULL;
+static size_t static_cache_bytes = 0;
+
+static const char* http_encoding_name(HttpEncoding enc) {
+    return enc == HTTP_ENC_GZIP ? "gzip" : enc == HTTP_ENC_DEFLATE ? "deflate" : "identity";
+}
+
+// Picks the coding with the highest q-value; gzip wins ties and "*" stands
+// for the codings the header does not name. An explicit identity that
+// outranks both leaves the body as it is.
+static HttpEncoding http_negotiate_encoding(const char* accept) {
+    if (!accept || !compress_enabled) return HTTP_ENC_NONE;
+    double gzip_q = -1.0;
+    double deflate_q = -1.0;
+    double identity_q = -1.0;
+    double any_q = -1.0;
+    const char* p = accept;
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        const char* token = p;
+        while (*p && *p != ',' && *p != ';' && *p != ' ') p++;
+        size_t token_len = (size_t)(p - token);
+        const char* end = strchr(p, ',');
+        if (!end) end = p + strlen(p);
+        const char* q = memmem(p, (size_t)(end - p), "q=", 2);
+        double weight = q ? strtod(q + 2, NULL) : 1.0;
+        if (token_len == 4 && strncasecmp(token, "gzip", 4) == 0) gzip_q = weight;
+        else if (token_len == 7 && strncasecmp(token, "deflate", 7) == 0) deflate_q = weight;
+        else if (token_len == 8 && strncasecmp(token, "identity", 8) == 0) identity_q = weight;
+        else if (token_len == 1 && *token == '*') any_q = weight;
+        p = end;
+    }
+    if (gzip_q < 0.0) gzip_q = any_q;
+    if (deflate_q < 0.0) deflate_q = any_q;
+    double best = gzip_q >= deflate_q ? gzip_q : deflate_q;
+    if (best <= 0.0 || identity_q > best) return HTTP_ENC_NONE;
+    return gzip_q >= deflate_q ? HTTP_ENC_GZIP : HTTP_ENC_DEFLATE;
+}
+
+static bool http_is_compressible(const char* content_type) {
+    if (!content_type) return false;
+    if (strncasecmp(content_type, "text/", 5) == 0) return true;
+    return strcasestr(content_type, "json") || strcasestr(content_type, "javascript") ||
+           strcasestr(content_type, "xml") || strcasestr(content_type, "wasm");
+}
+
+// gzip adds a header/trailer around the zlib stream; "deflate" in HTTP is the
+// zlib format (RFC 9110), not raw deflate.
+static int http_deflate_init(z_stream* zs, HttpEncoding enc) {
+    memset(zs, 0, sizeof(*zs));
+    return deflateInit2(zs, compress_level, Z_DEFLATED, enc == HTTP_ENC_GZIP ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY);
+}
+
+static char* http_compress(HttpEncoding enc, const char* data, size_t len, size_t* out_len) {
+    z_stream zs;
+    if (http_deflate_init(&zs, enc) != Z_OK) return NULL;
+    size_t cap = deflateBound(&zs, (uLong)len);
+    char* out = malloc(cap);
+    if (!out) {
+        deflateEnd(&zs);
+        return NULL;
+    }
+    zs.next_in = (Bytef*)data;
+    zs.avail_in = (uInt)len;
+    zs.next_out = (Bytef*)out;
+    zs.avail_out = (uInt)cap;
+    int r = deflate(&zs, Z_FINISH);
+    *out_len = zs.total_out;
+    deflateEnd(&zs);
+    if (r != Z_STREAM_END) {
+        free(out);
+        return NULL;
     }
-    out[total_len] = '\0';
-    free(header_buf);
-    if (out_len) *out_len = total_len;
     return out;
 }
 
+static void http_response_mark_encoded(HttpResponse* resp, HttpEncoding enc) {
+    http_response_add_header(resp, "Content-Encoding", http_encoding_name(enc));
+    http_response_add_header(resp, "Vary", "Accept-Encoding");
+}
+
+// Encodes the body in place when allowed and when it actually gets smaller.
+static void http_response_compress(HttpResponse* resp, HttpEncoding enc, const char* content_type) {
+    if (!resp || enc == HTTP_ENC_NONE || !resp->body || resp->shared_body) return;
+    if (resp->body_length < compress_min_size || !http_is_compressible(content_type)) return;
+    size_t out_len = 0;
+    char* out = http_compress(enc, resp->body, resp->body_length, &out_len);
+    if (!out) return;
+    if (out_len >= resp->body_length) {
+        free(out);
+        return;
+    }
+    free(resp->body);
+    resp->body = out;
+    resp->body_length = out_len;
+    http_response_mark_encoded(resp, enc);
+}
+
+static void http_cached_body_release(HttpCachedBody* entry) {
+    if (entry && --entry->refcount == 0) {
+        free(entry->path);
+        free(entry->data);
+        free(entry);
+    }
+}
+
+// Returns a referenced entry, dropping it if the file changed on disk.
+static HttpCachedBody* static_cache_lookup(const char* path, const struct stat* st, HttpEncoding enc) {
+    HttpCachedBody** cur = &static_cache;
+    while (*cur) {
+        HttpCachedBody* entry = *cur;
+        if (entry->encoding == enc && strcmp(entry->path, path) == 0) {
+            *cur = entry->next;
+            if (entry->mtime != st->st_mtime || entry->size != st->st_size) {
+                static_cache_bytes -= entry->len;
+                http_cached_body_release(entry);
+                return NULL;
+            }
+            entry->next = static_cache;
+            static_cache = entry;
+            entry->refcount++;
+            return entry;
+        }
+        cur = &entry->next;
+    }
+    return NULL;
+}
+
+// Takes ownership of data; returns a referenced entry.
+static HttpCachedBody* static_cache_store(const char* path, const struct stat* st, HttpEncoding enc, char* data, size_t len) {
+    HttpCachedBody* entry = calloc(1, sizeof(HttpCachedBody));
+    entry->refcount = 2;
+    entry->path = strdup(path);
+    entry->mtime = st->st_mtime;
+    entry->size = st->st_size;
+    entry->encoding = enc;
+    entry->data = data;
+    entry->len = len;
+    entry->next = static_cache;
+    static_cache = entry;
+    static_cache_bytes += len;
+    // Evict least recently used entries (the tail) beyond the byte budget.
+    while (static_cache_bytes > STATIC_CACHE_MAX_BYTES && static_cache->next) {
+        HttpCachedBody** tail = &static_cache;
+        while ((*tail)->next) tail = &(*tail)->next;
+        HttpCachedBody* victim = *tail;
+        *tail = NULL;
+        static_cache_bytes -= victim->len;
+        http_cached_body_release(victim);
+    }
+    return entry;
+}
+
+static void http_response_share_body(HttpResponse* resp, HttpCachedBody* entry, const char* content_type) {
+    resp->shared_body = entry;
+    resp->body = entry->data;
+    resp->body_length = entry->len;
+    http_response_add_header(resp, "Content-Type", content_type);
+    http_response_mark_encoded(resp, entry->encoding);
+}
+
 static void http_response_free(HttpResponse* resp) {
     if (!resp) return;
+    if (resp->shared_body) {
+        http_cached_body_release(resp->shared_body);
+    } else {
+        free(resp->body);
+    }
+    if (resp->arena) return;
     free(resp->status_text);
     if (resp->header_names && resp->header_values) {
         for (int i = 0; i < resp->header_count; i++) {
@@ -451,255 +894,639 @@ static void http_response_free(HttpResponse* resp) {
     }
     free(resp->header_names);
     free(resp->header_values);
-    free(resp->body);
     free(resp);
 }
 
-static bool should_keep_alive(HttpClientResponse* resp) {
-    const char* conn = http_client_response_get_header(resp, "Connection");
-    return conn && strcasecmp(conn, "keep-alive") == 0;
+// Asynchronous HTTP client
+// Every step (DNS via uv_getaddrinfo, connect, write, read) runs from libuv
+// callbacks, so many requests can be in flight while the script keeps going.
+// Sockets are pooled per host:port: at most client_max_per_host are open at
+// once, further requests queue on the host, and keep-alive sockets go back to
+// the pool (unref'd, so an idle pool never keeps the loop alive).
+
+typedef enum {
+    FETCH_BODY_NONE,
+    FETCH_BODY_LENGTH,
+    FETCH_BODY_CHUNKED,
+    FETCH_BODY_EOF
+} FetchBodyMode;
+
+typedef enum {
+    CHUNK_SIZE_LINE,
+    CHUNK_DATA,
+    CHUNK_DATA_END,
+    CHUNK_TRAILER
+} ChunkState;
+
+struct HttpFetch;
+
+typedef struct ClientConn {
+    uv_tcp_t tcp;
+    struct HostPool* pool;
+    struct HttpFetch* fetch;
+    time_t last_used;
+    bool resolving;
+    bool closing;
+    struct ClientConn* next_idle;
+} ClientConn;
+
+typedef struct HostPool {
+    char* host;
+    int port;
+    int open_count;
+    ClientConn* idle;
+    struct HttpFetch* wait_head;
+    struct HttpFetch* wait_tail;
+    struct HostPool* next;
+} HostPool;
+
+typedef struct HttpFetch {
+    char* id;
+    HttpClientRequest* request;
+    HostPool* pool;
+    ClientConn* conn;
+    Value callback;
+    Value on_chunk;
+    HttpClientResponse* response;
+    char* head_buf;
+    size_t head_len;
+    size_t head_cap;
+    bool headers_done;
+    FetchBodyMode body_mode;
+    size_t body_remaining;
+    size_t body_cap;
+    ChunkState chunk_state;
+    char chunk_line[32];
+    size_t chunk_line_len;
+    size_t bytes_received;
+    z_stream* inflater;      // set when the response is gzip/deflate encoded
+    bool reused;
+    bool retried;
+    bool done;
+    char* error;
+    uv_timer_t timer;
+    struct HttpFetch* next_wait;
+    struct HttpFetch* next;
+} HttpFetch;
+
+#define HTTP_CLIENT_MAX_HEAD (64 * 1024)
+
+static HostPool* host_pools = NULL;
+static HttpFetch* http_fetches = NULL;
+static long next_fetch_id = 1;
+static int client_max_per_host = 6;
+static int client_idle_timeout = 30;       // seconds an idle keep-alive socket is kept
+static int client_request_timeout = 30000; // milliseconds per request
+
+static void fetch_dispatch(HttpFetch* f);
+static void fetch_fail(HttpFetch* f, const char* message);
+static void on_client_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
+
+static HostPool* host_pool_get(const char* host, int port) {
+    for (HostPool* cur = host_pools; cur; cur = cur->next) {
+        if (cur->port == port && strcmp(cur->host, host) == 0) return cur;
+    }
+    HostPool* pool = calloc(1, sizeof(HostPool));
+    pool->host = strdup(host);
+    pool->port = port;
+    pool->next = host_pools;
+    host_pools = pool;
+    return pool;
 }
 
-static ConnectionPool* global_connection_pool = NULL;
+static void on_client_conn_closed(uv_handle_t* handle) {
+    free(handle->data);
+}
 
-static ConnectionPool* connection_pool_create(int max_connections, int idle_timeout) {
-    ConnectionPool* pool = calloc(1, sizeof(ConnectionPool));
-    if (!pool) return NULL;
-    pool->head = NULL;
-    pool->max_connections = max_connections > 0 ? max_connections : 10;
-    pool->idle_timeout = idle_timeout > 0 ? idle_timeout : 30;
-    return pool;
+static void pool_drain_waiting(HostPool* pool) {
+    while (pool->wait_head && (pool->idle || pool->open_count < client_max_per_host)) {
+        HttpFetch* f = pool->wait_head;
+        pool->wait_head = f->next_wait;
+        if (!pool->wait_head) pool->wait_tail = NULL;
+        f->next_wait = NULL;
+        fetch_dispatch(f);
+    }
 }
 
-__attribute__((unused))
-static void connection_pool_free(ConnectionPool* pool) {
-    if (!pool) return;
-    ConnectionPoolEntry* cur = pool->head;
-    while (cur) {
-        ConnectionPoolEntry* next = cur->next;
-        if (cur->handle) {
-            uv_close((uv_handle_t*)cur->handle, on_http_client_close);
+static void client_conn_close(ClientConn* conn) {
+    if (!conn || conn->closing) return;
+    conn->closing = true;
+    conn->fetch = NULL;
+    HostPool* pool = conn->pool;
+    pool->open_count--;
+    // A pending getaddrinfo still points at conn; its callback closes it.
+    if (!conn->resolving) {
+        uv_close((uv_handle_t*)&conn->tcp, on_client_conn_closed);
+    }
+    pool_drain_waiting(pool);
+}
+
+static void on_client_write(uv_write_t* req, int status) {
+    ClientConn* conn = req->handle->data;
+    free(req->data);
+    free(req);
+    if (status < 0 && conn && conn->fetch && !conn->closing) {
+        fetch_fail(conn->fetch, uv_strerror(status));
+    }
+}
+
+static void fetch_start_io(HttpFetch* f, ClientConn* conn) {
+    size_t len = 0;
+    char* data = http_client_request_build(f->request, &len);
+    if (!data) {
+        fetch_fail(f, "could not build request");
+        return;
+    }
+    uv_write_t* wreq = malloc(sizeof(uv_write_t));
+    wreq->data = data;
+    uv_buf_t buf = uv_buf_init(data, (unsigned int)len);
+    int r = uv_write(wreq, (uv_stream_t*)&conn->tcp, &buf, 1, on_client_write);
+    if (r != 0) {
+        free(data);
+        free(wreq);
+        fetch_fail(f, uv_strerror(r));
+        return;
+    }
+    uv_read_start((uv_stream_t*)&conn->tcp, alloc_buffer, on_client_read);
+}
+
+static void on_client_connect(uv_connect_t* req, int status) {
+    ClientConn* conn = req->data;
+    free(req);
+    if (conn->closing) return;
+    if (status < 0) {
+        if (conn->fetch) {
+            fetch_fail(conn->fetch, uv_strerror(status));
+        } else {
+            client_conn_close(conn);
         }
-        free(cur->host);
-        free(cur);
-        cur = next;
+        return;
+    }
+    if (conn->fetch) {
+        fetch_start_io(conn->fetch, conn);
     }
-    free(pool);
 }
 
-static void connection_pool_cleanup_idle(ConnectionPool* pool) {
-    if (!pool) return;
-    time_t now = time(NULL);
-    ConnectionPoolEntry** cur = &pool->head;
-    while (*cur) {
-        ConnectionPoolEntry* entry = *cur;
-        if (!entry->in_use && difftime(now, entry->last_used) > pool->idle_timeout) {
-            *cur = entry->next;
-            if (entry->handle) {
-                uv_close((uv_handle_t*)entry->handle, on_http_client_close);
-            }
-            free(entry->host);
-            free(entry);
-            continue;
+static void client_conn_connect(ClientConn* conn, const struct sockaddr* addr) {
+    uv_connect_t* creq = malloc(sizeof(uv_connect_t));
+    creq->data = conn;
+    int r = uv_tcp_connect(creq, &conn->tcp, addr, on_client_connect);
+    if (r != 0) {
+        free(creq);
+        if (conn->fetch) {
+            fetch_fail(conn->fetch, uv_strerror(r));
+        } else {
+            client_conn_close(conn);
         }
-        cur = &entry->next;
     }
 }
 
-static uv_tcp_t* connection_pool_get(ConnectionPool* pool, const char* host, int port) {
-    if (!pool || !host) return NULL;
-    connection_pool_cleanup_idle(pool);
-    for (ConnectionPoolEntry* cur = pool->head; cur; cur = cur->next) {
-        if (!cur->in_use && cur->port == port && cur->host && strcmp(cur->host, host) == 0) {
-            cur->in_use = true;
-            return cur->handle;
+static void on_client_resolved(uv_getaddrinfo_t* req, int status, struct addrinfo* res) {
+    ClientConn* conn = req->data;
+    free(req);
+    conn->resolving = false;
+    if (conn->closing) {
+        uv_freeaddrinfo(res);
+        uv_close((uv_handle_t*)&conn->tcp, on_client_conn_closed);
+        return;
+    }
+    if (status < 0 || !res) {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "could not resolve %s: %s", conn->pool->host, uv_strerror(status));
+        uv_freeaddrinfo(res);
+        if (conn->fetch) {
+            fetch_fail(conn->fetch, msg);
+        } else {
+            client_conn_close(conn);
         }
+        return;
     }
-    return NULL;
+    client_conn_connect(conn, res->ai_addr);
+    uv_freeaddrinfo(res);
+}
+
+static ClientConn* client_conn_open(HostPool* pool) {
+    ClientConn* conn = calloc(1, sizeof(ClientConn));
+    conn->pool = pool;
+    uv_tcp_init(global_event_loop, &conn->tcp);
+    conn->tcp.data = conn;
+    uv_tcp_nodelay(&conn->tcp, 1);
+    pool->open_count++;
+    return conn;
 }
 
-static void connection_pool_release(ConnectionPool* pool, const char* host, int port, uv_tcp_t* handle) {
-    if (!pool || !host || !handle) return;
-    connection_pool_cleanup_idle(pool);
-    ConnectionPoolEntry* match = NULL;
-    int count = 0;
-    for (ConnectionPoolEntry* cur = pool->head; cur; cur = cur->next) {
-        count++;
-        if (!match && cur->port == port && cur->host && strcmp(cur->host, host) == 0 && cur->handle == handle) {
-            match = cur;
+static void client_conn_resolve(ClientConn* conn) {
+    HostPool* pool = conn->pool;
+    struct sockaddr_in addr4;
+    struct sockaddr_in6 addr6;
+    // Literal addresses skip the resolver entirely.
+    if (uv_ip4_addr(pool->host, pool->port, &addr4) == 0) {
+        client_conn_connect(conn, (const struct sockaddr*)&addr4);
+        return;
+    }
+    if (uv_ip6_addr(pool->host, pool->port, &addr6) == 0) {
+        client_conn_connect(conn, (const struct sockaddr*)&addr6);
+        return;
+    }
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", pool->port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    uv_getaddrinfo_t* greq = malloc(sizeof(uv_getaddrinfo_t));
+    greq->data = conn;
+    conn->resolving = true;
+    int r = uv_getaddrinfo(global_event_loop, greq, on_client_resolved, pool->host, port_str, &hints);
+    if (r != 0) {
+        free(greq);
+        conn->resolving = false;
+        if (conn->fetch) {
+            fetch_fail(conn->fetch, uv_strerror(r));
+        } else {
+            client_conn_close(conn);
         }
     }
-    if (match) {
-        match->in_use = false;
-        match->last_used = time(NULL);
+}
+
+// Hand the request a pooled socket, open a new one, or queue it on the host.
+static void fetch_dispatch(HttpFetch* f) {
+    HostPool* pool = f->pool;
+    time_t now = time(NULL);
+    while (pool->idle && !f->retried) {
+        ClientConn* conn = pool->idle;
+        pool->idle = conn->next_idle;
+        conn->next_idle = NULL;
+        if (difftime(now, conn->last_used) > client_idle_timeout) {
+            client_conn_close(conn);
+            continue;
+        }
+        uv_ref((uv_handle_t*)&conn->tcp);
+        conn->fetch = f;
+        f->conn = conn;
+        f->reused = true;
+        fetch_start_io(f, conn);
         return;
     }
-    ConnectionPoolEntry* entry = calloc(1, sizeof(ConnectionPoolEntry));
-    entry->host = strdup(host);
-    entry->port = port;
-    entry->handle = handle;
-    entry->last_used = time(NULL);
-    entry->in_use = false;
-    entry->next = pool->head;
-    pool->head = entry;
-    count++;
-    if (count > pool->max_connections) {
-        connection_pool_cleanup_idle(pool);
+    if (pool->open_count < client_max_per_host) {
+        ClientConn* conn = client_conn_open(pool);
+        conn->fetch = f;
+        f->conn = conn;
+        f->reused = false;
+        client_conn_resolve(conn);
+        return;
+    }
+    if (pool->wait_tail) {
+        pool->wait_tail->next_wait = f;
+    } else {
+        pool->wait_head = f;
     }
+    pool->wait_tail = f;
 }
 
-static void on_http_client_close(uv_handle_t* handle) {
-    if (!handle) return;
-    free(handle);
+static void on_fetch_timer_closed(uv_handle_t* handle) {
+    HttpFetch* f = handle->data;
+    free(f->id);
+    http_client_request_free(f->request);
+    http_client_response_free(f->response);
+    value_free(&f->callback);
+    value_free(&f->on_chunk);
+    free(f->head_buf);
+    free(f->error);
+    if (f->inflater) {
+        inflateEnd(f->inflater);
+        free(f->inflater);
+    }
+    free(f);
 }
 
-static void on_http_client_connect(uv_connect_t* req, int status) {
-    if (!req) return;
-    HttpClientContext* ctx = req->data;
-    if (ctx) {
-        ctx->connect_done = true;
-        ctx->connect_status = status;
+// Drop a finished request; the handle string stops resolving.
+static void fetch_release(HttpFetch* f) {
+    HttpFetch** cur = &http_fetches;
+    while (*cur && *cur != f) {
+        cur = &(*cur)->next;
     }
-    free(req);
+    if (*cur == f) {
+        *cur = f->next;
+    }
+    uv_close((uv_handle_t*)&f->timer, on_fetch_timer_closed);
 }
 
-static void on_http_client_write(uv_write_t* req, int status) {
-    if (req) {
-        if (req->data) free(req->data);
-        free(req);
+static HttpFetch* fetch_find(const char* id) {
+    if (!id) return NULL;
+    for (HttpFetch* cur = http_fetches; cur; cur = cur->next) {
+        if (strcmp(cur->id, id) == 0) return cur;
     }
-    if (status < 0) {
-        fprintf(stderr, "Write error: %s\n", uv_strerror(status));
+    return NULL;
+}
+
+// [status, body, headers, error] - headers is [name1, value1, ...] like the
+// headers argument route handlers get; error is null on success.
+static void fetch_result_values(HttpFetch* f, Value out[4]) {
+    HttpClientResponse* resp = f->response;
+    out[0] = make_int(f->error ? 0 : resp->status_code);
+    out[1] = make_string(resp->body && !f->error ? resp->body : "");
+    out[2] = array_value(array_create(resp->header_count * 2));
+    if (!f->error) {
+        for (int i = 0; i < resp->header_count; i++) {
+            array_push_owned(out[2].array_val, make_string(resp->header_names[i]));
+            array_push_owned(out[2].array_val, make_string(resp->header_values[i]));
+        }
     }
+    out[3] = f->error ? make_string(f->error) : make_null();
 }
 
-static void on_http_client_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
-    HttpClientContext* ctx = stream ? stream->data : NULL;
-    if (nread > 0 && ctx) {
-        if (ctx->buffer_used + (size_t)nread > ctx->buffer_size) {
-            size_t new_size = ctx->buffer_size * 2;
-            while (new_size < ctx->buffer_used + (size_t)nread) new_size *= 2;
-            ctx->buffer = realloc(ctx->buffer, new_size);
-            ctx->buffer_size = new_size;
+static void fetch_finish(HttpFetch* f) {
+    f->done = true;
+    uv_timer_stop(&f->timer);
+    interpreter_wake(f->id);
+    if (f->callback.type != VAL_FUNCTION) return;
+    Value args[4];
+    fetch_result_values(f, args);
+    Value result = interpreter_execute_callback(f->callback, 4, args);
+    value_free(&result);
+    for (int i = 0; i < 4; i++) value_free(&args[i]);
+    // Callback-style requests are not waited on; free them right away.
+    fetch_release(f);
+}
+
+static void fetch_fail(HttpFetch* f, const char* message) {
+    if (f->done) return;
+    if (f->conn) {
+        ClientConn* conn = f->conn;
+        f->conn = NULL;
+        client_conn_close(conn);
+    } else {
+        HttpFetch** cur = &f->pool->wait_head;
+        HttpFetch* prev = NULL;
+        while (*cur && *cur != f) {
+            prev = *cur;
+            cur = &(*cur)->next_wait;
         }
-        memcpy(ctx->buffer + ctx->buffer_used, buf->base, (size_t)nread);
-        ctx->buffer_used += (size_t)nread;
-        if (http_client_response_parse(ctx->response, ctx->buffer, ctx->buffer_used)) {
-            uv_read_stop(stream);
+        if (*cur == f) {
+            *cur = f->next_wait;
+            if (f->pool->wait_tail == f) f->pool->wait_tail = prev;
         }
-    } else if (nread < 0 && ctx) {
-        ctx->response->complete = true;
-        uv_read_stop(stream);
     }
-    if (buf && buf->base) free(buf->base);
+    free(f->error);
+    f->error = strdup(message ? message : "request failed");
+    fetch_finish(f);
 }
 
-static void on_http_client_timeout(uv_timer_t* timer) {
-    if (!timer) return;
-    HttpClientContext* ctx = timer->data;
-    if (ctx && ctx->response) {
-        ctx->timed_out = true;
-        ctx->response->status_code = 0;
-        free(ctx->response->status_text);
-        ctx->response->status_text = strdup("Request Timeout");
-        ctx->response->complete = true;
-        if (ctx->tcp_handle) {
-            uv_read_stop((uv_stream_t*)ctx->tcp_handle);
-            uv_close((uv_handle_t*)ctx->tcp_handle, on_http_client_close);
+static void fetch_complete(HttpFetch* f) {
+    if (f->done) return;
+    ClientConn* conn = f->conn;
+    f->conn = NULL;
+    f->response->complete = true;
+    if (conn) {
+        const char* connection = http_client_response_get_header(f->response, "Connection");
+        bool keep_alive = f->body_mode != FETCH_BODY_EOF &&
+                          !(connection && strcasecmp(connection, "close") == 0);
+        if (keep_alive) {
+            uv_read_stop((uv_stream_t*)&conn->tcp);
+            uv_unref((uv_handle_t*)&conn->tcp);
+            conn->fetch = NULL;
+            conn->last_used = time(NULL);
+            conn->next_idle = conn->pool->idle;
+            conn->pool->idle = conn;
+            pool_drain_waiting(conn->pool);
+        } else {
+            client_conn_close(conn);
         }
     }
-    uv_timer_stop(timer);
-    uv_close((uv_handle_t*)timer, NULL);
+    fetch_finish(f);
 }
 
-__attribute__((unused))
-static HttpClientResponse* http_client_execute(HttpClientRequest* req) {
-    if (!req) return NULL;
-    if (!global_event_loop) interpreter_init_event_loop();
-    if (!global_connection_pool) global_connection_pool = connection_pool_create(10, 30);
-    connection_pool_cleanup_idle(global_connection_pool);
-
-    uv_tcp_t* handle = connection_pool_get(global_connection_pool, req->host, req->port);
-    bool reused = handle != NULL;
-    if (!handle) {
-        handle = malloc(sizeof(uv_tcp_t));
-        uv_tcp_init(global_event_loop, handle);
-        struct sockaddr_in dest;
-        if (uv_ip4_addr(req->host, req->port, &dest) != 0) {
-            free(handle);
-            return NULL;
-        }
-        HttpClientContext tmp_ctx = {0};
-        uv_connect_t* connect_req = malloc(sizeof(uv_connect_t));
-        connect_req->data = &tmp_ctx;
-        tmp_ctx.connect_done = false;
-        tmp_ctx.connect_status = 0;
-        uv_tcp_connect(connect_req, handle, (const struct sockaddr*)&dest, on_http_client_connect);
-        while (!tmp_ctx.connect_done) {
-            uv_run(global_event_loop, UV_RUN_ONCE);
-        }
-        if (tmp_ctx.connect_status < 0) {
-            uv_close((uv_handle_t*)handle, on_http_client_close);
-            return NULL;
-        }
-    }
-
-    size_t req_len = 0;
-    char* req_data = http_client_request_build(req, &req_len);
-    if (!req_data) {
-        if (!reused) uv_close((uv_handle_t*)handle, on_http_client_close);
-        return NULL;
+static void fetch_deliver(HttpFetch* f, const char* data, size_t len) {
+    if (f->on_chunk.type == VAL_FUNCTION) {
+        char* piece = strndup(data, len);
+        Value arg = make_string(piece);
+        free(piece);
+        Value result = interpreter_execute_callback(f->on_chunk, 1, &arg);
+        value_free(&result);
+        value_free(&arg);
+        return;
     }
+    HttpClientResponse* resp = f->response;
+    if (resp->body_length + len + 1 > f->body_cap) {
+        size_t cap = f->body_cap ? f->body_cap : 4096;
+        while (cap < resp->body_length + len + 1) cap *= 2;
+        resp->body = realloc(resp->body, cap);
+        f->body_cap = cap;
+    }
+    memcpy(resp->body + resp->body_length, data, len);
+    resp->body_length += len;
+    resp->body[resp->body_length] = '\0';
+}
 
-    HttpClientContext* ctx = calloc(1, sizeof(HttpClientContext));
-    ctx->request = req;
-    ctx->response = http_client_response_create();
-    ctx->tcp_handle = handle;
-    ctx->buffer_size = 8192;
-    ctx->buffer_used = 0;
-    ctx->buffer = malloc(ctx->buffer_size);
-    ctx->headers_complete = false;
-    ctx->content_length = 0;
-    ctx->interp = NULL;
-    ctx->connect_done = true;
-    ctx->connect_status = 0;
-    ctx->timed_out = false;
-    ctx->timer_handle = malloc(sizeof(uv_timer_t));
-    ctx->timer_handle->data = ctx;
-
-    handle->data = ctx;
-
-    uv_write_t* write_req = malloc(sizeof(uv_write_t));
-    uv_buf_t buf = uv_buf_init(req_data, (unsigned int)req_len);
-    write_req->data = req_data;
-    uv_write(write_req, (uv_stream_t*)handle, &buf, 1, on_http_client_write);
+// Body bytes as received; transparently inflated for encoded responses.
+static void fetch_emit(HttpFetch* f, const char* data, size_t len) {
+    if (len == 0) return;
+    if (!f->inflater) {
+        fetch_deliver(f, data, len);
+        return;
+    }
+    char out[16384];
+    f->inflater->next_in = (Bytef*)data;
+    f->inflater->avail_in = (uInt)len;
+    while (f->inflater->avail_in > 0 && !f->done) {
+        f->inflater->next_out = (Bytef*)out;
+        f->inflater->avail_out = sizeof(out);
+        int r = inflate(f->inflater, Z_NO_FLUSH);
+        size_t produced = sizeof(out) - f->inflater->avail_out;
+        if (produced > 0) fetch_deliver(f, out, produced);
+        if (r == Z_STREAM_END) break;
+        if (r != Z_OK && !(r == Z_BUF_ERROR && produced > 0)) {
+            fetch_fail(f, "invalid compressed response body");
+            return;
+        }
+    }
+}
 
-    uv_read_start((uv_stream_t*)handle, alloc_buffer, on_http_client_read);
+static void fetch_feed_body(HttpFetch* f, const char* data, size_t len) {
+    if (f->body_mode == FETCH_BODY_EOF) {
+        fetch_emit(f, data, len);
+        return;
+    }
+    if (f->body_mode == FETCH_BODY_LENGTH) {
+        size_t n = len < f->body_remaining ? len : f->body_remaining;
+        fetch_emit(f, data, n);
+        f->body_remaining -= n;
+        if (f->body_remaining == 0) fetch_complete(f);
+        return;
+    }
+    while (len > 0 && !f->done && f->body_mode == FETCH_BODY_CHUNKED) {
+        char c;
+        switch (f->chunk_state) {
+            case CHUNK_SIZE_LINE:
+                c = *data++;
+                len--;
+                if (c == '\n') {
+                    f->chunk_line[f->chunk_line_len] = '\0';
+                    f->chunk_line_len = 0;
+                    f->body_remaining = (size_t)strtoul(f->chunk_line, NULL, 16);
+                    f->chunk_state = f->body_remaining == 0 ? CHUNK_TRAILER : CHUNK_DATA;
+                } else if (c != '\r' && f->chunk_line_len < sizeof(f->chunk_line) - 1) {
+                    f->chunk_line[f->chunk_line_len++] = c;
+                }
+                break;
+            case CHUNK_DATA: {
+                size_t n = len < f->body_remaining ? len : f->body_remaining;
+                fetch_emit(f, data, n);
+                data += n;
+                len -= n;
+                f->body_remaining -= n;
+                if (f->body_remaining == 0) f->chunk_state = CHUNK_DATA_END;
+                break;
+            }
+            case CHUNK_DATA_END:
+                c = *data++;
+                len--;
+                if (c == '\n') f->chunk_state = CHUNK_SIZE_LINE;
+                break;
+            case CHUNK_TRAILER:
+                c = *data++;
+                len--;
+                if (c == '\n') {
+                    if (f->chunk_line_len == 0) {
+                        fetch_complete(f);
+                        return;
+                    }
+                    f->chunk_line_len = 0;
+                } else if (c != '\r') {
+                    f->chunk_line_len = 1;
+                }
+                break;
+        }
+    }
+}
 
-    uv_timer_init(global_event_loop, ctx->timer_handle);
-    uv_timer_start(ctx->timer_handle, on_http_client_timeout, 30000, 0);
+static void fetch_feed(HttpFetch* f, const char* data, size_t len) {
+    if (f->headers_done) {
+        fetch_feed_body(f, data, len);
+        return;
+    }
+    if (f->head_len + len + 1 > f->head_cap) {
+        size_t cap = f->head_cap ? f->head_cap : 1024;
+        while (cap < f->head_len + len + 1) cap *= 2;
+        f->head_buf = realloc(f->head_buf, cap);
+        f->head_cap = cap;
+    }
+    memcpy(f->head_buf + f->head_len, data, len);
+    f->head_len += len;
+    f->head_buf[f->head_len] = '\0';
 
-    while (!ctx->response->complete && !ctx->timed_out) {
-        uv_run(global_event_loop, UV_RUN_ONCE);
+    size_t body_off = http_client_response_parse_head(f->response, f->head_buf, f->head_len);
+    if (body_off == 0) {
+        if (f->head_len > HTTP_CLIENT_MAX_HEAD) fetch_fail(f, "response headers too large");
+        return;
+    }
+    HttpClientResponse* resp = f->response;
+    if (resp->status_code >= 100 && resp->status_code < 200) {
+        // Interim response (100 Continue): discard it and parse what follows.
+        size_t rest = f->head_len - body_off;
+        char* copy = rest > 0 ? strndup(f->head_buf + body_off, rest) : NULL;
+        f->head_len = 0;
+        http_client_response_free(f->response);
+        f->response = http_client_response_create();
+        if (copy) {
+            fetch_feed(f, copy, rest);
+            free(copy);
+        }
+        return;
     }
+    f->headers_done = true;
 
-    if (ctx->timer_handle) {
-        uv_timer_stop(ctx->timer_handle);
-        uv_close((uv_handle_t*)ctx->timer_handle, NULL);
+    const char* te = http_client_response_get_header(resp, "Transfer-Encoding");
+    const char* cl = http_client_response_get_header(resp, "Content-Length");
+    const char* ce = http_client_response_get_header(resp, "Content-Encoding");
+    if (ce && (strcasecmp(ce, "gzip") == 0 || strcasecmp(ce, "x-gzip") == 0 || strcasecmp(ce, "deflate") == 0)) {
+        f->inflater = calloc(1, sizeof(z_stream));
+        // 15 + 32: accept both gzip and zlib wrappers.
+        if (inflateInit2(f->inflater, 15 + 32) != Z_OK) {
+            free(f->inflater);
+            f->inflater = NULL;
+        }
+    }
+    if (strcasecmp(f->request->method, "HEAD") == 0 || resp->status_code == 204 || resp->status_code == 304) {
+        f->body_mode = FETCH_BODY_NONE;
+    } else if (te && strcasestr(te, "chunked")) {
+        f->body_mode = FETCH_BODY_CHUNKED;
+        f->chunk_state = CHUNK_SIZE_LINE;
+    } else if (cl) {
+        f->body_mode = FETCH_BODY_LENGTH;
+        f->body_remaining = (size_t)strtoull(cl, NULL, 10);
+    } else {
+        f->body_mode = FETCH_BODY_EOF;
     }
+    if (f->body_mode == FETCH_BODY_NONE || (f->body_mode == FETCH_BODY_LENGTH && f->body_remaining == 0)) {
+        fetch_complete(f);
+        return;
+    }
+    if (f->head_len > body_off) {
+        fetch_feed_body(f, f->head_buf + body_off, f->head_len - body_off);
+    }
+}
 
-    HttpClientResponse* resp = ctx->response;
-    ctx->response = NULL;
+// The socket closed or errored before the response completed.
+static void fetch_conn_lost(HttpFetch* f, ssize_t status) {
+    if (f->headers_done && f->body_mode == FETCH_BODY_EOF && status == UV_EOF) {
+        fetch_complete(f);
+        return;
+    }
+    // A pooled keep-alive socket the server already closed: retry once on a
+    // fresh connection before reporting an error.
+    if (f->reused && !f->retried && f->bytes_received == 0) {
+        ClientConn* conn = f->conn;
+        f->conn = NULL;
+        f->retried = true;
+        client_conn_close(conn);
+        fetch_dispatch(f);
+        return;
+    }
+    fetch_fail(f, status == UV_EOF ? "connection closed before response completed" : uv_strerror((int)status));
+}
 
-    if (!ctx->timed_out && (reused || should_keep_alive(resp))) {
-        connection_pool_release(global_connection_pool, req->host, req->port, handle);
-    } else {
-        uv_close((uv_handle_t*)handle, on_http_client_close);
+static void on_client_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+    ClientConn* conn = stream->data;
+    HttpFetch* f = conn ? conn->fetch : NULL;
+    if (nread > 0 && f) {
+        f->bytes_received += (size_t)nread;
+        fetch_feed(f, buf->base, (size_t)nread);
+    } else if (nread < 0) {
+        if (f) {
+            fetch_conn_lost(f, nread);
+        } else {
+            client_conn_close(conn);
+        }
     }
+    if (buf && buf->base) tcp_slab_put(buf->base);
+}
 
-    free(ctx->buffer);
-    free(ctx);
-    return resp;
+static void on_fetch_timeout(uv_timer_t* timer) {
+    fetch_fail(timer->data, "request timed out");
+}
+
+static HttpFetch* fetch_start(HttpClientRequest* req, Value callback, Value on_chunk) {
+    if (!global_event_loop) interpreter_init_event_loop();
+    HttpFetch* f = calloc(1, sizeof(HttpFetch));
+    char id_buf[64];
+    snprintf(id_buf, sizeof(id_buf), "http_req_%ld", next_fetch_id++);
+    f->id = strdup(id_buf);
+    f->request = req;
+    f->response = http_client_response_create();
+    f->callback = callback;
+    f->on_chunk = on_chunk;
+    f->pool = host_pool_get(req->host, req->port);
+    uv_timer_init(global_event_loop, &f->timer);
+    f->timer.data = f;
+    f->next = http_fetches;
+    http_fetches = f;
+    if (client_request_timeout > 0) {
+        uv_timer_start(&f->timer, on_fetch_timeout, (uint64_t)client_request_timeout, 0);
+    }
+    fetch_dispatch(f);
+    return f;
 }
 
 static RouteRegistry* route_registry_create(void) {
@@ -784,25 +1611,42 @@ static bool path_has_parent_ref(const char* path) {
 }
 
 // Route Parameters Implementation
-static RouteParams* route_params_create(void) {
-    RouteParams* params = calloc(1, sizeof(RouteParams));
-    params->keys = NULL;
-    params->values = NULL;
-    params->count = 0;
+static RouteParams* route_params_create(Arena* arena) {
+    RouteParams* params = arena ? arena_calloc(arena, sizeof(RouteParams)) : calloc(1, sizeof(RouteParams));
+    params->arena = arena;
     return params;
 }
 
-static void route_params_add(RouteParams* params, const char* key, const char* value) {
-    if (!params || !key || !value) return;
-    params->keys = realloc(params->keys, sizeof(char*) * (params->count + 1));
-    params->values = realloc(params->values, sizeof(char*) * (params->count + 1));
-    params->keys[params->count] = strdup(key);
-    params->values[params->count] = strdup(value);
+static void route_params_add_n(RouteParams* params, const char* key, size_t key_len, const char* value, size_t value_len) {
+    if (params->count == params->capacity) {
+        int cap = params->capacity ? params->capacity * 2 : 4;
+        if (params->arena) {
+            char** keys = arena_alloc(params->arena, sizeof(char*) * (size_t)cap);
+            char** values = arena_alloc(params->arena, sizeof(char*) * (size_t)cap);
+            if (params->count > 0) {
+                memcpy(keys, params->keys, sizeof(char*) * (size_t)params->count);
+                memcpy(values, params->values, sizeof(char*) * (size_t)params->count);
+            }
+            params->keys = keys;
+            params->values = values;
+        } else {
+            params->keys = realloc(params->keys, sizeof(char*) * (size_t)cap);
+            params->values = realloc(params->values, sizeof(char*) * (size_t)cap);
+        }
+        params->capacity = cap;
+    }
+    if (params->arena) {
+        params->keys[params->count] = arena_strndup(params->arena, key, key_len);
+        params->values[params->count] = arena_strndup(params->arena, value, value_len);
+    } else {
+        params->keys[params->count] = strndup(key, key_len);
+        params->values[params->count] = strndup(value, value_len);
+    }
     params->count++;
 }
 
 static void route_params_free(RouteParams* params) {
-    if (!params) return;
+    if (!params || params->arena) return;
     for (int i = 0; i < params->count; i++) {
         free(params->keys[i]);
         free(params->values[i]);
@@ -813,10 +1657,10 @@ static void route_params_free(RouteParams* params) {
 }
 
 // Match route pattern with params: /user/:id matches /user/123
-static bool route_match_with_params(const char* pattern, const char* path, RouteParams** params_out) {
+static bool route_match_with_params(Arena* arena, const char* pattern, const char* path, RouteParams** params_out) {
     if (!pattern || !path) return false;
 
-    RouteParams* params = route_params_create();
+    RouteParams* params = route_params_create(arena);
     const char* p = pattern;
     const char* u = path;
 
@@ -827,23 +1671,14 @@ static bool route_match_with_params(const char* pattern, const char* path, Route
             const char* param_start = p;
             while (*p && *p != '/') p++;
 
-            // Extract parameter name
             size_t param_len = p - param_start;
-            char* param_name = malloc(param_len + 1);
-            memcpy(param_name, param_start, param_len);
-            param_name[param_len] = '\0';
 
             // Extract parameter value from URL
             const char* value_start = u;
             while (*u && *u != '/') u++;
             size_t value_len = u - value_start;
-            char* param_value = malloc(value_len + 1);
-            memcpy(param_value, value_start, value_len);
-            param_value[value_len] = '\0';
 
-            route_params_add(params, param_name, param_value);
-            free(param_name);
-            free(param_value);
+            route_params_add_n(params, param_start, param_len, value_start, value_len);
         } else if (*p == *u) {
             p++;
             u++;
@@ -863,7 +1698,7 @@ static bool route_match_with_params(const char* pattern, const char* path, Route
     return match;
 }
 
-static RouteNode* route_registry_find_with_params(RouteRegistry* reg, const char* path, const char* method, RouteParams** params_out) {
+static RouteNode* route_registry_find_with_params(RouteRegistry* reg, Arena* arena, const char* path, const char* method, RouteParams** params_out) {
     if (!reg || !path) return NULL;
 
     // First try exact match (faster)
@@ -877,7 +1712,7 @@ static RouteNode* route_registry_find_with_params(RouteRegistry* reg, const char
     // Try parameter matching
     for (RouteNode* cur = reg->head; cur; cur = cur->next) {
         if (cur->has_params && cur->method && method && strcasecmp(cur->method, method) == 0) {
-            if (route_match_with_params(cur->path, path, params_out)) {
+            if (route_match_with_params(arena, cur->path, path, params_out)) {
                 return cur;
             }
         }
@@ -1001,181 +1836,6 @@ static char* form_get(const char* form_data, const char* key) {
     return value;
 }
 
-// Template Engine: {{ var }}
-static char* template_render(const char* template_str, RouteParams* vars) {
-    if (!template_str) return NULL;
-    if (!vars || vars->count == 0) return strdup(template_str);
-
-    size_t result_size = strlen(template_str) * 2 + 1024;
-    char* result = malloc(result_size);
-    size_t result_len = 0;
-
-    const char* p = template_str;
-    while (*p) {
-        if (p[0] == '{' && p[1] == '{') {
-            // Found template variable
-            p += 2;
-            while (*p == ' ') p++; // Skip whitespace
-
-            const char* var_start = p;
-            while (*p && *p != '}') p++;
-            const char* var_end = p;
-            while (var_end > var_start && *(var_end-1) == ' ') var_end--;
-
-            size_t var_len = var_end - var_start;
-            char* var_name = malloc(var_len + 1);
-            memcpy(var_name, var_start, var_len);
-            var_name[var_len] = '\0';
-
-            // Find variable value
-            const char* value = NULL;
-            for (int i = 0; i < vars->count; i++) {
-                if (strcmp(vars->keys[i], var_name) == 0) {
-                    value = vars->values[i];
-                    break;
-                }
-            }
-
-            if (value) {
-                size_t value_len = strlen(value);
-                if (result_len + value_len >= result_size) {
-                    result_size *= 2;
-                    result = realloc(result, result_size);
-                }
-                memcpy(result + result_len, value, value_len);
-                result_len += value_len;
-            }
-
-            free(var_name);
-
-            // Skip closing }}
-            if (*p == '}') p++;
-            if (*p == '}') p++;
-        } else {
-            if (result_len >= result_size - 1) {
-                result_size *= 2;
-                result = realloc(result, result_size);
-            }
-            result[result_len++] = *p++;
-        }
-    }
-
-    result[result_len] = '\0';
-    return result;
-}
-
-// Session Management
-static SessionStore* __attribute__((unused)) session_store_create(void) {
-    SessionStore* store = calloc(1, sizeof(SessionStore));
-    store->head = NULL;
-    store->count = 0;
-    return store;
-}
-
-static char* generate_session_id(void) {
-    char* id = malloc(33);
-    srand((unsigned)time(NULL) + (unsigned)getpid());
-    for (int i = 0; i < 32; i++) {
-        int r = rand() % 16;
-        id[i] = "0123456789abcdef"[r];
-    }
-    id[32] = '\0';
-    return id;
-}
-
-static Session* __attribute__((unused)) session_create(const char* id) {
-    Session* sess = calloc(1, sizeof(Session));
-    sess->id = id ? strdup(id) : generate_session_id();
-    sess->keys = NULL;
-    sess->values = NULL;
-    sess->count = 0;
-    sess->created = time(NULL);
-    sess->last_accessed = time(NULL);
-    sess->next = NULL;
-    return sess;
-}
-
-static Session* __attribute__((unused)) session_find(SessionStore* store, const char* id) {
-    if (!store || !id) return NULL;
-    for (Session* sess = store->head; sess; sess = sess->next) {
-        if (strcmp(sess->id, id) == 0) {
-            sess->last_accessed = time(NULL);
-            return sess;
-        }
-    }
-    return NULL;
-}
-
-static void __attribute__((unused)) session_set(Session* sess, const char* key, const char* value) {
-    if (!sess || !key || !value) return;
-
-    // Check if key already exists
-    for (int i = 0; i < sess->count; i++) {
-        if (strcmp(sess->keys[i], key) == 0) {
-            free(sess->values[i]);
-            sess->values[i] = strdup(value);
-            return;
-        }
-    }
-
-    // Add new key-value pair
-    sess->keys = realloc(sess->keys, sizeof(char*) * (sess->count + 1));
-    sess->values = realloc(sess->values, sizeof(char*) * (sess->count + 1));
-    sess->keys[sess->count] = strdup(key);
-    sess->values[sess->count] = strdup(value);
-    sess->count++;
-}
-
-static const char* __attribute__((unused)) session_get(Session* sess, const char* key) {
-    if (!sess || !key) return NULL;
-    for (int i = 0; i < sess->count; i++) {
-        if (strcmp(sess->keys[i], key) == 0) {
-            return sess->values[i];
-        }
-    }
-    return NULL;
-}
-
-static void __attribute__((unused)) session_destroy(SessionStore* store, const char* id) {
-    if (!store || !id) return;
-    Session** cur = &store->head;
-    while (*cur) {
-        if (strcmp((*cur)->id, id) == 0) {
-            Session* to_free = *cur;
-            *cur = to_free->next;
-            for (int i = 0; i < to_free->count; i++) {
-                free(to_free->keys[i]);
-                free(to_free->values[i]);
-            }
-            free(to_free->keys);
-            free(to_free->values);
-            free(to_free->id);
-            free(to_free);
-            store->count--;
-            return;
-        }
-        cur = &(*cur)->next;
-    }
-}
-
-static void __attribute__((unused)) session_store_free(SessionStore* store) {
-    if (!store) return;
-    Session* cur = store->head;
-    while (cur) {
-        Session* next = cur->next;
-        for (int i = 0; i < cur->count; i++) {
-            free(cur->keys[i]);
-            free(cur->values[i]);
-        }
-        free(cur->keys);
-        free(cur->values);
-        free(cur->id);
-        free(cur);
-        cur = next;
-    }
-    free(store);
-}
-
 static const char* guess_mime(const char* path) {
     if (!path) return "application/octet-stream";
     const char* ext = strrchr(path, '.');
@@ -1275,7 +1935,6 @@ static RadsBufferNode* buffer_push(RadsBufferNode** head, const char* data, size
     return node;
 }
 
-__attribute__((unused))
 static HttpClientRequest* http_client_request_create(const char* method, const char* url) {
     if (!method || !url) return NULL;
     HttpClientRequest* req = calloc(1, sizeof(HttpClientRequest));
@@ -1303,7 +1962,6 @@ static void http_client_request_add_header(HttpClientRequest* req, const char* n
     req->header_count++;
 }
 
-__attribute__((unused))
 static void http_client_request_set_body(HttpClientRequest* req, const char* body) {
     if (!req) return;
     free(req->body);
@@ -1419,11 +2077,12 @@ static const char* http_client_response_get_header(HttpClientResponse* resp, con
     return NULL;
 }
 
-static bool http_client_response_parse(HttpClientResponse* resp, const char* data, size_t len) {
-    if (!resp || !data || len == 0) return false;
-    const char* end = data + len;
+// Parses the status line and headers of a NUL-terminated buffer. Returns the
+// offset where the body starts, or 0 while the header block is incomplete.
+static size_t http_client_response_parse_head(HttpClientResponse* resp, const char* data, size_t len) {
+    if (!resp || !data || len == 0) return 0;
     const char* line_end = strstr(data, "\r\n");
-    if (!line_end) return false;
+    if (!line_end) return 0;
     size_t status_len = (size_t)(line_end - data);
     char* status_line = strndup(data, status_len);
     char* saveptr;
@@ -1432,7 +2091,7 @@ static bool http_client_response_parse(HttpClientResponse* resp, const char* dat
     char* status_text = strtok_r(NULL, "", &saveptr);
     if (!http_version || !status_code_str) {
         free(status_line);
-        return false;
+        return 0;
     }
     resp->status_code = atoi(status_code_str);
     free(resp->status_text);
@@ -1441,7 +2100,7 @@ static bool http_client_response_parse(HttpClientResponse* resp, const char* dat
 
     const char* headers_start = line_end + 2;
     const char* headers_end = strstr(headers_start, "\r\n\r\n");
-    if (!headers_end) return false;
+    if (!headers_end) return 0;
     const char* cursor = headers_start;
     while (cursor < headers_end) {
         const char* eol = strstr(cursor, "\r\n");
@@ -1464,33 +2123,9 @@ static bool http_client_response_parse(HttpClientResponse* resp, const char* dat
         cursor = eol + 2;
     }
 
-    const char* body_start = headers_end + 4;
-    size_t remaining = (size_t)(end - body_start);
-    const char* cl = http_client_response_get_header(resp, "Content-Length");
-    if (cl) {
-        size_t blen = (size_t)strtoul(cl, NULL, 10);
-        if (blen <= remaining) {
-            resp->body_length = blen;
-            free(resp->body);
-            resp->body = malloc(blen + 1);
-            memcpy(resp->body, body_start, blen);
-            resp->body[blen] = '\0';
-            resp->complete = true;
-            return true;
-        }
-    } else if (remaining > 0) {
-        resp->body_length = remaining;
-        free(resp->body);
-        resp->body = malloc(remaining + 1);
-        memcpy(resp->body, body_start, remaining);
-        resp->body[remaining] = '\0';
-        resp->complete = true;
-        return true;
-    }
-    return false;
+    return (size_t)(headers_end + 4 - data);
 }
 
-__attribute__((unused))
 static void http_client_response_free(HttpClientResponse* resp) {
     if (!resp) return;
     free(resp->status_text);
@@ -1514,6 +2149,8 @@ static TcpHandleCtx* register_tcp_ctx(struct Interpreter* interp, uv_tcp_t* hand
     ctx->owns_handle = owns_handle;
     ctx->is_http = is_http;
     ctx->data_owner = false;
+    ctx->writer = NULL;
+    ctx->arena = NULL;
     ctx->data = NULL;
     ctx->interp = interp;
     if (explicit_id) {
@@ -1543,7 +2180,22 @@ static void unregister_tcp_ctx(TcpHandleCtx* ctx) {
     if (*cur == ctx) {
         *cur = ctx->next;
     }
+    interpreter_wake(ctx->id);
     buffer_free(ctx->recv_queue);
+    if (ctx->rx.data) {
+        if (ctx->rx.cap == TCP_SLAB_SIZE) tcp_slab_put(ctx->rx.data);
+        else free(ctx->rx.data);
+    }
+    if (ctx->pipe_to) ctx->pipe_to->pipe_from = NULL;
+    if (ctx->pipe_from) {
+        // Nothing left to forward into; the proxy's other side goes too.
+        ctx->pipe_from->pipe_to = NULL;
+        tcp_close(ctx->pipe_from);
+    }
+    if (ctx->writer) {
+        http_writer_detach(ctx->writer);
+    }
+    arena_release(ctx->arena);
     if (ctx->data_owner && ctx->data) {
         route_registry_free((RouteRegistry*)ctx->data);
     }
@@ -1567,10 +2219,289 @@ static void enqueue_data(TcpHandleCtx* ctx, const char* data, ssize_t len) {
     buffer_push(&ctx->recv_queue, data, (size_t)len);
 }
 
+// Read buffers come from a pool of fixed-size slabs shared by every
+// connection on the loop instead of a fresh malloc per read.
+static char* tcp_slab_pool = NULL;   // free list threaded through the slabs
+static int tcp_slab_pool_count = 0;
+
+static char* tcp_slab_get(void) {
+    char* slab = tcp_slab_pool;
+    if (slab) {
+        memcpy(&tcp_slab_pool, slab, sizeof(char*));
+        tcp_slab_pool_count--;
+        return slab;
+    }
+    return malloc(TCP_SLAB_SIZE);
+}
+
+static void tcp_slab_put(char* slab) {
+    if (!slab) return;
+    if (tcp_slab_pool_count >= TCP_SLAB_POOL_MAX) {
+        free(slab);
+        return;
+    }
+    memcpy(slab, &tcp_slab_pool, sizeof(char*));
+    tcp_slab_pool = slab;
+    tcp_slab_pool_count++;
+}
+
 void alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
     (void)handle;
-    buf->base = malloc(suggested_size);
-    buf->len = suggested_size;
+    (void)suggested_size;
+    buf->base = tcp_slab_get();
+    buf->len = buf->base ? TCP_SLAB_SIZE : 0;
+}
+
+// Makes room for at least min bytes after the unread data.
+static bool tcp_rx_reserve(TcpRecvBuffer* rx, size_t min) {
+    if (!rx->data) {
+        rx->data = tcp_slab_get();
+        if (!rx->data) return false;
+        rx->cap = TCP_SLAB_SIZE;
+        rx->head = rx->len = 0;
+    }
+    if (rx->len == 0) rx->head = 0;
+    if (rx->cap - rx->head - rx->len >= min) return true;
+    if (rx->head > 0 && rx->cap - rx->len >= min) {
+        memmove(rx->data, rx->data + rx->head, rx->len);
+        rx->head = 0;
+        return true;
+    }
+    size_t cap = rx->cap * 2;
+    while (cap - rx->len < min) cap *= 2;
+    char* data = malloc(cap);
+    if (!data) return false;
+    memcpy(data, rx->data + rx->head, rx->len);
+    if (rx->cap == TCP_SLAB_SIZE) tcp_slab_put(rx->data);
+    else free(rx->data);
+    rx->data = data;
+    rx->cap = cap;
+    rx->head = 0;
+    return true;
+}
+
+static void tcp_rx_consume(TcpRecvBuffer* rx, size_t n) {
+    rx->head += n;
+    rx->len -= n;
+    if (rx->len == 0 && rx->cap == TCP_SLAB_SIZE) {
+        // Idle sockets give their slab back.
+        tcp_slab_put(rx->data);
+        rx->data = NULL;
+        rx->cap = rx->head = 0;
+    }
+}
+
+// Raw sockets read into their receive buffer, or into a slab that is
+// handed to uv_write as-is when the socket is piped.
+static void tcp_alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
+    (void)suggested_size;
+    TcpHandleCtx* ctx = handle->data;
+    if (ctx->piped) {
+        alloc_buffer(handle, suggested_size, buf);
+        return;
+    }
+    if (!tcp_rx_reserve(&ctx->rx, TCP_RECV_MIN_READ)) {
+        buf->base = NULL;
+        buf->len = 0;
+        return;
+    }
+    buf->base = ctx->rx.data + ctx->rx.head + ctx->rx.len;
+    buf->len = ctx->rx.cap - ctx->rx.head - ctx->rx.len;
+}
+
+static bool tcp_rx_full(const TcpHandleCtx* ctx) {
+    return ctx->rx.len >= TCP_RECV_HIGH_WATER && ctx->rx.len >= ctx->rx_want;
+}
+
+static void tcp_read_resume(TcpHandleCtx* ctx) {
+    if (ctx->reading || ctx->eof || ctx->closing || ctx->connecting || ctx->pipe_paused) return;
+    if (!ctx->piped && tcp_rx_full(ctx)) return;
+    if (uv_read_start((uv_stream_t*)ctx->handle, tcp_alloc_buffer, on_read) == 0) ctx->reading = true;
+}
+
+static void tcp_read_pause(TcpHandleCtx* ctx) {
+    if (!ctx->reading) return;
+    uv_read_stop((uv_stream_t*)ctx->handle);
+    ctx->reading = false;
+}
+
+static void tcp_close(TcpHandleCtx* ctx) {
+    if (ctx->closing) return;
+    ctx->closing = true;
+    ctx->reading = false;
+    if (!uv_is_closing((uv_handle_t*)ctx->handle)) uv_close((uv_handle_t*)ctx->handle, on_close);
+}
+
+// After main() returns the script can no longer accept, recv from or pipe
+// through its listeners and sockets, so close them rather than let them keep
+// the event loop running. HTTP client requests are not in this list and
+// still finish.
+static void tcp_close_all(void) {
+    for (TcpHandleCtx* cur = tcp_ctx_head; cur; cur = cur->next) tcp_close(cur);
+}
+
+// net.pipe: each read slab is written to the target as-is and returns to
+// the pool once the write completes.
+static void tcp_pipe_on_write(uv_write_t* req, int status) {
+    tcp_slab_put(req->data);
+    TcpHandleCtx* target = req->handle->data;
+    free(req);
+    if (!target) return;
+    if (status < 0) {
+        tcp_close(target);
+        return;
+    }
+    TcpHandleCtx* src = target->pipe_from;
+    if (src && src->pipe_paused && target->handle->write_queue_size <= TCP_PIPE_LOW_WATER) {
+        src->pipe_paused = false;
+        tcp_read_resume(src);
+    }
+}
+
+static void tcp_on_shutdown(uv_shutdown_t* req, int status) {
+    TcpHandleCtx* ctx = req->handle->data;
+    free(req);
+    if (ctx && (status < 0 || ctx->eof)) tcp_close(ctx);
+}
+
+static void tcp_shutdown(TcpHandleCtx* ctx) {
+    if (ctx->shut || ctx->closing) return;
+    ctx->shut = true;
+    uv_shutdown_t* req = malloc(sizeof(uv_shutdown_t));
+    if (uv_shutdown(req, (uv_stream_t*)ctx->handle, tcp_on_shutdown) != 0) {
+        free(req);
+        tcp_close(ctx);
+    }
+}
+
+// Queues len bytes of data (owned by the request from now on) on ctx.
+static bool tcp_write_owned(TcpHandleCtx* ctx, char* owner, const char* data, size_t len,
+                            uv_write_cb cb) {
+    uv_write_t* req = malloc(sizeof(uv_write_t));
+    uv_buf_t buf = uv_buf_init((char*)data, (unsigned int)len);
+    req->data = owner;
+    int r = uv_write(req, (uv_stream_t*)ctx->handle, &buf, 1, cb);
+    if (r != 0) {
+        fprintf(stderr, "uv_write error: %s\n", uv_strerror(r));
+        free(req);
+        return false;
+    }
+    return true;
+}
+
+static void tcp_pipe_read(TcpHandleCtx* ctx, ssize_t nread, const uv_buf_t* buf) {
+    TcpHandleCtx* target = ctx->pipe_to;
+    if (nread > 0 && target && !target->closing) {
+        if (!tcp_write_owned(target, buf->base, buf->base, (size_t)nread, tcp_pipe_on_write)) {
+            tcp_slab_put(buf->base);
+            tcp_close(target);
+            return;
+        }
+        if (target->handle->write_queue_size > TCP_PIPE_HIGH_WATER) {
+            tcp_read_pause(ctx);
+            ctx->pipe_paused = true;
+        }
+        return;
+    }
+    if (buf && buf->base) tcp_slab_put(buf->base);
+    if (nread == 0) return;
+    // EOF, a read error, or nowhere left to write: pass the half-close on
+    // and close once both directions are finished.
+    tcp_read_pause(ctx);
+    ctx->eof = true;
+    if (target) tcp_shutdown(target);
+    if (ctx->shut || !target) tcp_close(ctx);
+}
+
+// HTTP connections read straight into their request arena, behind any
+// bytes not yet consumed, keeping one spare byte so the parser can
+// NUL-terminate in place. Between requests only that unconsumed input is
+// live, so the arena is reset and the input moved to the front.
+static void http_alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
+    TcpHandleCtx* ctx = handle->data;
+    if (!ctx->arena) ctx->arena = arena_acquire();
+    const char* pending = ctx->http_in;
+    char* saved = NULL;
+    if (!ctx->http_processing) {
+        if (ctx->http_in_len > 0) {
+            saved = malloc(ctx->http_in_len);
+            if (saved) memcpy(saved, ctx->http_in, ctx->http_in_len);
+        }
+        arena_reset(ctx->arena);
+        pending = saved;
+    }
+    char* base = (pending || ctx->http_in_len == 0) ? arena_alloc(ctx->arena, ctx->http_in_len + suggested_size) : NULL;
+    if (base && ctx->http_in_len > 0) memcpy(base, pending, ctx->http_in_len);
+    free(saved);
+    if (!base) {
+        ctx->http_in = NULL;
+        ctx->http_in_len = 0;
+        buf->base = NULL;
+        buf->len = 0;
+        return;
+    }
+    ctx->http_in = base;
+    buf->base = base + ctx->http_in_len;
+    buf->len = suggested_size - 1;
+}
+
+// Handles the complete requests buffered on an HTTP connection in order.
+// The next request is parsed only once the previous response has been
+// written, so pipelined requests are answered in the order they arrived even
+// when a handler streams or finishes asynchronously.
+static void http_process_input(uv_stream_t* client) {
+    TcpHandleCtx* ctx = client->data;
+    if (ctx->http_processing) return;
+    ctx->http_processing = true;
+    while (!ctx->http_busy && ctx->http_in_len > 0 && !uv_is_closing((uv_handle_t*)client)) {
+        int status = 0;
+        size_t n = http_request_frame(ctx->http_in, ctx->http_in_len, &status);
+        if (status) {
+            ctx->http_in_len = 0;
+            ctx->http_keep_alive = false;
+            ctx->http_busy = true;
+            HttpResponse* resp = http_response_create(NULL, status, http_status_text(status));
+            http_response_set_body(resp, http_status_text(status), "text/plain");
+            http_send_response(client, resp);
+            http_response_free(resp);
+            break;
+        }
+        if (n == 0) break;
+        // The parser terminates the request in place; that byte may be the
+        // start of the next one.
+        char next = ctx->http_in[n];
+        ctx->http_busy = true;
+        http_handle_request(client, ctx->http_in, (ssize_t)n);
+        if (ctx->upgraded) {
+            // The websocket module owns the socket now; drop only our state.
+            ctx->owns_handle = false;
+            unregister_tcp_ctx(ctx);
+            return;
+        }
+        ctx->http_in[n] = next;
+        ctx->http_in += n;
+        ctx->http_in_len -= n;
+    }
+    ctx->http_processing = false;
+    if (ctx->http_in_len == 0) {
+        ctx->http_in = NULL;
+        if (ctx->arena) arena_reset(ctx->arena);
+    }
+    if (uv_is_closing((uv_handle_t*)client) || ctx->http_busy) return;
+    if (ctx->eof) {
+        uv_close((uv_handle_t*)client, on_close);
+    } else if (ctx->http_paused) {
+        ctx->http_paused = false;
+        uv_read_start(client, http_alloc_buffer, on_read);
+    }
+}
+
+// The last write of a response completed on a connection that stays open.
+static void http_response_done(uv_stream_t* client) {
+    TcpHandleCtx* ctx = client ? client->data : NULL;
+    if (!ctx || uv_is_closing((uv_handle_t*)client)) return;
+    ctx->http_busy = false;
+    http_process_input(client);
 }
 
 void on_new_connection(uv_stream_t* server, int status) {
@@ -1588,11 +2519,17 @@ void on_new_connection(uv_stream_t* server, int status) {
             ctx->data = server_ctx->data;
             ctx->data_owner = false;
         }
-        // Expose new client handle to interpreter via the listener's queue
+        // HTTP connections are handled natively; only raw TCP listeners
+        // expose new client handles to the interpreter via their queue.
+        if (ctx->is_http) {
+            uv_read_start((uv_stream_t*)client, http_alloc_buffer, on_read);
+            return;
+        }
         if (server_ctx) {
             enqueue_data(server_ctx, ctx->id, (ssize_t)strlen(ctx->id));
+            interpreter_wake(server_ctx->id);
         }
-        uv_read_start((uv_stream_t*)client, alloc_buffer, on_read);
+        tcp_read_resume(ctx);
     } else {
         uv_close((uv_handle_t*)client, on_close);
     }
@@ -1600,15 +2537,45 @@ void on_new_connection(uv_stream_t* server, int status) {
 
 void on_read(uv_stream_t* client, ssize_t nread, const uv_buf_t* buf) {
     TcpHandleCtx* ctx = client ? client->data : NULL;
-    if (nread > 0) {
-        enqueue_data(ctx, buf->base, nread);
-        if (ctx && ctx->is_http) {
-            http_handle_request(client, buf->base, nread);
+    if (ctx && ctx->is_http) {
+        if (nread > 0) {
+            ctx->http_in_len += (size_t)nread;
+            // Pipelined input waits while a response is outstanding; stop
+            // reading rather than buffer without bound.
+            if (ctx->http_busy && ctx->http_in_len > HTTP_MAX_HEAD && !ctx->http_paused) {
+                uv_read_stop(client);
+                ctx->http_paused = true;
+            }
+            http_process_input(client);
+        } else if (nread < 0 && !uv_is_closing((uv_handle_t*)client)) {
+            // A client may half-close after pipelining: requests already
+            // received are still answered, but a stream the client stopped
+            // reading is closed at once.
+            HttpResponseWriter* writer = ctx->writer;
+            bool streaming = writer && writer->headers_sent && !writer->ended;
+            ctx->eof = true;
+            uv_read_stop(client);
+            if (nread != UV_EOF || !ctx->http_busy || streaming) {
+                uv_close((uv_handle_t*)client, on_close);
+            }
         }
+        return;
+    }
+    if (!ctx) return;
+    if (ctx->piped) {
+        tcp_pipe_read(ctx, nread, buf);
+        return;
+    }
+    interpreter_wake(ctx->id);
+    if (nread > 0) {
+        ctx->rx.len += (size_t)nread;
+        if (tcp_rx_full(ctx)) tcp_read_pause(ctx);
     } else if (nread < 0) {
-        uv_close((uv_handle_t*)client, on_close);
+        // Keep the socket (and anything still buffered) until the script
+        // has read it; net.recv closes it once it is drained.
+        tcp_read_pause(ctx);
+        ctx->eof = true;
     }
-    if (buf->base) free(buf->base);
 }
 
 void on_write(uv_write_t* req, int status) {
@@ -1620,10 +2587,17 @@ void on_write(uv_write_t* req, int status) {
 }
 
 void on_connect(uv_connect_t* req, int status) {
-    if (status < 0) {
-        fprintf(stderr, "Connect error: %s\n", uv_strerror(status));
-    } else {
-        uv_read_start(req->handle, alloc_buffer, on_read);
+    TcpHandleCtx* ctx = req->handle->data;
+    if (ctx) {
+        ctx->connecting = false;
+        interpreter_wake(ctx->id);
+        if (status < 0) {
+            fprintf(stderr, "Connect error: %s\n", uv_strerror(status));
+            ctx->eof = true;
+            ctx->shut = true;
+        } else {
+            tcp_read_resume(ctx);
+        }
     }
     free(req);
 }
@@ -1633,19 +2607,371 @@ void on_close(uv_handle_t* handle) {
     unregister_tcp_ctx(ctx);
 }
 
+typedef struct HttpWriteReq {
+    uv_write_t req;
+    char* head;
+    char* body;
+    HttpCommonHeaders* common;
+    HttpCachedBody* shared;
+    HttpResponseWriter* writer;
+    bool close_after;
+    bool last;               // final write of the response
+    char chunk_prefix[24];
+} HttpWriteReq;
+
+static void http_write_req_free(HttpWriteReq* wr) {
+    free(wr->head);
+    free(wr->body);
+    http_cached_body_release(wr->shared);
+    http_common_headers_release(wr->common);
+    free(wr);
+}
+
+static void on_http_response_written(uv_write_t* req, int status) {
+    HttpWriteReq* wr = (HttpWriteReq*)req;
+    if (status < 0 && status != UV_ECANCELED) {
+        fprintf(stderr, "Write error: %s\n", uv_strerror(status));
+    }
+    uv_stream_t* client = req->handle;
+    bool close_after = wr->close_after || (status < 0 && wr->last);
+    bool last = wr->last;
+    HttpResponseWriter* writer = wr->writer;
+    http_write_req_free(wr);
+    // Close only once the write finished so large bodies are not truncated.
+    if (close_after) {
+        if (client && !uv_is_closing((uv_handle_t*)client)) {
+            uv_close((uv_handle_t*)client, on_close);
+        }
+        return;
+    }
+    if (last) {
+        http_response_done(client);
+        return;
+    }
+    if (status == 0 && writer && writer->client && writer->waiting_drain &&
+        uv_stream_get_write_queue_size(writer->client) <= HTTP_STREAM_LOW_WATER) {
+        writer->waiting_drain = false;
+        if (writer->on_drain.type == VAL_FUNCTION) {
+            Value arg = make_string(writer->id);
+            Value result = interpreter_execute_callback(writer->on_drain, 1, &arg);
+            value_free(&result);
+            value_free(&arg);
+        }
+    }
+}
+
+static bool http_write_bufs(uv_stream_t* client, HttpWriteReq* wr, uv_buf_t* bufs, unsigned int nbufs) {
+    int r = uv_write(&wr->req, client, bufs, nbufs, on_http_response_written);
+    if (r != 0) {
+        fprintf(stderr, "uv_write error: %s\n", uv_strerror(r));
+        bool close_after = wr->close_after || wr->last;
+        http_write_req_free(wr);
+        if (close_after && !uv_is_closing((uv_handle_t*)client)) {
+            uv_close((uv_handle_t*)client, on_close);
+        }
+        return false;
+    }
+    return true;
+}
+
+// Scatter-gather send: [status line + headers][Date/Server][body]. The body
+// buffer is moved out of the response rather than concatenated with the head.
 static void http_send_response(uv_stream_t* client, HttpResponse* resp) {
     if (!client || !resp) return;
-    size_t resp_len = 0;
-    char* serialized = http_response_build(resp, &resp_len);
-    if (!serialized) return;
-    uv_write_t* req = malloc(sizeof(uv_write_t));
-    uv_buf_t buf = uv_buf_init(serialized, (unsigned int)resp_len);
-    req->data = serialized;
-    uv_write(req, client, &buf, 1, on_write);
-    uv_close((uv_handle_t*)client, on_close);
+    TcpHandleCtx* ctx = client->data;
+    bool keep_alive = ctx && ctx->http_keep_alive;
+    size_t head_len = 0;
+    char* head = http_response_build_head(resp, keep_alive, &head_len);
+    if (!head) return;
+    HttpWriteReq* wr = calloc(1, sizeof(HttpWriteReq));
+    const char* body = resp->body;
+    wr->head = head;
+    if (resp->shared_body) {
+        wr->shared = resp->shared_body;
+        resp->shared_body = NULL;
+    } else {
+        wr->body = resp->body;
+    }
+    wr->common = http_common_headers_acquire();
+    wr->close_after = !keep_alive;
+    wr->last = true;
+    resp->body = NULL;
+
+    uv_buf_t bufs[3];
+    unsigned int nbufs = 0;
+    bufs[nbufs++] = uv_buf_init(head, (unsigned int)head_len);
+    if (wr->common) {
+        bufs[nbufs++] = uv_buf_init(wr->common->data, (unsigned int)wr->common->len);
+    } else {
+        bufs[nbufs++] = uv_buf_init("\r\n", 2);
+    }
+    if (body && resp->body_length > 0) {
+        bufs[nbufs++] = uv_buf_init((char*)body, (unsigned int)resp->body_length);
+    }
+    http_write_bufs(client, wr, bufs, nbufs);
+}
+
+// Streaming responses (Transfer-Encoding: chunked)
+static HttpResponseWriter* http_writers = NULL;
+static long next_writer_id = 1;
+
+static HttpResponseWriter* http_writer_create(uv_stream_t* client) {
+    HttpResponseWriter* writer = calloc(1, sizeof(HttpResponseWriter));
+    char id_buf[64];
+    snprintf(id_buf, sizeof(id_buf), "http_res_%ld", next_writer_id++);
+    writer->id = strdup(id_buf);
+    writer->client = client;
+    writer->status_code = 200;
+    writer->on_drain = make_null();
+    writer->next = http_writers;
+    http_writers = writer;
+    return writer;
+}
+
+static HttpResponseWriter* http_writer_find(const char* id) {
+    if (!id) return NULL;
+    for (HttpResponseWriter* cur = http_writers; cur; cur = cur->next) {
+        if (strcmp(cur->id, id) == 0) return cur;
+    }
+    return NULL;
+}
+
+// A kept-alive connection reuses its writer for the next response. The new
+// id stops a handle kept from the previous request writing into this one.
+static void http_writer_reset(HttpResponseWriter* writer) {
+    char id_buf[64];
+    snprintf(id_buf, sizeof(id_buf), "http_res_%ld", next_writer_id++);
+    free(writer->id);
+    writer->id = strdup(id_buf);
+    writer->status_code = 200;
+    writer->headers_sent = false;
+    writer->ended = false;
+    writer->sse = false;
+    writer->waiting_drain = false;
+    value_free(&writer->on_drain);
+    writer->on_drain = make_null();
+    if (writer->zs) {
+        deflateEnd(writer->zs);
+        free(writer->zs);
+        writer->zs = NULL;
+    }
+}
+
+// Called when the connection goes away; the handle string stops resolving.
+static void http_writer_detach(HttpResponseWriter* writer) {
+    if (!writer) return;
+    HttpResponseWriter** cur = &http_writers;
+    while (*cur && *cur != writer) {
+        cur = &(*cur)->next;
+    }
+    if (*cur == writer) {
+        *cur = writer->next;
+    }
+    value_free(&writer->on_drain);
+    if (writer->zs) {
+        deflateEnd(writer->zs);
+        free(writer->zs);
+    }
+    free(writer->id);
+    free(writer);
+}
+
+static bool http_writer_send_head(HttpResponseWriter* writer, int status, const char* content_type) {
+    if (!writer->client || writer->headers_sent) return false;
+    HttpResponse* resp = http_response_create(NULL, status, NULL);
+    http_response_add_header(resp, "Content-Type", content_type ? content_type : "text/plain");
+    http_response_add_header(resp, "Transfer-Encoding", "chunked");
+    if (writer->sse) {
+        http_response_add_header(resp, "Cache-Control", "no-cache");
+    }
+    // Each chunk is deflated with Z_SYNC_FLUSH so the client can decode it
+    // as soon as it arrives (important for SSE).
+    if (writer->accept_encoding != HTTP_ENC_NONE && http_is_compressible(content_type)) {
+        writer->zs = malloc(sizeof(z_stream));
+        if (http_deflate_init(writer->zs, (HttpEncoding)writer->accept_encoding) == Z_OK) {
+            http_response_mark_encoded(resp, (HttpEncoding)writer->accept_encoding);
+        } else {
+            free(writer->zs);
+            writer->zs = NULL;
+        }
+    }
+    TcpHandleCtx* ctx = writer->client->data;
+    size_t head_len = 0;
+    char* head = http_response_build_head(resp, ctx && ctx->http_keep_alive, &head_len);
+    http_response_free(resp);
+    if (!head) return false;
+
+    HttpWriteReq* wr = calloc(1, sizeof(HttpWriteReq));
+    wr->head = head;
+    wr->common = http_common_headers_acquire();
+    wr->writer = writer;
+    uv_buf_t bufs[2];
+    bufs[0] = uv_buf_init(head, (unsigned int)head_len);
+    bufs[1] = wr->common ? uv_buf_init(wr->common->data, (unsigned int)wr->common->len) : uv_buf_init("\r\n", 2);
+    writer->status_code = status;
+    writer->headers_sent = true;
+    return http_write_bufs(writer->client, wr, bufs, 2);
+}
+
+// Runs a chunk through the response's deflate stream. Takes ownership of data.
+static char* http_writer_deflate(HttpResponseWriter* writer, char* data, size_t len, bool last, size_t* out_len) {
+    z_stream* zs = writer->zs;
+    size_t cap = deflateBound(zs, (uLong)len) + 64;
+    char* out = malloc(cap);
+    size_t used = 0;
+    zs->next_in = (Bytef*)(data ? data : "");
+    zs->avail_in = (uInt)len;
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    for (;;) {
+        if (cap - used < 64) {
+            cap *= 2;
+            out = realloc(out, cap);
+        }
+        zs->next_out = (Bytef*)out + used;
+        zs->avail_out = (uInt)(cap - used);
+        int r = deflate(zs, flush);
+        used = cap - zs->avail_out;
+        if (r == Z_STREAM_ERROR || r == Z_STREAM_END) break;
+        if (!last && zs->avail_in == 0 && zs->avail_out > 0) break;
+    }
+    free(data);
+    if (last) {
+        deflateEnd(zs);
+        free(zs);
+        writer->zs = NULL;
+    }
+    *out_len = used;
+    return out;
+}
+
+// Queue one chunk (data may be NULL for the terminating chunk only). Takes
+// ownership of data. Returns false once the write queue is above the high
+// water mark; the handler should then wait for res.on_drain.
+static bool http_writer_send_chunk(HttpResponseWriter* writer, char* data, size_t len, bool last) {
+    if (!writer->client || writer->ended) {
+        free(data);
+        return false;
+    }
+    if (writer->zs && ((data && len > 0) || last)) {
+        data = http_writer_deflate(writer, data, data ? len : 0, last, &len);
+    }
+    HttpWriteReq* wr = calloc(1, sizeof(HttpWriteReq));
+    wr->body = data;
+    wr->writer = writer;
+    TcpHandleCtx* ctx = writer->client->data;
+    wr->close_after = last && !(ctx && ctx->http_keep_alive);
+    wr->last = last;
+    uv_buf_t bufs[4];
+    unsigned int nbufs = 0;
+    if (data && len > 0) {
+        int plen = snprintf(wr->chunk_prefix, sizeof(wr->chunk_prefix), "%zx\r\n", len);
+        bufs[nbufs++] = uv_buf_init(wr->chunk_prefix, (unsigned int)plen);
+        bufs[nbufs++] = uv_buf_init(data, (unsigned int)len);
+        bufs[nbufs++] = uv_buf_init("\r\n", 2);
+    }
+    if (last) {
+        bufs[nbufs++] = uv_buf_init("0\r\n\r\n", 5);
+        writer->ended = true;
+    }
+    if (nbufs == 0) {
+        http_write_req_free(wr);
+        return true;
+    }
+    uv_stream_t* client = writer->client;
+    if (!http_write_bufs(client, wr, bufs, nbufs)) return false;
+    if (last) return true;
+    if (uv_stream_get_write_queue_size(client) > HTTP_STREAM_HIGH_WATER) {
+        writer->waiting_drain = true;
+        return false;
+    }
+    return true;
+}
+
+// What a route handler returned: [status, body, content_type], a body
+// string, or anything else (a 500).
+typedef struct HttpHandlerResult {
+    int status;
+    const char* status_text;
+    const char* content_type;    // points into the handler's value
+    char* body;                  // owned
+    size_t body_length;
+} HttpHandlerResult;
+
+// NUL-terminated copy of a bytes value, for bodies that must outlive it.
+static char* bytes_body_copy(const Value* v, size_t* len_out) {
+    const unsigned char* data = value_bytes(v, len_out);
+    char* out = malloc(*len_out + 1);
+    if (*len_out) memcpy(out, data, *len_out);
+    out[*len_out] = '\0';
+    return out;
+}
+
+static void http_handler_result(Value* resp_val, HttpHandlerResult* out) {
+    out->status = 200;
+    out->status_text = "OK";
+    out->content_type = "text/plain";
+    out->body = NULL;
+    out->body_length = 0;
+
+    // Bodies are moved out of the returned value when nothing else references
+    // it; shared arrays (e.g. a response tuple kept in a variable) are copied.
+    if (resp_val->type == VAL_ARRAY && resp_val->array_val && resp_val->array_val->count >= 2) {
+        Value code = resp_val->array_val->items[0];
+        Value* body_val = &resp_val->array_val->items[1];
+        Value ctype_val = resp_val->array_val->count >= 3 ? resp_val->array_val->items[2] : make_null();
+        if (code.type == VAL_INT) {
+            out->status = (int)code.int_val;
+            out->status_text = http_status_text(out->status);
+        }
+        if (body_val->type == VAL_STRING && body_val->string_val) {
+            out->body_length = strlen(body_val->string_val);
+            if (resp_val->array_val->refcount == 1) {
+                out->body = body_val->string_val;
+                body_val->string_val = NULL;
+            } else {
+                out->body = strdup(body_val->string_val);
+            }
+        } else if (body_val->type == VAL_BYTES) {
+            out->body = bytes_body_copy(body_val, &out->body_length);
+            out->content_type = "application/octet-stream";
+        }
+        if (ctype_val.type == VAL_STRING && ctype_val.string_val) {
+            out->content_type = ctype_val.string_val;
+        }
+    } else if (resp_val->type == VAL_STRING && resp_val->string_val) {
+        out->body_length = strlen(resp_val->string_val);
+        out->body = resp_val->string_val;
+        resp_val->string_val = NULL;
+    } else if (resp_val->type == VAL_BYTES) {
+        out->body = bytes_body_copy(resp_val, &out->body_length);
+        out->content_type = "application/octet-stream";
+    } else {
+        out->status = 500;
+        out->status_text = "Internal Server Error";
+        out->body = strdup("Internal Error");
+        out->body_length = strlen(out->body);
+    }
+}
+
+// An async handler finished: send what it returned, unless it already
+// streamed its own response or the client is gone.
+static void http_async_handler_done(Value* result, void* user) {
+    char* writer_id = user;
+    HttpResponseWriter* writer = http_writer_find(writer_id);
+    free(writer_id);
+    if (!writer || !writer->client || writer->headers_sent || writer->ended) return;
+    HttpHandlerResult out;
+    http_handler_result(result, &out);
+    HttpResponse* resp = http_response_create(NULL, out.status, out.status_text);
+    http_response_take_body(resp, out.body, out.body_length, out.content_type);
+    http_response_compress(resp, (HttpEncoding)writer->accept_encoding, out.content_type);
+    writer->headers_sent = true;
+    writer->ended = true;
+    http_send_response(writer->client, resp);
+    http_response_free(resp);
 }
 
-static void http_handle_request(uv_stream_t* client, const char* data, ssize_t len) {
+static void http_handle_request(uv_stream_t* client, char* data, ssize_t len) {
     if (len <= 0 || !data) {
         fprintf(stderr, "[NET] http_handle_request early exit len=%zd data=%p\n", (size_t)len, (void*)data);
         return;
@@ -1659,21 +2985,38 @@ static void http_handle_request(uv_stream_t* client, const char* data, ssize_t l
     if (!reg) {
         fprintf(stderr, "[NET] http_handle_request missing route registry\n");
     }
-    HttpRequest* req = http_request_parse(data, len);
+    Arena* arena = ctx->arena;
+    HttpRequest* req = http_request_parse(arena, data, (size_t)len);
     HttpResponse* resp = NULL;
+    ctx->http_keep_alive = req && http_request_keep_alive(req);
     if (!req) {
-        resp = http_response_create(400, "Bad Request");
+        resp = http_response_create(arena, 400, "Bad Request");
         http_response_set_body(resp, "Bad Request", "text/plain");
         http_send_response(client, resp);
-        http_request_free(req);
+        http_response_free(resp);
+        return;
+    }
+    // WebSocket upgrades leave net entirely: a ws.route() hub adopts the socket.
+    const char* upgrade = http_request_get_header(req, "Upgrade");
+    if (upgrade && strcasecmp(upgrade, "websocket") == 0 && websocket_has_route(req->path)) {
+        if (websocket_adopt(client, req->path,
+                            http_request_get_header(req, "Sec-WebSocket-Key"),
+                            http_request_get_header(req, "Sec-WebSocket-Version"),
+                            http_request_get_header(req, "Sec-WebSocket-Extensions"),
+                            req->body, req->body ? req->body_length : 0)) {
+            ctx->upgraded = true;
+            return;
+        }
+        resp = http_response_create(arena, 400, "Bad Request");
+        http_response_set_body(resp, "Invalid WebSocket handshake", "text/plain");
+        http_send_response(client, resp);
         http_response_free(resp);
         return;
     }
     if (!reg) {
-        resp = http_response_create(500, "Internal Server Error");
+        resp = http_response_create(arena, 500, "Internal Server Error");
         http_response_set_body(resp, "No route registry", "text/plain");
         http_send_response(client, resp);
-        http_request_free(req);
         http_response_free(resp);
         return;
     }
@@ -1685,87 +3028,124 @@ static void http_handle_request(uv_stream_t* client, const char* data, ssize_t l
         const char* remainder = req->path + strlen(prefix);
         if (*remainder == '/') remainder++;
         if (path_has_parent_ref(remainder)) {
-            resp = http_response_create(403, "Forbidden");
+            resp = http_response_create(arena, 403, "Forbidden");
             http_response_set_body(resp, "Forbidden", "text/plain");
             http_send_response(client, resp);
-            http_request_free(req);
             http_response_free(resp);
             return;
         }
         char fullpath[PATH_MAX];
         if (snprintf(fullpath, sizeof(fullpath), "%s/%s", static_route->static_dir ? static_route->static_dir : ".", remainder) >= (int)sizeof(fullpath)) {
-            resp = http_response_create(414, "URI Too Long");
+            resp = http_response_create(arena, 414, "URI Too Long");
             http_response_set_body(resp, "Path too long", "text/plain");
             http_send_response(client, resp);
-            http_request_free(req);
             http_response_free(resp);
             return;
         }
         struct stat st;
         if (stat(fullpath, &st) != 0 || !S_ISREG(st.st_mode)) {
-            resp = http_response_create(404, "Not Found");
+            resp = http_response_create(arena, 404, "Not Found");
             http_response_set_body(resp, "Not Found", "text/plain");
             http_send_response(client, resp);
-            http_request_free(req);
+            http_response_free(resp);
+            return;
+        }
+        const char* mime = guess_mime(fullpath);
+        HttpEncoding enc = http_negotiate_encoding(http_request_get_header(req, "Accept-Encoding"));
+        bool compressible = enc != HTTP_ENC_NONE && http_is_compressible(mime) &&
+                            (size_t)st.st_size >= compress_min_size;
+        HttpCachedBody* cached = compressible ? static_cache_lookup(fullpath, &st, enc) : NULL;
+        if (cached) {
+            resp = http_response_create(arena, 200, "OK");
+            http_response_share_body(resp, cached, mime);
+            http_send_response(client, resp);
             http_response_free(resp);
             return;
         }
         FILE* f = fopen(fullpath, "rb");
         if (!f) {
-            resp = http_response_create(500, "Internal Server Error");
+            resp = http_response_create(arena, 500, "Internal Server Error");
             http_response_set_body(resp, "Failed to read file", "text/plain");
             http_send_response(client, resp);
-            http_request_free(req);
             http_response_free(resp);
             return;
         }
         char* buf = malloc((size_t)st.st_size + 1);
         if (!buf) {
             fclose(f);
-            resp = http_response_create(500, "Internal Server Error");
+            resp = http_response_create(arena, 500, "Internal Server Error");
             http_response_set_body(resp, "OOM", "text/plain");
             http_send_response(client, resp);
-            http_request_free(req);
             http_response_free(resp);
             return;
         }
         size_t readn = fread(buf, 1, (size_t)st.st_size, f);
         fclose(f);
         buf[readn] = '\0';
-        resp = http_response_create(200, "OK");
-        http_response_set_body(resp, buf, guess_mime(fullpath));
-        free(buf);
+        resp = http_response_create(arena, 200, "OK");
+        size_t encoded_len = 0;
+        char* encoded = compressible ? http_compress(enc, buf, readn, &encoded_len) : NULL;
+        if (encoded && encoded_len < readn) {
+            free(buf);
+            http_response_share_body(resp, static_cache_store(fullpath, &st, enc, encoded, encoded_len), mime);
+        } else {
+            free(encoded);
+            http_response_take_body(resp, buf, readn, mime);
+        }
         http_send_response(client, resp);
-        http_request_free(req);
         http_response_free(resp);
         return;
     }
 
     // Try to find route with parameter matching
     RouteParams* params = NULL;
-    RouteNode* route = route_registry_find_with_params(reg, req->path, req->method, &params);
+    RouteNode* route = route_registry_find_with_params(reg, arena, req->path, req->method, &params);
     if (!route) {
-        resp = http_response_create(404, "Not Found");
+        resp = http_response_create(arena, 404, "Not Found");
         http_response_set_body(resp, "Not Found", "text/plain");
         http_send_response(client, resp);
-        http_request_free(req);
         http_response_free(resp);
         return;
     }
 
-    // Build request object with path, method, body, query, params, headers, cookies
-    Value args[7];
+    if (route->native) {
+        if (params) route_params_free(params);
+        int status = 200;
+        const char* content_type = "text/plain";
+        size_t body_length = 0;
+        char* body = route->native(route->native_user, req->method, req->query_string,
+                                   req->body, req->body ? req->body_length : 0,
+                                   &status, &content_type, &body_length);
+        resp = http_response_create(arena, status, status == 200 ? "OK" : status == 400 ? "Bad Request" : "Error");
+        if (body) {
+            http_response_take_body(resp, body, body_length, content_type);
+            http_response_compress(resp, http_negotiate_encoding(http_request_get_header(req, "Accept-Encoding")), content_type);
+        } else {
+            http_response_set_body(resp, "", content_type);
+        }
+        http_send_response(client, resp);
+        http_response_free(resp);
+        return;
+    }
+
+    // Build request object with path, method, body, query, params, headers, cookies, res
+    Value args[8];
     args[0] = make_string(req->path);
     args[1] = make_string(req->method ? req->method : "");
-    args[2] = req->body ? make_string(req->body) : make_null();
+    // Bodies with NUL bytes (uploads, protobuf) arrive as bytes.
+    if (req->body && memchr(req->body, '\0', req->body_length)) {
+        args[2] = make_bytes(req->body, req->body_length);
+    } else {
+        args[2] = req->body ? make_string(req->body) : make_null();
+    }
     args[3] = req->query_string ? make_string(req->query_string) : make_null();
 
     // args[4] = params object (as array of key-value pairs)
     if (params && params->count > 0) {
         Array* params_arr = array_create(params->count * 2);
         for (int i = 0; i < params->count; i++) {
-            array_push(params_arr, make_string(params->keys[i]));
-            array_push(params_arr, make_string(params->values[i]));
+            array_push_owned(params_arr, make_string(params->keys[i]));
+            array_push_owned(params_arr, make_string(params->values[i]));
         }
         args[4].type = VAL_ARRAY;
         args[4].array_val = params_arr;
@@ -1777,8 +3157,8 @@ static void http_handle_request(uv_stream_t* client, const char* data, ssize_t l
     if (req->header_count > 0) {
         Array* headers_arr = array_create(req->header_count * 2);
         for (int i = 0; i < req->header_count; i++) {
-            array_push(headers_arr, make_string(req->header_names[i]));
-            array_push(headers_arr, make_string(req->header_values[i]));
+            array_push_owned(headers_arr, make_string(req->header_names[i]));
+            array_push_owned(headers_arr, make_string(req->header_values[i]));
         }
         args[5].type = VAL_ARRAY;
         args[5].array_val = headers_arr;
@@ -1789,55 +3169,58 @@ static void http_handle_request(uv_stream_t* client, const char* data, ssize_t l
     // args[6] = cookies (parse from Cookie header)
     const char* cookie_header = http_request_get_header(req, "Cookie");
     args[6] = cookie_header ? make_string(cookie_header) : make_null();
+
+    // args[7] = response writer for streaming (res.write / res.end / res.sse)
+    if (!ctx->writer) {
+        ctx->writer = http_writer_create(client);
+    } else {
+        http_writer_reset(ctx->writer);
+    }
+    HttpResponseWriter* writer = ctx->writer;
+    writer->accept_encoding = http_negotiate_encoding(http_request_get_header(req, "Accept-Encoding"));
+    args[7] = make_string(writer->id);
     if (route->handler.type != VAL_FUNCTION) {
         fprintf(stderr, "[NET] handler not function\n");
-        resp = http_response_create(500, "Internal Server Error");
+        for (int i = 0; i < 8; i++) value_free(&args[i]);
+        if (params) route_params_free(params);
+        resp = http_response_create(arena, 500, "Internal Server Error");
         http_response_set_body(resp, "Handler invalid", "text/plain");
         http_send_response(client, resp);
-        http_request_free(req);
         http_response_free(resp);
         return;
     }
     fprintf(stderr, "[NET] executing handler path=%s method=%s params=%d\n",
             req->path, req->method ? req->method : "", params ? params->count : 0);
-    Value resp_val = interpreter_execute_callback(route->handler, 7, args);
-    for (int i = 0; i < 7; i++) value_free(&args[i]);
+    Value resp_val = interpreter_execute_callback(route->handler, 8, args);
+    for (int i = 0; i < 8; i++) value_free(&args[i]);
     if (params) route_params_free(params);
 
-    int status = 200;
-    const char* status_text = "OK";
-    const char* content_type = "text/plain";
-    char* body = NULL;
+    // An async handler still waiting on I/O answers when its task finishes.
+    char* writer_id = strdup(writer->id);
+    if (interpreter_task_defer(&resp_val, http_async_handler_done, writer_id)) {
+        return;
+    }
+    free(writer_id);
 
-    if (resp_val.type == VAL_ARRAY && resp_val.array_val && resp_val.array_val->count >= 2) {
-        Value code = resp_val.array_val->items[0];
-        Value body_val = resp_val.array_val->items[1];
-        Value ctype_val = resp_val.array_val->count >= 3 ? resp_val.array_val->items[2] : make_null();
-        if (code.type == VAL_INT) {
-            status = (int)code.int_val;
-        }
-        if (body_val.type == VAL_STRING && body_val.string_val) {
-            body = strdup(body_val.string_val);
-        }
-        if (ctype_val.type == VAL_STRING && ctype_val.string_val) {
-            content_type = ctype_val.string_val;
-        }
-    } else if (resp_val.type == VAL_STRING && resp_val.string_val) {
-        body = strdup(resp_val.string_val);
-    } else {
-        status = 500;
-        status_text = "Internal Server Error";
-        body = strdup("Internal Error");
+    // A handler that started streaming owns the response from here on; the
+    // connection stays open until res.end() or the client disconnects.
+    if (writer->headers_sent || writer->ended) {
+        value_free(&resp_val);
+        return;
     }
 
-    resp = http_response_create(status, status_text);
-    http_response_set_body(resp, body ? body : "", content_type);
+    HttpHandlerResult out;
+    http_handler_result(&resp_val, &out);
+    resp = http_response_create(arena, out.status, out.status_text);
+    http_response_take_body(resp, out.body, out.body_length, out.content_type);
+    http_response_compress(resp, http_negotiate_encoding(http_request_get_header(req, "Accept-Encoding")), out.content_type);
+    // The returned value is the whole response; res handles go quiet.
+    writer->headers_sent = true;
+    writer->ended = true;
     http_send_response(client, resp);
 
-    free(body);
     value_free(&resp_val);
 
-    http_request_free(req);
     http_response_free(resp);
 }
 
@@ -1915,6 +3298,24 @@ Value native_net_route(struct Interpreter* interp, int argc, Value* args) {
     return make_bool(ok);
 }
 
+bool net_route_native(const char* server, const char* path, const char* method,
+                      NetNativeHandler fn, void* user) {
+    TcpHandleCtx* ctx = server ? find_tcp_ctx(server) : NULL;
+    if (!ctx || !ctx->is_listener || !ctx->is_http || !path || !fn) {
+        fprintf(stderr, "⚠️ Net Error: Unknown or non-http server handle\n");
+        return false;
+    }
+    if (!ctx->data) {
+        ctx->data = route_registry_create();
+        ctx->data_owner = true;
+    }
+    RouteRegistry* reg = (RouteRegistry*)ctx->data;
+    if (!route_registry_add(reg, path, method, make_null())) return false;
+    reg->head->native = fn;
+    reg->head->native_user = user;
+    return true;
+}
+
 // Register a static prefix to directory mapping.
 Value native_net_static(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
@@ -2030,6 +3431,7 @@ Value native_net_tcp_connect(struct Interpreter* interp, int argc, Value* args)
         return make_null();
     }
     TcpHandleCtx* ctx = register_tcp_ctx(interp, &client->handle, "tcp_client", false, false, false, NULL);
+    ctx->connecting = true;
 
     struct sockaddr_in dest;
     uv_ip4_addr(host, port, &dest);
@@ -2049,32 +3451,112 @@ Value native_net_tcp_connect(struct Interpreter* interp, int argc, Value* args)
     return make_string(ctx->id);
 }
 
+// Waits (suspending the current task, if any) until ready(ctx) holds or the
+// socket is gone. Callbacks may free the context, so it is looked up again
+// after every turn; they wake waiters through the socket's id.
+static TcpHandleCtx* tcp_wait(const char* id, bool (*ready)(TcpHandleCtx*, void*), void* arg) {
+    TcpHandleCtx* ctx = find_tcp_ctx(id);
+    while (ctx && !ready(ctx, arg)) {
+        tcp_read_resume(ctx);
+        // Nothing left on the loop that could make progress.
+        if (!interpreter_wait(id)) return NULL;
+        ctx = find_tcp_ctx(id);
+    }
+    return ctx;
+}
+
+static bool tcp_connected(TcpHandleCtx* ctx, void* arg) {
+    (void)arg;
+    return !ctx || !ctx->connecting;
+}
+
+static bool tcp_has_bytes(TcpHandleCtx* ctx, void* arg) {
+    return !ctx || ctx->eof || ctx->closing || ctx->rx.len >= *(size_t*)arg;
+}
+
+static bool tcp_has_client(TcpHandleCtx* ctx, void* arg) {
+    (void)arg;
+    return !ctx || ctx->recv_queue != NULL;
+}
+
+typedef struct TcpDelimSearch {
+    const char* delim;
+    size_t delim_len;
+    size_t scanned;          // bytes already known not to start a match
+    const char* found;
+} TcpDelimSearch;
+
+static bool tcp_has_delim(TcpHandleCtx* ctx, void* arg) {
+    TcpDelimSearch* search = arg;
+    if (!ctx) return true;
+    const char* data = ctx->rx.data ? ctx->rx.data + ctx->rx.head : NULL;
+    search->found = NULL;
+    if (data && ctx->rx.len >= search->delim_len) {
+        search->found = memmem(data + search->scanned, ctx->rx.len - search->scanned,
+                               search->delim, search->delim_len);
+        if (search->found) return true;
+        search->scanned = ctx->rx.len - search->delim_len + 1;
+    }
+    ctx->rx_want = ctx->rx.len + 1;
+    return ctx->eof || ctx->closing;
+}
+
+// Takes len buffered bytes as a string or bytes value.
+static Value tcp_take(TcpHandleCtx* ctx, size_t len, size_t skip, bool as_bytes) {
+    char* out = malloc(len + 1);
+    if (len) memcpy(out, ctx->rx.data + ctx->rx.head, len);
+    out[len] = '\0';
+    tcp_rx_consume(&ctx->rx, len + skip);
+    ctx->rx_want = 0;
+    tcp_read_resume(ctx);
+    if (as_bytes) return make_bytes_owned((unsigned char*)out, len, len + 1);
+    return (Value){ .type = VAL_STRING, .string_val = out };
+}
+
+// net.send(sock, data) -> bool. data is a string or bytes. Written in
+// place when the socket accepts it straight away; otherwise a string is
+// queued itself, and only the unwritten rest of bytes is copied.
 Value native_net_send(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
-    if (argc < 2 || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
+    if (argc < 2 || args[0].type != VAL_STRING || (args[1].type != VAL_STRING && args[1].type != VAL_BYTES)) {
         fprintf(stderr, "⚠️ Net Error: Expected socket and data for send\n");
         return make_null();
     }
-    TcpHandleCtx* ctx = find_tcp_ctx(args[0].string_val);
+    TcpHandleCtx* ctx = tcp_wait(args[0].string_val, tcp_connected, NULL);
     if (!ctx) {
         fprintf(stderr, "⚠️ Net Error: Unknown handle\n");
         return make_bool(false);
     }
-    uv_write_t* req = malloc(sizeof(uv_write_t));
-    uv_buf_t buf = uv_buf_init(strdup(args[1].string_val), (unsigned int)strlen(args[1].string_val));
-    req->data = buf.base;
-    int r = uv_write(req, (uv_stream_t*)ctx->handle, &buf, 1, on_write);
-    if (r != 0) {
-        fprintf(stderr, "uv_write error: %s\n", uv_strerror(r));
-        free(buf.base);
-        free(req);
+    if (ctx->shut || ctx->closing || ctx->is_listener) return make_bool(false);
+    size_t len = 0;
+    const unsigned char* data = value_bytes(&args[1], &len);
+    uv_buf_t buf = uv_buf_init((char*)data, (unsigned int)len);
+    int written = len ? uv_try_write((uv_stream_t*)ctx->handle, &buf, 1) : 0;
+    if (written < 0 && written != UV_EAGAIN) {
+        fprintf(stderr, "uv_write error: %s\n", uv_strerror(written));
+        return make_bool(false);
+    }
+    if (written < 0) written = 0;
+    if ((size_t)written == len) return make_bool(true);
+    char* owned;
+    char* start;
+    if (args[1].type == VAL_STRING) {
+        owned = args[1].string_val;
+        start = owned + written;
+        args[1] = make_null();
+    } else {
+        owned = malloc(len - (size_t)written);
+        memcpy(owned, data + written, len - (size_t)written);
+        start = owned;
+    }
+    if (!tcp_write_owned(ctx, owned, start, len - (size_t)written, on_write)) {
+        free(owned);
         return make_bool(false);
     }
     return make_bool(true);
 }
 
-Value native_net_recv(struct Interpreter* interp, int argc, Value* args) {
-    (void)interp;
+static Value tcp_recv(int argc, Value* args, bool as_bytes) {
     if (argc < 1 || args[0].type != VAL_STRING) {
         fprintf(stderr, "⚠️ Net Error: Expected socket for recv\n");
         return make_null();
@@ -2084,7 +3566,111 @@ Value native_net_recv(struct Interpreter* interp, int argc, Value* args) {
         fprintf(stderr, "⚠️ Net Error: Unknown handle\n");
         return make_null();
     }
-    return buffer_pop(&ctx->recv_queue);
+    if (ctx->is_listener) {
+        ctx = tcp_wait(args[0].string_val, tcp_has_client, NULL);
+        return ctx ? buffer_pop(&ctx->recv_queue) : make_null();
+    }
+    if (ctx->piped) return make_null();
+    size_t want = 1;
+    if (argc >= 2 && args[1].type == VAL_INT && args[1].int_val > 0) want = (size_t)args[1].int_val;
+    ctx->rx_want = want;
+    ctx = tcp_wait(args[0].string_val, tcp_has_bytes, &want);
+    if (!ctx) return make_null();
+    if (ctx->rx.len == 0) {
+        ctx->rx_want = 0;
+        if (ctx->eof) tcp_close(ctx);
+        return make_null();
+    }
+    size_t take = ctx->rx.len;
+    if (argc >= 2 && want < take) take = want;
+    return tcp_take(ctx, take, 0, as_bytes);
+}
+
+// net.recv(sock, [n]) -> string or null. Blocks until data arrives; with n,
+// until exactly n bytes are buffered (fewer only at end of stream). Returns
+// null once the peer has closed and everything was read. On a listener,
+// returns the next accepted connection.
+Value native_net_recv(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    return tcp_recv(argc, args, false);
+}
+
+// net.recv_bytes(sock, [n]) -> bytes or null. Like recv, for binary data.
+Value native_net_recv_bytes(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    return tcp_recv(argc, args, true);
+}
+
+// net.recv_until(sock, delim) -> string or null. Blocks until delim arrives
+// and returns everything before it; the delimiter is consumed. Returns null
+// if the stream ends first (the unterminated tail stays readable by recv).
+Value native_net_recv_until(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 2 || args[0].type != VAL_STRING || args[1].type != VAL_STRING || !args[1].string_val[0]) {
+        fprintf(stderr, "⚠️ Net Error: Expected socket and delimiter for recv_until\n");
+        return make_null();
+    }
+    TcpHandleCtx* ctx = find_tcp_ctx(args[0].string_val);
+    if (!ctx || ctx->is_listener || ctx->piped) {
+        fprintf(stderr, "⚠️ Net Error: Unknown handle\n");
+        return make_null();
+    }
+    TcpDelimSearch search = { args[1].string_val, strlen(args[1].string_val), 0, NULL };
+    ctx = tcp_wait(args[0].string_val, tcp_has_delim, &search);
+    if (!ctx || !search.found) {
+        if (ctx) {
+            ctx->rx_want = 0;
+            if (ctx->eof && ctx->rx.len == 0) tcp_close(ctx);
+        }
+        return make_null();
+    }
+    size_t len = (size_t)(search.found - (ctx->rx.data + ctx->rx.head));
+    return tcp_take(ctx, len, search.delim_len, false);
+}
+
+// net.pipe(from, to) -> bool. Forwards everything read on from to to inside
+// the event loop, reusing the read buffers for the writes. End of stream on
+// from shuts down to's write side; pipe both ways for a full proxy.
+Value native_net_pipe(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 2 || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
+        fprintf(stderr, "⚠️ Net Error: Expected two sockets for pipe\n");
+        return make_bool(false);
+    }
+    TcpHandleCtx* from = find_tcp_ctx(args[0].string_val);
+    TcpHandleCtx* to = find_tcp_ctx(args[1].string_val);
+    if (!from || !to || from == to || from->is_listener || to->is_listener || from->is_http ||
+        to->is_http || from->piped || to->pipe_from) {
+        fprintf(stderr, "⚠️ Net Error: Cannot pipe these handles\n");
+        return make_bool(false);
+    }
+    if (from->rx.len) {
+        char* pending = malloc(from->rx.len);
+        memcpy(pending, from->rx.data + from->rx.head, from->rx.len);
+        if (!tcp_write_owned(to, pending, pending, from->rx.len, on_write)) free(pending);
+        tcp_rx_consume(&from->rx, from->rx.len);
+    }
+    from->rx_want = 0;
+    from->piped = true;
+    from->pipe_to = to;
+    to->pipe_from = from;
+    if (from->eof) {
+        tcp_shutdown(to);
+        if (from->shut) tcp_close(from);
+    } else {
+        tcp_read_resume(from);
+    }
+    return make_bool(true);
+}
+
+// net.close(sock) -> bool
+Value native_net_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) return make_bool(false);
+    TcpHandleCtx* ctx = find_tcp_ctx(args[0].string_val);
+    if (!ctx || ctx->is_http) return make_bool(false);
+    tcp_close(ctx);
+    return make_bool(true);
 }
 
 Value native_net_rest_get(struct Interpreter* interp, int argc, Value* args) {
@@ -2161,33 +3747,153 @@ Value native_net_form_parse(struct Interpreter* interp, int argc, Value* args) {
     return v;
 }
 
-// net.template_render(template_string, vars_array) -> rendered string
-// vars_array should be [key1, val1, key2, val2, ...]
+// Rendered pages go through one buffer that keeps its capacity.
+static _Thread_local TemplateBuffer template_out = { NULL, 0, 0 };
+
+static Value render_template(const RadsTemplate* tpl, int argc, Value* args) {
+    template_render_into(tpl, argc >= 2 ? &args[1] : NULL, &template_out);
+    template_release(tpl);
+    Value v = { .type = VAL_STRING };
+    v.string_val = strndup(template_out.data, template_out.len);
+    return v;
+}
+
+// net.template_render(template_string, vars) -> rendered string
+// vars is a struct or [key1, val1, key2, val2, ...]; see stdlib_template.h
+// for the syntax. Compiled templates are cached by their text.
 Value native_net_template_render(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
     if (argc < 1 || args[0].type != VAL_STRING) {
         return make_string("");
     }
-    if (argc < 2) {
-        return make_string(args[0].string_val);
+    char error[160];
+    const RadsTemplate* tpl = template_cache_text(args[0].string_val, error, sizeof(error));
+    if (!tpl) {
+        fprintf(stderr, "⚠️ Net Error: template: %s\n", error);
+        return make_null();
     }
+    return render_template(tpl, argc, args);
+}
 
-    RouteParams* vars = route_params_create();
-    if (args[1].type == VAL_ARRAY && args[1].array_val) {
-        Array* arr = args[1].array_val;
-        for (size_t i = 0; i + 1 < arr->count; i += 2) {
-            if (arr->items[i].type == VAL_STRING && arr->items[i+1].type == VAL_STRING) {
-                route_params_add(vars, arr->items[i].string_val, arr->items[i+1].string_val);
-            }
-        }
+// net.render(path, vars) -> rendered string. The file is compiled on first
+// use and recompiled when it changes on disk.
+Value native_net_render(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) {
+        fprintf(stderr, "⚠️ Net Error: Expected template path for render\n");
+        return make_null();
+    }
+    char error[160];
+    const RadsTemplate* tpl = template_cache_file(args[0].string_val, error, sizeof(error));
+    if (!tpl) {
+        fprintf(stderr, "⚠️ Net Error: template: %s\n", error);
+        return make_null();
+    }
+    return render_template(tpl, argc, args);
+}
+
+// net.template_cache_stats() -> [hits, misses, cached_templates]
+Value native_net_template_cache_stats(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    (void)argc;
+    (void)args;
+    long long hits, misses;
+    int size;
+    template_cache_stats(&hits, &misses, &size);
+    Array* stats = array_create(3);
+    array_push_owned(stats, make_int(hits));
+    array_push_owned(stats, make_int(misses));
+    array_push_owned(stats, make_int(size));
+    Value v = { .type = VAL_ARRAY };
+    v.array_val = stats;
+    return v;
+}
+
+// Sessions (see stdlib_session.h). Values are stored as text.
+
+// net.session_start([ttl_seconds]) -> new session id
+Value native_net_session_start(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    session_store_attach(global_event_loop);
+    char id[SESSION_ID_LEN + 1];
+    session_store_create(id, argc >= 1 && args[0].type == VAL_INT ? (int)args[0].int_val : 0);
+    return id[0] ? make_string(id) : make_null();
+}
+
+// net.session_get(id, key) -> value or null; refreshes the session
+Value native_net_session_get(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 2 || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
+        return make_null();
+    }
+    char* value = session_store_get(args[0].string_val, args[1].string_val);
+    if (!value) return make_null();
+    Value v = { .type = VAL_STRING };
+    v.string_val = value;
+    return v;
+}
+
+// net.session_set(id, key, value) -> false if the session is gone
+Value native_net_session_set(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 3 || args[0].type != VAL_STRING || args[1].type != VAL_STRING) {
+        fprintf(stderr, "⚠️ Net Error: Expected session id, key and value for session_set\n");
+        return make_bool(false);
     }
+    char num[64];
+    const char* value = num;
+    switch (args[2].type) {
+        case VAL_STRING: value = args[2].string_val; break;
+        case VAL_INT: snprintf(num, sizeof(num), "%lld", args[2].int_val); break;
+        case VAL_FLOAT: snprintf(num, sizeof(num), "%g", args[2].float_val); break;
+        case VAL_BOOL: value = args[2].bool_val ? "true" : "false"; break;
+        default:
+            fprintf(stderr, "⚠️ Net Error: session values must be strings, numbers or booleans\n");
+            return make_bool(false);
+    }
+    return make_bool(session_store_set(args[0].string_val, args[1].string_val, value));
+}
+
+// net.session_exists(id) -> bool
+Value native_net_session_exists(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    return make_bool(argc >= 1 && args[0].type == VAL_STRING && session_store_exists(args[0].string_val));
+}
 
-    char* result = template_render(args[0].string_val, vars);
-    route_params_free(vars);
+// net.session_destroy(id) -> bool
+Value native_net_session_destroy(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    return make_bool(argc >= 1 && args[0].type == VAL_STRING && session_store_destroy(args[0].string_val));
+}
+
+// net.session_config(max_sessions, ttl_seconds, [sqlite_path])
+Value native_net_session_config(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    long long max = argc >= 1 && args[0].type == VAL_INT ? args[0].int_val : 0;
+    long long ttl = argc >= 2 && args[1].type == VAL_INT ? args[1].int_val : 0;
+    const char* path = argc >= 3 && args[2].type == VAL_STRING ? args[2].string_val : NULL;
+    char error[160];
+    if (!session_store_configure(max > 0 ? (size_t)max : 0, ttl > 0 ? (int)ttl : 0, path, error, sizeof(error))) {
+        fprintf(stderr, "⚠️ Net Error: session store: %s\n", error);
+        return make_bool(false);
+    }
+    session_store_attach(global_event_loop);
+    return make_bool(true);
+}
 
-    if (!result) return make_null();
-    Value v = make_string(result);
-    free(result);
+// net.session_stats() -> [active, expired, evicted]
+Value native_net_session_stats(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    (void)argc;
+    (void)args;
+    SessionStoreStats st;
+    session_store_stats(&st);
+    Array* stats = array_create(3);
+    array_push_owned(stats, make_int((long long)st.count));
+    array_push_owned(stats, make_int((long long)st.expired));
+    array_push_owned(stats, make_int((long long)st.evicted));
+    Value v = { .type = VAL_ARRAY };
+    v.array_val = stats;
     return v;
 }
 
@@ -2213,7 +3919,320 @@ Value native_net_param_get(struct Interpreter* interp, int argc, Value* args) {
 }
 
 
+// HTTP client (non-blocking)
+// Requests return a handle ("http_req_N") immediately. Results arrive as
+// callback(status, body, headers, error) or through req.wait().
+
+static HttpClientRequest* client_request_from_args(const char* method, Value* url, const char* fn) {
+    if (url->type != VAL_STRING) {
+        fprintf(stderr, "⚠️ Net Error: Expected URL for %s\n", fn);
+        return NULL;
+    }
+    if (strncasecmp(url->string_val, "https://", 8) == 0) {
+        fprintf(stderr, "⚠️ Net Error: %s does not support https yet: %s\n", fn, url->string_val);
+        return NULL;
+    }
+    HttpClientRequest* req = http_client_request_create(method, url->string_val);
+    if (!req) {
+        fprintf(stderr, "⚠️ Net Error: Invalid URL for %s: %s\n", fn, url->string_val);
+        return NULL;
+    }
+    return req;
+}
+
+static Value take_function_arg(int argc, Value* args, int index) {
+    if (index >= argc || args[index].type != VAL_FUNCTION) return make_null();
+    Value fn = args[index];
+    args[index] = make_null();
+    return fn;
+}
+
+// net.fetch(url, [callback], [on_chunk]) -> request handle
+Value native_net_fetch(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1) {
+        fprintf(stderr, "⚠️ Net Error: Expected URL for fetch\n");
+        return make_null();
+    }
+    HttpClientRequest* req = client_request_from_args("GET", &args[0], "fetch");
+    if (!req) return make_null();
+    http_client_request_add_header(req, "Connection", "keep-alive");
+    http_client_request_add_header(req, "Accept-Encoding", "gzip, deflate");
+    HttpFetch* f = fetch_start(req, take_function_arg(argc, args, 1), take_function_arg(argc, args, 2));
+    return make_string(f->id);
+}
+
+// net.request(method, url, [body], [headers], [callback], [on_chunk]) -> request handle
+// headers is [name1, value1, name2, value2, ...]
+Value native_net_request(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 2 || args[0].type != VAL_STRING) {
+        fprintf(stderr, "⚠️ Net Error: Expected method and URL for request\n");
+        return make_null();
+    }
+    HttpClientRequest* req = client_request_from_args(args[0].string_val, &args[1], "request");
+    if (!req) return make_null();
+    bool has_connection = false;
+    bool has_accept_encoding = false;
+    if (argc >= 4 && args[3].type == VAL_ARRAY && args[3].array_val) {
+        Array* arr = args[3].array_val;
+        for (size_t i = 0; i + 1 < arr->count; i += 2) {
+            if (arr->items[i].type == VAL_STRING && arr->items[i + 1].type == VAL_STRING) {
+                http_client_request_add_header(req, arr->items[i].string_val, arr->items[i + 1].string_val);
+                if (strcasecmp(arr->items[i].string_val, "Connection") == 0) has_connection = true;
+                if (strcasecmp(arr->items[i].string_val, "Accept-Encoding") == 0) has_accept_encoding = true;
+            }
+        }
+    }
+    if (!has_connection) {
+        http_client_request_add_header(req, "Connection", "keep-alive");
+    }
+    if (!has_accept_encoding) {
+        http_client_request_add_header(req, "Accept-Encoding", "gzip, deflate");
+    }
+    if (argc >= 3 && args[2].type == VAL_STRING) {
+        http_client_request_set_body(req, args[2].string_val);
+    }
+    HttpFetch* f = fetch_start(req, take_function_arg(argc, args, 4), take_function_arg(argc, args, 5));
+    return make_string(f->id);
+}
+
+// Runs the event loop until the request finishes; other requests keep
+// progressing meanwhile. The request is released once its result is taken.
+static Value fetch_wait(const char* id) {
+    HttpFetch* f = fetch_find(id);
+    while (f && !f->done) {
+        if (!interpreter_wait(id)) break;
+        f = fetch_find(id);
+    }
+    if (f && !f->done) return make_null();
+    if (!f) return make_null();
+    Value parts[4];
+    fetch_result_values(f, parts);
+    Array* result = array_create(4);
+    for (int i = 0; i < 4; i++) {
+        array_push_owned(result, parts[i]);
+    }
+    fetch_release(f);
+    return array_value(result);
+}
+
+// req.wait() -> [status, body, headers, error]
+Value native_net_req_wait(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) return make_null();
+    return fetch_wait(args[0].string_val);
+}
+
+// req.done() -> bool
+Value native_net_req_done(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) return make_bool(false);
+    HttpFetch* f = fetch_find(args[0].string_val);
+    return make_bool(!f || f->done);
+}
+
+// req.cancel() -> bool
+Value native_net_req_cancel(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) return make_bool(false);
+    HttpFetch* f = fetch_find(args[0].string_val);
+    if (!f || f->done) return make_bool(false);
+    fetch_fail(f, "request cancelled");
+    return make_bool(true);
+}
+
+// net.wait_all([req1, req2, ...]) -> array of [status, body, headers, error]
+Value native_net_wait_all(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_ARRAY || !args[0].array_val) {
+        fprintf(stderr, "⚠️ Net Error: wait_all expects an array of requests\n");
+        return make_null();
+    }
+    Array* reqs = args[0].array_val;
+    Array* results = array_create(reqs->count);
+    for (size_t i = 0; i < reqs->count; i++) {
+        Value r = reqs->items[i].type == VAL_STRING ? fetch_wait(reqs->items[i].string_val) : make_null();
+        array_push(results, r);
+        value_free(&r);
+    }
+    return array_value(results);
+}
+
+// net.client_config(max_per_host, [idle_timeout_sec], [timeout_ms]) -> bool
+Value native_net_client_config(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc >= 1 && args[0].type == VAL_INT && args[0].int_val > 0) {
+        client_max_per_host = (int)args[0].int_val;
+    }
+    if (argc >= 2 && args[1].type == VAL_INT && args[1].int_val >= 0) {
+        client_idle_timeout = (int)args[1].int_val;
+    }
+    if (argc >= 3 && args[2].type == VAL_INT && args[2].int_val >= 0) {
+        client_request_timeout = (int)args[2].int_val;
+    }
+    return make_bool(true);
+}
+
+// net.compression(enabled, [level 1-9], [min_size_bytes]) -> bool
+Value native_net_compression(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc >= 1 && args[0].type == VAL_BOOL) {
+        compress_enabled = args[0].bool_val;
+    }
+    if (argc >= 2 && args[1].type == VAL_INT) {
+        if (args[1].int_val < 1 || args[1].int_val > 9) {
+            fprintf(stderr, "⚠️ Net Error: compression level must be 1-9\n");
+            return make_bool(false);
+        }
+        compress_level = (int)args[1].int_val;
+    }
+    if (argc >= 3 && args[2].type == VAL_INT && args[2].int_val >= 0) {
+        compress_min_size = (size_t)args[2].int_val;
+    }
+    return make_bool(true);
+}
+
+// Streaming responses (v0.0.x)
+// Handlers receive `res` as their 8th argument; calling any of these on it
+// switches the route to a chunked response that outlives the handler call.
+
+static HttpResponseWriter* writer_arg(int argc, Value* args, const char* fn) {
+    if (argc < 1 || args[0].type != VAL_STRING) {
+        fprintf(stderr, "%s expects a response handle\n", fn);
+        return NULL;
+    }
+    HttpResponseWriter* writer = http_writer_find(args[0].string_val);
+    if (!writer || !writer->client) {
+        fprintf(stderr, "%s: response is closed\n", fn);
+        return NULL;
+    }
+    return writer;
+}
+
+// Move the string out of an argument without copying; eval_call frees args.
+static char* take_string_arg(Value* v, size_t* len_out) {
+    char* data = NULL;
+    if (v->type == VAL_STRING && v->string_val) {
+        data = v->string_val;
+        v->string_val = NULL;
+        v->type = VAL_NULL;
+    } else if (v->type == VAL_BYTES) {
+        return bytes_body_copy(v, len_out);
+    } else if (v->type == VAL_INT) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%lld", (long long)v->int_val);
+        data = strdup(buf);
+    } else if (v->type == VAL_FLOAT) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%g", v->float_val);
+        data = strdup(buf);
+    }
+    *len_out = data ? strlen(data) : 0;
+    return data;
+}
+
+// res.write_head(status, [content_type]) -> bool
+Value native_net_res_write_head(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    HttpResponseWriter* writer = writer_arg(argc, args, "res.write_head");
+    if (!writer) return make_bool(false);
+    int status = (argc >= 2 && args[1].type == VAL_INT) ? (int)args[1].int_val : 200;
+    const char* ctype = (argc >= 3 && args[2].type == VAL_STRING) ? args[2].string_val : "text/plain";
+    return make_bool(http_writer_send_head(writer, status, ctype));
+}
+
+// res.write(chunk) -> bool (false means "wait for on_drain before writing more")
+Value native_net_res_write(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    HttpResponseWriter* writer = writer_arg(argc, args, "res.write");
+    if (!writer || argc < 2) return make_bool(false);
+    if (!writer->headers_sent && !http_writer_send_head(writer, 200, "text/plain")) {
+        return make_bool(false);
+    }
+    size_t len = 0;
+    char* data = take_string_arg(&args[1], &len);
+    return make_bool(http_writer_send_chunk(writer, data, len, false));
+}
+
+// res.end([final_chunk]) -> bool
+Value native_net_res_end(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    HttpResponseWriter* writer = writer_arg(argc, args, "res.end");
+    if (!writer || writer->ended) return make_bool(false);
+    if (!writer->headers_sent && !http_writer_send_head(writer, 200, "text/plain")) {
+        return make_bool(false);
+    }
+    size_t len = 0;
+    char* data = argc >= 2 ? take_string_arg(&args[1], &len) : NULL;
+    return make_bool(http_writer_send_chunk(writer, data, len, true));
+}
+
+// res.sse(data, [event], [id]) -> bool
+// Sends one Server-Sent Event; the first call sends text/event-stream headers.
+Value native_net_res_sse(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    HttpResponseWriter* writer = writer_arg(argc, args, "res.sse");
+    if (!writer || argc < 2 || args[1].type != VAL_STRING) return make_bool(false);
+    if (!writer->headers_sent) {
+        writer->sse = true;
+        if (!http_writer_send_head(writer, 200, "text/event-stream")) return make_bool(false);
+    }
+    const char* event = (argc >= 3 && args[2].type == VAL_STRING) ? args[2].string_val : NULL;
+    const char* id = (argc >= 4 && args[3].type == VAL_STRING) ? args[3].string_val : NULL;
+    const char* data = args[1].string_val;
+
+    // Every line of the payload needs its own "data: " prefix.
+    size_t lines = 1;
+    for (const char* p = data; *p; p++) {
+        if (*p == '\n') lines++;
+    }
+    size_t cap = strlen(data) + lines * 7 + 16;
+    if (event) cap += strlen(event) + 8;
+    if (id) cap += strlen(id) + 5;
+    char* frame = malloc(cap);
+    size_t off = 0;
+    if (id) off += snprintf(frame + off, cap - off, "id: %s\n", id);
+    if (event) off += snprintf(frame + off, cap - off, "event: %s\n", event);
+    const char* line = data;
+    while (1) {
+        const char* nl = strchr(line, '\n');
+        size_t n = nl ? (size_t)(nl - line) : strlen(line);
+        memcpy(frame + off, "data: ", 6);
+        off += 6;
+        memcpy(frame + off, line, n);
+        off += n;
+        frame[off++] = '\n';
+        if (!nl) break;
+        line = nl + 1;
+    }
+    frame[off++] = '\n';
+    frame[off] = '\0';
+    return make_bool(http_writer_send_chunk(writer, frame, off, false));
+}
+
+// res.on_drain(callback) - called with `res` once the write queue drains
+// after res.write returned false.
+Value native_net_res_on_drain(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    HttpResponseWriter* writer = writer_arg(argc, args, "res.on_drain");
+    if (!writer || argc < 2 || args[1].type != VAL_FUNCTION) return make_bool(false);
+    value_free(&writer->on_drain);
+    writer->on_drain = args[1];
+    args[1] = make_null();
+    return make_bool(true);
+}
+
+// res.queue_size() -> bytes still waiting in the socket write queue
+Value native_net_res_queue_size(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    HttpResponseWriter* writer = writer_arg(argc, args, "res.queue_size");
+    if (!writer) return make_int(0);
+    return make_int((long long)uv_stream_get_write_queue_size(writer->client));
+}
+
 void stdlib_net_register(void) {
+    interpreter_on_main_return(tcp_close_all);
     register_native("net.http_server", native_net_http_server);
     register_native("net.route", native_net_route);
     register_native("net.static", native_net_static);
@@ -2224,6 +4243,10 @@ void stdlib_net_register(void) {
     register_native("net.tcp_connect", native_net_tcp_connect);
     register_native("net.send", native_net_send);
     register_native("net.recv", native_net_recv);
+    register_native("net.recv_bytes", native_net_recv_bytes);
+    register_native("net.recv_until", native_net_recv_until);
+    register_native("net.pipe", native_net_pipe);
+    register_native("net.close", native_net_close);
     register_native("net.rest_get", native_net_rest_get);
     register_native("net.rest_post", native_net_rest_post);
 
@@ -2233,5 +4256,35 @@ void stdlib_net_register(void) {
     register_native("net.form_get", native_net_form_get);
     register_native("net.form_parse", native_net_form_parse);
     register_native("net.template_render", native_net_template_render);
+    register_native("net.render", native_net_render);
+    register_native("net.template_cache_stats", native_net_template_cache_stats);
+    register_native("net.session_start", native_net_session_start);
+    register_native("net.session_get", native_net_session_get);
+    register_native("net.session_set", native_net_session_set);
+    register_native("net.session_exists", native_net_session_exists);
+    register_native("net.session_destroy", native_net_session_destroy);
+    register_native("net.session_config", native_net_session_config);
+    register_native("net.session_stats", native_net_session_stats);
     register_native("net.param_get", native_net_param_get);
+
+    // Streaming responses
+    register_native("net.res_write_head", native_net_res_write_head);
+    register_native("net.res_write", native_net_res_write);
+    register_native("net.res_end", native_net_res_end);
+    register_native("net.res_sse", native_net_res_sse);
+    register_native("net.res_on_drain", native_net_res_on_drain);
+    register_native("net.res_queue_size", native_net_res_queue_size);
+    register_handle_methods("http_res_", "net.res_");
+    register_native("net.compression", native_net_compression);
+
+    // HTTP client
+    register_native("net.fetch", native_net_fetch);
+    register_native("net.request", native_net_request);
+    register_native("net.wait_all", native_net_wait_all);
+    register_native("net.client_config", native_net_client_config);
+    register_native("net.req_wait", native_net_req_wait);
+    register_native("net.req_done", native_net_req_done);
+    register_native("net.req_cancel", native_net_req_cancel);
+    register_handle_methods("http_req_", "net.req_");
+    register_awaitable("http_req_", native_net_req_wait);
 }
@@ -40,12 +40,25 @@ Value native_net_tcp_listen(struct Interpreter* interp, int argc, Value* args);
 Value native_net_tcp_connect(struct Interpreter* interp, int argc, Value* args);
 Value native_net_send(struct Interpreter* interp, int argc, Value* args);
 Value native_net_recv(struct Interpreter* interp, int argc, Value* args);
+Value native_net_recv_bytes(struct Interpreter* interp, int argc, Value* args);
+Value native_net_recv_until(struct Interpreter* interp, int argc, Value* args);
+Value native_net_pipe(struct Interpreter* interp, int argc, Value* args);
+Value native_net_close(struct Interpreter* interp, int argc, Value* args);
 
 // High-level REST stubs
 Value native_net_rest_get(struct Interpreter* interp, int argc, Value* args);
 Value native_net_rest_post(struct Interpreter* interp, int argc, Value* args);
 Value native_net_http_get(struct Interpreter* interp, int argc, Value* args);
 
+// Routes served by C code in other modules (e.g. graphql). The handler
+// returns a heap body (taken over by net) and may set *status and
+// *content_type; query and body may be NULL.
+typedef char* (*NetNativeHandler)(void* user, const char* method, const char* query,
+                                  const char* body, size_t body_len, int* status,
+                                  const char** content_type, size_t* out_len);
+bool net_route_native(const char* server, const char* path, const char* method,
+                      NetNativeHandler fn, void* user);
+
 // Callbacks
 void alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf);
 void on_new_connection(uv_stream_t* server, int status);
@@ -0,0 +1,608 @@
+#include "stdlib_numarray.h"
+#include "../core/numvec.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest element count new() and range() will allocate (32 GiB).
+#define NUMARRAY_MAX_LENGTH ((size_t)1 << 32)
+
+static const char* num_type(NumArrayKind kind) {
+    return kind == NUM_F64 ? "f64array" : "i64array";
+}
+
+static bool is_number(const Value* v) {
+    return v->type == VAL_INT || v->type == VAL_FLOAT;
+}
+
+static double number_f64(const Value* v) {
+    return v->type == VAL_INT ? (double)v->int_val : v->float_val;
+}
+
+static long long number_i64(const Value* v) {
+    if (v->type == VAL_INT) return v->int_val;
+    long long out;
+    numvec_f64_to_i64(&out, &v->float_val, 1);
+    return out;
+}
+
+// Copies an array of numbers into a new numeric array: i64 when every
+// element is an integer, else f64. NULL when an element is not a number.
+static NumArray* numarray_from_values(const Array* arr) {
+    NumArrayKind kind = NUM_I64;
+    for (size_t i = 0; i < arr->count; i++) {
+        if (arr->items[i].type == VAL_FLOAT) kind = NUM_F64;
+        else if (arr->items[i].type != VAL_INT) return NULL;
+    }
+    NumArray* out = numarray_create(kind, arr->count);
+    if (!out) return NULL;
+    for (size_t i = 0; i < arr->count; i++) {
+        if (kind == NUM_F64) out->f64[i] = number_f64(&arr->items[i]);
+        else out->i64[i] = arr->items[i].int_val;
+    }
+    return out;
+}
+
+// A new array of the given kind holding src's elements.
+static NumArray* numarray_convert(const NumArray* src, NumArrayKind kind) {
+    NumArray* out = numarray_create(kind, src->count);
+    if (!out) return NULL;
+    if (src->kind == kind) memcpy(out->data, src->data, src->count * sizeof(double));
+    else if (kind == NUM_F64) numvec_i64_to_f64(out->f64, src->i64, src->count);
+    else numvec_f64_to_i64(out->i64, src->f64, src->count);
+    return out;
+}
+
+// The numeric array a method was called on, or NULL after an error.
+static NumArray* num_self(const char* fn, int argc, Value* args, int nargs) {
+    if (argc >= 1 + nargs && args[0].type == VAL_NUMARRAY) return args[0].numarray_val;
+    const char* type = argc >= 1 && args[0].type == VAL_NUMARRAY ? num_type(args[0].numarray_val->kind) : "f64array";
+    if (nargs == 0) {
+        fprintf(stderr, "Error: %s.%s() requires a numeric array\n", type, fn);
+    } else {
+        fprintf(stderr, "Error: %s.%s() requires a numeric array and %d argument%s\n", type, fn, nargs,
+                nargs == 1 ? "" : "s");
+    }
+    return NULL;
+}
+
+// An operand of an elementwise operation: a numeric array, an array of
+// numbers (converted into temp) or one number used for every element
+// (step 0). i64 elements are widened into widened for f64 operations.
+typedef struct NumOperand {
+    NumArrayKind kind;
+    const void* data;
+    size_t step;
+    NumArray* temp;
+    double* widened;
+    double f64;
+    long long i64;
+} NumOperand;
+
+static void num_operand_free(NumOperand* op) {
+    numarray_release(op->temp);
+    free(op->widened);
+}
+
+static bool num_operand(const char* fn, const NumArray* self, const Value* v, NumOperand* op) {
+    memset(op, 0, sizeof(*op));
+    if (v->type == VAL_INT) {
+        op->kind = NUM_I64;
+        op->i64 = v->int_val;
+        op->data = &op->i64;
+        return true;
+    }
+    if (v->type == VAL_FLOAT) {
+        op->kind = NUM_F64;
+        op->f64 = v->float_val;
+        op->data = &op->f64;
+        return true;
+    }
+    const NumArray* arr = NULL;
+    if (v->type == VAL_NUMARRAY) arr = v->numarray_val;
+    else if (v->type == VAL_ARRAY) arr = op->temp = numarray_from_values(v->array_val);
+    if (!arr) {
+        fprintf(stderr, "Error: %s.%s() operands must be numbers or arrays of numbers\n", num_type(self->kind), fn);
+        return false;
+    }
+    if (arr->count != self->count) {
+        fprintf(stderr, "Error: %s.%s() operands differ in length (%zu and %zu)\n", num_type(self->kind), fn,
+                self->count, arr->count);
+        num_operand_free(op);
+        return false;
+    }
+    op->kind = arr->kind;
+    op->data = arr->data;
+    op->step = 1;
+    return true;
+}
+
+// Reads n operands from vals; on failure none are left to free.
+static bool num_operands(const char* fn, const NumArray* self, const Value* vals, int n, NumOperand* ops) {
+    for (int i = 0; i < n; i++) {
+        if (!num_operand(fn, self, &vals[i], &ops[i])) {
+            while (i-- > 0) num_operand_free(&ops[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static const double* num_operand_f64(NumOperand* op, size_t count) {
+    if (op->kind == NUM_F64) return op->data;
+    if (op->step == 0) {
+        op->f64 = (double)op->i64;
+        return &op->f64;
+    }
+    op->widened = malloc((count > 0 ? count : 1) * sizeof(double));
+    numvec_i64_to_f64(op->widened, op->data, count);
+    return op->widened;
+}
+
+// ============================================================================
+// Constructors
+// ============================================================================
+
+// f64array.new(count, [fill]) / i64array.new(count, [fill])
+static Value numarray_new(NumArrayKind kind, int argc, Value* args) {
+    if (argc < 1 || args[0].type != VAL_INT || args[0].int_val < 0 ||
+        (unsigned long long)args[0].int_val > NUMARRAY_MAX_LENGTH) {
+        fprintf(stderr, "Error: %s.new() requires a count from 0 to %zu\n", num_type(kind), NUMARRAY_MAX_LENGTH);
+        return make_null();
+    }
+    NumArray* arr = numarray_create(kind, (size_t)args[0].int_val);
+    if (!arr) return make_null();
+    if (argc >= 2 && is_number(&args[1])) {
+        if (kind == NUM_F64) {
+            double fill = number_f64(&args[1]);
+            for (size_t i = 0; i < arr->count; i++) arr->f64[i] = fill;
+        } else {
+            long long fill = number_i64(&args[1]);
+            for (size_t i = 0; i < arr->count; i++) arr->i64[i] = fill;
+        }
+    }
+    return make_numarray(arr);
+}
+
+// f64array.from(values) / i64array.from(values): an array of numbers or a
+// numeric array of either kind, converted (floats truncate into i64).
+static Value numarray_from(NumArrayKind kind, int argc, Value* args) {
+    const NumArray* src = NULL;
+    NumArray* temp = NULL;
+    if (argc >= 1 && args[0].type == VAL_NUMARRAY) src = args[0].numarray_val;
+    else if (argc >= 1 && args[0].type == VAL_ARRAY) src = temp = numarray_from_values(args[0].array_val);
+    if (!src) {
+        fprintf(stderr, "Error: %s.from() requires an array of numbers or a numeric array\n", num_type(kind));
+        return make_null();
+    }
+    if (temp && temp->kind == kind) return make_numarray(temp);
+    NumArray* out = numarray_convert(src, kind);
+    numarray_release(temp);
+    return out ? make_numarray(out) : make_null();
+}
+
+// f64array.range(start, stop, [step]) / i64array.range(...): start,
+// start + step, ... up to but not including stop.
+static Value numarray_range(NumArrayKind kind, int argc, Value* args) {
+    if (argc < 2 || !is_number(&args[0]) || !is_number(&args[1]) || (argc >= 3 && !is_number(&args[2]))) {
+        fprintf(stderr, "Error: %s.range() requires start, stop and an optional step\n", num_type(kind));
+        return make_null();
+    }
+    size_t count = 0;
+    NumArray* arr;
+    if (kind == NUM_I64) {
+        long long start = number_i64(&args[0]), stop = number_i64(&args[1]);
+        long long step = argc >= 3 ? number_i64(&args[2]) : 1;
+        if (step == 0) {
+            fprintf(stderr, "Error: i64array.range() step must not be 0\n");
+            return make_null();
+        }
+        unsigned long long span = 0, stride = step > 0 ? (unsigned long long)step : 0 - (unsigned long long)step;
+        if (step > 0 && stop > start) span = (unsigned long long)stop - (unsigned long long)start;
+        if (step < 0 && stop < start) span = (unsigned long long)start - (unsigned long long)stop;
+        count = span > 0 ? (size_t)((span - 1) / stride + 1) : 0;
+        if (count > NUMARRAY_MAX_LENGTH) goto too_long;
+        arr = numarray_create(NUM_I64, count);
+        if (!arr) return make_null();
+        for (size_t i = 0; i < count; i++) arr->i64[i] = (long long)((unsigned long long)start + i * (unsigned long long)step);
+    } else {
+        double start = number_f64(&args[0]), stop = number_f64(&args[1]);
+        double step = argc >= 3 ? number_f64(&args[2]) : 1.0;
+        if (step == 0.0 || !isfinite(step) || !isfinite(start) || !isfinite(stop)) {
+            fprintf(stderr, "Error: f64array.range() requires finite bounds and a non-zero step\n");
+            return make_null();
+        }
+        double span = ceil((stop - start) / step);
+        if (span > (double)NUMARRAY_MAX_LENGTH) goto too_long;
+        count = span > 0 ? (size_t)span : 0;
+        arr = numarray_create(NUM_F64, count);
+        if (!arr) return make_null();
+        for (size_t i = 0; i < count; i++) arr->f64[i] = start + (double)i * step;
+    }
+    return make_numarray(arr);
+
+too_long:
+    fprintf(stderr, "Error: %s.range() would have more than %zu elements\n", num_type(kind), NUMARRAY_MAX_LENGTH);
+    return make_null();
+}
+
+#define NUMARRAY_CONSTRUCTOR(kind, prefix, name)                                             \
+    static Value native_##prefix##_##name(struct Interpreter* interp, int argc, Value* args) { \
+        (void)interp;                                                                        \
+        return numarray_##name(kind, argc, args);                                            \
+    }
+
+NUMARRAY_CONSTRUCTOR(NUM_F64, f64array, new)
+NUMARRAY_CONSTRUCTOR(NUM_F64, f64array, from)
+NUMARRAY_CONSTRUCTOR(NUM_F64, f64array, range)
+NUMARRAY_CONSTRUCTOR(NUM_I64, i64array, new)
+NUMARRAY_CONSTRUCTOR(NUM_I64, i64array, from)
+NUMARRAY_CONSTRUCTOR(NUM_I64, i64array, range)
+
+// ============================================================================
+// Elements
+// ============================================================================
+
+// a.to_array(): the elements as an array of ints or floats.
+static Value native_numarray_to_array(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("to_array", argc, args, 0);
+    if (!a) return make_null();
+    Array* arr = array_create(a->count);
+    for (size_t i = 0; i < a->count; i++) {
+        arr->items[i] = a->kind == NUM_F64 ? make_float(a->f64[i]) : make_int(a->i64[i]);
+    }
+    arr->count = a->count;
+    return (Value){ .type = VAL_ARRAY, .array_val = arr };
+}
+
+// Resolves an index against count, negative values counting from the end.
+static bool num_index(const Value* v, size_t count, size_t* out) {
+    if (v->type != VAL_INT) return false;
+    long long i = v->int_val < 0 ? v->int_val + (long long)count : v->int_val;
+    if (i < 0 || (unsigned long long)i >= count) return false;
+    *out = (size_t)i;
+    return true;
+}
+
+// a.get(i): null when i is out of range. a[i] does the same.
+static Value native_numarray_get(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("get", argc, args, 1);
+    size_t i;
+    if (!a || !num_index(&args[1], a->count, &i)) return make_null();
+    return a->kind == NUM_F64 ? make_float(a->f64[i]) : make_int(a->i64[i]);
+}
+
+// a.set(i, value): in place, so every reference to a sees it.
+static Value native_numarray_set(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("set", argc, args, 2);
+    size_t i;
+    if (!a || !num_index(&args[1], a->count, &i) || !is_number(&args[2])) return make_bool(false);
+    if (a->kind == NUM_F64) a->f64[i] = number_f64(&args[2]);
+    else a->i64[i] = number_i64(&args[2]);
+    return make_bool(true);
+}
+
+// a.slice(start, [end]): a copy of the elements from start to end.
+static Value native_numarray_slice(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("slice", argc, args, 0);
+    if (!a) return make_null();
+    long long start = argc >= 2 && args[1].type == VAL_INT ? args[1].int_val : 0;
+    long long end = argc >= 3 && args[2].type == VAL_INT ? args[2].int_val : (long long)a->count;
+    if (start < 0) start += (long long)a->count;
+    if (end < 0) end += (long long)a->count;
+    if (start < 0) start = 0;
+    if (end > (long long)a->count) end = (long long)a->count;
+    if (end < start) end = start;
+    NumArray* out = numarray_create(a->kind, (size_t)(end - start));
+    if (!out) return make_null();
+    memcpy(out->data, (double*)a->data + start, out->count * sizeof(double));
+    return make_numarray(out);
+}
+
+// a.copy(): an array with storage of its own.
+static Value native_numarray_copy(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("copy", argc, args, 0);
+    if (!a) return make_null();
+    NumArray* out = numarray_convert(a, a->kind);
+    return out ? make_numarray(out) : make_null();
+}
+
+// ============================================================================
+// Elementwise
+// ============================================================================
+
+static Value numarray_arith(const char* fn, NumVecOp op, int argc, Value* args) {
+    NumArray* a = num_self(fn, argc, args, 1);
+    NumOperand ops[2];
+    if (!a || !num_operands(fn, a, args, 2, ops)) return make_null();
+    size_t n = a->count;
+    NumArray* out;
+    if (ops[0].kind == NUM_I64 && ops[1].kind == NUM_I64 && op != NUMVEC_DIV) {
+        out = numarray_create(NUM_I64, n);
+        if (out) numvec_i64_arith(op, out->i64, a->i64, ops[1].data, ops[1].step, n);
+    } else {
+        out = numarray_create(NUM_F64, n);
+        if (out) numvec_f64_arith(op, out->f64, num_operand_f64(&ops[0], n), num_operand_f64(&ops[1], n), ops[1].step, n);
+    }
+    num_operand_free(&ops[0]);
+    num_operand_free(&ops[1]);
+    return out ? make_numarray(out) : make_null();
+}
+
+#define NUMARRAY_ARITH(name, op)                                                             \
+    static Value native_numarray_##name(struct Interpreter* interp, int argc, Value* args) { \
+        (void)interp;                                                                        \
+        return numarray_arith(#name, op, argc, args);                                        \
+    }
+
+NUMARRAY_ARITH(add, NUMVEC_ADD)
+NUMARRAY_ARITH(sub, NUMVEC_SUB)
+NUMARRAY_ARITH(mul, NUMVEC_MUL)
+NUMARRAY_ARITH(div, NUMVEC_DIV)
+
+// a.fma(b, c): a * b + c rounded once, as an f64array.
+static Value native_numarray_fma(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("fma", argc, args, 2);
+    NumOperand ops[3];
+    if (!a || !num_operands("fma", a, args, 3, ops)) return make_null();
+    size_t n = a->count;
+    NumArray* out = numarray_create(NUM_F64, n);
+    if (out) {
+        numvec_f64_fma(out->f64, num_operand_f64(&ops[0], n), num_operand_f64(&ops[1], n), ops[1].step,
+                       num_operand_f64(&ops[2], n), ops[2].step, n);
+    }
+    for (int i = 0; i < 3; i++) num_operand_free(&ops[i]);
+    return out ? make_numarray(out) : make_null();
+}
+
+static Value numarray_compare(const char* fn, NumVecCmp cmp, int argc, Value* args) {
+    NumArray* a = num_self(fn, argc, args, 1);
+    NumOperand ops[2];
+    if (!a || !num_operands(fn, a, args, 2, ops)) return make_null();
+    size_t n = a->count;
+    NumArray* mask = numarray_create(NUM_I64, n);
+    if (!mask) {
+        num_operand_free(&ops[0]);
+        num_operand_free(&ops[1]);
+        return make_null();
+    }
+    if (ops[0].kind == NUM_I64 && ops[1].kind == NUM_I64) {
+        numvec_i64_compare(cmp, mask->i64, a->i64, ops[1].data, ops[1].step, n);
+    } else {
+        numvec_f64_compare(cmp, mask->i64, num_operand_f64(&ops[0], n), num_operand_f64(&ops[1], n), ops[1].step, n);
+    }
+    num_operand_free(&ops[0]);
+    num_operand_free(&ops[1]);
+    return make_numarray(mask);
+}
+
+#define NUMARRAY_COMPARE(name, cmp)                                                          \
+    static Value native_numarray_##name(struct Interpreter* interp, int argc, Value* args) { \
+        (void)interp;                                                                        \
+        return numarray_compare(#name, cmp, argc, args);                                     \
+    }
+
+NUMARRAY_COMPARE(lt, NUMVEC_LT)
+NUMARRAY_COMPARE(le, NUMVEC_LE)
+NUMARRAY_COMPARE(gt, NUMVEC_GT)
+NUMARRAY_COMPARE(ge, NUMVEC_GE)
+NUMARRAY_COMPARE(eq, NUMVEC_EQ)
+NUMARRAY_COMPARE(ne, NUMVEC_NE)
+
+// mask.where(x, y): x where mask is non-zero, else y.
+static Value native_numarray_where(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* mask = num_self("where", argc, args, 2);
+    NumOperand ops[2];
+    if (!mask || !num_operands("where", mask, args + 1, 2, ops)) return make_null();
+    size_t n = mask->count;
+    NumArray* set = NULL;
+    if (mask->kind == NUM_F64) {
+        static const double zero = 0.0;
+        set = numarray_create(NUM_I64, n);
+        if (!set) {
+            num_operand_free(&ops[0]);
+            num_operand_free(&ops[1]);
+            return make_null();
+        }
+        numvec_f64_compare(NUMVEC_NE, set->i64, mask->f64, &zero, 0, n);
+    }
+    NumArray* out;
+    if (ops[0].kind == NUM_I64 && ops[1].kind == NUM_I64) {
+        out = numarray_create(NUM_I64, n);
+        if (out) numvec_where(out->data, set ? set->i64 : mask->i64, ops[0].data, ops[0].step, ops[1].data, ops[1].step, n);
+    } else {
+        out = numarray_create(NUM_F64, n);
+        if (out) {
+            numvec_where(out->data, set ? set->i64 : mask->i64, num_operand_f64(&ops[0], n), ops[0].step,
+                         num_operand_f64(&ops[1], n), ops[1].step, n);
+        }
+    }
+    numarray_release(set);
+    num_operand_free(&ops[0]);
+    num_operand_free(&ops[1]);
+    return out ? make_numarray(out) : make_null();
+}
+
+Value numarray_clamp(const NumArray* a, const Value* lo, const Value* hi) {
+    if (!is_number(lo) || !is_number(hi)) {
+        fprintf(stderr, "Error: %s.clamp() bounds must be numbers\n", num_type(a->kind));
+        return make_null();
+    }
+    size_t n = a->count;
+    NumArray* out;
+    if (a->kind == NUM_I64 && lo->type == VAL_INT && hi->type == VAL_INT) {
+        out = numarray_create(NUM_I64, n);
+        if (out) numvec_i64_clamp(out->i64, a->i64, lo->int_val, hi->int_val, n);
+    } else if (a->kind == NUM_F64) {
+        out = numarray_create(NUM_F64, n);
+        if (out) numvec_f64_clamp(out->f64, a->f64, number_f64(lo), number_f64(hi), n);
+    } else {
+        out = numarray_convert(a, NUM_F64);
+        if (out) numvec_f64_clamp(out->f64, out->f64, number_f64(lo), number_f64(hi), n);
+    }
+    return out ? make_numarray(out) : make_null();
+}
+
+// a.clamp(lo, hi)
+static Value native_numarray_clamp(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("clamp", argc, args, 2);
+    if (!a) return make_null();
+    return numarray_clamp(a, &args[1], &args[2]);
+}
+
+// ============================================================================
+// Reductions
+// ============================================================================
+
+static Value native_numarray_sum(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("sum", argc, args, 0);
+    if (!a) return make_null();
+    if (a->kind == NUM_I64) return make_int(numvec_i64_sum(a->i64, a->count));
+    return make_float(numvec_f64_sum(a->f64, a->count));
+}
+
+Value numarray_min(const NumArray* a) {
+    if (a->count == 0) return make_null();
+    if (a->kind == NUM_I64) return make_int(numvec_i64_min(a->i64, a->count));
+    return make_float(numvec_f64_min(a->f64, a->count));
+}
+
+Value numarray_max(const NumArray* a) {
+    if (a->count == 0) return make_null();
+    if (a->kind == NUM_I64) return make_int(numvec_i64_max(a->i64, a->count));
+    return make_float(numvec_f64_max(a->f64, a->count));
+}
+
+// a.min() / a.max(): null when a is empty.
+static Value native_numarray_min(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("min", argc, args, 0);
+    return a ? numarray_min(a) : make_null();
+}
+
+static Value native_numarray_max(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("max", argc, args, 0);
+    return a ? numarray_max(a) : make_null();
+}
+
+// Elements of a as doubles: a's own for an f64array, else a converted
+// copy left in *widened for the caller to free.
+static const double* num_f64_view(const NumArray* a, double** widened) {
+    *widened = NULL;
+    if (a->kind == NUM_F64) return a->f64;
+    *widened = malloc((a->count > 0 ? a->count : 1) * sizeof(double));
+    numvec_i64_to_f64(*widened, a->i64, a->count);
+    return *widened;
+}
+
+// a.mean(): a float, null when a is empty.
+static Value native_numarray_mean(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("mean", argc, args, 0);
+    if (!a || a->count == 0) return make_null();
+    double* widened;
+    double sum = numvec_f64_sum(num_f64_view(a, &widened), a->count);
+    free(widened);
+    return make_float(sum / (double)a->count);
+}
+
+// a.variance([ddof]): the mean squared deviation from the mean, dividing
+// by count - ddof (1 for the sample variance). Null without enough
+// elements.
+static Value native_numarray_variance(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("variance", argc, args, 0);
+    if (!a) return make_null();
+    long long ddof = argc >= 2 && args[1].type == VAL_INT ? args[1].int_val : 0;
+    if (ddof < 0 || (long long)a->count <= ddof) return make_null();
+    double* widened;
+    const double* x = num_f64_view(a, &widened);
+    double mean = numvec_f64_sum(x, a->count) / (double)a->count;
+    double sq = numvec_f64_sq_dev(x, mean, a->count);
+    free(widened);
+    return make_float(sq / (double)(a->count - (size_t)ddof));
+}
+
+// a.dot(b): an int when both are integer, else a float.
+static Value native_numarray_dot(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("dot", argc, args, 1);
+    NumOperand ops[2];
+    if (!a || !num_operands("dot", a, args, 2, ops)) return make_null();
+    Value result = make_null();
+    size_t n = a->count;
+    if (ops[1].step == 0) {
+        fprintf(stderr, "Error: %s.dot() requires an array operand\n", num_type(a->kind));
+    } else if (ops[0].kind == NUM_I64 && ops[1].kind == NUM_I64) {
+        result = make_int(numvec_i64_dot(a->i64, ops[1].data, n));
+    } else {
+        result = make_float(numvec_f64_dot(num_operand_f64(&ops[0], n), num_operand_f64(&ops[1], n), n));
+    }
+    num_operand_free(&ops[0]);
+    num_operand_free(&ops[1]);
+    return result;
+}
+
+// a.cumsum(): running totals, of the same kind as a.
+static Value native_numarray_cumsum(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    NumArray* a = num_self("cumsum", argc, args, 0);
+    if (!a) return make_null();
+    NumArray* out = numarray_create(a->kind, a->count);
+    if (!out) return make_null();
+    if (a->kind == NUM_I64) numvec_i64_cumsum(out->i64, a->i64, a->count);
+    else numvec_f64_cumsum(out->f64, a->f64, a->count);
+    return make_numarray(out);
+}
+
+// Methods work on either kind, so each is registered under both prefixes.
+#define REGISTER_NUMARRAY_METHOD(name)                            \
+    register_native("f64array." #name, native_numarray_##name); \
+    register_native("i64array." #name, native_numarray_##name)
+
+void stdlib_numarray_register(void) {
+    numvec_init();
+    register_native("f64array.new", native_f64array_new);
+    register_native("f64array.from", native_f64array_from);
+    register_native("f64array.range", native_f64array_range);
+    register_native("i64array.new", native_i64array_new);
+    register_native("i64array.from", native_i64array_from);
+    register_native("i64array.range", native_i64array_range);
+    REGISTER_NUMARRAY_METHOD(to_array);
+    REGISTER_NUMARRAY_METHOD(get);
+    REGISTER_NUMARRAY_METHOD(set);
+    REGISTER_NUMARRAY_METHOD(slice);
+    REGISTER_NUMARRAY_METHOD(copy);
+    REGISTER_NUMARRAY_METHOD(add);
+    REGISTER_NUMARRAY_METHOD(sub);
+    REGISTER_NUMARRAY_METHOD(mul);
+    REGISTER_NUMARRAY_METHOD(div);
+    REGISTER_NUMARRAY_METHOD(fma);
+    REGISTER_NUMARRAY_METHOD(lt);
+    REGISTER_NUMARRAY_METHOD(le);
+    REGISTER_NUMARRAY_METHOD(gt);
+    REGISTER_NUMARRAY_METHOD(ge);
+    REGISTER_NUMARRAY_METHOD(eq);
+    REGISTER_NUMARRAY_METHOD(ne);
+    REGISTER_NUMARRAY_METHOD(where);
+    REGISTER_NUMARRAY_METHOD(clamp);
+    REGISTER_NUMARRAY_METHOD(sum);
+    REGISTER_NUMARRAY_METHOD(min);
+    REGISTER_NUMARRAY_METHOD(max);
+    REGISTER_NUMARRAY_METHOD(mean);
+    REGISTER_NUMARRAY_METHOD(variance);
+    REGISTER_NUMARRAY_METHOD(dot);
+    REGISTER_NUMARRAY_METHOD(cumsum);
+}
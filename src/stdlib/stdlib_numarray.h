@@ -0,0 +1,27 @@
+#ifndef RADS_STDLIB_NUMARRAY_H
+#define RADS_STDLIB_NUMARRAY_H
+
+#include "../core/interpreter.h"
+
+// Unboxed number arrays behind f64array.* and i64array.*.
+//
+// An f64array or i64array holds its elements in one contiguous block
+// instead of as boxed values, and is shared by reference like an array.
+// Elementwise operations and reductions run on the numvec kernels (AVX2
+// where available): a.add(b), a.fma(b, c), a.gt(0.5), mask.where(x, y),
+// a.sum(), a.dot(b), a.cumsum().
+//
+// Operands may be numeric arrays or arrays of numbers of the same length,
+// or single numbers applied to every element. Results are i64array only
+// when every operand is integer; div and fma always give an f64array.
+// Comparisons give an i64array mask of 0s and 1s.
+
+// Numeric Array Module registration
+void stdlib_numarray_register(void);
+
+// Used by math.min, math.max and math.clamp for a numeric array argument.
+Value numarray_min(const NumArray* arr);
+Value numarray_max(const NumArray* arr);
+Value numarray_clamp(const NumArray* arr, const Value* lo, const Value* hi);
+
+#endif // RADS_STDLIB_NUMARRAY_H
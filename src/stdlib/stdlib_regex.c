@@ -0,0 +1,1333 @@
+#include "stdlib_regex.h"
+#include "../core/textscan.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uv.h>
+
+extern Value make_string(const char* val);
+extern Array* array_create(size_t capacity);
+
+// ---------------------------------------------------------------------------
+// Parser
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    RX_EMPTY,
+    RX_CHAR,        // one code point
+    RX_CLASS,       // a set of code points
+    RX_CAT,
+    RX_ALT,
+    RX_REPEAT,
+    RX_GROUP,
+    RX_ASSERT
+} RxKind;
+
+typedef enum {
+    RX_BEGIN,       // start of text
+    RX_END,         // end of text
+    RX_BOL,         // start of a line
+    RX_EOL,         // end of a line
+    RX_WORD,        // \b
+    RX_NOT_WORD     // \B
+} RxAssert;
+
+typedef struct {
+    uint32_t lo, hi;
+} RxRange;
+
+typedef struct RxNode {
+    RxKind kind;
+    uint32_t cp;            // RX_CHAR
+    bool fold;              // RX_CHAR: either ASCII case
+    uint32_t ascii[4];      // RX_CLASS: members below 0x80, as a bitmap
+    RxRange* ranges;        // RX_CLASS: members from 0x80 up
+    int nranges;
+    int min, max;           // RX_REPEAT; max -1 is unbounded
+    bool greedy;
+    int group;              // RX_GROUP: capture index, or -1
+    RxAssert assert;
+    struct RxNode** kids;
+    int nkids;
+    struct RxNode* all_next;
+} RxNode;
+
+typedef struct {
+    const char* s;
+    size_t len;
+    size_t pos;
+    bool icase;
+    bool multiline;
+    bool dotall;
+    int groups;
+    int depth;
+    char* error;
+    size_t error_len;
+    RxNode* all;            // every node, for freeing
+} RxParser;
+
+static RxNode* rx_parse_alt(RxParser* p);
+
+static RxNode* rx_node(RxParser* p, RxKind kind) {
+    RxNode* n = calloc(1, sizeof(RxNode));
+    n->kind = kind;
+    n->all_next = p->all;
+    p->all = n;
+    return n;
+}
+
+static void rx_add_kid(RxNode* n, RxNode* kid) {
+    n->kids = realloc(n->kids, (size_t)(n->nkids + 1) * sizeof(RxNode*));
+    n->kids[n->nkids++] = kid;
+}
+
+static void rx_free_nodes(RxNode* all) {
+    while (all) {
+        RxNode* next = all->all_next;
+        free(all->ranges);
+        free(all->kids);
+        free(all);
+        all = next;
+    }
+}
+
+static RxNode* rx_fail(RxParser* p, const char* msg) {
+    if (p->error[0] == '\0') {
+        snprintf(p->error, p->error_len, "%s at offset %zu", msg, p->pos);
+    }
+    return NULL;
+}
+
+static uint32_t rx_decode(RxParser* p) {
+    const unsigned char* s = (const unsigned char*)p->s + p->pos;
+    size_t left = p->len - p->pos;
+    uint32_t c = s[0];
+    int n = c < 0x80 ? 1 : c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+    if ((size_t)n > left) n = 1;
+    if (n == 1) {
+        p->pos++;
+        return c;
+    }
+    c &= 0x3F >> (n - 1);
+    for (int i = 1; i < n; i++) c = (c << 6) | (s[i] & 0x3F);
+    p->pos += (size_t)n;
+    return c;
+}
+
+static bool rx_is_letter(uint32_t c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static void cls_add(RxParser* p, RxNode* cls, uint32_t lo, uint32_t hi) {
+    for (uint32_t c = lo; c <= hi && c < 0x80; c++) {
+        cls->ascii[c >> 5] |= 1u << (c & 31);
+        if (p->icase && rx_is_letter(c)) {
+            uint32_t other = c ^ 0x20;
+            cls->ascii[other >> 5] |= 1u << (other & 31);
+        }
+    }
+    if (hi < 0x80) return;
+    if (lo < 0x80) lo = 0x80;
+    cls->ranges = realloc(cls->ranges, (size_t)(cls->nranges + 1) * sizeof(RxRange));
+    cls->ranges[cls->nranges++] = (RxRange){ lo, hi };
+}
+
+static int rx_range_cmp(const void* a, const void* b) {
+    const RxRange* x = a;
+    const RxRange* y = b;
+    return x->lo < y->lo ? -1 : x->lo > y->lo;
+}
+
+// Sorts and merges the ranges from 0x80 up.
+static void cls_normalize(RxNode* cls) {
+    if (cls->nranges < 2) return;
+    qsort(cls->ranges, (size_t)cls->nranges, sizeof(RxRange), rx_range_cmp);
+    int out = 0;
+    for (int i = 1; i < cls->nranges; i++) {
+        if (cls->ranges[i].lo <= cls->ranges[out].hi + 1) {
+            if (cls->ranges[i].hi > cls->ranges[out].hi) cls->ranges[out].hi = cls->ranges[i].hi;
+        } else {
+            cls->ranges[++out] = cls->ranges[i];
+        }
+    }
+    cls->nranges = out + 1;
+}
+
+static void cls_negate(RxNode* cls) {
+    for (int i = 0; i < 4; i++) cls->ascii[i] = ~cls->ascii[i];
+    cls_normalize(cls);
+    RxRange* neg = malloc((size_t)(cls->nranges + 1) * sizeof(RxRange));
+    int n = 0;
+    uint32_t next = 0x80;
+    for (int i = 0; i < cls->nranges; i++) {
+        if (cls->ranges[i].lo > next) neg[n++] = (RxRange){ next, cls->ranges[i].lo - 1 };
+        next = cls->ranges[i].hi + 1;
+    }
+    if (next <= 0x10FFFF) neg[n++] = (RxRange){ next, 0x10FFFF };
+    free(cls->ranges);
+    cls->ranges = neg;
+    cls->nranges = n;
+}
+
+// \d \w \s and their negations, added to cls.
+static void cls_add_shorthand(RxParser* p, RxNode* cls, char which) {
+    RxNode tmp;
+    memset(&tmp, 0, sizeof(tmp));
+    RxNode* target = (which >= 'A' && which <= 'Z') ? &tmp : cls;
+    switch (which | 0x20) {
+        case 'd':
+            cls_add(p, target, '0', '9');
+            break;
+        case 'w':
+            cls_add(p, target, '0', '9');
+            cls_add(p, target, 'A', 'Z');
+            cls_add(p, target, 'a', 'z');
+            cls_add(p, target, '_', '_');
+            break;
+        default:
+            cls_add(p, target, '\t', '\r');
+            cls_add(p, target, ' ', ' ');
+            break;
+    }
+    if (target == cls) return;
+    cls_negate(&tmp);
+    for (int i = 0; i < 4; i++) cls->ascii[i] |= tmp.ascii[i];
+    for (int i = 0; i < tmp.nranges; i++) cls_add(p, cls, tmp.ranges[i].lo, tmp.ranges[i].hi);
+    free(tmp.ranges);
+}
+
+static int rx_hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parses the escape after a backslash. Returns 1 with *cp set for a single
+// character, 2 when a shorthand class was added to cls, 0 on error.
+static int rx_escape(RxParser* p, RxNode* cls, uint32_t* cp) {
+    if (p->pos >= p->len) {
+        rx_fail(p, "trailing backslash");
+        return 0;
+    }
+    char c = p->s[p->pos];
+    switch (c) {
+        case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+            p->pos++;
+            cls_add_shorthand(p, cls, c);
+            return 2;
+        case 'n': p->pos++; *cp = '\n'; return 1;
+        case 't': p->pos++; *cp = '\t'; return 1;
+        case 'r': p->pos++; *cp = '\r'; return 1;
+        case 'f': p->pos++; *cp = '\f'; return 1;
+        case 'v': p->pos++; *cp = '\v'; return 1;
+        case '0': p->pos++; *cp = 0; return 1;
+        case 'x': {
+            int hi = p->pos + 1 < p->len ? rx_hex(p->s[p->pos + 1]) : -1;
+            int lo = p->pos + 2 < p->len ? rx_hex(p->s[p->pos + 2]) : -1;
+            if (hi < 0 || lo < 0) {
+                rx_fail(p, "\\x needs two hex digits");
+                return 0;
+            }
+            p->pos += 3;
+            *cp = (uint32_t)(hi * 16 + lo);
+            return 1;
+        }
+        default:
+            if ((unsigned char)c < 0x80 && !(c >= '0' && c <= '9') && !rx_is_letter((unsigned char)c)) {
+                p->pos++;
+                *cp = (unsigned char)c;
+                return 1;
+            }
+            rx_fail(p, "unknown escape");
+            return 0;
+    }
+}
+
+static RxNode* rx_parse_class(RxParser* p) {
+    RxNode* cls = rx_node(p, RX_CLASS);
+    p->pos++;   // '['
+    bool negate = p->pos < p->len && p->s[p->pos] == '^';
+    if (negate) p->pos++;
+    bool first = true;
+    for (;;) {
+        if (p->pos >= p->len) return rx_fail(p, "missing ]");
+        if (p->s[p->pos] == ']' && !first) {
+            p->pos++;
+            break;
+        }
+        first = false;
+        uint32_t lo;
+        if (p->s[p->pos] == '\\') {
+            p->pos++;
+            int kind = rx_escape(p, cls, &lo);
+            if (kind == 0) return NULL;
+            if (kind == 2) continue;
+        } else {
+            lo = rx_decode(p);
+        }
+        uint32_t hi = lo;
+        if (p->pos + 1 < p->len && p->s[p->pos] == '-' && p->s[p->pos + 1] != ']') {
+            p->pos++;
+            if (p->s[p->pos] == '\\') {
+                p->pos++;
+                RxNode scratch;
+                memset(&scratch, 0, sizeof(scratch));
+                int kind = rx_escape(p, &scratch, &hi);
+                free(scratch.ranges);
+                if (kind != 1) return rx_fail(p, "bad class range");
+            } else {
+                hi = rx_decode(p);
+            }
+            if (hi < lo) return rx_fail(p, "bad class range");
+        }
+        cls_add(p, cls, lo, hi);
+    }
+    if (negate) cls_negate(cls);
+    else cls_normalize(cls);
+    return cls;
+}
+
+static RxNode* rx_parse_atom(RxParser* p) {
+    char c = p->s[p->pos];
+    switch (c) {
+        case '(': {
+            if (++p->depth > 1000) return rx_fail(p, "nesting too deep");
+            p->pos++;
+            int group = -1;
+            if (p->pos < p->len && p->s[p->pos] == '?') {
+                if (p->pos + 1 < p->len && p->s[p->pos + 1] == ':') {
+                    p->pos += 2;
+                } else {
+                    return rx_fail(p, "unsupported group syntax");
+                }
+            } else {
+                if (p->groups >= REGEX_MAX_GROUPS) return rx_fail(p, "too many groups");
+                group = ++p->groups;
+            }
+            RxNode* inner = rx_parse_alt(p);
+            if (!inner) return NULL;
+            if (p->pos >= p->len || p->s[p->pos] != ')') return rx_fail(p, "missing )");
+            p->pos++;
+            p->depth--;
+            RxNode* n = rx_node(p, RX_GROUP);
+            n->group = group;
+            rx_add_kid(n, inner);
+            return n;
+        }
+        case '[':
+            return rx_parse_class(p);
+        case '.': {
+            p->pos++;
+            RxNode* n = rx_node(p, RX_CLASS);
+            cls_add(p, n, 0, 0x10FFFF);
+            if (!p->dotall) n->ascii[0] &= ~(1u << '\n');
+            return n;
+        }
+        case '^':
+        case '$': {
+            p->pos++;
+            RxNode* n = rx_node(p, RX_ASSERT);
+            if (c == '^') n->assert = p->multiline ? RX_BOL : RX_BEGIN;
+            else n->assert = p->multiline ? RX_EOL : RX_END;
+            return n;
+        }
+        case '*':
+        case '+':
+        case '?':
+            return rx_fail(p, "nothing to repeat");
+        case '\\': {
+            p->pos++;
+            if (p->pos < p->len && (p->s[p->pos] == 'b' || p->s[p->pos] == 'B')) {
+                RxNode* n = rx_node(p, RX_ASSERT);
+                n->assert = p->s[p->pos] == 'b' ? RX_WORD : RX_NOT_WORD;
+                p->pos++;
+                return n;
+            }
+            RxNode* cls = rx_node(p, RX_CLASS);
+            uint32_t cp;
+            int kind = rx_escape(p, cls, &cp);
+            if (kind == 0) return NULL;
+            if (kind == 2) {
+                cls_normalize(cls);
+                return cls;
+            }
+            cls->kind = RX_CHAR;
+            cls->cp = cp;
+            cls->fold = p->icase && rx_is_letter(cp);
+            return cls;
+        }
+        default: {
+            RxNode* n = rx_node(p, RX_CHAR);
+            n->cp = rx_decode(p);
+            n->fold = p->icase && rx_is_letter(n->cp);
+            return n;
+        }
+    }
+}
+
+// Reads {n}, {n,} or {n,m}. A brace that does not start one is a literal.
+static bool rx_parse_braces(RxParser* p, int* min, int* max) {
+    size_t at = p->pos + 1;
+    long lo = 0, hi;
+    size_t digits = 0;
+    while (at < p->len && p->s[at] >= '0' && p->s[at] <= '9' && digits < 9) {
+        lo = lo * 10 + (p->s[at++] - '0');
+        digits++;
+    }
+    if (digits == 0) return false;
+    hi = lo;
+    if (at < p->len && p->s[at] == ',') {
+        at++;
+        hi = -1;
+        if (at < p->len && p->s[at] >= '0' && p->s[at] <= '9') {
+            hi = 0;
+            digits = 0;
+            while (at < p->len && p->s[at] >= '0' && p->s[at] <= '9' && digits < 9) {
+                hi = hi * 10 + (p->s[at++] - '0');
+                digits++;
+            }
+        }
+    }
+    if (at >= p->len || p->s[at] != '}') return false;
+    p->pos = at + 1;
+    *min = (int)lo;
+    *max = (int)hi;
+    return true;
+}
+
+static RxNode* rx_parse_repeat(RxParser* p) {
+    RxNode* atom = rx_parse_atom(p);
+    if (!atom) return NULL;
+    bool repeated = false;
+    while (p->pos < p->len) {
+        char c = p->s[p->pos];
+        int min, max;
+        if (c == '*') {
+            min = 0; max = -1; p->pos++;
+        } else if (c == '+') {
+            min = 1; max = -1; p->pos++;
+        } else if (c == '?') {
+            min = 0; max = 1; p->pos++;
+        } else if (c == '{' && rx_parse_braces(p, &min, &max)) {
+            if (min > REGEX_MAX_REPEAT || max > REGEX_MAX_REPEAT) return rx_fail(p, "repeat count too large");
+            if (max >= 0 && max < min) return rx_fail(p, "bad repeat range");
+        } else {
+            break;
+        }
+        if (repeated) return rx_fail(p, "multiple repeat");
+        if (atom->kind == RX_ASSERT) return rx_fail(p, "nothing to repeat");
+        repeated = true;
+        RxNode* n = rx_node(p, RX_REPEAT);
+        n->min = min;
+        n->max = max;
+        n->greedy = true;
+        if (p->pos < p->len && p->s[p->pos] == '?') {
+            n->greedy = false;
+            p->pos++;
+        }
+        rx_add_kid(n, atom);
+        atom = n;
+    }
+    return atom;
+}
+
+static RxNode* rx_parse_cat(RxParser* p) {
+    RxNode* cat = rx_node(p, RX_CAT);
+    while (p->pos < p->len && p->s[p->pos] != '|' && p->s[p->pos] != ')') {
+        RxNode* n = rx_parse_repeat(p);
+        if (!n) return NULL;
+        rx_add_kid(cat, n);
+    }
+    if (cat->nkids == 0) cat->kind = RX_EMPTY;
+    if (cat->nkids == 1) return cat->kids[0];
+    return cat;
+}
+
+static RxNode* rx_parse_alt(RxParser* p) {
+    RxNode* first = rx_parse_cat(p);
+    if (!first || p->pos >= p->len || p->s[p->pos] != '|') return first;
+    RxNode* alt = rx_node(p, RX_ALT);
+    rx_add_kid(alt, first);
+    while (p->pos < p->len && p->s[p->pos] == '|') {
+        p->pos++;
+        RxNode* n = rx_parse_cat(p);
+        if (!n) return NULL;
+        rx_add_kid(alt, n);
+    }
+    return alt;
+}
+
+// ---------------------------------------------------------------------------
+// Compiler
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    OP_BYTE,        // consume a byte in [lo, hi]
+    OP_SET,         // consume a byte in sets[x]
+    OP_SPLIT,       // continue at x, then (lower priority) at y
+    OP_JMP,
+    OP_SAVE,        // record the position in capture slot x
+    OP_ASSERT,      // RxAssert x holds here
+    OP_MATCH
+} RxOp;
+
+typedef struct {
+    uint8_t op;
+    uint8_t lo, hi;
+    int x, y;
+} RxInst;
+
+struct Regex {
+    _Atomic int refs;
+    RxInst* prog;
+    int nprog;
+    int cap;
+    uint32_t (*sets)[4];
+    int nsets;
+    int groups;
+    bool anchored;          // can only match at the start of the text
+    char* prefix;           // literal bytes every match starts with
+    size_t prefix_len;
+    bool literal;           // the pattern is exactly prefix
+    bool too_big;
+};
+
+static int rx_emit(Regex* re, RxOp op, int lo, int hi, int x, int y) {
+    if (re->nprog >= REGEX_MAX_PROGRAM) {
+        re->too_big = true;
+        return re->nprog - 1;
+    }
+    if (re->nprog == re->cap) {
+        re->cap = re->cap ? re->cap * 2 : 32;
+        re->prog = realloc(re->prog, (size_t)re->cap * sizeof(RxInst));
+    }
+    re->prog[re->nprog] = (RxInst){ (uint8_t)op, (uint8_t)lo, (uint8_t)hi, x, y };
+    return re->nprog++;
+}
+
+static int rx_add_set(Regex* re, const uint32_t* ascii) {
+    re->sets = realloc(re->sets, (size_t)(re->nsets + 1) * sizeof(*re->sets));
+    memcpy(re->sets[re->nsets], ascii, sizeof(*re->sets));
+    return re->nsets++;
+}
+
+static int rx_utf8_encode(uint32_t cp, uint8_t* out) {
+    if (cp < 0x80) {
+        out[0] = (uint8_t)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (uint8_t)(0xC0 | (cp >> 6));
+        out[1] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (uint8_t)(0xE0 | (cp >> 12));
+        out[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (uint8_t)(0xF0 | (cp >> 18));
+    out[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (uint8_t)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// A run of byte ranges matching one UTF-8 encoded code point.
+typedef struct {
+    int n;
+    uint8_t lo[4], hi[4];
+} RxSeq;
+
+typedef struct {
+    RxSeq* items;
+    int count;
+} RxSeqList;
+
+// Splits [lo, hi] into ranges whose encodings differ only in the trailing
+// bytes, each of which is then a run of byte ranges.
+static void rx_utf8_seqs(uint32_t lo, uint32_t hi, RxSeqList* out) {
+    static const uint32_t max_for_len[] = { 0x7F, 0x7FF, 0xFFFF };
+    for (int i = 0; i < 3; i++) {
+        if (lo <= max_for_len[i] && hi > max_for_len[i]) {
+            rx_utf8_seqs(lo, max_for_len[i], out);
+            rx_utf8_seqs(max_for_len[i] + 1, hi, out);
+            return;
+        }
+    }
+    for (int i = 1; i < 4; i++) {
+        uint32_t m = (1u << (6 * i)) - 1;
+        if ((lo & ~m) != (hi & ~m)) {
+            if ((lo & m) != 0) {
+                rx_utf8_seqs(lo, lo | m, out);
+                rx_utf8_seqs((lo | m) + 1, hi, out);
+                return;
+            }
+            if ((hi & m) != m) {
+                rx_utf8_seqs(lo, (hi & ~m) - 1, out);
+                rx_utf8_seqs(hi & ~m, hi, out);
+                return;
+            }
+        }
+    }
+    RxSeq seq;
+    seq.n = rx_utf8_encode(lo, seq.lo);
+    rx_utf8_encode(hi, seq.hi);
+    out->items = realloc(out->items, (size_t)(out->count + 1) * sizeof(RxSeq));
+    out->items[out->count++] = seq;
+}
+
+static void rx_compile_node(Regex* re, const RxNode* n);
+
+// Emits n alternatives in priority order; emit_alt(i) emits the i-th.
+#define RX_ALTERNATION(re, count, emit_alt)                                   \
+    do {                                                                      \
+        int rx_jumps[(count) > 0 ? (count) : 1];                              \
+        for (int rx_i = 0; rx_i < (count); rx_i++) {                          \
+            int rx_split = -1;                                                \
+            if (rx_i + 1 < (count)) rx_split = rx_emit(re, OP_SPLIT, 0, 0, (re)->nprog + 1, 0); \
+            emit_alt(rx_i);                                                   \
+            if (rx_i + 1 < (count)) {                                         \
+                rx_jumps[rx_i] = rx_emit(re, OP_JMP, 0, 0, 0, 0);             \
+                (re)->prog[rx_split].y = (re)->nprog;                         \
+            }                                                                 \
+        }                                                                     \
+        for (int rx_i = 0; rx_i + 1 < (count); rx_i++) (re)->prog[rx_jumps[rx_i]].x = (re)->nprog; \
+    } while (0)
+
+static void rx_compile_class(Regex* re, const RxNode* n) {
+    bool has_ascii = (n->ascii[0] | n->ascii[1] | n->ascii[2] | n->ascii[3]) != 0;
+    RxSeqList seqs = { NULL, 0 };
+    for (int i = 0; i < n->nranges; i++) rx_utf8_seqs(n->ranges[i].lo, n->ranges[i].hi, &seqs);
+    int count = (has_ascii ? 1 : 0) + seqs.count;
+    if (count == 0) {
+        rx_emit(re, OP_BYTE, 1, 0, 0, 0);   // matches nothing
+        return;
+    }
+#define RX_CLASS_ALT(i)                                                       \
+    do {                                                                      \
+        if (has_ascii && (i) == 0) {                                          \
+            rx_emit(re, OP_SET, 0, 0, rx_add_set(re, n->ascii), 0);           \
+        } else {                                                              \
+            const RxSeq* s = &seqs.items[(i) - (has_ascii ? 1 : 0)];          \
+            for (int k = 0; k < s->n; k++) rx_emit(re, OP_BYTE, s->lo[k], s->hi[k], 0, 0); \
+        }                                                                     \
+    } while (0)
+    RX_ALTERNATION(re, count, RX_CLASS_ALT);
+#undef RX_CLASS_ALT
+    free(seqs.items);
+}
+
+static void rx_compile_repeat(Regex* re, const RxNode* n) {
+    const RxNode* kid = n->kids[0];
+    if (n->max == -1) {
+        // x{n,} is x{n-1}x+, and x* is (x+)?: a body that matches empty
+        // then runs once instead of being cut off by the loop check.
+        for (int i = 1; i < n->min && !re->too_big; i++) rx_compile_node(re, kid);
+        int skip = n->min == 0 ? rx_emit(re, OP_SPLIT, 0, 0, 0, 0) : -1;
+        int body = re->nprog;
+        rx_compile_node(re, kid);
+        int loop = rx_emit(re, OP_SPLIT, 0, 0, 0, 0);
+        int out = re->nprog;
+        re->prog[loop].x = n->greedy ? body : out;
+        re->prog[loop].y = n->greedy ? out : body;
+        if (skip >= 0) {
+            re->prog[skip].x = n->greedy ? body : out;
+            re->prog[skip].y = n->greedy ? out : body;
+        }
+        return;
+    }
+    for (int i = 0; i < n->min && !re->too_big; i++) rx_compile_node(re, kid);
+    int optional = n->max - n->min;
+    if (optional <= 0) return;
+    int* splits = malloc((size_t)optional * sizeof(int));
+    for (int i = 0; i < optional && !re->too_big; i++) {
+        splits[i] = rx_emit(re, OP_SPLIT, 0, 0, 0, 0);
+        rx_compile_node(re, kid);
+    }
+    // Skipping any optional copy skips the rest too.
+    int out = re->nprog;
+    for (int i = 0; i < optional && !re->too_big; i++) {
+        re->prog[splits[i]].x = n->greedy ? splits[i] + 1 : out;
+        re->prog[splits[i]].y = n->greedy ? out : splits[i] + 1;
+    }
+    free(splits);
+}
+
+static void rx_compile_node(Regex* re, const RxNode* n) {
+    if (re->too_big) return;
+    switch (n->kind) {
+        case RX_EMPTY:
+            break;
+        case RX_CHAR:
+            if (n->fold) {
+                uint32_t ascii[4] = { 0, 0, 0, 0 };
+                ascii[n->cp >> 5] |= 1u << (n->cp & 31);
+                ascii[(n->cp ^ 0x20) >> 5] |= 1u << ((n->cp ^ 0x20) & 31);
+                rx_emit(re, OP_SET, 0, 0, rx_add_set(re, ascii), 0);
+            } else {
+                uint8_t bytes[4];
+                int len = rx_utf8_encode(n->cp, bytes);
+                for (int i = 0; i < len; i++) rx_emit(re, OP_BYTE, bytes[i], bytes[i], 0, 0);
+            }
+            break;
+        case RX_CLASS:
+            rx_compile_class(re, n);
+            break;
+        case RX_CAT:
+            for (int i = 0; i < n->nkids; i++) rx_compile_node(re, n->kids[i]);
+            break;
+        case RX_ALT: {
+#define RX_BRANCH(i) rx_compile_node(re, n->kids[i])
+            RX_ALTERNATION(re, n->nkids, RX_BRANCH);
+#undef RX_BRANCH
+            break;
+        }
+        case RX_REPEAT:
+            rx_compile_repeat(re, n);
+            break;
+        case RX_GROUP:
+            if (n->group >= 0) rx_emit(re, OP_SAVE, 0, 0, 2 * n->group, 0);
+            rx_compile_node(re, n->kids[0]);
+            if (n->group >= 0) rx_emit(re, OP_SAVE, 0, 0, 2 * n->group + 1, 0);
+            break;
+        case RX_ASSERT:
+            rx_emit(re, OP_ASSERT, 0, 0, (int)n->assert, 0);
+            break;
+    }
+}
+
+// Literal text at the start of every match, for the prefilter.
+static void rx_find_prefix(Regex* re, const RxNode* root) {
+    const RxNode* const* kids = &root;
+    int nkids = 1;
+    if (root->kind == RX_CAT) {
+        kids = (const RxNode* const*)root->kids;
+        nkids = root->nkids;
+    }
+    char buf[256];
+    size_t len = 0;
+    bool all_literal = true;
+    int i = 0;
+    if (nkids > 0 && kids[0]->kind == RX_ASSERT && kids[0]->assert == RX_BEGIN) {
+        re->anchored = true;
+        all_literal = false;
+        i = 1;
+    }
+    for (; i < nkids; i++) {
+        const RxNode* k = kids[i];
+        if (k->kind != RX_CHAR || k->fold || len + 4 > sizeof(buf)) {
+            all_literal = false;
+            break;
+        }
+        len += (size_t)rx_utf8_encode(k->cp, (uint8_t*)buf + len);
+    }
+    if (len == 0) return;
+    re->prefix = malloc(len);
+    memcpy(re->prefix, buf, len);
+    re->prefix_len = len;
+    re->literal = all_literal && re->groups == 0;
+}
+
+Regex* regex_compile(const char* pattern, size_t len, char* error, size_t error_len) {
+    RxParser p;
+    memset(&p, 0, sizeof(p));
+    p.s = pattern;
+    p.len = len;
+    p.error = error;
+    p.error_len = error_len;
+    error[0] = '\0';
+    // Leading flag groups: (?i), (?ms), ...
+    while (p.pos + 2 < len && pattern[p.pos] == '(' && pattern[p.pos + 1] == '?' &&
+           strchr("ims", pattern[p.pos + 2]) != NULL) {
+        size_t at = p.pos + 2;
+        while (at < len && strchr("ims", pattern[at]) != NULL && pattern[at] != '\0') {
+            if (pattern[at] == 'i') p.icase = true;
+            if (pattern[at] == 'm') p.multiline = true;
+            if (pattern[at] == 's') p.dotall = true;
+            at++;
+        }
+        if (at >= len || pattern[at] != ')') break;
+        p.pos = at + 1;
+    }
+    RxNode* root = rx_parse_alt(&p);
+    if (root && p.pos < p.len) root = rx_fail(&p, "unmatched )");
+    if (!root) {
+        rx_free_nodes(p.all);
+        return NULL;
+    }
+
+    Regex* re = calloc(1, sizeof(Regex));
+    atomic_init(&re->refs, 1);
+    re->groups = p.groups;
+    rx_emit(re, OP_SAVE, 0, 0, 0, 0);
+    rx_compile_node(re, root);
+    rx_emit(re, OP_SAVE, 0, 0, 1, 0);
+    rx_emit(re, OP_MATCH, 0, 0, 0, 0);
+    rx_find_prefix(re, root);
+    rx_free_nodes(p.all);
+    if (re->too_big) {
+        snprintf(error, error_len, "pattern too large");
+        regex_release(re);
+        return NULL;
+    }
+    return re;
+}
+
+void regex_release(Regex* re) {
+    if (!re || atomic_fetch_sub(&re->refs, 1) != 1) return;
+    free(re->prog);
+    free(re->sets);
+    free(re->prefix);
+    free(re);
+}
+
+int regex_groups(const Regex* re) {
+    return re->groups;
+}
+
+// ---------------------------------------------------------------------------
+// Pike VM
+// ---------------------------------------------------------------------------
+
+// Threads at one text position, in priority order. A sparse set keeps each
+// instruction at most once, which bounds the work per byte.
+typedef struct {
+    int* dense;
+    int* sparse;
+    int n;
+    long* caps;             // ncap slots per thread
+} RxList;
+
+typedef struct {
+    int pc;
+    int slot;               // >= 0: restore caps[slot] = val instead
+    long val;
+} RxFrame;
+
+typedef struct {
+    int prog_cap;
+    int ncap_cap;
+    RxList lists[2];
+    RxFrame* stack;
+    long* tmp;
+    long* init;
+} RxScratch;
+
+static _Thread_local RxScratch rx_scratch;
+
+static RxScratch* rx_scratch_for(const Regex* re, int ncap) {
+    RxScratch* sc = &rx_scratch;
+    if (sc->prog_cap < re->nprog || sc->ncap_cap < ncap) {
+        int prog_cap = re->nprog > sc->prog_cap ? re->nprog : sc->prog_cap;
+        int ncap_cap = ncap > sc->ncap_cap ? ncap : sc->ncap_cap;
+        for (int i = 0; i < 2; i++) {
+            free(sc->lists[i].dense);
+            free(sc->lists[i].sparse);
+            free(sc->lists[i].caps);
+            sc->lists[i].dense = malloc((size_t)prog_cap * sizeof(int));
+            sc->lists[i].sparse = calloc((size_t)prog_cap, sizeof(int));
+            sc->lists[i].caps = malloc((size_t)prog_cap * (size_t)ncap_cap * sizeof(long));
+        }
+        free(sc->stack);
+        free(sc->tmp);
+        free(sc->init);
+        sc->stack = malloc((size_t)(prog_cap + 1) * sizeof(RxFrame));
+        sc->tmp = malloc((size_t)ncap_cap * sizeof(long));
+        sc->init = malloc((size_t)ncap_cap * sizeof(long));
+        sc->prog_cap = prog_cap;
+        sc->ncap_cap = ncap_cap;
+    }
+    for (int i = 0; i < ncap; i++) sc->init[i] = -1;
+    return sc;
+}
+
+static bool rx_word_byte(int c) {
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_';
+}
+
+static bool rx_assert_holds(int kind, const unsigned char* text, size_t len, size_t pos) {
+    switch (kind) {
+        case RX_BEGIN: return pos == 0;
+        case RX_END: return pos == len;
+        case RX_BOL: return pos == 0 || text[pos - 1] == '\n';
+        case RX_EOL: return pos == len || text[pos] == '\n';
+        default: {
+            bool before = pos > 0 && rx_word_byte(text[pos - 1]);
+            bool after = pos < len && rx_word_byte(text[pos]);
+            return (before != after) == (kind == RX_WORD);
+        }
+    }
+}
+
+// Adds the thread at pc0, and everything reachable from it without
+// consuming input, to l.
+static void rx_add_thread(const Regex* re, RxScratch* sc, RxList* l, int ncap, int pc0,
+                          const long* caps, const unsigned char* text, size_t len, size_t pos) {
+    memcpy(sc->tmp, caps, (size_t)ncap * sizeof(long));
+    int top = 0;
+    sc->stack[top++] = (RxFrame){ pc0, -1, 0 };
+    while (top > 0) {
+        RxFrame f = sc->stack[--top];
+        if (f.slot >= 0) {
+            sc->tmp[f.slot] = f.val;
+            continue;
+        }
+        int pc = f.pc;
+        for (;;) {
+            int at = l->sparse[pc];
+            if (at < l->n && l->dense[at] == pc) break;
+            at = l->n++;
+            l->dense[at] = pc;
+            l->sparse[pc] = at;
+            const RxInst* in = &re->prog[pc];
+            if (in->op == OP_JMP) {
+                pc = in->x;
+            } else if (in->op == OP_SPLIT) {
+                sc->stack[top++] = (RxFrame){ in->y, -1, 0 };
+                pc = in->x;
+            } else if (in->op == OP_SAVE) {
+                sc->stack[top++] = (RxFrame){ 0, in->x, sc->tmp[in->x] };
+                sc->tmp[in->x] = (long)pos;
+                pc++;
+            } else if (in->op == OP_ASSERT) {
+                if (!rx_assert_holds(in->x, text, len, pos)) break;
+                pc++;
+            } else {
+                memcpy(l->caps + (size_t)at * (size_t)ncap, sc->tmp, (size_t)ncap * sizeof(long));
+                break;
+            }
+        }
+    }
+}
+
+bool regex_search(const Regex* re, const char* text_in, size_t len, size_t start, long* caps) {
+    const unsigned char* text = (const unsigned char*)text_in;
+    if (start > len) return false;
+    if (re->literal) {
+        const char* hit = text_find(text_in + start, len - start, re->prefix, re->prefix_len);
+        if (!hit) return false;
+        caps[0] = (long)(hit - text_in);
+        caps[1] = caps[0] + (long)re->prefix_len;
+        return true;
+    }
+    if (re->anchored && start > 0) return false;
+
+    int ncap = 2 * (re->groups + 1);
+    RxScratch* sc = rx_scratch_for(re, ncap);
+    RxList* cur = &sc->lists[0];
+    RxList* next = &sc->lists[1];
+    cur->n = 0;
+    bool matched = false;
+    size_t pos = start;
+    for (;;) {
+        // A new thread starting here ranks below every thread already running.
+        if (!matched && (!re->anchored || pos == 0)) {
+            if (cur->n == 0 && re->prefix_len > 0 && !re->anchored) {
+                const char* hit = text_find(text_in + pos, len - pos, re->prefix, re->prefix_len);
+                if (!hit) break;
+                pos = (size_t)(hit - text_in);
+            }
+            rx_add_thread(re, sc, cur, ncap, 0, sc->init, text, len, pos);
+        }
+        if (cur->n == 0) {
+            if (matched || re->anchored || pos >= len) break;
+            pos++;
+            continue;
+        }
+        next->n = 0;
+        int c = pos < len ? text[pos] : -1;
+        for (int i = 0; i < cur->n; i++) {
+            const RxInst* in = &re->prog[cur->dense[i]];
+            long* thread_caps = cur->caps + (size_t)i * (size_t)ncap;
+            if (in->op == OP_MATCH) {
+                // Lower-priority threads can no longer win.
+                matched = true;
+                memcpy(caps, thread_caps, (size_t)ncap * sizeof(long));
+                break;
+            }
+            if (c < 0) continue;
+            bool ok = in->op == OP_BYTE ? (c >= in->lo && c <= in->hi)
+                    : in->op == OP_SET ? (c < 0x80 && (re->sets[in->x][c >> 5] >> (c & 31)) & 1)
+                    : false;
+            if (ok) rx_add_thread(re, sc, next, ncap, cur->dense[i] + 1, thread_caps, text, len, pos + 1);
+        }
+        RxList* swap = cur;
+        cur = next;
+        next = swap;
+        if (pos >= len) break;
+        pos++;
+    }
+    return matched;
+}
+
+// ---------------------------------------------------------------------------
+// Cache
+// ---------------------------------------------------------------------------
+
+#define REGEX_CACHE_BUCKETS 509
+
+typedef struct RegexEntry {
+    char* pattern;
+    uint32_t hash;
+    Regex* re;
+    long id;                // > 0 once regex.compile has pinned it
+    struct RegexEntry* bucket_next;
+    struct RegexEntry* lru_prev;
+    struct RegexEntry* lru_next;
+} RegexEntry;
+
+static RegexEntry* regex_cache[REGEX_CACHE_BUCKETS];
+static RegexEntry* regex_lru_head = NULL;
+static RegexEntry* regex_lru_tail = NULL;
+static int regex_lru_count = 0;             // unpinned entries
+static int regex_cache_count = 0;
+static long long regex_cache_hits = 0;
+static long long regex_cache_misses = 0;
+static RegexEntry** regex_handles = NULL;   // pinned entries by id - 1
+static long regex_handle_count = 0;
+static uv_mutex_t regex_lock;
+static uv_once_t regex_once = UV_ONCE_INIT;
+
+static void regex_init_lock(void) {
+    uv_mutex_init(&regex_lock);
+}
+
+static uint32_t regex_hash(const char* s) {
+    uint32_t h = 2166136261u;
+    for (; *s; s++) h = (h ^ (unsigned char)*s) * 16777619u;
+    return h;
+}
+
+static void regex_lru_unlink(RegexEntry* e) {
+    if (e->lru_prev) e->lru_prev->lru_next = e->lru_next;
+    else regex_lru_head = e->lru_next;
+    if (e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+    else regex_lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+    regex_lru_count--;
+}
+
+static void regex_lru_push(RegexEntry* e) {
+    e->lru_next = regex_lru_head;
+    if (regex_lru_head) regex_lru_head->lru_prev = e;
+    regex_lru_head = e;
+    if (!regex_lru_tail) regex_lru_tail = e;
+    regex_lru_count++;
+}
+
+static void regex_cache_remove(RegexEntry* e) {
+    regex_lru_unlink(e);
+    RegexEntry** link = &regex_cache[e->hash % REGEX_CACHE_BUCKETS];
+    while (*link && *link != e) link = &(*link)->bucket_next;
+    if (*link) *link = e->bucket_next;
+    regex_release(e->re);
+    free(e->pattern);
+    free(e);
+    regex_cache_count--;
+}
+
+static RegexEntry* regex_cache_find(const char* pattern, uint32_t hash) {
+    for (RegexEntry* e = regex_cache[hash % REGEX_CACHE_BUCKETS]; e; e = e->bucket_next) {
+        if (e->hash == hash && strcmp(e->pattern, pattern) == 0) return e;
+    }
+    return NULL;
+}
+
+static RegexEntry* regex_handle_find(const char* s) {
+    if (strncmp(s, "regex_", 6) != 0) return NULL;
+    char* end;
+    long id = strtol(s + 6, &end, 10);
+    if (*end != '\0' || id <= 0 || id > regex_handle_count) return NULL;
+    return regex_handles[id - 1];
+}
+
+// Returns the compiled pattern (or handle) with a reference the caller
+// releases. With pin, the entry is kept for good and *id gets its handle id.
+static Regex* regex_acquire(const char* pattern, bool pin, long* id, char* error, size_t error_len) {
+    uv_once(&regex_once, regex_init_lock);
+    uint32_t hash = regex_hash(pattern);
+    uv_mutex_lock(&regex_lock);
+    RegexEntry* e = regex_handle_find(pattern);
+    if (!e) e = regex_cache_find(pattern, hash);
+    if (e) {
+        regex_cache_hits++;
+    } else {
+        regex_cache_misses++;
+        uv_mutex_unlock(&regex_lock);
+        // Compiled unlocked; a thread that raced us to it wins below.
+        Regex* re = regex_compile(pattern, strlen(pattern), error, error_len);
+        if (!re) return NULL;
+        uv_mutex_lock(&regex_lock);
+        e = regex_cache_find(pattern, hash);
+        if (e) {
+            regex_release(re);
+        } else {
+            if (regex_lru_count >= REGEX_CACHE_CAPACITY && regex_lru_tail) {
+                regex_cache_remove(regex_lru_tail);
+            }
+            e = calloc(1, sizeof(RegexEntry));
+            e->pattern = strdup(pattern);
+            e->hash = hash;
+            e->re = re;
+            e->bucket_next = regex_cache[hash % REGEX_CACHE_BUCKETS];
+            regex_cache[hash % REGEX_CACHE_BUCKETS] = e;
+            regex_lru_push(e);
+            regex_cache_count++;
+        }
+    }
+    if (e->id == 0) {
+        regex_lru_unlink(e);
+        if (pin) {
+            regex_handles = realloc(regex_handles, (size_t)(regex_handle_count + 1) * sizeof(RegexEntry*));
+            regex_handles[regex_handle_count++] = e;
+            e->id = regex_handle_count;
+        } else {
+            regex_lru_push(e);
+        }
+    }
+    if (id) *id = e->id;
+    Regex* re = e->re;
+    atomic_fetch_add(&re->refs, 1);
+    uv_mutex_unlock(&regex_lock);
+    return re;
+}
+
+// ---------------------------------------------------------------------------
+// Natives
+// ---------------------------------------------------------------------------
+
+static Regex* regex_arg(const char* fn, int argc, Value* args, int needed) {
+    if (argc < needed || args[0].type != VAL_STRING ||
+        (args[1].type != VAL_STRING && args[1].type != VAL_BYTES)) {
+        fprintf(stderr, "Error: regex.%s() requires a pattern and a string or bytes\n", fn);
+        return NULL;
+    }
+    char error[128];
+    Regex* re = regex_acquire(args[0].string_val, false, NULL, error, sizeof(error));
+    if (!re) fprintf(stderr, "Error: regex.%s(): %s\n", fn, error);
+    return re;
+}
+
+// Match text as a value of the same kind as the subject: bytes slices
+// share the subject's storage, strings are copied out.
+static Value regex_piece(const Value* subject, const char* data, long start, long end) {
+    if (start < 0) return make_null();
+    if (subject->type == VAL_BYTES) {
+        Bytes* b = subject->bytes_val;
+        return make_bytes_view(b->buf, b->offset + (size_t)start, (size_t)(end - start));
+    }
+    char* out = malloc((size_t)(end - start) + 1);
+    memcpy(out, data + start, (size_t)(end - start));
+    out[end - start] = '\0';
+    Value v;
+    v.type = VAL_STRING;
+    v.string_val = out;
+    return v;
+}
+
+static void regex_push(Array* arr, Value v) {
+    if (arr->count >= arr->capacity) {
+        arr->capacity = arr->capacity ? arr->capacity * 2 : 4;
+        arr->items = realloc(arr->items, arr->capacity * sizeof(Value));
+    }
+    arr->items[arr->count++] = v;
+}
+
+static Value regex_groups_value(const Regex* re, const Value* subject, const char* data, const long* caps) {
+    Array* arr = array_create((size_t)re->groups + 1);
+    for (int g = 0; g <= re->groups; g++) {
+        regex_push(arr, regex_piece(subject, data, caps[2 * g], caps[2 * g + 1]));
+    }
+    Value v;
+    v.type = VAL_ARRAY;
+    v.array_val = arr;
+    return v;
+}
+
+// Where to look after a match ending at end: an empty match moves on by
+// one character so the next search makes progress.
+static size_t regex_next_start(const char* data, size_t len, const long* caps) {
+    size_t end = (size_t)caps[1];
+    if (caps[0] != caps[1] || end >= len) return end + (caps[0] == caps[1] ? 1 : 0);
+    size_t step = 1;
+    while (end + step < len && ((unsigned char)data[end + step] & 0xC0) == 0x80) step++;
+    return end + step;
+}
+
+// regex.compile(pattern) -> "regex_<n>" handle, or null if malformed
+Value native_regex_compile(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) {
+        fprintf(stderr, "Error: regex.compile() requires a pattern string\n");
+        return make_null();
+    }
+    char error[128];
+    long id = 0;
+    Regex* re = regex_acquire(args[0].string_val, true, &id, error, sizeof(error));
+    if (!re) {
+        fprintf(stderr, "Error: regex.compile(): %s\n", error);
+        return make_null();
+    }
+    regex_release(re);
+    char handle[32];
+    snprintf(handle, sizeof(handle), "regex_%ld", id);
+    return make_string(handle);
+}
+
+// regex.test(pattern, text) -> true if the pattern occurs in text
+Value native_regex_test(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Regex* re = regex_arg("test", argc, args, 2);
+    if (!re) return make_bool(false);
+    size_t len;
+    const char* data = (const char*)value_bytes(&args[1], &len);
+    long* caps = malloc(2 * (size_t)(re->groups + 1) * sizeof(long));
+    bool found = regex_search(re, data, len, 0, caps);
+    free(caps);
+    regex_release(re);
+    return make_bool(found);
+}
+
+// regex.match(pattern, text) -> [match, group1, ...] for the first match, or null
+Value native_regex_match(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Regex* re = regex_arg("match", argc, args, 2);
+    if (!re) return make_null();
+    size_t len;
+    const char* data = (const char*)value_bytes(&args[1], &len);
+    long* caps = malloc(2 * (size_t)(re->groups + 1) * sizeof(long));
+    Value result = make_null();
+    if (regex_search(re, data, len, 0, caps)) result = regex_groups_value(re, &args[1], data, caps);
+    free(caps);
+    regex_release(re);
+    return result;
+}
+
+// regex.find_all(pattern, text) -> every non-overlapping match; each item is
+// the matched text, or [match, group1, ...] when the pattern has groups
+Value native_regex_find_all(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    Regex* re = regex_arg("find_all", argc, args, 2);
+    if (!re) return make_null();
+    size_t len;
+    const char* data = (const char*)value_bytes(&args[1], &len);
+    long* caps = malloc(2 * (size_t)(re->groups + 1) * sizeof(long));
+    Array* arr = array_create(8);
+    size_t start = 0;
+    while (start <= len && regex_search(re, data, len, start, caps)) {
+        if (re->groups == 0) regex_push(arr, regex_piece(&args[1], data, caps[0], caps[1]));
+        else regex_push(arr, regex_groups_value(re, &args[1], data, caps));
+        start = regex_next_start(data, len, caps);
+    }
+    free(caps);
+    regex_release(re);
+    Value v;
+    v.type = VAL_ARRAY;
+    v.array_val = arr;
+    return v;
+}
+
+static void regex_append(char** out, size_t* used, size_t* cap, const char* s, size_t n) {
+    if (*used + n + 1 > *cap) {
+        while (*used + n + 1 > *cap) *cap *= 2;
+        *out = realloc(*out, *cap);
+    }
+    memcpy(*out + *used, s, n);
+    *used += n;
+}
+
+// regex.replace(pattern, text, replacement) -> text with every match
+// replaced; $0-$9 and ${n} insert groups, $$ is a dollar sign
+Value native_regex_replace(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 3 || args[2].type != VAL_STRING) {
+        fprintf(stderr, "Error: regex.replace() requires a pattern, text and a replacement string\n");
+        return make_null();
+    }
+    Regex* re = regex_arg("replace", argc, args, 3);
+    if (!re) return make_null();
+    size_t len;
+    const char* data = (const char*)value_bytes(&args[1], &len);
+    const char* repl = args[2].string_val;
+    long* caps = malloc(2 * (size_t)(re->groups + 1) * sizeof(long));
+    size_t cap = len + 16, used = 0;
+    char* out = malloc(cap);
+    size_t start = 0, copied = 0;
+    while (start <= len && regex_search(re, data, len, start, caps)) {
+        regex_append(&out, &used, &cap, data + copied, (size_t)caps[0] - copied);
+        for (const char* r = repl; *r; r++) {
+            int group = -1;
+            if (r[0] == '$' && r[1] == '$') {
+                r++;
+            } else if (r[0] == '$' && r[1] >= '0' && r[1] <= '9') {
+                group = r[1] - '0';
+                r++;
+            } else if (r[0] == '$' && r[1] == '{') {
+                char* end;
+                long g = strtol(r + 2, &end, 10);
+                if (end != r + 2 && *end == '}') {
+                    group = (int)g;
+                    r = end;
+                }
+            }
+            if (group < 0) {
+                regex_append(&out, &used, &cap, r, 1);
+            } else if (group <= re->groups && caps[2 * group] >= 0) {
+                regex_append(&out, &used, &cap, data + caps[2 * group],
+                             (size_t)(caps[2 * group + 1] - caps[2 * group]));
+            }
+        }
+        copied = (size_t)caps[1];
+        start = regex_next_start(data, len, caps);
+        // An empty match keeps the character it stepped over.
+        if (caps[0] == caps[1] && start <= len) {
+            regex_append(&out, &used, &cap, data + copied, start - copied);
+            copied = start;
+        }
+    }
+    if (copied < len) regex_append(&out, &used, &cap, data + copied, len - copied);
+    free(caps);
+    regex_release(re);
+    if (args[1].type == VAL_BYTES) {
+        Value v = make_bytes_owned((unsigned char*)out, used, cap);
+        return v;
+    }
+    out[used] = '\0';
+    Value v;
+    v.type = VAL_STRING;
+    v.string_val = out;
+    return v;
+}
+
+// regex.cache_stats() -> [hits, misses, size]
+Value native_regex_cache_stats(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    (void)argc;
+    (void)args;
+    uv_once(&regex_once, regex_init_lock);
+    uv_mutex_lock(&regex_lock);
+    Array* stats = array_create(3);
+    regex_push(stats, make_int(regex_cache_hits));
+    regex_push(stats, make_int(regex_cache_misses));
+    regex_push(stats, make_int(regex_cache_count));
+    uv_mutex_unlock(&regex_lock);
+    Value v;
+    v.type = VAL_ARRAY;
+    v.array_val = stats;
+    return v;
+}
+
+void stdlib_regex_register(void) {
+    register_native("regex.compile", native_regex_compile);
+    register_native("regex.test", native_regex_test);
+    register_native("regex.match", native_regex_match);
+    register_native("regex.find_all", native_regex_find_all);
+    register_native("regex.replace", native_regex_replace);
+    register_native("regex.cache_stats", native_regex_cache_stats);
+    register_handle_methods("regex_", "regex.");
+}
@@ -0,0 +1,49 @@
+#ifndef RADS_REGEX_H
+#define RADS_REGEX_H
+
+#include "../core/interpreter.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Regular expressions behind regex.*.
+//
+// Patterns compile to a program for a Pike VM (a Thompson NFA simulation
+// that carries capture positions along with each thread), so a match takes
+// time linear in the text whatever the pattern: there is no backtracking.
+// Matches are leftmost-first, as in Perl. Syntax:
+//   literals, .  [abc] [^a-z]  \d \w \s \D \W \S  \b \B  ^ $
+//   (group) (?:group)  a|b  * + ? {n} {n,} {n,m} and lazy *? +? ?? {n,m}?
+//   \n \t \r \f \v \xHH, and \ before any punctuation
+//   (?i) (?m) (?s) at the start: ASCII case-insensitive, ^ $ at line
+//   breaks, . matches \n
+// Text is UTF-8: . and classes match whole code points.
+//
+// When a pattern starts with literal text, candidate positions are found
+// with the vectorized text_find before the VM runs.
+//
+// Compiled patterns are shared by every thread, keyed by pattern text; the
+// least recently used one is dropped beyond REGEX_CACHE_CAPACITY.
+// regex.compile keeps its pattern for good and returns a "regex_<n>" handle
+// with methods, e.g. re.match(line). Everywhere a pattern is expected, such
+// a handle may be passed instead.
+
+#define REGEX_CACHE_CAPACITY 256
+#define REGEX_MAX_GROUPS 64
+#define REGEX_MAX_REPEAT 1000
+#define REGEX_MAX_PROGRAM 20000
+
+typedef struct Regex Regex;
+
+// Returns NULL and fills error when the pattern is malformed.
+Regex* regex_compile(const char* pattern, size_t len, char* error, size_t error_len);
+void regex_release(Regex* re);
+int regex_groups(const Regex* re);
+
+// Leftmost-first match in text starting at or after start. caps receives
+// 2 * (groups + 1) offsets: the match, then each group (-1 for groups that
+// took no part). Assertions see the text before start.
+bool regex_search(const Regex* re, const char* text, size_t len, size_t start, long* caps);
+
+void stdlib_regex_register(void);
+
+#endif
@@ -0,0 +1,636 @@
+#include "stdlib_session.h"
+#include "stdlib_json.h"
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/random.h>
+
+typedef struct SessionField {
+    char* key;
+    char* value;
+} SessionField;
+
+typedef struct Session {
+    char id[SESSION_ID_LEN + 1];
+    uint64_t hash;
+    SessionField* fields;
+    int count;
+    int cap;
+    time_t created;
+    time_t last_accessed;
+    int ttl;
+    bool queued;                      // id is in the shard's persistence queue
+    unsigned wheel_slot;
+    struct Session* hash_next;
+    struct Session* lru_prev;         // towards most recently used
+    struct Session* lru_next;
+    struct Session* wheel_prev;
+    struct Session* wheel_next;
+} Session;
+
+typedef struct SessionShard {
+    uv_mutex_t lock;
+    Session** buckets;
+    size_t nbuckets;
+    size_t count;
+    Session* lru_head;
+    Session* lru_tail;
+    // Sessions sit in the slot of their deadline (mod the wheel size). A
+    // touch only moves the deadline; the session is re-slotted lazily when
+    // its old slot comes round.
+    Session* wheel[SESSION_WHEEL_SLOTS];
+    time_t wheel_time;                // last second processed
+    size_t expired;
+    size_t evicted;
+    char (*pending)[SESSION_ID_LEN + 1];
+    size_t npending;
+    size_t pending_cap;
+} SessionShard;
+
+static SessionShard session_shards[SESSION_SHARDS];
+static uv_once_t session_once = UV_ONCE_INIT;
+static size_t session_max = SESSION_DEFAULT_MAX;
+static int session_ttl = SESSION_DEFAULT_TTL;
+
+static uv_mutex_t persist_lock;
+static sqlite3* persist_db = NULL;
+static sqlite3_stmt* persist_upsert = NULL;
+static sqlite3_stmt* persist_delete = NULL;
+static bool persist_enabled = false;
+static bool persist_atexit = false;
+
+static uv_timer_t session_timer;
+static bool session_timer_started = false;
+
+static void session_init_once(void) {
+    for (int i = 0; i < SESSION_SHARDS; i++) uv_mutex_init(&session_shards[i].lock);
+    uv_mutex_init(&persist_lock);
+}
+
+static uint64_t session_hash(const char* id) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const char* p = id; *p; p++) {
+        h ^= (unsigned char)*p;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static SessionShard* session_shard(uint64_t hash) {
+    return &session_shards[hash % SESSION_SHARDS];
+}
+
+static size_t session_bucket(const SessionShard* sh, uint64_t hash) {
+    return (size_t)(hash / SESSION_SHARDS) & (sh->nbuckets - 1);
+}
+
+// Sessions across all shards; checked against session_max on insert.
+static size_t session_total = 0;
+
+static void session_free(Session* s) {
+    for (int i = 0; i < s->count; i++) {
+        free(s->fields[i].key);
+        free(s->fields[i].value);
+    }
+    free(s->fields);
+    free(s);
+}
+
+static void session_queue(SessionShard* sh, Session* s) {
+    if (!persist_enabled || s->queued) return;
+    if (sh->npending == sh->pending_cap) {
+        sh->pending_cap = sh->pending_cap ? sh->pending_cap * 2 : 64;
+        sh->pending = realloc(sh->pending, sh->pending_cap * sizeof(*sh->pending));
+    }
+    memcpy(sh->pending[sh->npending++], s->id, SESSION_ID_LEN + 1);
+    s->queued = true;
+}
+
+// ---------------------------------------------------------------------------
+// Shard structure (callers hold sh->lock)
+// ---------------------------------------------------------------------------
+
+static void wheel_insert(SessionShard* sh, Session* s) {
+    size_t slot = (size_t)(s->last_accessed + s->ttl) % SESSION_WHEEL_SLOTS;
+    s->wheel_slot = (unsigned)slot;
+    s->wheel_prev = NULL;
+    s->wheel_next = sh->wheel[slot];
+    if (sh->wheel[slot]) sh->wheel[slot]->wheel_prev = s;
+    sh->wheel[slot] = s;
+}
+
+static void wheel_remove(SessionShard* sh, Session* s) {
+    if (s->wheel_prev) {
+        s->wheel_prev->wheel_next = s->wheel_next;
+    } else if (sh->wheel[s->wheel_slot] == s) {
+        sh->wheel[s->wheel_slot] = s->wheel_next;
+    }
+    if (s->wheel_next) s->wheel_next->wheel_prev = s->wheel_prev;
+    s->wheel_prev = s->wheel_next = NULL;
+}
+
+static void lru_unlink(SessionShard* sh, Session* s) {
+    if (s->lru_prev) s->lru_prev->lru_next = s->lru_next;
+    else sh->lru_head = s->lru_next;
+    if (s->lru_next) s->lru_next->lru_prev = s->lru_prev;
+    else sh->lru_tail = s->lru_prev;
+    s->lru_prev = s->lru_next = NULL;
+}
+
+static void lru_push(SessionShard* sh, Session* s) {
+    s->lru_next = sh->lru_head;
+    if (sh->lru_head) sh->lru_head->lru_prev = s;
+    sh->lru_head = s;
+    if (!sh->lru_tail) sh->lru_tail = s;
+}
+
+static void shard_grow(SessionShard* sh) {
+    size_t nb = sh->nbuckets ? sh->nbuckets * 2 : 64;
+    Session** buckets = calloc(nb, sizeof(Session*));
+    if (!buckets) return;
+    for (size_t i = 0; i < sh->nbuckets; i++) {
+        Session* s = sh->buckets[i];
+        while (s) {
+            Session* next = s->hash_next;
+            size_t b = (size_t)(s->hash / SESSION_SHARDS) & (nb - 1);
+            s->hash_next = buckets[b];
+            buckets[b] = s;
+            s = next;
+        }
+    }
+    free(sh->buckets);
+    sh->buckets = buckets;
+    sh->nbuckets = nb;
+}
+
+static Session* shard_find(SessionShard* sh, const char* id, uint64_t hash) {
+    if (!sh->nbuckets) return NULL;
+    for (Session* s = sh->buckets[session_bucket(sh, hash)]; s; s = s->hash_next) {
+        if (s->hash == hash && strcmp(s->id, id) == 0) return s;
+    }
+    return NULL;
+}
+
+static void shard_unlink(SessionShard* sh, Session* s) {
+    Session** link = &sh->buckets[session_bucket(sh, s->hash)];
+    while (*link && *link != s) link = &(*link)->hash_next;
+    if (*link) *link = s->hash_next;
+    lru_unlink(sh, s);
+    wheel_remove(sh, s);
+    sh->count--;
+    __atomic_fetch_sub(&session_total, 1, __ATOMIC_RELAXED);
+}
+
+// Removes and frees s, queueing its deletion from the database.
+static void shard_drop(SessionShard* sh, Session* s) {
+    shard_unlink(sh, s);
+    s->queued = false;
+    session_queue(sh, s);
+    session_free(s);
+}
+
+// Over the limit, the inserting shard gives up its least recently used
+// session, which approximates a global LRU without a global lock. An empty
+// shard takes the eviction from the next shard it can lock without waiting,
+// so two inserting shards never wait on each other.
+static void shard_link(SessionShard* sh, Session* s) {
+    while (__atomic_load_n(&session_total, __ATOMIC_RELAXED) >= session_max && sh->lru_tail) {
+        shard_drop(sh, sh->lru_tail);
+        sh->evicted++;
+    }
+    size_t self = (size_t)(sh - session_shards);
+    for (size_t i = 1; i < SESSION_SHARDS && __atomic_load_n(&session_total, __ATOMIC_RELAXED) >= session_max; i++) {
+        SessionShard* other = &session_shards[(self + i) % SESSION_SHARDS];
+        if (uv_mutex_trylock(&other->lock) != 0) continue;
+        if (other->lru_tail) {
+            shard_drop(other, other->lru_tail);
+            other->evicted++;
+        }
+        uv_mutex_unlock(&other->lock);
+    }
+    if (sh->count >= sh->nbuckets) shard_grow(sh);
+    size_t b = session_bucket(sh, s->hash);
+    s->hash_next = sh->buckets[b];
+    sh->buckets[b] = s;
+    lru_push(sh, s);
+    if (!sh->wheel_time) sh->wheel_time = s->last_accessed;
+    wheel_insert(sh, s);
+    sh->count++;
+    __atomic_fetch_add(&session_total, 1, __ATOMIC_RELAXED);
+}
+
+// Finds a live session; one past its deadline is dropped on the spot.
+static Session* shard_lookup(SessionShard* sh, const char* id, uint64_t hash, time_t now) {
+    Session* s = shard_find(sh, id, hash);
+    if (s && s->last_accessed + s->ttl <= now) {
+        shard_drop(sh, s);
+        sh->expired++;
+        return NULL;
+    }
+    return s;
+}
+
+static void shard_touch(SessionShard* sh, Session* s, time_t now) {
+    s->last_accessed = now;
+    if (sh->lru_head != s) {
+        lru_unlink(sh, s);
+        lru_push(sh, s);
+    }
+}
+
+static void shard_expire(SessionShard* sh, time_t now) {
+    if (!sh->wheel_time || now <= sh->wheel_time) return;
+    time_t steps = now - sh->wheel_time;
+    if (steps > SESSION_WHEEL_SLOTS) steps = SESSION_WHEEL_SLOTS;
+    for (time_t t = now - steps + 1; t <= now; t++) {
+        size_t slot = (size_t)t % SESSION_WHEEL_SLOTS;
+        Session* s = sh->wheel[slot];
+        sh->wheel[slot] = NULL;
+        while (s) {
+            Session* next = s->wheel_next;
+            s->wheel_prev = s->wheel_next = NULL;
+            if (s->last_accessed + s->ttl <= now) {
+                shard_drop(sh, s);
+                sh->expired++;
+            } else {
+                wheel_insert(sh, s);
+            }
+            s = next;
+        }
+    }
+    sh->wheel_time = now;
+}
+
+static bool session_field_set(Session* s, const char* key, const char* value) {
+    for (int i = 0; i < s->count; i++) {
+        if (strcmp(s->fields[i].key, key) == 0) {
+            char* copy = strdup(value);
+            if (!copy) return false;
+            free(s->fields[i].value);
+            s->fields[i].value = copy;
+            return true;
+        }
+    }
+    if (s->count == s->cap) {
+        int cap = s->cap ? s->cap * 2 : 4;
+        SessionField* fields = realloc(s->fields, (size_t)cap * sizeof(SessionField));
+        if (!fields) return false;
+        s->fields = fields;
+        s->cap = cap;
+    }
+    s->fields[s->count].key = strdup(key);
+    s->fields[s->count].value = strdup(value);
+    s->count++;
+    return true;
+}
+
+// Ids come from getrandom(), drawn in blocks so that creating a session
+// is not a system call each time.
+static void session_new_id(char id[SESSION_ID_LEN + 1]) {
+    static _Thread_local unsigned char pool[1024];
+    static _Thread_local size_t pool_pos = sizeof(pool);
+    const size_t need = SESSION_ID_LEN / 2;
+    if (pool_pos + need > sizeof(pool)) {
+        size_t got = 0;
+        while (got < sizeof(pool)) {
+            ssize_t n = getrandom(pool + got, sizeof(pool) - got, 0);
+            if (n <= 0) break;
+            got += (size_t)n;
+        }
+        for (; got < sizeof(pool); got++) pool[got] = (unsigned char)rand();
+        pool_pos = 0;
+    }
+    const unsigned char* raw = pool + pool_pos;
+    for (size_t i = 0; i < need; i++) {
+        id[i * 2] = "0123456789abcdef"[raw[i] >> 4];
+        id[i * 2 + 1] = "0123456789abcdef"[raw[i] & 15];
+    }
+    memset(pool + pool_pos, 0, need);
+    pool_pos += need;
+    id[SESSION_ID_LEN] = '\0';
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void session_store_create(char id[SESSION_ID_LEN + 1], int ttl) {
+    uv_once(&session_once, session_init_once);
+    time_t now = time(NULL);
+    Session* s = calloc(1, sizeof(Session));
+    if (!s) {
+        id[0] = '\0';
+        return;
+    }
+    s->created = s->last_accessed = now;
+    s->ttl = ttl > 0 ? ttl : session_ttl;
+    for (;;) {
+        session_new_id(s->id);
+        s->hash = session_hash(s->id);
+        SessionShard* sh = session_shard(s->hash);
+        uv_mutex_lock(&sh->lock);
+        if (!shard_find(sh, s->id, s->hash)) {
+            shard_link(sh, s);
+            session_queue(sh, s);
+            uv_mutex_unlock(&sh->lock);
+            break;
+        }
+        uv_mutex_unlock(&sh->lock);
+    }
+    memcpy(id, s->id, SESSION_ID_LEN + 1);
+}
+
+bool session_store_exists(const char* id) {
+    if (!id) return false;
+    uv_once(&session_once, session_init_once);
+    uint64_t hash = session_hash(id);
+    SessionShard* sh = session_shard(hash);
+    uv_mutex_lock(&sh->lock);
+    bool found = shard_lookup(sh, id, hash, time(NULL)) != NULL;
+    uv_mutex_unlock(&sh->lock);
+    return found;
+}
+
+char* session_store_get(const char* id, const char* key) {
+    if (!id || !key) return NULL;
+    uv_once(&session_once, session_init_once);
+    time_t now = time(NULL);
+    uint64_t hash = session_hash(id);
+    SessionShard* sh = session_shard(hash);
+    char* value = NULL;
+    uv_mutex_lock(&sh->lock);
+    Session* s = shard_lookup(sh, id, hash, now);
+    if (s) {
+        shard_touch(sh, s, now);
+        for (int i = 0; i < s->count; i++) {
+            if (strcmp(s->fields[i].key, key) == 0) {
+                value = strdup(s->fields[i].value);
+                break;
+            }
+        }
+    }
+    uv_mutex_unlock(&sh->lock);
+    return value;
+}
+
+bool session_store_set(const char* id, const char* key, const char* value) {
+    if (!id || !key || !value) return false;
+    uv_once(&session_once, session_init_once);
+    time_t now = time(NULL);
+    uint64_t hash = session_hash(id);
+    SessionShard* sh = session_shard(hash);
+    bool ok = false;
+    uv_mutex_lock(&sh->lock);
+    Session* s = shard_lookup(sh, id, hash, now);
+    if (s) {
+        shard_touch(sh, s, now);
+        ok = session_field_set(s, key, value);
+        session_queue(sh, s);
+    }
+    uv_mutex_unlock(&sh->lock);
+    return ok;
+}
+
+bool session_store_destroy(const char* id) {
+    if (!id) return false;
+    uv_once(&session_once, session_init_once);
+    uint64_t hash = session_hash(id);
+    SessionShard* sh = session_shard(hash);
+    uv_mutex_lock(&sh->lock);
+    Session* s = shard_find(sh, id, hash);
+    if (s) shard_drop(sh, s);
+    uv_mutex_unlock(&sh->lock);
+    return s != NULL;
+}
+
+size_t session_store_expire(time_t now) {
+    uv_once(&session_once, session_init_once);
+    size_t total = 0;
+    for (int i = 0; i < SESSION_SHARDS; i++) {
+        SessionShard* sh = &session_shards[i];
+        uv_mutex_lock(&sh->lock);
+        size_t before = sh->expired;
+        shard_expire(sh, now);
+        total += sh->expired - before;
+        uv_mutex_unlock(&sh->lock);
+    }
+    return total;
+}
+
+void session_store_stats(SessionStoreStats* out) {
+    uv_once(&session_once, session_init_once);
+    memset(out, 0, sizeof(*out));
+    for (int i = 0; i < SESSION_SHARDS; i++) {
+        SessionShard* sh = &session_shards[i];
+        uv_mutex_lock(&sh->lock);
+        out->count += sh->count;
+        out->expired += sh->expired;
+        out->evicted += sh->evicted;
+        uv_mutex_unlock(&sh->lock);
+    }
+}
+
+static void session_timer_cb(uv_timer_t* timer) {
+    (void)timer;
+    session_store_expire(time(NULL));
+    session_store_flush();
+}
+
+void session_store_attach(uv_loop_t* loop) {
+    if (session_timer_started || !loop) return;
+    session_timer_started = true;
+    uv_timer_init(loop, &session_timer);
+    uv_timer_start(&session_timer, session_timer_cb, 1000, 1000);
+    uv_unref((uv_handle_t*)&session_timer);
+}
+
+// ---------------------------------------------------------------------------
+// Persistence
+// ---------------------------------------------------------------------------
+
+typedef struct SessionBuf {
+    char* data;
+    size_t len;
+    size_t cap;
+} SessionBuf;
+
+static void sb_reserve(SessionBuf* b, size_t extra) {
+    if (b->len + extra <= b->cap) return;
+    size_t cap = b->cap ? b->cap : 128;
+    while (cap < b->len + extra) cap *= 2;
+    b->data = realloc(b->data, cap);
+    b->cap = cap;
+}
+
+static void sb_string(SessionBuf* b, const char* s) {
+    sb_reserve(b, strlen(s) * 6 + 2);
+    char* o = b->data + b->len;
+    *o++ = '"';
+    for (const unsigned char* p = (const unsigned char*)s; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            *o++ = '\\';
+            *o++ = (char)*p;
+        } else if (*p < 0x20) {
+            o += sprintf(o, "\\u%04x", *p);
+        } else {
+            *o++ = (char)*p;
+        }
+    }
+    *o++ = '"';
+    b->len = (size_t)(o - b->data);
+}
+
+static void sb_char(SessionBuf* b, char c) {
+    sb_reserve(b, 1);
+    b->data[b->len++] = c;
+}
+
+// Fields are stored as a flat JSON object of strings.
+static char* session_encode(const Session* s, size_t* out_len) {
+    SessionBuf b = { NULL, 0, 0 };
+    sb_char(&b, '{');
+    for (int i = 0; i < s->count; i++) {
+        if (i) sb_char(&b, ',');
+        sb_string(&b, s->fields[i].key);
+        sb_char(&b, ':');
+        sb_string(&b, s->fields[i].value);
+    }
+    sb_char(&b, '}');
+    *out_len = b.len;
+    return b.data;
+}
+
+void session_store_flush(void) {
+    uv_once(&session_once, session_init_once);
+    uv_mutex_lock(&persist_lock);
+    if (!persist_db) {
+        uv_mutex_unlock(&persist_lock);
+        return;
+    }
+    sqlite3_exec(persist_db, "BEGIN", NULL, NULL, NULL);
+    for (int i = 0; i < SESSION_SHARDS; i++) {
+        SessionShard* sh = &session_shards[i];
+        uv_mutex_lock(&sh->lock);
+        for (size_t k = 0; k < sh->npending; k++) {
+            const char* id = sh->pending[k];
+            Session* s = shard_find(sh, id, session_hash(id));
+            if (s) {
+                size_t len;
+                char* data = session_encode(s, &len);
+                sqlite3_bind_text(persist_upsert, 1, id, -1, SQLITE_STATIC);
+                sqlite3_bind_text(persist_upsert, 2, data, (int)len, SQLITE_STATIC);
+                sqlite3_bind_int64(persist_upsert, 3, s->created);
+                sqlite3_bind_int64(persist_upsert, 4, s->last_accessed);
+                sqlite3_bind_int(persist_upsert, 5, s->ttl);
+                sqlite3_step(persist_upsert);
+                sqlite3_reset(persist_upsert);
+                free(data);
+                s->queued = false;
+            } else {
+                sqlite3_bind_text(persist_delete, 1, id, -1, SQLITE_STATIC);
+                sqlite3_step(persist_delete);
+                sqlite3_reset(persist_delete);
+            }
+        }
+        sh->npending = 0;
+        uv_mutex_unlock(&sh->lock);
+    }
+    sqlite3_exec(persist_db, "COMMIT", NULL, NULL, NULL);
+    uv_mutex_unlock(&persist_lock);
+}
+
+static void session_load(sqlite3* db, time_t now) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT id, data, created, last_accessed, ttl FROM sessions", -1, &stmt, NULL) != SQLITE_OK) {
+        return;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* id = (const char*)sqlite3_column_text(stmt, 0);
+        const char* data = (const char*)sqlite3_column_text(stmt, 1);
+        time_t last = (time_t)sqlite3_column_int64(stmt, 3);
+        int ttl = sqlite3_column_int(stmt, 4);
+        if (!id || strlen(id) != SESSION_ID_LEN || ttl <= 0 || last + ttl <= now) continue;
+        Session* s = calloc(1, sizeof(Session));
+        memcpy(s->id, id, SESSION_ID_LEN + 1);
+        s->hash = session_hash(s->id);
+        s->created = (time_t)sqlite3_column_int64(stmt, 2);
+        s->last_accessed = last;
+        s->ttl = ttl;
+        Value fields;
+        char error[64];
+        if (data && json_parse_text(data, strlen(data), &fields, error, sizeof(error))) {
+            if (fields.type == VAL_STRUCT_INSTANCE && fields.struct_instance) {
+                for (FieldValue* f = fields.struct_instance->fields; f; f = f->next) {
+                    if (f->value->type == VAL_STRING) session_field_set(s, f->name, f->value->string_val);
+                }
+            }
+            value_free(&fields);
+        }
+        SessionShard* sh = session_shard(s->hash);
+        uv_mutex_lock(&sh->lock);
+        Session* old = shard_find(sh, s->id, s->hash);
+        if (old) shard_drop(sh, old);
+        shard_link(sh, s);
+        uv_mutex_unlock(&sh->lock);
+    }
+    sqlite3_finalize(stmt);
+}
+
+static void session_persist_close(void) {
+    if (!persist_db) return;
+    sqlite3_finalize(persist_upsert);
+    sqlite3_finalize(persist_delete);
+    sqlite3_close(persist_db);
+    persist_db = NULL;
+    persist_upsert = persist_delete = NULL;
+    persist_enabled = false;
+}
+
+bool session_store_configure(size_t max_sessions, int ttl, const char* persist_path,
+                             char* error, size_t error_len) {
+    uv_once(&session_once, session_init_once);
+    if (max_sessions > 0) session_max = max_sessions;
+    if (ttl > 0) session_ttl = ttl;
+    if (!persist_path) return true;
+
+    session_store_flush();
+    uv_mutex_lock(&persist_lock);
+    session_persist_close();
+    sqlite3* db = NULL;
+    if (sqlite3_open(persist_path, &db) != SQLITE_OK ||
+        sqlite3_exec(db,
+                     "PRAGMA journal_mode=WAL;"
+                     "PRAGMA synchronous=NORMAL;"
+                     "CREATE TABLE IF NOT EXISTS sessions ("
+                     "id TEXT PRIMARY KEY, data TEXT NOT NULL, created INTEGER NOT NULL, "
+                     "last_accessed INTEGER NOT NULL, ttl INTEGER NOT NULL)",
+                     NULL, NULL, NULL) != SQLITE_OK) {
+        snprintf(error, error_len, "%s", db ? sqlite3_errmsg(db) : "out of memory");
+        sqlite3_close(db);
+        uv_mutex_unlock(&persist_lock);
+        return false;
+    }
+    time_t now = time(NULL);
+    sqlite3_stmt* purge;
+    if (sqlite3_prepare_v2(db, "DELETE FROM sessions WHERE last_accessed + ttl <= ?", -1, &purge, NULL) == SQLITE_OK) {
+        sqlite3_bind_int64(purge, 1, now);
+        sqlite3_step(purge);
+        sqlite3_finalize(purge);
+    }
+    session_load(db, now);
+    sqlite3_prepare_v2(db,
+                       "INSERT OR REPLACE INTO sessions (id, data, created, last_accessed, ttl) "
+                       "VALUES (?, ?, ?, ?, ?)",
+                       -1, &persist_upsert, NULL);
+    sqlite3_prepare_v2(db, "DELETE FROM sessions WHERE id = ?", -1, &persist_delete, NULL);
+    persist_db = db;
+    persist_enabled = true;
+    if (!persist_atexit) {
+        persist_atexit = true;
+        atexit(session_store_flush);
+    }
+    uv_mutex_unlock(&persist_lock);
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef RADS_SESSION_H
+#define RADS_SESSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <uv.h>
+
+// Server-side session store behind net.session_*.
+//
+// Sessions live in SESSION_SHARDS independently locked shards, each with
+// its own hash index, LRU list and one-second timer wheel, so lookups are
+// O(1) and workers on other threads only contend within a shard. Sessions
+// expire SESSION_DEFAULT_TTL seconds after their last access unless the
+// TTL is configured; at the size limit the inserting shard evicts its least
+// recently used session (or, when empty, a neighbouring shard's).
+//
+// With a persistence path the store is mirrored into a SQLite table:
+// changes are queued and written in one transaction per second (and at
+// exit), and unexpired sessions are loaded back on configure.
+
+#define SESSION_SHARDS 64
+#define SESSION_WHEEL_SLOTS 4096
+#define SESSION_DEFAULT_TTL 1800
+#define SESSION_DEFAULT_MAX 1000000
+#define SESSION_ID_LEN 32
+
+typedef struct SessionStoreStats {
+    size_t count;
+    size_t expired;
+    size_t evicted;
+} SessionStoreStats;
+
+// max_sessions and ttl of 0 keep the current value; persist_path may be
+// NULL. Returns false and fills error if the database cannot be opened.
+bool session_store_configure(size_t max_sessions, int ttl, const char* persist_path,
+                             char* error, size_t error_len);
+
+// Creates a session and writes its id (SESSION_ID_LEN hex chars) into id.
+// ttl <= 0 uses the store default.
+void session_store_create(char id[SESSION_ID_LEN + 1], int ttl);
+
+bool session_store_exists(const char* id);
+// Returns a heap copy of the value, or NULL.
+char* session_store_get(const char* id, const char* key);
+bool session_store_set(const char* id, const char* key, const char* value);
+bool session_store_destroy(const char* id);
+
+// Starts the once-a-second expiry/flush timer on loop (unreferenced, so it
+// never keeps the loop alive). Call from the loop thread; later calls are
+// no-ops.
+void session_store_attach(uv_loop_t* loop);
+
+// Drops sessions whose deadline has passed; returns how many.
+size_t session_store_expire(time_t now);
+// Writes queued changes to the persistence database, if any.
+void session_store_flush(void);
+void session_store_stats(SessionStoreStats* out);
+
+#endif
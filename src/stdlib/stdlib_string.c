@@ -1,9 +1,9 @@
 #define _POSIX_C_SOURCE 200809L
 #include "stdlib_string.h"
+#include "../core/textscan.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 
 static bool check_argc(int argc, int expected) {
     return argc == expected;
@@ -12,16 +12,12 @@ static bool check_argc(int argc, int expected) {
 Value native_str_length(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
     
-    if (!check_argc(argc, 1) || args[0].type != VAL_STRING) {
-        Value v;
-        v.type = VAL_INT;
-        v.int_val = 0;
-        return v;
-    }
+    size_t len = 0;
+    if (check_argc(argc, 1)) value_bytes(&args[0], &len);
     
     Value v;
     v.type = VAL_INT;
-    v.int_val = strlen(args[0].string_val);
+    v.int_val = (long long)len;
     return v;
 }
 
@@ -34,10 +30,10 @@ Value native_str_upper(struct Interpreter* interp, int argc, Value* args) {
         return v;
     }
     
-    char* str = strdup(args[0].string_val);
-    for (int i = 0; str[i]; i++) {
-        str[i] = toupper((unsigned char)str[i]);
-    }
+    size_t len = strlen(args[0].string_val);
+    char* str = malloc(len + 1);
+    text_upper(str, args[0].string_val, len);
+    str[len] = '\0';
     
     Value v;
     v.type = VAL_STRING;
@@ -54,10 +50,10 @@ Value native_str_lower(struct Interpreter* interp, int argc, Value* args) {
         return v;
     }
     
-    char* str = strdup(args[0].string_val);
-    for (int i = 0; str[i]; i++) {
-        str[i] = tolower((unsigned char)str[i]);
-    }
+    size_t len = strlen(args[0].string_val);
+    char* str = malloc(len + 1);
+    text_lower(str, args[0].string_val, len);
+    str[len] = '\0';
     
     Value v;
     v.type = VAL_STRING;
@@ -75,26 +71,10 @@ Value native_str_trim(struct Interpreter* interp, int argc, Value* args) {
     }
     
     const char* str = args[0].string_val;
-    
-    // Trim leading whitespace
-    while (*str && isspace((unsigned char)*str)) {
-        str++;
-    }
-    
-    if (*str == '\0') {
-        Value v;
-        v.type = VAL_STRING;
-        v.string_val = strdup("");
-        return v;
-    }
-    
-    // Trim trailing whitespace
-    const char* end = str + strlen(str) - 1;
-    while (end > str && isspace((unsigned char)*end)) {
-        end--;
-    }
-    
-    size_t len = end - str + 1;
+    size_t len = strlen(str);
+    size_t start = text_skip_space(str, len);
+    str += start;
+    len = text_trim_end(str, len - start);
     char* result = malloc(len + 1);
     memcpy(result, str, len);
     result[len] = '\0';
@@ -155,7 +135,8 @@ Value native_str_contains(struct Interpreter* interp, int argc, Value* args) {
     
     Value v;
     v.type = VAL_BOOL;
-    v.bool_val = (strstr(args[0].string_val, args[1].string_val) != NULL);
+    v.bool_val = text_find(args[0].string_val, strlen(args[0].string_val),
+                           args[1].string_val, strlen(args[1].string_val)) != NULL;
     return v;
 }
 
@@ -173,14 +154,9 @@ Value native_str_replace(struct Interpreter* interp, int argc, Value* args) {
     const char* find = args[1].string_val;
     const char* replace = args[2].string_val;
     
-    if (strlen(find) == 0) {
-        Value v;
-        v.type = VAL_STRING;
-        v.string_val = strdup(str);
-        return v;
-    }
-    
-    const char* pos = strstr(str, find);
+    size_t str_len = strlen(str);
+    size_t find_len = strlen(find);
+    const char* pos = find_len > 0 ? text_find(str, str_len, find, find_len) : NULL;
     if (!pos) {
         Value v;
         v.type = VAL_STRING;
@@ -189,9 +165,8 @@ Value native_str_replace(struct Interpreter* interp, int argc, Value* args) {
     }
     
     size_t prefix_len = pos - str;
-    size_t find_len = strlen(find);
     size_t replace_len = strlen(replace);
-    size_t suffix_len = strlen(pos + find_len);
+    size_t suffix_len = str_len - prefix_len - find_len;
     
     char* result = malloc(prefix_len + replace_len + suffix_len + 1);
     memcpy(result, str, prefix_len);
@@ -252,7 +227,24 @@ Value native_str_ends_with(struct Interpreter* interp, int argc, Value* args) {
     return v;
 }
 
+// str.is_utf8(s) -> bool. Also checks bytes, e.g. before bytes.to_string.
+Value native_str_is_utf8(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    size_t len = 0;
+    const unsigned char* data = check_argc(argc, 1) ? value_bytes(&args[0], &len) : NULL;
+    return make_bool(data && text_utf8_valid((const char*)data, len));
+}
+
+// str.char_count(s) -> number of UTF-8 code points (str.length counts bytes)
+Value native_str_char_count(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    size_t len = 0;
+    const unsigned char* data = check_argc(argc, 1) ? value_bytes(&args[0], &len) : NULL;
+    return make_int(data ? (long long)text_utf8_count((const char*)data, len) : 0);
+}
+
 void stdlib_string_register(void) {
+    textscan_init();
     register_native("str.length", native_str_length);
     register_native("str.upper", native_str_upper);
     register_native("str.lower", native_str_lower);
@@ -262,4 +254,6 @@ void stdlib_string_register(void) {
     register_native("str.replace", native_str_replace);
     register_native("str.starts_with", native_str_starts_with);
     register_native("str.ends_with", native_str_ends_with);
+    register_native("str.is_utf8", native_str_is_utf8);
+    register_native("str.char_count", native_str_char_count);
 }
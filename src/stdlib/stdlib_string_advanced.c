@@ -1,13 +1,32 @@
 #include "stdlib_string_advanced.h"
+#include "../core/textscan.h"
+#include <stdatomic.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
 
 extern Value make_string(const char* val);
 extern Array* array_create(size_t capacity);
 extern void array_push(Array* arr, Value v);
 
+static Value string_from_range(const char* start, size_t len) {
+    char* out = malloc(len + 1);
+    memcpy(out, start, len);
+    out[len] = '\0';
+    Value v;
+    v.type = VAL_STRING;
+    v.string_val = out;
+    return v;
+}
+
+static void array_append_owned(Array* arr, Value v) {
+    if (arr->count >= arr->capacity) {
+        arr->capacity *= 2;
+        arr->items = realloc(arr->items, arr->capacity * sizeof(Value));
+    }
+    arr->items[arr->count++] = v;
+}
+
 Value stdlib_string_split(struct Interpreter* interp, int argc, Value* args) {
     (void)interp;
     if (argc < 2) {
@@ -24,23 +43,21 @@ Value stdlib_string_split(struct Interpreter* interp, int argc, Value* args) {
         return v;
     }
 
-    char* str = args[0].string_val;
-    char* sep = args[1].string_val;
+    // The separator is a substring; empty fields are kept, so joining the
+    // pieces with it gives the string back.
+    const char* str = args[0].string_val;
+    const char* sep = args[1].string_val;
+    size_t len = strlen(str);
+    size_t sep_len = strlen(sep);
     
     Array* result_arr = array_create(8);
-    
-    char* str_copy = strdup(str);
-    char* token = strtok(str_copy, sep);
-    
-    while (token != NULL) {
-        Value item;
-        item.type = VAL_STRING;
-        item.string_val = strdup(token);
-        array_push(result_arr, item);
-        token = strtok(NULL, sep);
+    size_t pos = 0;
+    const char* hit;
+    while (sep_len > 0 && (hit = text_find(str + pos, len - pos, sep, sep_len)) != NULL) {
+        array_append_owned(result_arr, string_from_range(str + pos, (size_t)(hit - (str + pos))));
+        pos = (size_t)(hit - str) + sep_len;
     }
-    
-    free(str_copy);
+    array_append_owned(result_arr, string_from_range(str + pos, len - pos));
     
     Value result;
     result.type = VAL_ARRAY;
@@ -66,27 +83,35 @@ Value stdlib_string_join(struct Interpreter* interp, int argc, Value* args) {
 
     Array* arr = args[0].array_val;
     char* sep = args[1].string_val;
+    size_t sep_len = strlen(sep);
     
     size_t total_len = 1;
     for (size_t i = 0; i < arr->count; i++) {
         if (arr->items[i].type == VAL_STRING) {
             total_len += strlen(arr->items[i].string_val);
         }
-        if (i > 0) total_len += strlen(sep);
+        if (i > 0) total_len += sep_len;
     }
     
     char* result = malloc(total_len);
-    result[0] = '\0';
+    char* dst = result;
     
     for (size_t i = 0; i < arr->count; i++) {
-        if (i > 0) strcat(result, sep);
+        if (i > 0) {
+            memcpy(dst, sep, sep_len);
+            dst += sep_len;
+        }
         if (arr->items[i].type == VAL_STRING) {
-            strcat(result, arr->items[i].string_val);
+            size_t item_len = strlen(arr->items[i].string_val);
+            memcpy(dst, arr->items[i].string_val, item_len);
+            dst += item_len;
         }
     }
+    *dst = '\0';
     
-    Value v = make_string(result);
-    free(result);
+    Value v;
+    v.type = VAL_STRING;
+    v.string_val = result;
     return v;
 }
 
@@ -106,25 +131,10 @@ Value stdlib_string_trim(struct Interpreter* interp, int argc, Value* args) {
         return v;
     }
 
-    char* str = args[0].string_val;
-    
-    while (isspace((unsigned char)*str)) str++;
-    
-    if (*str == '\0') {
-        return make_string("");
-    }
-    
-    char* end = str + strlen(str) - 1;
-    while (end > str && isspace((unsigned char)*end)) end--;
-    
-    size_t len = end - str + 1;
-    char* trimmed = malloc(len + 1);
-    strncpy(trimmed, str, len);
-    trimmed[len] = '\0';
-    
-    Value v = make_string(trimmed);
-    free(trimmed);
-    return v;
+    const char* str = args[0].string_val;
+    size_t len = strlen(str);
+    size_t start = text_skip_space(str, len);
+    return string_from_range(str + start, text_trim_end(str + start, len - start));
 }
 
 Value stdlib_string_upper(struct Interpreter* interp, int argc, Value* args) {
@@ -143,15 +153,15 @@ Value stdlib_string_upper(struct Interpreter* interp, int argc, Value* args) {
         return v;
     }
 
-    char* str = args[0].string_val;
-    char* upper = strdup(str);
-    
-    for (char* p = upper; *p; p++) {
-        *p = toupper((unsigned char)*p);
-    }
+    const char* str = args[0].string_val;
+    size_t len = strlen(str);
+    char* upper = malloc(len + 1);
+    text_upper(upper, str, len);
+    upper[len] = '\0';
     
-    Value v = make_string(upper);
-    free(upper);
+    Value v;
+    v.type = VAL_STRING;
+    v.string_val = upper;
     return v;
 }
 
@@ -171,15 +181,15 @@ Value stdlib_string_lower(struct Interpreter* interp, int argc, Value* args) {
         return v;
     }
 
-    char* str = args[0].string_val;
-    char* lower = strdup(str);
-    
-    for (char* p = lower; *p; p++) {
-        *p = tolower((unsigned char)*p);
-    }
+    const char* str = args[0].string_val;
+    size_t len = strlen(str);
+    char* lower = malloc(len + 1);
+    text_lower(lower, str, len);
+    lower[len] = '\0';
     
-    Value v = make_string(lower);
-    free(lower);
+    Value v;
+    v.type = VAL_STRING;
+    v.string_val = lower;
     return v;
 }
 
@@ -199,27 +209,30 @@ Value stdlib_string_replace(struct Interpreter* interp, int argc, Value* args) {
         return v;
     }
 
-    char* str = args[0].string_val;
-    char* old_sub = args[1].string_val;
-    char* new_sub = args[2].string_val;
+    const char* str = args[0].string_val;
+    const char* old_sub = args[1].string_val;
+    const char* new_sub = args[2].string_val;
     
+    size_t len = strlen(str);
     size_t old_len = strlen(old_sub);
     size_t new_len = strlen(new_sub);
+    if (old_len == 0) return make_string(str);
     
     size_t count = 0;
-    char* pos = str;
-    while ((pos = strstr(pos, old_sub)) != NULL) {
+    const char* end = str + len;
+    const char* pos = str;
+    while ((pos = text_find(pos, (size_t)(end - pos), old_sub, old_len)) != NULL) {
         count++;
         pos += old_len;
     }
     
-    size_t result_len = strlen(str) + count * (new_len - old_len) + 1;
-    char* result = malloc(result_len);
+    char* result = malloc(len - count * old_len + count * new_len + 1);
     
-    char* src = str;
+    const char* src = str;
     char* dst = result;
     
-    while ((pos = strstr(src, old_sub)) != NULL) {
+    for (size_t i = 0; i < count; i++) {
+        pos = text_find(src, (size_t)(end - src), old_sub, old_len);
         size_t copy_len = pos - src;
         memcpy(dst, src, copy_len);
         dst += copy_len;
@@ -227,10 +240,11 @@ Value stdlib_string_replace(struct Interpreter* interp, int argc, Value* args) {
         dst += new_len;
         src = pos + old_len;
     }
-    strcpy(dst, src);
+    memcpy(dst, src, (size_t)(end - src) + 1);
     
-    Value v = make_string(result);
-    free(result);
+    Value v;
+    v.type = VAL_STRING;
+    v.string_val = result;
     return v;
 }
 
@@ -271,6 +285,97 @@ Value stdlib_string_substring(struct Interpreter* interp, int argc, Value* args)
     return v;
 }
 
+// ============================================================================
+// Split iterators
+// ============================================================================
+//
+// string.split_iter(s, sep) yields the pieces string.split would return one
+// at a time, so a large input is never held as an array of copies. Bytes
+// input yields bytes slices that share its storage. Iterators belong to the
+// thread that made them and are released once exhausted (or by close()).
+
+typedef struct SplitIter {
+    long id;
+    char handle[32];
+    Value source;            // string or bytes, owned
+    char* sep;
+    size_t sep_len;
+    size_t pos;
+    struct SplitIter* next;
+} SplitIter;
+
+static _Thread_local SplitIter* split_iters = NULL;
+static _Atomic long next_split_id = 1;
+
+static SplitIter* split_find(const Value* v) {
+    if (v->type != VAL_STRING) return NULL;
+    for (SplitIter* it = split_iters; it; it = it->next) {
+        if (strcmp(it->handle, v->string_val) == 0) return it;
+    }
+    return NULL;
+}
+
+static void split_free(SplitIter* it) {
+    SplitIter** cur = &split_iters;
+    while (*cur != it) cur = &(*cur)->next;
+    *cur = it->next;
+    value_free(&it->source);
+    free(it->sep);
+    free(it);
+}
+
+// string.split_iter(s, sep) -> "split_<n>", for `cruise (piece in it)`
+Value stdlib_string_split_iter(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 2 || (args[0].type != VAL_STRING && args[0].type != VAL_BYTES) || args[1].type != VAL_STRING) {
+        fprintf(stderr, "Error: string.split_iter() requires a string or bytes and a separator\n");
+        return make_null();
+    }
+    SplitIter* it = calloc(1, sizeof(SplitIter));
+    it->id = atomic_fetch_add(&next_split_id, 1);
+    snprintf(it->handle, sizeof(it->handle), "split_%ld", it->id);
+    it->source = args[0];
+    args[0] = make_null();
+    it->sep = args[1].string_val;
+    it->sep_len = strlen(it->sep);
+    args[1] = make_null();
+    it->next = split_iters;
+    split_iters = it;
+    return make_string(it->handle);
+}
+
+// it.next() -> next piece, or null once the input is used up
+Value stdlib_string_split_next(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    SplitIter* it = argc >= 1 ? split_find(&args[0]) : NULL;
+    if (!it) return make_null();
+    size_t len = 0;
+    const char* data = (const char*)value_bytes(&it->source, &len);
+    if (it->pos > len) {
+        split_free(it);
+        return make_null();
+    }
+    const char* start = data + it->pos;
+    const char* hit = it->sep_len > 0 ? text_find(start, len - it->pos, it->sep, it->sep_len) : NULL;
+    size_t piece_len = hit ? (size_t)(hit - start) : len - it->pos;
+    size_t offset = it->pos;
+    // Past the end once the last piece is out.
+    it->pos = hit ? offset + piece_len + it->sep_len : len + 1;
+    if (it->source.type == VAL_BYTES) {
+        Bytes* b = it->source.bytes_val;
+        return make_bytes_view(b->buf, b->offset + offset, piece_len);
+    }
+    return string_from_range(start, piece_len);
+}
+
+Value stdlib_string_split_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    SplitIter* it = argc >= 1 ? split_find(&args[0]) : NULL;
+    if (!it) return make_bool(false);
+    split_free(it);
+    return make_bool(true);
+}
+
 void stdlib_string_advanced_register(void) {
     register_native("string.split", stdlib_string_split);
     register_native("string.join", stdlib_string_join);
@@ -279,4 +384,9 @@ void stdlib_string_advanced_register(void) {
     register_native("string.lower", stdlib_string_lower);
     register_native("string.replace", stdlib_string_replace);
     register_native("string.substring", stdlib_string_substring);
+    register_native("string.split_iter", stdlib_string_split_iter);
+    register_native("string.split_next", stdlib_string_split_next);
+    register_native("string.split_close", stdlib_string_split_close);
+    register_handle_methods("split_", "string.split_");
+    register_iterable("split_", stdlib_string_split_next);
 }
\ No newline at end of file
@@ -12,5 +12,8 @@ Value stdlib_string_upper(struct Interpreter* interp, int argc, Value* args);
 Value stdlib_string_lower(struct Interpreter* interp, int argc, Value* args);
 Value stdlib_string_replace(struct Interpreter* interp, int argc, Value* args);
 Value stdlib_string_substring(struct Interpreter* interp, int argc, Value* args);
+Value stdlib_string_split_iter(struct Interpreter* interp, int argc, Value* args);
+Value stdlib_string_split_next(struct Interpreter* interp, int argc, Value* args);
+Value stdlib_string_split_close(struct Interpreter* interp, int argc, Value* args);
 
 #endif
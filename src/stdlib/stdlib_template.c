@@ -0,0 +1,689 @@
+#include "stdlib_template.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <uv.h>
+
+// Templates are compiled once into a flat op list: literal slices of the
+// source, variable references and block ops whose jump points at the op
+// that ends them. Root names are numbered into slots at compile time, so a
+// render binds the caller's variables once and every {{ name }} is an index
+// instead of a string search.
+
+#define TEMPLATE_MAX_NESTING 32
+#define TEMPLATE_CACHE_BUCKETS 128
+
+typedef enum {
+    TOP_TEXT,
+    TOP_VAR,       // escaped
+    TOP_RAW,
+    TOP_EACH,
+    TOP_IF,
+    TOP_UNLESS,
+    TOP_ELSE,
+    TOP_END
+} TemplateOpKind;
+
+typedef enum {
+    ROOT_SLOT,     // caller variable (or a field of a loop item)
+    ROOT_THIS,
+    ROOT_INDEX
+} TemplateRoot;
+
+typedef struct TemplatePath {
+    TemplateRoot root;
+    int slot;
+    size_t nseg;           // further .segments
+    char** seg;
+} TemplatePath;
+
+typedef struct TemplateOp {
+    TemplateOpKind kind;
+    size_t start;          // TOP_TEXT: slice of the source
+    size_t len;
+    int path;
+    int jump;              // blocks: matching else/end; else: matching end
+} TemplateOp;
+
+struct RadsTemplate {
+    char* text;
+    TemplateOp* ops;
+    int nops;
+    TemplatePath* paths;
+    int npaths;
+    char** slot_names;
+    int nslots;
+    int* slot_index;       // open-addressed name -> slot table
+    size_t slot_cap;
+    size_t literal_bytes;
+    _Atomic int refs;      // cache entry + renders in flight
+};
+
+static uint32_t tpl_hash(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int tpl_find_slot(const RadsTemplate* t, const char* name, size_t len) {
+    if (!t->slot_cap) return -1;
+    size_t mask = t->slot_cap - 1;
+    for (size_t i = tpl_hash(name, len) & mask;; i = (i + 1) & mask) {
+        int slot = t->slot_index[i];
+        if (slot < 0) return -1;
+        if (strncmp(t->slot_names[slot], name, len) == 0 && t->slot_names[slot][len] == '\0') return slot;
+    }
+}
+
+static void tpl_index_slots(RadsTemplate* t) {
+    size_t cap = 8;
+    while (cap < (size_t)t->nslots * 2) cap *= 2;
+    t->slot_cap = cap;
+    t->slot_index = malloc(cap * sizeof(int));
+    for (size_t i = 0; i < cap; i++) t->slot_index[i] = -1;
+    for (int s = 0; s < t->nslots; s++) {
+        size_t i = tpl_hash(t->slot_names[s], strlen(t->slot_names[s])) & (cap - 1);
+        while (t->slot_index[i] >= 0) i = (i + 1) & (cap - 1);
+        t->slot_index[i] = s;
+    }
+}
+
+void template_free(RadsTemplate* t) {
+    if (!t) return;
+    for (int i = 0; i < t->npaths; i++) {
+        for (size_t s = 0; s < t->paths[i].nseg; s++) free(t->paths[i].seg[s]);
+        free(t->paths[i].seg);
+    }
+    for (int i = 0; i < t->nslots; i++) free(t->slot_names[i]);
+    free(t->slot_names);
+    free(t->slot_index);
+    free(t->paths);
+    free(t->ops);
+    free(t->text);
+    free(t);
+}
+
+// ---------------------------------------------------------------------------
+// Compiler
+// ---------------------------------------------------------------------------
+
+static int tpl_emit(RadsTemplate* t, int* cap, TemplateOpKind kind) {
+    if (t->nops == *cap) {
+        *cap = *cap ? *cap * 2 : 16;
+        t->ops = realloc(t->ops, (size_t)*cap * sizeof(TemplateOp));
+    }
+    TemplateOp* op = &t->ops[t->nops];
+    memset(op, 0, sizeof(*op));
+    op->kind = kind;
+    op->path = -1;
+    op->jump = -1;
+    return t->nops++;
+}
+
+static int tpl_slot(RadsTemplate* t, const char* name, size_t len) {
+    for (int i = 0; i < t->nslots; i++) {
+        if (strncmp(t->slot_names[i], name, len) == 0 && t->slot_names[i][len] == '\0') return i;
+    }
+    t->slot_names = realloc(t->slot_names, (size_t)(t->nslots + 1) * sizeof(char*));
+    t->slot_names[t->nslots] = strndup(name, len);
+    return t->nslots++;
+}
+
+// Parses "a.b.c", "this", "this.x", "." or "@index" into a path.
+static int tpl_path(RadsTemplate* t, const char* s, size_t len, char* error, size_t error_len) {
+    if (len == 0) {
+        snprintf(error, error_len, "empty variable name");
+        return -1;
+    }
+    TemplatePath p;
+    memset(&p, 0, sizeof(p));
+    size_t i = 0;
+    if ((len == 1 && s[0] == '.') || (len >= 4 && strncmp(s, "this", 4) == 0 && (len == 4 || s[4] == '.'))) {
+        p.root = ROOT_THIS;
+        i = len == 1 ? 1 : 4;
+    } else if (len == 6 && strncmp(s, "@index", 6) == 0) {
+        p.root = ROOT_INDEX;
+        i = 6;
+    } else {
+        size_t end = 0;
+        while (end < len && s[end] != '.') end++;
+        p.root = ROOT_SLOT;
+        p.slot = tpl_slot(t, s, end);
+        i = end;
+    }
+    while (i < len) {
+        if (s[i] != '.' || i + 1 >= len) {
+            snprintf(error, error_len, "invalid variable \"%.*s\"", (int)len, s);
+            for (size_t k = 0; k < p.nseg; k++) free(p.seg[k]);
+            free(p.seg);
+            return -1;
+        }
+        size_t start = ++i;
+        while (i < len && s[i] != '.') i++;
+        p.seg = realloc(p.seg, (p.nseg + 1) * sizeof(char*));
+        p.seg[p.nseg++] = strndup(s + start, i - start);
+    }
+    t->paths = realloc(t->paths, (size_t)(t->npaths + 1) * sizeof(TemplatePath));
+    t->paths[t->npaths] = p;
+    return t->npaths++;
+}
+
+static int tpl_line(const char* text, size_t at) {
+    int line = 1;
+    for (size_t i = 0; i < at; i++) {
+        if (text[i] == '\n') line++;
+    }
+    return line;
+}
+
+RadsTemplate* template_compile(const char* text, size_t len, char* error, size_t error_len) {
+    RadsTemplate* t = calloc(1, sizeof(RadsTemplate));
+    if (!t) return NULL;
+    t->text = malloc(len + 1);
+    memcpy(t->text, text, len);
+    t->text[len] = '\0';
+    const char* s = t->text;
+    int cap = 0;
+    int stack[TEMPLATE_MAX_NESTING];
+    size_t stack_at[TEMPLATE_MAX_NESTING];
+    int depth = 0;
+    char detail[128] = "";
+    size_t pos = 0;
+    size_t tag_at = 0;
+
+    while (pos < len) {
+        const char* open = strstr(s + pos, "{{");
+        size_t lit_end = open ? (size_t)(open - s) : len;
+        if (lit_end > pos) {
+            int op = tpl_emit(t, &cap, TOP_TEXT);
+            t->ops[op].start = pos;
+            t->ops[op].len = lit_end - pos;
+            t->literal_bytes += lit_end - pos;
+        }
+        if (!open) break;
+        tag_at = lit_end;
+        bool raw = s[lit_end + 2] == '{';
+        size_t inner = lit_end + (raw ? 3 : 2);
+        const char* close = strstr(s + inner, raw ? "}}}" : "}}");
+        if (!close) {
+            // An unclosed tag is kept as literal text.
+            int op = tpl_emit(t, &cap, TOP_TEXT);
+            t->ops[op].start = lit_end;
+            t->ops[op].len = len - lit_end;
+            break;
+        }
+        size_t end = (size_t)(close - s);
+        pos = end + (raw ? 3 : 2);
+        while (inner < end && (s[inner] == ' ' || s[inner] == '\t' || s[inner] == '\n')) inner++;
+        while (end > inner && (s[end - 1] == ' ' || s[end - 1] == '\t' || s[end - 1] == '\n')) end--;
+        const char* tag = s + inner;
+        size_t tag_len = end - inner;
+
+        if (!raw && tag_len > 0 && tag[0] == '!') continue;
+        if (!raw && tag_len > 0 && tag[0] == '#') {
+            TemplateOpKind kind;
+            size_t kw;
+            if (tag_len > 5 && strncmp(tag + 1, "each", 4) == 0 && (tag[5] == ' ' || tag[5] == '\t')) {
+                kind = TOP_EACH;
+                kw = 5;
+            } else if (tag_len > 3 && strncmp(tag + 1, "if", 2) == 0 && (tag[3] == ' ' || tag[3] == '\t')) {
+                kind = TOP_IF;
+                kw = 3;
+            } else if (tag_len > 7 && strncmp(tag + 1, "unless", 6) == 0 && (tag[7] == ' ' || tag[7] == '\t')) {
+                kind = TOP_UNLESS;
+                kw = 7;
+            } else {
+                snprintf(detail, sizeof(detail), "unknown block \"%.*s\"", (int)tag_len, tag);
+                goto fail;
+            }
+            while (kw < tag_len && (tag[kw] == ' ' || tag[kw] == '\t')) kw++;
+            if (depth == TEMPLATE_MAX_NESTING) {
+                snprintf(detail, sizeof(detail), "blocks nest too deeply");
+                goto fail;
+            }
+            int path = tpl_path(t, tag + kw, tag_len - kw, detail, sizeof(detail));
+            if (path < 0) goto fail;
+            int op = tpl_emit(t, &cap, kind);
+            t->ops[op].path = path;
+            stack_at[depth] = tag_at;
+            stack[depth++] = op;
+            continue;
+        }
+        if (!raw && tag_len == 4 && strncmp(tag, "else", 4) == 0) {
+            if (depth == 0 || t->ops[stack[depth - 1]].jump >= 0) {
+                snprintf(detail, sizeof(detail), "unexpected {{else}}");
+                goto fail;
+            }
+            int op = tpl_emit(t, &cap, TOP_ELSE);
+            t->ops[stack[depth - 1]].jump = op;
+            continue;
+        }
+        if (!raw && tag_len > 0 && tag[0] == '/') {
+            static const char* names[] = { [TOP_EACH] = "each", [TOP_IF] = "if", [TOP_UNLESS] = "unless" };
+            if (depth == 0) {
+                snprintf(detail, sizeof(detail), "unexpected {{%.*s}}", (int)tag_len, tag);
+                goto fail;
+            }
+            int open_op = stack[--depth];
+            const char* want = names[t->ops[open_op].kind];
+            if (tag_len - 1 != strlen(want) || strncmp(tag + 1, want, tag_len - 1) != 0) {
+                snprintf(detail, sizeof(detail), "{{%.*s}} closes {{#%s}}", (int)tag_len, tag, want);
+                goto fail;
+            }
+            int op = tpl_emit(t, &cap, TOP_END);
+            int else_op = t->ops[open_op].jump;
+            if (else_op >= 0) t->ops[else_op].jump = op;
+            else t->ops[open_op].jump = op;
+            t->ops[op].jump = open_op;
+            continue;
+        }
+        int path = tpl_path(t, tag, tag_len, detail, sizeof(detail));
+        if (path < 0) goto fail;
+        int op = tpl_emit(t, &cap, raw ? TOP_RAW : TOP_VAR);
+        t->ops[op].path = path;
+    }
+    if (depth > 0) {
+        static const char* names[] = { [TOP_EACH] = "each", [TOP_IF] = "if", [TOP_UNLESS] = "unless" };
+        tag_at = stack_at[depth - 1];
+        snprintf(detail, sizeof(detail), "unclosed {{#%s}}", names[t->ops[stack[depth - 1]].kind]);
+        goto fail;
+    }
+    tpl_index_slots(t);
+    atomic_init(&t->refs, 1);
+    return t;
+
+fail:
+    snprintf(error, error_len, "%s (line %d)", detail, tpl_line(s, tag_at));
+    template_free(t);
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Renderer
+// ---------------------------------------------------------------------------
+
+typedef struct TemplateScope {
+    const Value* item;
+    size_t index;
+} TemplateScope;
+
+typedef struct TemplateRender {
+    const RadsTemplate* t;
+    const Value** slots;
+    TemplateScope scopes[TEMPLATE_MAX_NESTING];
+    int depth;
+    TemplateBuffer* out;
+} TemplateRender;
+
+static void tb_reserve(TemplateBuffer* b, size_t extra) {
+    if (b->len + extra + 1 <= b->cap) return;
+    size_t cap = b->cap ? b->cap : 1024;
+    while (cap < b->len + extra + 1) cap *= 2;
+    b->data = realloc(b->data, cap);
+    b->cap = cap;
+}
+
+static void tb_append(TemplateBuffer* b, const char* s, size_t n) {
+    tb_reserve(b, n);
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+}
+
+static void tb_escaped(TemplateBuffer* b, const char* s, size_t n) {
+    tb_reserve(b, n);
+    size_t run = 0;
+    for (size_t i = 0; i < n; i++) {
+        const char* ent;
+        switch (s[i]) {
+            case '&': ent = "&amp;"; break;
+            case '<': ent = "&lt;"; break;
+            case '>': ent = "&gt;"; break;
+            case '"': ent = "&quot;"; break;
+            case '\'': ent = "&#39;"; break;
+            default: continue;
+        }
+        tb_append(b, s + run, i - run);
+        tb_append(b, ent, strlen(ent));
+        run = i + 1;
+    }
+    tb_append(b, s + run, n - run);
+}
+
+static const Value* tpl_field(const Value* v, const char* name) {
+    if (!v || v->type != VAL_STRUCT_INSTANCE || !v->struct_instance) return NULL;
+    for (FieldValue* f = v->struct_instance->fields; f; f = f->next) {
+        if (strcmp(f->name, name) == 0) return f->value;
+    }
+    return NULL;
+}
+
+// Returns the value a path names, or NULL. Index paths write into scratch.
+static const Value* tpl_lookup(TemplateRender* r, int path_id, Value* scratch) {
+    const TemplatePath* p = &r->t->paths[path_id];
+    const Value* v = NULL;
+    switch (p->root) {
+        case ROOT_THIS:
+            v = r->depth > 0 ? r->scopes[r->depth - 1].item : NULL;
+            break;
+        case ROOT_INDEX:
+            if (r->depth == 0) return NULL;
+            scratch->type = VAL_INT;
+            scratch->int_val = (long long)r->scopes[r->depth - 1].index;
+            return scratch;
+        case ROOT_SLOT: {
+            const char* name = r->t->slot_names[p->slot];
+            for (int d = r->depth - 1; d >= 0 && !v; d--) v = tpl_field(r->scopes[d].item, name);
+            if (!v) v = r->slots[p->slot];
+            break;
+        }
+    }
+    for (size_t i = 0; v && i < p->nseg; i++) v = tpl_field(v, p->seg[i]);
+    return v;
+}
+
+static bool tpl_truthy(const Value* v) {
+    if (!v) return false;
+    switch (v->type) {
+        case VAL_NULL: return false;
+        case VAL_BOOL: return v->bool_val;
+        case VAL_INT: return v->int_val != 0;
+        case VAL_FLOAT: return v->float_val != 0.0;
+        case VAL_STRING: return v->string_val && v->string_val[0];
+        case VAL_ARRAY: return v->array_val && v->array_val->count > 0;
+        default: return true;
+    }
+}
+
+static void tpl_write_value(TemplateBuffer* out, const Value* v, bool escape) {
+    if (!v) return;
+    char num[64];
+    const char* s = NULL;
+    size_t n = 0;
+    switch (v->type) {
+        case VAL_STRING:
+            s = v->string_val ? v->string_val : "";
+            n = strlen(s);
+            break;
+        case VAL_INT:
+            n = (size_t)snprintf(num, sizeof(num), "%lld", v->int_val);
+            s = num;
+            break;
+        case VAL_FLOAT:
+            n = (size_t)snprintf(num, sizeof(num), "%g", v->float_val);
+            s = num;
+            break;
+        case VAL_BOOL:
+            s = v->bool_val ? "true" : "false";
+            n = strlen(s);
+            break;
+        default:
+            return;
+    }
+    if (escape) tb_escaped(out, s, n);
+    else tb_append(out, s, n);
+}
+
+static void tpl_run(TemplateRender* r, int from, int to) {
+    const RadsTemplate* t = r->t;
+    Value scratch;
+    for (int i = from; i < to; i++) {
+        const TemplateOp* op = &t->ops[i];
+        switch (op->kind) {
+            case TOP_TEXT:
+                tb_append(r->out, t->text + op->start, op->len);
+                break;
+            case TOP_VAR:
+            case TOP_RAW:
+                tpl_write_value(r->out, tpl_lookup(r, op->path, &scratch), op->kind == TOP_VAR);
+                break;
+            case TOP_IF:
+            case TOP_UNLESS:
+            case TOP_EACH: {
+                int else_op = t->ops[op->jump].kind == TOP_ELSE ? op->jump : -1;
+                int end = else_op >= 0 ? t->ops[else_op].jump : op->jump;
+                int body_end = else_op >= 0 ? else_op : end;
+                const Value* v = tpl_lookup(r, op->path, &scratch);
+                if (op->kind == TOP_EACH) {
+                    bool any = v && v->type == VAL_ARRAY && v->array_val && v->array_val->count > 0;
+                    if (any && r->depth < TEMPLATE_MAX_NESTING) {
+                        Array* arr = v->array_val;
+                        TemplateScope* scope = &r->scopes[r->depth++];
+                        for (size_t k = 0; k < arr->count; k++) {
+                            scope->item = &arr->items[k];
+                            scope->index = k;
+                            tpl_run(r, i + 1, body_end);
+                        }
+                        r->depth--;
+                    } else if (!any && else_op >= 0) {
+                        tpl_run(r, else_op + 1, end);
+                    }
+                } else {
+                    bool cond = tpl_truthy(v) == (op->kind == TOP_IF);
+                    if (cond) tpl_run(r, i + 1, body_end);
+                    else if (else_op >= 0) tpl_run(r, else_op + 1, end);
+                }
+                i = end;
+                break;
+            }
+            case TOP_ELSE:
+            case TOP_END:
+                break;
+        }
+    }
+}
+
+void template_render_into(const RadsTemplate* t, const Value* vars, TemplateBuffer* out) {
+    out->len = 0;
+    tb_reserve(out, t->literal_bytes + 256);
+    const Value* stack_slots[32];
+    const Value** slots = t->nslots <= 32 ? stack_slots : calloc((size_t)t->nslots, sizeof(Value*));
+    for (int i = 0; i < t->nslots; i++) slots[i] = NULL;
+
+    // Bind caller variables to slots once per render.
+    if (vars && vars->type == VAL_STRUCT_INSTANCE && vars->struct_instance) {
+        for (FieldValue* f = vars->struct_instance->fields; f; f = f->next) {
+            int slot = tpl_find_slot(t, f->name, strlen(f->name));
+            if (slot >= 0 && !slots[slot]) slots[slot] = f->value;
+        }
+    } else if (vars && vars->type == VAL_ARRAY && vars->array_val) {
+        Array* arr = vars->array_val;
+        for (size_t i = 0; i + 1 < arr->count; i += 2) {
+            if (arr->items[i].type != VAL_STRING) continue;
+            const char* name = arr->items[i].string_val;
+            int slot = tpl_find_slot(t, name, strlen(name));
+            if (slot >= 0 && !slots[slot]) slots[slot] = &arr->items[i + 1];
+        }
+    }
+
+    TemplateRender r;
+    r.t = t;
+    r.slots = slots;
+    r.depth = 0;
+    r.out = out;
+    tpl_run(&r, 0, t->nops);
+    out->data[out->len] = '\0';
+    if (slots != stack_slots) free(slots);
+}
+
+// ---------------------------------------------------------------------------
+// Cache
+// ---------------------------------------------------------------------------
+
+typedef struct TemplateCacheEntry {
+    char* key;              // template text, or a file path
+    bool is_file;
+    uint32_t hash;
+    struct timespec mtime;
+    off_t size;
+    RadsTemplate* tpl;
+    struct TemplateCacheEntry* bucket_next;
+    struct TemplateCacheEntry* lru_prev;
+    struct TemplateCacheEntry* lru_next;
+} TemplateCacheEntry;
+
+static TemplateCacheEntry* template_cache[TEMPLATE_CACHE_BUCKETS];
+static TemplateCacheEntry* template_lru_head = NULL;
+static TemplateCacheEntry* template_lru_tail = NULL;
+static int template_cache_count = 0;
+static long long template_cache_hits = 0;
+static long long template_cache_misses = 0;
+static uv_mutex_t template_lock;
+static uv_once_t template_once = UV_ONCE_INIT;
+
+static void template_init_lock(void) {
+    uv_mutex_init(&template_lock);
+}
+
+static void template_lru_unlink(TemplateCacheEntry* e) {
+    if (e->lru_prev) e->lru_prev->lru_next = e->lru_next;
+    else template_lru_head = e->lru_next;
+    if (e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+    else template_lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+}
+
+static void template_lru_push(TemplateCacheEntry* e) {
+    e->lru_next = template_lru_head;
+    if (template_lru_head) template_lru_head->lru_prev = e;
+    template_lru_head = e;
+    if (!template_lru_tail) template_lru_tail = e;
+}
+
+static void template_cache_remove(TemplateCacheEntry* e) {
+    template_lru_unlink(e);
+    TemplateCacheEntry** link = &template_cache[e->hash % TEMPLATE_CACHE_BUCKETS];
+    while (*link && *link != e) link = &(*link)->bucket_next;
+    if (*link) *link = e->bucket_next;
+    template_release(e->tpl);
+    free(e->key);
+    free(e);
+    template_cache_count--;
+}
+
+static TemplateCacheEntry* template_cache_find(const char* key, bool is_file, uint32_t hash) {
+    for (TemplateCacheEntry* e = template_cache[hash % TEMPLATE_CACHE_BUCKETS]; e; e = e->bucket_next) {
+        if (e->hash == hash && e->is_file == is_file && strcmp(e->key, key) == 0) return e;
+    }
+    return NULL;
+}
+
+static TemplateCacheEntry* template_cache_insert(const char* key, bool is_file, uint32_t hash, RadsTemplate* tpl) {
+    if (template_cache_count >= TEMPLATE_CACHE_CAPACITY && template_lru_tail) {
+        template_cache_remove(template_lru_tail);
+    }
+    TemplateCacheEntry* e = calloc(1, sizeof(TemplateCacheEntry));
+    e->key = strdup(key);
+    e->is_file = is_file;
+    e->hash = hash;
+    e->tpl = tpl;
+    e->bucket_next = template_cache[hash % TEMPLATE_CACHE_BUCKETS];
+    template_cache[hash % TEMPLATE_CACHE_BUCKETS] = e;
+    template_lru_push(e);
+    template_cache_count++;
+    return e;
+}
+
+// Takes a reference for the caller; call with template_lock held.
+static const RadsTemplate* template_cache_hit(TemplateCacheEntry* e) {
+    template_cache_hits++;
+    template_lru_unlink(e);
+    template_lru_push(e);
+    atomic_fetch_add(&e->tpl->refs, 1);
+    return e->tpl;
+}
+
+const RadsTemplate* template_cache_text(const char* text, char* error, size_t error_len) {
+    uv_once(&template_once, template_init_lock);
+    size_t len = strlen(text);
+    uint32_t hash = tpl_hash(text, len);
+    uv_mutex_lock(&template_lock);
+    TemplateCacheEntry* e = template_cache_find(text, false, hash);
+    if (e) {
+        const RadsTemplate* hit = template_cache_hit(e);
+        uv_mutex_unlock(&template_lock);
+        return hit;
+    }
+    template_cache_misses++;
+    uv_mutex_unlock(&template_lock);
+
+    // Compile outside the lock; another thread may have cached the same
+    // text meanwhile, in which case its copy wins.
+    RadsTemplate* tpl = template_compile(text, len, error, error_len);
+    if (!tpl) return NULL;
+    uv_mutex_lock(&template_lock);
+    e = template_cache_find(text, false, hash);
+    if (e) {
+        const RadsTemplate* hit = template_cache_hit(e);
+        uv_mutex_unlock(&template_lock);
+        template_free(tpl);
+        return hit;
+    }
+    template_cache_insert(text, false, hash, tpl);
+    atomic_fetch_add(&tpl->refs, 1);
+    uv_mutex_unlock(&template_lock);
+    return tpl;
+}
+
+const RadsTemplate* template_cache_file(const char* path, char* error, size_t error_len) {
+    uv_once(&template_once, template_init_lock);
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        snprintf(error, error_len, "cannot open template %s", path);
+        return NULL;
+    }
+    uint32_t hash = tpl_hash(path, strlen(path));
+    uv_mutex_lock(&template_lock);
+    TemplateCacheEntry* e = template_cache_find(path, true, hash);
+    if (e) {
+        if (e->size == st.st_size && e->mtime.tv_sec == st.st_mtim.tv_sec &&
+            e->mtime.tv_nsec == st.st_mtim.tv_nsec) {
+            const RadsTemplate* hit = template_cache_hit(e);
+            uv_mutex_unlock(&template_lock);
+            return hit;
+        }
+        template_cache_remove(e);
+    }
+    template_cache_misses++;
+    uv_mutex_unlock(&template_lock);
+
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        snprintf(error, error_len, "cannot open template %s", path);
+        return NULL;
+    }
+    char* text = malloc((size_t)st.st_size + 1);
+    size_t n = text ? fread(text, 1, (size_t)st.st_size, f) : 0;
+    fclose(f);
+    if (!text) return NULL;
+    RadsTemplate* tpl = template_compile(text, n, error, error_len);
+    free(text);
+    if (!tpl) return NULL;
+    uv_mutex_lock(&template_lock);
+    e = template_cache_find(path, true, hash);
+    if (e) template_cache_remove(e);
+    e = template_cache_insert(path, true, hash, tpl);
+    e->mtime = st.st_mtim;
+    e->size = st.st_size;
+    atomic_fetch_add(&tpl->refs, 1);
+    uv_mutex_unlock(&template_lock);
+    return tpl;
+}
+
+void template_release(const RadsTemplate* tpl) {
+    RadsTemplate* t = (RadsTemplate*)tpl;
+    if (t && atomic_fetch_sub(&t->refs, 1) == 1) template_free(t);
+}
+
+void template_cache_stats(long long* hits, long long* misses, int* size) {
+    uv_once(&template_once, template_init_lock);
+    uv_mutex_lock(&template_lock);
+    *hits = template_cache_hits;
+    *misses = template_cache_misses;
+    *size = template_cache_count;
+    uv_mutex_unlock(&template_lock);
+}
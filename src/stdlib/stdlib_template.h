@@ -0,0 +1,45 @@
+#ifndef RADS_TEMPLATE_H
+#define RADS_TEMPLATE_H
+
+#include "../core/interpreter.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Compiled templates. Syntax:
+//   {{ name }} / {{ user.name }}   HTML-escaped value
+//   {{{ html }}}                   raw value
+//   {{#each items}}..{{else}}..{{/each}}   loop; {{ this }}, {{ @index }}
+//   {{#if x}}..{{else}}..{{/if}} and {{#unless x}}..{{/unless}}
+//   {{! comment }}
+// Inside a loop, names are looked up on the current item first.
+
+// Compiled and file templates kept around; the least recently used is
+// dropped beyond this.
+#define TEMPLATE_CACHE_CAPACITY 64
+
+typedef struct RadsTemplate RadsTemplate;
+
+typedef struct TemplateBuffer {
+    char* data;
+    size_t len;
+    size_t cap;
+} TemplateBuffer;
+
+// Returns NULL and fills error when the template is malformed.
+RadsTemplate* template_compile(const char* text, size_t len, char* error, size_t error_len);
+void template_free(RadsTemplate* tpl);
+
+// Cached compilation of template text / a template file. File entries are
+// recompiled when the file's mtime or size changes. The cache is shared by
+// all threads; the result holds a reference that the caller drops with
+// template_release, so eviction cannot free a template mid-render.
+const RadsTemplate* template_cache_text(const char* text, char* error, size_t error_len);
+const RadsTemplate* template_cache_file(const char* path, char* error, size_t error_len);
+void template_release(const RadsTemplate* tpl);
+void template_cache_stats(long long* hits, long long* misses, int* size);
+
+// Renders into out (cleared first). vars is a struct instance or a flat
+// [key, value, ...] array; values may be any RADS value.
+void template_render_into(const RadsTemplate* tpl, const Value* vars, TemplateBuffer* out);
+
+#endif
@@ -0,0 +1,46 @@
+#include "stdlib_test.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+// Parallel jobs may check too.
+static atomic_int failures;
+
+// Same rules as an if condition.
+static bool check_passed(const Value* v) {
+    switch (v->type) {
+        case VAL_BOOL: return v->bool_val;
+        case VAL_INT: return v->int_val != 0;
+        case VAL_FLOAT: return v->float_val != 0.0;
+        case VAL_STRING: return v->string_val && v->string_val[0] != '\0';
+        case VAL_BYTES: return v->bytes_val->length > 0;
+        case VAL_NUMARRAY: return v->numarray_val->count > 0;
+        default: return false;
+    }
+}
+
+// test.check(name, ok) -> ok as a bool
+static Value native_test_check(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    const char* name = argc >= 1 && args[0].type == VAL_STRING ? args[0].string_val : "(unnamed)";
+    bool ok = argc >= 2 && check_passed(&args[1]);
+    printf("%s %s\n", ok ? "✓" : "✗", name);
+    if (!ok) atomic_fetch_add(&failures, 1);
+    return make_bool(ok);
+}
+
+// test.failures() -> failed checks so far
+static Value native_test_failures(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    (void)argc;
+    (void)args;
+    return make_int(atomic_load(&failures));
+}
+
+int test_failure_count(void) {
+    return atomic_load(&failures);
+}
+
+void stdlib_test_register(void) {
+    register_native("test.check", native_test_check);
+    register_native("test.failures", native_test_failures);
+}
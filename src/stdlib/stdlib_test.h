@@ -0,0 +1,17 @@
+#ifndef RADS_STDLIB_TEST_H
+#define RADS_STDLIB_TEST_H
+
+#include "../core/interpreter.h"
+
+// Assertions behind test.*, shared by the tests/*.rads suites.
+//
+// test.check(name, ok) prints "✓ name" or "✗ name" and counts the
+// failures; the interpreter exits with status 1 when any check failed,
+// so scripts run under run_tests.sh fail on a broken assertion.
+
+void stdlib_test_register(void);
+
+// Number of failed test.check calls so far.
+int test_failure_count(void);
+
+#endif
@@ -1,507 +1,1421 @@
 #include "stdlib_websocket.h"
+#include "../core/textscan.h"
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
-#include <unistd.h>
-#include <sys/socket.h>
 #include <netinet/in.h>
-#include <arpa/inet.h>
-#include <netdb.h>
-#include <fcntl.h>
-
-#define WS_MAX_CLIENTS 128
-#define WS_BUFFER_SIZE 8192
-#define WS_HANDSHAKE_TIMEOUT 5000
-
-static int ws_handshake(int client_fd, const char* request);
-static int ws_send_frame(int fd, const uint8_t* data, size_t length, WSMessageType type);
-static int ws_decode_frame(int fd, WSMessage* message);
-
-static uint64_t ntoh64(uint64_t value) {
-    uint64_t result = 0;
-    for (int i = 0; i < 8; i++) {
-        result = (result << 8) | ((value >> (i * 8)) & 0xFF);
+#include <zlib.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// WebSocket server on the shared libuv loop (RFC 6455).
+//
+// Sockets arrive two ways: ws.route() registers an upgrade path that
+// net.http_server hands matching requests to, and ws.listen() runs a
+// standalone listener. Either way a connection belongs to a hub, which owns
+// the script callbacks and the member list broadcast() walks.
+//
+// Reads go into one shared buffer and frames are parsed straight out of it;
+// only a trailing partial frame is copied into the connection's rx buffer, so
+// an idle connection costs a WsConn and a uv_tcp_t. Outgoing frames are
+// refcounted so a broadcast builds its frame once for every recipient.
+//
+// permessage-deflate (RFC 7692) is opt-in per hub. Without context takeover
+// (the default) both directions reset their window per message, so every
+// such connection shares one compressor and one decompressor and a broadcast
+// is compressed once; with takeover each connection keeps its own streams.
+
+extern uv_loop_t* global_event_loop;
+extern Value make_string(const char* val);
+extern Value make_bool(bool val);
+extern Value make_null(void);
+extern Value make_int(long long val);
+
+#define WS_READ_BUFFER_SIZE (64 * 1024)
+#define WS_MAX_HANDSHAKE 8192
+#define WS_CONN_BUCKETS 4096
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_RSV1 0x40              // "compressed" bit on a message's first frame
+#define WS_DEFLATE_MIN 64         // smaller messages go out uncompressed
+
+enum {
+    WS_OP_CONTINUATION = 0x0,
+    WS_OP_TEXT = 0x1,
+    WS_OP_BINARY = 0x2,
+    WS_OP_CLOSE = 0x8,
+    WS_OP_PING = 0x9,
+    WS_OP_PONG = 0xA
+};
+
+typedef enum {
+    WS_STATE_HANDSHAKE,  // standalone listener, waiting for the request head
+    WS_STATE_OPEN,
+    WS_STATE_CLOSING     // close frame sent, waiting for the peer's
+} WsState;
+
+typedef struct WsFrame {
+    int refs;
+    size_t len;
+    uint8_t data[];
+} WsFrame;
+
+typedef struct WsWrite {
+    uv_write_t req;
+    WsFrame* frame;
+} WsWrite;
+
+struct WsConn;
+
+typedef struct WsHub {
+    char id[32];
+    char* path;             // upgrade route on net.http_server, or NULL
+    uv_tcp_t* server;       // listener from ws.listen, or NULL
+    Value on_open;
+    Value on_message;
+    Value on_close;
+    size_t max_message;     // largest message accepted, after reassembly
+    bool deflate;           // accept permessage-deflate offers
+    bool context_takeover;  // let compression windows persist across messages
+    struct WsConn* conns;
+    size_t count;
+    bool closed;
+    struct WsHub* next;
+} WsHub;
+
+typedef struct WsConn {
+    uv_tcp_t* tcp;
+    long num;
+    char id[32];
+    WsHub* hub;
+    WsState state;
+    bool opened;            // on_open ran, so on_close is owed
+    bool waiting_drain;
+    uint16_t close_code;
+    Value on_drain;
+    uint8_t* rx;            // unparsed bytes carried between reads
+    size_t rx_len;
+    size_t rx_cap;
+    bool deflate;           // permessage-deflate negotiated
+    bool server_takeover;   // our compressor keeps its window between messages
+    bool client_takeover;   // the client's does, so inflate state must persist
+    int server_window_bits;
+    z_stream* zout;         // per-connection streams, only when a window persists
+    z_stream* zin;
+    uint8_t msg_opcode;     // opcode of a fragmented message being reassembled
+    bool msg_compressed;
+    uint8_t* msg;
+    size_t msg_len;
+    size_t msg_cap;
+    struct WsConn* prev;    // hub membership
+    struct WsConn* next;
+    struct WsConn* hash_next;
+} WsConn;
+
+static WsHub* ws_hubs = NULL;
+static long ws_next_hub_id = 1;
+static long ws_next_conn_id = 1;
+static WsConn* ws_conn_table[WS_CONN_BUCKETS];
+static uint8_t ws_read_buf[WS_READ_BUFFER_SIZE];
+
+static void ws_close_socket(WsConn* conn);
+static void ws_process(WsConn* conn, uint8_t* data, size_t len);
+
+// ---------------------------------------------------------------------------
+// Handshake: SHA-1 and base64 for Sec-WebSocket-Accept
+// ---------------------------------------------------------------------------
+
+#define SHA1_ROL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+static void sha1_block(uint32_t h[5], const uint8_t* p) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)p[i * 4] << 24) | ((uint32_t)p[i * 4 + 1] << 16) |
+               ((uint32_t)p[i * 4 + 2] << 8) | (uint32_t)p[i * 4 + 3];
     }
-    return result;
+    for (int i = 16; i < 80; i++) {
+        w[i] = SHA1_ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+        else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+        uint32_t t = SHA1_ROL(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = SHA1_ROL(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
 }
 
-static uint64_t hton64(uint64_t value) {
-    uint64_t result = 0;
-    for (int i = 0; i < 8; i++) {
-        result |= ((value >> (i * 8)) & 0xFF) << ((7 - i) * 8);
+static void sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    size_t full = len & ~(size_t)63;
+    for (size_t i = 0; i < full; i += 64) sha1_block(h, data + i);
+
+    uint8_t tail[128] = {0};
+    size_t rem = len - full;
+    memcpy(tail, data + full, rem);
+    tail[rem] = 0x80;
+    size_t tail_len = rem < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 0; i < 8; i++) tail[tail_len - 1 - i] = (uint8_t)(bits >> (i * 8));
+    for (size_t i = 0; i < tail_len; i += 64) sha1_block(h, tail + i);
+
+    for (int i = 0; i < 5; i++) {
+        out[i * 4] = (uint8_t)(h[i] >> 24);
+        out[i * 4 + 1] = (uint8_t)(h[i] >> 16);
+        out[i * 4 + 2] = (uint8_t)(h[i] >> 8);
+        out[i * 4 + 3] = (uint8_t)h[i];
     }
-    return result;
 }
 
-WebSocket* websocket_server_new(int port) {
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd < 0) {
-        perror("socket");
-        return NULL;
+static void base64_encode(const uint8_t* in, size_t len, char* out) {
+    static const char tbl[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < len) v |= in[i + 2];
+        out[o++] = tbl[(v >> 18) & 63];
+        out[o++] = tbl[(v >> 12) & 63];
+        out[o++] = i + 1 < len ? tbl[(v >> 6) & 63] : '=';
+        out[o++] = i + 2 < len ? tbl[v & 63] : '=';
     }
+    out[o] = '\0';
+}
 
-    int opt = 1;
-    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+// Sec-WebSocket-Accept for a client key; out holds 29 bytes.
+static void ws_accept_key(const char* key, char* out) {
+    char buf[128];
+    int n = snprintf(buf, sizeof(buf), "%s" WS_GUID, key);
+    uint8_t digest[20];
+    sha1((const uint8_t*)buf, (size_t)n, digest);
+    base64_encode(digest, 20, out);
+}
 
-    struct sockaddr_in address;
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(port);
+// A client key is 16 random bytes, base64 encoded.
+static bool ws_key_valid(const char* key) {
+    if (!key) return false;
+    size_t len = strlen(key);
+    return len == 24 && key[22] == '=' && key[23] == '=';
+}
 
-    if (bind(server_fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
-        perror("bind");
-        close(server_fd);
-        return NULL;
-    }
+// ---------------------------------------------------------------------------
+// Connection table
+// ---------------------------------------------------------------------------
 
-    if (listen(server_fd, WS_MAX_CLIENTS) < 0) {
-        perror("listen");
-        close(server_fd);
-        return NULL;
+static void ws_table_add(WsConn* conn) {
+    size_t b = (size_t)conn->num & (WS_CONN_BUCKETS - 1);
+    conn->hash_next = ws_conn_table[b];
+    ws_conn_table[b] = conn;
+}
+
+static void ws_table_remove(WsConn* conn) {
+    WsConn** link = &ws_conn_table[(size_t)conn->num & (WS_CONN_BUCKETS - 1)];
+    while (*link && *link != conn) link = &(*link)->hash_next;
+    if (*link) *link = conn->hash_next;
+}
+
+static WsConn* ws_conn_find(const char* id) {
+    if (!id || strncmp(id, "ws_conn_", 8) != 0) return NULL;
+    long num = strtol(id + 8, NULL, 10);
+    for (WsConn* c = ws_conn_table[(size_t)num & (WS_CONN_BUCKETS - 1)]; c; c = c->hash_next) {
+        if (c->num == num) return c;
     }
+    return NULL;
+}
 
-    WebSocket* ws = (WebSocket*)calloc(1, sizeof(WebSocket));
-    ws->fd = server_fd;
-    ws->url = NULL;
-    ws->is_server = true;
-    ws->connected = false;
-    ws->client_count = 0;
-    ws->rx_len = 0;
+static WsHub* ws_hub_find(const char* id) {
+    if (!id) return NULL;
+    for (WsHub* h = ws_hubs; h; h = h->next) {
+        if (strcmp(h->id, id) == 0) return h;
+    }
+    return NULL;
+}
 
-    return ws;
+static WsHub* ws_route_find(const char* path) {
+    if (!path) return NULL;
+    for (WsHub* h = ws_hubs; h; h = h->next) {
+        if (!h->closed && h->path && strcmp(h->path, path) == 0) return h;
+    }
+    return NULL;
 }
 
-WebSocket* websocket_client_new(const char* url) {
-    WebSocket* ws = (WebSocket*)calloc(1, sizeof(WebSocket));
-    ws->fd = -1;
-    ws->url = strdup(url);
-    ws->is_server = false;
-    ws->connected = false;
-    ws->rx_len = 0;
+bool websocket_has_route(const char* path) {
+    return ws_route_find(path) != NULL;
+}
 
-    return ws;
+// ---------------------------------------------------------------------------
+// Masking and permessage-deflate
+// ---------------------------------------------------------------------------
+
+// XORs a client payload with its 4-byte mask, 16 bytes at a time. Each wide
+// step covers a whole number of mask periods, so the key never rotates.
+static void ws_unmask(uint8_t* p, size_t len, const uint8_t mask[4]) {
+    size_t i = 0;
+    uint32_t m32;
+    memcpy(&m32, mask, 4);
+#if defined(__SSE2__)
+    __m128i m128 = _mm_set1_epi32((int)m32);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        _mm_storeu_si128((__m128i*)(p + i), _mm_xor_si128(v, m128));
+    }
+#endif
+    uint64_t m64 = ((uint64_t)m32 << 32) | m32;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t v;
+        memcpy(&v, p + i, 8);
+        v ^= m64;
+        memcpy(p + i, &v, 8);
+    }
+    for (; i < len; i++) p[i] ^= mask[i & 3];
 }
 
-void websocket_free(WebSocket* ws) {
-    if (!ws) return;
+static z_stream ws_shared_zout;
+static z_stream ws_shared_zin;
+static bool ws_shared_zout_ready = false;
+static bool ws_shared_zin_ready = false;
 
-    if (ws->url) free(ws->url);
+static bool ws_shares_deflater(const WsConn* conn) {
+    return !conn->server_takeover && conn->server_window_bits == 15;
+}
 
-    if (ws->is_server && ws->fd >= 0) {
-        close(ws->fd);
+// Compressor for conn; *reset says the window must not carry over.
+static z_stream* ws_deflater(WsConn* conn, bool* reset) {
+    *reset = !conn->server_takeover;
+    if (ws_shares_deflater(conn)) {
+        if (!ws_shared_zout_ready) {
+            if (deflateInit2(&ws_shared_zout, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) return NULL;
+            ws_shared_zout_ready = true;
+        }
+        return &ws_shared_zout;
     }
-
-    if (!ws->is_server && ws->fd >= 0) {
-        close(ws->fd);
+    if (!conn->zout) {
+        z_stream* zs = calloc(1, sizeof(z_stream));
+        if (!zs) return NULL;
+        if (deflateInit2(zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -conn->server_window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            free(zs);
+            return NULL;
+        }
+        conn->zout = zs;
     }
+    return conn->zout;
+}
 
-    for (int i = 0; i < ws->client_count; i++) {
-        if (ws->clients[i]) {
-            websocket_close(ws->clients[i]);
-            free(ws->clients[i]);
+static z_stream* ws_inflater(WsConn* conn, bool* reset) {
+    *reset = !conn->client_takeover;
+    if (!conn->client_takeover) {
+        if (!ws_shared_zin_ready) {
+            if (inflateInit2(&ws_shared_zin, -15) != Z_OK) return NULL;
+            ws_shared_zin_ready = true;
         }
+        return &ws_shared_zin;
     }
-
-    free(ws);
+    if (!conn->zin) {
+        z_stream* zs = calloc(1, sizeof(z_stream));
+        if (!zs) return NULL;
+        if (inflateInit2(zs, -15) != Z_OK) {
+            free(zs);
+            return NULL;
+        }
+        conn->zin = zs;
+    }
+    return conn->zin;
 }
 
-int ws_handshake(int client_fd, const char* request) {
-    const char* upgrade = strstr(request, "Upgrade: websocket");
-    if (!upgrade) return -1;
-
-    const char* key_start = strstr(request, "Sec-WebSocket-Key: ");
-    if (!key_start) return -1;
-
-    key_start += 19;
-    const char* key_end = strstr(key_start, "\r\n");
-    if (!key_end) return -1;
-
-    char key[128];
-    int key_len = key_end - key_start;
-    if (key_len > 127) key_len = 127;
-    memcpy(key, key_start, key_len);
-    key[key_len] = '\0';
-
-    char response[512];
-    snprintf(response, sizeof(response),
-        "HTTP/1.1 101 Switching Protocols\r\n"
-        "Upgrade: websocket\r\n"
-        "Connection: Upgrade\r\n"
-        "Sec-WebSocket-Accept: %s\r\n"
-        "\r\n",
-        key);
+static void ws_zstream_free(z_stream* zs, bool deflating) {
+    if (!zs) return;
+    if (deflating) deflateEnd(zs);
+    else inflateEnd(zs);
+    free(zs);
+}
 
-    return send(client_fd, response, strlen(response), 0) > 0 ? 0 : -1;
+// One message as a sync-flushed raw deflate block without the trailing
+// 00 00 ff ff, which RFC 7692 7.2.1 has the sender strip.
+static uint8_t* ws_deflate(z_stream* zs, bool reset, const uint8_t* in, size_t len, size_t* out_len) {
+    if (reset) deflateReset(zs);
+    size_t cap = deflateBound(zs, (uLong)len) + 16;
+    uint8_t* out = malloc(cap);
+    if (!out) return NULL;
+    size_t used = 0;
+    zs->next_in = (Bytef*)in;
+    zs->avail_in = (uInt)len;
+    for (;;) {
+        zs->next_out = out + used;
+        zs->avail_out = (uInt)(cap - used);
+        int r = deflate(zs, Z_SYNC_FLUSH);
+        used = cap - zs->avail_out;
+        if (r != Z_OK && r != Z_BUF_ERROR) {
+            free(out);
+            return NULL;
+        }
+        if (zs->avail_out > 0) break;
+        cap *= 2;
+        uint8_t* grown = realloc(out, cap);
+        if (!grown) {
+            free(out);
+            return NULL;
+        }
+        out = grown;
+    }
+    if (used >= 4 && memcmp(out + used - 4, "\x00\x00\xff\xff", 4) == 0) used -= 4;
+    *out_len = used;
+    return out;
 }
 
-static int ws_send_frame(int fd, const uint8_t* data, size_t length, WSMessageType type) {
-    uint8_t frame[WS_BUFFER_SIZE + 14];
-    int frame_len = 0;
+// Inverse of ws_deflate. Output is capped at max so a small compressed
+// message cannot expand without bound; *too_big tells that apart from a
+// corrupt stream. The result is NUL-terminated so it can become a string
+// value as is.
+static uint8_t* ws_inflate(z_stream* zs, bool reset, const uint8_t* in, size_t len,
+                           size_t max, size_t* out_len, bool* too_big) {
+    static const uint8_t tail[4] = { 0x00, 0x00, 0xff, 0xff };
+    *too_big = false;
+    if (reset) inflateReset(zs);
+    size_t cap = len * 4 + 64;
+    if (cap > max + 1) cap = max + 1;
+    uint8_t* out = malloc(cap);
+    if (!out) return NULL;
+    size_t used = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        zs->next_in = (Bytef*)(pass == 0 ? in : tail);
+        zs->avail_in = (uInt)(pass == 0 ? len : sizeof(tail));
+        for (;;) {
+            if (used == cap) {
+                if (cap > max) {
+                    *too_big = true;
+                    free(out);
+                    return NULL;
+                }
+                cap = cap * 2 > max + 1 ? max + 1 : cap * 2;
+                uint8_t* grown = realloc(out, cap);
+                if (!grown) {
+                    free(out);
+                    return NULL;
+                }
+                out = grown;
+            }
+            zs->next_out = out + used;
+            zs->avail_out = (uInt)(cap - used);
+            int r = inflate(zs, Z_SYNC_FLUSH);
+            used = cap - zs->avail_out;
+            if (r == Z_STREAM_END) {
+                // A final block ends this stream; the next message starts fresh.
+                inflateReset(zs);
+                if (zs->avail_in == 0) break;
+                continue;
+            }
+            if (r != Z_OK && r != Z_BUF_ERROR) {
+                free(out);
+                return NULL;
+            }
+            if (zs->avail_out > 0) {
+                if (zs->avail_in == 0) break;
+                if (r == Z_BUF_ERROR) {
+                    free(out);
+                    return NULL;
+                }
+            }
+        }
+    }
+    if (used > max) {
+        *too_big = true;
+        free(out);
+        return NULL;
+    }
+    if (used == cap) {
+        uint8_t* grown = realloc(out, cap + 1);
+        if (!grown) {
+            free(out);
+            return NULL;
+        }
+        out = grown;
+    }
+    out[used] = '\0';
+    *out_len = used;
+    return out;
+}
 
-    frame[0] = 0x80;
+static void ws_trim(char** s) {
+    while (**s == ' ' || **s == '\t') (*s)++;
+    char* end = *s + strlen(*s);
+    while (end > *s && (end[-1] == ' ' || end[-1] == '\t')) *--end = '\0';
+}
 
-    switch (type) {
-        case WS_MESSAGE_TEXT: frame[0] |= 0x01; break;
-        case WS_MESSAGE_BINARY: frame[0] |= 0x02; break;
-        case WS_MESSAGE_CLOSE: frame[0] |= 0x08; break;
-        case WS_MESSAGE_PING: frame[0] |= 0x09; break;
-        case WS_MESSAGE_PONG: frame[0] |= 0x0A; break;
+// Accepts the first permessage-deflate offer in a Sec-WebSocket-Extensions
+// header that this hub can honour, setting conn's compression state and
+// writing the response header value into out. Returns false to decline.
+static bool ws_negotiate_deflate(WsHub* hub, WsConn* conn, const char* offers, char* out, size_t out_size) {
+    if (!hub->deflate || !offers) return false;
+    char* copy = strdup(offers);
+    if (!copy) return false;
+    bool accepted = false;
+    char* offer_save = NULL;
+    for (char* offer = strtok_r(copy, ",", &offer_save); offer && !accepted;
+         offer = strtok_r(NULL, ",", &offer_save)) {
+        char* param_save = NULL;
+        char* name = strtok_r(offer, ";", &param_save);
+        if (!name) continue;
+        ws_trim(&name);
+        if (strcmp(name, "permessage-deflate") != 0) continue;
+
+        bool ok = true;
+        bool server_no_takeover = false;
+        bool client_no_takeover = false;
+        int window_bits = 15;
+        for (char* param = strtok_r(NULL, ";", &param_save); param && ok;
+             param = strtok_r(NULL, ";", &param_save)) {
+            ws_trim(&param);
+            char* value = strchr(param, '=');
+            if (value) {
+                *value++ = '\0';
+                ws_trim(&param);
+                ws_trim(&value);
+                if (*value == '"') value++;
+                char* q = strchr(value, '"');
+                if (q) *q = '\0';
+            }
+            if (strcmp(param, "server_no_context_takeover") == 0 && !value) {
+                server_no_takeover = true;
+            } else if (strcmp(param, "client_no_context_takeover") == 0 && !value) {
+                client_no_takeover = true;
+            } else if (strcmp(param, "server_max_window_bits") == 0 && value) {
+                // zlib cannot produce raw deflate with an 8-bit window.
+                window_bits = atoi(value);
+                ok = window_bits >= 9 && window_bits <= 15;
+            } else if (strcmp(param, "client_max_window_bits") == 0) {
+                ok = !value || (atoi(value) >= 8 && atoi(value) <= 15);
+            } else {
+                ok = false;
+            }
+        }
+        if (!ok) continue;
+
+        conn->deflate = true;
+        conn->server_takeover = hub->context_takeover && !server_no_takeover;
+        conn->client_takeover = hub->context_takeover && !client_no_takeover;
+        conn->server_window_bits = window_bits;
+        int n = snprintf(out, out_size, "permessage-deflate");
+        if (!conn->server_takeover) n += snprintf(out + n, out_size - n, "; server_no_context_takeover");
+        if (!conn->client_takeover) n += snprintf(out + n, out_size - n, "; client_no_context_takeover");
+        if (window_bits < 15) snprintf(out + n, out_size - n, "; server_max_window_bits=%d", window_bits);
+        accepted = true;
     }
+    free(copy);
+    return accepted;
+}
 
-    if (length < 126) {
-        frame[1] = (uint8_t)length;
-        frame_len = 2;
-    } else if (length < 65536) {
-        frame[1] = 126;
-        frame[2] = (length >> 8) & 0xFF;
-        frame[3] = length & 0xFF;
-        frame_len = 4;
+// ---------------------------------------------------------------------------
+// Frames and writes
+// ---------------------------------------------------------------------------
+
+// Server frames are never masked, so the header is 2, 4 or 10 bytes.
+// opcode may carry WS_RSV1 for a compressed message.
+static WsFrame* ws_frame_create(uint8_t opcode, const void* payload, size_t len) {
+    size_t hdr = len < 126 ? 2 : (len <= 0xFFFF ? 4 : 10);
+    WsFrame* frame = malloc(sizeof(WsFrame) + hdr + len);
+    if (!frame) return NULL;
+    frame->refs = 1;
+    frame->len = hdr + len;
+    uint8_t* p = frame->data;
+    p[0] = 0x80 | opcode;
+    if (hdr == 2) {
+        p[1] = (uint8_t)len;
+    } else if (hdr == 4) {
+        p[1] = 126;
+        p[2] = (uint8_t)(len >> 8);
+        p[3] = (uint8_t)len;
     } else {
-        frame[1] = 127;
-        uint64_t len = hton64((uint64_t)length);
-        memcpy(&frame[2], &len, 8);
-        frame_len = 10;
+        p[1] = 127;
+        for (int i = 0; i < 8; i++) p[2 + i] = (uint8_t)((uint64_t)len >> ((7 - i) * 8));
     }
-
-    memcpy(&frame[frame_len], data, length);
-    frame_len += length;
-
-    return send(fd, (char*)frame, frame_len, 0);
+    if (len) memcpy(p + hdr, payload, len);
+    return frame;
 }
 
-static int ws_decode_frame(int fd, WSMessage* message) {
-    uint8_t header[14];
-    ssize_t len = recv(fd, (char*)header, 2, 0);
-
-    if (len <= 0) return -1;
+static WsFrame* ws_frame_raw(const char* data, size_t len) {
+    WsFrame* frame = malloc(sizeof(WsFrame) + len);
+    if (!frame) return NULL;
+    frame->refs = 1;
+    frame->len = len;
+    memcpy(frame->data, data, len);
+    return frame;
+}
 
-    bool fin = (header[0] & 0x80) != 0;
-    int opcode = header[0] & 0x0F;
-    bool masked = (header[1] & 0x80) != 0;
-    uint64_t payload_len = header[1] & 0x7F;
+static void ws_frame_release(WsFrame* frame) {
+    if (frame && --frame->refs == 0) free(frame);
+}
 
-    int header_len = 2;
+static void ws_call_drain(WsConn* conn) {
+    conn->waiting_drain = false;
+    if (conn->on_drain.type != VAL_FUNCTION) return;
+    Value arg = make_string(conn->id);
+    Value result = interpreter_execute_callback(conn->on_drain, 1, &arg);
+    value_free(&result);
+    value_free(&arg);
+}
 
-    if (payload_len == 126) {
-        len = recv(fd, (char*)&header[2], 2, 0);
-        if (len != 2) return -1;
-        payload_len = (header[2] << 8) | header[3];
-        header_len = 4;
-    } else if (payload_len == 127) {
-        len = recv(fd, (char*)&header[2], 8, 0);
-        if (len != 8) return -1;
-        payload_len = ntoh64(*(uint64_t*)&header[2]);
-        header_len = 10;
+static void on_ws_written(uv_write_t* req, int status) {
+    WsWrite* w = (WsWrite*)req;
+    WsConn* conn = req->handle->data;
+    ws_frame_release(w->frame);
+    free(w);
+    if (!conn || uv_is_closing((uv_handle_t*)conn->tcp)) return;
+    if (status < 0) {
+        ws_close_socket(conn);
+        return;
     }
-
-    uint8_t mask[4];
-    if (masked) {
-        len = recv(fd, (char*)mask, 4, 0);
-        if (len != 4) return -1;
-        header_len += 4;
+    if (conn->waiting_drain && conn->state == WS_STATE_OPEN &&
+        uv_stream_get_write_queue_size((uv_stream_t*)conn->tcp) <= WS_LOW_WATER) {
+        ws_call_drain(conn);
     }
+}
 
-    if (payload_len > WS_BUFFER_SIZE) {
-        payload_len = WS_BUFFER_SIZE;
+// Queues a reference to frame on conn; the caller keeps its own reference.
+static bool ws_write_frame(WsConn* conn, WsFrame* frame) {
+    if (uv_is_closing((uv_handle_t*)conn->tcp)) return false;
+    WsWrite* w = malloc(sizeof(WsWrite));
+    if (!w) return false;
+    w->frame = frame;
+    frame->refs++;
+    uv_buf_t buf = uv_buf_init((char*)frame->data, (unsigned int)frame->len);
+    if (uv_write(&w->req, (uv_stream_t*)conn->tcp, &buf, 1, on_ws_written) != 0) {
+        frame->refs--;
+        free(w);
+        ws_close_socket(conn);
+        return false;
     }
+    return true;
+}
 
-    uint8_t* payload = (uint8_t*)malloc(payload_len + 1);
-    len = recv(fd, (char*)payload, payload_len, 0);
+// Sends one frame to conn. Returns false when the frame was not queued or
+// the queue is now above the high-water mark; a connection whose queue has
+// reached WS_MAX_QUEUE is a consumer that stopped reading and is dropped.
+static bool ws_send_frame(WsConn* conn, WsFrame* frame) {
+    uv_stream_t* stream = (uv_stream_t*)conn->tcp;
+    if (uv_stream_get_write_queue_size(stream) >= WS_MAX_QUEUE) {
+        ws_close_socket(conn);
+        return false;
+    }
+    if (!ws_write_frame(conn, frame)) return false;
+    if (uv_stream_get_write_queue_size(stream) > WS_HIGH_WATER) {
+        conn->waiting_drain = true;
+        return false;
+    }
+    return true;
+}
 
-    if (masked) {
-        for (uint64_t i = 0; i < payload_len; i++) {
-            payload[i] ^= mask[i % 4];
+// Frames one outgoing data message for conn, compressed when the
+// connection negotiated permessage-deflate and the message is big enough
+// to be worth it.
+static WsFrame* ws_message_frame(WsConn* conn, uint8_t opcode, const void* data, size_t len) {
+    if (conn->deflate && len >= WS_DEFLATE_MIN) {
+        bool reset;
+        z_stream* zs = ws_deflater(conn, &reset);
+        size_t clen;
+        uint8_t* packed = zs ? ws_deflate(zs, reset, data, len, &clen) : NULL;
+        if (packed) {
+            WsFrame* frame = ws_frame_create(opcode | WS_RSV1, packed, clen);
+            free(packed);
+            return frame;
         }
     }
+    return ws_frame_create(opcode, data, len);
+}
 
-    payload[payload_len] = '\0';
-
-    message->data = payload;
-    message->length = payload_len;
+static bool ws_send(WsConn* conn, uint8_t opcode, const void* data, size_t len) {
+    if (conn->state != WS_STATE_OPEN) return false;
+    WsFrame* frame = ws_message_frame(conn, opcode, data, len);
+    if (!frame) return false;
+    bool ok = ws_send_frame(conn, frame);
+    ws_frame_release(frame);
+    return ok;
+}
 
-    switch (opcode) {
-        case 0x01: message->type = WS_MESSAGE_TEXT; break;
-        case 0x02: message->type = WS_MESSAGE_BINARY; break;
-        case 0x08: message->type = WS_MESSAGE_CLOSE; break;
-        case 0x09: message->type = WS_MESSAGE_PING; break;
-        case 0x0A: message->type = WS_MESSAGE_PONG; break;
-        default: message->type = WS_MESSAGE_TEXT; break;
+// Starts the closing handshake; the socket closes once the peer answers.
+static void ws_send_close(WsConn* conn, uint16_t code, const char* reason) {
+    if (conn->state == WS_STATE_CLOSING) return;
+    if (conn->state == WS_STATE_HANDSHAKE) {
+        ws_close_socket(conn);
+        return;
     }
+    uint8_t payload[125];
+    size_t rlen = reason ? strlen(reason) : 0;
+    if (rlen > sizeof(payload) - 2) rlen = sizeof(payload) - 2;
+    payload[0] = (uint8_t)(code >> 8);
+    payload[1] = (uint8_t)code;
+    if (rlen) memcpy(payload + 2, reason, rlen);
+    conn->state = WS_STATE_CLOSING;
+    conn->close_code = code;
+    WsFrame* frame = ws_frame_create(WS_OP_CLOSE, payload, 2 + rlen);
+    if (frame) {
+        ws_write_frame(conn, frame);
+        ws_frame_release(frame);
+    }
+}
 
-    return 0;
+// ---------------------------------------------------------------------------
+// Connection lifecycle
+// ---------------------------------------------------------------------------
+
+static void ws_hub_free(WsHub* hub) {
+    WsHub** link = &ws_hubs;
+    while (*link && *link != hub) link = &(*link)->next;
+    if (*link) *link = hub->next;
+    value_free(&hub->on_open);
+    value_free(&hub->on_message);
+    value_free(&hub->on_close);
+    free(hub->path);
+    free(hub);
 }
 
-int websocket_connect(WebSocket* ws) {
-    if (!ws || ws->is_server) return -1;
+static void on_ws_closed(uv_handle_t* handle) {
+    WsConn* conn = handle->data;
+    WsHub* hub = conn->hub;
+    if (conn->opened && hub->on_close.type == VAL_FUNCTION) {
+        Value args[2];
+        args[0] = make_string(conn->id);
+        args[1] = make_int(conn->close_code ? conn->close_code : 1006);
+        Value result = interpreter_execute_callback(hub->on_close, 2, args);
+        value_free(&result);
+        value_free(&args[0]);
+    }
+    if (conn->prev) conn->prev->next = conn->next;
+    else hub->conns = conn->next;
+    if (conn->next) conn->next->prev = conn->prev;
+    hub->count--;
+    ws_table_remove(conn);
+    value_free(&conn->on_drain);
+    ws_zstream_free(conn->zout, true);
+    ws_zstream_free(conn->zin, false);
+    free(conn->msg);
+    free(conn->rx);
+    free(conn->tcp);
+    free(conn);
+    if (hub->closed && hub->count == 0 && !hub->server) ws_hub_free(hub);
+}
 
-    struct sockaddr_in server_addr;
-    const char* host = ws->url + 7;
-    int port = 80;
+static void ws_close_socket(WsConn* conn) {
+    uv_handle_t* handle = (uv_handle_t*)conn->tcp;
+    if (!uv_is_closing(handle)) uv_close(handle, on_ws_closed);
+}
 
-    const char* slash = strchr(host, '/');
-    if (slash) {
-        port = atoi(slash + 1);
-        const char* colon = strchr(host, ':');
-        if (colon) {
-            port = atoi(colon + 1);
-        }
-    }
+static void ws_alloc(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
+    (void)handle;
+    (void)suggested_size;
+    buf->base = (char*)ws_read_buf;
+    buf->len = sizeof(ws_read_buf);
+}
 
-    ws->fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (ws->fd < 0) {
-        perror("socket");
-        return -1;
+static void ws_on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+    WsConn* conn = stream->data;
+    if (nread < 0) {
+        ws_close_socket(conn);
+        return;
     }
+    if (nread > 0) ws_process(conn, (uint8_t*)buf->base, (size_t)nread);
+}
 
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
+static WsConn* ws_conn_create(WsHub* hub, uv_tcp_t* tcp) {
+    WsConn* conn = calloc(1, sizeof(WsConn));
+    if (!conn) return NULL;
+    conn->tcp = tcp;
+    conn->hub = hub;
+    conn->num = ws_next_conn_id++;
+    conn->on_drain = make_null();
+    snprintf(conn->id, sizeof(conn->id), "ws_conn_%ld", conn->num);
+    conn->next = hub->conns;
+    if (hub->conns) hub->conns->prev = conn;
+    hub->conns = conn;
+    hub->count++;
+    ws_table_add(conn);
+    tcp->data = conn;
+    return conn;
+}
 
-    const char* colon = strchr(host, ':');
-    if (colon) {
-        const char* slash2 = strchr(colon, '/');
-        int host_len = slash2 ? slash2 - host - 7 : strlen(host) - 7;
-        char hostname[256];
-        memcpy(hostname, host + 7, host_len);
-        hostname[host_len] = '\0';
+// Sends the 101 response, answering any permessage-deflate offer, and
+// fires on_open.
+static void ws_open(WsConn* conn, const char* key, const char* extensions) {
+    char accept[32];
+    char ext[160];
+    char head[384];
+    ws_accept_key(key, accept);
+    bool deflate = ws_negotiate_deflate(conn->hub, conn, extensions, ext, sizeof(ext));
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: %s\r\n"
+                     "%s%s%s\r\n", accept,
+                     deflate ? "Sec-WebSocket-Extensions: " : "",
+                     deflate ? ext : "", deflate ? "\r\n" : "");
+    WsFrame* frame = ws_frame_raw(head, (size_t)n);
+    if (!frame) {
+        ws_close_socket(conn);
+        return;
+    }
+    bool ok = ws_write_frame(conn, frame);
+    ws_frame_release(frame);
+    if (!ok) return;
+    conn->state = WS_STATE_OPEN;
+    conn->opened = true;
+    uv_tcp_nodelay(conn->tcp, 1);
+    if (conn->hub->on_open.type == VAL_FUNCTION) {
+        Value arg = make_string(conn->id);
+        Value result = interpreter_execute_callback(conn->hub->on_open, 1, &arg);
+        value_free(&result);
+        value_free(&arg);
+    }
+}
 
-        struct hostent* he = gethostbyname(hostname);
-        if (!he) {
-            fprintf(stderr, "Failed to resolve host: %s\n", hostname);
-            close(ws->fd);
-            return -1;
+bool websocket_adopt(uv_stream_t* client, const char* path, const char* key,
+                     const char* version, const char* extensions,
+                     const char* leftover, size_t leftover_len) {
+    WsHub* hub = ws_route_find(path);
+    if (!hub || !ws_key_valid(key) || !version || strcmp(version, "13") != 0) return false;
+    uv_read_stop(client);
+    WsConn* conn = ws_conn_create(hub, (uv_tcp_t*)client);
+    if (!conn) return false;
+    ws_open(conn, key, extensions);
+    uv_read_start(client, ws_alloc, ws_on_read);
+    if (leftover_len && conn->state == WS_STATE_OPEN) {
+        // Parsed in place, so leftover must not point into ws_read_buf.
+        uint8_t* copy = malloc(leftover_len);
+        if (copy) {
+            memcpy(copy, leftover, leftover_len);
+            ws_process(conn, copy, leftover_len);
+            free(copy);
         }
+    }
+    return true;
+}
 
-        memcpy(&server_addr.sin_addr, he->h_addr_list[0], he->h_length);
+// ---------------------------------------------------------------------------
+// Incoming data
+// ---------------------------------------------------------------------------
+
+// Calls on_message with a NUL-terminated message it takes ownership of.
+// Binary messages are passed as bytes, text as a string.
+static void ws_deliver_owned(WsConn* conn, uint8_t opcode, char* text, size_t len) {
+    WsHub* hub = conn->hub;
+    if (hub->on_message.type != VAL_FUNCTION) {
+        free(text);
+        return;
+    }
+    Value args[3];
+    args[0] = make_string(conn->id);
+    if (opcode == WS_OP_BINARY) {
+        args[1] = make_bytes_owned((unsigned char*)text, len, len + 1);
     } else {
-        server_addr.sin_addr.s_addr = inet_addr(host);
+        args[1] = (Value){ .type = VAL_STRING, .string_val = text };
     }
+    args[2] = make_bool(opcode == WS_OP_BINARY);
+    Value result = interpreter_execute_callback(hub->on_message, 3, args);
+    value_free(&result);
+    value_free(&args[0]);
+    value_free(&args[1]);
+}
 
-    if (connect(ws->fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        perror("connect");
-        close(ws->fd);
-        ws->fd = -1;
-        return -1;
-    }
+static void ws_deliver(WsConn* conn, uint8_t opcode, const uint8_t* payload, size_t len) {
+    if (conn->hub->on_message.type != VAL_FUNCTION) return;
+    char* copy = malloc(len + 1);
+    if (!copy) return;
+    memcpy(copy, payload, len);
+    copy[len] = '\0';
+    ws_deliver_owned(conn, opcode, copy, len);
+}
 
-    char handshake[1024];
-    snprintf(handshake, sizeof(handshake),
-        "GET / HTTP/1.1\r\n"
-        "Host: %s\r\n"
-        "Upgrade: websocket\r\n"
-        "Connection: Upgrade\r\n"
-        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
-        "Sec-WebSocket-Version: 13\r\n"
-        "\r\n",
-        ws->url);
+// Text messages must be valid UTF-8 as a whole (RFC 6455 8.1); a frame
+// boundary may split a character, so this runs on the reassembled message.
+static bool ws_text_valid(WsConn* conn, uint8_t opcode, const uint8_t* text, size_t len) {
+    if (opcode != WS_OP_TEXT || text_utf8_valid((const char*)text, len)) return true;
+    ws_send_close(conn, 1007, "invalid UTF-8");
+    return false;
+}
 
-    if (send(ws->fd, handshake, strlen(handshake), 0) <= 0) {
-        close(ws->fd);
-        ws->fd = -1;
-        return -1;
+// Hands a complete message to on_message, inflating it first if the
+// client sent it compressed.
+static void ws_message(WsConn* conn, uint8_t opcode, bool compressed, const uint8_t* payload, size_t len) {
+    if (!compressed) {
+        if (ws_text_valid(conn, opcode, payload, len)) ws_deliver(conn, opcode, payload, len);
+        return;
     }
-
-    char response[1024];
-    ssize_t len = recv(ws->fd, response, sizeof(response) - 1, 0);
-    if (len <= 0 || !strstr(response, "101 Switching Protocols")) {
-        close(ws->fd);
-        ws->fd = -1;
-        return -1;
+    bool reset;
+    bool too_big = false;
+    size_t out_len = 0;
+    z_stream* zs = ws_inflater(conn, &reset);
+    uint8_t* out = zs ? ws_inflate(zs, reset, payload, len, conn->hub->max_message, &out_len, &too_big) : NULL;
+    if (!out) {
+        ws_send_close(conn, too_big ? 1009 : 1007, too_big ? "message too big" : "invalid compressed data");
+        return;
     }
-
-    ws->connected = true;
-    return 0;
+    if (!ws_text_valid(conn, opcode, out, out_len)) {
+        free(out);
+        return;
+    }
+    ws_deliver_owned(conn, opcode, (char*)out, out_len);
 }
 
-int websocket_listen(WebSocket* ws) {
-    if (!ws || !ws->is_server) return -1;
-
-    printf("WebSocket server listening on port %d\n", ws->fd);
-
-    fd_set readfds;
-    struct timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 100000;
-
-    while (ws->fd >= 0) {
-        FD_ZERO(&readfds);
-        FD_SET(ws->fd, &readfds);
+static bool ws_msg_append(WsConn* conn, const uint8_t* data, size_t len) {
+    if (conn->msg_len + len > conn->hub->max_message) {
+        ws_send_close(conn, 1009, "message too big");
+        return false;
+    }
+    if (conn->msg_len + len > conn->msg_cap) {
+        size_t cap = conn->msg_cap ? conn->msg_cap : 4096;
+        while (cap < conn->msg_len + len) cap *= 2;
+        uint8_t* msg = realloc(conn->msg, cap);
+        if (!msg) {
+            ws_close_socket(conn);
+            return false;
+        }
+        conn->msg = msg;
+        conn->msg_cap = cap;
+    }
+    memcpy(conn->msg + conn->msg_len, data, len);
+    conn->msg_len += len;
+    return true;
+}
 
-        int max_fd = ws->fd;
-        for (int i = 0; i < ws->client_count; i++) {
-            if (ws->clients[i] && ws->clients[i]->fd >= 0) {
-                FD_SET(ws->clients[i]->fd, &readfds);
-                if (ws->clients[i]->fd > max_fd) {
-                    max_fd = ws->clients[i]->fd;
+static void ws_handle_frame(WsConn* conn, bool fin, bool rsv1, uint8_t opcode, const uint8_t* payload, size_t len) {
+    switch (opcode) {
+        case WS_OP_TEXT:
+        case WS_OP_BINARY:
+            if (conn->state != WS_STATE_OPEN) return;
+            if (conn->msg_opcode) {
+                ws_send_close(conn, 1002, "expected a continuation frame");
+                return;
+            }
+            if (fin) {
+                ws_message(conn, opcode, rsv1, payload, len);
+                return;
+            }
+            conn->msg_opcode = opcode;
+            conn->msg_compressed = rsv1;
+            ws_msg_append(conn, payload, len);
+            return;
+        case WS_OP_CONTINUATION:
+            if (conn->state != WS_STATE_OPEN) return;
+            if (!conn->msg_opcode) {
+                ws_send_close(conn, 1002, "unexpected continuation frame");
+                return;
+            }
+            if (!ws_msg_append(conn, payload, len) || !fin) return;
+            ws_message(conn, conn->msg_opcode, conn->msg_compressed, conn->msg, conn->msg_len);
+            // Reassembly buffers are rare; don't keep one per idle connection.
+            free(conn->msg);
+            conn->msg = NULL;
+            conn->msg_len = conn->msg_cap = 0;
+            conn->msg_opcode = 0;
+            return;
+        case WS_OP_PING:
+            if (conn->state == WS_STATE_OPEN) {
+                WsFrame* frame = ws_frame_create(WS_OP_PONG, payload, len);
+                if (frame) {
+                    ws_write_frame(conn, frame);
+                    ws_frame_release(frame);
                 }
             }
+            return;
+        case WS_OP_PONG:
+            return;
+        case WS_OP_CLOSE: {
+            uint16_t code = len >= 2 ? (uint16_t)((payload[0] << 8) | payload[1]) : 1005;
+            if (conn->state == WS_STATE_OPEN) {
+                ws_send_close(conn, code == 1005 ? 1000 : code, NULL);
+            }
+            conn->close_code = code;
+            // libuv finishes queued writes (our close frame) before closing.
+            ws_close_socket(conn);
+            return;
         }
+        default:
+            ws_send_close(conn, 1002, "unknown opcode");
+            return;
+    }
+}
 
-        int activity = select(max_fd + 1, &readfds, NULL, NULL, &timeout);
-        if (activity < 0) {
-            perror("select");
-            break;
+// Parses complete frames from data, unmasking in place. Returns the number
+// of bytes consumed; the rest is an incomplete frame.
+static size_t ws_parse_frames(WsConn* conn, uint8_t* data, size_t len) {
+    size_t pos = 0;
+    while (len - pos >= 2 && conn->state != WS_STATE_HANDSHAKE &&
+           !uv_is_closing((uv_handle_t*)conn->tcp)) {
+        const uint8_t* p = data + pos;
+        bool fin = (p[0] & 0x80) != 0;
+        uint8_t opcode = p[0] & 0x0F;
+        bool masked = (p[1] & 0x80) != 0;
+        uint64_t plen = p[1] & 0x7F;
+        size_t hdr = 2;
+        if (plen == 126) {
+            if (len - pos < 4) break;
+            plen = ((uint64_t)p[2] << 8) | p[3];
+            hdr = 4;
+        } else if (plen == 127) {
+            if (len - pos < 10) break;
+            plen = 0;
+            for (int i = 0; i < 8; i++) plen = (plen << 8) | p[2 + i];
+            hdr = 10;
         }
-
-        if (activity == 0) continue;
-
-        if (FD_ISSET(ws->fd, &readfds)) {
-            struct sockaddr_in client_addr;
-            socklen_t client_len = sizeof(client_addr);
-            int client_fd = accept(ws->fd, (struct sockaddr*)&client_addr, &client_len);
-
-            if (client_fd >= 0) {
-                char* ip = inet_ntoa(client_addr.sin_addr);
-                printf("Client connected: %s\n", ip);
-
-                char request[1024];
-                ssize_t len = recv(client_fd, request, sizeof(request) - 1, 0);
-                request[len] = '\0';
-
-                if (ws_handshake(client_fd, request) == 0) {
-                    if (ws->client_count < WS_MAX_CLIENTS) {
-                        WebSocket* client = (WebSocket*)calloc(1, sizeof(WebSocket));
-                        client->fd = client_fd;
-                        client->is_server = false;
-                        client->connected = true;
-                        client->rx_len = 0;
-                        client->user_data = ws->user_data;
-
-                        if (ws->on_connect) {
-                            ws->on_connect(client, ws->user_data);
-                        }
-
-                        ws->clients[ws->client_count++] = client;
-                    } else {
-                        close(client_fd);
-                    }
-                } else {
-                    close(client_fd);
-                }
-            }
+        // RSV1 marks a compressed message, so only a data frame that starts
+        // a message on a deflate connection may set it.
+        bool rsv1 = (p[0] & WS_RSV1) != 0;
+        bool starts_message = opcode == WS_OP_TEXT || opcode == WS_OP_BINARY;
+        if ((p[0] & 0x30) || !masked || (rsv1 && (!conn->deflate || !starts_message))) {
+            ws_send_close(conn, 1002, "protocol error");
+            return len;
+        }
+        if ((opcode & 0x8) && (!fin || plen > 125)) {
+            ws_send_close(conn, 1002, "invalid control frame");
+            return len;
+        }
+        if (plen > conn->hub->max_message) {
+            ws_send_close(conn, 1009, "message too big");
+            return len;
         }
+        if (len - pos < hdr + 4 + plen) break;
 
-        for (int i = 0; i < ws->client_count; i++) {
-            WebSocket* client = ws->clients[i];
-            if (!client || client->fd < 0) continue;
+        const uint8_t* mask = data + pos + hdr;
+        uint8_t* payload = data + pos + hdr + 4;
+        ws_unmask(payload, (size_t)plen, mask);
+        pos += hdr + 4 + (size_t)plen;
+        ws_handle_frame(conn, fin, rsv1, opcode, payload, (size_t)plen);
+    }
+    return pos;
+}
 
-            if (FD_ISSET(client->fd, &readfds)) {
-                WSMessage message;
-                if (ws_decode_frame(client->fd, &message) >= 0) {
-                    if (message.type == WS_MESSAGE_CLOSE) {
-                        printf("Client disconnected\n");
-                        websocket_close(client);
-                        continue;
-                    }
+static bool ws_rx_append(WsConn* conn, const uint8_t* data, size_t len) {
+    if (conn->rx_len + len > conn->rx_cap) {
+        size_t cap = conn->rx_cap ? conn->rx_cap : 4096;
+        while (cap < conn->rx_len + len) cap *= 2;
+        uint8_t* rx = realloc(conn->rx, cap);
+        if (!rx) return false;
+        conn->rx = rx;
+        conn->rx_cap = cap;
+    }
+    memcpy(conn->rx + conn->rx_len, data, len);
+    conn->rx_len += len;
+    return true;
+}
 
-                    if (message.type == WS_MESSAGE_PING) {
-                        ws_send_frame(client->fd, message.data, message.length, WS_MESSAGE_PONG);
-                    }
+// Copies an unparsed tail into rx, or drops rx once nothing is pending.
+static void ws_rx_keep(WsConn* conn, const uint8_t* rest, size_t len) {
+    if (len == 0) {
+        free(conn->rx);
+        conn->rx = NULL;
+        conn->rx_len = conn->rx_cap = 0;
+        return;
+    }
+    if (rest >= conn->rx && rest < conn->rx + conn->rx_len) {
+        memmove(conn->rx, rest, len);
+        conn->rx_len = len;
+        return;
+    }
+    conn->rx_len = 0;
+    if (!ws_rx_append(conn, rest, len)) ws_close_socket(conn);
+}
 
-                    if (ws->on_message && (message.type == WS_MESSAGE_TEXT || message.type == WS_MESSAGE_BINARY)) {
-                        ws->on_message(client, &message, ws->user_data);
-                    }
+static void ws_handshake(WsConn* conn);
 
-                    free(message.data);
-                }
-            }
+static void ws_process(WsConn* conn, uint8_t* data, size_t len) {
+    if (conn->state == WS_STATE_HANDSHAKE || conn->rx_len) {
+        if (!ws_rx_append(conn, data, len)) {
+            ws_close_socket(conn);
+            return;
+        }
+        if (conn->state == WS_STATE_HANDSHAKE) {
+            ws_handshake(conn);
+            return;
         }
+        size_t used = ws_parse_frames(conn, conn->rx, conn->rx_len);
+        ws_rx_keep(conn, conn->rx + used, conn->rx_len - used);
+        return;
+    }
+    size_t used = ws_parse_frames(conn, data, len);
+    if (used < len && !uv_is_closing((uv_handle_t*)conn->tcp)) {
+        ws_rx_keep(conn, data + used, len - used);
     }
-
-    return 0;
 }
 
-void websocket_send(WebSocket* ws, const char* message, size_t length) {
-    if (!ws || ws->fd < 0) return;
-
-    WSMessageType type = WS_MESSAGE_TEXT;
-    ws_send_frame(ws->fd, (const uint8_t*)message, length, type);
+// ---------------------------------------------------------------------------
+// Standalone listener (ws.listen)
+// ---------------------------------------------------------------------------
+
+static const char* ws_header_value(char* head, const char* name, char** out_end) {
+    size_t nlen = strlen(name);
+    for (char* line = strstr(head, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, name, nlen) == 0 && line[nlen] == ':') {
+            char* v = line + nlen + 1;
+            while (*v == ' ' || *v == '\t') v++;
+            char* end = strstr(v, "\r\n");
+            if (!end) return NULL;
+            while (end > v && (end[-1] == ' ' || end[-1] == '\t')) end--;
+            *out_end = end;
+            return v;
+        }
+    }
+    return NULL;
 }
 
-void websocket_send_text(WebSocket* ws, const char* text) {
-    websocket_send(ws, text, strlen(text));
+static void ws_reject(WsConn* conn) {
+    static const char resp[] = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    WsFrame* frame = ws_frame_raw(resp, sizeof(resp) - 1);
+    if (frame) {
+        ws_write_frame(conn, frame);
+        ws_frame_release(frame);
+    }
+    ws_close_socket(conn);
 }
 
-void websocket_send_binary(WebSocket* ws, const uint8_t* data, size_t length) {
-    if (!ws || ws->fd < 0) return;
+static void ws_handshake(WsConn* conn) {
+    char* head = (char*)conn->rx;
+    char* end = memmem(head, conn->rx_len, "\r\n\r\n", 4);
+    if (!end) {
+        if (conn->rx_len > WS_MAX_HANDSHAKE) ws_reject(conn);
+        return;
+    }
+    size_t head_len = (size_t)(end - head) + 4;
+    end[2] = '\0';  // headers keep their trailing CRLF for ws_header_value
+
+    char* key_end = NULL;
+    char* ver_end = NULL;
+    char* up_end = NULL;
+    char* ext_end = NULL;
+    const char* key = ws_header_value(head, "Sec-WebSocket-Key", &key_end);
+    const char* version = ws_header_value(head, "Sec-WebSocket-Version", &ver_end);
+    const char* upgrade = ws_header_value(head, "Upgrade", &up_end);
+    const char* extensions = ws_header_value(head, "Sec-WebSocket-Extensions", &ext_end);
+    if (strncmp(head, "GET ", 4) != 0 || !key || !version || !upgrade) {
+        ws_reject(conn);
+        return;
+    }
+    *key_end = '\0';
+    *ver_end = '\0';
+    *up_end = '\0';
+    if (extensions) *ext_end = '\0';
+    if (!ws_key_valid(key) || strcmp(version, "13") != 0 || strcasecmp(upgrade, "websocket") != 0) {
+        ws_reject(conn);
+        return;
+    }
+    char key_copy[32];
+    snprintf(key_copy, sizeof(key_copy), "%s", key);
+    ws_open(conn, key_copy, extensions);
+    if (conn->state != WS_STATE_OPEN) return;
+
+    // Frames the client pipelined behind the request head.
+    size_t rest = conn->rx_len - head_len;
+    memmove(conn->rx, conn->rx + head_len, rest);
+    conn->rx_len = rest;
+    size_t used = ws_parse_frames(conn, conn->rx, conn->rx_len);
+    ws_rx_keep(conn, conn->rx + used, conn->rx_len - used);
+}
 
-    ws_send_frame(ws->fd, data, length, WS_MESSAGE_BINARY);
+static void ws_on_connection(uv_stream_t* server, int status) {
+    if (status < 0) return;
+    WsHub* hub = server->data;
+    uv_tcp_t* client = malloc(sizeof(uv_tcp_t));
+    if (!client) return;
+    uv_tcp_init(global_event_loop, client);
+    if (uv_accept(server, (uv_stream_t*)client) != 0 || hub->closed) {
+        client->data = NULL;
+        uv_close((uv_handle_t*)client, (uv_close_cb)free);
+        return;
+    }
+    WsConn* conn = ws_conn_create(hub, client);
+    if (!conn) {
+        uv_close((uv_handle_t*)client, (uv_close_cb)free);
+        return;
+    }
+    uv_read_start((uv_stream_t*)client, ws_alloc, ws_on_read);
 }
 
-void websocket_broadcast(WebSocket* server, const char* message, size_t length, WebSocket* exclude) {
-    if (!server || !server->is_server) return;
+static void on_ws_server_closed(uv_handle_t* handle) {
+    WsHub* hub = handle->data;
+    free(handle);
+    hub->server = NULL;
+    if (hub->count == 0) ws_hub_free(hub);
+}
 
-    for (int i = 0; i < server->client_count; i++) {
-        if (server->clients[i] && server->clients[i] != exclude && server->clients[i]->fd >= 0) {
-            websocket_send(server->clients[i], message, length);
+// ---------------------------------------------------------------------------
+// Natives
+// ---------------------------------------------------------------------------
+
+static WsHub* ws_hub_create(int argc, Value* args, int first_cb) {
+    WsHub* hub = calloc(1, sizeof(WsHub));
+    if (!hub) return NULL;
+    snprintf(hub->id, sizeof(hub->id), "ws_hub_%ld", ws_next_hub_id++);
+    hub->max_message = WS_MAX_MESSAGE;
+    Value* slots[3] = { &hub->on_open, &hub->on_message, &hub->on_close };
+    for (int i = 0; i < 3; i++) {
+        int a = first_cb + i;
+        if (a < argc && args[a].type == VAL_FUNCTION) {
+            *slots[i] = args[a];
+            args[a] = make_null();  // moved into the hub
+        } else {
+            *slots[i] = make_null();
         }
     }
+    hub->next = ws_hubs;
+    ws_hubs = hub;
+    return hub;
 }
 
-void websocket_on_message(WebSocket* ws, WSMessageHandler handler, void* user_data) {
-    if (!ws) return;
-    ws->on_message = handler;
-    ws->user_data = user_data;
+// ws.route(path, on_open, on_message, on_close)
+static Value native_ws_route(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_STRING) {
+        fprintf(stderr, "⚠️ WebSocket Error: ws.route expects (path, on_open, on_message, on_close)\n");
+        return make_null();
+    }
+    if (ws_route_find(args[0].string_val)) {
+        fprintf(stderr, "⚠️ WebSocket Error: route %s is already registered\n", args[0].string_val);
+        return make_null();
+    }
+    WsHub* hub = ws_hub_create(argc, args, 1);
+    if (!hub) return make_null();
+    hub->path = strdup(args[0].string_val);
+    return make_string(hub->id);
 }
 
-void websocket_on_connect(WebSocket* ws, WSConnectHandler handler, void* user_data) {
-    if (!ws) return;
-    ws->on_connect = handler;
-    ws->user_data = user_data;
+// ws.listen(port, on_open, on_message, on_close)
+static Value native_ws_listen(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    if (argc < 1 || args[0].type != VAL_INT) {
+        fprintf(stderr, "⚠️ WebSocket Error: ws.listen expects (port, on_open, on_message, on_close)\n");
+        return make_null();
+    }
+    if (!global_event_loop) interpreter_init_event_loop();
+    uv_tcp_t* server = malloc(sizeof(uv_tcp_t));
+    if (!server) return make_null();
+    uv_tcp_init(global_event_loop, server);
+    struct sockaddr_in addr;
+    uv_ip4_addr("0.0.0.0", (int)args[0].int_val, &addr);
+    int r = uv_tcp_bind(server, (const struct sockaddr*)&addr, 0);
+    if (r == 0) r = uv_listen((uv_stream_t*)server, SOMAXCONN, ws_on_connection);
+    if (r != 0) {
+        fprintf(stderr, "⚠️ WebSocket Error: cannot listen on port %lld: %s\n",
+                args[0].int_val, uv_strerror(r));
+        uv_close((uv_handle_t*)server, (uv_close_cb)free);
+        return make_null();
+    }
+    WsHub* hub = ws_hub_create(argc, args, 1);
+    if (!hub) {
+        uv_close((uv_handle_t*)server, (uv_close_cb)free);
+        return make_null();
+    }
+    hub->server = server;
+    server->data = hub;
+    return make_string(hub->id);
 }
 
-void websocket_on_close(WebSocket* ws, WSCloseHandler handler, void* user_data) {
-    if (!ws) return;
-    ws->on_close = handler;
-    ws->user_data = user_data;
+static WsHub* hub_arg(int argc, Value* args, const char* fn) {
+    WsHub* hub = argc >= 1 && args[0].type == VAL_STRING ? ws_hub_find(args[0].string_val) : NULL;
+    if (!hub) fprintf(stderr, "⚠️ WebSocket Error: %s expects a ws hub handle\n", fn);
+    return hub;
 }
 
-void websocket_close(WebSocket* ws) {
-    if (!ws || ws->fd < 0) return;
+static WsConn* conn_arg(int argc, Value* args, const char* fn) {
+    WsConn* conn = argc >= 1 && args[0].type == VAL_STRING ? ws_conn_find(args[0].string_val) : NULL;
+    if (!conn) fprintf(stderr, "⚠️ WebSocket Error: %s expects an open ws connection\n", fn);
+    return conn;
+}
 
-    ws_send_frame(ws->fd, NULL, 0, WS_MESSAGE_CLOSE);
-    close(ws->fd);
-    ws->fd = -1;
-    ws->connected = false;
+// hub.broadcast(message, [exclude_conn]) -> number of connections sent to.
+// Each distinct encoding is built once and every write references the same
+// bytes: one plain frame, and one compressed frame for all connections that
+// share the stateless compressor. Only connections with context takeover
+// need a compression pass of their own.
+static Value native_ws_hub_broadcast(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    WsHub* hub = hub_arg(argc, args, "hub.broadcast");
+    if (!hub || argc < 2 || (args[1].type != VAL_STRING && args[1].type != VAL_BYTES)) return make_int(0);
+    WsConn* exclude = argc >= 3 && args[2].type == VAL_STRING ? ws_conn_find(args[2].string_val) : NULL;
+    size_t len = 0;
+    const char* data = (const char*)value_bytes(&args[1], &len);
+    uint8_t opcode = args[1].type == VAL_BYTES ? WS_OP_BINARY : WS_OP_TEXT;
+    bool compressible = len >= WS_DEFLATE_MIN;
+    WsFrame* plain = NULL;
+    WsFrame* packed = NULL;
+    long long sent = 0;
+    WsConn* next;
+    for (WsConn* conn = hub->conns; conn; conn = next) {
+        next = conn->next;
+        if (conn == exclude || conn->state != WS_STATE_OPEN) continue;
+        if (uv_stream_get_write_queue_size((uv_stream_t*)conn->tcp) >= WS_MAX_QUEUE) {
+            ws_close_socket(conn);
+            continue;
+        }
+        WsFrame* own = NULL;
+        WsFrame* frame;
+        if (conn->deflate && compressible && ws_shares_deflater(conn)) {
+            if (!packed) packed = ws_message_frame(conn, opcode, data, len);
+            frame = packed;
+        } else if (conn->deflate && compressible) {
+            frame = own = ws_message_frame(conn, opcode, data, len);
+        } else {
+            if (!plain) plain = ws_frame_create(opcode, data, len);
+            frame = plain;
+        }
+        bool ok = frame && ws_write_frame(conn, frame);
+        ws_frame_release(own);
+        if (!ok) continue;
+        if (uv_stream_get_write_queue_size((uv_stream_t*)conn->tcp) > WS_HIGH_WATER) {
+            conn->waiting_drain = true;
+        }
+        sent++;
+    }
+    ws_frame_release(plain);
+    ws_frame_release(packed);
+    return make_int(sent);
+}
 
-    if (ws->on_close) {
-        ws->on_close(ws, ws->user_data);
+// hub.config([max_message_bytes], [compression], [context_takeover]) -> bool
+// Compression and takeover apply to connections opened afterwards.
+static Value native_ws_hub_config(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    WsHub* hub = hub_arg(argc, args, "hub.config");
+    if (!hub) return make_bool(false);
+    if (argc >= 2 && args[1].type == VAL_INT) {
+        if (args[1].int_val < 125) {
+            fprintf(stderr, "⚠️ WebSocket Error: max message size must be at least 125 bytes\n");
+            return make_bool(false);
+        }
+        hub->max_message = (size_t)args[1].int_val;
     }
+    if (argc >= 3 && args[2].type == VAL_BOOL) hub->deflate = args[2].bool_val;
+    if (argc >= 4 && args[3].type == VAL_BOOL) hub->context_takeover = args[3].bool_val;
+    return make_bool(true);
 }
 
-int websocket_poll(WebSocket* ws, int timeout_ms) {
-    if (!ws || ws->fd < 0) return -1;
+static Value native_ws_hub_count(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    WsHub* hub = hub_arg(argc, args, "hub.count");
+    if (!hub) return make_int(0);
+    long long open = 0;
+    for (WsConn* conn = hub->conns; conn; conn = conn->next) {
+        if (conn->state == WS_STATE_OPEN) open++;
+    }
+    return make_int(open);
+}
 
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    FD_SET(ws->fd, &readfds);
+// hub.close(): stops accepting and sends 1001 (going away) to every member.
+static void ws_hub_close(WsHub* hub) {
+    hub->closed = true;
+    WsConn* next;
+    for (WsConn* conn = hub->conns; conn; conn = next) {
+        next = conn->next;
+        ws_send_close(conn, 1001, "server closing");
+    }
+    if (hub->server) {
+        uv_close((uv_handle_t*)hub->server, on_ws_server_closed);
+    } else if (hub->count == 0) {
+        ws_hub_free(hub);
+    }
+}
 
-    struct timeval timeout;
-    timeout.tv_sec = timeout_ms / 1000;
-    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+static Value native_ws_hub_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    WsHub* hub = hub_arg(argc, args, "hub.close");
+    if (!hub || hub->closed) return make_bool(false);
+    ws_hub_close(hub);
+    return make_bool(true);
+}
 
-    return select(ws->fd + 1, &readfds, NULL, NULL, &timeout);
+// Once main() returns no script callback can answer a client, so every hub
+// is closed and its sockets dropped after the 1001 frame instead of waiting
+// for the peer's reply.
+static void ws_close_all(void) {
+    WsHub* next_hub;
+    for (WsHub* hub = ws_hubs; hub; hub = next_hub) {
+        next_hub = hub->next;
+        if (!hub->closed) ws_hub_close(hub);
+    }
+    for (WsHub* hub = ws_hubs; hub; hub = hub->next) {
+        for (WsConn* conn = hub->conns; conn; conn = conn->next) ws_close_socket(conn);
+    }
 }
 
-const char* websocket_get_remote_address(WebSocket* ws) {
-    static char addr_str[64];
-    if (!ws || ws->fd < 0) return "unknown";
+// conn.send(data): strings go out as text messages, bytes as binary.
+static Value native_ws_conn_send(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    WsConn* conn = conn_arg(argc, args, "conn.send");
+    if (!conn || argc < 2 || (args[1].type != VAL_STRING && args[1].type != VAL_BYTES)) return make_bool(false);
+    size_t len = 0;
+    const unsigned char* data = value_bytes(&args[1], &len);
+    return make_bool(ws_send(conn, args[1].type == VAL_BYTES ? WS_OP_BINARY : WS_OP_TEXT, data, len));
+}
 
-    struct sockaddr_in addr;
-    socklen_t len = sizeof(addr);
-    getpeername(ws->fd, (struct sockaddr*)&addr, &len);
+static Value native_ws_conn_send_binary(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    WsConn* conn = conn_arg(argc, args, "conn.send_binary");
+    if (!conn || argc < 2 || (args[1].type != VAL_STRING && args[1].type != VAL_BYTES)) return make_bool(false);
+    size_t len = 0;
+    const unsigned char* data = value_bytes(&args[1], &len);
+    return make_bool(ws_send(conn, WS_OP_BINARY, data, len));
+}
 
-    snprintf(addr_str, sizeof(addr_str), "%s:%d",
-        inet_ntoa(addr.sin_addr), ntohs(addr.sin_port));
+static Value native_ws_conn_ping(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    WsConn* conn = conn_arg(argc, args, "conn.ping");
+    if (!conn) return make_bool(false);
+    const char* data = argc >= 2 && args[1].type == VAL_STRING ? args[1].string_val : "";
+    size_t len = strlen(data);
+    return make_bool(len <= 125 && ws_send(conn, WS_OP_PING, data, len));
+}
 
-    return addr_str;
+// conn.close([code], [reason])
+static Value native_ws_conn_close(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    WsConn* conn = conn_arg(argc, args, "conn.close");
+    if (!conn) return make_bool(false);
+    uint16_t code = argc >= 2 && args[1].type == VAL_INT ? (uint16_t)args[1].int_val : 1000;
+    const char* reason = argc >= 3 && args[2].type == VAL_STRING ? args[2].string_val : NULL;
+    ws_send_close(conn, code, reason);
+    return make_bool(true);
 }
 
-int websocket_get_port(WebSocket* ws) {
-    if (!ws || ws->fd < 0) return -1;
+static Value native_ws_conn_queue_size(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    WsConn* conn = conn_arg(argc, args, "conn.queue_size");
+    if (!conn) return make_int(0);
+    return make_int((long long)uv_stream_get_write_queue_size((uv_stream_t*)conn->tcp));
+}
 
-    struct sockaddr_in addr;
-    socklen_t len = sizeof(addr);
-    getsockname(ws->fd, (struct sockaddr*)&addr, &len);
+// conn.on_drain(callback): called with the connection once a send that
+// returned false has been flushed below the low-water mark.
+static Value native_ws_conn_on_drain(struct Interpreter* interp, int argc, Value* args) {
+    (void)interp;
+    WsConn* conn = conn_arg(argc, args, "conn.on_drain");
+    if (!conn || argc < 2) return make_bool(false);
+    value_free(&conn->on_drain);
+    conn->on_drain = args[1];
+    args[1] = make_null();
+    return make_bool(true);
+}
 
-    return ntohs(addr.sin_port);
+void stdlib_websocket_register(void) {
+    interpreter_on_main_return(ws_close_all);
+    register_native("ws.route", native_ws_route);
+    register_native("ws.listen", native_ws_listen);
+    register_native("ws.hub_broadcast", native_ws_hub_broadcast);
+    register_native("ws.hub_count", native_ws_hub_count);
+    register_native("ws.hub_config", native_ws_hub_config);
+    register_native("ws.hub_close", native_ws_hub_close);
+    register_native("ws.conn_send", native_ws_conn_send);
+    register_native("ws.conn_send_binary", native_ws_conn_send_binary);
+    register_native("ws.conn_ping", native_ws_conn_ping);
+    register_native("ws.conn_close", native_ws_conn_close);
+    register_native("ws.conn_queue_size", native_ws_conn_queue_size);
+    register_native("ws.conn_on_drain", native_ws_conn_on_drain);
+    register_handle_methods("ws_hub_", "ws.hub_");
+    register_handle_methods("ws_conn_", "ws.conn_");
 }
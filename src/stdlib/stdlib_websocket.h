@@ -2,6 +2,7 @@
 #define RADS_WEBSOCKET_H
 
 #include "../core/interpreter.h"
+#include <uv.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -14,52 +15,31 @@ typedef enum {
     WS_MESSAGE_CLOSE
 } WSMessageType;
 
-typedef struct {
-    WSMessageType type;
-    uint8_t* data;
-    size_t length;
-} WSMessage;
+// Write-queue watermarks per connection (bytes queued in libuv). Above the
+// high mark send() returns false and on_drain fires once it falls below the
+// low mark; a connection that reaches the hard limit is dropped.
+#define WS_HIGH_WATER (1024 * 1024)
+#define WS_LOW_WATER (256 * 1024)
+#define WS_MAX_QUEUE (16 * 1024 * 1024)
+
+// Default for the largest message accepted from a client, after continuation
+// frames are reassembled and permessage-deflate is undone (hub.config).
+#define WS_MAX_MESSAGE (16 * 1024 * 1024)
+
+// True when a ws.route() hub is registered for path.
+bool websocket_has_route(const char* path);
+
+// Completes the handshake on a client socket that net.http_server parsed an
+// Upgrade request from, negotiating permessage-deflate from extensions (may
+// be NULL). On success the websocket module owns the handle
+// (handle->data and read callbacks are replaced); bytes that followed the
+// request head are fed to the frame parser. Returns false without touching
+// the handle when there is no matching route or the request is not a valid
+// WebSocket handshake.
+bool websocket_adopt(uv_stream_t* client, const char* path, const char* key,
+                     const char* version, const char* extensions,
+                     const char* leftover, size_t leftover_len);
 
-typedef struct WebSocket WebSocket;
-
-struct WebSocket {
-    int fd;
-    char* url;
-    bool is_server;
-    bool connected;
-
-    void (*on_message)(struct WebSocket* ws, WSMessage* message, void* user_data);
-    void (*on_connect)(struct WebSocket* ws, void* user_data);
-    void (*on_close)(struct WebSocket* ws, void* user_data);
-    void* user_data;
-
-    char rx_buffer[8192];
-    int rx_len;
-
-    struct WebSocket* clients[128];
-    int client_count;
-};
-
-typedef void (*WSMessageHandler)(struct WebSocket* ws, WSMessage* message, void* user_data);
-typedef void (*WSConnectHandler)(struct WebSocket* ws, void* user_data);
-typedef void (*WSCloseHandler)(struct WebSocket* ws, void* user_data);
-
-struct WebSocket* websocket_server_new(int port);
-struct WebSocket* websocket_client_new(const char* url);
-void websocket_free(struct WebSocket* ws);
-int websocket_listen(struct WebSocket* ws);
-int websocket_connect(struct WebSocket* ws);
-void websocket_send(struct WebSocket* ws, const char* message, size_t length);
-void websocket_send_text(struct WebSocket* ws, const char* text);
-void websocket_send_binary(struct WebSocket* ws, const uint8_t* data, size_t length);
-void websocket_on_message(struct WebSocket* ws, WSMessageHandler handler, void* user_data);
-void websocket_on_connect(struct WebSocket* ws, WSConnectHandler handler, void* user_data);
-void websocket_on_close(struct WebSocket* ws, WSCloseHandler handler, void* user_data);
-void websocket_close(struct WebSocket* ws);
 void stdlib_websocket_register(void);
-void websocket_broadcast(struct WebSocket* server, const char* message, size_t length, struct WebSocket* exclude);
-int websocket_poll(struct WebSocket* ws, int timeout_ms);
-const char* websocket_get_remote_address(struct WebSocket* ws);
-int websocket_get_port(struct WebSocket* ws);
 
 #endif